@@ -1,4 +1,5 @@
 #include "App.h"
+#include "Apps/BenchmarkRunner.h"
 #include "Commons/Timer.h"
 #include "Commons/ShaderTable.h"
 #include "Commons/DescriptorHeap.h"
@@ -8,6 +9,7 @@
 #include "Commons/DSVDescriptor.h"
 #include "Commons/Texture.h"
 #include "Commons/Mesh.h"
+#include "Commons/ThreadPool.h"
 #include "Shaders/ConstantBuffers.h"
 #include "Shaders/Vertices.h"
 #include "Helpers/DebugHelper.h"
@@ -34,6 +36,7 @@
 #include <strsafe.h>
 #endif
 
+#include <algorithm>
 #include <vector>
 #include <queue>
 #include <fstream>
@@ -193,7 +196,10 @@ bool App::Init(const std::string& ksFilepath, std::string& ksRunNumber)
 
 	CreateScreenQuad();
 
-	InitScene(ksFilepath);
+	if (InitScene(ksFilepath) == false)
+	{
+		return false;
+	}
 
 	if (CreateShaderTables() == false)
 	{
@@ -298,14 +304,107 @@ void App::Update(const Timer& kTimer)
 	m_pLight->SetIsRendering((bool)m_LightCBs[0].Enabled);
 	m_pLight->SetPosition(m_LightCBs[0].Position);
 
-	m_pGIVolume->SetAnchorPosition(ObjectManager::GetInstance()->GetActiveCamera()->GetPosition());
+	++m_uiGIFrame;
+
+	WakeGIProbes();
+
+	//Cascades that aren't updated this frame don't scroll either, so the planes they would clear aren't lost
+	for (int i = 0; i < (int)m_GIVolumes.size(); ++i)
+	{
+		if (m_GICascades.ShouldUpdate(i, m_uiGIFrame) == false)
+		{
+			continue;
+		}
+
+		m_GIVolumes[i]->SetAnchorPosition(ObjectManager::GetInstance()->GetActiveCamera()->GetPosition());
 
-	m_pGIVolume->Update(kTimer);
+		m_GIVolumes[i]->Update(kTimer);
+
+		m_GICascades.SetCascadeTransform(i, m_GIVolumes[i]->GetPosition(), m_GIVolumes[i]->GetProbeOffsets());
+	}
 
 	ImGuiIO io = ImGui::GetIO();
 	io.DeltaTime = kTimer.DeltaTime();
 }
 
+void App::WakeGIProbes()
+{
+	if (m_GILightCBs.size() != m_LightCBs.size() || memcmp(m_GILightCBs.data(), m_LightCBs.data(), m_LightCBs.size() * sizeof(LightCB)) != 0)
+	{
+		for (int i = 0; i < (int)m_GIVolumes.size(); ++i)
+		{
+			m_GIVolumes[i]->WakeAllProbes();
+		}
+
+		m_GILightCBs = m_LightCBs;
+	}
+
+	//Updated in place so nothing is allocated for objects that haven't changed
+	m_GIWakeBounds.clear();
+
+	for (std::unordered_map<std::string, GameObject*>::iterator it = ObjectManager::GetInstance()->GetGameObjects()->begin(); it != ObjectManager::GetInstance()->GetGameObjects()->end(); ++it)
+	{
+		Mesh* pMesh = it->second->GetMesh();
+
+		if (it->second->IsContributeGI() == false || pMesh == nullptr)
+		{
+			continue;
+		}
+
+		DirectX::XMFLOAT4X4 world = it->second->GetWorldMatrix();
+
+		std::unordered_map<std::string, GIObjectState>::iterator state = m_GIObjectStates.find(it->first);
+
+		if (state == m_GIObjectStates.end())
+		{
+			state = m_GIObjectStates.emplace(it->first, GIObjectState()).first;
+		}
+		else if (memcmp(&state->second.World, &world, sizeof(DirectX::XMFLOAT4X4)) == 0)
+		{
+			state->second.Seen = true;
+
+			continue;
+		}
+		else
+		{
+			//Both where it was and where it is now can see the change
+			m_GIWakeBounds.push_back(std::make_pair(state->second.BoundsMin, state->second.BoundsMax));
+		}
+
+		state->second.World = world;
+		state->second.Seen = true;
+
+		MathHelper::TransformBounds(pMesh->GetBoundsMin(), pMesh->GetBoundsMax(), world, state->second.BoundsMin, state->second.BoundsMax);
+
+		m_GIWakeBounds.push_back(std::make_pair(state->second.BoundsMin, state->second.BoundsMax));
+	}
+
+	//Objects that were removed or stopped contributing leave a change behind too
+	for (std::unordered_map<std::string, GIObjectState>::iterator it = m_GIObjectStates.begin(); it != m_GIObjectStates.end();)
+	{
+		if (it->second.Seen == false)
+		{
+			m_GIWakeBounds.push_back(std::make_pair(it->second.BoundsMin, it->second.BoundsMax));
+
+			it = m_GIObjectStates.erase(it);
+
+			continue;
+		}
+
+		it->second.Seen = false;
+
+		++it;
+	}
+
+	for (int i = 0; i < (int)m_GIVolumes.size(); ++i)
+	{
+		for (int j = 0; j < (int)m_GIWakeBounds.size(); ++j)
+		{
+			m_GIVolumes[i]->WakeProbesNear(m_GIWakeBounds[j].first, m_GIWakeBounds[j].second);
+		}
+	}
+}
+
 void App::OnResize()
 {
 	FlushCommandQueue();
@@ -467,7 +566,17 @@ void App::Draw()
 
 		m_pGraphicsCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-		m_pGIVolume->Draw(m_pSRVHeap, m_pScenePerFrameCBUpload, m_pGraphicsCommandList.Get(), m_TopLevelBuffer);
+		GPU_PROFILE_BEGIN(GpuStats::DRAW_VOLUME, m_pGraphicsCommandList)
+
+		for (int i = 0; i < (int)m_GIVolumes.size(); ++i)
+		{
+			if (m_GICascades.ShouldUpdate(i, m_uiGIFrame) == true)
+			{
+				m_GIVolumes[i]->Draw(m_pSRVHeap, m_pScenePerFrameCBUpload, m_pGraphicsCommandList.Get(), m_TopLevelBuffer);
+			}
+		}
+
+		GPU_PROFILE_END(GpuStats::DRAW_VOLUME, m_pGraphicsCommandList)
 
 		DrawDeferredPass();
 
@@ -585,7 +694,7 @@ void App::DrawGBufferPass()
 	m_pGraphicsCommandList->SetComputeRootDescriptorTable(DeferredPass::GlobalRootSignatureParams::POSITION, m_pSRVHeap->GetGpuDescriptorHandle(GBuffer[(int)GBuffer::POSITION]->GetUAVDesc()->GetDescriptorIndex()));
 
 	m_pGraphicsCommandList->SetComputeRootConstantBufferView(DeferredPass::GlobalRootSignatureParams::PER_FRAME_SCENE_CB, m_pScenePerFrameCBUpload->GetBufferGPUAddress(App::GetApp()->GetFrameIndex()));
-	m_pGraphicsCommandList->SetComputeRootConstantBufferView(DeferredPass::GlobalRootSignatureParams::PER_FRAME_RAYTRACE_CB, m_pGIVolume->GetRaytracePerFrameUpload()->GetBufferGPUAddress());
+	m_pGraphicsCommandList->SetComputeRootConstantBufferView(DeferredPass::GlobalRootSignatureParams::PER_FRAME_RAYTRACE_CB, m_GIVolumes[0]->GetRaytracePerFrameUpload()->GetBufferGPUAddress());
 
 	m_pGraphicsCommandList->SetPipelineState1(m_pStateObject.Get());
 
@@ -631,17 +740,33 @@ void App::DrawLightPass()
 
 	m_pGraphicsCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
 
-	m_pGraphicsCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(GetBackBuffer(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
+	CD3DX12_RESOURCE_BARRIER pResourceBarriers[2] =
+	{
+		CD3DX12_RESOURCE_BARRIER::Transition(GetBackBuffer(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET),
+		CD3DX12_RESOURCE_BARRIER::Transition(GetDepthStencilBuffer()->GetResource().Get(), D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_DEPTH_WRITE)
+	};
+
+	m_pGraphicsCommandList->ResourceBarrier(2, pResourceBarriers);
 
 	float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
 
 	m_pGraphicsCommandList->ClearRenderTargetView(GetBackBufferView(), clearColor, 0, nullptr);
 
-	m_pGraphicsCommandList->OMSetRenderTargets(1, &GetBackBufferView(), FALSE, nullptr);
+	//Every pixel's depth is written by the full screen quad so there is no need to clear it
+	D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView = m_pDSVHeap->GetCpuDescriptorHandle(GetDepthStencilBufferView()->GetDescriptorIndex());
+
+	m_pGraphicsCommandList->OMSetRenderTargets(1, &GetBackBufferView(), FALSE, &depthStencilView);
 
 	m_pGraphicsCommandList->SetGraphicsRootDescriptorTable(DeferredPass::LightPass::LightPassRootSignatureParams::STANDARD_DESCRIPTORS, m_pSRVHeap->GetGpuDescriptorHandle());
 	m_pGraphicsCommandList->SetGraphicsRootConstantBufferView(DeferredPass::LightPass::LightPassRootSignatureParams::PER_FRAME_DEFERRED_CB, GetDeferredPerFrameUploadBuffer()->GetBufferGPUAddress());
-	m_pGraphicsCommandList->SetGraphicsRootConstantBufferView(DeferredPass::LightPass::LightPassRootSignatureParams::PER_FRAME_RAYTRACE_CB, m_pGIVolume->GetRaytracePerFrameUpload()->GetBufferGPUAddress());
+
+	//Unused slots still need something bound, the shader only reads NumGICascades of them
+	for (int i = 0; i < MAX_GI_CASCADES; ++i)
+	{
+		GIVolume* pVolume = m_GIVolumes[(std::min)(i, (int)m_GIVolumes.size() - 1)];
+
+		m_pGraphicsCommandList->SetGraphicsRootConstantBufferView(DeferredPass::LightPass::LightPassRootSignatureParams::PER_FRAME_RAYTRACE_CB + i, pVolume->GetRaytracePerFrameUpload()->GetBufferGPUAddress());
+	}
 	m_pGraphicsCommandList->SetGraphicsRootConstantBufferView(DeferredPass::LightPass::LightPassRootSignatureParams::PER_FRAME_SCENE_CB, m_pScenePerFrameCBUpload->GetBufferGPUAddress(m_uiFrameIndex));
 
 	D3D12_VERTEX_BUFFER_VIEW vertexBufferView;
@@ -655,12 +780,62 @@ void App::DrawLightPass()
 
 	m_pGraphicsCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-	m_pGraphicsCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(GetBackBuffer(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
+	DrawProbes();
+
+	pResourceBarriers[0] = CD3DX12_RESOURCE_BARRIER::Transition(GetBackBuffer(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
+	pResourceBarriers[1] = CD3DX12_RESOURCE_BARRIER::Transition(GetDepthStencilBuffer()->GetResource().Get(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_GENERIC_READ);
+
+	m_pGraphicsCommandList->ResourceBarrier(2, pResourceBarriers);
 
 	PIX_ONLY(PIXEndEvent());
 	GPU_PROFILE_END(GpuStats::LIGHT, m_pGraphicsCommandList)
 }
 
+void App::DrawProbes()
+{
+	PROFILE("Draw Probes");
+
+	bool bShowingProbes = false;
+
+	for (int i = 0; i < (int)m_GIVolumes.size(); ++i)
+	{
+		bShowingProbes |= m_GIVolumes[i]->IsShowingProbes();
+	}
+
+	if (bShowingProbes == false)
+	{
+		return;
+	}
+
+	GPU_PROFILE_BEGIN(GpuStats::DRAW_PROBES, m_pGraphicsCommandList)
+	PIX_ONLY(PIXBeginEvent(m_pGraphicsCommandList.Get(), PIX_COLOR(50, 50, 50), "Draw Probes"));
+
+	//Compute state is separate from graphics state so the light pass's bindings are still there afterwards
+	for (int i = 0; i < (int)m_GIVolumes.size(); ++i)
+	{
+		if (m_GIVolumes[i]->IsShowingProbes() == true)
+		{
+			m_GIVolumes[i]->UpdateProbePositions(m_pSRVHeap, m_pScenePerFrameCBUpload, m_pGraphicsCommandList.Get());
+		}
+	}
+
+	m_pGraphicsCommandList->SetPipelineState(m_pProbeVisualizationPSO.Get());
+
+	//One instance per probe, the volume's own constant buffer goes where the light pass has the finest cascade's
+	for (int i = 0; i < (int)m_GIVolumes.size(); ++i)
+	{
+		if (m_GIVolumes[i]->IsShowingProbes() == true)
+		{
+			m_pGraphicsCommandList->SetGraphicsRootConstantBufferView(DeferredPass::LightPass::LightPassRootSignatureParams::PER_FRAME_RAYTRACE_CB, m_GIVolumes[i]->GetRaytracePerFrameUpload()->GetBufferGPUAddress());
+
+			m_pGraphicsCommandList->DrawInstanced(6, m_GIVolumes[i]->GetNumProbes(), 0, 0);
+		}
+	}
+
+	PIX_ONLY(PIXEndEvent());
+	GPU_PROFILE_END(GpuStats::DRAW_PROBES, m_pGraphicsCommandList)
+}
+
 int App::Run()
 {
 	MSG msg = { 0 };
@@ -695,6 +870,29 @@ int App::Run()
 	return (int)msg.wParam;
 }
 
+int App::RunBenchmarks(const std::string& ksSceneFilepath)
+{
+	//The GPU hasn't run a frame so the volume's constants are the ones it was created with
+	BenchmarkRunner runner;
+
+	if (runner.Init(*m_GIVolumes[0]->GetRaytracePerFrameUpload()->GetMappedData(), m_LightCBs) == false)
+	{
+		LOG_ERROR(tag, L"Failed to init the benchmarks!");
+
+		return 0;
+	}
+
+	runner.Run();
+
+	std::string sSceneName = ksSceneFilepath == "" ? "Default" : ksSceneFilepath;
+	sSceneName = sSceneName.substr(sSceneName.find_last_of("/\\") + 1);
+	sSceneName = sSceneName.substr(0, sSceneName.find_last_of('.'));
+
+	runner.WriteResults("Times/Benchmarks-" + sSceneName + "-" + m_sRunName + ".json");
+
+	return 0;
+}
+
 void App::Load()
 {
 }
@@ -707,7 +905,14 @@ void App::Save(const std::string& sFileName)
 
 	ObjectManager::GetInstance()->Save(data);
 
-	m_pGIVolume->Save(data);
+	m_GIVolumes[0]->Save(data, sFileName);
+
+	data["GIVolume"]["NumCascades"].push_back(m_GICascades.GetNumCascades());
+
+	for (int i = 0; i < m_GICascades.GetNumCascades(); ++i)
+	{
+		data["GIVolume"]["CascadeUpdateIntervals"].push_back(m_GICascades.GetCascade(i).UpdateInterval);
+	}
 
 	for (int i = 0; i < m_uiNumLights; ++i)
 	{
@@ -1147,10 +1352,11 @@ void App::FlushCommandQueue()
 
 bool App::CreatePSOs()
 {
-	D3D12_DEPTH_STENCIL_DESC depthDesc;
-	depthDesc.DepthEnable = false;
+	//The light pass writes the depth of the G buffer's positions so the probes can be depth tested
+	D3D12_DEPTH_STENCIL_DESC depthDesc = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+	depthDesc.DepthFunc = D3D12_COMPARISON_FUNC_ALWAYS;
 	depthDesc.StencilEnable = false;
-	depthDesc.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO;
+	depthDesc.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
 
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
 	psoDesc.InputLayout = { m_ScreenQuadInputDesc.data(), (UINT)m_ScreenQuadInputDesc.size() };
@@ -1164,7 +1370,7 @@ bool App::CreatePSOs()
 	psoDesc.SampleDesc.Count = m_b4xMSAAState ? 4 : 1;
 	psoDesc.SampleDesc.Quality = m_b4xMSAAState ? (m_uiMSAAQuality - 1) : 0;
 	psoDesc.RTVFormats[0] = m_BackBufferFormat;
-	psoDesc.DSVFormat = DXGI_FORMAT_UNKNOWN;
+	psoDesc.DSVFormat = m_DepthStencilDSVFormat;
 	psoDesc.VS.BytecodeLength = m_Shaders[m_wsLightPassVertexName].Get()->GetBufferSize();
 	psoDesc.VS.pShaderBytecode = m_Shaders[m_wsLightPassVertexName].Get()->GetBufferPointer();
 
@@ -1183,6 +1389,24 @@ bool App::CreatePSOs()
 		}
 	}
 
+	//Probes are camera facing quads built from SV_VertexID so there is no input layout
+	psoDesc.InputLayout = { nullptr, 0 };
+	psoDesc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+	psoDesc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+	psoDesc.VS.BytecodeLength = m_Shaders[m_wsProbeVisualizationVertexName].Get()->GetBufferSize();
+	psoDesc.VS.pShaderBytecode = m_Shaders[m_wsProbeVisualizationVertexName].Get()->GetBufferPointer();
+	psoDesc.PS.BytecodeLength = m_Shaders[m_wsProbeVisualizationPixelName].Get()->GetBufferSize();
+	psoDesc.PS.pShaderBytecode = m_Shaders[m_wsProbeVisualizationPixelName].Get()->GetBufferPointer();
+
+	HRESULT hr = m_pDevice->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(m_pProbeVisualizationPSO.GetAddressOf()));
+
+	if (FAILED(hr))
+	{
+		LOG_ERROR(tag, L"Failed to create probe visualization PSO!");
+
+		return false;
+	}
+
 	return true;
 }
 
@@ -1297,6 +1521,9 @@ bool App::CompileShaders()
 		CompileRecord(L"Shaders/LightPassPixel.hlsl", m_wsLightPassPixelNames[(int)DeferredPass::LightPass::ShaderVersions::DIRECT], L"ps_6_3"),
 		CompileRecord(L"Shaders/LightPassPixel.hlsl", m_wsLightPassPixelNames[(int)DeferredPass::LightPass::ShaderVersions::SHOW_INDIRECT], L"ps_6_3", L"", showIndirect, _countof(showIndirect)),
 		CompileRecord(L"Shaders/LightPassPixel.hlsl", m_wsLightPassPixelNames[(int)DeferredPass::LightPass::ShaderVersions::USE_GI], L"ps_6_3", L"", useGI, _countof(useGI)),
+
+		CompileRecord(L"Shaders/ProbeVisualizationVertex.hlsl", m_wsProbeVisualizationVertexName, L"vs_6_3"),
+		CompileRecord(L"Shaders/ProbeVisualizationPixel.hlsl", m_wsProbeVisualizationPixelName, L"ps_6_3"),
 	};
 
 	for (int i = 0; i < _countof(records); ++i)
@@ -1325,11 +1552,16 @@ void App::CreateGeometry(const std::string& ksFilepath)
 		return;
 	}
 
+	//Meshes are parsed and decoded on the pool while this thread creates their resources, it's only needed until
+	//they're loaded
+	ThreadPool threadPool;
+
+	MeshManager::GetInstance()->SetThreadPool(&threadPool);
+
 	//If no filepath specified then load hard coded scene
 	if (ksFilepath == "")
 	{
-		MeshManager::GetInstance()->LoadMesh("Models/Sponza/gLTF/Sponza.gltf", "Cornell", m_pGraphicsCommandList.Get());
-		MeshManager::GetInstance()->LoadMesh("Models/Sphere/gLTF/Sphere.gltf", "Sphere", m_pGraphicsCommandList.Get());
+		MeshManager::GetInstance()->LoadMeshes({ "Models/Sponza/gLTF/Sponza.gltf", "Models/Sphere/gLTF/Sphere.gltf" }, { "Cornell", "Sphere" }, m_pGraphicsCommandList.Get());
 		//MeshManager::GetInstance()->LoadMesh("Models/Sponza/gLTF/Sponza.gltf", "Sponza", m_pGraphicsCommandList.Get());
 	}
 	else
@@ -1337,6 +1569,8 @@ void App::CreateGeometry(const std::string& ksFilepath)
 		MeshManager::GetInstance()->LoadScene(ksFilepath, m_pGraphicsCommandList.Get());
 	}
 
+	MeshManager::GetInstance()->SetThreadPool(nullptr);
+
 	m_pGraphicsCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 	ExecuteCommandList();
@@ -1517,7 +1751,7 @@ void App::CreateScreenQuad()
 	ExecuteCommandList();
 }
 
-void App::InitScene(const std::string& ksFilepath)
+bool App::InitScene(const std::string& ksFilepath)
 {
 	Mesh* pMesh = nullptr;
 	GameObject* pGameObject = nullptr;
@@ -1539,6 +1773,15 @@ void App::InitScene(const std::string& ksFilepath)
 		volumeDesc.Position = XMFLOAT3(0, 1, 0);
 		volumeDesc.ProbeCounts = XMINT3(22, 22, 22);
 		volumeDesc.ProbeRelocation = false;
+		volumeDesc.ProbeClassification = false;
+		volumeDesc.ProbeSchedulingMode = (int)ProbeSchedulingMode::ALL;
+		volumeDesc.ProbeUpdateBudget = 0;
+		volumeDesc.ProbeMaxAge = 8;
+		volumeDesc.AdaptiveRays = false;
+		volumeDesc.RayBudget = 22 * 22 * 22 * 144;
+		volumeDesc.MinRaysPerProbe = 32;
+		volumeDesc.RayRotationSequence = (int)RayRotationSequence::RANDOM;
+		volumeDesc.PerProbeRayRotation = false;
 		volumeDesc.ProbeScale = 0.05f;
 		volumeDesc.ProbeSpacing = XMFLOAT3(1.02f, 0.5f, 0.45f);
 		volumeDesc.ProbeTracking = false;
@@ -1553,14 +1796,33 @@ void App::InitScene(const std::string& ksFilepath)
 		volumeDesc.BrightnessThreshold = 2.0f;
 		volumeDesc.DistancePower = 50.0f;
 		volumeDesc.Hysteresis = 0.97f;
+		volumeDesc.AdaptiveHysteresis = false;
+		volumeDesc.MinHysteresis = 0.8f;
+		volumeDesc.HysteresisRiseRate = 0.05f;
+		volumeDesc.HysteresisChangeThreshold = 0.1f;
+		volumeDesc.ProbeSleeping = false;
+		volumeDesc.ProbeSleepFrames = 30;
+		volumeDesc.ProbeSleepThreshold = 0.0005f;
+		volumeDesc.ProbeWakeRadius = 2.0f;
+		volumeDesc.ProbeFilter = PROBE_FILTER_NONE;
+		volumeDesc.ProbeFilterStrength = 0.25f;
+		volumeDesc.RayDataFormat = FORMAT_PROBE_RAY_DATA_R32G32B32A32_FLOAT;
 		volumeDesc.IrradianceFormat = 1;
+		volumeDesc.IrradianceEncoding = PROBE_IRRADIANCE_ENCODING_OCTAHEDRAL;
+		volumeDesc.AtlasLayout = PROBE_ATLAS_LAYOUT_PLANES;
 		volumeDesc.IrradianceGammaEncoding = 5.0f;
 		volumeDesc.IrradianceThreshold = 0.2f;
+		volumeDesc.ProbeMinFrontfaceDistance = 0.1f;
+		volumeDesc.ProbeBackfaceThreshold = 0.25f;
 		volumeDesc.MissRadiance = DirectX::XMFLOAT3(0, 0, 0);
 		volumeDesc.ProbeOffsets = DirectX::XMINT3(0, 0, 0);
 		volumeDesc.Anchor = DirectX::XMFLOAT3(0, 0, 0);
+		volumeDesc.CascadeIndex = 0;
 
-		m_pGIVolume = new GIVolume(volumeDesc, m_pGraphicsCommandList.Get(), m_pSRVHeap, m_pRTVHeap);
+		if (CreateGIVolumes(volumeDesc, 1) == false)
+		{
+			return false;
+		}
 
 		CreateCameras();
 	}
@@ -1573,7 +1835,7 @@ void App::InitScene(const std::string& ksFilepath)
 		{
 			LOG_ERROR(tag, L"Failed to open scene json file when loading game object data!");
 
-			return;
+			return false;
 		}
 
 		nlohmann::json data;
@@ -1610,6 +1872,15 @@ void App::InitScene(const std::string& ksFilepath)
 		volumeDesc.Position = XMFLOAT3(data["GIVolume"]["Position"][0][0], data["GIVolume"]["Position"][0][1], data["GIVolume"]["Position"][0][2]);
 		volumeDesc.ProbeCounts = XMINT3(data["GIVolume"]["ProbeCounts"][0][0], data["GIVolume"]["ProbeCounts"][0][1], data["GIVolume"]["ProbeCounts"][0][2]);
 		volumeDesc.ProbeRelocation = data["GIVolume"]["ProbeRelocation"][0];
+		volumeDesc.ProbeClassification = data["GIVolume"].contains("ProbeClassification") == true ? (bool)data["GIVolume"]["ProbeClassification"][0] : false;
+		volumeDesc.ProbeSchedulingMode = data["GIVolume"].contains("ProbeSchedulingMode") == true ? (int)data["GIVolume"]["ProbeSchedulingMode"][0] : (int)ProbeSchedulingMode::ALL;
+		volumeDesc.ProbeUpdateBudget = data["GIVolume"].contains("ProbeUpdateBudget") == true ? (int)data["GIVolume"]["ProbeUpdateBudget"][0] : 0;
+		volumeDesc.ProbeMaxAge = data["GIVolume"].contains("ProbeMaxAge") == true ? (int)data["GIVolume"]["ProbeMaxAge"][0] : 8;
+		volumeDesc.AdaptiveRays = data["GIVolume"].contains("AdaptiveRays") == true ? (bool)data["GIVolume"]["AdaptiveRays"][0] : false;
+		volumeDesc.RayBudget = data["GIVolume"].contains("RayBudget") == true ? (int)data["GIVolume"]["RayBudget"][0] : volumeDesc.ProbeCounts.x * volumeDesc.ProbeCounts.y * volumeDesc.ProbeCounts.z * (int)data["GIVolume"]["RaysPerProbe"][0] / 2;
+		volumeDesc.MinRaysPerProbe = data["GIVolume"].contains("MinRaysPerProbe") == true ? (int)data["GIVolume"]["MinRaysPerProbe"][0] : 32;
+		volumeDesc.RayRotationSequence = data["GIVolume"].contains("RayRotationSequence") == true ? (int)data["GIVolume"]["RayRotationSequence"][0] : (int)RayRotationSequence::RANDOM;
+		volumeDesc.PerProbeRayRotation = data["GIVolume"].contains("PerProbeRayRotation") == true ? (bool)data["GIVolume"]["PerProbeRayRotation"][0] : false;
 		volumeDesc.ProbeScale = data["GIVolume"]["ProbeScale"][0];
 		volumeDesc.ProbeSpacing = XMFLOAT3(data["GIVolume"]["ProbeSpacing"][0][0], data["GIVolume"]["ProbeSpacing"][0][1], data["GIVolume"]["ProbeSpacing"][0][2]);
 		volumeDesc.ProbeTracking = data["GIVolume"]["ProbeTracking"][0];
@@ -1624,15 +1895,85 @@ void App::InitScene(const std::string& ksFilepath)
 		volumeDesc.BrightnessThreshold = data["GIVolume"]["BrightnessThreshold"][0];
 		volumeDesc.DistancePower = data["GIVolume"]["DistancePower"][0];
 		volumeDesc.Hysteresis = data["GIVolume"]["Hysteresis"][0];
+		volumeDesc.AdaptiveHysteresis = data["GIVolume"].contains("AdaptiveHysteresis") == true ? (bool)data["GIVolume"]["AdaptiveHysteresis"][0] : false;
+		volumeDesc.MinHysteresis = data["GIVolume"].contains("MinHysteresis") == true ? (float)data["GIVolume"]["MinHysteresis"][0] : 0.8f;
+		volumeDesc.HysteresisRiseRate = data["GIVolume"].contains("HysteresisRiseRate") == true ? (float)data["GIVolume"]["HysteresisRiseRate"][0] : 0.05f;
+		volumeDesc.HysteresisChangeThreshold = data["GIVolume"].contains("HysteresisChangeThreshold") == true ? (float)data["GIVolume"]["HysteresisChangeThreshold"][0] : 0.1f;
+		volumeDesc.ProbeSleeping = data["GIVolume"].contains("ProbeSleeping") == true ? (bool)data["GIVolume"]["ProbeSleeping"][0] : false;
+		volumeDesc.ProbeSleepFrames = data["GIVolume"].contains("ProbeSleepFrames") == true ? (int)data["GIVolume"]["ProbeSleepFrames"][0] : 30;
+		volumeDesc.ProbeSleepThreshold = data["GIVolume"].contains("ProbeSleepThreshold") == true ? (float)data["GIVolume"]["ProbeSleepThreshold"][0] : 0.0005f;
+		volumeDesc.ProbeWakeRadius = data["GIVolume"].contains("ProbeWakeRadius") == true ? (float)data["GIVolume"]["ProbeWakeRadius"][0] : 2.0f;
+		volumeDesc.ProbeFilter = data["GIVolume"].contains("ProbeFilter") == true ? (int)data["GIVolume"]["ProbeFilter"][0] : PROBE_FILTER_NONE;
+		volumeDesc.ProbeFilterStrength = data["GIVolume"].contains("ProbeFilterStrength") == true ? (float)data["GIVolume"]["ProbeFilterStrength"][0] : 0.25f;
+		volumeDesc.RayDataFormat = data["GIVolume"].contains("RayDataFormat") == true ? (int)data["GIVolume"]["RayDataFormat"][0] : volumeDesc.GIAtlasSize;	//Used to follow the atlas size
 		volumeDesc.IrradianceFormat = data["GIVolume"]["IrradianceFormat"][0];
+		volumeDesc.IrradianceEncoding = data["GIVolume"].contains("IrradianceEncoding") == true ? (int)data["GIVolume"]["IrradianceEncoding"][0] : PROBE_IRRADIANCE_ENCODING_OCTAHEDRAL;
+		volumeDesc.AtlasLayout = data["GIVolume"].contains("AtlasLayout") == true ? (int)data["GIVolume"]["AtlasLayout"][0] : PROBE_ATLAS_LAYOUT_PLANES;
 		volumeDesc.IrradianceGammaEncoding = data["GIVolume"]["IrradianceGammaEncoding"][0];
 		volumeDesc.IrradianceThreshold = data["GIVolume"]["IrradianceThreshold"][0];
+		volumeDesc.ProbeMinFrontfaceDistance = data["GIVolume"].contains("ProbeMinFrontfaceDistance") == true ? (float)data["GIVolume"]["ProbeMinFrontfaceDistance"][0] : 0.1f;
+		volumeDesc.ProbeBackfaceThreshold = data["GIVolume"].contains("ProbeBackfaceThreshold") == true ? (float)data["GIVolume"]["ProbeBackfaceThreshold"][0] : 0.25f;
 		volumeDesc.MissRadiance = DirectX::XMFLOAT3(data["GIVolume"]["MissRadiance"][0][0], data["GIVolume"]["MissRadiance"][0][1], data["GIVolume"]["MissRadiance"][0][2]);
 		volumeDesc.ProbeOffsets = DirectX::XMINT3(data["GIVolume"]["ProbeOffsets"][0][0], data["GIVolume"]["ProbeOffsets"][0][1], data["GIVolume"]["ProbeOffsets"][0][2]);
 		volumeDesc.Anchor = DirectX::XMFLOAT3(data["GIVolume"]["AnchorPosition"][0][0], data["GIVolume"]["AnchorPosition"][0][1], data["GIVolume"]["AnchorPosition"][0][2]);
+		volumeDesc.CascadeIndex = 0;
 
-		m_pGIVolume = new GIVolume(volumeDesc, m_pGraphicsCommandList.Get(), m_pSRVHeap, m_pRTVHeap);
+		if (CreateGIVolumes(volumeDesc, data["GIVolume"].contains("NumCascades") == true ? (int)data["GIVolume"]["NumCascades"][0] : 1) == false)
+		{
+			return false;
+		}
+
+		if (data["GIVolume"].contains("CascadeUpdateIntervals") == true)
+		{
+			for (int i = 0; i < m_GICascades.GetNumCascades() && i < (int)data["GIVolume"]["CascadeUpdateIntervals"].size(); ++i)
+			{
+				m_GICascades.SetUpdateInterval(i, data["GIVolume"]["CascadeUpdateIntervals"][i]);
+			}
+		}
+
+		//Only the innermost cascade is saved, the others converge from black
+		if (data["GIVolume"].contains("AtlasSnapshot") == true)
+		{
+			m_GIVolumes[0]->LoadSnapshot(data["GIVolume"]["AtlasSnapshot"][0].get<std::string>());
+		}
 	}
+
+	return true;
+}
+
+bool App::CreateGIVolumes(const GIVolumeDesc& kVolumeDesc, int iNumCascades)
+{
+	m_GICascades.Init(iNumCascades, kVolumeDesc.Position, kVolumeDesc.ProbeSpacing, kVolumeDesc.ProbeCounts, kVolumeDesc.ProbeOffsets);
+
+	for (int i = 0; i < m_GICascades.GetNumCascades(); ++i)
+	{
+		const GICascade& kCascade = m_GICascades.GetCascade(i);
+
+		GIVolumeDesc cascadeDesc = kVolumeDesc;
+		cascadeDesc.CascadeIndex = i;
+		cascadeDesc.ProbeSpacing = kCascade.ProbeSpacing;
+		cascadeDesc.ProbeOffsets = kCascade.ProbeOffsets;
+
+		if (i != 0)
+		{
+			cascadeDesc.ShowProbes = false;
+		}
+
+		GIVolume* pVolume = new GIVolume();
+
+		if (pVolume->Init(cascadeDesc, m_pGraphicsCommandList.Get(), m_pSRVHeap, m_pRTVHeap) == false)
+		{
+			LOG_ERROR(tag, L"Failed to create GI cascade %d!", i);
+
+			delete pVolume;
+
+			return false;
+		}
+
+		m_GIVolumes.push_back(pVolume);
+	}
+
+	return true;
 }
 
 void App::InitConstantBuffers(const std::string& ksFilepath)
@@ -1757,16 +2098,41 @@ void App::DrawImGui()
 
 		ImGui::Checkbox("Show Indirect", &m_bShowIndirect);
 
+		ImGui::Spacing();
+
+		ImGui::Text("Cascades: %d", m_GICascades.GetNumCascades());
+		ImGui::Text("Camera Cascade: %d", m_GICascades.SelectCascade(ObjectManager::GetInstance()->GetActiveCamera()->GetPosition()));
+
+		for (int i = 0; i < m_GICascades.GetNumCascades(); ++i)
+		{
+			int iUpdateInterval = m_GICascades.GetCascade(i).UpdateInterval;
+
+			if (ImGui::DragInt(("Cascade " + std::to_string(i) + " Update Interval").c_str(), &iUpdateInterval, 1.0f, 1, 64) == true)
+			{
+				m_GICascades.SetUpdateInterval(i, iUpdateInterval);
+			}
+		}
+
 		ImGui::TreePop();
 	}
 
-	m_pGIVolume->ShowUI();
+	for (int i = 0; i < (int)m_GIVolumes.size(); ++i)
+	{
+		m_GIVolumes[i]->ShowUI();
+	}
 
 	if (ImGui::Button("Save") == true)
 	{
 		Save("Test");
 	}
 
+	ImGui::SameLine();
+
+	if (ImGui::Button("Cook Meshes") == true)
+	{
+		MeshManager::GetInstance()->CookMeshes();
+	}
+
 	ImGui::End();
 
 	ImGui::Render();
@@ -2198,11 +2564,15 @@ bool App::CreateLightPassRootSignature()
 	slotRootParameter[DeferredPass::LightPass::LightPassRootSignatureParams::PER_FRAME_DEFERRED_CB].Descriptor.ShaderRegister = 1;
 	slotRootParameter[DeferredPass::LightPass::LightPassRootSignatureParams::PER_FRAME_DEFERRED_CB].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE;
 
-	slotRootParameter[DeferredPass::LightPass::LightPassRootSignatureParams::PER_FRAME_RAYTRACE_CB].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
-	slotRootParameter[DeferredPass::LightPass::LightPassRootSignatureParams::PER_FRAME_RAYTRACE_CB].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-	slotRootParameter[DeferredPass::LightPass::LightPassRootSignatureParams::PER_FRAME_RAYTRACE_CB].Descriptor.RegisterSpace = 0;
-	slotRootParameter[DeferredPass::LightPass::LightPassRootSignatureParams::PER_FRAME_RAYTRACE_CB].Descriptor.ShaderRegister = 2;
-	slotRootParameter[DeferredPass::LightPass::LightPassRootSignatureParams::PER_FRAME_RAYTRACE_CB].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE;
+	//One per GI cascade in b2 onwards
+	for (int i = 0; i < MAX_GI_CASCADES; ++i)
+	{
+		slotRootParameter[DeferredPass::LightPass::LightPassRootSignatureParams::PER_FRAME_RAYTRACE_CB + i].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+		slotRootParameter[DeferredPass::LightPass::LightPassRootSignatureParams::PER_FRAME_RAYTRACE_CB + i].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+		slotRootParameter[DeferredPass::LightPass::LightPassRootSignatureParams::PER_FRAME_RAYTRACE_CB + i].Descriptor.RegisterSpace = 0;
+		slotRootParameter[DeferredPass::LightPass::LightPassRootSignatureParams::PER_FRAME_RAYTRACE_CB + i].Descriptor.ShaderRegister = 2 + i;
+		slotRootParameter[DeferredPass::LightPass::LightPassRootSignatureParams::PER_FRAME_RAYTRACE_CB + i].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE;
+	}
 
 	std::array<const CD3DX12_STATIC_SAMPLER_DESC, 6> staticSamplers = DXRHelper::GetStaticSamplers();
 
@@ -2597,6 +2967,7 @@ void App::PopulatePrimitivePerInstanceCB()
 
 				primitiveInstanceCB.IndicesIndex = pNodes->at(i)->m_Primitives[j]->m_pIndexDesc->GetDescriptorIndex();
 				primitiveInstanceCB.VerticesIndex = pNodes->at(i)->m_Primitives[j]->m_pVertexDesc->GetDescriptorIndex();
+				primitiveInstanceCB.VertexFormat = it->second->GetVertexFormat();
 
 				m_pPrimitiveInstanceCBUpload->CopyData(pNodes->at(i)->m_Primitives[j]->m_iIndex, primitiveInstanceCB);
 			}
@@ -2614,6 +2985,7 @@ void App::PopulateDeferredPerFrameCB()
 		deferredPerFrameCB.DirectLightIndex = m_FrameResources[i].m_GBuffer[(int)GBuffer::DIRECT_LIGHT]->GetSRVDesc()->GetDescriptorIndex();
 		deferredPerFrameCB.NormalIndex = m_FrameResources[i].m_GBuffer[(int)GBuffer::NORMAL]->GetSRVDesc()->GetDescriptorIndex();
 		deferredPerFrameCB.PositionIndex = m_FrameResources[i].m_GBuffer[(int)GBuffer::POSITION]->GetSRVDesc()->GetDescriptorIndex();
+		deferredPerFrameCB.NumGICascades = m_GICascades.GetNumCascades();
 
 		GetDeferredPerFrameUploadBuffer(i)->CopyData(0, deferredPerFrameCB);
 	}
@@ -2623,8 +2995,10 @@ bool App::CreateDescriptorHeaps()
 {
 	m_pSRVHeap = new DescriptorHeap();
 
-	//2 descriptors per primitive (index and vertex buffers), 1 descriptor per texture, 1 extra descriptor for output texture, 2 extra per in flight frame for structured buffers and 1 extra for primitive instance structured buffer, 4 extra per in flight frame for G Buffer, 1 extra per in flight frame for depth buffer, 8 for Global illumination
-	if (m_pSRVHeap->Init(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE, (MeshManager::GetInstance()->GetNumPrimitives() * 2) + TextureManager::GetInstance()->GetNumTextures() + 40) == false)
+	//2 descriptors per primitive (index and vertex buffers), 1 descriptor per texture, 2 per in flight frame for the light and game object structured buffers and 1 for the primitive instance structured buffer, an SRV and UAV per G Buffer texture and an SRV for the depth buffer per in flight frame, the rest for Global illumination with room for every cascade
+	UINT uiNumAppDescriptors = (s_kuiSwapChainBufferCount * (2 + ((int)GBuffer::COUNT * 2) + 1)) + 1;
+
+	if (m_pSRVHeap->Init(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE, (MeshManager::GetInstance()->GetNumPrimitives() * 2) + TextureManager::GetInstance()->GetNumTextures() + uiNumAppDescriptors + (GIVolume::GetNumSRVDescriptors() * MAX_GI_CASCADES)) == false)
 	{
 		return false;
 	}
@@ -2638,7 +3012,7 @@ bool App::CreateDescriptorHeaps()
 
 	m_pRTVHeap = new DescriptorHeap();
 
-	if (m_pRTVHeap->Init(D3D12_DESCRIPTOR_HEAP_TYPE_RTV, D3D12_DESCRIPTOR_HEAP_FLAG_NONE, s_kuiSwapChainBufferCount + ((int)GBuffer::COUNT) * s_kuiSwapChainBufferCount + 2) == false)
+	if (m_pRTVHeap->Init(D3D12_DESCRIPTOR_HEAP_TYPE_RTV, D3D12_DESCRIPTOR_HEAP_FLAG_NONE, s_kuiSwapChainBufferCount + ((int)GBuffer::COUNT) * s_kuiSwapChainBufferCount + GIVolume::GetNumRTVDescriptors() * MAX_GI_CASCADES) == false)
 	{
 		return false;
 	}
@@ -10,6 +10,8 @@
 #include "Commons/AccelerationBuffers.h"
 #include "Cameras/DebugCamera.h"
 #include "Shaders/ConstantBuffers.h"
+#include "Shaders/Defines.hlsli"
+#include "GI/GICascades.h"
 
 #include <unordered_map>
 #include <array>
@@ -21,6 +23,8 @@ class DescriptorHeap;
 class Descriptor;
 class Texture;
 class GIVolume;
+
+struct GIVolumeDesc;
 class GameObject;
 
 struct RayGenerationCB;
@@ -62,6 +66,18 @@ struct FrameResources
 	Descriptor* m_pDepthStencilBufferView;
 };
 
+//A GI contributing object as it was the last time it was checked for a change, kept between frames to wake probes
+struct GIObjectState
+{
+	DirectX::XMFLOAT4X4 World;
+
+	//World space bounds of the object's mesh
+	DirectX::XMFLOAT3 BoundsMin;
+	DirectX::XMFLOAT3 BoundsMax;
+
+	bool Seen = false;	//Cleared after every check so objects that have gone can be found
+};
+
 namespace DeferredPass
 {
 	enum Value
@@ -121,9 +137,9 @@ namespace DeferredPass
 				STANDARD_DESCRIPTORS = 0,
 				PER_FRAME_SCENE_CB,
 				PER_FRAME_DEFERRED_CB,
-				PER_FRAME_RAYTRACE_CB,
+				PER_FRAME_RAYTRACE_CB,	//One per GI cascade from here, finest first
 
-				COUNT
+				COUNT = PER_FRAME_RAYTRACE_CB + MAX_GI_CASCADES
 			};
 		}
 
@@ -159,9 +175,13 @@ public:
 	void DrawDeferredPass();
 	void DrawGBufferPass();
 	void DrawLightPass();
+	void DrawProbes();
 
 	int Run();
 
+	//Runs the CPU benchmarks on the loaded scene instead of the main loop, results go in Times/ named after the scene
+	int RunBenchmarks(const std::string& ksSceneFilepath);
+
 	virtual void Load();
 	virtual void Save(const std::string& sFileName);
 
@@ -232,7 +252,13 @@ protected:
 
 	void CreateScreenQuad();
 
-	void InitScene(const std::string& ksFilepath);
+	bool InitScene(const std::string& ksFilepath);
+
+	//kVolumeDesc is cascade 0, the rest copy its settings with double the spacing of the cascade inside them
+	bool CreateGIVolumes(const GIVolumeDesc& kVolumeDesc, int iNumCascades);
+
+	//Wakes the GI volumes' sleeping probes when a light changes or an object that contributes to GI moves
+	void WakeGIProbes();
 	void InitConstantBuffers(const std::string& ksFilepath);
 
 	void InitImGui();
@@ -321,6 +347,7 @@ protected:
 	UINT m_uiRayGenRecordSize;
 
 	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_pLightPassPSOs[(int)DeferredPass::LightPass::ShaderVersions::COUNT] = { nullptr };
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_pProbeVisualizationPSO = nullptr;
 
 	Microsoft::WRL::ComPtr<IDXGIFactory4> m_pDXGIFactory = nullptr;
 	Microsoft::WRL::ComPtr<ID3D12Fence> m_pFence = nullptr;
@@ -388,6 +415,9 @@ protected:
 		L"LightPassDirect",
 	};
 
+	LPCWSTR m_wsProbeVisualizationVertexName = L"ProbeVisualizationVertex";
+	LPCWSTR m_wsProbeVisualizationPixelName = L"ProbeVisualizationPixel";
+
 	std::vector<D3D12_INPUT_ELEMENT_DESC> m_ScreenQuadInputDesc;
 	std::vector<D3D12_INPUT_ELEMENT_DESC> m_DefaultInputDesc;
 
@@ -426,7 +456,15 @@ protected:
 
 	GameObject* m_pLight = nullptr;
 
-	GIVolume* m_pGIVolume = nullptr;
+	//Cascade 0 is the innermost volume, the others double the spacing of the one before
+	std::vector<GIVolume*> m_GIVolumes;
+	GICascades m_GICascades;
+	UINT64 m_uiGIFrame = 0;
+
+	//Lights and GI contributing objects as they were last frame, compared against to wake probes
+	std::vector<LightCB> m_GILightCBs;
+	std::unordered_map<std::string, GIObjectState> m_GIObjectStates;
+	std::vector<std::pair<DirectX::XMFLOAT3, DirectX::XMFLOAT3>> m_GIWakeBounds;
 
 	bool m_bShowIndirect = false;
 	bool m_bUseGI = true;
@@ -0,0 +1,585 @@
+#include "BenchmarkRunner.h"
+#include "Cameras/Camera.h"
+#include "GI/AtlasLayoutBenchmark.h"
+#include "GI/CPUIrradianceQuery.h"
+#include "GI/ProbeFilterBenchmark.h"
+#include "GI/RayRotationExperiment.h"
+#include "GI/RayRotationGenerator.h"
+#include "Commons/Timer.h"
+#include "Helpers/DebugHelper.h"
+#include "Helpers/HDRPackingHelper.h"
+#include "Helpers/ProbeHelper.h"
+#include "Managers/MeshCache.h"
+#include "Managers/MeshLoadBenchmark.h"
+#include "Managers/MeshManager.h"
+#include "Managers/ObjectManager.h"
+#include "Shaders/Defines.hlsli"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <math.h>
+#include <thread>
+
+using namespace DirectX;
+
+Tag tag = L"BenchmarkRunner";
+
+#define NUM_TRACE_FRAMES 8
+
+#define NUM_REFERENCE_FRAMES 64
+#define REFERENCE_RAYS_PER_PROBE 1024
+#define NUM_ROTATION_FRAMES 64
+#define ROTATION_ERROR_THRESHOLD 0.1f
+
+#define NUM_BLEND_FRAMES 32
+
+#define NUM_QUERY_WAVES 4096
+#define QUERY_WAVE_SIZE 64
+#define QUERY_WAVE_RADIUS 0.25f
+
+#define NUM_FILTER_FRAMES 16
+
+#define NUM_MESH_LOADS 8
+#define NUM_SCENE_LOADS 4
+
+BenchmarkRunner::BenchmarkRunner() : m_Tracer(&m_ThreadPool), m_Blender(&m_ThreadPool)
+{
+}
+
+bool BenchmarkRunner::Init(const RaytracePerFrameCB& kParams, const std::vector<LightCB>& kLights)
+{
+	m_Params = kParams;
+	m_Params.ClearPlane = XMINT3(0, 0, 0);
+	m_Params.ProbeRelocation = 0;
+	m_Params.ProbeClassification = 0;
+	m_Params.UseActiveProbeList = 0;
+	m_Params.FullProbeUpdate = 1;
+	m_Params.AdaptiveRays = 0;
+	m_Params.AdaptiveHysteresis = 0;
+
+	m_Lights = kLights;
+
+	if (m_Tracer.BuildScene() == false)
+	{
+		LOG_ERROR(tag, L"Failed to init benchmarks as the CPU BVH couldn't be built!");
+
+		return false;
+	}
+
+	m_Tracer.SetHitShader([this](const CPUSurfaceHit& kHit)
+	{
+		return ShadeHit(kHit);
+	});
+
+	return true;
+}
+
+void BenchmarkRunner::Run()
+{
+	RunRayTracer();
+	RunRayRotation();
+	RunIrradianceQuery();
+	RunHDRPacking();
+	RunAtlasLayout();
+	RunProbeFilter();
+	RunMeshLoad();
+	RunSceneLoad();
+}
+
+bool BenchmarkRunner::WriteResults(const std::string& ksFilepath) const
+{
+	std::ofstream file(ksFilepath);
+
+	if (file.is_open() == false)
+	{
+		LOG_ERROR(tag, L"Failed to open %s to write the benchmark results!", std::wstring(ksFilepath.begin(), ksFilepath.end()).c_str());
+
+		return false;
+	}
+
+	file << std::setw(4) << m_Results;
+
+	file.close();
+
+	return true;
+}
+
+void BenchmarkRunner::RunRayTracer()
+{
+	PROFILE("Ray Tracer Benchmark");
+
+	CPUBVH* pBVH = m_Tracer.GetBVH();
+
+	nlohmann::json& data = m_Results["RayTracer"];
+	data["NumTriangles"] = pBVH->GetNumTriangles();
+	data["NumNodes"] = pBVH->GetNumNodes();
+	data["BuildSeconds"] = pBVH->GetLastBuildTime();
+	data["NumProbes"] = m_Params.ProbeCounts.x * m_Params.ProbeCounts.y * m_Params.ProbeCounts.z;
+	data["RaysPerProbe"] = m_Params.RaysPerProbe;
+
+	CPUAtlas rayData;
+
+	RaytracePerFrameCB params = m_Params;
+
+	RayRotationGenerator generator;
+	generator.SetSeed(0);
+
+	//Shaded is what a probe update costs, unshaded is the BVH on its own and on one thread is the per core speed
+	const std::string ksRunNames[3] = { "Shaded", "Unshaded", "SingleThreaded" };
+
+	for (int i = 0; i < 3; ++i)
+	{
+		if (i == 1)
+		{
+			m_Tracer.SetHitShader(nullptr);
+		}
+		else if (i == 2)
+		{
+			m_Tracer.SetThreadPool(nullptr);
+		}
+
+		CPUTraceStats totalStats;
+
+		for (int j = 0; j < NUM_TRACE_FRAMES; ++j)
+		{
+			params.RayRotation = generator.Next();
+
+			m_Tracer.TraceProbeRays(params, rayData);
+
+			const CPUTraceStats& kStats = m_Tracer.GetLastTraceStats();
+
+			totalStats.NumRays += kStats.NumRays;
+			totalStats.NumHits += kStats.NumHits;
+			totalStats.NumBackfaceHits += kStats.NumBackfaceHits;
+			totalStats.NumThreads = kStats.NumThreads;
+			totalStats.Seconds += kStats.Seconds;
+
+			data[ksRunNames[i]]["FrameSeconds"].push_back(kStats.Seconds);
+		}
+
+		AddTraceStats(totalStats, data[ksRunNames[i]]);
+
+		LOG_VERBOSE(tag, L"%s CPU trace: %f Mrays/s over %u threads", std::wstring(ksRunNames[i].begin(), ksRunNames[i].end()).c_str(), totalStats.GetRaysPerSecond() / 1000000.0, totalStats.NumThreads);
+	}
+
+	m_Tracer.SetThreadPool(&m_ThreadPool);
+	m_Tracer.SetHitShader([this](const CPUSurfaceHit& kHit)
+	{
+		return ShadeHit(kHit);
+	});
+}
+
+void BenchmarkRunner::RunRayRotation()
+{
+	PROFILE("Ray Rotation Benchmark");
+
+	//The experiment's error walks the atlas as planes and only knows octahedral irradiance
+	RaytracePerFrameCB params = m_Params;
+	params.AtlasLayout = PROBE_ATLAS_LAYOUT_PLANES;
+	params.IrradianceEncoding = PROBE_IRRADIANCE_ENCODING_OCTAHEDRAL;
+
+	RayRotationExperiment experiment(&m_ThreadPool);
+	experiment.BuildReference(m_Tracer, params, NUM_REFERENCE_FRAMES, REFERENCE_RAYS_PER_PROBE);
+
+	//Seeded so every run of the benchmark traces the same rotations
+	std::vector<RayRotationTrial> trials = experiment.RunAll(m_Tracer, params, NUM_ROTATION_FRAMES, ROTATION_ERROR_THRESHOLD, 1);
+
+	const std::string ksSequenceNames[(int)RayRotationSequence::COUNT] = { "Random", "R3", "Sobol", "BlueNoise" };
+
+	nlohmann::json& data = m_Results["RayRotation"];
+	data["Threshold"] = ROTATION_ERROR_THRESHOLD;
+	data["ReferenceFrames"] = NUM_REFERENCE_FRAMES;
+	data["ReferenceRaysPerProbe"] = REFERENCE_RAYS_PER_PROBE;
+
+	for (int i = 0; i < (int)trials.size(); ++i)
+	{
+		const RayRotationTrial& kTrial = trials[i];
+
+		nlohmann::json& trialData = data[ksSequenceNames[(int)kTrial.Sequence] + (kTrial.PerProbeRotation == true ? "PerProbe" : "")];
+		trialData["FramesToConverge"] = kTrial.FramesToConverge;
+		trialData["SettledError"] = kTrial.SettledError;
+		trialData["Errors"] = kTrial.Errors;
+		trialData["Seconds"] = kTrial.Seconds;
+	}
+}
+
+void BenchmarkRunner::RunIrradianceQuery()
+{
+	PROFILE("Irradiance Query Benchmark");
+
+	//The CPU blender only writes octahedral irradiance
+	RaytracePerFrameCB params = m_Params;
+	params.IrradianceEncoding = PROBE_IRRADIANCE_ENCODING_OCTAHEDRAL;
+
+	BlendAtlases(params, NUM_BLEND_FRAMES);
+
+	std::vector<IrradianceQuery> queries;
+	AtlasLayoutBenchmark::CreateQueries(params, NUM_QUERY_WAVES, QUERY_WAVE_SIZE, QUERY_WAVE_RADIUS, 0, queries);
+
+	XMFLOAT3 eyePosW = ObjectManager::GetInstance()->GetActiveCamera()->GetPosition();
+
+	CPUIrradianceQuery query(&m_ThreadPool);
+
+	std::vector<XMFLOAT4> results;
+
+	nlohmann::json& data = m_Results["IrradianceQuery"];
+	data["NumQueries"] = queries.size();
+
+	const std::string ksRunNames[2] = { "Batched", "BatchedSingleThreaded" };
+
+	for (int i = 0; i < 2; ++i)
+	{
+		query.SetThreadPool(i == 0 ? &m_ThreadPool : nullptr);
+		query.QueryIrradiance(params, m_IrradianceAtlas, m_DistanceAtlas, nullptr, eyePosW, queries, results);
+
+		const CPUQueryStats& kStats = query.GetLastQueryStats();
+
+		data[ksRunNames[i]]["NumThreads"] = kStats.NumThreads;
+		data[ksRunNames[i]]["Seconds"] = kStats.Seconds;
+		data[ksRunNames[i]]["QueriesPerSecond"] = kStats.GetQueriesPerSecond();
+	}
+
+	//The reference is what the batches have to match, the difference is relative to the brightest result
+	double dMaxDifference = 0.0;
+	double dMaxIrradiance = 0.0;
+
+	Timer timer;
+	timer.Reset();
+
+	for (int i = 0; i < (int)queries.size(); ++i)
+	{
+		const IrradianceQuery& kQuery = queries[i];
+
+		XMFLOAT3 cameraDirection = ProbeHelper::Normalize(XMFLOAT3(kQuery.PosW.x - eyePosW.x, kQuery.PosW.y - eyePosW.y, kQuery.PosW.z - eyePosW.z));
+		XMFLOAT3 surfaceBias = CPUIrradianceQuery::GetSurfaceBias(kQuery.NormalW, cameraDirection, params.NormalBias, params.ViewBias);
+
+		XMFLOAT4 reference = CPUIrradianceQuery::GetIrradiance(kQuery.PosW, surfaceBias, kQuery.NormalW, params, m_IrradianceAtlas, m_DistanceAtlas, nullptr);
+
+		dMaxDifference = (std::max)(dMaxDifference, (double)(std::max)(fabsf(reference.x - results[i].x), (std::max)(fabsf(reference.y - results[i].y), fabsf(reference.z - results[i].z))));
+		dMaxIrradiance = (std::max)(dMaxIrradiance, (double)(std::max)(reference.x, (std::max)(reference.y, reference.z)));
+	}
+
+	timer.Tick();
+
+	data["Reference"]["Seconds"] = timer.DeltaTime();
+	data["Reference"]["QueriesPerSecond"] = timer.DeltaTime() > 0.0f ? queries.size() / (double)timer.DeltaTime() : 0.0;
+	data["MaxRelativeDifference"] = dMaxIrradiance > 0.0 ? dMaxDifference / dMaxIrradiance : 0.0;
+}
+
+void BenchmarkRunner::RunHDRPacking()
+{
+	PROFILE("HDR Packing Benchmark");
+
+	RaytracePerFrameCB params = m_Params;
+	params.RayDataFormat = FORMAT_PROBE_RAY_DATA_R32G32B32A32_FLOAT;
+
+	m_Tracer.TraceProbeRays(params, m_RayData);
+
+	//Front face hits only, misses all hold the miss radiance and back faces hold none
+	std::vector<XMFLOAT3> radiance;
+	radiance.reserve(m_RayData.Texels.size());
+
+	for (size_t i = 0; i < m_RayData.Texels.size(); ++i)
+	{
+		const XMFLOAT4& kTexel = m_RayData.Texels[i];
+
+		if (kTexel.w > 0.0f && kTexel.w < 1e27f)
+		{
+			radiance.push_back(XMFLOAT3(kTexel.x, kTexel.y, kTexel.z));
+		}
+	}
+
+	nlohmann::json& data = m_Results["HDRPacking"];
+
+	const int kiFormats[2] = { FORMAT_PROBE_RAY_DATA_RGB9E5, FORMAT_PROBE_RAY_DATA_R11G11B10 };
+	const std::string ksFormatNames[2] = { "RGB9E5", "R11G11B10" };
+
+	for (int i = 0; i < 2; ++i)
+	{
+		HDRPackingStats stats = HDRPackingHelper::MeasureRoundTrip(kiFormats[i], radiance);
+
+		nlohmann::json& formatData = data[ksFormatNames[i]];
+		formatData["NumValues"] = stats.NumValues;
+		formatData["MaxRelativeError"] = stats.MaxRelativeError;
+		formatData["MeanRelativeError"] = stats.MeanRelativeError;
+		formatData["EncodesPerSecond"] = stats.GetEncodesPerSecond();
+		formatData["DecodesPerSecond"] = stats.GetDecodesPerSecond();
+	}
+}
+
+void BenchmarkRunner::RunAtlasLayout()
+{
+	PROFILE("Atlas Layout Benchmark");
+
+	std::vector<IrradianceQuery> queries;
+	AtlasLayoutBenchmark::CreateQueries(m_Params, NUM_QUERY_WAVES, QUERY_WAVE_SIZE, QUERY_WAVE_RADIUS, 0, queries);
+
+	AtlasCacheModel model;
+
+	AtlasLayoutBenchmark benchmark;
+	std::vector<AtlasLayoutStats> layoutStats = benchmark.RunAll(m_Params, model, queries, QUERY_WAVE_SIZE);
+
+	const std::string ksLayoutNames[2] = { "Planes", "Bricks" };
+
+	nlohmann::json& data = m_Results["AtlasLayout"];
+	data["LineBytes"] = model.LineBytes;
+	data["BlockWidth"] = model.BlockWidth;
+	data["BlockHeight"] = model.BlockHeight;
+
+	for (int i = 0; i < (int)layoutStats.size(); ++i)
+	{
+		const AtlasLayoutStats& kStats = layoutStats[i];
+
+		nlohmann::json& layoutData = data[ksLayoutNames[kStats.AtlasLayout]];
+		layoutData["NumQueries"] = kStats.NumQueries;
+		layoutData["LinesPerQuery"] = kStats.LinesPerQuery;
+		layoutData["BlocksPerQuery"] = kStats.BlocksPerQuery;
+		layoutData["LinesPerWave"] = kStats.LinesPerWave;
+		layoutData["BlocksPerWave"] = kStats.BlocksPerWave;
+	}
+}
+
+void BenchmarkRunner::RunProbeFilter()
+{
+	PROFILE("Probe Filter Benchmark");
+
+	RaytracePerFrameCB params = m_Params;
+	params.IrradianceEncoding = PROBE_IRRADIANCE_ENCODING_OCTAHEDRAL;
+
+	//The filter weighs neighbours by visibility so it gets the converged distances
+	BlendAtlases(params, NUM_BLEND_FRAMES);
+
+	CPUAtlas distanceAtlas = m_DistanceAtlas;
+
+	//Without hysteresis every frame is its own estimate so the variance across them is the ray noise
+	params.Hysteresis = 0.0f;
+	params.IrradianceThreshold = 1e27f;
+	params.BrightnessThreshold = 1e27f;
+
+	RayRotationGenerator generator;
+	generator.SetSeed(1);
+
+	std::vector<CPUAtlas> frames(NUM_FILTER_FRAMES);
+
+	for (int i = 0; i < NUM_FILTER_FRAMES; ++i)
+	{
+		params.RayRotation = generator.Next();
+
+		m_Tracer.TraceProbeRays(params, m_RayData);
+		m_Blender.BlendIrradiance(params, m_RayData, m_IrradianceAtlas);
+		m_Blender.BlendBorders(params.NumIrradianceTexels, params.ProbeCounts, m_IrradianceAtlas);
+
+		frames[i] = m_IrradianceAtlas;
+	}
+
+	ProbeFilterBenchmark benchmark(&m_ThreadPool);
+	std::vector<ProbeFilterStats> filterStats = benchmark.RunAll(params, frames, distanceAtlas, nullptr, m_Params.ProbeFilterStrength);
+
+	const std::string ksFilterNames[3] = { "None", "6Neighbours", "26Neighbours" };
+
+	nlohmann::json& data = m_Results["ProbeFilter"];
+	data["Strength"] = m_Params.ProbeFilterStrength;
+	data["NumFrames"] = NUM_FILTER_FRAMES;
+
+	for (int i = 0; i < (int)filterStats.size(); ++i)
+	{
+		const ProbeFilterStats& kStats = filterStats[i];
+
+		nlohmann::json& filterData = data[ksFilterNames[kStats.ProbeFilter]];
+		filterData["UnfilteredVariance"] = kStats.UnfilteredVariance;
+		filterData["FilteredVariance"] = kStats.FilteredVariance;
+		filterData["VarianceReduction"] = kStats.VarianceReduction;
+		filterData["RelativeBias"] = kStats.RelativeBias;
+		filterData["SecondsPerFrame"] = kStats.Seconds / (std::max)(kStats.NumFrames, 1);
+	}
+}
+
+void BenchmarkRunner::RunMeshLoad()
+{
+	PROFILE("Mesh Load Benchmark");
+
+	std::vector<std::string> filepaths;
+	std::vector<std::string> sampleFilepaths = MeshLoadBenchmark::GetSampleFilepaths();
+
+	for (int i = 0; i < (int)sampleFilepaths.size(); ++i)
+	{
+		if (GetFileAttributesA(sampleFilepaths[i].c_str()) == INVALID_FILE_ATTRIBUTES)
+		{
+			LOG_WARNING(tag, L"Skipping %s in the mesh load benchmark as it doesn't exist!", std::wstring(sampleFilepaths[i].begin(), sampleFilepaths[i].end()).c_str());
+
+			continue;
+		}
+
+		//RunAll only times the cache of files that have one
+		if (GetFileAttributesA(MeshCache::GetCacheFilepath(sampleFilepaths[i]).c_str()) == INVALID_FILE_ATTRIBUTES)
+		{
+			MeshManager::GetInstance()->CookMesh(sampleFilepaths[i]);
+		}
+
+		filepaths.push_back(sampleFilepaths[i]);
+	}
+
+	MeshLoadBenchmark benchmark;
+	std::vector<MeshLoadStats> loadStats = benchmark.RunAll(filepaths, NUM_MESH_LOADS);
+
+	nlohmann::json& data = m_Results["MeshLoad"];
+	data = nlohmann::json::array();
+
+	for (int i = 0; i < (int)loadStats.size(); ++i)
+	{
+		const MeshLoadStats& kStats = loadStats[i];
+
+		nlohmann::json loadData;
+		loadData["Filepath"] = kStats.Filepath;
+		loadData["Binary"] = kStats.Binary;
+		loadData["Cached"] = kStats.Cached;
+		loadData["NumLoads"] = kStats.NumLoads;
+		loadData["NumVertices"] = kStats.NumVertices;
+		loadData["NumIndices"] = kStats.NumIndices;
+		loadData["ParseSeconds"] = kStats.ParseSeconds;
+		loadData["BuildSeconds"] = kStats.BuildSeconds;
+		loadData["TotalSeconds"] = kStats.TotalSeconds;
+		loadData["FirstLoadSeconds"] = kStats.FirstLoadSeconds;
+
+		data.push_back(loadData);
+	}
+}
+
+void BenchmarkRunner::RunSceneLoad()
+{
+	PROFILE("Scene Load Benchmark");
+
+	std::vector<std::string> filepaths = MeshLoadBenchmark::GetSceneFilepaths();
+
+	unsigned int uiMaxThreads = (std::max)(std::thread::hardware_concurrency(), 1u);
+
+	MeshLoadBenchmark benchmark;
+	std::vector<SceneLoadStats> sceneStats = benchmark.RunSceneScaling(filepaths, uiMaxThreads, NUM_SCENE_LOADS);
+
+	nlohmann::json& data = m_Results["SceneLoad"];
+	data = nlohmann::json::array();
+
+	for (int i = 0; i < (int)sceneStats.size(); ++i)
+	{
+		const SceneLoadStats& kStats = sceneStats[i];
+
+		nlohmann::json sceneData;
+		sceneData["NumThreads"] = kStats.NumThreads;
+		sceneData["NumMeshes"] = kStats.NumMeshes;
+		sceneData["NumFailed"] = kStats.NumFailed;
+		sceneData["NumLoads"] = kStats.NumLoads;
+		sceneData["Seconds"] = kStats.Seconds;
+		sceneData["FirstLoadSeconds"] = kStats.FirstLoadSeconds;
+
+		if (i > 0 && sceneStats[0].Seconds > 0.0 && kStats.Seconds > 0.0)
+		{
+			sceneData["Speedup"] = sceneStats[0].Seconds / kStats.Seconds;
+		}
+
+		data.push_back(sceneData);
+	}
+}
+
+void BenchmarkRunner::BlendAtlases(const RaytracePerFrameCB& kParams, int iNumFrames)
+{
+	PROFILE("Benchmark Blend Atlases");
+
+	RaytracePerFrameCB params = kParams;
+
+	CPUProbeBlender::CreateAtlases(params, m_RayData, m_IrradianceAtlas, m_DistanceAtlas);
+
+	RayRotationGenerator generator;
+	generator.SetSeed(0);
+
+	for (int i = 0; i < iNumFrames; ++i)
+	{
+		params.RayRotation = generator.Next();
+
+		m_Tracer.TraceProbeRays(params, m_RayData);
+		m_Blender.BlendProbeAtlases(params, m_RayData, m_IrradianceAtlas, m_DistanceAtlas);
+	}
+}
+
+XMFLOAT3 BenchmarkRunner::ShadeHit(const CPUSurfaceHit& kHit)
+{
+	const CPUBVH* kpBVH = m_Tracer.GetBVH();
+
+	XMVECTOR posW = XMLoadFloat3(&kHit.PosW);
+	XMVECTOR normalW = XMLoadFloat3(&kHit.NormalW);
+
+	XMFLOAT3 origin;
+	XMStoreFloat3(&origin, posW + normalW * m_Params.NormalBias);
+
+	XMVECTOR directLight = XMVectorZero();
+
+	for (int i = 0; i < (int)m_Lights.size(); ++i)
+	{
+		const LightCB& kLight = m_Lights[i];
+
+		if (kLight.Enabled == 0)
+		{
+			continue;
+		}
+
+		XMVECTOR lightW;
+		float fMaxDistance;
+		float fAttenuation = 1.0f;
+
+		if (kLight.Type == LightType::DIRECTIONAL)
+		{
+			lightW = -XMVector3Normalize(XMLoadFloat3(&kLight.Direction));
+			fMaxDistance = m_Params.MaxRayDistance - m_Params.ViewBias;
+		}
+		else
+		{
+			lightW = XMLoadFloat3(&kLight.Position) - posW;
+
+			float fDistance = XMVectorGetX(XMVector3Length(lightW));
+
+			if (fDistance > kLight.Range)
+			{
+				continue;
+			}
+
+			lightW /= fDistance;
+			fMaxDistance = fDistance - m_Params.ViewBias;
+
+			//Same as CalculatePointLight, the first term scales the whole falloff
+			fAttenuation = (std::min)(1.0f / (kLight.Attenuation.x * (1.0f + kLight.Attenuation.y * fDistance + kLight.Attenuation.z * fDistance * fDistance)), 1.0f);
+		}
+
+		float fNormDotLight = XMVectorGetX(XMVector3Dot(normalW, lightW));
+
+		if (fNormDotLight <= 0.0f)
+		{
+			continue;
+		}
+
+		XMFLOAT3 direction;
+		XMStoreFloat3(&direction, lightW);
+
+		if (kpBVH->Trace(origin, direction, 0.0f, fMaxDistance).Distance >= 0.0f)
+		{
+			continue;
+		}
+
+		directLight += XMLoadFloat3(&kLight.Color) * (fNormDotLight * fAttenuation * kLight.Power);
+	}
+
+	XMFLOAT3 radiance;
+	XMStoreFloat3(&radiance, directLight * XMLoadFloat3(&kHit.Albedo) / XM_PI);
+
+	return radiance;
+}
+
+void BenchmarkRunner::AddTraceStats(const CPUTraceStats& kStats, nlohmann::json& data)
+{
+	data["NumRays"] = kStats.NumRays;
+	data["NumHits"] = kStats.NumHits;
+	data["NumBackfaceHits"] = kStats.NumBackfaceHits;
+	data["NumThreads"] = kStats.NumThreads;
+	data["Seconds"] = kStats.Seconds;
+	data["RaysPerSecond"] = kStats.GetRaysPerSecond();
+	data["RaysPerSecondPerCore"] = kStats.GetRaysPerSecondPerCore();
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Commons/ThreadPool.h"
+#include "GI/CPUAtlas.h"
+#include "GI/CPUProbeBlender.h"
+#include "GI/CPURayTracer.h"
+#include "Include/json/json.hpp"
+#include "Shaders/ConstantBuffers.h"
+
+#include <string>
+#include <vector>
+
+//Runs the CPU side benchmarks against the scene the app has loaded and writes what they measured to a JSON file, so
+//they can be compared across scenes and machines without a GPU capture. Started with -bench on the command line,
+//e.g. FYP.exe Scenes/Sponza.json 1 -bench, and the app quits once they have finished.
+class BenchmarkRunner
+{
+public:
+	BenchmarkRunner();
+
+	//kParams are the first GI volume's per frame constants, kLights the scene's lights that shade the CPU hits
+	bool Init(const RaytracePerFrameCB& kParams, const std::vector<LightCB>& kLights);
+
+	void Run();
+
+	bool WriteResults(const std::string& ksFilepath) const;
+
+protected:
+
+private:
+	//Rays per second through the CPU BVH on the volume's probes, with the pool and on one thread
+	void RunRayTracer();
+
+	//Frames each ray rotation sequence takes to converge on the scene, with and without the per probe rotation
+	void RunRayRotation();
+
+	//Batched queries on the pool and on one thread against the shader's single query written out on the CPU
+	void RunIrradianceQuery();
+
+	//Error and speed of the shared exponent codecs on a frame of the scene's traced radiance
+	void RunHDRPacking();
+
+	//Cache lines and blocks each atlas layout touches for waves of shading points
+	void RunAtlasLayout();
+
+	//Noise the probe filter takes out of single frame blends and the bias it adds, for both neighbourhoods
+	void RunProbeFilter();
+
+	//The sample models through the .gltf, .glb and cooked load paths
+	void RunMeshLoad();
+
+	//Every sample model loaded as one scene on the calling thread then on up to one worker per hardware thread
+	void RunSceneLoad();
+
+	//Traces and blends the atlases from empty with the scene's hysteresis, the same as a new GIVolume
+	void BlendAtlases(const RaytracePerFrameCB& kParams, int iNumFrames);
+
+	//Diffuse part of CalculateDirectLight in Shaders/LightingHelper.hlsli with shadow rays through the BVH. There
+	//is no previous frame irradiance so hits only get one bounce.
+	DirectX::XMFLOAT3 ShadeHit(const CPUSurfaceHit& kHit);
+
+	static void AddTraceStats(const CPUTraceStats& kStats, nlohmann::json& data);
+
+	ThreadPool m_ThreadPool;
+
+	CPURayTracer m_Tracer;
+	CPUProbeBlender m_Blender;
+
+	CPUAtlas m_RayData;
+	CPUAtlas m_IrradianceAtlas;
+	CPUAtlas m_DistanceAtlas;
+
+	//Every probe traced every frame, classification, relocation and adaptive rays need GPU written atlases
+	RaytracePerFrameCB m_Params;
+
+	std::vector<LightCB> m_Lights;
+
+	nlohmann::json m_Results;
+};
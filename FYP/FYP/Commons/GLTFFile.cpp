@@ -0,0 +1,413 @@
+#include "GLTFFile.h"
+#include "Include/tinygltf/tiny_gltf.h"
+#include "Helpers/DebugHelper.h"
+#include "Helpers/AccessorHelper.h"
+
+#include <algorithm>
+#include <climits>
+
+Tag tag = L"GLTFFile";
+
+#define GLB_HEADER_SIZE 12
+#define GLB_CHUNK_HEADER_SIZE 8
+#define GLB_CHUNK_TYPE_BIN 0x004E4942
+
+GLTFFile::GLTFFile()
+{
+	m_pModel = new tinygltf::Model();
+
+	m_pBinChunk = nullptr;
+	m_uiBinChunkSize = 0;
+}
+
+GLTFFile::~GLTFFile()
+{
+	Close();
+
+	delete m_pModel;
+}
+
+bool GLTFFile::Load(const std::string& ksFilepath)
+{
+	Close();
+
+	std::string err;
+	std::string warn;
+
+	bool bSuccess;
+
+	if (IsBinaryFilepath(ksFilepath) == true)
+	{
+		bSuccess = LoadBinary(ksFilepath, err, warn);
+	}
+	else
+	{
+		tinygltf::TinyGLTF loader;
+
+		bSuccess = loader.LoadASCIIFromFile(m_pModel, &err, &warn, ksFilepath);
+	}
+
+	if (warn.empty() == false)
+	{
+		LOG_WARNING(tag, L"%s", std::wstring(warn.begin(), warn.end()).c_str());
+	}
+
+	if (err.empty() == false)
+	{
+		LOG_ERROR(tag, L"%s", std::wstring(err.begin(), err.end()).c_str());
+	}
+
+	if (bSuccess == false)
+	{
+		Close();
+
+		return false;
+	}
+
+	return true;
+}
+
+void GLTFFile::Close()
+{
+	*m_pModel = tinygltf::Model();
+
+	m_File.Close();
+
+	m_pBinChunk = nullptr;
+	m_uiBinChunkSize = 0;
+}
+
+bool GLTFFile::IsBinary() const
+{
+	return m_File.IsOpen();
+}
+
+const tinygltf::Model& GLTFFile::GetModel() const
+{
+	return *m_pModel;
+}
+
+const BYTE* GLTFFile::GetBufferViewData(const tinygltf::BufferView& kBufferView) const
+{
+	if (kBufferView.buffer < 0 || kBufferView.buffer >= (int)m_pModel->buffers.size())
+	{
+		return nullptr;
+	}
+
+	const tinygltf::Buffer& kBuffer = m_pModel->buffers[kBufferView.buffer];
+
+	//The buffer without a uri in a .glb is the BIN chunk
+	if (m_pBinChunk != nullptr && kBuffer.uri.empty() == true)
+	{
+		if (kBufferView.byteOffset + kBufferView.byteLength > m_uiBinChunkSize)
+		{
+			return nullptr;
+		}
+
+		return m_pBinChunk + kBufferView.byteOffset;
+	}
+
+	if (kBufferView.byteOffset + kBufferView.byteLength > kBuffer.data.size())
+	{
+		return nullptr;
+	}
+
+	return kBuffer.data.data() + kBufferView.byteOffset;
+}
+
+bool GLTFFile::GetAccessorView(const tinygltf::Accessor& kAccessor, AccessorView& view) const
+{
+	view = AccessorView();
+	view.Count = (UINT)kAccessor.count;
+	view.ComponentType = kAccessor.componentType;
+	view.NumComponents = tinygltf::GetNumComponentsInType(kAccessor.type);
+	view.Normalized = kAccessor.normalized;
+
+	int iComponentSize = tinygltf::GetComponentSizeInBytes(kAccessor.componentType);
+
+	if (view.NumComponents <= 0 || view.NumComponents > 4 || iComponentSize <= 0)
+	{
+		LOG_ERROR(tag, L"Accessor %s isn't a scalar or vector with a glTF component type!", std::wstring(kAccessor.name.begin(), kAccessor.name.end()).c_str());
+
+		return false;
+	}
+
+	UINT uiElementSize = view.NumComponents * iComponentSize;
+
+	//Accessors without a buffer view are all zeros, apart from any sparse values
+	if (kAccessor.bufferView < 0)
+	{
+		view.ByteStride = uiElementSize;
+
+		return true;
+	}
+
+	if (kAccessor.bufferView >= (int)m_pModel->bufferViews.size())
+	{
+		LOG_ERROR(tag, L"Accessor %s uses a buffer view that doesn't exist!", std::wstring(kAccessor.name.begin(), kAccessor.name.end()).c_str());
+
+		return false;
+	}
+
+	int iByteStride = kAccessor.ByteStride(m_pModel->bufferViews[kAccessor.bufferView]);
+
+	if (iByteStride <= 0)
+	{
+		LOG_ERROR(tag, L"Accessor %s has a byte stride that isn't a multiple of its component size!", std::wstring(kAccessor.name.begin(), kAccessor.name.end()).c_str());
+
+		return false;
+	}
+
+	view.ByteStride = (UINT)iByteStride;
+
+	UINT64 uiSize = view.Count > 0 ? (UINT64)(view.Count - 1) * view.ByteStride + uiElementSize : 0;
+
+	view.Data = GetBufferViewRange(kAccessor.bufferView, kAccessor.byteOffset, uiSize);
+
+	if (view.Data == nullptr)
+	{
+		LOG_ERROR(tag, L"Accessor %s runs past the end of its buffer view!", std::wstring(kAccessor.name.begin(), kAccessor.name.end()).c_str());
+
+		return false;
+	}
+
+	return true;
+}
+
+bool GLTFFile::DecodeAccessor(const tinygltf::Accessor& kAccessor, float* pOutput, UINT uiOutputStride, int iNumOutputComponents) const
+{
+	AccessorView view;
+
+	if (GetAccessorView(kAccessor, view) == false)
+	{
+		return false;
+	}
+
+	AccessorHelper::DecodeFloats(view, pOutput, uiOutputStride, iNumOutputComponents);
+
+	if (kAccessor.sparse.isSparse == false)
+	{
+		return true;
+	}
+
+	std::vector<UINT> indices;
+	AccessorView values;
+
+	if (GetSparseView(kAccessor, indices, values) == false)
+	{
+		return false;
+	}
+
+	AccessorHelper::ScatterFloats(values, indices.data(), pOutput, uiOutputStride, iNumOutputComponents);
+
+	return true;
+}
+
+bool GLTFFile::DecodeIndices(const tinygltf::Accessor& kAccessor, UINT* pOutput) const
+{
+	AccessorView view;
+
+	if (GetAccessorView(kAccessor, view) == false)
+	{
+		return false;
+	}
+
+	//Index buffer views can't have a stride so the elements are always tightly packed
+	if (view.NumComponents != 1 || view.ByteStride != (UINT)tinygltf::GetComponentSizeInBytes(view.ComponentType))
+	{
+		LOG_ERROR(tag, L"Index accessor %s isn't tightly packed scalars!", std::wstring(kAccessor.name.begin(), kAccessor.name.end()).c_str());
+
+		return false;
+	}
+
+	if (view.Data == nullptr)
+	{
+		memset(pOutput, 0, sizeof(UINT) * view.Count);
+	}
+	else if (AccessorHelper::WidenIndices(view.Data, view.Count, view.ComponentType, pOutput) == false)
+	{
+		LOG_ERROR(tag, L"The tinygltf index data type %i isn't supported!", view.ComponentType);
+
+		return false;
+	}
+
+	if (kAccessor.sparse.isSparse == false)
+	{
+		return true;
+	}
+
+	std::vector<UINT> indices;
+	AccessorView values;
+
+	if (GetSparseView(kAccessor, indices, values) == false)
+	{
+		return false;
+	}
+
+	std::vector<UINT> sparseValues(values.Count);
+
+	if (AccessorHelper::WidenIndices(values.Data, values.Count, values.ComponentType, sparseValues.data()) == false)
+	{
+		LOG_ERROR(tag, L"The tinygltf index data type %i isn't supported!", values.ComponentType);
+
+		return false;
+	}
+
+	for (UINT i = 0; i < values.Count; ++i)
+	{
+		pOutput[indices[i]] = sparseValues[i];
+	}
+
+	return true;
+}
+
+bool GLTFFile::IsBinaryFilepath(const std::string& ksFilepath)
+{
+	size_t uiDot = ksFilepath.find_last_of('.');
+
+	if (uiDot == std::string::npos)
+	{
+		return false;
+	}
+
+	std::string sExtension = ksFilepath.substr(uiDot + 1);
+	std::transform(sExtension.begin(), sExtension.end(), sExtension.begin(), ::tolower);
+
+	return sExtension == "glb";
+}
+
+std::string GLTFFile::GetBaseDir(const std::string& ksFilepath)
+{
+	size_t uiSlash = ksFilepath.find_last_of("/\\");
+
+	if (uiSlash == std::string::npos)
+	{
+		return "";
+	}
+
+	return ksFilepath.substr(0, uiSlash);
+}
+
+const BYTE* GLTFFile::GetBufferViewRange(int iBufferView, UINT64 uiOffset, UINT64 uiSize) const
+{
+	if (iBufferView < 0 || iBufferView >= (int)m_pModel->bufferViews.size())
+	{
+		return nullptr;
+	}
+
+	const tinygltf::BufferView& kBufferView = m_pModel->bufferViews[iBufferView];
+
+	const BYTE* kpData = GetBufferViewData(kBufferView);
+
+	if (kpData == nullptr || uiOffset > kBufferView.byteLength || uiSize > kBufferView.byteLength - uiOffset)
+	{
+		return nullptr;
+	}
+
+	return kpData + uiOffset;
+}
+
+bool GLTFFile::GetSparseView(const tinygltf::Accessor& kAccessor, std::vector<UINT>& indices, AccessorView& values) const
+{
+	UINT uiCount = (UINT)kAccessor.sparse.count;
+
+	int iIndexSize = tinygltf::GetComponentSizeInBytes(kAccessor.sparse.indices.componentType);
+	const BYTE* kpIndices = iIndexSize > 0 ? GetBufferViewRange(kAccessor.sparse.indices.bufferView, kAccessor.sparse.indices.byteOffset, (UINT64)uiCount * iIndexSize) : nullptr;
+
+	indices.resize(uiCount);
+
+	if (kAccessor.sparse.count < 0 || kpIndices == nullptr || AccessorHelper::WidenIndices(kpIndices, uiCount, kAccessor.sparse.indices.componentType, indices.data()) == false)
+	{
+		LOG_ERROR(tag, L"Failed to read the sparse indices of accessor %s!", std::wstring(kAccessor.name.begin(), kAccessor.name.end()).c_str());
+
+		return false;
+	}
+
+	for (UINT i = 0; i < uiCount; ++i)
+	{
+		if (indices[i] >= kAccessor.count)
+		{
+			LOG_ERROR(tag, L"Accessor %s has a sparse index past its last element!", std::wstring(kAccessor.name.begin(), kAccessor.name.end()).c_str());
+
+			return false;
+		}
+	}
+
+	values = AccessorView();
+	values.Count = uiCount;
+	values.ComponentType = kAccessor.componentType;
+	values.NumComponents = tinygltf::GetNumComponentsInType(kAccessor.type);
+	values.Normalized = kAccessor.normalized;
+	values.ByteStride = values.NumComponents * tinygltf::GetComponentSizeInBytes(kAccessor.componentType);
+	values.Data = GetBufferViewRange(kAccessor.sparse.values.bufferView, kAccessor.sparse.values.byteOffset, (UINT64)uiCount * values.ByteStride);
+
+	if (values.Data == nullptr)
+	{
+		LOG_ERROR(tag, L"The sparse values of accessor %s run past the end of their buffer view!", std::wstring(kAccessor.name.begin(), kAccessor.name.end()).c_str());
+
+		return false;
+	}
+
+	return true;
+}
+
+bool GLTFFile::LoadBinary(const std::string& ksFilepath, std::string& err, std::string& warn)
+{
+	if (m_File.Open(ksFilepath) == false)
+	{
+		return false;
+	}
+
+	const BYTE* kpData = m_File.GetData();
+	UINT64 uiSize = m_File.GetSize();
+
+	if (uiSize > UINT_MAX)
+	{
+		LOG_ERROR(tag, L"%s is too large for tinygltf to load!", std::wstring(ksFilepath.begin(), ksFilepath.end()).c_str());
+
+		return false;
+	}
+
+	tinygltf::TinyGLTF loader;
+
+	if (loader.LoadBinaryFromMemory(m_pModel, &err, &warn, kpData, (unsigned int)uiSize, GetBaseDir(ksFilepath)) == false)
+	{
+		return false;
+	}
+
+	//The JSON chunk straight after the header is followed by the optional BIN chunk, tinygltf has already checked the
+	//header and JSON chunk
+	UINT uiJSONLength;
+	memcpy(&uiJSONLength, kpData + GLB_HEADER_SIZE, sizeof(UINT));
+
+	UINT64 uiBinHeader = (UINT64)GLB_HEADER_SIZE + GLB_CHUNK_HEADER_SIZE + uiJSONLength;
+
+	if (uiBinHeader + GLB_CHUNK_HEADER_SIZE > uiSize)
+	{
+		return true;
+	}
+
+	UINT uiBinLength;
+	UINT uiBinType;
+	memcpy(&uiBinLength, kpData + uiBinHeader, sizeof(UINT));
+	memcpy(&uiBinType, kpData + uiBinHeader + sizeof(UINT), sizeof(UINT));
+
+	if (uiBinType != GLB_CHUNK_TYPE_BIN)
+	{
+		return true;
+	}
+
+	m_pBinChunk = kpData + uiBinHeader + GLB_CHUNK_HEADER_SIZE;
+	m_uiBinChunkSize = (std::min)((UINT64)uiBinLength, uiSize - uiBinHeader - GLB_CHUNK_HEADER_SIZE);
+
+	//Images in buffer views were decoded while parsing so tinygltf's copy of the BIN chunk isn't needed any more
+	for (int i = 0; i < (int)m_pModel->buffers.size(); ++i)
+	{
+		if (m_pModel->buffers[i].uri.empty() == true)
+		{
+			std::vector<unsigned char>().swap(m_pModel->buffers[i].data);
+		}
+	}
+
+	return true;
+}
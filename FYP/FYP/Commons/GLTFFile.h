@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Commons/MappedFile.h"
+
+#include <string>
+#include <vector>
+
+struct AccessorView;
+
+namespace tinygltf
+{
+	class Model;
+
+	struct Accessor;
+	struct BufferView;
+}
+
+//A glTF parsed by tinygltf. .glb files are mapped and go through the binary loader, anything else through the ASCII
+//one. tinygltf copies the BIN chunk into its own buffer while parsing, that copy is dropped as soon as parsing is done
+//and buffer views in the BIN chunk are read from the mapped file instead. The mapping is kept until Close is called or
+//the object is destroyed.
+class GLTFFile
+{
+public:
+	GLTFFile();
+	~GLTFFile();
+
+	GLTFFile(const GLTFFile& rhs) = delete;
+	GLTFFile& operator=(const GLTFFile& rhs) = delete;
+
+	bool Load(const std::string& ksFilepath);
+	void Close();
+
+	bool IsBinary() const;
+
+	const tinygltf::Model& GetModel() const;
+
+	//Start of the buffer view's bytes, nullptr if the view runs past the end of its buffer
+	const BYTE* GetBufferViewData(const tinygltf::BufferView& kBufferView) const;
+
+	//Where the accessor's elements are and how they're stored, false if they run past the end of their buffer view or
+	//aren't scalars or vectors. Sparse values aren't included.
+	bool GetAccessorView(const tinygltf::Accessor& kAccessor, AccessorView& view) const;
+
+	//The accessor's elements as floats with any sparse values applied, see AccessorHelper::DecodeFloats
+	bool DecodeAccessor(const tinygltf::Accessor& kAccessor, float* pOutput, UINT uiOutputStride, int iNumOutputComponents) const;
+
+	//An index accessor widened to UINT with any sparse values applied
+	bool DecodeIndices(const tinygltf::Accessor& kAccessor, UINT* pOutput) const;
+
+	static bool IsBinaryFilepath(const std::string& ksFilepath);
+
+	//The directory files the glTF references are relative to
+	static std::string GetBaseDir(const std::string& ksFilepath);
+
+protected:
+
+private:
+	bool LoadBinary(const std::string& ksFilepath, std::string& err, std::string& warn);
+
+	//uiSize bytes from uiOffset into the buffer view, nullptr if the view doesn't exist or they aren't all inside it
+	const BYTE* GetBufferViewRange(int iBufferView, UINT64 uiOffset, UINT64 uiSize) const;
+
+	//The sparse indices of a sparse accessor and a view of its values, which are tightly packed
+	bool GetSparseView(const tinygltf::Accessor& kAccessor, std::vector<UINT>& indices, AccessorView& values) const;
+
+	tinygltf::Model* m_pModel;
+
+	MappedFile m_File;
+
+	const BYTE* m_pBinChunk;
+	UINT64 m_uiBinChunkSize;
+};
@@ -0,0 +1,107 @@
+#include "MappedFile.h"
+#include "Helpers/DebugHelper.h"
+
+Tag tag = L"MappedFile";
+
+MappedFile::MappedFile()
+{
+	m_File = INVALID_HANDLE_VALUE;
+	m_Mapping = nullptr;
+
+	m_pData = nullptr;
+	m_uiSize = 0;
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const std::string& ksFilepath)
+{
+	Close();
+
+	m_File = CreateFileA(ksFilepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+	if (m_File == INVALID_HANDLE_VALUE)
+	{
+		LOG_ERROR(tag, L"Failed to open %s to map it!", std::wstring(ksFilepath.begin(), ksFilepath.end()).c_str());
+
+		return false;
+	}
+
+	LARGE_INTEGER size;
+
+	if (GetFileSizeEx(m_File, &size) == FALSE || size.QuadPart == 0)
+	{
+		LOG_ERROR(tag, L"Tried to map %s but it is empty!", std::wstring(ksFilepath.begin(), ksFilepath.end()).c_str());
+
+		Close();
+
+		return false;
+	}
+
+	m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (m_Mapping == nullptr)
+	{
+		LOG_ERROR(tag, L"Failed to create a file mapping for %s!", std::wstring(ksFilepath.begin(), ksFilepath.end()).c_str());
+
+		Close();
+
+		return false;
+	}
+
+	m_pData = (const BYTE*)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+
+	if (m_pData == nullptr)
+	{
+		LOG_ERROR(tag, L"Failed to map a view of %s!", std::wstring(ksFilepath.begin(), ksFilepath.end()).c_str());
+
+		Close();
+
+		return false;
+	}
+
+	m_uiSize = (UINT64)size.QuadPart;
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_pData != nullptr)
+	{
+		UnmapViewOfFile(m_pData);
+		m_pData = nullptr;
+	}
+
+	if (m_Mapping != nullptr)
+	{
+		CloseHandle(m_Mapping);
+		m_Mapping = nullptr;
+	}
+
+	if (m_File != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_File);
+		m_File = INVALID_HANDLE_VALUE;
+	}
+
+	m_uiSize = 0;
+}
+
+bool MappedFile::IsOpen() const
+{
+	return m_pData != nullptr;
+}
+
+const BYTE* MappedFile::GetData() const
+{
+	return m_pData;
+}
+
+UINT64 MappedFile::GetSize() const
+{
+	return m_uiSize;
+}
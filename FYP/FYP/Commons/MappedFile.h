@@ -0,0 +1,34 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <string>
+
+//Read only view of a whole file mapped into memory. The view stays valid until Close is called or the object is
+//destroyed.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile& rhs) = delete;
+	MappedFile& operator=(const MappedFile& rhs) = delete;
+
+	bool Open(const std::string& ksFilepath);
+	void Close();
+
+	bool IsOpen() const;
+
+	const BYTE* GetData() const;
+	UINT64 GetSize() const;
+
+protected:
+
+private:
+	HANDLE m_File;
+	HANDLE m_Mapping;
+
+	const BYTE* m_pData;
+	UINT64 m_uiSize;
+};
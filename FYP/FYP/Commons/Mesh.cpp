@@ -1,5 +1,6 @@
 #include "Mesh.h"
 #include "Shaders/Vertices.h"
+#include "Shaders/Defines.hlsli"
 #include "Helpers/DXRHelper.h"
 #include "Helpers/DebugHelper.h"
 #include "Apps/App.h"
@@ -12,21 +13,48 @@ Mesh::Mesh()
 
 	m_pVertexBuffer = nullptr;
 	m_pIndexBuffer = nullptr;
+	m_pDequantizeBuffer = nullptr;
 	m_Nodes = std::vector<MeshNode*>();
 
 	m_uiNumIndices = 0;
 	m_uiNumVertices = 0;
+	m_uiNumPrimitives = 0;
+
+	m_BoundsMin = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+	m_BoundsMax = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+
+	m_iVertexFormat = VERTEX_FORMAT_FULL;
 
 	m_sFilePath = "";
 	m_sName = "";
 }
 
+Mesh::~Mesh()
+{
+	for (int i = 0; i < m_Nodes.size(); ++i)
+	{
+		for (int j = 0; j < m_Nodes[i]->m_Primitives.size(); ++j)
+		{
+			delete m_Nodes[i]->m_Primitives[j];
+		}
+
+		delete m_Nodes[i];
+	}
+
+	delete m_pVertexBuffer;
+	delete m_pIndexBuffer;
+	delete m_pDequantizeBuffer;
+}
+
 bool Mesh::CreateBLAS(ID3D12GraphicsCommandList4*& pGraphicsCommandList, ID3D12Device5*& pDevice)
 {
 	std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> geometryDescs;
 
 	MeshNode* pNode;
 
+	DXGI_FORMAT positionFormat = m_iVertexFormat == VERTEX_FORMAT_QUANTIZED ? DXGI_FORMAT_R16G16B16A16_SNORM : DXGI_FORMAT_R32G32B32_FLOAT;
+	UINT uiPrimitive = 0;
+
 	for (int i = 0;i < m_Nodes.size(); ++i)
 	{
 		pNode = m_Nodes[i];
@@ -37,9 +65,11 @@ bool Mesh::CreateBLAS(ID3D12GraphicsCommandList4*& pGraphicsCommandList, ID3D12D
 		}
 
 		//Create a geometry desc for each primitive
-		for (int i = 0; i < pNode->m_Primitives.size(); ++i)
+		for (int i = 0; i < pNode->m_Primitives.size(); ++i, ++uiPrimitive)
 		{
-			pNode->m_Primitives[i]->CreateBLAS(pGraphicsCommandList, m_pVertexBuffer, m_pIndexBuffer, pDevice);
+			D3D12_GPU_VIRTUAL_ADDRESS transform = m_pDequantizeBuffer != nullptr ? m_pDequantizeBuffer->GetBufferGPUAddress(uiPrimitive) : 0;
+
+			pNode->m_Primitives[i]->CreateBLAS(pGraphicsCommandList, m_pVertexBuffer, positionFormat, transform, m_pIndexBuffer, pDevice);
 		}
 	}
 
@@ -51,7 +81,7 @@ std::vector<Texture*>* Mesh::GetTextures()
 	return &m_Textures;
 }
 
-UploadBuffer<Vertex>* Mesh::GetVertexUploadBuffer()
+UploadBuffer<BYTE>* Mesh::GetVertexUploadBuffer()
 {
 	return m_pVertexBuffer;
 }
@@ -61,6 +91,11 @@ UploadBuffer<UINT>* Mesh::GetIndexUploadBuffer()
 	return m_pIndexBuffer;
 }
 
+int Mesh::GetVertexFormat() const
+{
+	return m_iVertexFormat;
+}
+
 std::vector<MeshNode*>* Mesh::GetNodes()
 {
 	return &m_Nodes;
@@ -86,6 +121,16 @@ UINT Mesh::GetNumPrimitives() const
 	return m_uiNumPrimitives;
 }
 
+const DirectX::XMFLOAT3& Mesh::GetBoundsMin() const
+{
+	return m_BoundsMin;
+}
+
+const DirectX::XMFLOAT3& Mesh::GetBoundsMax() const
+{
+	return m_BoundsMax;
+}
+
 std::string Mesh::GetName() const
 {
 	return m_sName;
@@ -44,6 +44,9 @@ struct Primitive
 		m_pVertexDesc = nullptr;
 
 		m_Attributes = (PrimitiveAttributes)0;
+
+		m_PositionOffset = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+		m_PositionScale = DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f);
 	}
 
 	bool HasAttribute(PrimitiveAttributes primAttribute)
@@ -51,18 +54,20 @@ struct Primitive
 		return (UINT8)m_Attributes & (UINT8)primAttribute;
 	}
 
-	bool CreateBLAS(ID3D12GraphicsCommandList4*& pGraphicsCommandList, UploadBuffer<Vertex>*& pVertexBuffer, UploadBuffer<UINT>*& pIndexBuffer, ID3D12Device5*& pDevice)
+	//Positions are read as positionFormat from the start of each vertex, transform is 0 or the primitive's dequantization
+	//transform for quantized positions
+	bool CreateBLAS(ID3D12GraphicsCommandList4*& pGraphicsCommandList, UploadBuffer<BYTE>*& pVertexBuffer, DXGI_FORMAT positionFormat, D3D12_GPU_VIRTUAL_ADDRESS transform, UploadBuffer<UINT>*& pIndexBuffer, ID3D12Device5*& pDevice)
 	{
 		D3D12_RAYTRACING_GEOMETRY_DESC geomDesc = {};
 		geomDesc.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
 		geomDesc.Triangles.IndexBuffer = pIndexBuffer->GetBufferGPUAddress(m_uiFirstIndex);
 		geomDesc.Triangles.IndexCount = m_uiNumIndices;
-		geomDesc.Triangles.Transform3x4 = 0;
+		geomDesc.Triangles.Transform3x4 = transform;
 		geomDesc.Triangles.IndexFormat = DXGI_FORMAT_R32_UINT;
-		geomDesc.Triangles.VertexFormat = DXGI_FORMAT_R32G32B32_FLOAT;
+		geomDesc.Triangles.VertexFormat = positionFormat;
 		geomDesc.Triangles.VertexCount = m_uiNumVertices;
 		geomDesc.Triangles.VertexBuffer.StartAddress = pVertexBuffer->GetBufferGPUAddress(m_uiFirstVertex);
-		geomDesc.Triangles.VertexBuffer.StrideInBytes = sizeof(Vertex);
+		geomDesc.Triangles.VertexBuffer.StrideInBytes = pVertexBuffer->GetStride();
 		geomDesc.Flags = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE;
 
 		D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs = {};
@@ -117,6 +122,10 @@ struct Primitive
 
 	DirectX::XMFLOAT4 m_BaseColour;
 
+	//Maps VERTEX_FORMAT_QUANTIZED positions back to the mesh's space, see VertexPackingHelper::GetQuantization
+	DirectX::XMFLOAT3 m_PositionOffset;
+	DirectX::XMFLOAT3 m_PositionScale;
+
 	PrimitiveAttributes m_Attributes = (PrimitiveAttributes)0;
 
 	AccelerationBuffers m_BottomLevel;
@@ -154,14 +163,21 @@ class Mesh
 {
 public:
 	Mesh();
+	~Mesh();
+
+	Mesh(const Mesh& rhs) = delete;
+	Mesh& operator=(const Mesh& rhs) = delete;
 
 	bool CreateBLAS(ID3D12GraphicsCommandList4*& pGraphicsCommandList, ID3D12Device5*& pDevice);
 
 	std::vector<Texture*>* GetTextures();
 
-	UploadBuffer<Vertex>* GetVertexUploadBuffer();
+	//Vertices are in the layout of the mesh's vertex format, the buffer's stride is the size of one
+	UploadBuffer<BYTE>* GetVertexUploadBuffer();
 	UploadBuffer<UINT>* GetIndexUploadBuffer();
 
+	int GetVertexFormat() const;
+
 	std::vector<MeshNode*>* GetNodes();
 	const MeshNode* GetNode(int iIndex) const;
 
@@ -169,6 +185,10 @@ public:
 	UINT GetNumIndices() const;
 	UINT GetNumPrimitives() const;
 
+	//Bounds of every primitive with its node's transform applied, the space the game object's world matrix works in
+	const DirectX::XMFLOAT3& GetBoundsMin() const;
+	const DirectX::XMFLOAT3& GetBoundsMax() const;
+
 	std::string GetName() const;
 
 protected:
@@ -176,15 +196,23 @@ protected:
 private:
 	std::vector<Texture*> m_Textures;
 
-	UploadBuffer<Vertex>* m_pVertexBuffer;
+	UploadBuffer<BYTE>* m_pVertexBuffer;
 	UploadBuffer<UINT>* m_pIndexBuffer;
 
+	//A dequantization transform per primitive in node then primitive order, only used by VERTEX_FORMAT_QUANTIZED
+	UploadBuffer<DirectX::XMFLOAT3X4>* m_pDequantizeBuffer;
+
+	int m_iVertexFormat;	//VERTEX_FORMAT_ value
+
 	std::vector<MeshNode*> m_Nodes;
 
 	UINT m_uiNumVertices;
 	UINT m_uiNumIndices;
 	UINT m_uiNumPrimitives;
 
+	DirectX::XMFLOAT3 m_BoundsMin;
+	DirectX::XMFLOAT3 m_BoundsMax;
+
 	std::string m_sFilePath;
 	std::string m_sName;
 
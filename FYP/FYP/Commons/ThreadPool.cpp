@@ -0,0 +1,142 @@
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int uiNumThreads)
+{
+	if (uiNumThreads == 0)
+	{
+		unsigned int uiHardwareThreads = std::thread::hardware_concurrency();
+
+		uiNumThreads = uiHardwareThreads > 1 ? uiHardwareThreads - 1 : 1;
+	}
+
+	m_Workers.reserve(uiNumThreads);
+
+	for (unsigned int i = 0; i < uiNumThreads; ++i)
+	{
+		m_Workers.push_back(std::thread(&ThreadPool::WorkerLoop, this));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		m_bStopping = true;
+	}
+
+	m_Condition.notify_all();
+
+	for (int i = 0; i < m_Workers.size(); ++i)
+	{
+		m_Workers[i].join();
+	}
+}
+
+void ThreadPool::ParallelFor(int iCount, int iGrainSize, const std::function<void(int, int)>& func)
+{
+	if (iCount <= 0)
+	{
+		return;
+	}
+
+	iGrainSize = std::max(iGrainSize, 1);
+
+	int iNumChunks = (iCount + iGrainSize - 1) / iGrainSize;
+
+	if (iNumChunks == 1 || m_Workers.size() == 0)
+	{
+		func(0, iCount);
+
+		return;
+	}
+
+	//Shared so helpers that only get scheduled after the loop has finished can still safely find there is no work left
+	struct ForState
+	{
+		std::atomic<int> NextChunk;
+		std::atomic<int> CompletedChunks;
+		std::mutex Mutex;
+		std::condition_variable Condition;
+	};
+
+	std::shared_ptr<ForState> pState = std::make_shared<ForState>();
+	pState->NextChunk = 0;
+	pState->CompletedChunks = 0;
+
+	const std::function<void(int, int)>* pFunc = &func;
+
+	std::function<void()> runChunks = [pState, pFunc, iNumChunks, iGrainSize, iCount]()
+	{
+		int iChunk;
+
+		while ((iChunk = pState->NextChunk.fetch_add(1)) < iNumChunks)
+		{
+			int iStart = iChunk * iGrainSize;
+
+			(*pFunc)(iStart, std::min(iStart + iGrainSize, iCount));
+
+			if (pState->CompletedChunks.fetch_add(1) + 1 == iNumChunks)
+			{
+				std::lock_guard<std::mutex> lock(pState->Mutex);
+
+				pState->Condition.notify_all();
+			}
+		}
+	};
+
+	int iNumHelpers = std::min((int)m_Workers.size(), iNumChunks - 1);
+
+	for (int i = 0; i < iNumHelpers; ++i)
+	{
+		Enqueue(runChunks);
+	}
+
+	runChunks();
+
+	std::unique_lock<std::mutex> lock(pState->Mutex);
+	pState->Condition.wait(lock, [pState, iNumChunks]() { return pState->CompletedChunks == iNumChunks; });
+}
+
+unsigned int ThreadPool::GetNumThreads() const
+{
+	return (unsigned int)m_Workers.size();
+}
+
+void ThreadPool::Enqueue(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		m_Tasks.push(std::move(task));
+	}
+
+	m_Condition.notify_one();
+}
+
+void ThreadPool::WorkerLoop()
+{
+	std::function<void()> task;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+
+			m_Condition.wait(lock, [this]() { return m_bStopping == true || m_Tasks.empty() == false; });
+
+			if (m_bStopping == true && m_Tasks.empty() == true)
+			{
+				return;
+			}
+
+			task = std::move(m_Tasks.front());
+			m_Tasks.pop();
+		}
+
+		task();
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+
+class ThreadPool
+{
+public:
+	//Passing 0 uses one worker per hardware thread, minus the thread that owns the pool
+	ThreadPool(unsigned int uiNumThreads = 0);
+	~ThreadPool();
+
+	//std::result_of is gone in C++20, decltype works the same on every language version
+	template<class Func>
+	auto Submit(Func func) -> std::future<decltype(func())>
+	{
+		typedef decltype(func()) ReturnType;
+
+		std::shared_ptr<std::packaged_task<ReturnType()>> pTask = std::make_shared<std::packaged_task<ReturnType()>>(func);
+		std::future<ReturnType> result = pTask->get_future();
+
+		Enqueue([pTask]()
+		{
+			(*pTask)();
+		});
+
+		return result;
+	}
+
+	//Calls func(iStart, iEnd) over [0, iCount) in chunks of iGrainSize. The calling thread also does work and
+	//only returns once every chunk has completed, so it is safe to call from inside another pool task.
+	void ParallelFor(int iCount, int iGrainSize, const std::function<void(int, int)>& func);
+
+	unsigned int GetNumThreads() const;
+
+protected:
+
+private:
+	void Enqueue(std::function<void()> task);
+
+	void WorkerLoop();
+
+	std::vector<std::thread> m_Workers;
+	std::queue<std::function<void()>> m_Tasks;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_Condition;
+
+	bool m_bStopping = false;
+};
@@ -11,3 +11,16 @@ UAVDescriptor::UAVDescriptor(UINT uiDescriptorIndex, D3D12_CPU_DESCRIPTOR_HANDLE
 
 	App::GetApp()->GetDevice()->CreateUnorderedAccessView(pResource, nullptr, &uavDesc, handle);
 }
+
+UAVDescriptor::UAVDescriptor(UINT uiDescriptorIndex, D3D12_CPU_DESCRIPTOR_HANDLE handle, ID3D12Resource* pResource, UINT uiNumElements, DXGI_FORMAT format, UINT uiBufferByteStride, UINT64 uiFirstElement) : Descriptor(uiDescriptorIndex)
+{
+	D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+	uavDesc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
+	uavDesc.Format = format;
+	uavDesc.Buffer.NumElements = uiNumElements;
+	uavDesc.Buffer.StructureByteStride = uiBufferByteStride;
+	uavDesc.Buffer.FirstElement = uiFirstElement;
+	uavDesc.Buffer.Flags = D3D12_BUFFER_UAV_FLAG_NONE;
+
+	App::GetApp()->GetDevice()->CreateUnorderedAccessView(pResource, nullptr, &uavDesc, handle);
+}
@@ -5,6 +5,7 @@ class UAVDescriptor : public Descriptor
 {
 public:
 	UAVDescriptor(UINT uiDescriptorIndex, D3D12_CPU_DESCRIPTOR_HANDLE handle, ID3D12Resource* pResource, D3D12_UAV_DIMENSION viewDimension, DXGI_FORMAT format);
+	UAVDescriptor(UINT uiDescriptorIndex, D3D12_CPU_DESCRIPTOR_HANDLE handle, ID3D12Resource* pResource, UINT uiNumElements, DXGI_FORMAT format, UINT uiBufferByteStride, UINT64 uiFirstElement);
 
 protected:
 
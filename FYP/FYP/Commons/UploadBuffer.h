@@ -111,6 +111,17 @@ public:
 		memcpy(&m_pMappedData[iIndex * m_uiByteStride], &data[0], sizeof(T) * data.size());
 	}
 
+	void CopyData(int iIndex, const T* kpData, UINT uiCount)
+	{
+		memcpy(&m_pMappedData[iIndex * m_uiByteStride], kpData, sizeof(T) * uiCount);
+	}
+
+	//Upload heaps are write combined so reading through this is slow, only use it for one off copies
+	const T* GetMappedData() const
+	{
+		return reinterpret_cast<const T*>(m_pMappedData);
+	}
+
 	D3D12_GPU_VIRTUAL_ADDRESS GetBufferGPUAddress(UINT uiCount = 0)
 	{
 		return m_pUploadBuffer.Get()->GetGPUVirtualAddress() + (uiCount * m_uiByteStride);
@@ -0,0 +1,200 @@
+#include "AdaptiveRayAllocator.h"
+
+#include <algorithm>
+#include <math.h>
+
+AdaptiveRayAllocator::AdaptiveRayAllocator()
+{
+}
+
+void AdaptiveRayAllocator::Allocate(const std::vector<float>& kMeans, const std::vector<float>& kVariances, std::vector<UINT>& rayCounts) const
+{
+	int iNumProbes = (int)kMeans.size();
+
+	if (iNumProbes == 0)
+	{
+		return;
+	}
+
+	if ((int)rayCounts.size() != iNumProbes)
+	{
+		AllocateUniform(iNumProbes, rayCounts);
+	}
+
+	std::vector<float> sigmas;
+	GetSigmas(kMeans, kVariances, rayCounts, sigmas);
+
+	int iMinRays = (std::min)(m_iMinRays, m_iMaxRays);
+	int iBudget = (std::max)(m_iRayBudget, iMinRays * iNumProbes);
+
+	//Water filling, probes that hit the min or max are fixed there and the rest of the budget is shared out again
+	std::vector<double> allocation(iNumProbes, 0.0);
+	std::vector<bool> fixed(iNumProbes, false);
+
+	double dFreeBudget = iBudget;
+	bool bClamped = true;
+
+	while (bClamped == true)
+	{
+		bClamped = false;
+
+		double dTotalSigma = 0.0;
+		int iNumFree = 0;
+
+		for (int i = 0; i < iNumProbes; ++i)
+		{
+			if (fixed[i] == false)
+			{
+				dTotalSigma += sigmas[i];
+				++iNumFree;
+			}
+		}
+
+		if (iNumFree == 0)
+		{
+			break;
+		}
+
+		for (int i = 0; i < iNumProbes; ++i)
+		{
+			if (fixed[i] == true)
+			{
+				continue;
+			}
+
+			//Nothing to go on so split what's left evenly
+			allocation[i] = dTotalSigma > 0.0 ? dFreeBudget * sigmas[i] / dTotalSigma : dFreeBudget / iNumFree;
+		}
+
+		for (int i = 0; i < iNumProbes; ++i)
+		{
+			if (fixed[i] == true)
+			{
+				continue;
+			}
+
+			if (allocation[i] < iMinRays || allocation[i] > m_iMaxRays)
+			{
+				allocation[i] = allocation[i] < iMinRays ? iMinRays : m_iMaxRays;
+				fixed[i] = true;
+
+				dFreeBudget -= allocation[i];
+				bClamped = true;
+			}
+		}
+	}
+
+	//Round down to the granularity then give the leftover granules to the probes that lost the most
+	std::vector<std::pair<double, int>> remainders;
+	remainders.reserve(iNumProbes);
+
+	int iGranularity = (std::max)(m_iGranularity, 1);
+	int iUsed = 0;
+
+	for (int i = 0; i < iNumProbes; ++i)
+	{
+		int iNumRays = (std::max)(RoundDown((int)allocation[i]), (std::max)(RoundDown(iMinRays), iGranularity));
+
+		rayCounts[i] = iNumRays;
+		iUsed += iNumRays;
+
+		remainders.push_back(std::make_pair(allocation[i] - iNumRays, i));
+	}
+
+	std::sort(remainders.begin(), remainders.end(), [](const std::pair<double, int>& kLHS, const std::pair<double, int>& kRHS)
+	{
+		return kLHS.first > kRHS.first;
+	});
+
+	for (int i = 0; i < iNumProbes && iUsed + iGranularity <= iBudget; ++i)
+	{
+		int iProbeIndex = remainders[i].second;
+
+		if ((int)rayCounts[iProbeIndex] + iGranularity <= m_iMaxRays)
+		{
+			rayCounts[iProbeIndex] += iGranularity;
+			iUsed += iGranularity;
+		}
+	}
+}
+
+void AdaptiveRayAllocator::AllocateUniform(int iNumProbes, std::vector<UINT>& rayCounts) const
+{
+	int iNumRays = iNumProbes > 0 ? m_iRayBudget / iNumProbes : 0;
+	iNumRays = RoundDown((std::max)((std::min)(iNumRays, m_iMaxRays), m_iMinRays));
+
+	rayCounts.assign(iNumProbes, (std::max)(iNumRays, (std::max)(m_iGranularity, 1)));
+}
+
+double AdaptiveRayAllocator::GetExpectedError(const std::vector<float>& kSigmas, const std::vector<UINT>& kRayCounts)
+{
+	double dError = 0.0;
+
+	for (int i = 0; i < (int)kSigmas.size(); ++i)
+	{
+		dError += (double)kSigmas[i] * kSigmas[i] / (std::max)(kRayCounts[i], 1u);
+	}
+
+	return dError;
+}
+
+void AdaptiveRayAllocator::GetSigmas(const std::vector<float>& kMeans, const std::vector<float>& kVariances, const std::vector<UINT>& kRayCounts, std::vector<float>& sigmas)
+{
+	sigmas.resize(kMeans.size());
+
+	for (int i = 0; i < (int)kMeans.size(); ++i)
+	{
+		//The variance is of the mean over all the probe's rays so scale it back up to a per ray variance, relative to
+		//the brightness so dark and bright probes are treated the same
+		float fRelativeVariance = kVariances[i] / (kMeans[i] * kMeans[i] + 1e-4f);
+
+		sigmas[i] = sqrtf((std::max)(fRelativeVariance, 0.0f) * (std::max)(kRayCounts[i], 1u));
+	}
+}
+
+int AdaptiveRayAllocator::RoundDown(int iNumRays) const
+{
+	int iGranularity = (std::max)(m_iGranularity, 1);
+
+	return (iNumRays / iGranularity) * iGranularity;
+}
+
+int AdaptiveRayAllocator::GetRayBudget() const
+{
+	return m_iRayBudget;
+}
+
+int AdaptiveRayAllocator::GetMinRays() const
+{
+	return m_iMinRays;
+}
+
+int AdaptiveRayAllocator::GetMaxRays() const
+{
+	return m_iMaxRays;
+}
+
+int AdaptiveRayAllocator::GetGranularity() const
+{
+	return m_iGranularity;
+}
+
+void AdaptiveRayAllocator::SetRayBudget(int iRayBudget)
+{
+	m_iRayBudget = (std::max)(iRayBudget, 0);
+}
+
+void AdaptiveRayAllocator::SetMinRays(int iMinRays)
+{
+	m_iMinRays = (std::max)(iMinRays, 1);
+}
+
+void AdaptiveRayAllocator::SetMaxRays(int iMaxRays)
+{
+	m_iMaxRays = (std::max)(iMaxRays, 1);
+}
+
+void AdaptiveRayAllocator::SetGranularity(int iGranularity)
+{
+	m_iGranularity = (std::max)(iGranularity, 1);
+}
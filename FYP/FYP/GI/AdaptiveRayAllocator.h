@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <vector>
+
+//Splits a ray budget between probes so the noisiest probes get the most rays. Each probe's per-ray standard deviation
+//is estimated from the temporal variance of its luminance and the rays it traced to get it, then rays are handed out in
+//proportion to that (Neyman allocation), which minimises the summed variance of every probe's estimate for the budget.
+class AdaptiveRayAllocator
+{
+public:
+	AdaptiveRayAllocator();
+
+	//kMeans and kVariances are per probe. rayCounts holds the counts the statistics were gathered with and is replaced
+	//with the new counts, which are multiples of the granularity between the min and max and sum to at most the budget.
+	void Allocate(const std::vector<float>& kMeans, const std::vector<float>& kVariances, std::vector<UINT>& rayCounts) const;
+
+	//Every probe gets the same number of rays, what GIVolume does without adaptive rays
+	void AllocateUniform(int iNumProbes, std::vector<UINT>& rayCounts) const;
+
+	//Summed variance of every probe's estimate, sigma^2 / n, for comparing allocations against each other
+	static double GetExpectedError(const std::vector<float>& kSigmas, const std::vector<UINT>& kRayCounts);
+
+	//Relative per-ray standard deviation of each probe, what Allocate shares the budget out by
+	static void GetSigmas(const std::vector<float>& kMeans, const std::vector<float>& kVariances, const std::vector<UINT>& kRayCounts, std::vector<float>& sigmas);
+
+	//Getters
+	int GetRayBudget() const;
+	int GetMinRays() const;
+	int GetMaxRays() const;
+	int GetGranularity() const;
+
+	//Setters
+	void SetRayBudget(int iRayBudget);
+	void SetMinRays(int iMinRays);
+	void SetMaxRays(int iMaxRays);
+	void SetGranularity(int iGranularity);
+
+protected:
+
+private:
+	int RoundDown(int iNumRays) const;
+
+	int m_iRayBudget = 0;
+	int m_iMinRays = 32;
+	int m_iMaxRays = 288;
+	int m_iGranularity = 32;
+};
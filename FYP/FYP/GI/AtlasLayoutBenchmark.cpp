@@ -0,0 +1,188 @@
+#include "AtlasLayoutBenchmark.h"
+#include "Helpers/ProbeHelper.h"
+#include "Helpers/DebugHelper.h"
+
+#include <algorithm>
+#include <math.h>
+#include <random>
+
+using namespace DirectX;
+
+void AtlasLayoutBenchmark::CreateQueries(const RaytracePerFrameCB& kParams, int iNumWaves, int iWaveSize, float fWaveRadius, unsigned int uiSeed, std::vector<IrradianceQuery>& queries)
+{
+	std::mt19937 rng(uiSeed);
+	std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+	queries.clear();
+	queries.reserve((size_t)iNumWaves * iWaveSize);
+
+	XMFLOAT3 extents = XMFLOAT3(
+		(kParams.ProbeCounts.x - 1) * kParams.ProbeSpacing.x,
+		(kParams.ProbeCounts.y - 1) * kParams.ProbeSpacing.y,
+		(kParams.ProbeCounts.z - 1) * kParams.ProbeSpacing.z);
+
+	XMFLOAT3 minPosW = ProbeHelper::GetProbeCoordsWorld(XMINT3(0, 0, 0), kParams.VolumePosition, kParams.ProbeOffsets, kParams.ProbeSpacing, kParams.ProbeCounts);
+
+	for (int i = 0; i < iNumWaves; ++i)
+	{
+		XMFLOAT3 centre = XMFLOAT3(minPosW.x + uniform(rng) * extents.x, minPosW.y + uniform(rng) * extents.y, minPosW.z + uniform(rng) * extents.z);
+
+		//Uniform direction on the sphere for the surface's normal
+		float fCosTheta = 1.0f - 2.0f * uniform(rng);
+		float fSinTheta = sqrtf((std::max)(0.0f, 1.0f - fCosTheta * fCosTheta));
+		float fPhi = XM_2PI * uniform(rng);
+
+		XMFLOAT3 normal = XMFLOAT3(fSinTheta * cosf(fPhi), fSinTheta * sinf(fPhi), fCosTheta);
+
+		XMFLOAT3 tangent = ProbeHelper::Normalize(fabsf(normal.y) < 0.999f ? ProbeHelper::Cross(normal, XMFLOAT3(0, 1, 0)) : ProbeHelper::Cross(normal, XMFLOAT3(1, 0, 0)));
+		XMFLOAT3 bitangent = ProbeHelper::Cross(normal, tangent);
+
+		for (int j = 0; j < iWaveSize; ++j)
+		{
+			float fRadius = fWaveRadius * sqrtf(uniform(rng));
+			float fAngle = XM_2PI * uniform(rng);
+
+			float fTangent = fRadius * cosf(fAngle);
+			float fBitangent = fRadius * sinf(fAngle);
+
+			IrradianceQuery query;
+			query.PosW = XMFLOAT3(
+				centre.x + tangent.x * fTangent + bitangent.x * fBitangent,
+				centre.y + tangent.y * fTangent + bitangent.y * fBitangent,
+				centre.z + tangent.z * fTangent + bitangent.z * fBitangent);
+			query.NormalW = normal;
+
+			queries.push_back(query);
+		}
+	}
+}
+
+AtlasLayoutStats AtlasLayoutBenchmark::Run(const RaytracePerFrameCB& kParams, int iAtlasLayout, const AtlasCacheModel& kModel, const std::vector<IrradianceQuery>& kQueries, int iWaveSize)
+{
+	PROFILE("Atlas Layout Benchmark");
+
+	AtlasLayoutStats stats;
+	stats.AtlasLayout = iAtlasLayout;
+
+	if (kQueries.empty() == true || iWaveSize <= 0)
+	{
+		return stats;
+	}
+
+	//Same formats GIVolume picks for the atlases, the distance atlas is full float alongside full float irradiance
+	int iIrradianceTexelBytes = kParams.IrradianceFormat == FORMAT_PROBE_IRRADIANCE_R32G32B32A32_FLOAT ? 16 : 4;
+	int iDistanceTexelBytes = kParams.IrradianceFormat == FORMAT_PROBE_IRRADIANCE_R32G32B32A32_FLOAT ? 8 : 4;
+
+	int iIrradianceWidth = (kParams.NumIrradianceTexels + 2) * kParams.ProbeCounts.x * kParams.ProbeCounts.y;
+	int iIrradianceHeight = (kParams.NumIrradianceTexels + 2) * kParams.ProbeCounts.z;
+	int iDistanceWidth = (kParams.NumDistanceTexels + 2) * kParams.ProbeCounts.x * kParams.ProbeCounts.y;
+	int iDistanceHeight = (kParams.NumDistanceTexels + 2) * kParams.ProbeCounts.z;
+
+	UINT64 uiTotalQueryLines = 0;
+	UINT64 uiTotalQueryBlocks = 0;
+	UINT64 uiTotalWaveLines = 0;
+	UINT64 uiTotalWaveBlocks = 0;
+	UINT64 uiNumWaves = 0;
+
+	m_WaveLines.clear();
+	m_WaveBlocks.clear();
+
+	for (size_t i = 0; i < kQueries.size(); ++i)
+	{
+		const IrradianceQuery& kQuery = kQueries[i];
+
+		m_QueryLines.clear();
+		m_QueryBlocks.clear();
+
+		XMINT3 closestProbeCoords = ProbeHelper::GetClosestProbeCoords(kQuery.PosW, kParams.VolumePosition, kParams.ProbeOffsets, kParams.ProbeSpacing, kParams.ProbeCounts);
+
+		XMFLOAT2 irradianceOctCoords = ProbeHelper::GetOctahedralCoords(kQuery.NormalW);
+
+		for (int j = 0; j < 8; ++j)
+		{
+			XMINT3 probeCoords;
+			probeCoords.x = (std::min)(closestProbeCoords.x + (j & 1), kParams.ProbeCounts.x - 1);
+			probeCoords.y = (std::min)(closestProbeCoords.y + ((j >> 1) & 1), kParams.ProbeCounts.y - 1);
+			probeCoords.z = (std::min)(closestProbeCoords.z + ((j >> 2) & 1), kParams.ProbeCounts.z - 1);
+
+			int iProbeIndex = ProbeHelper::GetOffsettedProbeIndex(probeCoords, kParams.ProbeCounts, kParams.ProbeOffsets);
+
+			XMFLOAT3 probeCoordsWorld = ProbeHelper::GetProbeCoordsWorld(probeCoords, kParams.VolumePosition, kParams.ProbeOffsets, kParams.ProbeSpacing, kParams.ProbeCounts);
+			XMFLOAT3 toProbe = XMFLOAT3(probeCoordsWorld.x - kQuery.PosW.x, probeCoordsWorld.y - kQuery.PosW.y, probeCoordsWorld.z - kQuery.PosW.z);
+
+			//A point right on the probe samples the middle of its tile, which direction doesn't matter
+			float fDistance = sqrtf(toProbe.x * toProbe.x + toProbe.y * toProbe.y + toProbe.z * toProbe.z);
+			XMFLOAT2 distanceOctCoords = fDistance > 0.0f ? ProbeHelper::GetOctahedralCoords(XMFLOAT3(-toProbe.x / fDistance, -toProbe.y / fDistance, -toProbe.z / fDistance)) : XMFLOAT2(0, 0);
+
+			AddFootprint(ProbeHelper::GetAtlasCoords(iProbeIndex, irradianceOctCoords, kParams.NumIrradianceTexels, kParams.ProbeCounts, iAtlasLayout), 0, iIrradianceWidth, iIrradianceHeight, iIrradianceTexelBytes, kModel);
+			AddFootprint(ProbeHelper::GetAtlasCoords(iProbeIndex, distanceOctCoords, kParams.NumDistanceTexels, kParams.ProbeCounts, iAtlasLayout), 1, iDistanceWidth, iDistanceHeight, iDistanceTexelBytes, kModel);
+		}
+
+		m_WaveLines.insert(m_WaveLines.end(), m_QueryLines.begin(), m_QueryLines.end());
+		m_WaveBlocks.insert(m_WaveBlocks.end(), m_QueryBlocks.begin(), m_QueryBlocks.end());
+
+		uiTotalQueryLines += CountUnique(m_QueryLines);
+		uiTotalQueryBlocks += CountUnique(m_QueryBlocks);
+
+		if ((i + 1) % iWaveSize == 0 || i + 1 == kQueries.size())
+		{
+			uiTotalWaveLines += CountUnique(m_WaveLines);
+			uiTotalWaveBlocks += CountUnique(m_WaveBlocks);
+			++uiNumWaves;
+
+			m_WaveLines.clear();
+			m_WaveBlocks.clear();
+		}
+	}
+
+	stats.NumQueries = kQueries.size();
+	stats.LinesPerQuery = uiTotalQueryLines / (double)stats.NumQueries;
+	stats.BlocksPerQuery = uiTotalQueryBlocks / (double)stats.NumQueries;
+	stats.LinesPerWave = uiTotalWaveLines / (double)uiNumWaves;
+	stats.BlocksPerWave = uiTotalWaveBlocks / (double)uiNumWaves;
+
+	return stats;
+}
+
+std::vector<AtlasLayoutStats> AtlasLayoutBenchmark::RunAll(const RaytracePerFrameCB& kParams, const AtlasCacheModel& kModel, const std::vector<IrradianceQuery>& kQueries, int iWaveSize)
+{
+	std::vector<AtlasLayoutStats> stats;
+	stats.push_back(Run(kParams, PROBE_ATLAS_LAYOUT_PLANES, kModel, kQueries, iWaveSize));
+	stats.push_back(Run(kParams, PROBE_ATLAS_LAYOUT_BRICKS, kModel, kQueries, iWaveSize));
+
+	return stats;
+}
+
+void AtlasLayoutBenchmark::AddFootprint(const XMFLOAT2& kUV, UINT uiAtlasIndex, int iWidth, int iHeight, int iTexelBytes, const AtlasCacheModel& kModel)
+{
+	//Same texels CPUIrradianceQuery::SampleLinearWrap reads
+	float fX = kUV.x * iWidth - 0.5f;
+	float fY = kUV.y * iHeight - 0.5f;
+
+	int iX0 = (int)floorf(fX);
+	int iY0 = (int)floorf(fY);
+
+	int iBlocksAcross = (iWidth + kModel.BlockWidth - 1) / kModel.BlockWidth;
+
+	for (int y = 0; y < 2; ++y)
+	{
+		for (int x = 0; x < 2; ++x)
+		{
+			int iTexelX = ((iX0 + x) % iWidth + iWidth) % iWidth;
+			int iTexelY = ((iY0 + y) % iHeight + iHeight) % iHeight;
+
+			UINT64 uiLine = (((UINT64)iTexelY * iWidth) + iTexelX) * iTexelBytes / kModel.LineBytes;
+			UINT64 uiBlock = ((UINT64)(iTexelY / kModel.BlockHeight) * iBlocksAcross) + (iTexelX / kModel.BlockWidth);
+
+			m_QueryLines.push_back(((UINT64)uiAtlasIndex << 60) | uiLine);
+			m_QueryBlocks.push_back(((UINT64)uiAtlasIndex << 60) | uiBlock);
+		}
+	}
+}
+
+size_t AtlasLayoutBenchmark::CountUnique(std::vector<UINT64>& ids)
+{
+	std::sort(ids.begin(), ids.end());
+
+	return std::unique(ids.begin(), ids.end()) - ids.begin();
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "GI/CPUIrradianceQuery.h"
+#include "Shaders/ConstantBuffers.h"
+#include "Shaders/Defines.hlsli"
+
+#include <vector>
+
+//How texels are grouped into the cache lines that get counted, both are made up of whole texels
+struct AtlasCacheModel
+{
+	//Row major texels split into lines of this many bytes, like a linear texture or a buffer
+	int LineBytes = 64;
+
+	//Texels split into blocks of this size, closer to how GPUs tile textures in memory
+	int BlockWidth = 8;
+	int BlockHeight = 8;
+};
+
+struct AtlasLayoutStats
+{
+	int AtlasLayout = PROBE_ATLAS_LAYOUT_PLANES;
+
+	UINT64 NumQueries = 0;
+
+	//Mean distinct lines or blocks touched by the irradiance and distance samples of one query
+	double LinesPerQuery = 0.0;
+	double BlocksPerQuery = 0.0;
+
+	//Mean distinct lines or blocks touched by a whole wave of queries, what a wave of shading threads would fetch
+	double LinesPerWave = 0.0;
+	double BlocksPerWave = 0.0;
+};
+
+//Counts the cache lines each probe atlas layout touches when shading, to compare them without a GPU capture. Every
+//query fetches the bilinear footprints GetIrradiance in Shaders/Irradiance.hlsl does, one irradiance and one
+//distance sample for each of the eight surrounding probes, and the distinct lines and blocks those texels fall in are
+//counted per query and per wave of neighbouring queries. Only the addresses are worked out so no atlases are needed.
+//Only octahedral irradiance. Surface bias, classification and relocation are left out as they barely move the footprints.
+class AtlasLayoutBenchmark
+{
+public:
+	//iNumWaves patches of iWaveSize shading points, each patch a disc of fWaveRadius on a randomly facing surface
+	//somewhere inside the volume, like the pixels of a screen tile
+	static void CreateQueries(const RaytracePerFrameCB& kParams, int iNumWaves, int iWaveSize, float fWaveRadius, unsigned int uiSeed, std::vector<IrradianceQuery>& queries);
+
+	//kQueries is split into waves of iWaveSize in order
+	AtlasLayoutStats Run(const RaytracePerFrameCB& kParams, int iAtlasLayout, const AtlasCacheModel& kModel, const std::vector<IrradianceQuery>& kQueries, int iWaveSize);
+
+	//Every layout over the same queries
+	std::vector<AtlasLayoutStats> RunAll(const RaytracePerFrameCB& kParams, const AtlasCacheModel& kModel, const std::vector<IrradianceQuery>& kQueries, int iWaveSize);
+
+protected:
+
+private:
+	//Adds the lines and blocks the 2x2 texels around kUV fall in, the atlases are told apart by uiAtlasIndex
+	void AddFootprint(const DirectX::XMFLOAT2& kUV, UINT uiAtlasIndex, int iWidth, int iHeight, int iTexelBytes, const AtlasCacheModel& kModel);
+
+	//Sorts and removes duplicates, returning how many are left
+	static size_t CountUnique(std::vector<UINT64>& ids);
+
+	std::vector<UINT64> m_QueryLines;
+	std::vector<UINT64> m_QueryBlocks;
+
+	std::vector<UINT64> m_WaveLines;
+	std::vector<UINT64> m_WaveBlocks;
+};
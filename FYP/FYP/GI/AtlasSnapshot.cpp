@@ -0,0 +1,191 @@
+#include "AtlasSnapshot.h"
+#include "Helpers/DebugHelper.h"
+
+#include <fstream>
+
+Tag tag = L"AtlasSnapshot";
+
+static const char s_kMagic[4] = { 'G', 'I', 'A', 'S' };
+
+bool AtlasSnapshot::Write(const std::string& ksFilepath, const AtlasSnapshotDesc& kDesc, const std::vector<AtlasSnapshotEntry>& kEntries, const std::vector<const BYTE*>& kData)
+{
+	std::ofstream outFile(ksFilepath, std::ios::binary);
+
+	if (outFile.is_open() == false)
+	{
+		LOG_ERROR(tag, L"Failed to open %s to write the GI atlas snapshot!", std::wstring(ksFilepath.begin(), ksFilepath.end()).c_str());
+
+		return false;
+	}
+
+	AtlasSnapshotHeader header = {};
+	memcpy(header.Magic, s_kMagic, sizeof(s_kMagic));
+	header.Version = ATLAS_SNAPSHOT_VERSION;
+	header.HeaderSize = sizeof(AtlasSnapshotHeader);
+	header.NumAtlases = (UINT32)kEntries.size();
+	header.Desc = kDesc;
+
+	outFile.write((const char*)&header, sizeof(AtlasSnapshotHeader));
+
+	//Work out where each atlas's data will end up now the size of the tables is known
+	std::vector<AtlasSnapshotEntry> entries = kEntries;
+	UINT64 uiOffset = sizeof(AtlasSnapshotHeader) + sizeof(AtlasSnapshotEntry) * entries.size();
+
+	for (int i = 0; i < entries.size(); ++i)
+	{
+		entries[i].DataOffset = uiOffset;
+
+		uiOffset += (UINT64)entries[i].RowSize * entries[i].Height;
+	}
+
+	outFile.write((const char*)entries.data(), sizeof(AtlasSnapshotEntry) * entries.size());
+
+	for (int i = 0; i < entries.size(); ++i)
+	{
+		outFile.write((const char*)kData[i], (std::streamsize)entries[i].RowSize * entries[i].Height);
+	}
+
+	outFile.close();
+
+	if (outFile.fail() == true)
+	{
+		LOG_ERROR(tag, L"Failed to write the GI atlas snapshot to %s!", std::wstring(ksFilepath.begin(), ksFilepath.end()).c_str());
+
+		return false;
+	}
+
+	return true;
+}
+
+bool AtlasSnapshot::Open(const std::string& ksFilepath)
+{
+	Close();
+
+	if (m_File.Open(ksFilepath) == false)
+	{
+		return false;
+	}
+
+	if (m_File.GetSize() < sizeof(AtlasSnapshotHeader))
+	{
+		LOG_ERROR(tag, L"GI atlas snapshot %s is too small to contain a header!", std::wstring(ksFilepath.begin(), ksFilepath.end()).c_str());
+
+		Close();
+
+		return false;
+	}
+
+	const AtlasSnapshotHeader* kpHeader = (const AtlasSnapshotHeader*)m_File.GetData();
+
+	if (memcmp(kpHeader->Magic, s_kMagic, sizeof(s_kMagic)) != 0 || kpHeader->HeaderSize != sizeof(AtlasSnapshotHeader))
+	{
+		LOG_ERROR(tag, L"%s isn't a GI atlas snapshot!", std::wstring(ksFilepath.begin(), ksFilepath.end()).c_str());
+
+		Close();
+
+		return false;
+	}
+
+	if (kpHeader->Version != ATLAS_SNAPSHOT_VERSION)
+	{
+		LOG_WARNING(tag, L"GI atlas snapshot %s is version %u but version %u is needed!", std::wstring(ksFilepath.begin(), ksFilepath.end()).c_str(), kpHeader->Version, ATLAS_SNAPSHOT_VERSION);
+
+		Close();
+
+		return false;
+	}
+
+	UINT64 uiTableEnd = sizeof(AtlasSnapshotHeader) + sizeof(AtlasSnapshotEntry) * (UINT64)kpHeader->NumAtlases;
+
+	if (m_File.GetSize() < uiTableEnd)
+	{
+		LOG_ERROR(tag, L"GI atlas snapshot %s is truncated!", std::wstring(ksFilepath.begin(), ksFilepath.end()).c_str());
+
+		Close();
+
+		return false;
+	}
+
+	const AtlasSnapshotEntry* kpEntries = (const AtlasSnapshotEntry*)(m_File.GetData() + sizeof(AtlasSnapshotHeader));
+
+	for (UINT32 i = 0; i < kpHeader->NumAtlases; ++i)
+	{
+		if (kpEntries[i].DataOffset < uiTableEnd || kpEntries[i].DataOffset + (UINT64)kpEntries[i].RowSize * kpEntries[i].Height > m_File.GetSize())
+		{
+			LOG_ERROR(tag, L"GI atlas snapshot %s is truncated!", std::wstring(ksFilepath.begin(), ksFilepath.end()).c_str());
+
+			Close();
+
+			return false;
+		}
+	}
+
+	m_kpHeader = kpHeader;
+	m_kpEntries = kpEntries;
+
+	return true;
+}
+
+void AtlasSnapshot::Close()
+{
+	m_kpHeader = nullptr;
+	m_kpEntries = nullptr;
+
+	m_File.Close();
+}
+
+bool AtlasSnapshot::IsCompatible(const AtlasSnapshotDesc& kDesc) const
+{
+	if (m_kpHeader == nullptr)
+	{
+		return false;
+	}
+
+	const AtlasSnapshotDesc& kSnapshotDesc = m_kpHeader->Desc;
+
+	return kSnapshotDesc.ProbeCounts.x == kDesc.ProbeCounts.x &&
+		kSnapshotDesc.ProbeCounts.y == kDesc.ProbeCounts.y &&
+		kSnapshotDesc.ProbeCounts.z == kDesc.ProbeCounts.z &&
+		kSnapshotDesc.IrradianceTexelsPerProbe == kDesc.IrradianceTexelsPerProbe &&
+		kSnapshotDesc.DistanceTexelsPerProbe == kDesc.DistanceTexelsPerProbe &&
+		kSnapshotDesc.GIAtlasSize == kDesc.GIAtlasSize &&
+		kSnapshotDesc.RayDataFormat == kDesc.RayDataFormat &&
+		kSnapshotDesc.IrradianceFormat == kDesc.IrradianceFormat &&
+		kSnapshotDesc.IrradianceEncoding == kDesc.IrradianceEncoding &&
+		kSnapshotDesc.AtlasLayout == kDesc.AtlasLayout;
+}
+
+bool AtlasSnapshot::IsCompatible(SnapshotAtlas atlas, DXGI_FORMAT format, UINT64 uiWidth, UINT uiNumRows, UINT64 uiRowSize) const
+{
+	const AtlasSnapshotEntry* kpEntry = GetEntry(atlas);
+
+	return kpEntry != nullptr && kpEntry->Format == format && kpEntry->Width == uiWidth && kpEntry->Height == uiNumRows && kpEntry->RowSize == uiRowSize;
+}
+
+const AtlasSnapshotDesc& AtlasSnapshot::GetDesc() const
+{
+	return m_kpHeader->Desc;
+}
+
+const AtlasSnapshotEntry* AtlasSnapshot::GetEntry(SnapshotAtlas atlas) const
+{
+	if (m_kpHeader == nullptr)
+	{
+		return nullptr;
+	}
+
+	for (UINT32 i = 0; i < m_kpHeader->NumAtlases; ++i)
+	{
+		if (m_kpEntries[i].Type == atlas)
+		{
+			return &m_kpEntries[i];
+		}
+	}
+
+	return nullptr;
+}
+
+const BYTE* AtlasSnapshot::GetData(const AtlasSnapshotEntry* kpEntry) const
+{
+	return m_File.GetData() + kpEntry->DataOffset;
+}
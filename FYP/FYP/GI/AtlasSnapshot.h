@@ -0,0 +1,94 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <DirectXMath.h>
+#include <dxgiformat.h>
+
+#include "Commons/MappedFile.h"
+
+#include <string>
+#include <vector>
+
+#define ATLAS_SNAPSHOT_VERSION 8
+
+enum class SnapshotAtlas : UINT32
+{
+	IRRADIANCE = 0,
+	DISTANCE,
+	PROBE_DATA,
+
+	COUNT
+};
+
+//Volume settings the atlases were saved with. Only the settings that decide the atlases' layout are stored, plus where
+//the volume was, so new volume settings don't change the file format. Every member is 4 bytes wide so there's no padding.
+struct AtlasSnapshotDesc
+{
+	DirectX::XMFLOAT3 Position;
+	DirectX::XMINT3 ProbeCounts;
+	DirectX::XMINT3 ProbeOffsets;
+
+	INT32 IrradianceTexelsPerProbe;
+	INT32 DistanceTexelsPerProbe;
+	INT32 GIAtlasSize;
+	INT32 RayDataFormat;	//FORMAT_PROBE_RAY_DATA_ value
+	INT32 IrradianceFormat;	//FORMAT_PROBE_IRRADIANCE_ value
+	INT32 IrradianceEncoding;	//PROBE_IRRADIANCE_ENCODING_ value
+	INT32 AtlasLayout;	//PROBE_ATLAS_LAYOUT_ value
+};
+
+//Binary layout of a GI atlas snapshot:
+//AtlasSnapshotHeader, then an AtlasSnapshotEntry per atlas, then each atlas's rows packed tightly one after the other.
+//The version only has to be bumped when one of these structs changes.
+struct AtlasSnapshotHeader
+{
+	char Magic[4];
+	UINT32 Version;
+	UINT32 HeaderSize;
+	UINT32 NumAtlases;
+
+	AtlasSnapshotDesc Desc;
+};
+
+struct AtlasSnapshotEntry
+{
+	SnapshotAtlas Type;
+	DXGI_FORMAT Format;
+
+	UINT32 Width;
+	UINT32 Height;
+	UINT32 RowSize;	//In bytes without any padding
+	UINT32 Pad;
+
+	UINT64 DataOffset;	//From the start of the file
+};
+
+class AtlasSnapshot
+{
+public:
+	static bool Write(const std::string& ksFilepath, const AtlasSnapshotDesc& kDesc, const std::vector<AtlasSnapshotEntry>& kEntries, const std::vector<const BYTE*>& kData);
+
+	//Maps the file and checks the header, the atlas data isn't touched until it's asked for
+	bool Open(const std::string& ksFilepath);
+	void Close();
+
+	//Snapshots only line up with the current atlases if the probe layout is the same
+	bool IsCompatible(const AtlasSnapshotDesc& kDesc) const;
+
+	//The stored atlas has to have the same format and size as the one it's copied into, uiRowSize is without padding
+	bool IsCompatible(SnapshotAtlas atlas, DXGI_FORMAT format, UINT64 uiWidth, UINT uiNumRows, UINT64 uiRowSize) const;
+
+	const AtlasSnapshotDesc& GetDesc() const;
+
+	const AtlasSnapshotEntry* GetEntry(SnapshotAtlas atlas) const;
+	const BYTE* GetData(const AtlasSnapshotEntry* kpEntry) const;
+
+protected:
+
+private:
+	MappedFile m_File;
+
+	const AtlasSnapshotHeader* m_kpHeader = nullptr;
+	const AtlasSnapshotEntry* m_kpEntries = nullptr;
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <vector>
+
+//CPU side copy of one of the GI volume's texture atlases. Every texel is stored as a float4 whatever the GPU format
+//is, with unused channels left at zero, e.g. R32G32 ray data only uses x and y.
+struct CPUAtlas
+{
+	void Resize(int iWidth, int iHeight)
+	{
+		Width = iWidth;
+		Height = iHeight;
+
+		Texels.assign((size_t)iWidth * iHeight, DirectX::XMFLOAT4(0, 0, 0, 0));
+	}
+
+	DirectX::XMFLOAT4& GetTexel(int iX, int iY)
+	{
+		return Texels[(size_t)iY * Width + iX];
+	}
+
+	const DirectX::XMFLOAT4& GetTexel(int iX, int iY) const
+	{
+		return Texels[(size_t)iY * Width + iX];
+	}
+
+	int Width = 0;
+	int Height = 0;
+
+	std::vector<DirectX::XMFLOAT4> Texels;
+};
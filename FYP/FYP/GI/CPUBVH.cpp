@@ -0,0 +1,636 @@
+#include "CPUBVH.h"
+#include "Commons/Mesh.h"
+#include "Commons/ThreadPool.h"
+#include "Commons/Timer.h"
+#include "Helpers/DebugHelper.h"
+#include "Helpers/VertexPackingHelper.h"
+#include "Shaders/Vertices.h"
+#include "Shaders/Defines.hlsli"
+
+#include <algorithm>
+
+using namespace DirectX;
+
+Tag tag = L"CPUBVH";
+
+#define BVH_NUM_BINS 16
+#define BVH_MAX_LEAF_SIZE 16
+#define BVH_MAX_STACK_SIZE 64
+#define BVH_PARALLEL_BUILD_SIZE 4096
+#define BVH_TRIANGLES_PER_TASK 1024
+
+namespace
+{
+	inline float GetSurfaceArea(const XMFLOAT3& kMin, const XMFLOAT3& kMax)
+	{
+		XMFLOAT3 extents = XMFLOAT3(kMax.x - kMin.x, kMax.y - kMin.y, kMax.z - kMin.z);
+
+		return 2.0f * (extents.x * extents.y + extents.y * extents.z + extents.z * extents.x);
+	}
+
+	inline void GrowBounds(XMFLOAT3& min, XMFLOAT3& max, const XMFLOAT3& kMin, const XMFLOAT3& kMax)
+	{
+		min = XMFLOAT3((std::min)(min.x, kMin.x), (std::min)(min.y, kMin.y), (std::min)(min.z, kMin.z));
+		max = XMFLOAT3((std::max)(max.x, kMax.x), (std::max)(max.y, kMax.y), (std::max)(max.z, kMax.z));
+	}
+
+	inline bool AnyTrue(FXMVECTOR mask)
+	{
+		return XMComparisonAnyTrue(XMVector4EqualIntR(mask, XMVectorTrueInt()));
+	}
+}
+
+CPUBVH::CPUBVH(ThreadPool* pThreadPool)
+{
+	m_pThreadPool = pThreadPool;
+	m_iNumNodes = 0;
+}
+
+void CPUBVH::Clear()
+{
+	m_Triangles.clear();
+	m_Sources.clear();
+	m_Nodes.clear();
+
+	m_iNumNodes = 0;
+}
+
+void CPUBVH::AddMesh(const Mesh* kpMesh, const XMFLOAT4X4& kWorld)
+{
+	Mesh* pMesh = const_cast<Mesh*>(kpMesh);
+
+	const BYTE* kpVertices = pMesh->GetVertexUploadBuffer()->GetMappedData();
+	UINT uiStride = pMesh->GetVertexUploadBuffer()->GetStride();
+	const UINT* kpuiIndices = pMesh->GetIndexUploadBuffer()->GetMappedData();
+
+	const std::vector<MeshNode*>* kpNodes = pMesh->GetNodes();
+
+	XMFLOAT4X4 world;
+
+	std::vector<XMFLOAT3> positions;
+
+	for (int i = 0; i < kpNodes->size(); ++i)
+	{
+		const MeshNode* kpNode = kpNodes->at(i);
+
+		XMStoreFloat4x4(&world, XMMatrixMultiply(XMLoadFloat4x4(&kpNode->m_Transform), XMLoadFloat4x4(&kWorld)));
+
+		for (int j = 0; j < kpNode->m_Primitives.size(); ++j)
+		{
+			const Primitive* kpPrimitive = kpNode->m_Primitives[j];
+
+			CPUTriangleSource source;
+			source.m_pMesh = kpMesh;
+			source.m_pPrimitive = kpPrimitive;
+			source.m_uiTriangle = 0;
+
+			const BYTE* kpPrimitiveVertices = kpVertices + (size_t)kpPrimitive->m_uiFirstVertex * uiStride;
+
+			//Indices are relative to the primitive's first vertex, the same as the bottom level acceleration structures
+			if (pMesh->GetVertexFormat() == VERTEX_FORMAT_QUANTIZED)
+			{
+				positions.resize(kpPrimitive->m_uiNumVertices);
+
+				VertexPackingHelper::UnpackPositions(kpPrimitiveVertices, kpPrimitive->m_uiNumVertices, VERTEX_FORMAT_QUANTIZED, kpPrimitive->m_PositionOffset, kpPrimitive->m_PositionScale, positions.data());
+
+				AddTriangles(positions.data(), sizeof(XMFLOAT3), &kpuiIndices[kpPrimitive->m_uiFirstIndex], kpPrimitive->m_uiNumIndices, world, source);
+			}
+			else
+			{
+				//Full and packed vertices both start with a float position
+				AddTriangles(reinterpret_cast<const XMFLOAT3*>(kpPrimitiveVertices), uiStride, &kpuiIndices[kpPrimitive->m_uiFirstIndex], kpPrimitive->m_uiNumIndices, world, source);
+			}
+		}
+	}
+}
+
+void CPUBVH::AddTriangles(const XMFLOAT3* kpPositions, UINT uiPositionStride, const UINT* kpuiIndices, UINT uiNumIndices, const XMFLOAT4X4& kWorld, const CPUTriangleSource& kSource)
+{
+	XMMATRIX world = XMLoadFloat4x4(&kWorld);
+
+	//Facing is worked out in object space on the GPU so mirrored instances need their winding flipping
+	bool bFlipWinding = XMVectorGetX(XMMatrixDeterminant(world)) < 0.0f;
+
+	const BYTE* kpPositionBytes = reinterpret_cast<const BYTE*>(kpPositions);
+
+	CPUTriangleSource source = kSource;
+
+	XMVECTOR vertices[3];
+
+	for (UINT i = 0; i + 2 < uiNumIndices; i += 3)
+	{
+		for (int j = 0; j < 3; ++j)
+		{
+			const XMFLOAT3* kpPosition = reinterpret_cast<const XMFLOAT3*>(kpPositionBytes + (size_t)kpuiIndices[i + j] * uiPositionStride);
+
+			vertices[j] = XMVector3TransformCoord(XMLoadFloat3(kpPosition), world);
+		}
+
+		if (bFlipWinding == true)
+		{
+			std::swap(vertices[1], vertices[2]);
+		}
+
+		CPUTriangle triangle;
+		XMStoreFloat3(&triangle.Vertex0, vertices[0]);
+		XMStoreFloat3(&triangle.Edge1, XMVectorSubtract(vertices[1], vertices[0]));
+		XMStoreFloat3(&triangle.Edge2, XMVectorSubtract(vertices[2], vertices[0]));
+
+		source.m_uiTriangle = i / 3;
+
+		m_Triangles.push_back(triangle);
+		m_Sources.push_back(source);
+	}
+}
+
+bool CPUBVH::Build()
+{
+	PROFILE("CPU BVH Build");
+
+	Timer timer;
+	timer.Reset();
+
+	int iNumTriangles = (int)m_Triangles.size();
+
+	if (iNumTriangles == 0)
+	{
+		LOG_WARNING(tag, L"Tried to build a BVH with no triangles!");
+
+		m_Nodes.clear();
+		m_iNumNodes = 0;
+
+		return false;
+	}
+
+	m_TriangleBounds.resize(iNumTriangles);
+	m_Centroids.resize(iNumTriangles);
+	m_TriangleIndices.resize(iNumTriangles);
+
+	std::function<void(int, int)> calculateBounds = [this](int iStart, int iEnd)
+	{
+		for (int i = iStart; i < iEnd; ++i)
+		{
+			const CPUTriangle& kTriangle = m_Triangles[i];
+
+			XMVECTOR vertex0 = XMLoadFloat3(&kTriangle.Vertex0);
+			XMVECTOR vertex1 = XMVectorAdd(vertex0, XMLoadFloat3(&kTriangle.Edge1));
+			XMVECTOR vertex2 = XMVectorAdd(vertex0, XMLoadFloat3(&kTriangle.Edge2));
+
+			XMVECTOR min = XMVectorMin(XMVectorMin(vertex0, vertex1), vertex2);
+			XMVECTOR max = XMVectorMax(XMVectorMax(vertex0, vertex1), vertex2);
+
+			XMStoreFloat3(&m_TriangleBounds[i].Min, min);
+			XMStoreFloat3(&m_TriangleBounds[i].Max, max);
+			XMStoreFloat3(&m_Centroids[i], XMVectorScale(XMVectorAdd(min, max), 0.5f));
+
+			m_TriangleIndices[i] = i;
+		}
+	};
+
+	if (m_pThreadPool != nullptr)
+	{
+		m_pThreadPool->ParallelFor(iNumTriangles, BVH_TRIANGLES_PER_TASK, calculateBounds);
+	}
+	else
+	{
+		calculateBounds(0, iNumTriangles);
+	}
+
+	//A binary tree with one triangle per leaf is the worst case
+	m_Nodes.resize((size_t)iNumTriangles * 2 - 1);
+	m_iNumNodes = 1;
+
+	BuildNode(0, 0, iNumTriangles);
+
+	m_Nodes.resize(m_iNumNodes);
+
+	//Reorder the triangles so leaves can index them directly when tracing
+	std::vector<CPUTriangle> triangles(iNumTriangles);
+	std::vector<CPUTriangleSource> sources(iNumTriangles);
+
+	for (int i = 0; i < iNumTriangles; ++i)
+	{
+		triangles[i] = m_Triangles[m_TriangleIndices[i]];
+		sources[i] = m_Sources[m_TriangleIndices[i]];
+	}
+
+	m_Triangles.swap(triangles);
+	m_Sources.swap(sources);
+
+	m_TriangleBounds.clear();
+	m_TriangleBounds.shrink_to_fit();
+	m_Centroids.clear();
+	m_Centroids.shrink_to_fit();
+	m_TriangleIndices.clear();
+	m_TriangleIndices.shrink_to_fit();
+
+	timer.Tick();
+
+	m_fLastBuildTime = timer.DeltaTime();
+
+	return true;
+}
+
+void CPUBVH::BuildNode(int iNodeIndex, int iFirst, int iCount)
+{
+	BVHNode& node = m_Nodes[iNodeIndex];
+
+	node.Min = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+	node.Max = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+	BuildBounds centroidBounds;
+	centroidBounds.Min = node.Min;
+	centroidBounds.Max = node.Max;
+
+	for (int i = iFirst; i < iFirst + iCount; ++i)
+	{
+		int iTriangleIndex = m_TriangleIndices[i];
+
+		GrowBounds(node.Min, node.Max, m_TriangleBounds[iTriangleIndex].Min, m_TriangleBounds[iTriangleIndex].Max);
+		GrowBounds(centroidBounds.Min, centroidBounds.Max, m_Centroids[iTriangleIndex], m_Centroids[iTriangleIndex]);
+	}
+
+	node.LeftFirst = iFirst;
+	node.Count = iCount;
+
+	if (iCount <= 2)
+	{
+		return;
+	}
+
+	BuildSplit split = FindSplit(iFirst, iCount, centroidBounds);
+
+	int iMid = iFirst + iCount / 2;
+
+	if (split.Axis != -1)
+	{
+		//Splitting has to be cheaper than intersecting every triangle in the node unless the leaf would be too big
+		float fLeafCost = iCount * GetSurfaceArea(node.Min, node.Max);
+
+		if (split.Cost >= fLeafCost && iCount <= BVH_MAX_LEAF_SIZE)
+		{
+			return;
+		}
+
+		iMid = (int)(std::partition(m_TriangleIndices.begin() + iFirst, m_TriangleIndices.begin() + iFirst + iCount, [this, &split](int iTriangleIndex)
+		{
+			return GetBin(split, iTriangleIndex) <= split.Bin;
+		}) - m_TriangleIndices.begin());
+	}
+	else if (iCount <= BVH_MAX_LEAF_SIZE)
+	{
+		//Every centroid is in the same place so there's nothing to split on
+		return;
+	}
+
+	if (iMid == iFirst || iMid == iFirst + iCount)
+	{
+		iMid = iFirst + iCount / 2;
+	}
+
+	int iLeftIndex = m_iNumNodes.fetch_add(2);
+
+	node.LeftFirst = iLeftIndex;
+	node.Count = 0;
+
+	int iLeftCount = iMid - iFirst;
+
+	if (m_pThreadPool != nullptr && iCount > BVH_PARALLEL_BUILD_SIZE)
+	{
+		m_pThreadPool->ParallelFor(2, 1, [this, iLeftIndex, iFirst, iMid, iLeftCount, iCount](int iStart, int iEnd)
+		{
+			for (int i = iStart; i < iEnd; ++i)
+			{
+				if (i == 0)
+				{
+					BuildNode(iLeftIndex, iFirst, iLeftCount);
+				}
+				else
+				{
+					BuildNode(iLeftIndex + 1, iMid, iCount - iLeftCount);
+				}
+			}
+		});
+	}
+	else
+	{
+		BuildNode(iLeftIndex, iFirst, iLeftCount);
+		BuildNode(iLeftIndex + 1, iMid, iCount - iLeftCount);
+	}
+}
+
+CPUBVH::BuildSplit CPUBVH::FindSplit(int iFirst, int iCount, const BuildBounds& kCentroidBounds) const
+{
+	BuildSplit bestSplit;
+
+	const float* kpfCentroidMin = &kCentroidBounds.Min.x;
+	const float* kpfCentroidMax = &kCentroidBounds.Max.x;
+
+	int binCounts[BVH_NUM_BINS];
+	BuildBounds binBounds[BVH_NUM_BINS];
+
+	float leftAreas[BVH_NUM_BINS - 1];
+	int leftCounts[BVH_NUM_BINS - 1];
+
+	for (int iAxis = 0; iAxis < 3; ++iAxis)
+	{
+		float fExtent = kpfCentroidMax[iAxis] - kpfCentroidMin[iAxis];
+
+		if (fExtent <= 0.0f)
+		{
+			continue;
+		}
+
+		BuildSplit split;
+		split.Axis = iAxis;
+		split.CentroidMin = kpfCentroidMin[iAxis];
+		split.BinScale = BVH_NUM_BINS / fExtent;
+
+		for (int i = 0; i < BVH_NUM_BINS; ++i)
+		{
+			binCounts[i] = 0;
+			binBounds[i].Min = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+			binBounds[i].Max = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		}
+
+		for (int i = iFirst; i < iFirst + iCount; ++i)
+		{
+			int iTriangleIndex = m_TriangleIndices[i];
+			int iBin = GetBin(split, iTriangleIndex);
+
+			++binCounts[iBin];
+			GrowBounds(binBounds[iBin].Min, binBounds[iBin].Max, m_TriangleBounds[iTriangleIndex].Min, m_TriangleBounds[iTriangleIndex].Max);
+		}
+
+		//Sweep from the left storing the cost of everything up to each split, then from the right to finish the cost
+		BuildBounds sweepBounds = binBounds[0];
+		int iSweepCount = 0;
+
+		for (int i = 0; i < BVH_NUM_BINS - 1; ++i)
+		{
+			GrowBounds(sweepBounds.Min, sweepBounds.Max, binBounds[i].Min, binBounds[i].Max);
+			iSweepCount += binCounts[i];
+
+			leftAreas[i] = iSweepCount > 0 ? GetSurfaceArea(sweepBounds.Min, sweepBounds.Max) : 0.0f;
+			leftCounts[i] = iSweepCount;
+		}
+
+		sweepBounds = binBounds[BVH_NUM_BINS - 1];
+		iSweepCount = 0;
+
+		for (int i = BVH_NUM_BINS - 1; i > 0; --i)
+		{
+			GrowBounds(sweepBounds.Min, sweepBounds.Max, binBounds[i].Min, binBounds[i].Max);
+			iSweepCount += binCounts[i];
+
+			if (iSweepCount == 0 || leftCounts[i - 1] == 0)
+			{
+				continue;
+			}
+
+			float fCost = leftAreas[i - 1] * leftCounts[i - 1] + GetSurfaceArea(sweepBounds.Min, sweepBounds.Max) * iSweepCount;
+
+			if (fCost < bestSplit.Cost)
+			{
+				bestSplit = split;
+				bestSplit.Bin = i - 1;
+				bestSplit.Cost = fCost;
+			}
+		}
+	}
+
+	return bestSplit;
+}
+
+int CPUBVH::GetBin(const BuildSplit& kSplit, int iTriangleIndex) const
+{
+	const float* kpfCentroid = &m_Centroids[iTriangleIndex].x;
+
+	int iBin = (int)((kpfCentroid[kSplit.Axis] - kSplit.CentroidMin) * kSplit.BinScale);
+
+	return (std::max)(0, (std::min)(iBin, BVH_NUM_BINS - 1));
+}
+
+CPUHit CPUBVH::Trace(const XMFLOAT3& kOrigin, const XMFLOAT3& kDirection, float fTMin, float fTMax) const
+{
+	CPURayPacket packet;
+	packet.OriginX = XMVectorReplicate(kOrigin.x);
+	packet.OriginY = XMVectorReplicate(kOrigin.y);
+	packet.OriginZ = XMVectorReplicate(kOrigin.z);
+	packet.DirectionX = XMVectorReplicate(kDirection.x);
+	packet.DirectionY = XMVectorReplicate(kDirection.y);
+	packet.DirectionZ = XMVectorReplicate(kDirection.z);
+	packet.TMin = XMVectorReplicate(fTMin);
+	packet.TMax = XMVectorReplicate(fTMax);
+	packet.ActiveMask = XMVectorSetInt(0xFFFFFFFF, 0, 0, 0);
+
+	CPUHit hits[4];
+
+	TracePacket(packet, hits);
+
+	return hits[0];
+}
+
+void CPUBVH::TracePacket(const CPURayPacket& kPacket, CPUHit hits[4]) const
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		hits[i] = CPUHit();
+	}
+
+	if (m_Nodes.size() == 0)
+	{
+		return;
+	}
+
+	XMVECTOR zero = XMVectorZero();
+	XMVECTOR one = XMVectorSplatOne();
+	XMVECTOR epsilon = XMVectorReplicate(1e-8f);
+
+	XMVECTOR invDirectionX = XMVectorReciprocal(kPacket.DirectionX);
+	XMVECTOR invDirectionY = XMVectorReciprocal(kPacket.DirectionY);
+	XMVECTOR invDirectionZ = XMVectorReciprocal(kPacket.DirectionZ);
+
+	XMVECTOR tMax = kPacket.TMax;
+	XMVECTOR hitU = zero;
+	XMVECTOR hitV = zero;
+	XMVECTOR hitDeterminant = zero;
+	XMVECTOR hitTriangle = XMVectorReplicateInt(0xFFFFFFFF);
+
+	//Used to decide which child to visit first, all rays in a probe packet share an origin so this is exact for them
+	XMFLOAT3 packetOrigin = XMFLOAT3(XMVectorGetX(kPacket.OriginX), XMVectorGetX(kPacket.OriginY), XMVectorGetX(kPacket.OriginZ));
+
+	int stack[BVH_MAX_STACK_SIZE];
+	int iStackSize = 0;
+
+	stack[iStackSize++] = 0;
+
+	while (iStackSize > 0)
+	{
+		const BVHNode& kNode = m_Nodes[stack[--iStackSize]];
+
+		//Slab test against every ray in the packet at once
+		XMVECTOR t1X = XMVectorMultiply(XMVectorSubtract(XMVectorReplicate(kNode.Min.x), kPacket.OriginX), invDirectionX);
+		XMVECTOR t2X = XMVectorMultiply(XMVectorSubtract(XMVectorReplicate(kNode.Max.x), kPacket.OriginX), invDirectionX);
+		XMVECTOR t1Y = XMVectorMultiply(XMVectorSubtract(XMVectorReplicate(kNode.Min.y), kPacket.OriginY), invDirectionY);
+		XMVECTOR t2Y = XMVectorMultiply(XMVectorSubtract(XMVectorReplicate(kNode.Max.y), kPacket.OriginY), invDirectionY);
+		XMVECTOR t1Z = XMVectorMultiply(XMVectorSubtract(XMVectorReplicate(kNode.Min.z), kPacket.OriginZ), invDirectionZ);
+		XMVECTOR t2Z = XMVectorMultiply(XMVectorSubtract(XMVectorReplicate(kNode.Max.z), kPacket.OriginZ), invDirectionZ);
+
+		XMVECTOR tEnter = XMVectorMax(XMVectorMax(XMVectorMin(t1X, t2X), XMVectorMin(t1Y, t2Y)), XMVectorMax(XMVectorMin(t1Z, t2Z), kPacket.TMin));
+		XMVECTOR tExit = XMVectorMin(XMVectorMin(XMVectorMax(t1X, t2X), XMVectorMax(t1Y, t2Y)), XMVectorMin(XMVectorMax(t1Z, t2Z), tMax));
+
+		if (AnyTrue(XMVectorAndInt(XMVectorLessOrEqual(tEnter, tExit), kPacket.ActiveMask)) == false)
+		{
+			continue;
+		}
+
+		if (kNode.Count == 0)
+		{
+			if (iStackSize + 2 > BVH_MAX_STACK_SIZE)
+			{
+				LOG_ERROR(tag, L"BVH traversal stack overflowed!");
+
+				break;
+			}
+
+			const BVHNode& kLeft = m_Nodes[kNode.LeftFirst];
+			const BVHNode& kRight = m_Nodes[kNode.LeftFirst + 1];
+
+			XMVECTOR origin = XMLoadFloat3(&packetOrigin);
+
+			float fLeftDistance = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(XMVectorScale(XMVectorAdd(XMLoadFloat3(&kLeft.Min), XMLoadFloat3(&kLeft.Max)), 0.5f), origin)));
+			float fRightDistance = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(XMVectorScale(XMVectorAdd(XMLoadFloat3(&kRight.Min), XMLoadFloat3(&kRight.Max)), 0.5f), origin)));
+
+			//Push the far child first so the near one is visited first
+			if (fLeftDistance < fRightDistance)
+			{
+				stack[iStackSize++] = kNode.LeftFirst + 1;
+				stack[iStackSize++] = kNode.LeftFirst;
+			}
+			else
+			{
+				stack[iStackSize++] = kNode.LeftFirst;
+				stack[iStackSize++] = kNode.LeftFirst + 1;
+			}
+
+			continue;
+		}
+
+		for (int i = kNode.LeftFirst; i < kNode.LeftFirst + kNode.Count; ++i)
+		{
+			const CPUTriangle& kTriangle = m_Triangles[i];
+
+			XMVECTOR edge1X = XMVectorReplicate(kTriangle.Edge1.x);
+			XMVECTOR edge1Y = XMVectorReplicate(kTriangle.Edge1.y);
+			XMVECTOR edge1Z = XMVectorReplicate(kTriangle.Edge1.z);
+			XMVECTOR edge2X = XMVectorReplicate(kTriangle.Edge2.x);
+			XMVECTOR edge2Y = XMVectorReplicate(kTriangle.Edge2.y);
+			XMVECTOR edge2Z = XMVectorReplicate(kTriangle.Edge2.z);
+
+			//Moller-Trumbore, no culling as backface hits have to be reported
+			XMVECTOR pX = XMVectorNegativeMultiplySubtract(kPacket.DirectionZ, edge2Y, XMVectorMultiply(kPacket.DirectionY, edge2Z));
+			XMVECTOR pY = XMVectorNegativeMultiplySubtract(kPacket.DirectionX, edge2Z, XMVectorMultiply(kPacket.DirectionZ, edge2X));
+			XMVECTOR pZ = XMVectorNegativeMultiplySubtract(kPacket.DirectionY, edge2X, XMVectorMultiply(kPacket.DirectionX, edge2Y));
+
+			XMVECTOR determinant = XMVectorMultiplyAdd(edge1X, pX, XMVectorMultiplyAdd(edge1Y, pY, XMVectorMultiply(edge1Z, pZ)));
+			XMVECTOR invDeterminant = XMVectorReciprocal(determinant);
+
+			XMVECTOR tX = XMVectorSubtract(kPacket.OriginX, XMVectorReplicate(kTriangle.Vertex0.x));
+			XMVECTOR tY = XMVectorSubtract(kPacket.OriginY, XMVectorReplicate(kTriangle.Vertex0.y));
+			XMVECTOR tZ = XMVectorSubtract(kPacket.OriginZ, XMVectorReplicate(kTriangle.Vertex0.z));
+
+			XMVECTOR u = XMVectorMultiply(XMVectorMultiplyAdd(tX, pX, XMVectorMultiplyAdd(tY, pY, XMVectorMultiply(tZ, pZ))), invDeterminant);
+
+			XMVECTOR qX = XMVectorNegativeMultiplySubtract(tZ, edge1Y, XMVectorMultiply(tY, edge1Z));
+			XMVECTOR qY = XMVectorNegativeMultiplySubtract(tX, edge1Z, XMVectorMultiply(tZ, edge1X));
+			XMVECTOR qZ = XMVectorNegativeMultiplySubtract(tY, edge1X, XMVectorMultiply(tX, edge1Y));
+
+			XMVECTOR v = XMVectorMultiply(XMVectorMultiplyAdd(kPacket.DirectionX, qX, XMVectorMultiplyAdd(kPacket.DirectionY, qY, XMVectorMultiply(kPacket.DirectionZ, qZ))), invDeterminant);
+			XMVECTOR t = XMVectorMultiply(XMVectorMultiplyAdd(edge2X, qX, XMVectorMultiplyAdd(edge2Y, qY, XMVectorMultiply(edge2Z, qZ))), invDeterminant);
+
+			XMVECTOR hitMask = XMVectorAndInt(kPacket.ActiveMask, XMVectorGreater(XMVectorAbs(determinant), epsilon));
+			hitMask = XMVectorAndInt(hitMask, XMVectorGreaterOrEqual(u, zero));
+			hitMask = XMVectorAndInt(hitMask, XMVectorGreaterOrEqual(v, zero));
+			hitMask = XMVectorAndInt(hitMask, XMVectorLessOrEqual(XMVectorAdd(u, v), one));
+			hitMask = XMVectorAndInt(hitMask, XMVectorGreaterOrEqual(t, kPacket.TMin));
+			hitMask = XMVectorAndInt(hitMask, XMVectorLess(t, tMax));
+
+			if (AnyTrue(hitMask) == false)
+			{
+				continue;
+			}
+
+			tMax = XMVectorSelect(tMax, t, hitMask);
+			hitU = XMVectorSelect(hitU, u, hitMask);
+			hitV = XMVectorSelect(hitV, v, hitMask);
+			hitDeterminant = XMVectorSelect(hitDeterminant, determinant, hitMask);
+			hitTriangle = XMVectorSelect(hitTriangle, XMVectorReplicateInt((UINT32)i), hitMask);
+		}
+	}
+
+	XMFLOAT4 distances;
+	XMFLOAT4 us;
+	XMFLOAT4 vs;
+	XMFLOAT4 determinants;
+	XMUINT4 triangles;
+
+	XMStoreFloat4(&distances, tMax);
+	XMStoreFloat4(&us, hitU);
+	XMStoreFloat4(&vs, hitV);
+	XMStoreFloat4(&determinants, hitDeterminant);
+	XMStoreInt4(&triangles.x, hitTriangle);
+
+	for (int i = 0; i < 4; ++i)
+	{
+		int iTriangle = (int)(&triangles.x)[i];
+
+		if (iTriangle == -1)
+		{
+			continue;
+		}
+
+		hits[i].Distance = (&distances.x)[i];
+		hits[i].BarycentricU = (&us.x)[i];
+		hits[i].BarycentricV = (&vs.x)[i];
+		hits[i].TriangleIndex = iTriangle;
+
+		//DXR treats clockwise triangles as front facing which gives a positive determinant here
+		hits[i].FrontFace = (&determinants.x)[i] > 0.0f;
+	}
+}
+
+const CPUTriangleSource& CPUBVH::GetTriangleSource(int iTriangleIndex) const
+{
+	return m_Sources[iTriangleIndex];
+}
+
+XMFLOAT3 CPUBVH::GetGeometricNormal(int iTriangleIndex) const
+{
+	const CPUTriangle& kTriangle = m_Triangles[iTriangleIndex];
+
+	XMFLOAT3 normal;
+	XMStoreFloat3(&normal, XMVector3Normalize(XMVector3Cross(XMLoadFloat3(&kTriangle.Edge1), XMLoadFloat3(&kTriangle.Edge2))));
+
+	return normal;
+}
+
+UINT CPUBVH::GetNumTriangles() const
+{
+	return (UINT)m_Triangles.size();
+}
+
+UINT CPUBVH::GetNumNodes() const
+{
+	return (UINT)m_Nodes.size();
+}
+
+float CPUBVH::GetLastBuildTime() const
+{
+	return m_fLastBuildTime;
+}
+
+void CPUBVH::SetThreadPool(ThreadPool* pThreadPool)
+{
+	m_pThreadPool = pThreadPool;
+}
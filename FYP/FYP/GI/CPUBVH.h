@@ -0,0 +1,139 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <DirectXMath.h>
+
+#include <atomic>
+#include <float.h>
+#include <vector>
+
+class Mesh;
+class ThreadPool;
+
+struct Primitive;
+
+//Result of tracing a single ray against the BVH. Distance is negative on a miss, matching the payload in Miss.hlsl.
+struct CPUHit
+{
+	float Distance = -1.0f;
+	float BarycentricU = 0.0f;
+	float BarycentricV = 0.0f;
+
+	int TriangleIndex = -1;
+
+	bool FrontFace = false;
+};
+
+//Four rays traced together, stored one component per vector so each lane is a ray
+struct CPURayPacket
+{
+	DirectX::XMVECTOR OriginX;
+	DirectX::XMVECTOR OriginY;
+	DirectX::XMVECTOR OriginZ;
+
+	DirectX::XMVECTOR DirectionX;
+	DirectX::XMVECTOR DirectionY;
+	DirectX::XMVECTOR DirectionZ;
+
+	DirectX::XMVECTOR TMin;
+	DirectX::XMVECTOR TMax;
+
+	DirectX::XMVECTOR ActiveMask;	//All bits set for lanes holding a ray
+};
+
+//World space triangle soup built from MeshManager meshes. Triangles are stored as a vertex and two edges so the
+//intersection test can use them straight away.
+struct CPUTriangle
+{
+	DirectX::XMFLOAT3 Vertex0;
+	DirectX::XMFLOAT3 Edge1;
+	DirectX::XMFLOAT3 Edge2;
+};
+
+//Where a triangle came from so hits can be shaded
+struct CPUTriangleSource
+{
+	const Mesh* m_pMesh;
+	const Primitive* m_pPrimitive;
+
+	UINT m_uiTriangle;	//Index of the triangle within the primitive, the same as PrimitiveIndex() in the hit shaders
+};
+
+//Bounding volume hierarchy over world space triangles built with a binned surface area heuristic. Children are always
+//allocated as a pair so a node only has to store the index of its left child.
+class CPUBVH
+{
+public:
+	CPUBVH(ThreadPool* pThreadPool = nullptr);
+
+	void Clear();
+
+	//Adds every primitive in the mesh, using each node's transform followed by the world matrix like App::CreateTLAS
+	void AddMesh(const Mesh* kpMesh, const DirectX::XMFLOAT4X4& kWorld);
+
+	void AddTriangles(const DirectX::XMFLOAT3* kpPositions, UINT uiPositionStride, const UINT* kpuiIndices, UINT uiNumIndices, const DirectX::XMFLOAT4X4& kWorld, const CPUTriangleSource& kSource);
+
+	bool Build();
+
+	CPUHit Trace(const DirectX::XMFLOAT3& kOrigin, const DirectX::XMFLOAT3& kDirection, float fTMin, float fTMax) const;
+	void TracePacket(const CPURayPacket& kPacket, CPUHit hits[4]) const;
+
+	const CPUTriangleSource& GetTriangleSource(int iTriangleIndex) const;
+	DirectX::XMFLOAT3 GetGeometricNormal(int iTriangleIndex) const;
+
+	UINT GetNumTriangles() const;
+	UINT GetNumNodes() const;
+
+	float GetLastBuildTime() const;	//In seconds
+
+	void SetThreadPool(ThreadPool* pThreadPool);
+
+protected:
+
+private:
+	struct BVHNode
+	{
+		DirectX::XMFLOAT3 Min;
+		int LeftFirst;	//Index of the left child, or of the first triangle for leaves
+		DirectX::XMFLOAT3 Max;
+		int Count;		//Number of triangles, 0 for interior nodes
+	};
+
+	struct BuildBounds
+	{
+		DirectX::XMFLOAT3 Min;
+		DirectX::XMFLOAT3 Max;
+	};
+
+	struct BuildSplit
+	{
+		int Axis = -1;
+		int Bin = 0;
+
+		float CentroidMin = 0.0f;
+		float BinScale = 0.0f;
+
+		float Cost = FLT_MAX;
+	};
+
+	void BuildNode(int iNodeIndex, int iFirst, int iCount);
+
+	BuildSplit FindSplit(int iFirst, int iCount, const BuildBounds& kCentroidBounds) const;
+	int GetBin(const BuildSplit& kSplit, int iTriangleIndex) const;
+
+	std::vector<CPUTriangle> m_Triangles;
+	std::vector<CPUTriangleSource> m_Sources;
+
+	//Build time only
+	std::vector<BuildBounds> m_TriangleBounds;
+	std::vector<DirectX::XMFLOAT3> m_Centroids;
+	std::vector<int> m_TriangleIndices;
+
+	std::vector<BVHNode> m_Nodes;
+	std::atomic<int> m_iNumNodes;
+
+	ThreadPool* m_pThreadPool = nullptr;
+
+	float m_fLastBuildTime = 0.0f;
+};
@@ -0,0 +1,470 @@
+#include "CPUIrradianceQuery.h"
+#include "CPUSHProjector.h"
+#include "Commons/ThreadPool.h"
+#include "Commons/Timer.h"
+#include "Helpers/ProbeHelper.h"
+#include "Helpers/DebugHelper.h"
+#include "Shaders/Defines.hlsli"
+
+#include <algorithm>
+#include <functional>
+#include <math.h>
+
+using namespace DirectX;
+
+Tag tag = L"CPUIrradianceQuery";
+
+#define QUERIES_PER_TASK 64
+
+namespace
+{
+	inline float HorizontalAdd(FXMVECTOR vector)
+	{
+		return XMVectorGetX(vector) + XMVectorGetY(vector) + XMVectorGetZ(vector) + XMVectorGetW(vector);
+	}
+
+	inline float Length(const XMFLOAT3& kVector)
+	{
+		return sqrtf(kVector.x * kVector.x + kVector.y * kVector.y + kVector.z * kVector.z);
+	}
+
+	inline float Lerp(float fA, float fB, float fT)
+	{
+		return fA + (fB - fA) * fT;
+	}
+
+	inline float Clamp(float fValue, float fMin, float fMax)
+	{
+		return (std::max)(fMin, (std::min)(fValue, fMax));
+	}
+}
+
+CPUIrradianceQuery::CPUIrradianceQuery(ThreadPool* pThreadPool)
+{
+	m_pThreadPool = pThreadPool;
+}
+
+void CPUIrradianceQuery::QueryIrradiance(const RaytracePerFrameCB& kParams, const CPUAtlas& kIrradianceAtlas, const CPUAtlas& kDistanceAtlas, const CPUAtlas* kpProbeData, const XMFLOAT3& kEyePosW, const std::vector<IrradianceQuery>& kQueries, std::vector<XMFLOAT4>& results)
+{
+	PROFILE("CPU Irradiance Queries");
+
+	Timer timer;
+	timer.Reset();
+
+	int iNumQueries = (int)kQueries.size();
+
+	results.resize(iNumQueries);
+
+	if (kParams.ProbeClassification == 0 && kParams.ProbeRelocation == 0)
+	{
+		kpProbeData = nullptr;
+	}
+
+	std::function<void(int, int)> queryPoints = [this, &kParams, &kIrradianceAtlas, &kDistanceAtlas, kpProbeData, &kEyePosW, &kQueries, &results](int iStart, int iEnd)
+	{
+		for (int i = iStart; i < iEnd; ++i)
+		{
+			const IrradianceQuery& kQuery = kQueries[i];
+
+			XMFLOAT3 cameraDirection = ProbeHelper::Normalize(XMFLOAT3(kQuery.PosW.x - kEyePosW.x, kQuery.PosW.y - kEyePosW.y, kQuery.PosW.z - kEyePosW.z));
+			XMFLOAT3 surfaceBias = GetSurfaceBias(kQuery.NormalW, cameraDirection, kParams.NormalBias, kParams.ViewBias);
+
+			results[i] = QueryPoint(kQuery.PosW, surfaceBias, kQuery.NormalW, kParams, kIrradianceAtlas, kDistanceAtlas, kpProbeData);
+		}
+	};
+
+	if (m_pThreadPool != nullptr)
+	{
+		m_pThreadPool->ParallelFor(iNumQueries, QUERIES_PER_TASK, queryPoints);
+	}
+	else
+	{
+		queryPoints(0, iNumQueries);
+	}
+
+	timer.Tick();
+
+	m_LastQueryStats.NumQueries = iNumQueries;
+	m_LastQueryStats.NumThreads = m_pThreadPool != nullptr ? m_pThreadPool->GetNumThreads() + 1 : 1;	//The calling thread helps out as well
+	m_LastQueryStats.Seconds = timer.DeltaTime();
+}
+
+XMFLOAT4 CPUIrradianceQuery::GetIrradiance(const XMFLOAT3& kPosW, const XMFLOAT3& kSurfaceBias, const XMFLOAT3& kDirection, const RaytracePerFrameCB& kParams, const CPUAtlas& kIrradianceAtlas, const CPUAtlas& kDistanceAtlas, const CPUAtlas* kpProbeData)
+{
+	XMFLOAT3 biasedPosW = XMFLOAT3(kPosW.x + kSurfaceBias.x, kPosW.y + kSurfaceBias.y, kPosW.z + kSurfaceBias.z);
+	XMINT3 closestProbeCoords = ProbeHelper::GetClosestProbeCoords(biasedPosW, kParams.VolumePosition, kParams.ProbeOffsets, kParams.ProbeSpacing, kParams.ProbeCounts);
+	XMFLOAT3 closestProbeCoordsWorld = ProbeHelper::GetProbeCoordsWorld(closestProbeCoords, kParams.VolumePosition, kParams.ProbeOffsets, kParams.ProbeSpacing, kParams.ProbeCounts);
+
+	XMFLOAT3 distanceRatio;
+	distanceRatio.x = Clamp((biasedPosW.x - closestProbeCoordsWorld.x) / kParams.ProbeSpacing.x, 0.0f, 1.0f);
+	distanceRatio.y = Clamp((biasedPosW.y - closestProbeCoordsWorld.y) / kParams.ProbeSpacing.y, 0.0f, 1.0f);
+	distanceRatio.z = Clamp((biasedPosW.z - closestProbeCoordsWorld.z) / kParams.ProbeSpacing.z, 0.0f, 1.0f);
+
+	XMFLOAT4 irradiance = XMFLOAT4(0, 0, 0, 0);
+	float fAccumulatedWeights = 0;
+	float fAccumulatedDistanceWeights = 0;
+
+	for (int i = 0; i < 8; ++i)
+	{
+		XMINT3 probeOffset = XMINT3(i & 1, (i >> 1) & 1, (i >> 2) & 1);
+		XMINT3 probeCoords;
+		probeCoords.x = (std::min)(closestProbeCoords.x + probeOffset.x, kParams.ProbeCounts.x - 1);
+		probeCoords.y = (std::min)(closestProbeCoords.y + probeOffset.y, kParams.ProbeCounts.y - 1);
+		probeCoords.z = (std::min)(closestProbeCoords.z + probeOffset.z, kParams.ProbeCounts.z - 1);
+
+		int iProbeIndex = ProbeHelper::GetOffsettedProbeIndex(probeCoords, kParams.ProbeCounts, kParams.ProbeOffsets);
+
+		XMFLOAT4 probeData = XMFLOAT4(0, 0, 0, PROBE_STATE_ACTIVE);
+
+		if (kpProbeData != nullptr)
+		{
+			XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(iProbeIndex, kParams.ProbeCounts, kParams.AtlasLayout);
+			probeData = kpProbeData->GetTexel(dataCoords.x, dataCoords.y);
+		}
+
+		if (kParams.ProbeClassification == true && probeData.w != PROBE_STATE_ACTIVE)
+		{
+			continue;
+		}
+
+		XMFLOAT3 probeCoordsWorld = ProbeHelper::GetProbeCoordsWorld(probeCoords, kParams.VolumePosition, kParams.ProbeOffsets, kParams.ProbeSpacing, kParams.ProbeCounts);
+
+		if (kParams.ProbeRelocation == true)
+		{
+			probeCoordsWorld.x += probeData.x * kParams.ProbeSpacing.x;
+			probeCoordsWorld.y += probeData.y * kParams.ProbeSpacing.y;
+			probeCoordsWorld.z += probeData.z * kParams.ProbeSpacing.z;
+		}
+
+		XMFLOAT3 toProbe = ProbeHelper::Normalize(XMFLOAT3(probeCoordsWorld.x - kPosW.x, probeCoordsWorld.y - kPosW.y, probeCoordsWorld.z - kPosW.z));
+		XMFLOAT3 biasedToProbe = XMFLOAT3(probeCoordsWorld.x - biasedPosW.x, probeCoordsWorld.y - biasedPosW.y, probeCoordsWorld.z - biasedPosW.z);
+
+		float fBiasedToProbeDistance = Length(biasedToProbe);
+
+		biasedToProbe = XMFLOAT3(biasedToProbe.x / fBiasedToProbeDistance, biasedToProbe.y / fBiasedToProbeDistance, biasedToProbe.z / fBiasedToProbeDistance);
+
+		XMFLOAT3 trilinear;
+		trilinear.x = (std::max)(0.001f, Lerp(1.0f - distanceRatio.x, distanceRatio.x, (float)probeOffset.x));
+		trilinear.y = (std::max)(0.001f, Lerp(1.0f - distanceRatio.y, distanceRatio.y, (float)probeOffset.y));
+		trilinear.z = (std::max)(0.001f, Lerp(1.0f - distanceRatio.z, distanceRatio.z, (float)probeOffset.z));
+
+		float fWrapShading = (1.0f + toProbe.x * kDirection.x + toProbe.y * kDirection.y + toProbe.z * kDirection.z) * 0.5f;
+
+		float fWeight = fWrapShading * fWrapShading + 0.2f;
+
+		XMFLOAT2 octCoords = ProbeHelper::GetOctahedralCoords(XMFLOAT3(-biasedToProbe.x, -biasedToProbe.y, -biasedToProbe.z));
+		XMFLOAT2 atlasCoords = ProbeHelper::GetAtlasCoords(iProbeIndex, octCoords, kParams.NumDistanceTexels, kParams.ProbeCounts, kParams.AtlasLayout);
+
+		//R component is distance, G component is distance squared
+		XMFLOAT4 distanceSample = SampleLinearWrap(kDistanceAtlas, atlasCoords);
+		XMFLOAT2 distance = XMFLOAT2(2.0f * distanceSample.x, 2.0f * distanceSample.y);
+
+		float fVariance = fabsf(distance.x * distance.x - distance.y);
+
+		float fChebyshevWeight = 1.0f;
+		if (fBiasedToProbeDistance > distance.x)
+		{
+			float fV = fBiasedToProbeDistance - distance.x;
+			fChebyshevWeight = fVariance / (fV * fV + fVariance);
+
+			fChebyshevWeight = (std::max)(fChebyshevWeight * fChebyshevWeight * fChebyshevWeight, 0.0f);
+		}
+
+		fWeight *= (std::max)(0.05f, fChebyshevWeight);
+		fWeight = (std::max)(0.000001f, fWeight);
+
+		const float kfCrushThreshold = 0.2f;
+		if (fWeight < kfCrushThreshold)
+		{
+			fWeight *= (fWeight * fWeight) / (kfCrushThreshold * kfCrushThreshold);
+		}
+
+		float fTrilinearWeight = trilinear.x * trilinear.y * trilinear.z;
+		fWeight *= fTrilinearWeight;
+
+		XMFLOAT4 probeIrradiance;
+
+		if (kParams.IrradianceEncoding == PROBE_IRRADIANCE_ENCODING_OCTAHEDRAL)
+		{
+			octCoords = ProbeHelper::GetOctahedralCoords(kDirection);
+			atlasCoords = ProbeHelper::GetAtlasCoords(iProbeIndex, octCoords, kParams.NumIrradianceTexels, kParams.ProbeCounts, kParams.AtlasLayout);
+
+			probeIrradiance = SampleLinearWrap(kIrradianceAtlas, atlasCoords);
+			probeIrradiance.x = powf(probeIrradiance.x, kParams.IrradianceGammaEncoding * 0.5f);
+			probeIrradiance.y = powf(probeIrradiance.y, kParams.IrradianceGammaEncoding * 0.5f);
+			probeIrradiance.z = powf(probeIrradiance.z, kParams.IrradianceGammaEncoding * 0.5f);
+		}
+		else
+		{
+			XMFLOAT3 shIrradiance = CPUSHProjector::EvaluateIrradiance(iProbeIndex, kDirection, kParams, kIrradianceAtlas);
+
+			probeIrradiance.x = sqrtf((std::max)(shIrradiance.x, 0.0f));
+			probeIrradiance.y = sqrtf((std::max)(shIrradiance.y, 0.0f));
+			probeIrradiance.z = sqrtf((std::max)(shIrradiance.z, 0.0f));
+		}
+
+		irradiance.x += fWeight * probeIrradiance.x;
+		irradiance.y += fWeight * probeIrradiance.y;
+		irradiance.z += fWeight * probeIrradiance.z;
+		irradiance.w += fTrilinearWeight * distance.x;
+
+		fAccumulatedWeights += fWeight;
+		fAccumulatedDistanceWeights += fTrilinearWeight;
+	}
+
+	if (fAccumulatedWeights == 0.0f)
+	{
+		return XMFLOAT4(0, 0, 0, -1);
+	}
+
+	float fScale = kParams.IrradianceEncoding == PROBE_IRRADIANCE_ENCODING_OCTAHEDRAL && kParams.IrradianceFormat == FORMAT_PROBE_IRRADIANCE_R10G10B10A2_FLOAT ? 1.0989f : 1.0f;
+
+	irradiance.x /= fAccumulatedWeights;
+	irradiance.y /= fAccumulatedWeights;
+	irradiance.z /= fAccumulatedWeights;
+	irradiance.x *= irradiance.x * XM_2PI * fScale;
+	irradiance.y *= irradiance.y * XM_2PI * fScale;
+	irradiance.z *= irradiance.z * XM_2PI * fScale;
+
+	irradiance.w *= 1.0f / fAccumulatedDistanceWeights;
+
+	return irradiance;
+}
+
+XMFLOAT3 CPUIrradianceQuery::GetSurfaceBias(const XMFLOAT3& kNormal, const XMFLOAT3& kCameraDirection, float fNormalBias, float fViewBias)
+{
+	return XMFLOAT3(
+		(kNormal.x * fNormalBias) + (-kCameraDirection.x * fViewBias),
+		(kNormal.y * fNormalBias) + (-kCameraDirection.y * fViewBias),
+		(kNormal.z * fNormalBias) + (-kCameraDirection.z * fViewBias));
+}
+
+XMFLOAT4 CPUIrradianceQuery::SampleLinearWrap(const CPUAtlas& kAtlas, const XMFLOAT2& kUV)
+{
+	//Texel centres are at half texel offsets
+	float fX = kUV.x * kAtlas.Width - 0.5f;
+	float fY = kUV.y * kAtlas.Height - 0.5f;
+
+	float fFloorX = floorf(fX);
+	float fFloorY = floorf(fY);
+
+	int iX0 = (((int)fFloorX % kAtlas.Width) + kAtlas.Width) % kAtlas.Width;
+	int iY0 = (((int)fFloorY % kAtlas.Height) + kAtlas.Height) % kAtlas.Height;
+	int iX1 = (iX0 + 1) % kAtlas.Width;
+	int iY1 = (iY0 + 1) % kAtlas.Height;
+
+	XMVECTOR top = XMVectorLerp(XMLoadFloat4(&kAtlas.GetTexel(iX0, iY0)), XMLoadFloat4(&kAtlas.GetTexel(iX1, iY0)), fX - fFloorX);
+	XMVECTOR bottom = XMVectorLerp(XMLoadFloat4(&kAtlas.GetTexel(iX0, iY1)), XMLoadFloat4(&kAtlas.GetTexel(iX1, iY1)), fX - fFloorX);
+
+	XMFLOAT4 sample;
+	XMStoreFloat4(&sample, XMVectorLerp(top, bottom, fY - fFloorY));
+
+	return sample;
+}
+
+void CPUIrradianceQuery::SetThreadPool(ThreadPool* pThreadPool)
+{
+	m_pThreadPool = pThreadPool;
+}
+
+const CPUQueryStats& CPUIrradianceQuery::GetLastQueryStats() const
+{
+	return m_LastQueryStats;
+}
+
+XMFLOAT4 CPUIrradianceQuery::QueryPoint(const XMFLOAT3& kPosW, const XMFLOAT3& kSurfaceBias, const XMFLOAT3& kDirection, const RaytracePerFrameCB& kParams, const CPUAtlas& kIrradianceAtlas, const CPUAtlas& kDistanceAtlas, const CPUAtlas* kpProbeData) const
+{
+	XMFLOAT3 biasedPosW = XMFLOAT3(kPosW.x + kSurfaceBias.x, kPosW.y + kSurfaceBias.y, kPosW.z + kSurfaceBias.z);
+	XMINT3 closestProbeCoords = ProbeHelper::GetClosestProbeCoords(biasedPosW, kParams.VolumePosition, kParams.ProbeOffsets, kParams.ProbeSpacing, kParams.ProbeCounts);
+	XMFLOAT3 closestProbeCoordsWorld = ProbeHelper::GetProbeCoordsWorld(closestProbeCoords, kParams.VolumePosition, kParams.ProbeOffsets, kParams.ProbeSpacing, kParams.ProbeCounts);
+
+	XMVECTOR distanceRatioX = XMVectorReplicate(Clamp((biasedPosW.x - closestProbeCoordsWorld.x) / kParams.ProbeSpacing.x, 0.0f, 1.0f));
+	XMVECTOR distanceRatioY = XMVectorReplicate(Clamp((biasedPosW.y - closestProbeCoordsWorld.y) / kParams.ProbeSpacing.y, 0.0f, 1.0f));
+	XMVECTOR distanceRatioZ = XMVectorReplicate(Clamp((biasedPosW.z - closestProbeCoordsWorld.z) / kParams.ProbeSpacing.z, 0.0f, 1.0f));
+
+	//The direction is the same for every probe so only the atlas coords change
+	XMFLOAT2 irradianceOctCoords = ProbeHelper::GetOctahedralCoords(kDirection);
+
+	const XMVECTOR kZero = XMVectorZero();
+	const XMVECTOR kOne = XMVectorSplatOne();
+	const XMVECTOR kHalf = XMVectorReplicate(0.5f);
+	const XMVECTOR kCrushThreshold = XMVectorReplicate(0.2f);
+	const bool kbOctahedral = kParams.IrradianceEncoding == PROBE_IRRADIANCE_ENCODING_OCTAHEDRAL;
+
+	//SH is stored linear so only needs the square root the octahedral path gets from halving the gamma
+	const XMVECTOR kGamma = XMVectorReplicate(kbOctahedral == true ? kParams.IrradianceGammaEncoding * 0.5f : 0.5f);
+
+	XMVECTOR irradianceR = kZero;
+	XMVECTOR irradianceG = kZero;
+	XMVECTOR irradianceB = kZero;
+	XMVECTOR distances = kZero;
+	XMVECTOR accumulatedWeights = kZero;
+	XMVECTOR accumulatedDistanceWeights = kZero;
+
+	//The eight probes around the query are weighted as two packets of four
+	for (int iPacket = 0; iPacket < 8; iPacket += 4)
+	{
+		XMFLOAT4 probeX;
+		XMFLOAT4 probeY;
+		XMFLOAT4 probeZ;
+		XMFLOAT4 probeOffsetX;
+		XMFLOAT4 probeOffsetY;
+		XMFLOAT4 probeOffsetZ;
+		XMUINT4 activeMask;
+
+		int probeIndices[4];
+
+		for (int i = 0; i < 4; ++i)
+		{
+			int iCorner = iPacket + i;
+
+			XMINT3 probeOffset = XMINT3(iCorner & 1, (iCorner >> 1) & 1, (iCorner >> 2) & 1);
+			XMINT3 probeCoords;
+			probeCoords.x = (std::min)(closestProbeCoords.x + probeOffset.x, kParams.ProbeCounts.x - 1);
+			probeCoords.y = (std::min)(closestProbeCoords.y + probeOffset.y, kParams.ProbeCounts.y - 1);
+			probeCoords.z = (std::min)(closestProbeCoords.z + probeOffset.z, kParams.ProbeCounts.z - 1);
+
+			probeIndices[i] = ProbeHelper::GetOffsettedProbeIndex(probeCoords, kParams.ProbeCounts, kParams.ProbeOffsets);
+
+			XMFLOAT4 probeData = XMFLOAT4(0, 0, 0, PROBE_STATE_ACTIVE);
+
+			if (kpProbeData != nullptr)
+			{
+				XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(probeIndices[i], kParams.ProbeCounts, kParams.AtlasLayout);
+				probeData = kpProbeData->GetTexel(dataCoords.x, dataCoords.y);
+			}
+
+			(&activeMask.x)[i] = kParams.ProbeClassification == true && probeData.w != PROBE_STATE_ACTIVE ? 0 : 0xFFFFFFFF;
+
+			XMFLOAT3 probeCoordsWorld = ProbeHelper::GetProbeCoordsWorld(probeCoords, kParams.VolumePosition, kParams.ProbeOffsets, kParams.ProbeSpacing, kParams.ProbeCounts);
+
+			if (kParams.ProbeRelocation == true)
+			{
+				probeCoordsWorld.x += probeData.x * kParams.ProbeSpacing.x;
+				probeCoordsWorld.y += probeData.y * kParams.ProbeSpacing.y;
+				probeCoordsWorld.z += probeData.z * kParams.ProbeSpacing.z;
+			}
+
+			(&probeX.x)[i] = probeCoordsWorld.x;
+			(&probeY.x)[i] = probeCoordsWorld.y;
+			(&probeZ.x)[i] = probeCoordsWorld.z;
+			(&probeOffsetX.x)[i] = (float)probeOffset.x;
+			(&probeOffsetY.x)[i] = (float)probeOffset.y;
+			(&probeOffsetZ.x)[i] = (float)probeOffset.z;
+		}
+
+		XMVECTOR active = XMLoadInt4(&activeMask.x);
+
+		XMVECTOR toProbeX = XMVectorSubtract(XMLoadFloat4(&probeX), XMVectorReplicate(kPosW.x));
+		XMVECTOR toProbeY = XMVectorSubtract(XMLoadFloat4(&probeY), XMVectorReplicate(kPosW.y));
+		XMVECTOR toProbeZ = XMVectorSubtract(XMLoadFloat4(&probeZ), XMVectorReplicate(kPosW.z));
+		XMVECTOR toProbeLength = XMVectorSqrt(XMVectorMultiplyAdd(toProbeX, toProbeX, XMVectorMultiplyAdd(toProbeY, toProbeY, XMVectorMultiply(toProbeZ, toProbeZ))));
+
+		XMVECTOR biasedToProbeX = XMVectorSubtract(XMLoadFloat4(&probeX), XMVectorReplicate(biasedPosW.x));
+		XMVECTOR biasedToProbeY = XMVectorSubtract(XMLoadFloat4(&probeY), XMVectorReplicate(biasedPosW.y));
+		XMVECTOR biasedToProbeZ = XMVectorSubtract(XMLoadFloat4(&probeZ), XMVectorReplicate(biasedPosW.z));
+		XMVECTOR biasedToProbeDistance = XMVectorSqrt(XMVectorMultiplyAdd(biasedToProbeX, biasedToProbeX, XMVectorMultiplyAdd(biasedToProbeY, biasedToProbeY, XMVectorMultiply(biasedToProbeZ, biasedToProbeZ))));
+
+		//Only the direction is needed for the octahedral coords so there is no need to normalise biasedToProbe
+		XMVECTOR wrapShading = XMVectorMultiplyAdd(toProbeX, XMVectorReplicate(kDirection.x), XMVectorMultiplyAdd(toProbeY, XMVectorReplicate(kDirection.y), XMVectorMultiply(toProbeZ, XMVectorReplicate(kDirection.z))));
+		wrapShading = XMVectorMultiply(XMVectorAdd(kOne, XMVectorDivide(wrapShading, toProbeLength)), kHalf);
+
+		XMVECTOR weights = XMVectorMultiplyAdd(wrapShading, wrapShading, XMVectorReplicate(0.2f));
+
+		XMVECTOR trilinear = XMVectorMax(XMVectorReplicate(0.001f), XMVectorLerpV(XMVectorSubtract(kOne, distanceRatioX), distanceRatioX, XMLoadFloat4(&probeOffsetX)));
+		trilinear = XMVectorMultiply(trilinear, XMVectorMax(XMVectorReplicate(0.001f), XMVectorLerpV(XMVectorSubtract(kOne, distanceRatioY), distanceRatioY, XMLoadFloat4(&probeOffsetY))));
+		trilinear = XMVectorMultiply(trilinear, XMVectorMax(XMVectorReplicate(0.001f), XMVectorLerpV(XMVectorSubtract(kOne, distanceRatioZ), distanceRatioZ, XMLoadFloat4(&probeOffsetZ))));
+
+		//Atlas reads are gathers so are done a probe at a time
+		XMFLOAT4 biasedX;
+		XMFLOAT4 biasedY;
+		XMFLOAT4 biasedZ;
+		XMStoreFloat4(&biasedX, biasedToProbeX);
+		XMStoreFloat4(&biasedY, biasedToProbeY);
+		XMStoreFloat4(&biasedZ, biasedToProbeZ);
+
+		XMFLOAT4 meanDistance = XMFLOAT4(0, 0, 0, 0);
+		XMFLOAT4 meanDistanceSquared = XMFLOAT4(0, 0, 0, 0);
+		XMFLOAT4 sampleR = XMFLOAT4(0, 0, 0, 0);
+		XMFLOAT4 sampleG = XMFLOAT4(0, 0, 0, 0);
+		XMFLOAT4 sampleB = XMFLOAT4(0, 0, 0, 0);
+
+		for (int i = 0; i < 4; ++i)
+		{
+			if ((&activeMask.x)[i] == 0)
+			{
+				continue;
+			}
+
+			XMFLOAT2 octCoords = ProbeHelper::GetOctahedralCoords(XMFLOAT3(-(&biasedX.x)[i], -(&biasedY.x)[i], -(&biasedZ.x)[i]));
+
+			//R component is distance, G component is distance squared
+			XMFLOAT4 distanceSample = SampleLinearWrap(kDistanceAtlas, ProbeHelper::GetAtlasCoords(probeIndices[i], octCoords, kParams.NumDistanceTexels, kParams.ProbeCounts, kParams.AtlasLayout));
+			(&meanDistance.x)[i] = 2.0f * distanceSample.x;
+			(&meanDistanceSquared.x)[i] = 2.0f * distanceSample.y;
+
+			if (kbOctahedral == true)
+			{
+				XMFLOAT4 irradianceSample = SampleLinearWrap(kIrradianceAtlas, ProbeHelper::GetAtlasCoords(probeIndices[i], irradianceOctCoords, kParams.NumIrradianceTexels, kParams.ProbeCounts, kParams.AtlasLayout));
+				(&sampleR.x)[i] = irradianceSample.x;
+				(&sampleG.x)[i] = irradianceSample.y;
+				(&sampleB.x)[i] = irradianceSample.z;
+			}
+			else
+			{
+				XMFLOAT3 irradianceSample = CPUSHProjector::EvaluateIrradiance(probeIndices[i], kDirection, kParams, kIrradianceAtlas);
+				(&sampleR.x)[i] = (std::max)(irradianceSample.x, 0.0f);
+				(&sampleG.x)[i] = (std::max)(irradianceSample.y, 0.0f);
+				(&sampleB.x)[i] = (std::max)(irradianceSample.z, 0.0f);
+			}
+		}
+
+		XMVECTOR distance = XMLoadFloat4(&meanDistance);
+		XMVECTOR variance = XMVectorAbs(XMVectorNegativeMultiplySubtract(distance, distance, XMLoadFloat4(&meanDistanceSquared)));
+
+		XMVECTOR v = XMVectorSubtract(biasedToProbeDistance, distance);
+		XMVECTOR chebyshevWeights = XMVectorDivide(variance, XMVectorMultiplyAdd(v, v, variance));
+		chebyshevWeights = XMVectorMax(XMVectorMultiply(XMVectorMultiply(chebyshevWeights, chebyshevWeights), chebyshevWeights), kZero);
+		chebyshevWeights = XMVectorSelect(kOne, chebyshevWeights, XMVectorGreater(biasedToProbeDistance, distance));
+
+		weights = XMVectorMultiply(weights, XMVectorMax(XMVectorReplicate(0.05f), chebyshevWeights));
+		weights = XMVectorMax(XMVectorReplicate(0.000001f), weights);
+
+		XMVECTOR crushedWeights = XMVectorMultiply(weights, XMVectorDivide(XMVectorMultiply(weights, weights), XMVectorMultiply(kCrushThreshold, kCrushThreshold)));
+		weights = XMVectorSelect(weights, crushedWeights, XMVectorLess(weights, kCrushThreshold));
+
+		weights = XMVectorMultiply(weights, trilinear);
+
+		//Skipped probes add nothing to either sum
+		weights = XMVectorSelect(kZero, weights, active);
+		trilinear = XMVectorSelect(kZero, trilinear, active);
+
+		irradianceR = XMVectorMultiplyAdd(weights, XMVectorPow(XMLoadFloat4(&sampleR), kGamma), irradianceR);
+		irradianceG = XMVectorMultiplyAdd(weights, XMVectorPow(XMLoadFloat4(&sampleG), kGamma), irradianceG);
+		irradianceB = XMVectorMultiplyAdd(weights, XMVectorPow(XMLoadFloat4(&sampleB), kGamma), irradianceB);
+		distances = XMVectorMultiplyAdd(trilinear, distance, distances);
+
+		accumulatedWeights = XMVectorAdd(accumulatedWeights, weights);
+		accumulatedDistanceWeights = XMVectorAdd(accumulatedDistanceWeights, trilinear);
+	}
+
+	float fAccumulatedWeights = HorizontalAdd(accumulatedWeights);
+
+	if (fAccumulatedWeights == 0.0f)
+	{
+		return XMFLOAT4(0, 0, 0, -1);
+	}
+
+	float fScale = kParams.IrradianceEncoding == PROBE_IRRADIANCE_ENCODING_OCTAHEDRAL && kParams.IrradianceFormat == FORMAT_PROBE_IRRADIANCE_R10G10B10A2_FLOAT ? 1.0989f : 1.0f;
+
+	XMFLOAT4 irradiance;
+	irradiance.x = HorizontalAdd(irradianceR) / fAccumulatedWeights;
+	irradiance.y = HorizontalAdd(irradianceG) / fAccumulatedWeights;
+	irradiance.z = HorizontalAdd(irradianceB) / fAccumulatedWeights;
+	irradiance.x *= irradiance.x * XM_2PI * fScale;
+	irradiance.y *= irradiance.y * XM_2PI * fScale;
+	irradiance.z *= irradiance.z * XM_2PI * fScale;
+	irradiance.w = HorizontalAdd(distances) / HorizontalAdd(accumulatedDistanceWeights);
+
+	return irradiance;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "GI/CPUAtlas.h"
+#include "Shaders/ConstantBuffers.h"
+
+#include <DirectXMath.h>
+#include <vector>
+
+class ThreadPool;
+
+struct IrradianceQuery
+{
+	DirectX::XMFLOAT3 PosW;
+	DirectX::XMFLOAT3 NormalW;	//Also the direction the irradiance is gathered in
+};
+
+struct CPUQueryStats
+{
+	UINT64 NumQueries = 0;
+
+	UINT NumThreads = 1;
+
+	float Seconds = 0.0f;
+
+	double GetQueriesPerSecond() const
+	{
+		return Seconds > 0.0f ? NumQueries / (double)Seconds : 0.0;
+	}
+};
+
+//CPU port of GetIrradiance in Shaders/Irradiance.hlsl for things that need the GI away from the light pass, e.g.
+//lighting dynamic objects or gameplay checks for how lit a spot is. Reads CPU copies of a volume's irradiance,
+//distance and probe data atlases laid out the same way as GIVolume's, like the ones CPUProbeBlender and
+//CPUProbeRelocator fill in. Each query's eight surrounding probes are weighted four at a time as a packet and
+//batches are split across the thread pool.
+class CPUIrradianceQuery
+{
+public:
+	CPUIrradianceQuery(ThreadPool* pThreadPool = nullptr);
+
+	//Fills results with the same float4 GetIrradiance returns, RGB irradiance and W distance, or (0, 0, 0, -1) if
+	//every probe around the query was skipped. Surface bias is worked out from kEyePosW like the light pass does.
+	//kpProbeData is only read when classification or relocation is on and can be null otherwise.
+	void QueryIrradiance(const RaytracePerFrameCB& kParams, const CPUAtlas& kIrradianceAtlas, const CPUAtlas& kDistanceAtlas, const CPUAtlas* kpProbeData, const DirectX::XMFLOAT3& kEyePosW, const std::vector<IrradianceQuery>& kQueries, std::vector<DirectX::XMFLOAT4>& results);
+
+	//Single query with everything written out the same way as the shader, kept as a reference for the batched path
+	static DirectX::XMFLOAT4 GetIrradiance(const DirectX::XMFLOAT3& kPosW, const DirectX::XMFLOAT3& kSurfaceBias, const DirectX::XMFLOAT3& kDirection, const RaytracePerFrameCB& kParams, const CPUAtlas& kIrradianceAtlas, const CPUAtlas& kDistanceAtlas, const CPUAtlas* kpProbeData);
+
+	//Same as GetSurfaceBias in Shaders/ProbeHelper.hlsl
+	static DirectX::XMFLOAT3 GetSurfaceBias(const DirectX::XMFLOAT3& kNormal, const DirectX::XMFLOAT3& kCameraDirection, float fNormalBias, float fViewBias);
+
+	//Bilinear filtered sample with wrapping, the same as SamLinearWrap at mip 0
+	static DirectX::XMFLOAT4 SampleLinearWrap(const CPUAtlas& kAtlas, const DirectX::XMFLOAT2& kUV);
+
+	void SetThreadPool(ThreadPool* pThreadPool);
+
+	const CPUQueryStats& GetLastQueryStats() const;
+
+protected:
+
+private:
+	DirectX::XMFLOAT4 QueryPoint(const DirectX::XMFLOAT3& kPosW, const DirectX::XMFLOAT3& kSurfaceBias, const DirectX::XMFLOAT3& kDirection, const RaytracePerFrameCB& kParams, const CPUAtlas& kIrradianceAtlas, const CPUAtlas& kDistanceAtlas, const CPUAtlas* kpProbeData) const;
+
+	ThreadPool* m_pThreadPool = nullptr;
+
+	CPUQueryStats m_LastQueryStats;
+};
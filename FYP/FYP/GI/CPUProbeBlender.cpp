@@ -0,0 +1,562 @@
+#include "CPUProbeBlender.h"
+#include "Commons/ThreadPool.h"
+#include "Commons/Timer.h"
+#include "Helpers/ProbeHelper.h"
+#include "Helpers/DebugHelper.h"
+#include "Shaders/Defines.hlsli"
+
+#include <algorithm>
+#include <math.h>
+
+using namespace DirectX;
+
+Tag tag = L"CPUProbeBlender";
+
+#define PROBES_PER_TASK 16
+
+namespace
+{
+	inline float HorizontalAdd(FXMVECTOR vector)
+	{
+		return XMVectorGetX(vector) + XMVectorGetY(vector) + XMVectorGetZ(vector) + XMVectorGetW(vector);
+	}
+
+	inline float Max3(const XMFLOAT3& kVector)
+	{
+		return (std::max)((std::max)(kVector.x, kVector.y), kVector.z);
+	}
+}
+
+CPUProbeBlender::CPUProbeBlender(ThreadPool* pThreadPool)
+{
+	m_pThreadPool = pThreadPool;
+}
+
+void CPUProbeBlender::BlendProbeAtlases(const RaytracePerFrameCB& kParams, const CPUAtlas& kRayData, CPUAtlas& irradianceAtlas, CPUAtlas& distanceAtlas, CPUAtlas* pHysteresisAtlas, const uint32_t* kpProbeRayCounts)
+{
+	PROFILE("CPU Blend Probes");
+
+	Timer timer;
+	timer.Reset();
+
+	UpdateRayDirections(kParams);
+
+	Blend(kParams, kRayData, irradianceAtlas, true, pHysteresisAtlas, kpProbeRayCounts);
+	Blend(kParams, kRayData, distanceAtlas, false, nullptr, kpProbeRayCounts);
+
+	BlendBorders(kParams.NumIrradianceTexels, kParams.ProbeCounts, irradianceAtlas);
+	BlendBorders(kParams.NumDistanceTexels, kParams.ProbeCounts, distanceAtlas);
+
+	timer.Tick();
+
+	m_fLastBlendTime = timer.DeltaTime();
+}
+
+void CPUProbeBlender::BlendIrradiance(const RaytracePerFrameCB& kParams, const CPUAtlas& kRayData, CPUAtlas& irradianceAtlas, CPUAtlas* pHysteresisAtlas, const uint32_t* kpProbeRayCounts)
+{
+	UpdateRayDirections(kParams);
+
+	Blend(kParams, kRayData, irradianceAtlas, true, pHysteresisAtlas, kpProbeRayCounts);
+}
+
+void CPUProbeBlender::BlendDistance(const RaytracePerFrameCB& kParams, const CPUAtlas& kRayData, CPUAtlas& distanceAtlas, const uint32_t* kpProbeRayCounts)
+{
+	UpdateRayDirections(kParams);
+
+	Blend(kParams, kRayData, distanceAtlas, false, nullptr, kpProbeRayCounts);
+}
+
+void CPUProbeBlender::BlendBorders(int iNumTexels, const XMINT3& kProbeCounts, CPUAtlas& atlas)
+{
+	//Rows have to be finished before the columns as the corners are copied from the updated rows
+	if (m_pThreadPool == nullptr)
+	{
+		BlendRows(0, kProbeCounts.z, iNumTexels, kProbeCounts, atlas);
+		BlendColumns(0, kProbeCounts.x * kProbeCounts.y, iNumTexels, kProbeCounts, atlas);
+
+		return;
+	}
+
+	m_pThreadPool->ParallelFor(kProbeCounts.z, 1, [this, iNumTexels, &kProbeCounts, &atlas](int iStart, int iEnd)
+	{
+		BlendRows(iStart, iEnd, iNumTexels, kProbeCounts, atlas);
+	});
+
+	m_pThreadPool->ParallelFor(kProbeCounts.x * kProbeCounts.y, PROBES_PER_TASK, [this, iNumTexels, &kProbeCounts, &atlas](int iStart, int iEnd)
+	{
+		BlendColumns(iStart, iEnd, iNumTexels, kProbeCounts, atlas);
+	});
+}
+
+void CPUProbeBlender::CreateAtlases(const RaytracePerFrameCB& kParams, CPUAtlas& rayData, CPUAtlas& irradianceAtlas, CPUAtlas& distanceAtlas)
+{
+	int iNumProbes = kParams.ProbeCounts.x * kParams.ProbeCounts.y * kParams.ProbeCounts.z;
+
+	rayData.Resize(kParams.RaysPerProbe, iNumProbes);
+	irradianceAtlas.Resize(kParams.ProbeCounts.x * kParams.ProbeCounts.y * (kParams.NumIrradianceTexels + 2), kParams.ProbeCounts.z * (kParams.NumIrradianceTexels + 2));
+	distanceAtlas.Resize(kParams.ProbeCounts.x * kParams.ProbeCounts.y * (kParams.NumDistanceTexels + 2), kParams.ProbeCounts.z * (kParams.NumDistanceTexels + 2));
+}
+
+void CPUProbeBlender::CreateHysteresisAtlas(const RaytracePerFrameCB& kParams, CPUAtlas& hysteresisAtlas)
+{
+	hysteresisAtlas.Resize(kParams.ProbeCounts.x * kParams.ProbeCounts.y, kParams.ProbeCounts.z);
+}
+
+void CPUProbeBlender::SetThreadPool(ThreadPool* pThreadPool)
+{
+	m_pThreadPool = pThreadPool;
+}
+
+float CPUProbeBlender::GetLastBlendTime() const
+{
+	return m_fLastBlendTime;
+}
+
+void CPUProbeBlender::UpdateRayDirections(const RaytracePerFrameCB& kParams)
+{
+	m_RayDirectionTable.Update(kParams.RaysPerProbe, kParams.RayRotation);
+}
+
+void CPUProbeBlender::Blend(const RaytracePerFrameCB& kParams, const CPUAtlas& kRayData, CPUAtlas& atlas, bool bRadiance, CPUAtlas* pHysteresisAtlas, const uint32_t* kpProbeRayCounts)
+{
+	//One group per probe, same as the compute dispatch
+	int iNumGroups = kParams.ProbeCounts.x * kParams.ProbeCounts.y * kParams.ProbeCounts.z;
+
+	if (m_pThreadPool == nullptr)
+	{
+		ProbeRays probeRays;
+
+		for (int i = 0; i < iNumGroups; ++i)
+		{
+			BlendProbe(i, kParams, kRayData, atlas, bRadiance, pHysteresisAtlas, kpProbeRayCounts, probeRays);
+		}
+
+		return;
+	}
+
+	m_pThreadPool->ParallelFor(iNumGroups, PROBES_PER_TASK, [this, &kParams, &kRayData, &atlas, bRadiance, pHysteresisAtlas, kpProbeRayCounts](int iStart, int iEnd)
+	{
+		ProbeRays probeRays;
+
+		for (int i = iStart; i < iEnd; ++i)
+		{
+			BlendProbe(i, kParams, kRayData, atlas, bRadiance, pHysteresisAtlas, kpProbeRayCounts, probeRays);
+		}
+	});
+}
+
+void CPUProbeBlender::BlendProbe(int iGroupIndex, const RaytracePerFrameCB& kParams, const CPUAtlas& kRayData, CPUAtlas& atlas, bool bRadiance, CPUAtlas* pHysteresisAtlas, const uint32_t* kpProbeRayCounts, ProbeRays& probeRays)
+{
+	int iNumTexels = bRadiance == true ? kParams.NumIrradianceTexels : kParams.NumDistanceTexels;
+	int iNumGroupsX = kParams.ProbeCounts.x * kParams.ProbeCounts.y;
+
+	XMINT2 groupID = XMINT2(iGroupIndex % iNumGroupsX, iGroupIndex / iNumGroupsX);
+	XMINT2 groupOrigin = XMINT2(groupID.x * iNumTexels, groupID.y * iNumTexels);
+
+	int iNumProbes = kParams.ProbeCounts.x * kParams.ProbeCounts.y * kParams.ProbeCounts.z;
+	int iProbeIndex = ProbeHelper::GetProbeIndex(groupOrigin, iNumTexels, kParams.ProbeCounts, kParams.AtlasLayout);
+
+	if (iProbeIndex >= iNumProbes || iProbeIndex < 0)
+	{
+		return;
+	}
+
+	XMINT3 probeCoords = ProbeHelper::GetProbeCoords(iProbeIndex, kParams.ProbeCounts);
+
+	bool bClearedPlane = false;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		bClearedPlane |= ProbeHelper::IsScrolledPlane(probeCoords, i, kParams.ProbeOffsets, kParams.ProbeCounts, kParams.ClearPlane);
+	}
+
+	//The interior texels of this probe start one texel in from the probe's border
+	XMINT2 atlasOrigin = XMINT2(1 + groupOrigin.x + groupID.x * 2, 1 + groupOrigin.y + groupID.y * 2);
+
+	XMFLOAT4* pState = nullptr;
+
+	if (bRadiance == true && kParams.AdaptiveHysteresis != 0 && pHysteresisAtlas != nullptr)
+	{
+		XMINT2 stateCoords = ProbeHelper::GetProbeDataCoords(iProbeIndex, kParams.ProbeCounts, kParams.AtlasLayout);
+		pState = &pHysteresisAtlas->GetTexel(stateCoords.x, stateCoords.y);
+	}
+
+	if (bClearedPlane == true)
+	{
+		for (int y = 0; y < iNumTexels; ++y)
+		{
+			for (int x = 0; x < iNumTexels; ++x)
+			{
+				atlas.GetTexel(atlasOrigin.x + x, atlasOrigin.y + y) = XMFLOAT4(0, 0, 0, 0);
+			}
+		}
+
+		//The plane now holds new probes so they start converging from scratch
+		if (pState != nullptr)
+		{
+			*pState = XMFLOAT4(0, 0, 0, 0);
+		}
+
+		return;
+	}
+
+	int iNumRays = ProbeHelper::GetProbeNumRays(iProbeIndex, kParams.AdaptiveRays, (int)kParams.RaysPerProbe, kpProbeRayCounts);
+
+	if (LoadProbeRays(iProbeIndex, iNumRays, kParams, kRayData, bRadiance, probeRays) == false)
+	{
+		//Too many backface hits so the probe is left as it is
+		return;
+	}
+
+	int iNumVectors = (iNumRays + 3) / 4;
+
+	const XMVECTOR* kpDirectionsX = m_RayDirectionTable.GetDirectionsX().data();
+	const XMVECTOR* kpDirectionsY = m_RayDirectionTable.GetDirectionsY().data();
+	const XMVECTOR* kpDirectionsZ = m_RayDirectionTable.GetDirectionsZ().data();
+
+	if (iNumRays != m_RayDirectionTable.GetRaysPerProbe())
+	{
+		//Fewer rays are spread over the whole sphere so none of them line up with the table
+		GetProbeDirections(iProbeIndex, iNumRays, kParams, probeRays);
+
+		kpDirectionsX = probeRays.DirectionsX.data();
+		kpDirectionsY = probeRays.DirectionsY.data();
+		kpDirectionsZ = probeRays.DirectionsZ.data();
+	}
+	else if (kParams.PerProbeRayRotation != 0)
+	{
+		m_RayDirectionTable.GetProbeDirections(iProbeIndex, probeRays.DirectionsX, probeRays.DirectionsY, probeRays.DirectionsZ);
+
+		kpDirectionsX = probeRays.DirectionsX.data();
+		kpDirectionsY = probeRays.DirectionsY.data();
+		kpDirectionsZ = probeRays.DirectionsZ.data();
+	}
+
+	float fEpsilon = (float)iNumRays * 1e-9f;
+	float fHysteresis = kParams.Hysteresis;
+
+	probeRays.Results.resize(iNumTexels * iNumTexels);
+
+	XMVECTOR zero = XMVectorZero();
+	XMVECTOR distancePower = XMVectorReplicate(kParams.DistancePower);
+
+	for (int y = 0; y < iNumTexels; ++y)
+	{
+		for (int x = 0; x < iNumTexels; ++x)
+		{
+			XMFLOAT2 octCoords = ProbeHelper::GetNormalizedOctahedralCoords(XMINT2(groupOrigin.x + x, groupOrigin.y + y), iNumTexels);
+			XMFLOAT3 direction = ProbeHelper::GetOctahedralDirection(octCoords);
+
+			XMVECTOR directionX = XMVectorReplicate(direction.x);
+			XMVECTOR directionY = XMVectorReplicate(direction.y);
+			XMVECTOR directionZ = XMVectorReplicate(direction.z);
+
+			XMVECTOR sumX = zero;
+			XMVECTOR sumY = zero;
+			XMVECTOR sumZ = zero;
+			XMVECTOR sumWeights = zero;
+
+			for (int i = 0; i < iNumVectors; ++i)
+			{
+				XMVECTOR weights = XMVectorMultiply(directionX, kpDirectionsX[i]);
+				weights = XMVectorMultiplyAdd(directionY, kpDirectionsY[i], weights);
+				weights = XMVectorMultiplyAdd(directionZ, kpDirectionsZ[i], weights);
+				weights = XMVectorMax(weights, zero);
+
+				if (bRadiance == true)
+				{
+					weights = XMVectorAndInt(weights, probeRays.Mask[i]);
+
+					sumX = XMVectorMultiplyAdd(probeRays.RadianceR[i], weights, sumX);
+					sumY = XMVectorMultiplyAdd(probeRays.RadianceG[i], weights, sumY);
+					sumZ = XMVectorMultiplyAdd(probeRays.RadianceB[i], weights, sumZ);
+				}
+				else
+				{
+					weights = XMVectorAndInt(XMVectorPow(weights, distancePower), probeRays.Mask[i]);
+
+					XMVECTOR weightedDistances = XMVectorMultiply(probeRays.Distances[i], weights);
+
+					sumX = XMVectorAdd(sumX, weightedDistances);
+					sumY = XMVectorMultiplyAdd(probeRays.Distances[i], weightedDistances, sumY);
+				}
+
+				sumWeights = XMVectorAdd(sumWeights, weights);
+			}
+
+			float fScale = 1.0f / (2.0f * (std::max)(HorizontalAdd(sumWeights), fEpsilon));
+
+			XMFLOAT3 result = XMFLOAT3(HorizontalAdd(sumX) * fScale, HorizontalAdd(sumY) * fScale, HorizontalAdd(sumZ) * fScale);
+
+			XMFLOAT4& texel = atlas.GetTexel(atlasOrigin.x + x, atlasOrigin.y + y);
+			XMFLOAT3 previous = XMFLOAT3(texel.x, texel.y, texel.z);
+
+			if (bRadiance == false)
+			{
+				texel = XMFLOAT4(result.x + fHysteresis * (previous.x - result.x), result.y + fHysteresis * (previous.y - result.y), 0.0f, 1.0f);
+
+				continue;
+			}
+
+			//Tonemap
+			float fInvGamma = 1.0f / kParams.IrradianceGammaEncoding;
+
+			probeRays.Results[(y * iNumTexels) + x] = XMFLOAT3(powf(result.x, fInvGamma), powf(result.y, fInvGamma), powf(result.z, fInvGamma));
+		}
+	}
+
+	if (bRadiance == false)
+	{
+		return;
+	}
+
+	//Same as the shader's group reduction, the whole probe's change picks the hysteresis every texel uses
+	if (pState != nullptr)
+	{
+		float fLuminance = 0.0f;
+		float fPreviousLuminance = 0.0f;
+
+		for (int y = 0; y < iNumTexels; ++y)
+		{
+			for (int x = 0; x < iNumTexels; ++x)
+			{
+				const XMFLOAT4& kTexel = atlas.GetTexel(atlasOrigin.x + x, atlasOrigin.y + y);
+
+				fLuminance += ProbeHelper::GetLuminance(probeRays.Results[(y * iNumTexels) + x]);
+				fPreviousLuminance += ProbeHelper::GetLuminance(XMFLOAT3(kTexel.x, kTexel.y, kTexel.z));
+			}
+		}
+
+		float fChange = ProbeHelper::GetProbeIrradianceChange(fLuminance, fPreviousLuminance, iNumTexels * iNumTexels);
+		XMFLOAT2 state = ProbeHelper::UpdateProbeHysteresis(XMFLOAT2(pState->x, pState->y), fChange, kParams.MinHysteresis, kParams.Hysteresis, kParams.HysteresisRiseRate, kParams.HysteresisChangeThreshold);
+
+		*pState = XMFLOAT4(state.x, state.y, 0.0f, 0.0f);
+		fHysteresis = state.x;
+	}
+
+	for (int y = 0; y < iNumTexels; ++y)
+	{
+		for (int x = 0; x < iNumTexels; ++x)
+		{
+			XMFLOAT4& texel = atlas.GetTexel(atlasOrigin.x + x, atlasOrigin.y + y);
+			XMFLOAT3 previous = XMFLOAT3(texel.x, texel.y, texel.z);
+			XMFLOAT3 result = probeRays.Results[(y * iNumTexels) + x];
+
+			XMFLOAT3 delta = XMFLOAT3(result.x - previous.x, result.y - previous.y, result.z - previous.z);
+
+			float fHysteresisTexel = fHysteresis;
+
+			if ((std::max)((std::max)(previous.x - result.x, previous.y - result.y), previous.z - result.z) > kParams.IrradianceThreshold)
+			{
+				fHysteresisTexel = (std::max)(0.0f, fHysteresisTexel - 0.75f);
+			}
+
+			if (sqrtf(delta.x * delta.x + delta.y * delta.y + delta.z * delta.z) > kParams.BrightnessThreshold)
+			{
+				result = XMFLOAT3(previous.x + delta.x * 0.25f, previous.y + delta.y * 0.25f, previous.z + delta.z * 0.25f);
+			}
+
+			const float kfThreshold = 1.0f / 1024.0f;
+
+			XMFLOAT3 lerpDelta = XMFLOAT3((1.0f - fHysteresisTexel) * delta.x, (1.0f - fHysteresisTexel) * delta.y, (1.0f - fHysteresisTexel) * delta.z);
+
+			//Same as the shader, the step is clamped and then given its sign back
+			if (Max3(result) < Max3(previous))
+			{
+				lerpDelta.x = (std::min)((std::max)(kfThreshold, fabsf(lerpDelta.x)), fabsf(delta.x)) * ProbeHelper::Sign(lerpDelta.x);
+				lerpDelta.y = (std::min)((std::max)(kfThreshold, fabsf(lerpDelta.y)), fabsf(delta.y)) * ProbeHelper::Sign(lerpDelta.y);
+				lerpDelta.z = (std::min)((std::max)(kfThreshold, fabsf(lerpDelta.z)), fabsf(delta.z)) * ProbeHelper::Sign(lerpDelta.z);
+			}
+
+			texel = XMFLOAT4(previous.x + lerpDelta.x, previous.y + lerpDelta.y, previous.z + lerpDelta.z, 1.0f);
+		}
+	}
+}
+
+bool CPUProbeBlender::LoadProbeRays(int iProbeIndex, int iNumRays, const RaytracePerFrameCB& kParams, const CPUAtlas& kRayData, bool bRadiance, ProbeRays& probeRays)
+{
+	int iNumVectors = (iNumRays + 3) / 4;
+
+	probeRays.RadianceR.resize(iNumVectors);
+	probeRays.RadianceG.resize(iNumVectors);
+	probeRays.RadianceB.resize(iNumVectors);
+	probeRays.Distances.resize(iNumVectors);
+	probeRays.Mask.resize(iNumVectors);
+
+	float fMaxRayDistance = sqrtf(kParams.ProbeSpacing.x * kParams.ProbeSpacing.x + kParams.ProbeSpacing.y * kParams.ProbeSpacing.y + kParams.ProbeSpacing.z * kParams.ProbeSpacing.z) * 1.5f;
+
+	UINT32 uiNumBackfaceHits = 0;
+	UINT32 uiMaxBackfaceHits = (UINT32)(iNumRays * 0.1f);
+
+	XMFLOAT4 radianceR;
+	XMFLOAT4 radianceG;
+	XMFLOAT4 radianceB;
+	XMFLOAT4 distances;
+	UINT32 masks[4];
+
+	for (int i = 0; i < iNumVectors; ++i)
+	{
+		radianceR = XMFLOAT4(0, 0, 0, 0);
+		radianceG = XMFLOAT4(0, 0, 0, 0);
+		radianceB = XMFLOAT4(0, 0, 0, 0);
+		distances = XMFLOAT4(0, 0, 0, 0);
+
+		for (int j = 0; j < 4; ++j)
+		{
+			int iRayIndex = (i * 4) + j;
+
+			masks[j] = iRayIndex < iNumRays ? 0xFFFFFFFF : 0;
+
+			if (iRayIndex >= iNumRays)
+			{
+				continue;
+			}
+
+			const XMFLOAT4& kTexel = kRayData.GetTexel(iRayIndex, iProbeIndex);
+
+			XMFLOAT3 radiance = ProbeHelper::GetRayRadiance(kTexel, kParams.RayDataFormat);
+			float fDistance = ProbeHelper::GetRayDistance(kTexel, kParams.RayDataFormat);
+
+			if (bRadiance == true)
+			{
+				if (fDistance < 0.0f)
+				{
+					++uiNumBackfaceHits;
+				}
+
+				(&radianceR.x)[j] = radiance.x;
+				(&radianceG.x)[j] = radiance.y;
+				(&radianceB.x)[j] = radiance.z;
+				(&distances.x)[j] = fDistance;
+			}
+			else
+			{
+				(&distances.x)[j] = (std::min)(fabsf(fDistance), fMaxRayDistance);
+			}
+		}
+
+		probeRays.RadianceR[i] = XMLoadFloat4(&radianceR);
+		probeRays.RadianceG[i] = XMLoadFloat4(&radianceG);
+		probeRays.RadianceB[i] = XMLoadFloat4(&radianceB);
+		probeRays.Distances[i] = XMLoadFloat4(&distances);
+
+		XMVECTOR rayMask = XMVectorSetInt(masks[0], masks[1], masks[2], masks[3]);
+
+		if (bRadiance == true)
+		{
+			//Backface hits don't contribute to the irradiance
+			probeRays.Mask[i] = XMVectorAndInt(rayMask, XMVectorGreaterOrEqual(probeRays.Distances[i], XMVectorZero()));
+		}
+		else
+		{
+			probeRays.Mask[i] = rayMask;
+		}
+	}
+
+	//The shader bails out as soon as it has counted this many backface hits, whichever texel it is working on
+	if (bRadiance == true && uiNumBackfaceHits > 0 && uiNumBackfaceHits >= uiMaxBackfaceHits)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+void CPUProbeBlender::GetProbeDirections(int iProbeIndex, int iNumRays, const RaytracePerFrameCB& kParams, ProbeRays& probeRays)
+{
+	int iNumVectors = (iNumRays + 3) / 4;
+
+	probeRays.DirectionsX.resize(iNumVectors);
+	probeRays.DirectionsY.resize(iNumVectors);
+	probeRays.DirectionsZ.resize(iNumVectors);
+
+	XMFLOAT4 rayRotation = ProbeHelper::GetProbeRayRotation(iProbeIndex, kParams.RayRotation, kParams.PerProbeRayRotation);
+
+	XMFLOAT4 directionsX;
+	XMFLOAT4 directionsY;
+	XMFLOAT4 directionsZ;
+
+	for (int i = 0; i < iNumVectors; ++i)
+	{
+		for (int j = 0; j < 4; ++j)
+		{
+			int iRayIndex = (i * 4) + j;
+
+			//Lanes past the last ray are zero like the table's
+			XMFLOAT3 direction = iRayIndex < iNumRays ? ProbeHelper::GetRayDirection(iRayIndex, iNumRays, rayRotation) : XMFLOAT3(0, 0, 0);
+
+			(&directionsX.x)[j] = direction.x;
+			(&directionsY.x)[j] = direction.y;
+			(&directionsZ.x)[j] = direction.z;
+		}
+
+		probeRays.DirectionsX[i] = XMLoadFloat4(&directionsX);
+		probeRays.DirectionsY[i] = XMLoadFloat4(&directionsY);
+		probeRays.DirectionsZ[i] = XMLoadFloat4(&directionsZ);
+	}
+}
+
+void CPUProbeBlender::BlendRows(int iStartRow, int iEndRow, int iNumTexels, const XMINT3& kProbeCounts, CPUAtlas& atlas)
+{
+	//+2 for one row of padding on each side
+	int iRowLength = iNumTexels + 2;
+	int iAtlasWidth = kProbeCounts.x * kProbeCounts.y * iRowLength;
+
+	for (int iRow = iStartRow; iRow < iEndRow; ++iRow)
+	{
+		int iTopRow = iRow * iRowLength;
+		int iBottomRow = iTopRow + iRowLength - 1;
+
+		for (int x = 0; x < iAtlasWidth; ++x)
+		{
+			//Corners are done in the column update
+			int iMod = x % iRowLength;
+
+			if (iMod == 0 || iMod == iRowLength - 1)
+			{
+				continue;
+			}
+
+			int iProbeStart = (x / iRowLength) * iRowLength;
+			int iOffset = iRowLength - iMod - 1;
+
+			atlas.GetTexel(x, iTopRow) = atlas.GetTexel(iProbeStart + iOffset, iTopRow + 1);
+			atlas.GetTexel(x, iBottomRow) = atlas.GetTexel(iProbeStart + iOffset, iBottomRow - 1);
+		}
+	}
+}
+
+void CPUProbeBlender::BlendColumns(int iStartColumn, int iEndColumn, int iNumTexels, const XMINT3& kProbeCounts, CPUAtlas& atlas)
+{
+	//+2 for one column of padding on each side
+	int iColumnLength = iNumTexels + 2;
+	int iAtlasHeight = kProbeCounts.z * iColumnLength;
+
+	for (int iColumn = iStartColumn; iColumn < iEndColumn; ++iColumn)
+	{
+		int iLeftColumn = iColumn * iColumnLength;
+		int iRightColumn = iLeftColumn + iColumnLength - 1;
+
+		for (int y = 0; y < iAtlasHeight; ++y)
+		{
+			int iMod = y % iColumnLength;
+
+			//Corner texels
+			if (iMod == 0 || iMod == iColumnLength - 1)
+			{
+				int iCopyY = y - (int)ProbeHelper::Sign((float)(iMod - 1)) * iNumTexels;
+
+				atlas.GetTexel(iLeftColumn, y) = atlas.GetTexel(iLeftColumn + iNumTexels, iCopyY);
+				atlas.GetTexel(iRightColumn, y) = atlas.GetTexel(iRightColumn - iNumTexels, iCopyY);
+
+				continue;
+			}
+
+			int iProbeStart = (y / iColumnLength) * iColumnLength;
+			int iOffset = iColumnLength - iMod - 1;
+
+			atlas.GetTexel(iLeftColumn, y) = atlas.GetTexel(iLeftColumn + 1, iProbeStart + iOffset);
+			atlas.GetTexel(iRightColumn, y) = atlas.GetTexel(iRightColumn - 1, iProbeStart + iOffset);
+		}
+	}
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "GI/CPUAtlas.h"
+#include "GI/RayDirectionTable.h"
+#include "Shaders/ConstantBuffers.h"
+
+#include <DirectXMath.h>
+#include <stdint.h>
+#include <vector>
+
+class ThreadPool;
+
+//CPU port of Shaders/ProbeBlendingCompute.hlsl and Shaders/ProbeBorderBlendingCompute.hlsl. Takes ray data laid out
+//the same way as GIVolume's ray data atlas (one row per probe, one texel per ray) and blends it into the irradiance
+//and distance atlases using the same per frame constants the compute shaders use.
+class CPUProbeBlender
+{
+public:
+	CPUProbeBlender(ThreadPool* pThreadPool = nullptr);
+
+	//Does the same work as GIVolume::BlendProbeAtlases, main blends followed by the border updates. pHysteresisAtlas
+	//holds each probe's hysteresis state and is only used when kParams.AdaptiveHysteresis is set. kpProbeRayCounts holds
+	//one ray count per probe like the buffer at ProbeRayCountsIndex and is only read with adaptive rays.
+	void BlendProbeAtlases(const RaytracePerFrameCB& kParams, const CPUAtlas& kRayData, CPUAtlas& irradianceAtlas, CPUAtlas& distanceAtlas, CPUAtlas* pHysteresisAtlas = nullptr, const uint32_t* kpProbeRayCounts = nullptr);
+
+	void BlendIrradiance(const RaytracePerFrameCB& kParams, const CPUAtlas& kRayData, CPUAtlas& irradianceAtlas, CPUAtlas* pHysteresisAtlas = nullptr, const uint32_t* kpProbeRayCounts = nullptr);
+	void BlendDistance(const RaytracePerFrameCB& kParams, const CPUAtlas& kRayData, CPUAtlas& distanceAtlas, const uint32_t* kpProbeRayCounts = nullptr);
+
+	void BlendBorders(int iNumTexels, const DirectX::XMINT3& kProbeCounts, CPUAtlas& atlas);
+
+	//Sizes the atlases to match the textures GIVolume creates for the same settings
+	static void CreateAtlases(const RaytracePerFrameCB& kParams, CPUAtlas& rayData, CPUAtlas& irradianceAtlas, CPUAtlas& distanceAtlas);
+
+	//One texel per probe laid out like the probe data atlas, x is the probe's hysteresis and y its smoothed change
+	static void CreateHysteresisAtlas(const RaytracePerFrameCB& kParams, CPUAtlas& hysteresisAtlas);
+
+	void SetThreadPool(ThreadPool* pThreadPool);
+
+	float GetLastBlendTime() const;	//In seconds
+
+protected:
+
+private:
+	//Per thread copy of a single probe's ray data, equivalent to the group shared memory in the compute shader
+	struct ProbeRays
+	{
+		std::vector<DirectX::XMVECTOR> RadianceR;
+		std::vector<DirectX::XMVECTOR> RadianceG;
+		std::vector<DirectX::XMVECTOR> RadianceB;
+		std::vector<DirectX::XMVECTOR> Distances;
+		std::vector<DirectX::XMVECTOR> Mask;
+
+		//Every texel's tonemapped result, the probe's hysteresis can't be picked until all of them are known
+		std::vector<DirectX::XMFLOAT3> Results;
+
+		//Only used when the probe's rays aren't the table's, either spun per probe or fewer of them with adaptive rays
+		std::vector<DirectX::XMVECTOR> DirectionsX;
+		std::vector<DirectX::XMVECTOR> DirectionsY;
+		std::vector<DirectX::XMVECTOR> DirectionsZ;
+	};
+
+	void UpdateRayDirections(const RaytracePerFrameCB& kParams);
+
+	void Blend(const RaytracePerFrameCB& kParams, const CPUAtlas& kRayData, CPUAtlas& atlas, bool bRadiance, CPUAtlas* pHysteresisAtlas, const uint32_t* kpProbeRayCounts);
+
+	void BlendProbe(int iGroupIndex, const RaytracePerFrameCB& kParams, const CPUAtlas& kRayData, CPUAtlas& atlas, bool bRadiance, CPUAtlas* pHysteresisAtlas, const uint32_t* kpProbeRayCounts, ProbeRays& probeRays);
+
+	bool LoadProbeRays(int iProbeIndex, int iNumRays, const RaytracePerFrameCB& kParams, const CPUAtlas& kRayData, bool bRadiance, ProbeRays& probeRays);
+
+	//Works out the probe's directions one ray at a time, for when it traces a different number of rays to the table
+	static void GetProbeDirections(int iProbeIndex, int iNumRays, const RaytracePerFrameCB& kParams, ProbeRays& probeRays);
+
+	void BlendRows(int iStartRow, int iEndRow, int iNumTexels, const DirectX::XMINT3& kProbeCounts, CPUAtlas& atlas);
+	void BlendColumns(int iStartColumn, int iEndColumn, int iNumTexels, const DirectX::XMINT3& kProbeCounts, CPUAtlas& atlas);
+
+	ThreadPool* m_pThreadPool = nullptr;
+
+	//Ray directions are the same for every probe, unless they are spun per probe, so are only rotated once per blend
+	RayDirectionTable m_RayDirectionTable;
+
+	float m_fLastBlendTime = 0.0f;
+};
@@ -0,0 +1,99 @@
+#include "CPUProbeClassifier.h"
+#include "Commons/ThreadPool.h"
+#include "Helpers/ProbeHelper.h"
+#include "Shaders/Defines.hlsli"
+
+#include <math.h>
+
+using namespace DirectX;
+
+#define PROBES_PER_TASK 64
+
+CPUProbeClassifier::CPUProbeClassifier(ThreadPool* pThreadPool)
+{
+	m_pThreadPool = pThreadPool;
+}
+
+void CPUProbeClassifier::ClassifyProbes(const RaytracePerFrameCB& kParams, const CPUAtlas& kRayData, CPUAtlas& probeData, std::vector<int>& activeProbes, const uint32_t* kpProbeRayCounts, const uint32_t* kpTracedProbeMask)
+{
+	int iNumProbes = kParams.ProbeCounts.x * kParams.ProbeCounts.y * kParams.ProbeCounts.z;
+
+	std::function<void(int, int)> classifyProbes = [&kParams, &kRayData, &probeData, kpProbeRayCounts, kpTracedProbeMask](int iStart, int iEnd)
+	{
+		for (int i = iStart; i < iEnd; ++i)
+		{
+			XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(i, kParams.ProbeCounts, kParams.AtlasLayout);
+			XMFLOAT4& texel = probeData.GetTexel(dataCoords.x, dataCoords.y);
+
+			//Probes left out of this frame's trace have nothing new to classify them with so keep their state
+			if (ProbeHelper::WasProbeTraced(i, texel.w, kParams.UseActiveProbeList, kParams.FullProbeUpdate, kParams.TracedProbeMask, kpTracedProbeMask) == false)
+			{
+				continue;
+			}
+
+			texel.w = (float)ClassifyProbe(i, kParams, kRayData, kpProbeRayCounts);
+		}
+	};
+
+	if (m_pThreadPool != nullptr)
+	{
+		m_pThreadPool->ParallelFor(iNumProbes, PROBES_PER_TASK, classifyProbes);
+	}
+	else
+	{
+		classifyProbes(0, iNumProbes);
+	}
+
+	//Compacted serially so the list comes out in the same order every time
+	activeProbes.clear();
+
+	for (int i = 0; i < iNumProbes; ++i)
+	{
+		XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(i, kParams.ProbeCounts, kParams.AtlasLayout);
+
+		if (probeData.GetTexel(dataCoords.x, dataCoords.y).w == PROBE_STATE_ACTIVE)
+		{
+			activeProbes.push_back(i);
+		}
+	}
+}
+
+int CPUProbeClassifier::ClassifyProbe(int iProbeIndex, const RaytracePerFrameCB& kParams, const CPUAtlas& kRayData, const uint32_t* kpProbeRayCounts)
+{
+	int iRaysPerProbe = ProbeHelper::GetProbeNumRays(iProbeIndex, kParams.AdaptiveRays, (int)kParams.RaysPerProbe, kpProbeRayCounts);
+	int iNumBackfaceHits = 0;
+
+	//A probe only adds anything if there is a surface close enough for it to be the one shading it
+	float fMaxSurfaceDistance = sqrtf(kParams.ProbeSpacing.x * kParams.ProbeSpacing.x + kParams.ProbeSpacing.y * kParams.ProbeSpacing.y + kParams.ProbeSpacing.z * kParams.ProbeSpacing.z);
+	bool bNearSurface = false;
+
+	for (int i = 0; i < iRaysPerProbe; ++i)
+	{
+		float fRayDistance = ProbeHelper::GetRayDistance(kRayData.GetTexel(i, iProbeIndex), kParams.RayDataFormat);
+
+		if (fRayDistance < 0.0f)
+		{
+			++iNumBackfaceHits;
+
+			continue;
+		}
+
+		if (fRayDistance <= fMaxSurfaceDistance)
+		{
+			bNearSurface = true;
+		}
+	}
+
+	//Mostly inside geometry
+	if ((iNumBackfaceHits / (float)iRaysPerProbe) > kParams.ProbeBackfaceThreshold)
+	{
+		return PROBE_STATE_INACTIVE;
+	}
+
+	return bNearSurface == true ? PROBE_STATE_ACTIVE : PROBE_STATE_INACTIVE;
+}
+
+void CPUProbeClassifier::SetThreadPool(ThreadPool* pThreadPool)
+{
+	m_pThreadPool = pThreadPool;
+}
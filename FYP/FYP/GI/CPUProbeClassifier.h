@@ -0,0 +1,33 @@
+#pragma once
+
+#include "GI/CPUAtlas.h"
+#include "Shaders/ConstantBuffers.h"
+
+#include <stdint.h>
+#include <vector>
+
+class ThreadPool;
+
+//CPU port of Shaders/ProbeClassificationCompute.hlsl. Marks each probe active or inactive in the w component of a probe
+//data atlas and builds the list of active probes that the next frame's trace and blend are limited to.
+class CPUProbeClassifier
+{
+public:
+	CPUProbeClassifier(ThreadPool* pThreadPool = nullptr);
+
+	//Only probes that were traced get reclassified, the rest keep their state, see ProbeHelper::WasProbeTraced.
+	//kpTracedProbeMask holds a bit per probe like the mask after the active probe list and is only read when kParams.TracedProbeMask is set.
+	//activeProbes is filled with the atlas indices of the active probes in ascending order.
+	//kpProbeRayCounts holds one ray count per probe like the buffer at ProbeRayCountsIndex and is only read with adaptive rays.
+	void ClassifyProbes(const RaytracePerFrameCB& kParams, const CPUAtlas& kRayData, CPUAtlas& probeData, std::vector<int>& activeProbes, const uint32_t* kpProbeRayCounts = nullptr, const uint32_t* kpTracedProbeMask = nullptr);
+
+	//Returns PROBE_STATE_ACTIVE or PROBE_STATE_INACTIVE for a probe from its ray data
+	static int ClassifyProbe(int iProbeIndex, const RaytracePerFrameCB& kParams, const CPUAtlas& kRayData, const uint32_t* kpProbeRayCounts = nullptr);
+
+	void SetThreadPool(ThreadPool* pThreadPool);
+
+protected:
+
+private:
+	ThreadPool* m_pThreadPool = nullptr;
+};
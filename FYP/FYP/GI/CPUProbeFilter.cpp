@@ -0,0 +1,256 @@
+#include "CPUProbeFilter.h"
+#include "CPUIrradianceQuery.h"
+#include "Commons/ThreadPool.h"
+#include "Commons/Timer.h"
+#include "Helpers/ProbeHelper.h"
+#include "Helpers/DebugHelper.h"
+#include "Shaders/Defines.hlsli"
+
+#include <algorithm>
+#include <math.h>
+
+using namespace DirectX;
+
+Tag tag = L"CPUProbeFilter";
+
+#define PROBES_PER_TASK 16
+#define MAX_FILTER_NEIGHBOURS 26
+
+CPUProbeFilter::CPUProbeFilter(ThreadPool* pThreadPool)
+{
+	m_pThreadPool = pThreadPool;
+}
+
+void CPUProbeFilter::FilterProbes(const RaytracePerFrameCB& kParams, const CPUAtlas& kIrradianceAtlas, const CPUAtlas& kDistanceAtlas, const CPUAtlas* kpProbeData, CPUAtlas& filteredAtlas)
+{
+	PROFILE("CPU Filter Probes");
+
+	Timer timer;
+	timer.Reset();
+
+	if (filteredAtlas.Width != kIrradianceAtlas.Width || filteredAtlas.Height != kIrradianceAtlas.Height)
+	{
+		filteredAtlas.Resize(kIrradianceAtlas.Width, kIrradianceAtlas.Height);
+	}
+
+	if (kParams.ProbeClassification == 0 && kParams.ProbeRelocation == 0)
+	{
+		kpProbeData = nullptr;
+	}
+
+	int iNumProbes = kParams.ProbeCounts.x * kParams.ProbeCounts.y * kParams.ProbeCounts.z;
+
+	if (m_pThreadPool == nullptr)
+	{
+		for (int i = 0; i < iNumProbes; ++i)
+		{
+			FilterProbe(i, kParams, kIrradianceAtlas, kDistanceAtlas, kpProbeData, filteredAtlas);
+		}
+	}
+	else
+	{
+		m_pThreadPool->ParallelFor(iNumProbes, PROBES_PER_TASK, [this, &kParams, &kIrradianceAtlas, &kDistanceAtlas, kpProbeData, &filteredAtlas](int iStart, int iEnd)
+		{
+			for (int i = iStart; i < iEnd; ++i)
+			{
+				FilterProbe(i, kParams, kIrradianceAtlas, kDistanceAtlas, kpProbeData, filteredAtlas);
+			}
+		});
+	}
+
+	timer.Tick();
+
+	m_fLastFilterTime = timer.DeltaTime();
+}
+
+float CPUProbeFilter::GetNeighbourWeight(int iProbeIndex, int iNeighbour, const RaytracePerFrameCB& kParams, const CPUAtlas& kDistanceAtlas, const CPUAtlas* kpProbeData, int& iNeighbourIndex)
+{
+	iNeighbourIndex = 0;
+
+	XMINT3 probeCoords = ProbeHelper::GetUnoffsettedProbeCoords(iProbeIndex, kParams.ProbeCounts, kParams.ProbeOffsets);
+	XMINT3 offset = ProbeHelper::GetFilterNeighbourOffset(iNeighbour, kParams.ProbeFilter);
+	XMINT3 neighbourCoords = XMINT3(probeCoords.x + offset.x, probeCoords.y + offset.y, probeCoords.z + offset.z);
+
+	if (neighbourCoords.x < 0 || neighbourCoords.y < 0 || neighbourCoords.z < 0 ||
+		neighbourCoords.x >= kParams.ProbeCounts.x || neighbourCoords.y >= kParams.ProbeCounts.y || neighbourCoords.z >= kParams.ProbeCounts.z)
+	{
+		return 0.0f;
+	}
+
+	int iIndex = ProbeHelper::GetOffsettedProbeIndex(neighbourCoords, kParams.ProbeCounts, kParams.ProbeOffsets);
+
+	if (IsProbeOnScrolledPlane(iIndex, kParams) == true || IsProbeActive(iIndex, kParams, kpProbeData) == false)
+	{
+		return 0.0f;
+	}
+
+	XMFLOAT3 probePosW = GetProbePosition(probeCoords, kParams, kpProbeData);
+	XMFLOAT3 neighbourPosW = GetProbePosition(neighbourCoords, kParams, kpProbeData);
+
+	XMFLOAT3 toNeighbour = XMFLOAT3(neighbourPosW.x - probePosW.x, neighbourPosW.y - probePosW.y, neighbourPosW.z - probePosW.z);
+	float fDistance = sqrtf(toNeighbour.x * toNeighbour.x + toNeighbour.y * toNeighbour.y + toNeighbour.z * toNeighbour.z);
+	float fInvDistance = 1.0f / (std::max)(fDistance, 0.0001f);
+
+	toNeighbour = XMFLOAT3(toNeighbour.x * fInvDistance, toNeighbour.y * fInvDistance, toNeighbour.z * fInvDistance);
+
+	float fVisibility = ProbeHelper::GetChebyshevWeight(GetDistanceMoments(iProbeIndex, toNeighbour, kParams, kDistanceAtlas), fDistance);
+	fVisibility *= ProbeHelper::GetChebyshevWeight(GetDistanceMoments(iIndex, XMFLOAT3(-toNeighbour.x, -toNeighbour.y, -toNeighbour.z), kParams, kDistanceAtlas), fDistance);
+
+	iNeighbourIndex = iIndex;
+
+	return kParams.ProbeFilterStrength * fVisibility / (float)(offset.x * offset.x + offset.y * offset.y + offset.z * offset.z);
+}
+
+int CPUProbeFilter::GetNumNeighbours(int iProbeFilter)
+{
+	switch (iProbeFilter)
+	{
+	case PROBE_FILTER_6_NEIGHBOURS:
+		return 6;
+
+	case PROBE_FILTER_26_NEIGHBOURS:
+		return 26;
+
+	default:
+		return 0;
+	}
+}
+
+void CPUProbeFilter::SetThreadPool(ThreadPool* pThreadPool)
+{
+	m_pThreadPool = pThreadPool;
+}
+
+float CPUProbeFilter::GetLastFilterTime() const
+{
+	return m_fLastFilterTime;
+}
+
+void CPUProbeFilter::FilterProbe(int iProbeIndex, const RaytracePerFrameCB& kParams, const CPUAtlas& kIrradianceAtlas, const CPUAtlas& kDistanceAtlas, const CPUAtlas* kpProbeData, CPUAtlas& filteredAtlas) const
+{
+	bool bOctahedral = kParams.IrradianceEncoding == PROBE_IRRADIANCE_ENCODING_OCTAHEDRAL;
+
+	XMINT2 tileTexels = bOctahedral == true ? XMINT2(kParams.NumIrradianceTexels, kParams.NumIrradianceTexels) : XMINT2(kParams.NumSHCoefficients, 1);
+	int iBorder = bOctahedral == true ? 1 : 0;
+
+	XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(iProbeIndex, kParams.ProbeCounts, kParams.AtlasLayout);
+	XMINT2 tileOrigin = XMINT2(dataCoords.x * (tileTexels.x + iBorder * 2) + iBorder, dataCoords.y * (tileTexels.y + iBorder * 2) + iBorder);
+
+	int iNumNeighbours = GetNumNeighbours(kParams.ProbeFilter);
+
+	if (IsProbeOnScrolledPlane(iProbeIndex, kParams) == true || IsProbeActive(iProbeIndex, kParams, kpProbeData) == false)
+	{
+		iNumNeighbours = 0;
+	}
+
+	//Same as the group shared weights in the shader
+	int neighbourIndices[MAX_FILTER_NEIGHBOURS];
+	float neighbourWeights[MAX_FILTER_NEIGHBOURS];
+	XMINT2 neighbourOrigins[MAX_FILTER_NEIGHBOURS];
+
+	for (int i = 0; i < iNumNeighbours; ++i)
+	{
+		neighbourWeights[i] = GetNeighbourWeight(iProbeIndex, i, kParams, kDistanceAtlas, kpProbeData, neighbourIndices[i]);
+
+		XMINT2 neighbourDataCoords = ProbeHelper::GetProbeDataCoords(neighbourIndices[i], kParams.ProbeCounts, kParams.AtlasLayout);
+		neighbourOrigins[i] = XMINT2(neighbourDataCoords.x * (tileTexels.x + iBorder * 2) + iBorder, neighbourDataCoords.y * (tileTexels.y + iBorder * 2) + iBorder);
+	}
+
+	//Octahedral irradiance is gamma encoded so it is filtered in linear space, SH coefficients already are
+	float fGamma = bOctahedral == true ? kParams.IrradianceGammaEncoding : 1.0f;
+
+	for (int y = 0; y < tileTexels.y; ++y)
+	{
+		for (int x = 0; x < tileTexels.x; ++x)
+		{
+			const XMFLOAT4& kCentre = kIrradianceAtlas.GetTexel(tileOrigin.x + x, tileOrigin.y + y);
+
+			if (iNumNeighbours == 0)
+			{
+				filteredAtlas.GetTexel(tileOrigin.x + x, tileOrigin.y + y) = kCentre;
+
+				continue;
+			}
+
+			XMFLOAT3 result = XMFLOAT3(powf(kCentre.x, fGamma), powf(kCentre.y, fGamma), powf(kCentre.z, fGamma));
+			float fTotalWeight = 1.0f;
+
+			for (int i = 0; i < iNumNeighbours; ++i)
+			{
+				if (neighbourWeights[i] <= 0.0f)
+				{
+					continue;
+				}
+
+				const XMFLOAT4& kNeighbour = kIrradianceAtlas.GetTexel(neighbourOrigins[i].x + x, neighbourOrigins[i].y + y);
+
+				result.x += neighbourWeights[i] * powf(kNeighbour.x, fGamma);
+				result.y += neighbourWeights[i] * powf(kNeighbour.y, fGamma);
+				result.z += neighbourWeights[i] * powf(kNeighbour.z, fGamma);
+
+				fTotalWeight += neighbourWeights[i];
+			}
+
+			float fInvGamma = 1.0f / fGamma;
+
+			result = XMFLOAT3(powf(result.x / fTotalWeight, fInvGamma), powf(result.y / fTotalWeight, fInvGamma), powf(result.z / fTotalWeight, fInvGamma));
+
+			filteredAtlas.GetTexel(tileOrigin.x + x, tileOrigin.y + y) = XMFLOAT4(result.x, result.y, result.z, kCentre.w);
+		}
+	}
+}
+
+bool CPUProbeFilter::IsProbeOnScrolledPlane(int iProbeIndex, const RaytracePerFrameCB& kParams)
+{
+	XMINT3 probeCoords = ProbeHelper::GetProbeCoords(iProbeIndex, kParams.ProbeCounts);
+
+	for (int i = 0; i < 3; ++i)
+	{
+		if (ProbeHelper::IsScrolledPlane(probeCoords, i, kParams.ProbeOffsets, kParams.ProbeCounts, kParams.ClearPlane) == true)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool CPUProbeFilter::IsProbeActive(int iProbeIndex, const RaytracePerFrameCB& kParams, const CPUAtlas* kpProbeData)
+{
+	if (kParams.ProbeClassification == 0 || kpProbeData == nullptr)
+	{
+		return true;
+	}
+
+	XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(iProbeIndex, kParams.ProbeCounts, kParams.AtlasLayout);
+
+	return kpProbeData->GetTexel(dataCoords.x, dataCoords.y).w == PROBE_STATE_ACTIVE;
+}
+
+XMFLOAT3 CPUProbeFilter::GetProbePosition(const XMINT3& kProbeCoords, const RaytracePerFrameCB& kParams, const CPUAtlas* kpProbeData)
+{
+	XMFLOAT3 probeCoordsW = ProbeHelper::GetProbeCoordsWorld(kProbeCoords, kParams.VolumePosition, kParams.ProbeOffsets, kParams.ProbeSpacing, kParams.ProbeCounts);
+
+	if (kParams.ProbeRelocation != 0 && kpProbeData != nullptr)
+	{
+		int iProbeIndex = ProbeHelper::GetOffsettedProbeIndex(kProbeCoords, kParams.ProbeCounts, kParams.ProbeOffsets);
+		XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(iProbeIndex, kParams.ProbeCounts, kParams.AtlasLayout);
+
+		const XMFLOAT4& kProbeData = kpProbeData->GetTexel(dataCoords.x, dataCoords.y);
+
+		probeCoordsW.x += kProbeData.x * kParams.ProbeSpacing.x;
+		probeCoordsW.y += kProbeData.y * kParams.ProbeSpacing.y;
+		probeCoordsW.z += kProbeData.z * kParams.ProbeSpacing.z;
+	}
+
+	return probeCoordsW;
+}
+
+XMFLOAT2 CPUProbeFilter::GetDistanceMoments(int iProbeIndex, const XMFLOAT3& kDirection, const RaytracePerFrameCB& kParams, const CPUAtlas& kDistanceAtlas)
+{
+	XMFLOAT2 atlasCoords = ProbeHelper::GetAtlasCoords(iProbeIndex, ProbeHelper::GetOctahedralCoords(kDirection), kParams.NumDistanceTexels, kParams.ProbeCounts, kParams.AtlasLayout);
+
+	XMFLOAT4 moments = CPUIrradianceQuery::SampleLinearWrap(kDistanceAtlas, atlasCoords);
+
+	return XMFLOAT2(2.0f * moments.x, 2.0f * moments.y);
+}
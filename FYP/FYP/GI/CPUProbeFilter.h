@@ -0,0 +1,47 @@
+#pragma once
+
+#include "GI/CPUAtlas.h"
+#include "Shaders/ConstantBuffers.h"
+
+#include <DirectXMath.h>
+
+class ThreadPool;
+
+//CPU port of Shaders/ProbeFilterCompute.hlsl. Filters an irradiance atlas laid out like GIVolume's into a second atlas
+//of the same size, each probe mixed with its 6 or 26 neighbours in the grid depending on kParams.ProbeFilter and
+//weighted by kParams.ProbeFilterStrength, how well the two probes can see each other in the distance atlas and how far
+//apart they are. Only the interior texels are written, run CPUProbeBlender::BlendBorders on the result for the borders
+//the same as GIVolume does. Works on both octahedral and SH irradiance.
+class CPUProbeFilter
+{
+public:
+	CPUProbeFilter(ThreadPool* pThreadPool = nullptr);
+
+	//filteredAtlas is resized to match kIrradianceAtlas if it isn't already. kpProbeData is only read when
+	//classification or relocation is on and can be null otherwise.
+	void FilterProbes(const RaytracePerFrameCB& kParams, const CPUAtlas& kIrradianceAtlas, const CPUAtlas& kDistanceAtlas, const CPUAtlas* kpProbeData, CPUAtlas& filteredAtlas);
+
+	//Weight the neighbour gets relative to the probe itself, 0 if it is skipped. Same for every texel of the probe.
+	static float GetNeighbourWeight(int iProbeIndex, int iNeighbour, const RaytracePerFrameCB& kParams, const CPUAtlas& kDistanceAtlas, const CPUAtlas* kpProbeData, int& iNeighbourIndex);
+
+	static int GetNumNeighbours(int iProbeFilter);
+
+	void SetThreadPool(ThreadPool* pThreadPool);
+
+	float GetLastFilterTime() const;	//In seconds
+
+protected:
+
+private:
+	void FilterProbe(int iProbeIndex, const RaytracePerFrameCB& kParams, const CPUAtlas& kIrradianceAtlas, const CPUAtlas& kDistanceAtlas, const CPUAtlas* kpProbeData, CPUAtlas& filteredAtlas) const;
+
+	static bool IsProbeOnScrolledPlane(int iProbeIndex, const RaytracePerFrameCB& kParams);
+	static bool IsProbeActive(int iProbeIndex, const RaytracePerFrameCB& kParams, const CPUAtlas* kpProbeData);
+
+	static DirectX::XMFLOAT3 GetProbePosition(const DirectX::XMINT3& kProbeCoords, const RaytracePerFrameCB& kParams, const CPUAtlas* kpProbeData);
+	static DirectX::XMFLOAT2 GetDistanceMoments(int iProbeIndex, const DirectX::XMFLOAT3& kDirection, const RaytracePerFrameCB& kParams, const CPUAtlas& kDistanceAtlas);
+
+	ThreadPool* m_pThreadPool = nullptr;
+
+	float m_fLastFilterTime = 0.0f;
+};
@@ -0,0 +1,169 @@
+#include "CPUProbeRelocator.h"
+#include "Commons/ThreadPool.h"
+#include "Helpers/ProbeHelper.h"
+#include "Shaders/Defines.hlsli"
+
+#include <algorithm>
+#include <math.h>
+
+using namespace DirectX;
+
+#define PROBES_PER_TASK 64
+
+CPUProbeRelocator::CPUProbeRelocator(ThreadPool* pThreadPool)
+{
+	m_pThreadPool = pThreadPool;
+}
+
+void CPUProbeRelocator::RelocateProbes(const RaytracePerFrameCB& kParams, const CPUAtlas& kRayData, CPUAtlas& probeData, const uint32_t* kpProbeRayCounts, const uint32_t* kpTracedProbeMask)
+{
+	int iNumProbes = kParams.ProbeCounts.x * kParams.ProbeCounts.y * kParams.ProbeCounts.z;
+
+	std::function<void(int, int)> relocateProbes = [&kParams, &kRayData, &probeData, kpProbeRayCounts, kpTracedProbeMask](int iStart, int iEnd)
+	{
+		for (int i = iStart; i < iEnd; ++i)
+		{
+			XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(i, kParams.ProbeCounts, kParams.AtlasLayout);
+			XMFLOAT4& texel = probeData.GetTexel(dataCoords.x, dataCoords.y);
+
+			//Probes that have just been scrolled round are in a new cell so start again from the centre
+			XMINT3 probeCoords = ProbeHelper::GetProbeCoords(i, kParams.ProbeCounts);
+
+			if (ProbeHelper::IsScrolledPlane(probeCoords, 0, kParams.ProbeOffsets, kParams.ProbeCounts, kParams.ClearPlane) == true ||
+				ProbeHelper::IsScrolledPlane(probeCoords, 1, kParams.ProbeOffsets, kParams.ProbeCounts, kParams.ClearPlane) == true ||
+				ProbeHelper::IsScrolledPlane(probeCoords, 2, kParams.ProbeOffsets, kParams.ProbeCounts, kParams.ClearPlane) == true)
+			{
+				texel = XMFLOAT4(0, 0, 0, 0);
+
+				continue;
+			}
+
+			//Probes left out of this frame's trace still have last time's ray data
+			if (ProbeHelper::WasProbeTraced(i, texel.w, kParams.UseActiveProbeList, kParams.FullProbeUpdate, kParams.TracedProbeMask, kpTracedProbeMask) == false)
+			{
+				continue;
+			}
+
+			XMFLOAT3 offset = XMFLOAT3(texel.x * kParams.ProbeSpacing.x, texel.y * kParams.ProbeSpacing.y, texel.z * kParams.ProbeSpacing.z);
+
+			offset = RelocateProbe(i, offset, kParams, kRayData, kpProbeRayCounts);
+
+			texel.x = offset.x / kParams.ProbeSpacing.x;
+			texel.y = offset.y / kParams.ProbeSpacing.y;
+			texel.z = offset.z / kParams.ProbeSpacing.z;
+		}
+	};
+
+	if (m_pThreadPool != nullptr)
+	{
+		m_pThreadPool->ParallelFor(iNumProbes, PROBES_PER_TASK, relocateProbes);
+	}
+	else
+	{
+		relocateProbes(0, iNumProbes);
+	}
+}
+
+XMFLOAT3 CPUProbeRelocator::RelocateProbe(int iProbeIndex, const XMFLOAT3& kOffset, const RaytracePerFrameCB& kParams, const CPUAtlas& kRayData, const uint32_t* kpProbeRayCounts)
+{
+	int iRaysPerProbe = ProbeHelper::GetProbeNumRays(iProbeIndex, kParams.AdaptiveRays, (int)kParams.RaysPerProbe, kpProbeRayCounts);
+	int iNumBackfaceHits = 0;
+
+	int iClosestBackfaceIndex = -1;
+	int iClosestFrontfaceIndex = -1;
+	int iFarthestFrontfaceIndex = -1;
+
+	float fClosestBackfaceDistance = 1e27f;
+	float fClosestFrontfaceDistance = 1e27f;
+	float fFarthestFrontfaceDistance = 0.0f;
+
+	for (int i = 0; i < iRaysPerProbe; ++i)
+	{
+		float fRayDistance = ProbeHelper::GetRayDistance(kRayData.GetTexel(i, iProbeIndex), kParams.RayDataFormat);
+
+		if (fRayDistance < 0.0f)
+		{
+			++iNumBackfaceHits;
+
+			//Backface distances are stored negated and scaled down
+			fRayDistance *= -5.0f;
+
+			if (fRayDistance < fClosestBackfaceDistance)
+			{
+				fClosestBackfaceDistance = fRayDistance;
+				iClosestBackfaceIndex = i;
+			}
+
+			continue;
+		}
+
+		if (fRayDistance < fClosestFrontfaceDistance)
+		{
+			fClosestFrontfaceDistance = fRayDistance;
+			iClosestFrontfaceIndex = i;
+		}
+
+		if (fRayDistance > fFarthestFrontfaceDistance)
+		{
+			fFarthestFrontfaceDistance = fRayDistance;
+			iFarthestFrontfaceIndex = i;
+		}
+	}
+
+	XMFLOAT3 fullOffset = XMFLOAT3(1e27f, 1e27f, 1e27f);
+	XMFLOAT4 rayRotation = ProbeHelper::GetProbeRayRotation(iProbeIndex, kParams.RayRotation, kParams.PerProbeRayRotation);
+
+	if (iClosestBackfaceIndex != -1 && (iNumBackfaceHits / (float)iRaysPerProbe) > kParams.ProbeBackfaceThreshold)
+	{
+		//Inside geometry so move through the closest backface and a bit further so the probe ends up outside
+		XMFLOAT3 direction = ProbeHelper::GetRayDirection(iClosestBackfaceIndex, iRaysPerProbe, rayRotation);
+		float fDistance = fClosestBackfaceDistance + kParams.ProbeMinFrontfaceDistance * 0.5f;
+
+		fullOffset = XMFLOAT3(kOffset.x + direction.x * fDistance, kOffset.y + direction.y * fDistance, kOffset.z + direction.z * fDistance);
+	}
+	else if (fClosestFrontfaceDistance < kParams.ProbeMinFrontfaceDistance)
+	{
+		//Too close to a surface so move towards the most open direction as long as that is away from the surface
+		XMFLOAT3 closestDirection = ProbeHelper::GetRayDirection(iClosestFrontfaceIndex, iRaysPerProbe, rayRotation);
+		XMFLOAT3 farthestDirection = ProbeHelper::GetRayDirection(iFarthestFrontfaceIndex, iRaysPerProbe, rayRotation);
+
+		if (closestDirection.x * farthestDirection.x + closestDirection.y * farthestDirection.y + closestDirection.z * farthestDirection.z <= 0.0f)
+		{
+			float fDistance = (std::min)(fFarthestFrontfaceDistance, 1.0f);
+
+			fullOffset = XMFLOAT3(kOffset.x + farthestDirection.x * fDistance, kOffset.y + farthestDirection.y * fDistance, kOffset.z + farthestDirection.z * fDistance);
+		}
+	}
+	else if (fClosestFrontfaceDistance > kParams.ProbeMinFrontfaceDistance)
+	{
+		//Plenty of room so drift back towards the centre of the cell
+		float fOffsetLength = sqrtf(kOffset.x * kOffset.x + kOffset.y * kOffset.y + kOffset.z * kOffset.z);
+
+		if (fOffsetLength > 0.0f)
+		{
+			float fScale = 1.0f - (std::min)(fClosestFrontfaceDistance - kParams.ProbeMinFrontfaceDistance, fOffsetLength) / fOffsetLength;
+
+			fullOffset = XMFLOAT3(kOffset.x * fScale, kOffset.y * fScale, kOffset.z * fScale);
+		}
+	}
+
+	//Only accept offsets that stay inside the ellipsoid fitting in the cell so probes never swap places
+	XMFLOAT3 normalizedOffset = XMFLOAT3(fullOffset.x / kParams.ProbeSpacing.x, fullOffset.y / kParams.ProbeSpacing.y, fullOffset.z / kParams.ProbeSpacing.z);
+
+	if (normalizedOffset.x * normalizedOffset.x + normalizedOffset.y * normalizedOffset.y + normalizedOffset.z * normalizedOffset.z < 0.2025f)
+	{
+		return fullOffset;
+	}
+
+	return kOffset;
+}
+
+void CPUProbeRelocator::CreateAtlas(const RaytracePerFrameCB& kParams, CPUAtlas& probeData)
+{
+	probeData.Resize(kParams.ProbeCounts.x * kParams.ProbeCounts.y, kParams.ProbeCounts.z);
+}
+
+void CPUProbeRelocator::SetThreadPool(ThreadPool* pThreadPool)
+{
+	m_pThreadPool = pThreadPool;
+}
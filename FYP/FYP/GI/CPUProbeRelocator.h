@@ -0,0 +1,35 @@
+#pragma once
+
+#include "GI/CPUAtlas.h"
+#include "Shaders/ConstantBuffers.h"
+
+#include <DirectXMath.h>
+#include <stdint.h>
+
+class ThreadPool;
+
+//CPU port of Shaders/ProbeRelocationCompute.hlsl. Reads ray data laid out like GIVolume's ray data atlas and moves
+//each probe's offset in a probe data atlas (one texel per probe, xyz is the offset as a fraction of the probe spacing).
+class CPUProbeRelocator
+{
+public:
+	CPUProbeRelocator(ThreadPool* pThreadPool = nullptr);
+
+	//Probes left out of the trace keep their offset, see ProbeHelper::WasProbeTraced.
+	//kpTracedProbeMask holds a bit per probe like the mask after the active probe list and is only read when kParams.TracedProbeMask is set.
+	//kpProbeRayCounts holds one ray count per probe like the buffer at ProbeRayCountsIndex and is only read with adaptive rays.
+	void RelocateProbes(const RaytracePerFrameCB& kParams, const CPUAtlas& kRayData, CPUAtlas& probeData, const uint32_t* kpProbeRayCounts = nullptr, const uint32_t* kpTracedProbeMask = nullptr);
+
+	//Works out the new offset for a single probe, kOffset and the result are in world units
+	static DirectX::XMFLOAT3 RelocateProbe(int iProbeIndex, const DirectX::XMFLOAT3& kOffset, const RaytracePerFrameCB& kParams, const CPUAtlas& kRayData, const uint32_t* kpProbeRayCounts = nullptr);
+
+	//Sizes the atlas to match the texture GIVolume creates for the same settings
+	static void CreateAtlas(const RaytracePerFrameCB& kParams, CPUAtlas& probeData);
+
+	void SetThreadPool(ThreadPool* pThreadPool);
+
+protected:
+
+private:
+	ThreadPool* m_pThreadPool = nullptr;
+};
@@ -0,0 +1,310 @@
+#include "CPURayTracer.h"
+#include "Commons/Mesh.h"
+#include "Commons/ThreadPool.h"
+#include "Commons/Timer.h"
+#include "GameObjects/GameObject.h"
+#include "Helpers/ProbeHelper.h"
+#include "Helpers/DebugHelper.h"
+#include "Managers/ObjectManager.h"
+#include "Shaders/Defines.hlsli"
+
+#include <algorithm>
+#include <atomic>
+
+using namespace DirectX;
+
+Tag tag = L"CPURayTracer";
+
+#define PROBES_PER_TASK 4
+
+CPURayTracer::CPURayTracer(ThreadPool* pThreadPool) : m_BVH(pThreadPool)
+{
+	m_pThreadPool = pThreadPool;
+}
+
+bool CPURayTracer::BuildScene()
+{
+	m_BVH.Clear();
+
+	for (std::unordered_map<std::string, GameObject*>::iterator it = ObjectManager::GetInstance()->GetGameObjects()->begin(); it != ObjectManager::GetInstance()->GetGameObjects()->end(); ++it)
+	{
+		if (it->second->IsContributeGI() == false || it->second->GetMesh() == nullptr)
+		{
+			continue;
+		}
+
+		m_BVH.AddMesh(it->second->GetMesh(), it->second->GetWorldMatrix());
+	}
+
+	if (m_BVH.Build() == false)
+	{
+		LOG_ERROR(tag, L"Failed to build the CPU BVH for the scene!");
+
+		return false;
+	}
+
+	LOG_VERBOSE(tag, L"Built CPU BVH with %u triangles and %u nodes in %f ms", m_BVH.GetNumTriangles(), m_BVH.GetNumNodes(), m_BVH.GetLastBuildTime() * 1000.0f);
+
+	return true;
+}
+
+void CPURayTracer::TraceProbeRays(const RaytracePerFrameCB& kParams, CPUAtlas& rayData, const CPUAtlas* kpProbeData, const uint32_t* kpProbeRayCounts)
+{
+	PROFILE("CPU Trace Rays");
+
+	Timer timer;
+	timer.Reset();
+
+	int iNumProbes = kParams.ProbeCounts.x * kParams.ProbeCounts.y * kParams.ProbeCounts.z;
+
+	if (rayData.Width != (int)kParams.RaysPerProbe || rayData.Height != iNumProbes)
+	{
+		rayData.Resize(kParams.RaysPerProbe, iNumProbes);
+	}
+
+	std::atomic<UINT64> uiNumRays;
+	std::atomic<UINT64> uiNumHits;
+	std::atomic<UINT64> uiNumBackfaceHits;
+	uiNumRays = 0;
+	uiNumHits = 0;
+	uiNumBackfaceHits = 0;
+
+	if (kParams.ProbeRelocation == 0)
+	{
+		kpProbeData = nullptr;
+	}
+
+	m_RayDirectionTable.Update(kParams.RaysPerProbe, kParams.RayRotation);
+
+	std::function<void(int, int)> traceProbes = [this, &kParams, &rayData, kpProbeData, kpProbeRayCounts, &uiNumRays, &uiNumHits, &uiNumBackfaceHits](int iStart, int iEnd)
+	{
+		CPUTraceStats stats;
+
+		for (int i = iStart; i < iEnd; ++i)
+		{
+			TraceProbe(i, kParams, rayData, kpProbeData, kpProbeRayCounts, stats);
+		}
+
+		uiNumRays += stats.NumRays;
+		uiNumHits += stats.NumHits;
+		uiNumBackfaceHits += stats.NumBackfaceHits;
+	};
+
+	if (m_pThreadPool != nullptr)
+	{
+		m_pThreadPool->ParallelFor(iNumProbes, PROBES_PER_TASK, traceProbes);
+	}
+	else
+	{
+		traceProbes(0, iNumProbes);
+	}
+
+	timer.Tick();
+
+	m_LastTraceStats.NumRays = uiNumRays;
+	m_LastTraceStats.NumHits = uiNumHits;
+	m_LastTraceStats.NumBackfaceHits = uiNumBackfaceHits;
+	m_LastTraceStats.NumThreads = m_pThreadPool != nullptr ? m_pThreadPool->GetNumThreads() + 1 : 1;	//The calling thread helps out as well
+	m_LastTraceStats.Seconds = timer.DeltaTime();
+
+	LOG_VERBOSE(tag, L"Traced %llu rays in %f ms, %f Mrays/s per core over %u threads", m_LastTraceStats.NumRays, m_LastTraceStats.Seconds * 1000.0f, m_LastTraceStats.GetRaysPerSecondPerCore() / 1000000.0, m_LastTraceStats.NumThreads);
+}
+
+void CPURayTracer::TraceProbe(int iProbeIndex, const RaytracePerFrameCB& kParams, CPUAtlas& rayData, const CPUAtlas* kpProbeData, const uint32_t* kpProbeRayCounts, CPUTraceStats& stats) const
+{
+	XMINT3 probeCoords = ProbeHelper::GetProbeCoords(iProbeIndex, kParams.ProbeCounts);
+	XMFLOAT3 probeCoordsW = ProbeHelper::GetProbeCoordsWorld(probeCoords, kParams.VolumePosition, kParams.ProbeOffsets, kParams.ProbeSpacing, kParams.ProbeCounts);
+
+	int iOutputIndex = ProbeHelper::GetOffsettedProbeIndex(probeCoords, kParams.ProbeCounts, kParams.ProbeOffsets);
+
+	if (kpProbeData != nullptr)
+	{
+		XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(iOutputIndex, kParams.ProbeCounts, kParams.AtlasLayout);
+		const XMFLOAT4& kOffset = kpProbeData->GetTexel(dataCoords.x, dataCoords.y);
+
+		probeCoordsW.x += kOffset.x * kParams.ProbeSpacing.x;
+		probeCoordsW.y += kOffset.y * kParams.ProbeSpacing.y;
+		probeCoordsW.z += kOffset.z * kParams.ProbeSpacing.z;
+	}
+
+	int iRaysPerProbe = ProbeHelper::GetProbeNumRays(iOutputIndex, kParams.AdaptiveRays, (int)kParams.RaysPerProbe, kpProbeRayCounts);
+
+	stats.NumRays += iRaysPerProbe;
+
+	const std::vector<XMFLOAT4>& kDirections = m_RayDirectionTable.GetDirections();
+
+	//Probes with fewer rays spread them over the whole sphere so don't share the table's directions, same as the shader
+	//falling back to GetProbeRayDirection when there is no table
+	bool bUseTable = iRaysPerProbe == m_RayDirectionTable.GetRaysPerProbe();
+	XMFLOAT4 rayRotation = ProbeHelper::GetProbeRayRotation(iOutputIndex, kParams.RayRotation, kParams.PerProbeRayRotation);
+
+	CPURayPacket packet;
+	packet.OriginX = XMVectorReplicate(probeCoordsW.x);
+	packet.OriginY = XMVectorReplicate(probeCoordsW.y);
+	packet.OriginZ = XMVectorReplicate(probeCoordsW.z);
+	packet.TMin = XMVectorZero();
+	packet.TMax = XMVectorReplicate(kParams.MaxRayDistance);
+
+	XMFLOAT3 directions[4];
+	XMFLOAT4 directionsX;
+	XMFLOAT4 directionsY;
+	XMFLOAT4 directionsZ;
+	UINT32 masks[4];
+
+	CPUHit hits[4];
+
+	for (int iFirstRay = 0; iFirstRay < iRaysPerProbe; iFirstRay += 4)
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			int iRayIndex = iFirstRay + i;
+
+			directions[i] = XMFLOAT3(0, 0, 1);
+			masks[i] = 0;
+
+			if (iRayIndex < iRaysPerProbe)
+			{
+				if (bUseTable == true)
+				{
+					directions[i] = ProbeHelper::GetTableRayDirection(kDirections[iRayIndex], iOutputIndex, kParams.PerProbeRayRotation);
+				}
+				else
+				{
+					directions[i] = ProbeHelper::GetRayDirection(iRayIndex, iRaysPerProbe, rayRotation);
+				}
+				masks[i] = 0xFFFFFFFF;
+			}
+
+			(&directionsX.x)[i] = directions[i].x;
+			(&directionsY.x)[i] = directions[i].y;
+			(&directionsZ.x)[i] = directions[i].z;
+		}
+
+		packet.DirectionX = XMLoadFloat4(&directionsX);
+		packet.DirectionY = XMLoadFloat4(&directionsY);
+		packet.DirectionZ = XMLoadFloat4(&directionsZ);
+		packet.ActiveMask = XMVectorSetInt(masks[0], masks[1], masks[2], masks[3]);
+
+		m_BVH.TracePacket(packet, hits);
+
+		for (int i = 0; i < 4 && iFirstRay + i < iRaysPerProbe; ++i)
+		{
+			XMFLOAT4& texel = rayData.GetTexel(iFirstRay + i, iOutputIndex);
+
+			if (hits[i].Distance < 0.0f)
+			{
+				StoreRayMiss(texel, kParams.RayDataFormat, kParams.MissRadiance);
+
+				continue;
+			}
+
+			++stats.NumHits;
+
+			if (hits[i].FrontFace == false)
+			{
+				++stats.NumBackfaceHits;
+
+				StoreRayBackfaceHit(texel, hits[i].Distance, kParams.RayDataFormat);
+
+				continue;
+			}
+
+			XMFLOAT3 radiance = XMFLOAT3(0, 0, 0);
+
+			if (m_HitShader)
+			{
+				const CPUTriangleSource& kSource = m_BVH.GetTriangleSource(hits[i].TriangleIndex);
+
+				CPUSurfaceHit surfaceHit;
+				surfaceHit.PosW = XMFLOAT3(probeCoordsW.x + directions[i].x * hits[i].Distance, probeCoordsW.y + directions[i].y * hits[i].Distance, probeCoordsW.z + directions[i].z * hits[i].Distance);
+				surfaceHit.NormalW = m_BVH.GetGeometricNormal(hits[i].TriangleIndex);
+				surfaceHit.DirectionW = directions[i];
+				surfaceHit.Albedo = XMFLOAT3(kSource.m_pPrimitive->m_BaseColour.x, kSource.m_pPrimitive->m_BaseColour.y, kSource.m_pPrimitive->m_BaseColour.z);
+				surfaceHit.HitDistance = hits[i].Distance;
+				surfaceHit.Source = &kSource;
+
+				radiance = m_HitShader(surfaceHit);
+			}
+
+			StoreRayFrontfaceHit(texel, radiance, hits[i].Distance, kParams.RayDataFormat);
+		}
+	}
+}
+
+void CPURayTracer::StoreRayMiss(XMFLOAT4& texel, int iRayDataFormat, const XMFLOAT3& kMissRadiance)
+{
+	if (iRayDataFormat == FORMAT_PROBE_RAY_DATA_R32G32B32A32_FLOAT)
+	{
+		texel = XMFLOAT4(kMissRadiance.x, kMissRadiance.y, kMissRadiance.z, 1e27f);
+	}
+	else if (iRayDataFormat == FORMAT_PROBE_RAY_DATA_R32G32_FLOAT)
+	{
+		texel = XMFLOAT4((float)ProbeHelper::Float3ToUint(kMissRadiance), 1e27f, 0.0f, 0.0f);
+	}
+	else
+	{
+		texel = XMFLOAT4(ProbeHelper::PackRayRadiance(kMissRadiance, iRayDataFormat), 1e27f, 0.0f, 0.0f);
+	}
+}
+
+void CPURayTracer::StoreRayBackfaceHit(XMFLOAT4& texel, float fHitDistance, int iRayDataFormat)
+{
+	//Only the distance is written, same as the shader
+	if (iRayDataFormat == FORMAT_PROBE_RAY_DATA_R32G32B32A32_FLOAT)
+	{
+		texel.w = -fHitDistance * 0.2f;
+	}
+	else
+	{
+		texel.y = -fHitDistance * 0.2f;
+	}
+}
+
+void CPURayTracer::StoreRayFrontfaceHit(XMFLOAT4& texel, XMFLOAT3 radiance, float fHitDistance, int iRayDataFormat)
+{
+	if (iRayDataFormat == FORMAT_PROBE_RAY_DATA_R32G32B32A32_FLOAT)
+	{
+		texel = XMFLOAT4(radiance.x, radiance.y, radiance.z, fHitDistance);
+
+		return;
+	}
+
+	if (iRayDataFormat != FORMAT_PROBE_RAY_DATA_R32G32_FLOAT)
+	{
+		texel = XMFLOAT4(ProbeHelper::PackRayRadiance(radiance, iRayDataFormat), fHitDistance, 0.0f, 0.0f);
+
+		return;
+	}
+
+	//Check if max component will fit into accuracy available
+	const float kfThreshold = 1.0f / 255.0f;
+
+	if ((std::max)(radiance.x, (std::max)(radiance.y, radiance.z)) <= kfThreshold)
+	{
+		radiance = XMFLOAT3(0, 0, 0);
+	}
+
+	texel = XMFLOAT4((float)ProbeHelper::Float3ToUint(radiance), fHitDistance, 0.0f, 0.0f);
+}
+
+void CPURayTracer::SetHitShader(const HitShader& kHitShader)
+{
+	m_HitShader = kHitShader;
+}
+
+void CPURayTracer::SetThreadPool(ThreadPool* pThreadPool)
+{
+	m_pThreadPool = pThreadPool;
+
+	m_BVH.SetThreadPool(pThreadPool);
+}
+
+CPUBVH* CPURayTracer::GetBVH()
+{
+	return &m_BVH;
+}
+
+const CPUTraceStats& CPURayTracer::GetLastTraceStats() const
+{
+	return m_LastTraceStats;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "GI/CPUAtlas.h"
+#include "GI/CPUBVH.h"
+#include "GI/RayDirectionTable.h"
+#include "Shaders/ConstantBuffers.h"
+
+#include <DirectXMath.h>
+#include <functional>
+#include <stdint.h>
+
+class ThreadPool;
+
+//Everything a hit shader gets told about a front face hit
+struct CPUSurfaceHit
+{
+	DirectX::XMFLOAT3 PosW;
+	DirectX::XMFLOAT3 NormalW;	//Geometric normal
+	DirectX::XMFLOAT3 DirectionW;
+	DirectX::XMFLOAT3 Albedo;	//Primitive base colour, textures aren't sampled on the CPU
+
+	float HitDistance;
+
+	const CPUTriangleSource* Source;
+};
+
+struct CPUTraceStats
+{
+	UINT64 NumRays = 0;
+	UINT64 NumHits = 0;
+	UINT64 NumBackfaceHits = 0;
+
+	UINT NumThreads = 1;
+
+	float Seconds = 0.0f;
+
+	double GetRaysPerSecond() const
+	{
+		return Seconds > 0.0f ? NumRays / (double)Seconds : 0.0;
+	}
+
+	double GetRaysPerSecondPerCore() const
+	{
+		return GetRaysPerSecond() / NumThreads;
+	}
+};
+
+//CPU version of Shaders/RayGen.hlsl. Traces every probe's rays against a CPUBVH built from the meshes that contribute
+//to GI and writes the results into a ray data atlas laid out like GIVolume's, so the output can go straight into
+//CPUProbeBlender. Each probe's rays are traced four at a time as a packet.
+class CPURayTracer
+{
+public:
+	typedef std::function<DirectX::XMFLOAT3(const CPUSurfaceHit& kHit)> HitShader;
+
+	CPURayTracer(ThreadPool* pThreadPool = nullptr);
+
+	//Adds every game object that contributes to GI, the same objects the CONTRIBUTE_GI instance mask lets through
+	bool BuildScene();
+
+	//Probes are moved by the offsets in kpProbeData when relocation is on, the same as GetProbeCoordsWorld in the shaders.
+	//kpProbeRayCounts holds one ray count per probe like the buffer at ProbeRayCountsIndex and is only read with adaptive rays.
+	void TraceProbeRays(const RaytracePerFrameCB& kParams, CPUAtlas& rayData, const CPUAtlas* kpProbeData = nullptr, const uint32_t* kpProbeRayCounts = nullptr);
+
+	//Works out the radiance for front face hits. Without one, hits store no radiance so only the distances are useful.
+	void SetHitShader(const HitShader& kHitShader);
+
+	void SetThreadPool(ThreadPool* pThreadPool);
+
+	CPUBVH* GetBVH();
+
+	const CPUTraceStats& GetLastTraceStats() const;
+
+protected:
+
+private:
+	void TraceProbe(int iProbeIndex, const RaytracePerFrameCB& kParams, CPUAtlas& rayData, const CPUAtlas* kpProbeData, const uint32_t* kpProbeRayCounts, CPUTraceStats& stats) const;
+
+	static void StoreRayMiss(DirectX::XMFLOAT4& texel, int iRayDataFormat, const DirectX::XMFLOAT3& kMissRadiance);
+	static void StoreRayBackfaceHit(DirectX::XMFLOAT4& texel, float fHitDistance, int iRayDataFormat);
+	static void StoreRayFrontfaceHit(DirectX::XMFLOAT4& texel, DirectX::XMFLOAT3 radiance, float fHitDistance, int iRayDataFormat);
+
+	CPUBVH m_BVH;
+
+	RayDirectionTable m_RayDirectionTable;
+
+	HitShader m_HitShader;
+
+	ThreadPool* m_pThreadPool = nullptr;
+
+	CPUTraceStats m_LastTraceStats;
+};
@@ -0,0 +1,304 @@
+#include "CPUSHProjector.h"
+#include "Commons/ThreadPool.h"
+#include "Commons/Timer.h"
+#include "Helpers/ProbeHelper.h"
+#include "Helpers/DebugHelper.h"
+#include "Shaders/Defines.hlsli"
+
+#include <algorithm>
+#include <math.h>
+
+using namespace DirectX;
+
+Tag tag = L"CPUSHProjector";
+
+#define PROBES_PER_TASK 16
+
+CPUSHProjector::CPUSHProjector(ThreadPool* pThreadPool)
+{
+	m_pThreadPool = pThreadPool;
+}
+
+void CPUSHProjector::ProjectProbes(const RaytracePerFrameCB& kParams, const CPUAtlas& kRayData, CPUAtlas& shAtlas, CPUAtlas* pHysteresisAtlas, const uint32_t* kpProbeRayCounts)
+{
+	PROFILE("CPU Project SH");
+
+	Timer timer;
+	timer.Reset();
+
+	int iNumProbes = kParams.ProbeCounts.x * kParams.ProbeCounts.y * kParams.ProbeCounts.z;
+
+	if (m_pThreadPool == nullptr)
+	{
+		for (int i = 0; i < iNumProbes; ++i)
+		{
+			ProjectProbe(i, kParams, kRayData, shAtlas, pHysteresisAtlas, kpProbeRayCounts);
+		}
+	}
+	else
+	{
+		m_pThreadPool->ParallelFor(iNumProbes, PROBES_PER_TASK, [this, &kParams, &kRayData, &shAtlas, pHysteresisAtlas, kpProbeRayCounts](int iStart, int iEnd)
+		{
+			for (int i = iStart; i < iEnd; ++i)
+			{
+				ProjectProbe(i, kParams, kRayData, shAtlas, pHysteresisAtlas, kpProbeRayCounts);
+			}
+		});
+	}
+
+	timer.Tick();
+
+	m_fLastProjectionTime = timer.DeltaTime();
+}
+
+void CPUSHProjector::CreateAtlas(const RaytracePerFrameCB& kParams, CPUAtlas& shAtlas)
+{
+	shAtlas.Resize(kParams.ProbeCounts.x * kParams.ProbeCounts.y * kParams.NumSHCoefficients, kParams.ProbeCounts.z);
+}
+
+XMFLOAT3 CPUSHProjector::EvaluateIrradiance(int iProbeIndex, const XMFLOAT3& kDirection, const RaytracePerFrameCB& kParams, const CPUAtlas& kSHAtlas)
+{
+	XMFLOAT3 irradiance = XMFLOAT3(0, 0, 0);
+
+	for (int i = 0; i < kParams.NumSHCoefficients; ++i)
+	{
+		XMINT2 coords = GetSHCoords(iProbeIndex, i, kParams.NumSHCoefficients, kParams.ProbeCounts, kParams.AtlasLayout);
+
+		const XMFLOAT4& kCoefficient = kSHAtlas.GetTexel(coords.x, coords.y);
+
+		float fBasis = GetSHBasis(kDirection, i);
+
+		irradiance.x += kCoefficient.x * fBasis;
+		irradiance.y += kCoefficient.y * fBasis;
+		irradiance.z += kCoefficient.z * fBasis;
+	}
+
+	return irradiance;
+}
+
+float CPUSHProjector::GetSHBasis(const XMFLOAT3& kDirection, int iCoefficient)
+{
+	switch (iCoefficient)
+	{
+	case 0:
+		return 0.282095f;
+	case 1:
+		return 0.488603f * kDirection.y;
+	case 2:
+		return 0.488603f * kDirection.z;
+	case 3:
+		return 0.488603f * kDirection.x;
+	case 4:
+		return 1.092548f * kDirection.x * kDirection.y;
+	case 5:
+		return 1.092548f * kDirection.y * kDirection.z;
+	case 6:
+		return 0.315392f * (3.0f * kDirection.z * kDirection.z - 1.0f);
+	case 7:
+		return 1.092548f * kDirection.x * kDirection.z;
+	default:
+		return 0.546274f * (kDirection.x * kDirection.x - kDirection.y * kDirection.y);
+	}
+}
+
+float CPUSHProjector::GetSHBandFactor(int iCoefficient)
+{
+	if (iCoefficient == 0)
+	{
+		return XM_PI;
+	}
+
+	if (iCoefficient < 4)
+	{
+		return XM_PI * 2.0f / 3.0f;
+	}
+
+	return XM_PI * 0.25f;
+}
+
+XMINT2 CPUSHProjector::GetSHCoords(int iProbeIndex, int iCoefficient, int iNumCoefficients, const XMINT3& kProbeCounts, int iAtlasLayout)
+{
+	XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(iProbeIndex, kProbeCounts, iAtlasLayout);
+
+	return XMINT2(dataCoords.x * iNumCoefficients + iCoefficient, dataCoords.y);
+}
+
+SHEncodingError CPUSHProjector::MeasureError(const RaytracePerFrameCB& kParams, const CPUAtlas& kOctahedralAtlas, const CPUAtlas& kSHAtlas)
+{
+	SHEncodingError error;
+	error.OctahedralTexelsPerProbe = (kParams.NumIrradianceTexels + 2) * (kParams.NumIrradianceTexels + 2);
+	error.SHTexelsPerProbe = kParams.NumSHCoefficients;
+
+	int iNumTexels = kParams.NumIrradianceTexels;
+	int iNumProbes = kParams.ProbeCounts.x * kParams.ProbeCounts.y * kParams.ProbeCounts.z;
+
+	double dSquaredError = 0.0;
+	double dSquaredIrradiance = 0.0;
+	UINT64 uiNumSamples = 0;
+
+	for (int i = 0; i < iNumProbes; ++i)
+	{
+		XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(i, kParams.ProbeCounts, kParams.AtlasLayout);
+
+		for (int y = 0; y < iNumTexels; ++y)
+		{
+			for (int x = 0; x < iNumTexels; ++x)
+			{
+				XMFLOAT3 direction = ProbeHelper::GetOctahedralDirection(ProbeHelper::GetNormalizedOctahedralCoords(XMINT2(x, y), iNumTexels));
+
+				const XMFLOAT4& kTexel = kOctahedralAtlas.GetTexel(1 + dataCoords.x * (iNumTexels + 2) + x, 1 + dataCoords.y * (iNumTexels + 2) + y);
+
+				float octahedral[3] =
+				{
+					powf(kTexel.x, kParams.IrradianceGammaEncoding),
+					powf(kTexel.y, kParams.IrradianceGammaEncoding),
+					powf(kTexel.z, kParams.IrradianceGammaEncoding)
+				};
+
+				XMFLOAT3 sh = EvaluateIrradiance(i, direction, kParams, kSHAtlas);
+
+				for (int j = 0; j < 3; ++j)
+				{
+					//Negative SH ringing is clamped when shading so it is here too
+					double dError = (std::max)((&sh.x)[j], 0.0f) - octahedral[j];
+
+					dSquaredError += dError * dError;
+					dSquaredIrradiance += octahedral[j] * octahedral[j];
+
+					error.MaxError = (std::max)(error.MaxError, fabs(dError));
+				}
+
+				uiNumSamples += 3;
+			}
+		}
+	}
+
+	if (uiNumSamples > 0)
+	{
+		error.RMSError = sqrt(dSquaredError / uiNumSamples);
+		error.RelativeRMSError = dSquaredIrradiance > 0.0 ? sqrt(dSquaredError / dSquaredIrradiance) : 0.0;
+	}
+
+	return error;
+}
+
+void CPUSHProjector::SetThreadPool(ThreadPool* pThreadPool)
+{
+	m_pThreadPool = pThreadPool;
+}
+
+float CPUSHProjector::GetLastProjectionTime() const
+{
+	return m_fLastProjectionTime;
+}
+
+void CPUSHProjector::ProjectProbe(int iProbeIndex, const RaytracePerFrameCB& kParams, const CPUAtlas& kRayData, CPUAtlas& shAtlas, CPUAtlas* pHysteresisAtlas, const uint32_t* kpProbeRayCounts) const
+{
+	int iNumCoefficients = (std::min)(kParams.NumSHCoefficients, MAX_SH_COEFFICIENTS);
+
+	XMFLOAT4* pState = nullptr;
+
+	if (kParams.AdaptiveHysteresis != 0 && pHysteresisAtlas != nullptr)
+	{
+		XMINT2 stateCoords = ProbeHelper::GetProbeDataCoords(iProbeIndex, kParams.ProbeCounts, kParams.AtlasLayout);
+		pState = &pHysteresisAtlas->GetTexel(stateCoords.x, stateCoords.y);
+	}
+
+	XMINT3 probeCoords = ProbeHelper::GetProbeCoords(iProbeIndex, kParams.ProbeCounts);
+
+	bool bClearedPlane = false;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		bClearedPlane |= ProbeHelper::IsScrolledPlane(probeCoords, i, kParams.ProbeOffsets, kParams.ProbeCounts, kParams.ClearPlane);
+	}
+
+	if (bClearedPlane == true)
+	{
+		for (int i = 0; i < iNumCoefficients; ++i)
+		{
+			XMINT2 coords = GetSHCoords(iProbeIndex, i, iNumCoefficients, kParams.ProbeCounts, kParams.AtlasLayout);
+
+			shAtlas.GetTexel(coords.x, coords.y) = XMFLOAT4(0, 0, 0, 0);
+		}
+
+		if (pState != nullptr)
+		{
+			*pState = XMFLOAT4(0, 0, 0, 0);
+		}
+
+		return;
+	}
+
+	int iNumRays = ProbeHelper::GetProbeNumRays(iProbeIndex, kParams.AdaptiveRays, (int)kParams.RaysPerProbe, kpProbeRayCounts);
+
+	UINT32 uiNumBackfaceHits = 0;
+	UINT32 uiMaxBackfaceHits = (UINT32)(iNumRays * 0.1f);
+
+	XMFLOAT4 rayRotation = ProbeHelper::GetProbeRayRotation(iProbeIndex, kParams.RayRotation, kParams.PerProbeRayRotation);
+
+	XMFLOAT3 sums[MAX_SH_COEFFICIENTS] = {};
+	int iNumSamples = 0;
+
+	//Every ray adds to every coefficient so the basis is worked out once per ray rather than once per coefficient
+	for (int i = 0; i < iNumRays; ++i)
+	{
+		const XMFLOAT4& kTexel = kRayData.GetTexel(i, iProbeIndex);
+
+		XMFLOAT3 radiance = ProbeHelper::GetRayRadiance(kTexel, kParams.RayDataFormat);
+		float fDistance = ProbeHelper::GetRayDistance(kTexel, kParams.RayDataFormat);
+
+		if (fDistance < 0.0f)
+		{
+			++uiNumBackfaceHits;
+
+			if (uiNumBackfaceHits >= uiMaxBackfaceHits)
+			{
+				//Too many backface hits so the probe is left as it is
+				return;
+			}
+
+			continue;
+		}
+
+		XMFLOAT3 direction = ProbeHelper::GetRayDirection(i, iNumRays, rayRotation);
+
+		for (int j = 0; j < iNumCoefficients; ++j)
+		{
+			float fBasis = GetSHBasis(direction, j);
+
+			sums[j].x += radiance.x * fBasis;
+			sums[j].y += radiance.y * fBasis;
+			sums[j].z += radiance.z * fBasis;
+		}
+
+		++iNumSamples;
+	}
+
+	float fHysteresis = kParams.Hysteresis;
+
+	for (int i = 0; i < iNumCoefficients; ++i)
+	{
+		//Monte Carlo estimate over the sphere, halved to match the octahedral blend
+		float fScale = (2.0f * GetSHBandFactor(i)) / (float)(std::max)(iNumSamples, 1);
+
+		XMINT2 coords = GetSHCoords(iProbeIndex, i, iNumCoefficients, kParams.ProbeCounts, kParams.AtlasLayout);
+
+		XMFLOAT4& texel = shAtlas.GetTexel(coords.x, coords.y);
+
+		XMFLOAT3 result = XMFLOAT3(sums[i].x * fScale, sums[i].y * fScale, sums[i].z * fScale);
+
+		//The first coefficient is the probe's mean irradiance, same as the shader
+		if (i == 0 && pState != nullptr)
+		{
+			float fChange = ProbeHelper::GetProbeIrradianceChange(ProbeHelper::GetLuminance(result), ProbeHelper::GetLuminance(XMFLOAT3(texel.x, texel.y, texel.z)), 1);
+
+			XMFLOAT2 state = ProbeHelper::UpdateProbeHysteresis(XMFLOAT2(pState->x, pState->y), fChange, kParams.MinHysteresis, kParams.Hysteresis, kParams.HysteresisRiseRate, kParams.HysteresisChangeThreshold);
+
+			*pState = XMFLOAT4(state.x, state.y, 0.0f, 0.0f);
+			fHysteresis = state.x;
+		}
+
+		texel = XMFLOAT4(result.x + fHysteresis * (texel.x - result.x), result.y + fHysteresis * (texel.y - result.y), result.z + fHysteresis * (texel.z - result.z), 1.0f);
+	}
+}
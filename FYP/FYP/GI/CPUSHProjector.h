@@ -0,0 +1,62 @@
+#pragma once
+
+#include "GI/CPUAtlas.h"
+#include "Shaders/ConstantBuffers.h"
+
+#include <DirectXMath.h>
+#include <stdint.h>
+
+class ThreadPool;
+
+struct SHEncodingError
+{
+	//Linear irradiance at the centre of every interior octahedral texel of every probe
+	double RMSError = 0.0;
+	double MaxError = 0.0;
+	double RelativeRMSError = 0.0;	//RMS error over the RMS of the octahedral irradiance
+
+	//Border texels included, multiply by the atlas format's texel size for bytes
+	int OctahedralTexelsPerProbe = 0;
+	int SHTexelsPerProbe = 0;
+};
+
+//CPU port of Shaders/ProbeSHProjectionCompute.hlsl and Shaders/SphericalHarmonics.hlsl. Projects ray data laid out
+//like GIVolume's ray data atlas into an SH irradiance atlas laid out the same way as GIVolume's irradiance atlas is when
+//it uses an SH encoding, kParams.NumSHCoefficients picks L1 or L2. MeasureError compares the result against the
+//octahedral atlas CPUProbeBlender blends from the same rays.
+class CPUSHProjector
+{
+public:
+	CPUSHProjector(ThreadPool* pThreadPool = nullptr);
+
+	//pHysteresisAtlas holds the per probe hysteresis state and is only used when kParams.AdaptiveHysteresis is set, it's
+	//laid out like the probe data atlas, see CPUProbeBlender::CreateHysteresisAtlas. kpProbeRayCounts holds one ray count
+	//per probe like the buffer at ProbeRayCountsIndex and is only read with adaptive rays.
+	void ProjectProbes(const RaytracePerFrameCB& kParams, const CPUAtlas& kRayData, CPUAtlas& shAtlas, CPUAtlas* pHysteresisAtlas = nullptr, const uint32_t* kpProbeRayCounts = nullptr);
+
+	//Sizes the atlas to match the texture GIVolume creates for the same settings
+	static void CreateAtlas(const RaytracePerFrameCB& kParams, CPUAtlas& shAtlas);
+
+	//Same as EvaluateSHIrradiance in Shaders/SphericalHarmonics.hlsl, comparable with a decoded octahedral texel
+	static DirectX::XMFLOAT3 EvaluateIrradiance(int iProbeIndex, const DirectX::XMFLOAT3& kDirection, const RaytracePerFrameCB& kParams, const CPUAtlas& kSHAtlas);
+
+	static float GetSHBasis(const DirectX::XMFLOAT3& kDirection, int iCoefficient);
+	static float GetSHBandFactor(int iCoefficient);
+	static DirectX::XMINT2 GetSHCoords(int iProbeIndex, int iCoefficient, int iNumCoefficients, const DirectX::XMINT3& kProbeCounts, int iAtlasLayout);
+
+	//Both atlases should be blended from the same ray data with no hysteresis for the error to mean anything
+	static SHEncodingError MeasureError(const RaytracePerFrameCB& kParams, const CPUAtlas& kOctahedralAtlas, const CPUAtlas& kSHAtlas);
+
+	void SetThreadPool(ThreadPool* pThreadPool);
+
+	float GetLastProjectionTime() const;	//In seconds
+
+protected:
+
+private:
+	void ProjectProbe(int iProbeIndex, const RaytracePerFrameCB& kParams, const CPUAtlas& kRayData, CPUAtlas& shAtlas, CPUAtlas* pHysteresisAtlas, const uint32_t* kpProbeRayCounts) const;
+
+	ThreadPool* m_pThreadPool = nullptr;
+
+	float m_fLastProjectionTime = 0.0f;
+};
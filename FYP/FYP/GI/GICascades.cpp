@@ -0,0 +1,163 @@
+#include "GICascades.h"
+#include "Shaders/Defines.hlsli"
+
+#include <algorithm>
+#include <math.h>
+
+using namespace DirectX;
+
+GICascades::GICascades()
+{
+}
+
+void GICascades::Init(int iNumCascades, const XMFLOAT3& kPosition, const XMFLOAT3& kProbeSpacing, const XMINT3& kProbeCounts, const XMINT3& kProbeOffsets)
+{
+	iNumCascades = (std::max)(1, (std::min)(iNumCascades, MAX_GI_CASCADES));
+
+	m_Cascades.clear();
+	m_Cascades.resize(iNumCascades);
+
+	for (int i = 0; i < iNumCascades; ++i)
+	{
+		float fScale = (float)(1 << i);
+
+		m_Cascades[i].Position = kPosition;
+		m_Cascades[i].ProbeSpacing = XMFLOAT3(kProbeSpacing.x * fScale, kProbeSpacing.y * fScale, kProbeSpacing.z * fScale);
+		m_Cascades[i].ProbeCounts = kProbeCounts;
+		m_Cascades[i].ProbeOffsets = i == 0 ? kProbeOffsets : XMINT3(0, 0, 0);
+		m_Cascades[i].UpdateInterval = 1 << i;
+	}
+}
+
+XMINT3 GICascades::Scroll(XMFLOAT3& position, XMINT3& probeOffsets, const XMINT3& kProbeCounts, const XMFLOAT3& kProbeSpacing, const XMFLOAT3& kAnchor)
+{
+	XMINT3 scrolledPlanes = XMINT3(0, 0, 0);
+
+	XMFLOAT3 offsettedPos = XMFLOAT3(position.x + kProbeSpacing.x * probeOffsets.x, position.y + kProbeSpacing.y * probeOffsets.y, position.z + kProbeSpacing.z * probeOffsets.z);
+	XMFLOAT3 toAnchor = XMFLOAT3(kAnchor.x - offsettedPos.x, kAnchor.y - offsettedPos.y, kAnchor.z - offsettedPos.z);
+
+	XMINT3 toAnchorSigns = XMINT3(toAnchor.x < 0 ? -1 : 1, toAnchor.y < 0 ? -1 : 1, toAnchor.z < 0 ? -1 : 1);
+
+	//Whole probes only, rounded towards zero
+	XMINT3 shouldScroll;
+	shouldScroll.x = (int)(toAnchor.x / kProbeSpacing.x);
+	shouldScroll.y = (int)(toAnchor.y / kProbeSpacing.y);
+	shouldScroll.z = (int)(toAnchor.z / kProbeSpacing.z);
+
+	if (shouldScroll.x != 0)
+	{
+		probeOffsets.x += shouldScroll.x;
+		scrolledPlanes.x = 1;
+
+		Offset(position.x, probeOffsets.x, kProbeCounts.x, kProbeSpacing.x, toAnchorSigns.x);
+	}
+
+	if (shouldScroll.y != 0)
+	{
+		probeOffsets.y += shouldScroll.y;
+		scrolledPlanes.y = 1;
+
+		Offset(position.y, probeOffsets.y, kProbeCounts.y, kProbeSpacing.y, toAnchorSigns.y);
+	}
+
+	if (shouldScroll.z != 0)
+	{
+		probeOffsets.z += shouldScroll.z;
+		scrolledPlanes.z = 1;
+
+		Offset(position.z, probeOffsets.z, kProbeCounts.z, kProbeSpacing.z, toAnchorSigns.z);
+	}
+
+	return scrolledPlanes;
+}
+
+XMINT3 GICascades::Scroll(int iCascade, const XMFLOAT3& kAnchor)
+{
+	GICascade& cascade = m_Cascades[iCascade];
+
+	return Scroll(cascade.Position, cascade.ProbeOffsets, cascade.ProbeCounts, cascade.ProbeSpacing, kAnchor);
+}
+
+float GICascades::GetBlendWeight(const XMFLOAT3& kPosW, const GICascade& kCascade)
+{
+	XMFLOAT3 deltaPosW;
+	deltaPosW.x = fabsf(kPosW.x - (kCascade.Position.x + kCascade.ProbeOffsets.x * kCascade.ProbeSpacing.x)) - (kCascade.ProbeSpacing.x * (kCascade.ProbeCounts.x - 1)) * 0.5f;
+	deltaPosW.y = fabsf(kPosW.y - (kCascade.Position.y + kCascade.ProbeOffsets.y * kCascade.ProbeSpacing.y)) - (kCascade.ProbeSpacing.y * (kCascade.ProbeCounts.y - 1)) * 0.5f;
+	deltaPosW.z = fabsf(kPosW.z - (kCascade.Position.z + kCascade.ProbeOffsets.z * kCascade.ProbeSpacing.z)) - (kCascade.ProbeSpacing.z * (kCascade.ProbeCounts.z - 1)) * 0.5f;
+
+	if (deltaPosW.x < 0.0f && deltaPosW.y < 0.0f && deltaPosW.z < 0.0f)
+	{
+		return 1.0f;
+	}
+
+	float fWeight = 1.0f;
+	fWeight *= 1.0f - (std::max)(0.0f, (std::min)(deltaPosW.x / kCascade.ProbeSpacing.x, 1.0f));
+	fWeight *= 1.0f - (std::max)(0.0f, (std::min)(deltaPosW.y / kCascade.ProbeSpacing.y, 1.0f));
+	fWeight *= 1.0f - (std::max)(0.0f, (std::min)(deltaPosW.z / kCascade.ProbeSpacing.z, 1.0f));
+
+	return fWeight;
+}
+
+int GICascades::SelectCascade(const XMFLOAT3& kPosW) const
+{
+	for (int i = 0; i < (int)m_Cascades.size(); ++i)
+	{
+		if (GetBlendWeight(kPosW, m_Cascades[i]) > 0.0f)
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+void GICascades::GetCascadeWeights(const XMFLOAT3& kPosW, std::vector<float>& weights) const
+{
+	weights.assign(m_Cascades.size(), 0.0f);
+
+	float fRemaining = 1.0f;
+
+	for (int i = 0; i < (int)m_Cascades.size() && fRemaining > 0.0f; ++i)
+	{
+		weights[i] = GetBlendWeight(kPosW, m_Cascades[i]) * fRemaining;
+
+		fRemaining -= weights[i];
+	}
+}
+
+bool GICascades::ShouldUpdate(int iCascade, UINT64 uiFrame) const
+{
+	int iInterval = (std::max)(1, m_Cascades[iCascade].UpdateInterval);
+
+	return (uiFrame + iCascade) % iInterval == 0;
+}
+
+int GICascades::GetNumCascades() const
+{
+	return (int)m_Cascades.size();
+}
+
+const GICascade& GICascades::GetCascade(int iCascade) const
+{
+	return m_Cascades[iCascade];
+}
+
+void GICascades::SetCascadeTransform(int iCascade, const XMFLOAT3& kPosition, const XMINT3& kProbeOffsets)
+{
+	m_Cascades[iCascade].Position = kPosition;
+	m_Cascades[iCascade].ProbeOffsets = kProbeOffsets;
+}
+
+void GICascades::SetUpdateInterval(int iCascade, int iUpdateInterval)
+{
+	m_Cascades[iCascade].UpdateInterval = (std::max)(1, iUpdateInterval);
+}
+
+void GICascades::Offset(float& fPos, int& iProbeOffset, int iProbeCount, float fProbeSpacing, int iDirection)
+{
+	if (iProbeOffset != 0 && iProbeOffset % iProbeCount == 0)
+	{
+		fPos += iProbeCount * iDirection * fProbeSpacing;
+		iProbeOffset = 0;
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <DirectXMath.h>
+
+#include <vector>
+
+struct GICascade
+{
+	DirectX::XMFLOAT3 Position = DirectX::XMFLOAT3();
+	DirectX::XMFLOAT3 ProbeSpacing = DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f);
+
+	DirectX::XMINT3 ProbeCounts = DirectX::XMINT3(1, 1, 1);
+	DirectX::XMINT3 ProbeOffsets = DirectX::XMINT3(0, 0, 0);
+
+	//Cascade is traced and blended once every this many frames
+	int UpdateInterval = 1;
+};
+
+//Layout of the nested GI volumes that follow the camera around. Every cascade has the same probe counts as cascade 0
+//and double the spacing of the one inside it, so each cascade covers eight times the volume of the last. Cascades
+//scroll on their own with the same offsets GIVolume uses and are shaded finest first, each one fading out over its
+//last probe spacing into the next cascade out. Nothing in here touches D3D12 so it can be used outside the renderer.
+class GICascades
+{
+public:
+	GICascades();
+
+	//Cascade i gets 2^i times kProbeSpacing and an update interval of 2^i frames, all centred on kPosition
+	void Init(int iNumCascades, const DirectX::XMFLOAT3& kPosition, const DirectX::XMFLOAT3& kProbeSpacing, const DirectX::XMINT3& kProbeCounts, const DirectX::XMINT3& kProbeOffsets);
+
+	//Moves the volume a whole number of probes towards kAnchor, wrapping the offsets and moving the position once a
+	//full volume has been scrolled. Planes that moved get a 1 in the returned value so the blend can clear them.
+	static DirectX::XMINT3 Scroll(DirectX::XMFLOAT3& position, DirectX::XMINT3& probeOffsets, const DirectX::XMINT3& kProbeCounts, const DirectX::XMFLOAT3& kProbeSpacing, const DirectX::XMFLOAT3& kAnchor);
+	DirectX::XMINT3 Scroll(int iCascade, const DirectX::XMFLOAT3& kAnchor);
+
+	//Same as GetBlendWeight in Shaders/ProbeHelper.hlsl, 1 inside the volume falling to 0 one probe spacing outside it
+	static float GetBlendWeight(const DirectX::XMFLOAT3& kPosW, const GICascade& kCascade);
+
+	//Finest cascade that covers kPosW, -1 if it is outside all of them
+	int SelectCascade(const DirectX::XMFLOAT3& kPosW) const;
+
+	//How much each cascade adds to the irradiance at kPosW, matching the light pass. Finer cascades take what they can
+	//and the next one out gets what is left, so the weights add up to the outermost cascade's blend weight.
+	void GetCascadeWeights(const DirectX::XMFLOAT3& kPosW, std::vector<float>& weights) const;
+
+	//Cascades are staggered so the coarse ones don't all land on the same frame
+	bool ShouldUpdate(int iCascade, UINT64 uiFrame) const;
+
+	//Getters
+	int GetNumCascades() const;
+
+	const GICascade& GetCascade(int iCascade) const;
+
+	//Setters
+	void SetCascadeTransform(int iCascade, const DirectX::XMFLOAT3& kPosition, const DirectX::XMINT3& kProbeOffsets);
+	void SetUpdateInterval(int iCascade, int iUpdateInterval);
+
+protected:
+
+private:
+	static void Offset(float& fPos, int& iProbeOffset, int iProbeCount, float fProbeSpacing, int iDirection);
+
+	std::vector<GICascade> m_Cascades;
+};
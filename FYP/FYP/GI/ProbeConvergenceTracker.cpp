@@ -0,0 +1,77 @@
+#include "ProbeConvergenceTracker.h"
+#include "Helpers/ProbeHelper.h"
+
+using namespace DirectX;
+
+ProbeConvergenceTracker::ProbeConvergenceTracker()
+{
+}
+
+void ProbeConvergenceTracker::Update(const std::vector<XMFLOAT2>& kStates, float fMinHysteresis, float fChangeThreshold)
+{
+	m_States = kStates;
+	m_fChangeThreshold = fChangeThreshold;
+
+	m_Stats = ProbeConvergenceStats();
+	m_Stats.NumProbes = (int)m_States.size();
+
+	if (m_Stats.NumProbes == 0)
+	{
+		return;
+	}
+
+	double dTotalHysteresis = 0.0;
+	double dTotalConvergence = 0.0;
+
+	for (int i = 0; i < m_Stats.NumProbes; ++i)
+	{
+		float fConvergence = ProbeHelper::GetProbeConvergence(m_States[i], m_fChangeThreshold);
+
+		if (fConvergence > 0.75f)
+		{
+			++m_Stats.NumConverged;
+		}
+
+		if (m_States[i].x <= fMinHysteresis)
+		{
+			++m_Stats.NumReset;
+		}
+
+		dTotalHysteresis += m_States[i].x;
+		dTotalConvergence += fConvergence;
+	}
+
+	m_Stats.MeanHysteresis = (float)(dTotalHysteresis / m_Stats.NumProbes);
+	m_Stats.MeanConvergence = (float)(dTotalConvergence / m_Stats.NumProbes);
+}
+
+void ProbeConvergenceTracker::Reset()
+{
+	m_States.clear();
+	m_Stats = ProbeConvergenceStats();
+}
+
+float ProbeConvergenceTracker::GetProbeHysteresis(int iProbeIndex) const
+{
+	if (iProbeIndex < 0 || iProbeIndex >= (int)m_States.size())
+	{
+		return 0.0f;
+	}
+
+	return m_States[iProbeIndex].x;
+}
+
+float ProbeConvergenceTracker::GetProbeConvergence(int iProbeIndex) const
+{
+	if (iProbeIndex < 0 || iProbeIndex >= (int)m_States.size())
+	{
+		return 0.0f;
+	}
+
+	return ProbeHelper::GetProbeConvergence(m_States[iProbeIndex], m_fChangeThreshold);
+}
+
+const ProbeConvergenceStats& ProbeConvergenceTracker::GetStats() const
+{
+	return m_Stats;
+}
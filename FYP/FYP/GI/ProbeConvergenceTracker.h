@@ -0,0 +1,43 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <vector>
+
+struct ProbeConvergenceStats
+{
+	int NumProbes = 0;
+	int NumConverged = 0;	//Convergence above 0.75
+	int NumReset = 0;		//Hysteresis snapped down to the minimum by a lighting change
+
+	float MeanHysteresis = 0.0f;
+	float MeanConvergence = 0.0f;
+};
+
+//Keeps the last read back copy of the per probe adaptive hysteresis state, x the probe's hysteresis and y its smoothed
+//irradiance change, see UpdateProbeHysteresis in Shaders/ProbeHelper.hlsl. Convergence is 1 when a probe's irradiance
+//has stopped changing and 0 when it changes by the change threshold or more each frame.
+class ProbeConvergenceTracker
+{
+public:
+	ProbeConvergenceTracker();
+
+	//kStates is per probe in probe index order
+	void Update(const std::vector<DirectX::XMFLOAT2>& kStates, float fMinHysteresis, float fChangeThreshold);
+	void Reset();
+
+	//Getters
+	float GetProbeHysteresis(int iProbeIndex) const;
+	float GetProbeConvergence(int iProbeIndex) const;
+
+	const ProbeConvergenceStats& GetStats() const;
+
+protected:
+
+private:
+	std::vector<DirectX::XMFLOAT2> m_States;
+
+	float m_fChangeThreshold = 0.1f;
+
+	ProbeConvergenceStats m_Stats;
+};
@@ -0,0 +1,149 @@
+#include "ProbeFilterBenchmark.h"
+#include "Helpers/ProbeHelper.h"
+#include "Helpers/DebugHelper.h"
+
+#include <algorithm>
+#include <math.h>
+
+using namespace DirectX;
+
+Tag tag = L"ProbeFilterBenchmark";
+
+ProbeFilterBenchmark::ProbeFilterBenchmark(ThreadPool* pThreadPool) : m_Filter(pThreadPool)
+{
+}
+
+ProbeFilterStats ProbeFilterBenchmark::Run(const RaytracePerFrameCB& kParams, const std::vector<CPUAtlas>& kFrames, const CPUAtlas& kDistanceAtlas, const CPUAtlas* kpProbeData)
+{
+	ProbeFilterStats stats;
+	stats.ProbeFilter = kParams.ProbeFilter;
+	stats.Strength = kParams.ProbeFilterStrength;
+	stats.NumFrames = (int)kFrames.size();
+
+	if (kFrames.size() < 2)
+	{
+		LOG_WARNING(tag, L"At least two frames are needed to measure any variance!");
+
+		return stats;
+	}
+
+	std::vector<double> unfilteredSums;
+	std::vector<double> unfilteredSquaredSums;
+	std::vector<double> filteredSums;
+	std::vector<double> filteredSquaredSums;
+
+	for (int i = 0; i < (int)kFrames.size(); ++i)
+	{
+		Accumulate(kParams, kFrames[i], unfilteredSums, unfilteredSquaredSums);
+
+		m_Filter.FilterProbes(kParams, kFrames[i], kDistanceAtlas, kpProbeData, m_FilteredAtlas);
+		stats.Seconds += m_Filter.GetLastFilterTime();
+
+		Accumulate(kParams, m_FilteredAtlas, filteredSums, filteredSquaredSums);
+	}
+
+	stats.UnfilteredVariance = GetMeanVariance(unfilteredSums, unfilteredSquaredSums, stats.NumFrames);
+	stats.FilteredVariance = GetMeanVariance(filteredSums, filteredSquaredSums, stats.NumFrames);
+	stats.VarianceReduction = stats.FilteredVariance > 0.0 ? stats.UnfilteredVariance / stats.FilteredVariance : 1.0;
+
+	double dSquaredBias = 0.0;
+	double dSquaredMean = 0.0;
+
+	for (size_t i = 0; i < unfilteredSums.size(); ++i)
+	{
+		double dUnfilteredMean = unfilteredSums[i] / stats.NumFrames;
+		double dBias = filteredSums[i] / stats.NumFrames - dUnfilteredMean;
+
+		dSquaredBias += dBias * dBias;
+		dSquaredMean += dUnfilteredMean * dUnfilteredMean;
+	}
+
+	stats.RelativeBias = dSquaredMean > 0.0 ? sqrt(dSquaredBias / dSquaredMean) : 0.0;
+
+	return stats;
+}
+
+std::vector<ProbeFilterStats> ProbeFilterBenchmark::RunAll(const RaytracePerFrameCB& kParams, const std::vector<CPUAtlas>& kFrames, const CPUAtlas& kDistanceAtlas, const CPUAtlas* kpProbeData, float fStrength)
+{
+	std::vector<ProbeFilterStats> results;
+
+	RaytracePerFrameCB params = kParams;
+	params.ProbeFilterStrength = fStrength;
+
+	for (int iFilter = PROBE_FILTER_6_NEIGHBOURS; iFilter <= PROBE_FILTER_26_NEIGHBOURS; ++iFilter)
+	{
+		params.ProbeFilter = iFilter;
+
+		results.push_back(Run(params, kFrames, kDistanceAtlas, kpProbeData));
+	}
+
+	return results;
+}
+
+void ProbeFilterBenchmark::SetThreadPool(ThreadPool* pThreadPool)
+{
+	m_Filter.SetThreadPool(pThreadPool);
+}
+
+void ProbeFilterBenchmark::Accumulate(const RaytracePerFrameCB& kParams, const CPUAtlas& kAtlas, std::vector<double>& sums, std::vector<double>& squaredSums) const
+{
+	bool bOctahedral = kParams.IrradianceEncoding == PROBE_IRRADIANCE_ENCODING_OCTAHEDRAL;
+
+	XMINT2 tileTexels = bOctahedral == true ? XMINT2(kParams.NumIrradianceTexels, kParams.NumIrradianceTexels) : XMINT2(kParams.NumSHCoefficients, 1);
+	int iBorder = bOctahedral == true ? 1 : 0;
+	float fGamma = bOctahedral == true ? kParams.IrradianceGammaEncoding : 1.0f;
+
+	int iNumProbes = kParams.ProbeCounts.x * kParams.ProbeCounts.y * kParams.ProbeCounts.z;
+	size_t uiNumValues = (size_t)iNumProbes * tileTexels.x * tileTexels.y * 3;
+
+	if (sums.size() != uiNumValues)
+	{
+		sums.assign(uiNumValues, 0.0);
+		squaredSums.assign(uiNumValues, 0.0);
+	}
+
+	size_t uiValue = 0;
+
+	for (int i = 0; i < iNumProbes; ++i)
+	{
+		XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(i, kParams.ProbeCounts, kParams.AtlasLayout);
+
+		for (int y = 0; y < tileTexels.y; ++y)
+		{
+			for (int x = 0; x < tileTexels.x; ++x)
+			{
+				const XMFLOAT4& kTexel = kAtlas.GetTexel(dataCoords.x * (tileTexels.x + iBorder * 2) + iBorder + x, dataCoords.y * (tileTexels.y + iBorder * 2) + iBorder + y);
+
+				for (int j = 0; j < 3; ++j)
+				{
+					double dValue = powf((&kTexel.x)[j], fGamma);
+
+					sums[uiValue] += dValue;
+					squaredSums[uiValue] += dValue * dValue;
+
+					++uiValue;
+				}
+			}
+		}
+	}
+}
+
+double ProbeFilterBenchmark::GetMeanVariance(const std::vector<double>& kSums, const std::vector<double>& kSquaredSums, int iNumFrames)
+{
+	if (kSums.empty() == true)
+	{
+		return 0.0;
+	}
+
+	double dVariance = 0.0;
+
+	for (size_t i = 0; i < kSums.size(); ++i)
+	{
+		double dMean = kSums[i] / iNumFrames;
+
+		//Sample variance, the frames are all there is to go on
+		dVariance += (std::max)(0.0, (kSquaredSums[i] - dMean * kSums[i]) / (iNumFrames - 1));
+	}
+
+	return dVariance / kSums.size();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "GI/CPUAtlas.h"
+#include "GI/CPUProbeFilter.h"
+#include "Shaders/ConstantBuffers.h"
+#include "Shaders/Defines.hlsli"
+
+#include <vector>
+
+class ThreadPool;
+
+struct ProbeFilterStats
+{
+	int ProbeFilter = PROBE_FILTER_NONE;
+	float Strength = 0.0f;
+
+	int NumFrames = 0;
+
+	//Variance of each interior texel's linear irradiance across the frames, averaged over every texel and channel
+	double UnfilteredVariance = 0.0;
+	double FilteredVariance = 0.0;
+	double VarianceReduction = 1.0;	//Unfiltered over filtered variance
+
+	//How far the filter moves each texel's mean over the frames, relative to the RMS unfiltered mean. This is the light
+	//that leaks between neighbours and has to be weighed against the variance it takes away.
+	double RelativeBias = 0.0;
+
+	float Seconds = 0.0f;	//Spent filtering every frame
+};
+
+//Measures how much of the frame to frame noise in captured irradiance atlases the probe filter takes out and how
+//much it blurs the result in exchange. kFrames are irradiance atlases of the same volume captured over consecutive
+//frames, e.g. read out of AtlasSnapshot files or blended by CPUProbeBlender, all filtered against the same distance
+//and probe data atlases. With hysteresis the frames are already mostly averaged, blend them without it for the
+//variance to be the ray noise on its own.
+class ProbeFilterBenchmark
+{
+public:
+	ProbeFilterBenchmark(ThreadPool* pThreadPool = nullptr);
+
+	//kParams.ProbeFilter and kParams.ProbeFilterStrength pick the filter, irradiance is compared in linear space
+	ProbeFilterStats Run(const RaytracePerFrameCB& kParams, const std::vector<CPUAtlas>& kFrames, const CPUAtlas& kDistanceAtlas, const CPUAtlas* kpProbeData);
+
+	//Both neighbourhoods at the given strength
+	std::vector<ProbeFilterStats> RunAll(const RaytracePerFrameCB& kParams, const std::vector<CPUAtlas>& kFrames, const CPUAtlas& kDistanceAtlas, const CPUAtlas* kpProbeData, float fStrength);
+
+	void SetThreadPool(ThreadPool* pThreadPool);
+
+protected:
+
+private:
+	//Running sums over the frames for every interior texel and channel in the order the texels are visited
+	void Accumulate(const RaytracePerFrameCB& kParams, const CPUAtlas& kAtlas, std::vector<double>& sums, std::vector<double>& squaredSums) const;
+
+	//Mean variance across the frames for the sums
+	static double GetMeanVariance(const std::vector<double>& kSums, const std::vector<double>& kSquaredSums, int iNumFrames);
+
+	CPUProbeFilter m_Filter;
+
+	CPUAtlas m_FilteredAtlas;
+};
@@ -0,0 +1,252 @@
+#include "ProbeScheduler.h"
+#include "Helpers/ProbeHelper.h"
+
+#include <algorithm>
+#include <functional>
+#include <math.h>
+
+using namespace DirectX;
+
+ProbeScheduler::ProbeScheduler()
+{
+}
+
+void ProbeScheduler::Init(int iNumProbes)
+{
+	m_Ages.assign(iNumProbes, 0);
+	m_Changes.assign(iNumProbes, 0.0f);
+	m_Invalidated.assign(iNumProbes, false);
+	m_Asleep.assign(iNumProbes, false);
+	m_Picked.assign(iNumProbes, false);
+
+	m_iRoundRobinCursor = 0;
+
+	m_ScheduledProbes.clear();
+	m_ScheduledProbes.reserve(iNumProbes);
+	m_Candidates.reserve(iNumProbes);
+}
+
+const std::vector<UINT>& ProbeScheduler::Schedule(const XMFLOAT3& kVolumePosition, const XMFLOAT3& kProbeSpacing, const XMINT3& kProbeCounts, const XMINT3& kProbeOffsets, const XMFLOAT3& kCameraPosition)
+{
+	int iNumProbes = GetNumProbes();
+
+	m_ScheduledProbes.clear();
+
+	if (IsScheduling() == false)
+	{
+		for (int i = 0; i < iNumProbes; ++i)
+		{
+			m_ScheduledProbes.push_back(i);
+
+			m_Ages[i] = 0;
+			m_Invalidated[i] = false;
+		}
+
+		return m_ScheduledProbes;
+	}
+
+	std::fill(m_Picked.begin(), m_Picked.end(), false);
+
+	//Invalidated probes have nothing valid in the atlases so they can't wait for their turn
+	for (int i = 0; i < iNumProbes; ++i)
+	{
+		if (m_Invalidated[i] == true)
+		{
+			Pick(i);
+
+			m_Invalidated[i] = false;
+		}
+	}
+
+	int iNumRoundRobinSlots = GetNumRoundRobinSlots();
+
+	ScheduleRoundRobin(iNumRoundRobinSlots);
+
+	int iNumPrioritySlots = m_iBudget - (int)m_ScheduledProbes.size();
+
+	if (iNumPrioritySlots > 0)
+	{
+		SchedulePrioritised(iNumPrioritySlots, kVolumePosition, kProbeSpacing, kProbeCounts, kProbeOffsets, kCameraPosition);
+	}
+
+	for (int i = 0; i < iNumProbes; ++i)
+	{
+		m_Ages[i] = m_Picked[i] == true ? 0 : m_Ages[i] + 1;
+	}
+
+	//Neighbouring probes are next to each other in the atlases so keep them together for the GPU
+	std::sort(m_ScheduledProbes.begin(), m_ScheduledProbes.end());
+
+	return m_ScheduledProbes;
+}
+
+void ProbeScheduler::ScheduleRoundRobin(int iNumSlots)
+{
+	int iNumProbes = GetNumProbes();
+	int iNumUsed = 0;
+
+	//Never goes round more than once so a volume that is mostly asleep can't loop forever
+	for (int i = 0; i < iNumProbes && iNumUsed < iNumSlots; ++i)
+	{
+		int iProbeIndex = m_iRoundRobinCursor;
+		m_iRoundRobinCursor = (m_iRoundRobinCursor + 1) % iNumProbes;
+
+		//Sleeping probes are skipped for free, the cursor only gets round the awake ones faster
+		if (m_Asleep[iProbeIndex] == true)
+		{
+			continue;
+		}
+
+		//Still uses up the slot so the cursor moves at a fixed rate and the staleness bound holds
+		if (m_Picked[iProbeIndex] == false)
+		{
+			Pick(iProbeIndex);
+		}
+
+		++iNumUsed;
+	}
+}
+
+void ProbeScheduler::SchedulePrioritised(int iNumSlots, const XMFLOAT3& kVolumePosition, const XMFLOAT3& kProbeSpacing, const XMINT3& kProbeCounts, const XMINT3& kProbeOffsets, const XMFLOAT3& kCameraPosition)
+{
+	int iNumProbes = GetNumProbes();
+
+	m_Candidates.clear();
+
+	for (int i = 0; i < iNumProbes; ++i)
+	{
+		if (m_Picked[i] == true || m_Asleep[i] == true)
+		{
+			continue;
+		}
+
+		//Older probes always win eventually so nothing gets starved
+		float fPriority = (float)(m_Ages[i] + 1);
+
+		if (m_Mode == ProbeSchedulingMode::CAMERA_PROXIMITY)
+		{
+			XMINT3 probeCoords = ProbeHelper::GetUnoffsettedProbeCoords(i, kProbeCounts, kProbeOffsets);
+			XMFLOAT3 probeCoordsW = ProbeHelper::GetProbeCoordsWorld(probeCoords, kVolumePosition, kProbeOffsets, kProbeSpacing, kProbeCounts);
+
+			XMFLOAT3 toCamera = XMFLOAT3(probeCoordsW.x - kCameraPosition.x, probeCoordsW.y - kCameraPosition.y, probeCoordsW.z - kCameraPosition.z);
+
+			fPriority /= 1.0f + sqrtf(toCamera.x * toCamera.x + toCamera.y * toCamera.y + toCamera.z * toCamera.z);
+		}
+		else if (m_Mode == ProbeSchedulingMode::CHANGE_MAGNITUDE)
+		{
+			//Small bias so probes that haven't changed are still ordered by age
+			fPriority *= m_Changes[i] + 0.001f;
+		}
+
+		m_Candidates.push_back(std::make_pair(fPriority, (UINT)i));
+	}
+
+	if ((int)m_Candidates.size() > iNumSlots)
+	{
+		std::nth_element(m_Candidates.begin(), m_Candidates.begin() + iNumSlots, m_Candidates.end(), std::greater<std::pair<float, UINT>>());
+
+		m_Candidates.resize(iNumSlots);
+	}
+
+	for (int i = 0; i < (int)m_Candidates.size(); ++i)
+	{
+		Pick(m_Candidates[i].second);
+	}
+}
+
+void ProbeScheduler::Pick(int iProbeIndex)
+{
+	m_Picked[iProbeIndex] = true;
+	m_ScheduledProbes.push_back(iProbeIndex);
+}
+
+int ProbeScheduler::GetNumRoundRobinSlots() const
+{
+	if (m_Mode == ProbeSchedulingMode::ROUND_ROBIN)
+	{
+		return m_iBudget;
+	}
+
+	//Enough slots to get round every probe within the max age, or the whole budget if that isn't possible
+	int iMaxAge = (std::max)(m_iMaxAge, 0);
+	int iNumSlots = (GetNumProbes() + iMaxAge) / (iMaxAge + 1);
+
+	return (std::min)(iNumSlots, m_iBudget);
+}
+
+void ProbeScheduler::Invalidate(int iProbeIndex)
+{
+	m_Invalidated[iProbeIndex] = true;
+}
+
+ProbeSchedulingMode ProbeScheduler::GetMode() const
+{
+	return m_Mode;
+}
+
+int ProbeScheduler::GetBudget() const
+{
+	return m_iBudget;
+}
+
+int ProbeScheduler::GetMaxAge() const
+{
+	return m_iMaxAge;
+}
+
+int ProbeScheduler::GetNumProbes() const
+{
+	return (int)m_Ages.size();
+}
+
+int ProbeScheduler::GetMaxStaleness() const
+{
+	if (IsScheduling() == false)
+	{
+		return 0;
+	}
+
+	int iNumSlots = GetNumRoundRobinSlots();
+
+	return (GetNumProbes() + iNumSlots - 1) / iNumSlots - 1;
+}
+
+int ProbeScheduler::GetProbeAge(int iProbeIndex) const
+{
+	return m_Ages[iProbeIndex];
+}
+
+const std::vector<UINT>& ProbeScheduler::GetScheduledProbes() const
+{
+	return m_ScheduledProbes;
+}
+
+bool ProbeScheduler::IsScheduling() const
+{
+	return m_Mode != ProbeSchedulingMode::ALL && m_iBudget > 0 && m_iBudget < GetNumProbes();
+}
+
+void ProbeScheduler::SetMode(ProbeSchedulingMode mode)
+{
+	m_Mode = mode;
+}
+
+void ProbeScheduler::SetBudget(int iBudget)
+{
+	m_iBudget = (std::max)(iBudget, 0);
+}
+
+void ProbeScheduler::SetMaxAge(int iMaxAge)
+{
+	m_iMaxAge = (std::max)(iMaxAge, 0);
+}
+
+void ProbeScheduler::SetProbeChange(int iProbeIndex, float fChange)
+{
+	m_Changes[iProbeIndex] = fChange;
+}
+
+void ProbeScheduler::SetProbeAsleep(int iProbeIndex, bool bAsleep)
+{
+	m_Asleep[iProbeIndex] = bAsleep;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <vector>
+
+enum class ProbeSchedulingMode
+{
+	ALL = 0,
+	ROUND_ROBIN,
+	CAMERA_PROXIMITY,
+	CHANGE_MAGNITUDE,
+
+	COUNT
+};
+
+//Picks which probes get traced and blended each frame so the cost of a large volume can be capped at a fixed number
+//of probes. Probes are identified by their atlas index, the same index the ray data rows and the active probe list use.
+//Part of the budget always goes round robin so every probe is updated at least once every GetMaxStaleness() + 1
+//frames, the rest goes to the oldest probes weighted by how close they are to the camera or by how much they changed.
+class ProbeScheduler
+{
+public:
+	ProbeScheduler();
+
+	//Resets the age of every probe
+	void Init(int iNumProbes);
+
+	//Fills the list for this frame in ascending order and ages the probes that weren't picked
+	const std::vector<UINT>& Schedule(const DirectX::XMFLOAT3& kVolumePosition, const DirectX::XMFLOAT3& kProbeSpacing, const DirectX::XMINT3& kProbeCounts, const DirectX::XMINT3& kProbeOffsets, const DirectX::XMFLOAT3& kCameraPosition);
+
+	//Forces a probe into next frame's list on top of the budget, used for probes that have just been scrolled into a new cell
+	void Invalidate(int iProbeIndex);
+
+	//Getters
+	ProbeSchedulingMode GetMode() const;
+
+	int GetBudget() const;
+	int GetMaxAge() const;
+	int GetNumProbes() const;
+
+	//Most frames in a row a probe can go without being updated with the current settings
+	int GetMaxStaleness() const;
+
+	int GetProbeAge(int iProbeIndex) const;
+
+	const std::vector<UINT>& GetScheduledProbes() const;
+
+	bool IsScheduling() const;
+
+	//Setters
+	void SetMode(ProbeSchedulingMode mode);
+	void SetBudget(int iBudget);
+	void SetMaxAge(int iMaxAge);
+
+	//How much a probe's irradiance changed the last time it was blended, used by CHANGE_MAGNITUDE. GIVolume feeds it from the adaptive hysteresis readback
+	void SetProbeChange(int iProbeIndex, float fChange);
+
+	//Sleeping probes are passed over without using up any of the budget, see ProbeSleepTracker
+	void SetProbeAsleep(int iProbeIndex, bool bAsleep);
+
+protected:
+
+private:
+	int GetNumRoundRobinSlots() const;
+
+	void ScheduleRoundRobin(int iNumSlots);
+	void SchedulePrioritised(int iNumSlots, const DirectX::XMFLOAT3& kVolumePosition, const DirectX::XMFLOAT3& kProbeSpacing, const DirectX::XMINT3& kProbeCounts, const DirectX::XMINT3& kProbeOffsets, const DirectX::XMFLOAT3& kCameraPosition);
+
+	void Pick(int iProbeIndex);
+
+	ProbeSchedulingMode m_Mode = ProbeSchedulingMode::ALL;
+
+	int m_iBudget = 0;
+	int m_iMaxAge = 8;
+	int m_iRoundRobinCursor = 0;
+
+	std::vector<int> m_Ages;
+	std::vector<float> m_Changes;
+	std::vector<bool> m_Invalidated;
+	std::vector<bool> m_Asleep;
+	std::vector<bool> m_Picked;
+
+	std::vector<std::pair<float, UINT>> m_Candidates;
+	std::vector<UINT> m_ScheduledProbes;
+};
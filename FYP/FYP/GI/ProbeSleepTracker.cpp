@@ -0,0 +1,149 @@
+#include "ProbeSleepTracker.h"
+#include "Helpers/ProbeHelper.h"
+
+#include <algorithm>
+
+using namespace DirectX;
+
+ProbeSleepTracker::ProbeSleepTracker()
+{
+}
+
+void ProbeSleepTracker::Init(int iNumProbes)
+{
+	m_FramesBelowThreshold.assign(iNumProbes, 0);
+	m_Asleep.assign(iNumProbes, false);
+	m_Woken.assign(iNumProbes, false);
+
+	m_iNumAsleep = 0;
+}
+
+void ProbeSleepTracker::Update(const std::vector<float>& kChanges, const std::vector<UINT>& kUpdatedProbes)
+{
+	int iNumProbes = GetNumProbes();
+
+	for (int i = 0; i < (int)kUpdatedProbes.size(); ++i)
+	{
+		int iProbeIndex = (int)kUpdatedProbes[i];
+
+		if (iProbeIndex >= iNumProbes || iProbeIndex >= (int)kChanges.size() || m_Woken[iProbeIndex] == true || m_Asleep[iProbeIndex] == true)
+		{
+			continue;
+		}
+
+		if (kChanges[iProbeIndex] >= m_fChangeThreshold)
+		{
+			m_FramesBelowThreshold[iProbeIndex] = 0;
+
+			continue;
+		}
+
+		++m_FramesBelowThreshold[iProbeIndex];
+
+		if (m_FramesBelowThreshold[iProbeIndex] >= m_iSleepFrames)
+		{
+			m_Asleep[iProbeIndex] = true;
+
+			++m_iNumAsleep;
+		}
+	}
+
+	std::fill(m_Woken.begin(), m_Woken.end(), false);
+}
+
+void ProbeSleepTracker::Wake(int iProbeIndex)
+{
+	if (m_Asleep[iProbeIndex] == true)
+	{
+		m_Asleep[iProbeIndex] = false;
+
+		--m_iNumAsleep;
+	}
+
+	m_FramesBelowThreshold[iProbeIndex] = 0;
+	m_Woken[iProbeIndex] = true;
+}
+
+void ProbeSleepTracker::WakeAll()
+{
+	std::fill(m_FramesBelowThreshold.begin(), m_FramesBelowThreshold.end(), 0);
+	std::fill(m_Asleep.begin(), m_Asleep.end(), false);
+	std::fill(m_Woken.begin(), m_Woken.end(), true);
+
+	m_iNumAsleep = 0;
+}
+
+void ProbeSleepTracker::WakeInBounds(const XMFLOAT3& kBoundsMin, const XMFLOAT3& kBoundsMax, float fRadius, const XMFLOAT3& kVolumePosition, const XMFLOAT3& kProbeSpacing, const XMINT3& kProbeCounts, const XMINT3& kProbeOffsets)
+{
+	int iNumProbes = GetNumProbes();
+	float fRadiusSquared = fRadius * fRadius;
+
+	for (int i = 0; i < iNumProbes; ++i)
+	{
+		XMINT3 probeCoords = ProbeHelper::GetUnoffsettedProbeCoords(i, kProbeCounts, kProbeOffsets);
+		XMFLOAT3 probeCoordsW = ProbeHelper::GetProbeCoordsWorld(probeCoords, kVolumePosition, kProbeOffsets, kProbeSpacing, kProbeCounts);
+
+		//Distance to the closest point on the box, zero for probes inside it
+		XMFLOAT3 toProbe = XMFLOAT3((std::max)((std::max)(kBoundsMin.x - probeCoordsW.x, probeCoordsW.x - kBoundsMax.x), 0.0f),
+									(std::max)((std::max)(kBoundsMin.y - probeCoordsW.y, probeCoordsW.y - kBoundsMax.y), 0.0f),
+									(std::max)((std::max)(kBoundsMin.z - probeCoordsW.z, probeCoordsW.z - kBoundsMax.z), 0.0f));
+
+		if (toProbe.x * toProbe.x + toProbe.y * toProbe.y + toProbe.z * toProbe.z <= fRadiusSquared)
+		{
+			Wake(i);
+		}
+	}
+}
+
+void ProbeSleepTracker::RemoveSleepingProbes(const std::vector<UINT>& kProbes, std::vector<UINT>& awakeProbes) const
+{
+	awakeProbes.clear();
+
+	for (int i = 0; i < (int)kProbes.size(); ++i)
+	{
+		if (m_Asleep[kProbes[i]] == false)
+		{
+			awakeProbes.push_back(kProbes[i]);
+		}
+	}
+}
+
+bool ProbeSleepTracker::IsAsleep(int iProbeIndex) const
+{
+	return m_Asleep[iProbeIndex];
+}
+
+int ProbeSleepTracker::GetNumAsleep() const
+{
+	return m_iNumAsleep;
+}
+
+int ProbeSleepTracker::GetNumProbes() const
+{
+	return (int)m_Asleep.size();
+}
+
+int ProbeSleepTracker::GetFramesBelowThreshold(int iProbeIndex) const
+{
+	return m_FramesBelowThreshold[iProbeIndex];
+}
+
+int ProbeSleepTracker::GetSleepFrames() const
+{
+	return m_iSleepFrames;
+}
+
+float ProbeSleepTracker::GetChangeThreshold() const
+{
+	return m_fChangeThreshold;
+}
+
+void ProbeSleepTracker::SetSleepFrames(int iSleepFrames)
+{
+	m_iSleepFrames = (std::max)(iSleepFrames, 1);
+}
+
+void ProbeSleepTracker::SetChangeThreshold(float fChangeThreshold)
+{
+	m_fChangeThreshold = (std::max)(fChangeThreshold, 0.0f);
+}
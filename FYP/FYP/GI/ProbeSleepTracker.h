@@ -0,0 +1,62 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <DirectXMath.h>
+
+#include <vector>
+
+//Puts probes to sleep once their irradiance has stopped changing so a static scene stops paying to trace and blend
+//them. A probe sleeps after GetSleepFrames() updates in a row with its change below the change threshold and stays
+//asleep until it is woken. GIVolume passes the blended change from the adaptive hysteresis state, see
+//ProbeHelper::GetProbeBlendedChange, and the default threshold is about half a step of a 10 bit channel. Only frame
+//counts and thresholds are involved so the same changes and wakes always give the same probes asleep.
+class ProbeSleepTracker
+{
+public:
+	ProbeSleepTracker();
+
+	//Wakes every probe
+	void Init(int iNumProbes);
+
+	//kChanges is every probe's change in probe index order read back from the frame kUpdatedProbes were traced
+	//and blended in. The other probes weren't blended that frame so their change is stale and they are left alone, as
+	//are probes woken since then as their change is from before whatever woke them.
+	void Update(const std::vector<float>& kChanges, const std::vector<UINT>& kUpdatedProbes);
+
+	void Wake(int iProbeIndex);
+	void WakeAll();
+
+	//Wakes every probe whose world position is within fRadius of the box from kBoundsMin to kBoundsMax
+	void WakeInBounds(const DirectX::XMFLOAT3& kBoundsMin, const DirectX::XMFLOAT3& kBoundsMax, float fRadius, const DirectX::XMFLOAT3& kVolumePosition, const DirectX::XMFLOAT3& kProbeSpacing, const DirectX::XMINT3& kProbeCounts, const DirectX::XMINT3& kProbeOffsets);
+
+	//Copies kProbes into awakeProbes leaving out the sleeping ones, the order is kept
+	void RemoveSleepingProbes(const std::vector<UINT>& kProbes, std::vector<UINT>& awakeProbes) const;
+
+	//Getters
+	bool IsAsleep(int iProbeIndex) const;
+
+	int GetNumAsleep() const;
+	int GetNumProbes() const;
+
+	int GetFramesBelowThreshold(int iProbeIndex) const;
+	int GetSleepFrames() const;
+
+	float GetChangeThreshold() const;
+
+	//Setters
+	void SetSleepFrames(int iSleepFrames);
+	void SetChangeThreshold(float fChangeThreshold);
+
+protected:
+
+private:
+	std::vector<int> m_FramesBelowThreshold;
+	std::vector<bool> m_Asleep;
+	std::vector<bool> m_Woken;
+
+	int m_iNumAsleep = 0;
+	int m_iSleepFrames = 30;
+
+	float m_fChangeThreshold = 0.0005f;
+};
@@ -0,0 +1,172 @@
+#include "RayDirectionTable.h"
+#include "Helpers/ProbeHelper.h"
+
+using namespace DirectX;
+
+void RayDirectionTable::Update(int iRaysPerProbe, const XMFLOAT4& kRayRotation)
+{
+	const Spiral& kSpiral = GetSpiral(iRaysPerProbe);
+
+	int iNumVectors = (int)kSpiral.X.size();
+
+	m_iRaysPerProbe = iRaysPerProbe;
+	m_DirectionsX.resize(iNumVectors);
+	m_DirectionsY.resize(iNumVectors);
+	m_DirectionsZ.resize(iNumVectors);
+	m_Directions.resize(iRaysPerProbe);
+	m_Masks = kSpiral.Masks;
+
+	//Same sum as ProbeHelper::QuaternionRotate with the conjugate of the rotation, four rays at a time
+	XMFLOAT4 conjugate = ProbeHelper::QuaternionConjugate(kRayRotation);
+
+	XMVECTOR quatX = XMVectorReplicate(conjugate.x);
+	XMVECTOR quatY = XMVectorReplicate(conjugate.y);
+	XMVECTOR quatZ = XMVectorReplicate(conjugate.z);
+	XMVECTOR quatW2 = XMVectorReplicate(conjugate.w * 2.0f);
+	XMVECTOR scale = XMVectorReplicate(conjugate.w * conjugate.w - (conjugate.x * conjugate.x + conjugate.y * conjugate.y + conjugate.z * conjugate.z));
+	XMVECTOR two = XMVectorReplicate(2.0f);
+
+	XMFLOAT4 directionsX;
+	XMFLOAT4 directionsY;
+	XMFLOAT4 directionsZ;
+
+	for (int i = 0; i < iNumVectors; ++i)
+	{
+		XMVECTOR x = kSpiral.X[i];
+		XMVECTOR y = kSpiral.Y[i];
+		XMVECTOR z = kSpiral.Z[i];
+
+		XMVECTOR vecDot2 = XMVectorMultiply(two, XMVectorMultiplyAdd(x, quatX, XMVectorMultiplyAdd(y, quatY, XMVectorMultiply(z, quatZ))));
+
+		XMVECTOR crossX = XMVectorNegativeMultiplySubtract(quatZ, y, XMVectorMultiply(quatY, z));
+		XMVECTOR crossY = XMVectorNegativeMultiplySubtract(quatX, z, XMVectorMultiply(quatZ, x));
+		XMVECTOR crossZ = XMVectorNegativeMultiplySubtract(quatY, x, XMVectorMultiply(quatX, y));
+
+		XMVECTOR rotatedX = XMVectorMultiplyAdd(x, scale, XMVectorMultiplyAdd(quatX, vecDot2, XMVectorMultiply(crossX, quatW2)));
+		XMVECTOR rotatedY = XMVectorMultiplyAdd(y, scale, XMVectorMultiplyAdd(quatY, vecDot2, XMVectorMultiply(crossY, quatW2)));
+		XMVECTOR rotatedZ = XMVectorMultiplyAdd(z, scale, XMVectorMultiplyAdd(quatZ, vecDot2, XMVectorMultiply(crossZ, quatW2)));
+
+		//Normalised like GetRayDirection, the padding lanes are zero length so are masked back to zero afterwards
+		XMVECTOR length = XMVectorSqrt(XMVectorMultiplyAdd(rotatedX, rotatedX, XMVectorMultiplyAdd(rotatedY, rotatedY, XMVectorMultiply(rotatedZ, rotatedZ))));
+
+		m_DirectionsX[i] = XMVectorAndInt(XMVectorDivide(rotatedX, length), m_Masks[i]);
+		m_DirectionsY[i] = XMVectorAndInt(XMVectorDivide(rotatedY, length), m_Masks[i]);
+		m_DirectionsZ[i] = XMVectorAndInt(XMVectorDivide(rotatedZ, length), m_Masks[i]);
+
+		XMStoreFloat4(&directionsX, m_DirectionsX[i]);
+		XMStoreFloat4(&directionsY, m_DirectionsY[i]);
+		XMStoreFloat4(&directionsZ, m_DirectionsZ[i]);
+
+		for (int j = 0; j < 4 && (i * 4) + j < iRaysPerProbe; ++j)
+		{
+			m_Directions[(i * 4) + j] = XMFLOAT4((&directionsX.x)[j], (&directionsY.x)[j], (&directionsZ.x)[j], 0.0f);
+		}
+	}
+}
+
+void RayDirectionTable::GetProbeDirections(int iProbeIndex, std::vector<XMVECTOR>& directionsX, std::vector<XMVECTOR>& directionsY, std::vector<XMVECTOR>& directionsZ) const
+{
+	int iNumVectors = (int)m_DirectionsX.size();
+
+	directionsX.resize(iNumVectors);
+	directionsY.resize(iNumVectors);
+	directionsZ.resize(iNumVectors);
+
+	//The spin is about z so only x and y change, rotating by the conjugate turns them by the spin's full angle
+	XMFLOAT4 spin = ProbeHelper::GetProbeRaySpin(iProbeIndex);
+
+	float fCos = spin.w * spin.w - spin.z * spin.z;
+	float fSin = -2.0f * spin.w * spin.z;
+
+	XMVECTOR cosAngle = XMVectorReplicate(fCos);
+	XMVECTOR sinAngle = XMVectorReplicate(fSin);
+
+	for (int i = 0; i < iNumVectors; ++i)
+	{
+		directionsX[i] = XMVectorNegativeMultiplySubtract(m_DirectionsY[i], sinAngle, XMVectorMultiply(m_DirectionsX[i], cosAngle));
+		directionsY[i] = XMVectorMultiplyAdd(m_DirectionsX[i], sinAngle, XMVectorMultiply(m_DirectionsY[i], cosAngle));
+		directionsZ[i] = m_DirectionsZ[i];
+	}
+}
+
+int RayDirectionTable::GetRaysPerProbe() const
+{
+	return m_iRaysPerProbe;
+}
+
+const std::vector<XMFLOAT4>& RayDirectionTable::GetDirections() const
+{
+	return m_Directions;
+}
+
+const std::vector<XMVECTOR>& RayDirectionTable::GetDirectionsX() const
+{
+	return m_DirectionsX;
+}
+
+const std::vector<XMVECTOR>& RayDirectionTable::GetDirectionsY() const
+{
+	return m_DirectionsY;
+}
+
+const std::vector<XMVECTOR>& RayDirectionTable::GetDirectionsZ() const
+{
+	return m_DirectionsZ;
+}
+
+const std::vector<XMVECTOR>& RayDirectionTable::GetMasks() const
+{
+	return m_Masks;
+}
+
+const RayDirectionTable::Spiral& RayDirectionTable::GetSpiral(int iRaysPerProbe)
+{
+	std::unordered_map<int, Spiral>::iterator it = m_Spirals.find(iRaysPerProbe);
+
+	if (it != m_Spirals.end())
+	{
+		return it->second;
+	}
+
+	Spiral& spiral = m_Spirals[iRaysPerProbe];
+
+	int iNumVectors = (iRaysPerProbe + 3) / 4;
+
+	spiral.X.resize(iNumVectors);
+	spiral.Y.resize(iNumVectors);
+	spiral.Z.resize(iNumVectors);
+	spiral.Masks.resize(iNumVectors);
+
+	XMFLOAT4 vectorX;
+	XMFLOAT4 vectorY;
+	XMFLOAT4 vectorZ;
+	UINT32 masks[4];
+
+	for (int i = 0; i < iNumVectors; ++i)
+	{
+		for (int j = 0; j < 4; ++j)
+		{
+			int iRayIndex = (i * 4) + j;
+
+			XMFLOAT3 direction = XMFLOAT3(0, 0, 0);
+			masks[j] = 0;
+
+			if (iRayIndex < iRaysPerProbe)
+			{
+				direction = ProbeHelper::GetFibonacciSpiralDirection((float)iRayIndex, (float)iRaysPerProbe);
+				masks[j] = 0xFFFFFFFF;
+			}
+
+			(&vectorX.x)[j] = direction.x;
+			(&vectorY.x)[j] = direction.y;
+			(&vectorZ.x)[j] = direction.z;
+		}
+
+		spiral.X[i] = XMLoadFloat4(&vectorX);
+		spiral.Y[i] = XMLoadFloat4(&vectorY);
+		spiral.Z[i] = XMLoadFloat4(&vectorZ);
+		spiral.Masks[i] = XMVectorSetInt(masks[0], masks[1], masks[2], masks[3]);
+	}
+
+	return spiral;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <unordered_map>
+#include <vector>
+
+//Every ray's direction for one RaysPerProbe, the Fibonacci spiral rotated by the frame's ray rotation. Replaces working
+//out GetRayDirection for each ray in every pass, the spiral is only built once per ray count and the whole table is
+//rotated at once each frame. Directions are kept four rays to a vector for the CPU passes and as float4s, w unused, to
+//be uploaded for the shaders. Lanes past the last ray are zero.
+class RayDirectionTable
+{
+public:
+	//Rotates the spiral for iRaysPerProbe by kRayRotation the same way ProbeHelper::GetRayDirection does
+	void Update(int iRaysPerProbe, const DirectX::XMFLOAT4& kRayRotation);
+
+	//The table spun by the probe's per probe ray rotation, only needed when PerProbeRayRotation is on
+	void GetProbeDirections(int iProbeIndex, std::vector<DirectX::XMVECTOR>& directionsX, std::vector<DirectX::XMVECTOR>& directionsY, std::vector<DirectX::XMVECTOR>& directionsZ) const;
+
+	//Getters
+	int GetRaysPerProbe() const;
+
+	const std::vector<DirectX::XMFLOAT4>& GetDirections() const;
+
+	const std::vector<DirectX::XMVECTOR>& GetDirectionsX() const;
+	const std::vector<DirectX::XMVECTOR>& GetDirectionsY() const;
+	const std::vector<DirectX::XMVECTOR>& GetDirectionsZ() const;
+	const std::vector<DirectX::XMVECTOR>& GetMasks() const;
+
+protected:
+
+private:
+	struct Spiral
+	{
+		std::vector<DirectX::XMVECTOR> X;
+		std::vector<DirectX::XMVECTOR> Y;
+		std::vector<DirectX::XMVECTOR> Z;
+		std::vector<DirectX::XMVECTOR> Masks;
+	};
+
+	const Spiral& GetSpiral(int iRaysPerProbe);
+
+	//Unrotated spirals by ray count, switching back and forth between counts doesn't rebuild them
+	std::unordered_map<int, Spiral> m_Spirals;
+
+	int m_iRaysPerProbe = 0;
+
+	std::vector<DirectX::XMFLOAT4> m_Directions;
+
+	std::vector<DirectX::XMVECTOR> m_DirectionsX;
+	std::vector<DirectX::XMVECTOR> m_DirectionsY;
+	std::vector<DirectX::XMVECTOR> m_DirectionsZ;
+	std::vector<DirectX::XMVECTOR> m_Masks;
+};
@@ -0,0 +1,188 @@
+#include "RayRotationExperiment.h"
+#include "GI/CPURayTracer.h"
+#include "Commons/Timer.h"
+#include "Helpers/DebugHelper.h"
+#include "Shaders/Defines.hlsli"
+
+#include <algorithm>
+#include <math.h>
+
+using namespace DirectX;
+
+Tag tag = L"RayRotationExperiment";
+
+RayRotationExperiment::RayRotationExperiment(ThreadPool* pThreadPool) : m_Blender(pThreadPool)
+{
+}
+
+void RayRotationExperiment::BuildReference(CPURayTracer& tracer, const RaytracePerFrameCB& kParams, int iNumFrames, int iRaysPerProbe)
+{
+	PROFILE("Ray Rotation Reference");
+
+	RaytracePerFrameCB params = kParams;
+	params.RaysPerProbe = iRaysPerProbe;
+	params.RayDataFormat = FORMAT_PROBE_RAY_DATA_R32G32B32A32_FLOAT;
+	params.IrradianceGammaEncoding = 1.0f;
+	params.Hysteresis = 0.0f;
+	params.IrradianceThreshold = 1e27f;
+	params.BrightnessThreshold = 1e27f;
+	params.ClearPlane = XMINT3(0, 0, 0);
+	params.AdaptiveRays = 0;
+	params.PerProbeRayRotation = 0;
+
+	CPUProbeBlender::CreateAtlases(params, m_RayData, m_IrradianceAtlas, m_DistanceAtlas);
+
+	m_Reference.Resize(m_IrradianceAtlas.Width, m_IrradianceAtlas.Height);
+
+	RayRotationGenerator generator;
+	generator.SetSeed(0);
+
+	float fWeight = 1.0f / (std::max)(iNumFrames, 1);
+
+	//Without hysteresis each blend is just that frame's estimate, the blend's own hysteresis isn't an even average
+	for (int i = 0; i < iNumFrames; ++i)
+	{
+		params.RayRotation = generator.Next();
+
+		tracer.TraceProbeRays(params, m_RayData);
+		m_Blender.BlendIrradiance(params, m_RayData, m_IrradianceAtlas);
+
+		for (size_t j = 0; j < m_Reference.Texels.size(); ++j)
+		{
+			const XMFLOAT4& kTexel = m_IrradianceAtlas.Texels[j];
+			XMFLOAT4& reference = m_Reference.Texels[j];
+
+			reference = XMFLOAT4(reference.x + kTexel.x * fWeight, reference.y + kTexel.y * fWeight, reference.z + kTexel.z * fWeight, 1.0f);
+		}
+	}
+}
+
+RayRotationTrial RayRotationExperiment::Run(CPURayTracer& tracer, const RaytracePerFrameCB& kParams, RayRotationSequence sequence, bool bPerProbeRotation, int iNumFrames, float fThreshold, unsigned int uiSeed)
+{
+	PROFILE("Ray Rotation Trial");
+
+	RayRotationTrial trial;
+	trial.Sequence = sequence;
+	trial.PerProbeRotation = bPerProbeRotation;
+	trial.Errors.reserve(iNumFrames);
+
+	if (m_Reference.Texels.empty() == true)
+	{
+		LOG_ERROR(tag, L"Failed to run ray rotation trial as no reference has been built!");
+
+		return trial;
+	}
+
+	RaytracePerFrameCB params = kParams;
+	params.ClearPlane = XMINT3(0, 0, 0);
+	params.AdaptiveRays = 0;
+	params.PerProbeRayRotation = (int)bPerProbeRotation;
+
+	CPUProbeBlender::CreateAtlases(params, m_RayData, m_IrradianceAtlas, m_DistanceAtlas);
+
+	if (m_IrradianceAtlas.Width != m_Reference.Width || m_IrradianceAtlas.Height != m_Reference.Height)
+	{
+		LOG_ERROR(tag, L"Failed to run ray rotation trial as the reference was built for a different volume!");
+
+		return trial;
+	}
+
+	RayRotationGenerator generator;
+	generator.SetSeed(uiSeed);
+	generator.SetSequence(sequence);
+
+	Timer timer;
+	timer.Reset();
+
+	for (int i = 0; i < iNumFrames; ++i)
+	{
+		params.RayRotation = generator.Next();
+
+		tracer.TraceProbeRays(params, m_RayData);
+		m_Blender.BlendIrradiance(params, m_RayData, m_IrradianceAtlas);
+
+		double dError = GetRelativeError(params, m_IrradianceAtlas);
+
+		trial.Errors.push_back(dError);
+
+		if (trial.FramesToConverge == -1 && dError < fThreshold)
+		{
+			trial.FramesToConverge = i + 1;
+		}
+	}
+
+	timer.Tick();
+
+	trial.Seconds = timer.DeltaTime();
+
+	int iNumSettled = (std::max)(iNumFrames / 4, 1);
+
+	for (int i = iNumFrames - iNumSettled; i < iNumFrames; ++i)
+	{
+		trial.SettledError += trial.Errors[i] / iNumSettled;
+	}
+
+	LOG_VERBOSE(tag, L"Ray rotation sequence %d, per probe %d: converged in %d frames, settled error %f", (int)sequence, (int)bPerProbeRotation, trial.FramesToConverge, trial.SettledError);
+
+	return trial;
+}
+
+std::vector<RayRotationTrial> RayRotationExperiment::RunAll(CPURayTracer& tracer, const RaytracePerFrameCB& kParams, int iNumFrames, float fThreshold, unsigned int uiSeed)
+{
+	std::vector<RayRotationTrial> trials;
+
+	for (int i = 0; i < (int)RayRotationSequence::COUNT; ++i)
+	{
+		trials.push_back(Run(tracer, kParams, (RayRotationSequence)i, false, iNumFrames, fThreshold, uiSeed));
+		trials.push_back(Run(tracer, kParams, (RayRotationSequence)i, true, iNumFrames, fThreshold, uiSeed));
+	}
+
+	return trials;
+}
+
+double RayRotationExperiment::GetRelativeError(const RaytracePerFrameCB& kParams, const CPUAtlas& kIrradiance) const
+{
+	int iNumTexels = kParams.NumIrradianceTexels;
+	int iNumProbes = kParams.ProbeCounts.x * kParams.ProbeCounts.y * kParams.ProbeCounts.z;
+	int iNumProbesX = kParams.ProbeCounts.x * kParams.ProbeCounts.y;
+
+	double dSquaredError = 0.0;
+	double dSquaredReference = 0.0;
+
+	//Interior texels only, the borders are copies
+	for (int i = 0; i < iNumProbes; ++i)
+	{
+		int iOriginX = 1 + (i % iNumProbesX) * (iNumTexels + 2);
+		int iOriginY = 1 + (i / iNumProbesX) * (iNumTexels + 2);
+
+		for (int y = 0; y < iNumTexels; ++y)
+		{
+			for (int x = 0; x < iNumTexels; ++x)
+			{
+				const XMFLOAT4& kTexel = kIrradiance.GetTexel(iOriginX + x, iOriginY + y);
+				const XMFLOAT4& kReference = m_Reference.GetTexel(iOriginX + x, iOriginY + y);
+
+				for (int j = 0; j < 3; ++j)
+				{
+					double dValue = pow((double)(&kTexel.x)[j], (double)kParams.IrradianceGammaEncoding);
+					double dReference = (&kReference.x)[j];
+
+					dSquaredError += (dValue - dReference) * (dValue - dReference);
+					dSquaredReference += dReference * dReference;
+				}
+			}
+		}
+	}
+
+	return dSquaredReference > 0.0 ? sqrt(dSquaredError / dSquaredReference) : 0.0;
+}
+
+void RayRotationExperiment::SetThreadPool(ThreadPool* pThreadPool)
+{
+	m_Blender.SetThreadPool(pThreadPool);
+}
+
+const CPUAtlas& RayRotationExperiment::GetReference() const
+{
+	return m_Reference;
+}
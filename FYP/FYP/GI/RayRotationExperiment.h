@@ -0,0 +1,65 @@
+#pragma once
+
+#include "GI/CPUAtlas.h"
+#include "GI/CPUProbeBlender.h"
+#include "GI/RayRotationGenerator.h"
+#include "Shaders/ConstantBuffers.h"
+
+#include <vector>
+
+class CPURayTracer;
+class ThreadPool;
+
+struct RayRotationTrial
+{
+	RayRotationSequence Sequence = RayRotationSequence::RANDOM;
+	bool PerProbeRotation = false;
+
+	//First frame the error got below the threshold, -1 if it never did
+	int FramesToConverge = -1;
+
+	//Mean error over the last quarter of the frames, what the blend settles to with these settings
+	double SettledError = 0.0;
+
+	//Relative RMS error of the irradiance against the reference after each frame
+	std::vector<double> Errors;
+
+	float Seconds = 0.0f;
+};
+
+//Measures how many frames each ray rotation sequence takes to converge on the scene a CPURayTracer has built. A
+//reference is blended from many frames with a lot of rays, then each trial starts from empty atlases and traces and
+//blends frames with the given settings, the same as a new GIVolume, comparing the irradiance against the reference
+//after each one. The tracer's hit shader has to be set for there to be any radiance. Only octahedral irradiance.
+class RayRotationExperiment
+{
+public:
+	RayRotationExperiment(ThreadPool* pThreadPool = nullptr);
+
+	//Evenly weighted average of iNumFrames randomly rotated frames of iRaysPerProbe rays, blended without gamma
+	void BuildReference(CPURayTracer& tracer, const RaytracePerFrameCB& kParams, int iNumFrames, int iRaysPerProbe);
+
+	//fThreshold is relative RMS error, the same measure as RayRotationTrial::Errors
+	RayRotationTrial Run(CPURayTracer& tracer, const RaytracePerFrameCB& kParams, RayRotationSequence sequence, bool bPerProbeRotation, int iNumFrames, float fThreshold, unsigned int uiSeed);
+
+	//Every sequence with and without the per probe rotation, seeded the same so the random parts match
+	std::vector<RayRotationTrial> RunAll(CPURayTracer& tracer, const RaytracePerFrameCB& kParams, int iNumFrames, float fThreshold, unsigned int uiSeed);
+
+	//Irradiance atlases are compared in linear space, kIrradiance is decoded with the gamma in kParams
+	double GetRelativeError(const RaytracePerFrameCB& kParams, const CPUAtlas& kIrradiance) const;
+
+	void SetThreadPool(ThreadPool* pThreadPool);
+
+	const CPUAtlas& GetReference() const;
+
+protected:
+
+private:
+	CPUProbeBlender m_Blender;
+
+	CPUAtlas m_Reference;
+
+	CPUAtlas m_RayData;
+	CPUAtlas m_IrradianceAtlas;
+	CPUAtlas m_DistanceAtlas;
+};
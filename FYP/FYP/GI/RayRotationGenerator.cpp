@@ -0,0 +1,224 @@
+#include "RayRotationGenerator.h"
+
+#include <math.h>
+
+using namespace DirectX;
+
+#define NUM_BLUE_NOISE_ROTATIONS 64
+#define BLUE_NOISE_CANDIDATES 16
+
+RayRotationGenerator::RayRotationGenerator()
+{
+	Reset();
+}
+
+void RayRotationGenerator::Reset()
+{
+	m_iFrameIndex = 0;
+
+	m_Offset = XMFLOAT3(GetUniform(), GetUniform(), GetUniform());
+
+	for (int i = 0; i < 3; ++i)
+	{
+		m_uiScrambles[i] = m_rng();
+	}
+
+	if (m_Sequence == RayRotationSequence::BLUE_NOISE)
+	{
+		CreateBlueNoiseRotations();
+	}
+}
+
+XMFLOAT4 RayRotationGenerator::Next()
+{
+	int iIndex = m_iFrameIndex++;
+
+	switch (m_Sequence)
+	{
+	case RayRotationSequence::R3:
+	{
+		//Inverse powers of the plastic number's three dimensional counterpart, the root of x^4 = x + 1
+		const double kdG = 1.22074408460575947536;
+
+		double dU1 = m_Offset.x + iIndex / kdG;
+		double dU2 = m_Offset.y + iIndex / (kdG * kdG);
+		double dU3 = m_Offset.z + iIndex / (kdG * kdG * kdG);
+
+		return GetArvoRotation((float)(dU1 - floor(dU1)), (float)(dU2 - floor(dU2)), (float)(dU3 - floor(dU3)));
+	}
+
+	case RayRotationSequence::SOBOL:
+		return GetArvoRotation(GetSobol(iIndex, 0, m_uiScrambles[0]), GetSobol(iIndex, 1, m_uiScrambles[1]), GetSobol(iIndex, 2, m_uiScrambles[2]));
+
+	case RayRotationSequence::BLUE_NOISE:
+	{
+		int iSetIndex = iIndex % NUM_BLUE_NOISE_ROTATIONS;
+
+		if (iSetIndex == 0)
+		{
+			m_CycleRotation = GetArvoRotation(GetUniform(), GetUniform(), GetUniform());
+		}
+
+		XMVECTOR rotation = XMQuaternionMultiply(XMLoadFloat4(&m_BlueNoiseRotations[iSetIndex]), XMLoadFloat4(&m_CycleRotation));
+
+		XMFLOAT4 result;
+		XMStoreFloat4(&result, XMQuaternionNormalize(rotation));
+
+		return result;
+	}
+
+	default:
+		return GetArvoRotation(GetUniform(), GetUniform(), GetUniform());
+	}
+}
+
+XMFLOAT4 RayRotationGenerator::GetArvoRotation(float fU1, float fU2, float fU3)
+{
+	// This approach is based on James Arvo's implementation from Graphics Gems 3 (pg 117-120).
+// Also available at: http://citeseerx.ist.psu.edu/viewdoc/download?doi=10.1.1.53.1357&rep=rep1&type=pdf
+
+// Setup a random rotation matrix using 3 uniform RVs
+	float u1 = XM_PI * fU1 * 2.0f;
+	float cos1 = cosf(u1);
+	float sin1 = sinf(u1);
+
+	float u2 = XM_PI * fU2 * 2.0f;
+	float cos2 = cosf(u2);
+	float sin2 = sinf(u2);
+
+	float u3 = fU3;
+	float sq3 = 2.f * sqrtf(u3 * (1.f - u3));
+
+	float s2 = 2.f * u3 * sin2 * sin2 - 1.f;
+	float c2 = 2.f * u3 * cos2 * cos2 - 1.f;
+	float sc = 2.f * u3 * sin2 * cos2;
+
+	// Create the random rotation matrix
+	float _11 = cos1 * c2 - sin1 * sc;
+	float _12 = sin1 * c2 + cos1 * sc;
+	float _13 = sq3 * cos2;
+
+	float _21 = cos1 * sc - sin1 * s2;
+	float _22 = sin1 * sc + cos1 * s2;
+	float _23 = sq3 * sin2;
+
+	float _31 = cos1 * (sq3 * cos2) - sin1 * (sq3 * sin2);
+	float _32 = sin1 * (sq3 * cos2) + cos1 * (sq3 * sin2);
+	float _33 = 1.f - 2.f * u3;
+
+	// HLSL is column-major
+	DirectX::XMFLOAT3X3 transform(_11, _12, _13, _21, _22, _23, _31, _32, _33);
+
+	XMFLOAT4 rotation;
+	XMStoreFloat4(&rotation, XMQuaternionNormalize(XMQuaternionRotationMatrix(XMLoadFloat3x3(&transform))));
+
+	return rotation;
+}
+
+RayRotationSequence RayRotationGenerator::GetSequence() const
+{
+	return m_Sequence;
+}
+
+int RayRotationGenerator::GetFrameIndex() const
+{
+	return m_iFrameIndex;
+}
+
+void RayRotationGenerator::SetSequence(RayRotationSequence sequence)
+{
+	m_Sequence = sequence;
+
+	Reset();
+}
+
+void RayRotationGenerator::SetSeed(unsigned int uiSeed)
+{
+	m_rng.seed(uiSeed);
+
+	Reset();
+}
+
+void RayRotationGenerator::CreateBlueNoiseRotations()
+{
+	m_BlueNoiseRotations.clear();
+	m_BlueNoiseRotations.reserve(NUM_BLUE_NOISE_ROTATIONS);
+
+	m_BlueNoiseRotations.push_back(GetArvoRotation(GetUniform(), GetUniform(), GetUniform()));
+
+	//Mitchell's best candidate, every rotation added is the candidate farthest from the ones already picked so any run of
+	//consecutive frames is spread out as well as the whole set
+	for (int i = 1; i < NUM_BLUE_NOISE_ROTATIONS; ++i)
+	{
+		XMFLOAT4 bestCandidate;
+		float fBestDistance = -1.0f;
+
+		for (int j = 0; j < BLUE_NOISE_CANDIDATES * i; ++j)
+		{
+			XMFLOAT4 candidate = GetArvoRotation(GetUniform(), GetUniform(), GetUniform());
+
+			float fClosestDistance = 2.0f;
+
+			for (const XMFLOAT4& kRotation : m_BlueNoiseRotations)
+			{
+				//q and -q are the same rotation, 1 - |dot| grows with the angle between the two rotations
+				float fDistance = 1.0f - fabsf(candidate.x * kRotation.x + candidate.y * kRotation.y + candidate.z * kRotation.z + candidate.w * kRotation.w);
+
+				fClosestDistance = fDistance < fClosestDistance ? fDistance : fClosestDistance;
+			}
+
+			if (fClosestDistance > fBestDistance)
+			{
+				fBestDistance = fClosestDistance;
+				bestCandidate = candidate;
+			}
+		}
+
+		m_BlueNoiseRotations.push_back(bestCandidate);
+	}
+}
+
+float RayRotationGenerator::GetUniform()
+{
+	//Top 24 bits so the result is exactly representable and never reaches 1
+	return (m_rng() >> 8) * (1.0f / 16777216.0f);
+}
+
+float RayRotationGenerator::GetSobol(unsigned int uiIndex, int iDimension, unsigned int uiScramble)
+{
+	//Direction numbers for the first three dimensions, van der Corput then the primitive polynomials x + 1 and
+	//x^2 + x + 1 with initial numbers 1 and 1, 3. The scramble is a random digital shift which keeps the stratification.
+	unsigned int uiResult = uiScramble;
+	unsigned int uiDirection = 1u << 31;
+	unsigned int uiPreviousDirection = 0;
+
+	for (int i = 0; uiIndex != 0; ++i, uiIndex >>= 1)
+	{
+		if ((uiIndex & 1) != 0)
+		{
+			uiResult ^= uiDirection;
+		}
+
+		unsigned int uiNextDirection;
+
+		switch (iDimension)
+		{
+		case 0:
+			uiNextDirection = uiDirection >> 1;
+			break;
+
+		case 1:
+			uiNextDirection = uiDirection ^ (uiDirection >> 1);
+			break;
+
+		default:
+			uiNextDirection = i == 0 ? 3u << 30 : uiDirection ^ uiPreviousDirection ^ (uiPreviousDirection >> 2);
+			break;
+		}
+
+		uiPreviousDirection = uiDirection;
+		uiDirection = uiNextDirection;
+	}
+
+	return (uiResult >> 8) * (1.0f / 16777216.0f);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <random>
+#include <vector>
+
+enum class RayRotationSequence
+{
+	RANDOM = 0,
+	R3,
+	SOBOL,
+	BLUE_NOISE,
+
+	COUNT
+};
+
+//Gives GIVolume the rotation applied to every probe's rays each frame. Each rotation is built from three numbers in
+//[0, 1) with Arvo's method, which maps uniform numbers to uniform rotations, so a sequence that covers the unit cube
+//more evenly than random numbers covers the rotations more evenly and the blended probes converge in fewer frames.
+//R3 is Roberts' additive recurrence in three dimensions and SOBOL is the first three dimensions of the Sobol sequence,
+//both randomised by a per reset offset. BLUE_NOISE cycles through a fixed set of rotations spread out by best candidate
+//sampling, spun by a new random rotation every cycle so the same rotations aren't repeated.
+class RayRotationGenerator
+{
+public:
+	RayRotationGenerator();
+
+	//Restarts the sequence with new random offsets
+	void Reset();
+
+	//Rotation quaternion for the next frame
+	DirectX::XMFLOAT4 Next();
+
+	//Arvo's rotation from three uniform numbers in [0, 1)
+	static DirectX::XMFLOAT4 GetArvoRotation(float fU1, float fU2, float fU3);
+
+	//Getters
+	RayRotationSequence GetSequence() const;
+
+	int GetFrameIndex() const;
+
+	//Setters
+	void SetSequence(RayRotationSequence sequence);
+
+	void SetSeed(unsigned int uiSeed);
+
+protected:
+
+private:
+	void CreateBlueNoiseRotations();
+
+	float GetUniform();
+
+	static float GetSobol(unsigned int uiIndex, int iDimension, unsigned int uiScramble);
+
+	RayRotationSequence m_Sequence = RayRotationSequence::RANDOM;
+
+	std::mt19937 m_rng;
+
+	int m_iFrameIndex = 0;
+
+	DirectX::XMFLOAT3 m_Offset = DirectX::XMFLOAT3(0, 0, 0);
+	unsigned int m_uiScrambles[3] = {};
+
+	std::vector<DirectX::XMFLOAT4> m_BlueNoiseRotations;
+	DirectX::XMFLOAT4 m_CycleRotation = DirectX::XMFLOAT4(0, 0, 0, 1);
+};
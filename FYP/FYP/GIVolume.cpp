@@ -1,6 +1,8 @@
 #include "GIVolume.h"
 #include "Commons/Mesh.h"
 #include "Commons/Texture.h"
+#include "Commons/SRVDescriptor.h"
+#include "Commons/UAVDescriptor.h"
 #include "GameObjects/GameObject.h"
 #include "Managers/MeshManager.h"
 #include "Managers/ObjectManager.h"
@@ -10,6 +12,10 @@
 #include "Include/ImGui/imgui.h"
 #include "Commons/ShaderTable.h"
 #include "Apps/App.h"
+#include "GI/AtlasSnapshot.h"
+#include "GI/GICascades.h"
+#include "Helpers/ProbeHelper.h"
+#include "Shaders/Defines.hlsli"
 
 #if PIX
 #include "pix3.h"
@@ -18,16 +24,22 @@
 #include <strsafe.h>
 #endif
 
+#include <algorithm>
 #include <math.h>
 #include <time.h>
 
 Tag tag = L"GIVolume";
 
-GIVolume::GIVolume(const GIVolumeDesc& kVolumeDesc, ID3D12GraphicsCommandList4* pCommandList, DescriptorHeap* pSRVHeap, DescriptorHeap* pRTVHeap)
+GIVolume::GIVolume()
+{
+}
+
+bool GIVolume::Init(const GIVolumeDesc& kVolumeDesc, ID3D12GraphicsCommandList4* pCommandList, DescriptorHeap* pSRVHeap, DescriptorHeap* pRTVHeap)
 {
 	m_Position = kVolumeDesc.Position;
 	m_ProbeCounts = kVolumeDesc.ProbeCounts;
 	m_bProbeRelocation = kVolumeDesc.ProbeRelocation;
+	m_bProbeClassification = kVolumeDesc.ProbeClassification;
 	m_ProbeScale = kVolumeDesc.ProbeScale;
 	m_ProbeSpacing = kVolumeDesc.ProbeSpacing;
 	m_bProbeTracking = kVolumeDesc.ProbeTracking;
@@ -42,62 +54,144 @@ GIVolume::GIVolume(const GIVolumeDesc& kVolumeDesc, ID3D12GraphicsCommandList4*
 	m_fBrightnessThreshold = kVolumeDesc.BrightnessThreshold;
 	m_fDistancePower = kVolumeDesc.DistancePower;
 	m_fHysteresis = kVolumeDesc.Hysteresis;
+	m_iRayDataFormat = kVolumeDesc.RayDataFormat;
 	m_iIrradianceFormat = kVolumeDesc.IrradianceFormat;
+	m_iIrradianceEncoding = kVolumeDesc.IrradianceEncoding;
+	m_iAtlasLayout = kVolumeDesc.AtlasLayout;
 	m_fIrradianceGammaEncoding = kVolumeDesc.IrradianceGammaEncoding;
 	m_fIrradianceThreshold = kVolumeDesc.IrradianceThreshold;
+	m_fProbeMinFrontfaceDistance = kVolumeDesc.ProbeMinFrontfaceDistance;
+	m_fProbeBackfaceThreshold = kVolumeDesc.ProbeBackfaceThreshold;
 	m_MissRadiance = kVolumeDesc.MissRadiance;
 	m_ProbeOffsets = kVolumeDesc.ProbeOffsets;
 	m_Anchor = kVolumeDesc.Anchor;
+	m_iCascadeIndex = kVolumeDesc.CascadeIndex;
 
 	m_bProbeTracking = kVolumeDesc.ProbeTracking;
 
-	m_rng.seed(time(0));
+	m_ProbeScheduler.Init(m_ProbeCounts.x * m_ProbeCounts.y * m_ProbeCounts.z);
+	m_ProbeScheduler.SetMode((ProbeSchedulingMode)kVolumeDesc.ProbeSchedulingMode);
+	m_ProbeScheduler.SetBudget(kVolumeDesc.ProbeUpdateBudget);
+	m_ProbeScheduler.SetMaxAge(kVolumeDesc.ProbeMaxAge);
+
+	m_bAdaptiveRays = kVolumeDesc.AdaptiveRays;
+	m_RayAllocator.SetRayBudget(kVolumeDesc.RayBudget);
+	m_RayAllocator.SetMinRays(kVolumeDesc.MinRaysPerProbe);
+	m_RayAllocator.SetMaxRays(m_iRaysPerProbe);
+	m_RayAllocator.AllocateUniform(m_ProbeCounts.x * m_ProbeCounts.y * m_ProbeCounts.z, m_ProbeRayCounts);
+
+	m_bAdaptiveHysteresis = kVolumeDesc.AdaptiveHysteresis;
+	m_fMinHysteresis = kVolumeDesc.MinHysteresis;
+	m_fHysteresisRiseRate = kVolumeDesc.HysteresisRiseRate;
+	m_fHysteresisChangeThreshold = kVolumeDesc.HysteresisChangeThreshold;
+
+	m_bProbeSleeping = kVolumeDesc.ProbeSleeping;
+	m_fProbeWakeRadius = kVolumeDesc.ProbeWakeRadius;
+	m_SleepTracker.Init(m_ProbeCounts.x * m_ProbeCounts.y * m_ProbeCounts.z);
+	m_SleepTracker.SetSleepFrames(kVolumeDesc.ProbeSleepFrames);
+	m_SleepTracker.SetChangeThreshold(kVolumeDesc.ProbeSleepThreshold);
+
+	m_AllProbes.resize(m_ProbeCounts.x * m_ProbeCounts.y * m_ProbeCounts.z);
+
+	for (int i = 0; i < (int)m_AllProbes.size(); ++i)
+	{
+		m_AllProbes[i] = i;
+	}
+
+	m_iProbeFilter = kVolumeDesc.ProbeFilter;
+	m_fProbeFilterStrength = kVolumeDesc.ProbeFilterStrength;
+
+	m_bPerProbeRayRotation = kVolumeDesc.PerProbeRayRotation;
+	m_RayRotationGenerator.SetSequence((RayRotationSequence)kVolumeDesc.RayRotationSequence);
+	m_RayRotationGenerator.SetSeed((unsigned int)time(0));
 
-	CreateProbeGameObjects(pCommandList);
+	UINT uiFirstSRVDescriptor = pSRVHeap->GetNumDescsAllocated();
+
+	if (CreateTextureAtlases(pSRVHeap, pRTVHeap) == false)
+	{
+		LOG_ERROR(tag, L"Failed to create the GI volume's atlases!");
+
+		return false;
+	}
 
-	CreateTextureAtlases(pSRVHeap, pRTVHeap);
+	if (pSRVHeap->GetNumDescsAllocated() - uiFirstSRVDescriptor != GetNumSRVDescriptors())
+	{
+		LOG_WARNING(tag, L"GI volume allocated %u SRV heap descriptors but GetNumSRVDescriptors says %u!", pSRVHeap->GetNumDescsAllocated() - uiFirstSRVDescriptor, GetNumSRVDescriptors());
+	}
 
-	CompileShaders();
+	if (CompileShaders() == false)
+	{
+		return false;
+	}
 
-	CreateRootSignatures();
+	if (CreateRootSignatures() == false)
+	{
+		return false;
+	}
 
-	CreatePSOs();
+	if (CreatePSOs() == false)
+	{
+		return false;
+	}
 
-	CreateStateObject();
+	if (CreateStateObject() == false)
+	{
+		return false;
+	}
 
-	CreateShaderTables();
+	if (CreateShaderTables() == false)
+	{
+		return false;
+	}
 
 	CreateConstantBuffers();
 
 	UpdateConstantBuffers();
+
+	return true;
+}
+
+UINT GIVolume::GetNumSRVDescriptors()
+{
+	//SRV and UAV for the ray data, irradiance, filtered irradiance, distance and probe data atlases, the active probe list
+	//and the probe positions. UAVs for the probe statistics and hysteresis, SRVs for the ray counts and direction table
+	return 7 * 2 + 2 + 2;
+}
+
+UINT GIVolume::GetNumRTVDescriptors()
+{
+	//Irradiance and distance atlases
+	return 2;
 }
 
 void GIVolume::ShowUI()
 {
-	if (ImGui::TreeNodeEx("GI Settings", ImGuiTreeNodeFlags_Framed | ImGuiTreeNodeFlags_NoAutoOpenOnLog))
+	std::string sLabel = m_iCascadeIndex == 0 ? "GI Settings" : "GI Cascade " + std::to_string(m_iCascadeIndex) + " Settings";
+
+	if (ImGui::TreeNodeEx(sLabel.c_str(), ImGuiTreeNodeFlags_Framed | ImGuiTreeNodeFlags_NoAutoOpenOnLog))
 	{
 		if (ImGuiHelper::DragFloat3("Position", m_Position) == true)
 		{
-			UpdateProbePositions();
+			m_SleepTracker.WakeAll();
 		}
 
 		ImGui::Spacing();
 
 		if (ImGuiHelper::DragFloat3("Probe Spacing", m_ProbeSpacing) == true)
 		{
-			UpdateProbePositions();
+			m_SleepTracker.WakeAll();
 		}
 
 		ImGui::Spacing();
 
-		if (ImGuiHelper::DragFloat("Probe Scale", m_ProbeScale) == true)
-		{
-			UpdateProbeScales();
-		}
+		ImGuiHelper::DragFloat("Probe Scale", m_ProbeScale);
 
 		ImGui::Spacing();
 
-		ImGuiHelper::DragFloat3("Miss Radiance", m_MissRadiance);
+		if (ImGuiHelper::DragFloat3("Miss Radiance", m_MissRadiance) == true)
+		{
+			m_SleepTracker.WakeAll();
+		}
 
 		ImGui::Spacing();
 
@@ -121,10 +215,86 @@ void GIVolume::ShowUI()
 
 		ImGui::Spacing();
 
+		if (ImGuiHelper::Checkbox("Adaptive Hysteresis", m_bAdaptiveHysteresis, 150.0f) == true)
+		{
+			m_bProbeHysteresisValid = false;
+
+			m_SleepTracker.WakeAll();
+		}
+
+		ImGuiHelper::DragFloat("Min Hysteresis", m_fMinHysteresis, 150.0f, 0.01f, 0, m_fHysteresis);
+		ImGuiHelper::DragFloat("Hysteresis Rise Rate", m_fHysteresisRiseRate, 150.0f, 0.01f, 0, 1);
+		ImGuiHelper::DragFloat("Change Threshold", m_fHysteresisChangeThreshold, 150.0f, 0.01f, 0.001f, 10);
+
+		const ProbeConvergenceStats& kConvergenceStats = m_ConvergenceTracker.GetStats();
+
+		ImGui::Text("Converged Probes: %d / %d", kConvergenceStats.NumConverged, kConvergenceStats.NumProbes);
+		ImGui::Text("Reset Probes: %d", kConvergenceStats.NumReset);
+		ImGui::Text("Mean Hysteresis: %.3f", kConvergenceStats.MeanHysteresis);
+		ImGui::Text("Mean Convergence: %.3f", kConvergenceStats.MeanConvergence);
+
+		ImGui::Spacing();
+
+		if (ImGuiHelper::Checkbox("Probe Sleeping", m_bProbeSleeping, 150.0f) == true)
+		{
+			m_SleepTracker.WakeAll();
+		}
+
+		int iSleepFrames = m_SleepTracker.GetSleepFrames();
+
+		if (ImGui::DragInt("Sleep Frames", &iSleepFrames, 1.0f, 1, 1000) == true)
+		{
+			m_SleepTracker.SetSleepFrames(iSleepFrames);
+		}
+
+		float fSleepThreshold = m_SleepTracker.GetChangeThreshold();
+
+		if (ImGui::DragFloat("Sleep Threshold", &fSleepThreshold, 0.00005f, 0, 1, "%.5f") == true)
+		{
+			m_SleepTracker.SetChangeThreshold(fSleepThreshold);
+		}
+
+		ImGuiHelper::DragFloat("Wake Radius", m_fProbeWakeRadius, 150.0f, 0.1f, 0, 1000);
+
+		if (m_bProbeSleeping == true && m_bAdaptiveHysteresis == false)
+		{
+			ImGui::Text("Probe sleeping needs adaptive hysteresis");
+		}
+		else
+		{
+			ImGui::Text("Sleeping Probes: %d / %d", m_SleepTracker.GetNumAsleep(), m_ProbeCounts.x * m_ProbeCounts.y * m_ProbeCounts.z);
+		}
+
+		ImGui::Spacing();
+
+		ImGui::Combo("Probe Filter", &m_iProbeFilter, "None\0" "6 Neighbours\0" "26 Neighbours\0");
+		ImGuiHelper::DragFloat("Filter Strength", m_fProbeFilterStrength, 150.0f, 0.01f, 0, 1);
+
+		ImGui::Spacing();
+
 		ImGuiHelper::DragFloat("Irradiance Gamma", m_fIrradianceGammaEncoding, 150.0f, 0.1f, 0, 100);
 
 		ImGui::Spacing();
 
+		if (m_iIrradianceEncoding == PROBE_IRRADIANCE_ENCODING_OCTAHEDRAL)
+		{
+			ImGui::Text("Irradiance Encoding: Octahedral, %d texels per probe", (m_iIrradianceTexelsPerProbe + 2) * (m_iIrradianceTexelsPerProbe + 2));
+		}
+		else
+		{
+			ImGui::Text("Irradiance Encoding: SH L%d, %d texels per probe", m_iIrradianceEncoding == PROBE_IRRADIANCE_ENCODING_SH_L1 ? 1 : 2, GetNumSHCoefficients());
+		}
+
+		ImGui::Text("Atlas Layout: %s", m_iAtlasLayout == PROBE_ATLAS_LAYOUT_BRICKS ? "2x2x2 Bricks" : "Planes");
+
+		const char* kpRayDataFormats[] = { "R32G32 (10 bit UNORM)", "R32G32B32A32", "RGB9E5", "R11G11B10" };
+		const char* kpIrradianceFormats[] = { "R10G10B10A2", "R32G32B32A32", "R11G11B10" };
+
+		ImGui::Text("Ray Data Format: %s", kpRayDataFormats[m_iRayDataFormat]);
+		ImGui::Text("Irradiance Format: %s", kpIrradianceFormats[m_iIrradianceFormat]);
+
+		ImGui::Spacing();
+
 		ImGuiHelper::DragFloat("Irradiance Threshold", m_fIrradianceThreshold, 150.0f, 0.1f, 0, 100);
 
 		ImGui::Spacing();
@@ -137,37 +307,171 @@ void GIVolume::ShowUI()
 
 		ImGui::Spacing();
 
-		if (ImGuiHelper::Checkbox("Show Probes", m_bShowProbes, 150.0f) == true)
+		ImGuiHelper::Checkbox("Probe Relocation", m_bProbeRelocation, 150.0f);
+
+		ImGui::Spacing();
+
+		if (ImGuiHelper::Checkbox("Probe Classification", m_bProbeClassification, 150.0f) == true)
+		{
+			m_bActiveProbeCountValid = false;
+		}
+
+		ImGui::Spacing();
+
+		ImGui::Text("Active Probes: %d / %d", m_iNumActiveProbes, m_ProbeCounts.x * m_ProbeCounts.y * m_ProbeCounts.z);
+
+		ImGui::Spacing();
+
+		int iSchedulingMode = (int)m_ProbeScheduler.GetMode();
+
+		if (ImGui::Combo("Probe Scheduling", &iSchedulingMode, "All\0Round Robin\0Camera Proximity\0Change Magnitude\0") == true)
+		{
+			m_ProbeScheduler.SetMode((ProbeSchedulingMode)iSchedulingMode);
+		}
+
+		int iBudget = m_ProbeScheduler.GetBudget();
+
+		if (ImGui::DragInt("Probe Budget", &iBudget, 1.0f, 0, m_ProbeCounts.x * m_ProbeCounts.y * m_ProbeCounts.z) == true)
+		{
+			m_ProbeScheduler.SetBudget(iBudget);
+		}
+
+		int iMaxAge = m_ProbeScheduler.GetMaxAge();
+
+		if (ImGui::DragInt("Probe Max Age", &iMaxAge, 1.0f, 0, 1000) == true)
+		{
+			m_ProbeScheduler.SetMaxAge(iMaxAge);
+		}
+
+		ImGui::Text("Worst Case Staleness: %d frames", m_ProbeScheduler.GetMaxStaleness());
+
+		if (m_ProbeScheduler.GetMode() == ProbeSchedulingMode::CHANGE_MAGNITUDE && m_bAdaptiveHysteresis == false)
+		{
+			ImGui::Text("Change magnitude scheduling needs adaptive hysteresis");
+		}
+
+		ImGui::Spacing();
+
+		if (ImGuiHelper::Checkbox("Adaptive Rays", m_bAdaptiveRays, 150.0f) == true)
+		{
+			m_bProbeStatsValid = false;
+		}
+
+		int iRayBudget = m_RayAllocator.GetRayBudget();
+
+		if (ImGui::DragInt("Ray Budget", &iRayBudget, 256.0f, 0, m_ProbeCounts.x * m_ProbeCounts.y * m_ProbeCounts.z * m_iRaysPerProbe) == true)
+		{
+			m_RayAllocator.SetRayBudget(iRayBudget);
+		}
+
+		int iMinRays = m_RayAllocator.GetMinRays();
+
+		if (ImGui::DragInt("Min Rays Per Probe", &iMinRays, 1.0f, 1, m_iRaysPerProbe) == true)
+		{
+			m_RayAllocator.SetMinRays(iMinRays);
+		}
+
+		ImGui::Text("Error vs Fixed Rays: %.3f", m_dAdaptiveRayError);
+
+		ImGui::Spacing();
+
+		int iRotationSequence = (int)m_RayRotationGenerator.GetSequence();
+
+		if (ImGui::Combo("Ray Rotation", &iRotationSequence, "Random\0R3\0Sobol\0Blue Noise\0") == true)
 		{
-			ToggleProbeVisibility();
+			m_RayRotationGenerator.SetSequence((RayRotationSequence)iRotationSequence);
 		}
 
+		ImGuiHelper::Checkbox("Per Probe Rotation", m_bPerProbeRayRotation, 150.0f);
+
+		ImGui::Spacing();
+
+		ImGuiHelper::DragFloat("Min Frontface Distance", m_fProbeMinFrontfaceDistance, 150.0f, 0.01f, 0, 10);
+
+		ImGui::Spacing();
+
+		ImGuiHelper::DragFloat("Backface Threshold", m_fProbeBackfaceThreshold, 150.0f, 0.01f, 0, 1);
+
+		ImGui::Spacing();
+
+		ImGuiHelper::Checkbox("Show Probes", m_bShowProbes, 150.0f);
+
 		ImGui::TreePop();
 	}
 }
 
 void GIVolume::Update(const Timer& kTimer)
 {
-	UpdateRandomRotation();
+	UpdateRayRotation();
 
 	if (m_bProbeTracking == true)
 	{
 		UpdateVolumeOffsets();
 	}
 
+	//App flushes the command queue at the end of every frame so the copies recorded last frame have finished
+	if (m_SnapshotState == SnapshotState::COPYING)
+	{
+		WriteSnapshot();
+	}
+
+	//Reads back last frame's changes for sleeping before this frame's probe list is built
+	UpdateProbeConvergence();
+
+	UpdateActiveProbes();
+
+	UpdateProbeRayCounts();
+
+	UpdateRayDirectionTable();
+
 	UpdateConstantBuffers();
 }
 
 void GIVolume::Draw(DescriptorHeap* pSRVHeap, UploadBuffer<ScenePerFrameCB>* pScenePerFrameUpload, ID3D12GraphicsCommandList4* pGraphicsCommandList, AccelerationBuffers& topLevelBuffer)
 {
-	GPU_PROFILE_BEGIN(GpuStats::DRAW_VOLUME, pGraphicsCommandList)
 	PIX_ONLY(PIXBeginEvent(pGraphicsCommandList, PIX_COLOR(50, 50, 50), "Draw GI Volume"));
 
-	PopulateRayData(pSRVHeap, pScenePerFrameUpload, pGraphicsCommandList, topLevelBuffer);
+	if (m_bUploadProbeList == true)
+	{
+		UploadScheduledProbes(pGraphicsCommandList);
+	}
+
+	//Every probe can be asleep in a static scene, the blends still run to fill in the borders
+	if (m_bUseActiveProbeList == false || m_iNumActiveProbes > 0)
+	{
+		PopulateRayData(pSRVHeap, pScenePerFrameUpload, pGraphicsCommandList, topLevelBuffer);
+	}
+
 	BlendProbeAtlases(pSRVHeap, pScenePerFrameUpload, pGraphicsCommandList);
 
+	if (m_bAdaptiveHysteresis == true)
+	{
+		CopyProbeHysteresis(pGraphicsCommandList);
+	}
+
+	if (m_bProbeRelocation == true)
+	{
+		RelocateProbes(pSRVHeap, pScenePerFrameUpload, pGraphicsCommandList);
+	}
+
+	//Has to go before classification rebuilds the active probe list this frame's trace used
+	if (m_bAdaptiveRays == true)
+	{
+		UpdateProbeStats(pSRVHeap, pScenePerFrameUpload, pGraphicsCommandList);
+	}
+
+	//Still runs under a list built on the CPU so the probes it turns off can be left out of that list too
+	if (m_bProbeClassification == true)
+	{
+		ClassifyProbes(pSRVHeap, pScenePerFrameUpload, pGraphicsCommandList);
+	}
+
+	if (m_SnapshotState == SnapshotState::REQUESTED)
+	{
+		CopySnapshotAtlases(pGraphicsCommandList);
+	}
+
 	PIX_ONLY(PIXEndEvent());
-	GPU_PROFILE_END(GpuStats::DRAW_VOLUME, pGraphicsCommandList)
 }
 
 const DirectX::XMFLOAT3& GIVolume::GetPosition() const
@@ -190,6 +494,21 @@ const DirectX::XMINT3& GIVolume::GetProbeCounts() const
 	return m_ProbeCounts;
 }
 
+const DirectX::XMINT3& GIVolume::GetProbeOffsets() const
+{
+	return m_ProbeOffsets;
+}
+
+int GIVolume::GetNumProbes() const
+{
+	return m_ProbeCounts.x * m_ProbeCounts.y * m_ProbeCounts.z;
+}
+
+int GIVolume::GetCascadeIndex() const
+{
+	return m_iCascadeIndex;
+}
+
 UploadBuffer<RaytracePerFrameCB>* GIVolume::GetRaytracePerFrameUpload()
 {
 	return m_pRaytracedPerFrameUpload;
@@ -200,6 +519,11 @@ const bool& GIVolume::IsRelocating() const
 	return m_bProbeRelocation;
 }
 
+const bool& GIVolume::IsClassifying() const
+{
+	return m_bProbeClassification;
+}
+
 const bool& GIVolume::IsTracking() const
 {
 	return m_bProbeTracking;
@@ -214,21 +538,19 @@ void GIVolume::SetPosition(const DirectX::XMFLOAT3& kPosition)
 {
 	m_Position = kPosition;
 
-	UpdateProbePositions();
+	m_SleepTracker.WakeAll();
 }
 
 void GIVolume::SetProbeSpacing(const DirectX::XMFLOAT3& kProbeSpacing)
 {
 	m_ProbeSpacing = kProbeSpacing;
 
-	UpdateProbePositions();
+	m_SleepTracker.WakeAll();
 }
 
 void GIVolume::SetProbeScale(const float& kProbeScale)
 {
 	m_ProbeScale = kProbeScale;
-
-	UpdateProbeScales();
 }
 
 void GIVolume::SetProbeCounts(DirectX::XMINT3& kProbeCounts)
@@ -241,6 +563,12 @@ void GIVolume::SetIsRelocating(bool bIsRelocating)
 	m_bProbeRelocation = bIsRelocating;
 }
 
+void GIVolume::SetIsClassifying(bool bIsClassifying)
+{
+	m_bProbeClassification = bIsClassifying;
+	m_bActiveProbeCountValid = false;
+}
+
 void GIVolume::SetIsTracking(bool bIsTracking)
 {
 	m_bProbeTracking = bIsTracking;
@@ -251,12 +579,27 @@ void GIVolume::SetIsShowingProbes(bool bIsShowingProbes)
 	m_bShowProbes = bIsShowingProbes;
 }
 
+void GIVolume::WakeAllProbes()
+{
+	m_SleepTracker.WakeAll();
+}
+
+void GIVolume::WakeProbesNear(const DirectX::XMFLOAT3& kBoundsMin, const DirectX::XMFLOAT3& kBoundsMax)
+{
+	m_SleepTracker.WakeInBounds(kBoundsMin, kBoundsMax, m_fProbeWakeRadius, m_Position, m_ProbeSpacing, m_ProbeCounts, m_ProbeOffsets);
+}
+
+bool GIVolume::IsSleepingProbes() const
+{
+	return m_bProbeSleeping == true && m_bAdaptiveHysteresis == true;
+}
+
 void GIVolume::SetAnchorPosition(DirectX::XMFLOAT3 position)
 {
 	m_Anchor = position;
 }
 
-void GIVolume::Save(nlohmann::json& data)
+void GIVolume::Save(nlohmann::json& data, const std::string& ksFilename)
 {
 	data["GIVolume"]["Position"].push_back({ m_Position.x, m_Position.y, m_Position.z });
 	data["GIVolume"]["ProbeSpacing"].push_back({ m_ProbeSpacing.x, m_ProbeSpacing.y, m_ProbeSpacing.z });
@@ -266,135 +609,331 @@ void GIVolume::Save(nlohmann::json& data)
 	data["GIVolume"]["DistanceTexelsPerProbe"].push_back(m_iDistanceTexelsPerProbe);
 	data["GIVolume"]["AtlasSize"].push_back(m_AtlasSize);
 	data["GIVolume"]["ProbeRelocation"].push_back(m_bProbeRelocation);
+	data["GIVolume"]["ProbeClassification"].push_back(m_bProbeClassification);
 	data["GIVolume"]["ProbeTracking"].push_back(m_bProbeTracking);
 	data["GIVolume"]["ShowProbes"].push_back(m_bShowProbes);
 	data["GIVolume"]["MaxRayDistance"].push_back(m_fMaxRayDistance);
 	data["GIVolume"]["ViewBias"].push_back(m_fViewBias);
 	data["GIVolume"]["NormalBias"].push_back(m_fNormalBias);
 	data["GIVolume"]["RaysPerProbe"].push_back(m_iRaysPerProbe);
+	data["GIVolume"]["ProbeSchedulingMode"].push_back((int)m_ProbeScheduler.GetMode());
+	data["GIVolume"]["ProbeUpdateBudget"].push_back(m_ProbeScheduler.GetBudget());
+	data["GIVolume"]["ProbeMaxAge"].push_back(m_ProbeScheduler.GetMaxAge());
+	data["GIVolume"]["AdaptiveRays"].push_back(m_bAdaptiveRays);
+	data["GIVolume"]["RayBudget"].push_back(m_RayAllocator.GetRayBudget());
+	data["GIVolume"]["MinRaysPerProbe"].push_back(m_RayAllocator.GetMinRays());
+	data["GIVolume"]["RayRotationSequence"].push_back((int)m_RayRotationGenerator.GetSequence());
+	data["GIVolume"]["PerProbeRayRotation"].push_back(m_bPerProbeRayRotation);
 	data["GIVolume"]["BrightnessThreshold"].push_back(m_fBrightnessThreshold);
 	data["GIVolume"]["DistancePower"].push_back(m_fDistancePower);
 	data["GIVolume"]["Hysteresis"].push_back(m_fHysteresis);
+	data["GIVolume"]["AdaptiveHysteresis"].push_back(m_bAdaptiveHysteresis);
+	data["GIVolume"]["MinHysteresis"].push_back(m_fMinHysteresis);
+	data["GIVolume"]["HysteresisRiseRate"].push_back(m_fHysteresisRiseRate);
+	data["GIVolume"]["HysteresisChangeThreshold"].push_back(m_fHysteresisChangeThreshold);
+	data["GIVolume"]["ProbeSleeping"].push_back(m_bProbeSleeping);
+	data["GIVolume"]["ProbeSleepFrames"].push_back(m_SleepTracker.GetSleepFrames());
+	data["GIVolume"]["ProbeSleepThreshold"].push_back(m_SleepTracker.GetChangeThreshold());
+	data["GIVolume"]["ProbeWakeRadius"].push_back(m_fProbeWakeRadius);
+	data["GIVolume"]["ProbeFilter"].push_back(m_iProbeFilter);
+	data["GIVolume"]["ProbeFilterStrength"].push_back(m_fProbeFilterStrength);
+	data["GIVolume"]["RayDataFormat"].push_back(m_iRayDataFormat);
 	data["GIVolume"]["IrradianceFormat"].push_back(m_iIrradianceFormat);
+	data["GIVolume"]["IrradianceEncoding"].push_back(m_iIrradianceEncoding);
+	data["GIVolume"]["AtlasLayout"].push_back(m_iAtlasLayout);
 	data["GIVolume"]["IrradianceGammaEncoding"].push_back(m_fIrradianceGammaEncoding);
 	data["GIVolume"]["IrradianceThreshold"].push_back(m_fIrradianceThreshold);
+	data["GIVolume"]["ProbeMinFrontfaceDistance"].push_back(m_fProbeMinFrontfaceDistance);
+	data["GIVolume"]["ProbeBackfaceThreshold"].push_back(m_fProbeBackfaceThreshold);
 	data["GIVolume"]["MissRadiance"].push_back({ m_MissRadiance.x, m_MissRadiance.y, m_MissRadiance.z });
 	data["GIVolume"]["ProbeOffsets"].push_back({ m_ProbeOffsets.x, m_ProbeOffsets.y, m_ProbeOffsets.z });
 	data["GIVolume"]["AnchorPosition"].push_back({ m_Anchor.x, m_Anchor.y, m_Anchor.z });
+
+	//The atlases can only be read back once this frame's blend has been recorded so the file is written a frame later
+	m_sSnapshotFilepath = ksFilename + "_GI.bin";
+	m_SnapshotState = SnapshotState::REQUESTED;
+
+	data["GIVolume"]["AtlasSnapshot"].push_back(m_sSnapshotFilepath);
 }
 
-void GIVolume::CreateProbeGameObjects(ID3D12GraphicsCommandList4* pCommandList)
+bool GIVolume::LoadSnapshot(const std::string& ksFilepath)
 {
-	App::GetApp()->ResetCommandList();
+	AtlasSnapshot snapshot;
 
-	MeshManager::GetInstance()->LoadMesh("Models/Sphere/gLTF/Sphere.gltf", "Sphere", pCommandList);
+	if (snapshot.Open(ksFilepath) == false)
+	{
+		return false;
+	}
 
-	Mesh* pMesh = nullptr;
-	MeshManager::GetInstance()->GetMesh("Sphere", pMesh);
+	if (snapshot.IsCompatible(GetSnapshotDesc()) == false)
+	{
+		LOG_WARNING(tag, L"Ignoring GI atlas snapshot %s as it was saved with different probe or texel counts!", std::wstring(ksFilepath.begin(), ksFilepath.end()).c_str());
 
-	GameObject* pGameObject = nullptr;
-	int iIndex = -1;
+		return false;
+	}
 
-	XMFLOAT3 totalDimensions = XMFLOAT3(m_ProbeSpacing.x * (m_ProbeCounts.x - 1), m_ProbeSpacing.y * (m_ProbeCounts.y - 1), m_ProbeSpacing.z * (m_ProbeCounts.z - 1));
-	XMFLOAT3 offset;
+	int iNumAtlases = (int)SnapshotAtlas::COUNT;
 
-	m_ProbeGameObjects.reserve(m_ProbeCounts.x * m_ProbeCounts.y * m_ProbeCounts.z);
+	std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> footprints(iNumAtlases);
+	std::vector<UINT64> uploadSizes(iNumAtlases);
 
-	for (int i = 0; i < m_ProbeCounts.x; ++i)
+	//Check everything lines up before touching the atlases so a bad snapshot leaves them as they were
+	for (int i = 0; i < iNumAtlases; ++i)
 	{
-		for (int j = 0; j < m_ProbeCounts.y; ++j)
-		{
-			for (int k = 0; k < m_ProbeCounts.z; ++k)
-			{
-				iIndex = i + m_ProbeCounts.x * (j + m_ProbeCounts.z * k);
+		D3D12_RESOURCE_DESC desc = GetSnapshotAtlas(i)->GetResource()->GetDesc();
 
-				offset = XMFLOAT3((i * m_ProbeSpacing.x) - totalDimensions.x * 0.5f, (j * m_ProbeSpacing.y) - totalDimensions.y * 0.5f, (k * m_ProbeSpacing.z) - totalDimensions.z * 0.5f);
+		UINT uiNumRows = 0;
+		UINT64 uiRowSize = 0;
+		App::GetApp()->GetDevice()->GetCopyableFootprints(&desc, 0, 1, 0, &footprints[i], &uiNumRows, &uiRowSize, &uploadSizes[i]);
 
-				pGameObject = new GameObject();
-				pGameObject->Init("Probe" + std::to_string(iIndex), XMFLOAT3(m_Position.x + offset.x, m_Position.y + offset.y, m_Position.z + offset.z), XMFLOAT3(), XMFLOAT3(m_ProbeScale, m_ProbeScale, m_ProbeScale), pMesh, m_bShowProbes, false, false);
+		if (snapshot.IsCompatible((SnapshotAtlas)i, desc.Format, desc.Width, uiNumRows, uiRowSize) == false)
+		{
+			LOG_WARNING(tag, L"Ignoring GI atlas snapshot %s as its atlases don't match the volume's!", std::wstring(ksFilepath.begin(), ksFilepath.end()).c_str());
 
-				m_ProbeGameObjects.push_back(pGameObject);
-			}
+			return false;
 		}
 	}
 
-	App::GetApp()->ExecuteCommandList();
-}
-
-void GIVolume::UpdateProbePositions()
-{
-	XMFLOAT3 totalDimensions = XMFLOAT3(m_ProbeSpacing.x * (m_ProbeCounts.x - 1), m_ProbeSpacing.y * (m_ProbeCounts.y - 1), m_ProbeSpacing.z * (m_ProbeCounts.z - 1));
-	XMFLOAT3 offset;
+	std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> uploads(iNumAtlases);
 
-	for (int i = 0; i < m_ProbeCounts.x; ++i)
+	for (int i = 0; i < iNumAtlases; ++i)
 	{
-		for (int j = 0; j < m_ProbeCounts.y; ++j)
+		HRESULT hr = App::GetApp()->GetDevice()->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+																		D3D12_HEAP_FLAG_NONE,
+																		&CD3DX12_RESOURCE_DESC::Buffer(uploadSizes[i]),
+																		D3D12_RESOURCE_STATE_GENERIC_READ,
+																		nullptr,
+																		IID_PPV_ARGS(uploads[i].GetAddressOf()));
+
+		if (FAILED(hr))
 		{
-			for (int k = 0; k < m_ProbeCounts.z; ++k)
-			{
-				offset = XMFLOAT3(((i + m_ProbeOffsets.x) * m_ProbeSpacing.x) - totalDimensions.x * 0.5f, ((j + m_ProbeOffsets.y) * m_ProbeSpacing.y) - totalDimensions.y * 0.5f, ((k + m_ProbeOffsets.z) * m_ProbeSpacing.z) - totalDimensions.z * 0.5f);
+			LOG_ERROR(tag, L"Failed to create the upload buffer for the GI atlas snapshot!");
 
-				m_ProbeGameObjects[i + m_ProbeCounts.x * (j + m_ProbeCounts.z * k)]->SetPosition(XMFLOAT3(m_Position.x + offset.x, m_Position.y + offset.y, m_Position.z + offset.z));
-			}
+			return false;
 		}
-	}
-}
 
-void GIVolume::UpdateProbeScales()
-{
-	for (int i = 0; i < m_ProbeCounts.x; ++i)
-	{
-		for (int j = 0; j < m_ProbeCounts.y; ++j)
+		BYTE* pMappedData = nullptr;
+		hr = uploads[i]->Map(0, nullptr, reinterpret_cast<void**>(&pMappedData));
+
+		if (FAILED(hr))
 		{
-			for (int k = 0; k < m_ProbeCounts.z; ++k)
-			{
-				m_ProbeGameObjects[i + m_ProbeCounts.x * (j + m_ProbeCounts.z * k)]->SetScale(XMFLOAT3(m_ProbeScale, m_ProbeScale, m_ProbeScale));
-			}
+			LOG_ERROR(tag, L"Failed to map the upload buffer for the GI atlas snapshot!");
+
+			return false;
 		}
-	}
-}
 
-void GIVolume::ToggleProbeVisibility()
-{
-	for (int i = 0; i < m_ProbeCounts.x; ++i)
-	{
-		for (int j = 0; j < m_ProbeCounts.y; ++j)
+		//Rows are packed tightly in the file but have to be padded out to the row pitch for the copy
+		const AtlasSnapshotEntry* kpEntry = snapshot.GetEntry((SnapshotAtlas)i);
+		const BYTE* kpSource = snapshot.GetData(kpEntry);
+
+		for (UINT32 uiRow = 0; uiRow < kpEntry->Height; ++uiRow)
 		{
-			for (int k = 0; k < m_ProbeCounts.z; ++k)
-			{
-				m_ProbeGameObjects[i + m_ProbeCounts.x * (j + m_ProbeCounts.z * k)]->SetIsRendering(m_bShowProbes);
-			}
+			memcpy(pMappedData + footprints[i].Offset + (UINT64)uiRow * footprints[i].Footprint.RowPitch, kpSource + (UINT64)uiRow * kpEntry->RowSize, kpEntry->RowSize);
 		}
-	}
-}
 
-bool GIVolume::CreateTextureAtlases(DescriptorHeap* pSRVHeap, DescriptorHeap* pRTVHeap)
-{
-	if (CreateRayDataAtlas(pSRVHeap) == false)
-	{
-		return false;
+		uploads[i]->Unmap(0, nullptr);
 	}
 
-	if (CreateIrradianceAtlas(pSRVHeap, pRTVHeap) == false)
+	App::GetApp()->ResetCommandList();
+
+	ID3D12GraphicsCommandList4* pGraphicsCommandList = App::GetApp()->GetGraphicsCommandList();
+
+	std::vector<CD3DX12_RESOURCE_BARRIER> barriers(iNumAtlases);
+
+	for (int i = 0; i < iNumAtlases; ++i)
 	{
-		return false;
+		barriers[i] = CD3DX12_RESOURCE_BARRIER::Transition(GetSnapshotAtlas(i)->GetResource().Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
 	}
 
-	if (CreateDistanceAtlas(pSRVHeap, pRTVHeap) == false)
+	pGraphicsCommandList->ResourceBarrier(iNumAtlases, barriers.data());
+
+	for (int i = 0; i < iNumAtlases; ++i)
 	{
-		return false;
+		CD3DX12_TEXTURE_COPY_LOCATION destination = CD3DX12_TEXTURE_COPY_LOCATION(GetSnapshotAtlas(i)->GetResource().Get(), 0);
+		CD3DX12_TEXTURE_COPY_LOCATION source = CD3DX12_TEXTURE_COPY_LOCATION(uploads[i].Get(), footprints[i]);
+
+		pGraphicsCommandList->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
 	}
 
-	if (CreateProbeDataAtlas(pSRVHeap) == false)
+	for (int i = 0; i < iNumAtlases; ++i)
 	{
-		return false;
+		barriers[i] = CD3DX12_RESOURCE_BARRIER::Transition(GetSnapshotAtlas(i)->GetResource().Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 	}
 
-	return true;
-}
+	pGraphicsCommandList->ResourceBarrier(iNumAtlases, barriers.data());
 
-bool GIVolume::CreateRayDataAtlas(DescriptorHeap* pSRVHeap)
-{
+	App::GetApp()->ExecuteCommandList();
+
+	//Scrolled probes are stored at their offsetted index so the volume has to be where it was when the snapshot was taken
+	m_Position = snapshot.GetDesc().Position;
+	m_ProbeOffsets = snapshot.GetDesc().ProbeOffsets;
+
+	//The active probe list on the GPU doesn't match the loaded probe states so every probe is updated next frame
+	m_bActiveProbeCountValid = false;
+
+	m_SleepTracker.WakeAll();
+
+	UpdateConstantBuffers();
+
+	LOG_VERBOSE(tag, L"Loaded GI atlas snapshot %s", std::wstring(ksFilepath.begin(), ksFilepath.end()).c_str());
+
+	return true;
+}
+
+int GIVolume::GetNumActiveProbes() const
+{
+	return m_iNumActiveProbes;
+}
+
+const ProbeConvergenceStats& GIVolume::GetConvergenceStats() const
+{
+	return m_ConvergenceTracker.GetStats();
+}
+
+float GIVolume::GetProbeConvergence(int iProbeIndex) const
+{
+	return m_ConvergenceTracker.GetProbeConvergence(iProbeIndex);
+}
+
+float GIVolume::GetProbeHysteresis(int iProbeIndex) const
+{
+	return m_ConvergenceTracker.GetProbeHysteresis(iProbeIndex);
+}
+
+int GIVolume::GetNumSleepingProbes() const
+{
+	return IsSleepingProbes() == true ? m_SleepTracker.GetNumAsleep() : 0;
+}
+
+AtlasSnapshotDesc GIVolume::GetSnapshotDesc() const
+{
+	AtlasSnapshotDesc snapshotDesc;
+	snapshotDesc.Position = m_Position;
+	snapshotDesc.ProbeCounts = m_ProbeCounts;
+	snapshotDesc.ProbeOffsets = m_ProbeOffsets;
+	snapshotDesc.IrradianceTexelsPerProbe = m_iIrradianceTexelsPerProbe;
+	snapshotDesc.DistanceTexelsPerProbe = m_iDistanceTexelsPerProbe;
+	snapshotDesc.GIAtlasSize = (int)m_AtlasSize;
+	snapshotDesc.RayDataFormat = m_iRayDataFormat;
+	snapshotDesc.IrradianceFormat = m_iIrradianceFormat;
+	snapshotDesc.IrradianceEncoding = m_iIrradianceEncoding;
+	snapshotDesc.AtlasLayout = m_iAtlasLayout;
+
+	return snapshotDesc;
+}
+
+GIVolumeDesc GIVolume::GetVolumeDesc() const
+{
+	GIVolumeDesc volumeDesc;
+	volumeDesc.Position = m_Position;
+	volumeDesc.ProbeCounts = m_ProbeCounts;
+	volumeDesc.ProbeRelocation = m_bProbeRelocation;
+	volumeDesc.ProbeClassification = m_bProbeClassification;
+	volumeDesc.ProbeScale = m_ProbeScale;
+	volumeDesc.ProbeSpacing = m_ProbeSpacing;
+	volumeDesc.ProbeTracking = m_bProbeTracking;
+	volumeDesc.IrradianceTexelsPerProbe = m_iIrradianceTexelsPerProbe;
+	volumeDesc.DistanceTexelsPerProbe = m_iDistanceTexelsPerProbe;
+	volumeDesc.GIAtlasSize = (int)m_AtlasSize;
+	volumeDesc.ShowProbes = m_bShowProbes;
+	volumeDesc.MaxRayDistance = m_fMaxRayDistance;
+	volumeDesc.ViewBias = m_fViewBias;
+	volumeDesc.NormalBias = m_fNormalBias;
+	volumeDesc.RaysPerProbe = m_iRaysPerProbe;
+	volumeDesc.ProbeSchedulingMode = (int)m_ProbeScheduler.GetMode();
+	volumeDesc.ProbeUpdateBudget = m_ProbeScheduler.GetBudget();
+	volumeDesc.ProbeMaxAge = m_ProbeScheduler.GetMaxAge();
+	volumeDesc.AdaptiveRays = m_bAdaptiveRays;
+	volumeDesc.RayBudget = m_RayAllocator.GetRayBudget();
+	volumeDesc.MinRaysPerProbe = m_RayAllocator.GetMinRays();
+	volumeDesc.RayRotationSequence = (int)m_RayRotationGenerator.GetSequence();
+	volumeDesc.PerProbeRayRotation = m_bPerProbeRayRotation;
+	volumeDesc.CascadeIndex = m_iCascadeIndex;
+	volumeDesc.BrightnessThreshold = m_fBrightnessThreshold;
+	volumeDesc.DistancePower = m_fDistancePower;
+	volumeDesc.Hysteresis = m_fHysteresis;
+	volumeDesc.AdaptiveHysteresis = m_bAdaptiveHysteresis;
+	volumeDesc.MinHysteresis = m_fMinHysteresis;
+	volumeDesc.HysteresisRiseRate = m_fHysteresisRiseRate;
+	volumeDesc.HysteresisChangeThreshold = m_fHysteresisChangeThreshold;
+	volumeDesc.ProbeSleeping = m_bProbeSleeping;
+	volumeDesc.ProbeSleepFrames = m_SleepTracker.GetSleepFrames();
+	volumeDesc.ProbeSleepThreshold = m_SleepTracker.GetChangeThreshold();
+	volumeDesc.ProbeWakeRadius = m_fProbeWakeRadius;
+	volumeDesc.ProbeFilter = m_iProbeFilter;
+	volumeDesc.ProbeFilterStrength = m_fProbeFilterStrength;
+	volumeDesc.RayDataFormat = m_iRayDataFormat;
+	volumeDesc.IrradianceFormat = m_iIrradianceFormat;
+	volumeDesc.IrradianceEncoding = m_iIrradianceEncoding;
+	volumeDesc.AtlasLayout = m_iAtlasLayout;
+	volumeDesc.IrradianceGammaEncoding = m_fIrradianceGammaEncoding;
+	volumeDesc.IrradianceThreshold = m_fIrradianceThreshold;
+	volumeDesc.ProbeMinFrontfaceDistance = m_fProbeMinFrontfaceDistance;
+	volumeDesc.ProbeBackfaceThreshold = m_fProbeBackfaceThreshold;
+	volumeDesc.MissRadiance = m_MissRadiance;
+	volumeDesc.ProbeOffsets = m_ProbeOffsets;
+	volumeDesc.Anchor = m_Anchor;
+
+	return volumeDesc;
+}
+
+bool GIVolume::CreateTextureAtlases(DescriptorHeap* pSRVHeap, DescriptorHeap* pRTVHeap)
+{
+	if (CreateRayDataAtlas(pSRVHeap) == false)
+	{
+		return false;
+	}
+
+	if (CreateIrradianceAtlas(pSRVHeap, pRTVHeap) == false)
+	{
+		return false;
+	}
+
+	if (CreateFilteredIrradianceAtlas(pSRVHeap) == false)
+	{
+		return false;
+	}
+
+	if (CreateDistanceAtlas(pSRVHeap, pRTVHeap) == false)
+	{
+		return false;
+	}
+
+	if (CreateProbeDataAtlas(pSRVHeap) == false)
+	{
+		return false;
+	}
+
+	if (CreateActiveProbeList(pSRVHeap) == false)
+	{
+		return false;
+	}
+
+	if (CreateProbeStatsAtlas(pSRVHeap) == false)
+	{
+		return false;
+	}
+
+	if (CreateProbeHysteresisAtlas(pSRVHeap) == false)
+	{
+		return false;
+	}
+
+	if (CreateRayDirectionTable(pSRVHeap) == false)
+	{
+		return false;
+	}
+
+	if (CreateProbePositions(pSRVHeap) == false)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+bool GIVolume::CreateRayDataAtlas(DescriptorHeap* pSRVHeap)
+{
 	if (m_pRayDataAtlas != nullptr)
 	{
 		delete m_pRayDataAtlas;
@@ -429,9 +968,10 @@ bool GIVolume::CreateProbeDataAtlas(DescriptorHeap* pSRVHeap)
 		m_pProbeDataAtlas = nullptr;
 	}
 
-	m_pProbeDataAtlas = new Texture(nullptr, GetRayDataFormat());
+	m_pProbeDataAtlas = new Texture(nullptr, GetProbeDataFormat());
 
-	if (m_pProbeDataAtlas->CreateResource(m_ProbeCounts.x * m_ProbeCounts.y, m_ProbeCounts.z, 1, GetRayDataFormat(), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE) == false)
+	//XYZ is the relocation offset as a fraction of the probe spacing
+	if (m_pProbeDataAtlas->CreateResource(m_ProbeCounts.x * m_ProbeCounts.y, m_ProbeCounts.z, 1, GetProbeDataFormat(), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE) == false)
 	{
 		return false;
 	}
@@ -449,6 +989,242 @@ bool GIVolume::CreateProbeDataAtlas(DescriptorHeap* pSRVHeap)
 	return true;
 }
 
+bool GIVolume::CreateActiveProbeList(DescriptorHeap* pSRVHeap)
+{
+	int iNumProbes = m_ProbeCounts.x * m_ProbeCounts.y * m_ProbeCounts.z;
+
+	//The count and list are followed by the traced probe mask for lists built on the CPU
+	UINT uiNumElements = iNumProbes + 1 + ProbeHelper::GetTracedProbeMaskSize(iNumProbes);
+
+	HRESULT hr = App::GetApp()->GetDevice()->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+																	D3D12_HEAP_FLAG_NONE,
+																	&CD3DX12_RESOURCE_DESC::Buffer(uiNumElements * sizeof(UINT), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+																	D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+																	nullptr,
+																	IID_PPV_ARGS(m_pActiveProbeList.ReleaseAndGetAddressOf()));
+
+	if (FAILED(hr))
+	{
+		LOG_ERROR(tag, L"Failed to create the active probe list!");
+
+		return false;
+	}
+
+	hr = App::GetApp()->GetDevice()->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+															D3D12_HEAP_FLAG_NONE,
+															&CD3DX12_RESOURCE_DESC::Buffer(uiNumElements * sizeof(UINT)),
+															D3D12_RESOURCE_STATE_COPY_DEST,
+															nullptr,
+															IID_PPV_ARGS(m_pActiveProbeListReadback.ReleaseAndGetAddressOf()));
+
+	if (FAILED(hr))
+	{
+		LOG_ERROR(tag, L"Failed to create the active probe list readback buffer!");
+
+		return false;
+	}
+
+	//Copied over the count before each classification pass
+	m_pActiveProbeCountReset = new UploadBuffer<UINT>(App::GetApp()->GetDevice(), 1, false);
+	m_pActiveProbeCountReset->CopyData(0, 0);
+
+	m_pScheduledProbeListUpload = new UploadBuffer<UINT>(App::GetApp()->GetDevice(), uiNumElements, false);
+
+	UINT uiIndex;
+
+	if (pSRVHeap->Allocate(uiIndex) == false)
+	{
+		return false;
+	}
+
+	m_pActiveProbeListSRV = new SRVDescriptor(uiIndex, pSRVHeap->GetCpuDescriptorHandle(uiIndex), m_pActiveProbeList.Get(), D3D12_SRV_DIMENSION_BUFFER, uiNumElements, DXGI_FORMAT_R32_UINT, D3D12_BUFFER_SRV_FLAG_NONE, 0, 0);
+
+	if (pSRVHeap->Allocate(uiIndex) == false)
+	{
+		return false;
+	}
+
+	m_pActiveProbeListUAV = new UAVDescriptor(uiIndex, pSRVHeap->GetCpuDescriptorHandle(uiIndex), m_pActiveProbeList.Get(), uiNumElements, DXGI_FORMAT_R32_UINT, 0, 0);
+
+	return true;
+}
+
+bool GIVolume::CreateProbeStatsAtlas(DescriptorHeap* pSRVHeap)
+{
+	if (m_pProbeStatsAtlas != nullptr)
+	{
+		delete m_pProbeStatsAtlas;
+		m_pProbeStatsAtlas = nullptr;
+	}
+
+	m_pProbeStatsAtlas = new Texture(nullptr, DXGI_FORMAT_R32G32_FLOAT);
+
+	//Laid out the same as the probe data atlas, x is the mean luminance and y the variance
+	if (m_pProbeStatsAtlas->CreateResource(m_ProbeCounts.x * m_ProbeCounts.y, m_ProbeCounts.z, 1, DXGI_FORMAT_R32G32_FLOAT, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_UNORDERED_ACCESS) == false)
+	{
+		return false;
+	}
+
+	if (m_pProbeStatsAtlas->CreateUAVDesc(pSRVHeap) == false)
+	{
+		return false;
+	}
+
+	D3D12_RESOURCE_DESC desc = m_pProbeStatsAtlas->GetResource()->GetDesc();
+
+	UINT64 uiReadbackSize = 0;
+	App::GetApp()->GetDevice()->GetCopyableFootprints(&desc, 0, 1, 0, &m_ProbeStatsFootprint, nullptr, nullptr, &uiReadbackSize);
+
+	HRESULT hr = App::GetApp()->GetDevice()->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+																	D3D12_HEAP_FLAG_NONE,
+																	&CD3DX12_RESOURCE_DESC::Buffer(uiReadbackSize),
+																	D3D12_RESOURCE_STATE_COPY_DEST,
+																	nullptr,
+																	IID_PPV_ARGS(m_pProbeStatsReadback.ReleaseAndGetAddressOf()));
+
+	if (FAILED(hr))
+	{
+		LOG_ERROR(tag, L"Failed to create the probe statistics readback buffer!");
+
+		return false;
+	}
+
+	UINT uiNumProbes = m_ProbeCounts.x * m_ProbeCounts.y * m_ProbeCounts.z;
+
+	if (m_pProbeRayCountsUpload != nullptr)
+	{
+		delete m_pProbeRayCountsUpload;
+		m_pProbeRayCountsUpload = nullptr;
+	}
+
+	//Written by the CPU every frame and read straight from the upload heap by the shaders
+	m_pProbeRayCountsUpload = new UploadBuffer<UINT>(App::GetApp()->GetDevice(), uiNumProbes, false);
+
+	UINT uiIndex;
+
+	if (pSRVHeap->Allocate(uiIndex) == false)
+	{
+		return false;
+	}
+
+	m_pProbeRayCountsSRV = new SRVDescriptor(uiIndex, pSRVHeap->GetCpuDescriptorHandle(uiIndex), m_pProbeRayCountsUpload->Get(), D3D12_SRV_DIMENSION_BUFFER, uiNumProbes, DXGI_FORMAT_R32_UINT, D3D12_BUFFER_SRV_FLAG_NONE, 0, 0);
+
+	m_RayAllocator.AllocateUniform(uiNumProbes, m_ProbeRayCounts);
+	m_pProbeRayCountsUpload->CopyData(0, m_ProbeRayCounts);
+
+	m_bProbeStatsValid = false;
+
+	return true;
+}
+
+bool GIVolume::CreateProbeHysteresisAtlas(DescriptorHeap* pSRVHeap)
+{
+	if (m_pProbeHysteresisAtlas != nullptr)
+	{
+		delete m_pProbeHysteresisAtlas;
+		m_pProbeHysteresisAtlas = nullptr;
+	}
+
+	m_pProbeHysteresisAtlas = new Texture(nullptr, DXGI_FORMAT_R32G32_FLOAT);
+
+	//Laid out the same as the probe data atlas, x is the probe's hysteresis and y its smoothed irradiance change
+	if (m_pProbeHysteresisAtlas->CreateResource(m_ProbeCounts.x * m_ProbeCounts.y, m_ProbeCounts.z, 1, DXGI_FORMAT_R32G32_FLOAT, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_UNORDERED_ACCESS) == false)
+	{
+		return false;
+	}
+
+	if (m_pProbeHysteresisAtlas->CreateUAVDesc(pSRVHeap) == false)
+	{
+		return false;
+	}
+
+	D3D12_RESOURCE_DESC desc = m_pProbeHysteresisAtlas->GetResource()->GetDesc();
+
+	UINT64 uiReadbackSize = 0;
+	App::GetApp()->GetDevice()->GetCopyableFootprints(&desc, 0, 1, 0, &m_ProbeHysteresisFootprint, nullptr, nullptr, &uiReadbackSize);
+
+	HRESULT hr = App::GetApp()->GetDevice()->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+																	D3D12_HEAP_FLAG_NONE,
+																	&CD3DX12_RESOURCE_DESC::Buffer(uiReadbackSize),
+																	D3D12_RESOURCE_STATE_COPY_DEST,
+																	nullptr,
+																	IID_PPV_ARGS(m_pProbeHysteresisReadback.ReleaseAndGetAddressOf()));
+
+	if (FAILED(hr))
+	{
+		LOG_ERROR(tag, L"Failed to create the probe hysteresis readback buffer!");
+
+		return false;
+	}
+
+	m_ConvergenceTracker.Reset();
+	m_bProbeHysteresisValid = false;
+
+	return true;
+}
+
+bool GIVolume::CreateRayDirectionTable(DescriptorHeap* pSRVHeap)
+{
+	if (m_pRayDirectionTableUpload != nullptr)
+	{
+		delete m_pRayDirectionTableUpload;
+		m_pRayDirectionTableUpload = nullptr;
+	}
+
+	//Written by the CPU every frame and read straight from the upload heap by the shaders, same as the ray counts
+	m_pRayDirectionTableUpload = new UploadBuffer<DirectX::XMFLOAT4>(App::GetApp()->GetDevice(), m_iRaysPerProbe, false);
+
+	UINT uiIndex;
+
+	if (pSRVHeap->Allocate(uiIndex) == false)
+	{
+		return false;
+	}
+
+	m_pRayDirectionTableSRV = new SRVDescriptor(uiIndex, pSRVHeap->GetCpuDescriptorHandle(uiIndex), m_pRayDirectionTableUpload->Get(), D3D12_SRV_DIMENSION_BUFFER, m_iRaysPerProbe, DXGI_FORMAT_R32G32B32A32_FLOAT, D3D12_BUFFER_SRV_FLAG_NONE, 0, 0);
+
+	UpdateRayDirectionTable();
+
+	return true;
+}
+
+bool GIVolume::CreateProbePositions(DescriptorHeap* pSRVHeap)
+{
+	UINT uiNumElements = m_ProbeCounts.x * m_ProbeCounts.y * m_ProbeCounts.z;
+
+	HRESULT hr = App::GetApp()->GetDevice()->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+																	D3D12_HEAP_FLAG_NONE,
+																	&CD3DX12_RESOURCE_DESC::Buffer(uiNumElements * sizeof(DirectX::XMFLOAT4), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+																	D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+																	nullptr,
+																	IID_PPV_ARGS(m_pProbePositions.ReleaseAndGetAddressOf()));
+
+	if (FAILED(hr))
+	{
+		LOG_ERROR(tag, L"Failed to create the probe positions buffer!");
+
+		return false;
+	}
+
+	UINT uiIndex;
+
+	if (pSRVHeap->Allocate(uiIndex) == false)
+	{
+		return false;
+	}
+
+	m_pProbePositionsSRV = new SRVDescriptor(uiIndex, pSRVHeap->GetCpuDescriptorHandle(uiIndex), m_pProbePositions.Get(), D3D12_SRV_DIMENSION_BUFFER, uiNumElements, DXGI_FORMAT_R32G32B32A32_FLOAT, D3D12_BUFFER_SRV_FLAG_NONE, 0, 0);
+
+	if (pSRVHeap->Allocate(uiIndex) == false)
+	{
+		return false;
+	}
+
+	m_pProbePositionsUAV = new UAVDescriptor(uiIndex, pSRVHeap->GetCpuDescriptorHandle(uiIndex), m_pProbePositions.Get(), uiNumElements, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 0);
+
+	return true;
+}
+
 bool GIVolume::CreateIrradianceAtlas(DescriptorHeap* pSRVHeap, DescriptorHeap* pRTVHeap)
 {
 	if (m_pIrradianceAtlas != nullptr)
@@ -457,9 +1233,21 @@ bool GIVolume::CreateIrradianceAtlas(DescriptorHeap* pSRVHeap, DescriptorHeap* p
 		m_pIrradianceAtlas = nullptr;
 	}
 
-	m_pIrradianceAtlas = new Texture(nullptr, GetRayDataFormat());
+	//SH probes take a row of coefficients each and need a signed format
+	UINT uiWidth = m_ProbeCounts.x * m_ProbeCounts.y * (UINT)(m_iIrradianceTexelsPerProbe + 2);
+	UINT uiHeight = m_ProbeCounts.z * (UINT)(m_iIrradianceTexelsPerProbe + 2);
+	DXGI_FORMAT format = GetRayDataFormat();
+
+	if (m_iIrradianceEncoding != PROBE_IRRADIANCE_ENCODING_OCTAHEDRAL)
+	{
+		uiWidth = m_ProbeCounts.x * m_ProbeCounts.y * (UINT)GetNumSHCoefficients();
+		uiHeight = m_ProbeCounts.z;
+		format = GetSHFormat();
+	}
+
+	m_pIrradianceAtlas = new Texture(nullptr, format);
 
-	if (m_pIrradianceAtlas->CreateResource(m_ProbeCounts.x * m_ProbeCounts.y * (UINT)(m_iIrradianceTexelsPerProbe + 2), m_ProbeCounts.z * (UINT)(m_iIrradianceTexelsPerProbe + 2), 1, GetRayDataFormat(), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS | D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE) == false)
+	if (m_pIrradianceAtlas->CreateResource(uiWidth, uiHeight, 1, format, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS | D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE) == false)
 	{
 		return false;
 	}
@@ -482,6 +1270,37 @@ bool GIVolume::CreateIrradianceAtlas(DescriptorHeap* pSRVHeap, DescriptorHeap* p
 	return true;
 }
 
+bool GIVolume::CreateFilteredIrradianceAtlas(DescriptorHeap* pSRVHeap)
+{
+	if (m_pFilteredIrradianceAtlas != nullptr)
+	{
+		delete m_pFilteredIrradianceAtlas;
+		m_pFilteredIrradianceAtlas = nullptr;
+	}
+
+	//Same size and format as the irradiance atlas so the shading and border blend can't tell them apart
+	D3D12_RESOURCE_DESC desc = m_pIrradianceAtlas->GetResource()->GetDesc();
+
+	m_pFilteredIrradianceAtlas = new Texture(nullptr, desc.Format);
+
+	if (m_pFilteredIrradianceAtlas->CreateResource(desc.Width, desc.Height, 1, desc.Format, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE) == false)
+	{
+		return false;
+	}
+
+	if (m_pFilteredIrradianceAtlas->CreateSRVDesc(pSRVHeap) == false)
+	{
+		return false;
+	}
+
+	if (m_pFilteredIrradianceAtlas->CreateUAVDesc(pSRVHeap) == false)
+	{
+		return false;
+	}
+
+	return true;
+}
+
 bool GIVolume::CreateDistanceAtlas(DescriptorHeap* pSRVHeap, DescriptorHeap* pRTVHeap)
 {
 	if (m_pDistanceAtlas != nullptr)
@@ -662,6 +1481,34 @@ bool GIVolume::CreateRootSignatures()
 		textureAtlasRange[0].RegisterSpace = 0;
 		textureAtlasRange[0].OffsetInDescriptorsFromTableStart = 0;
 
+		D3D12_DESCRIPTOR_RANGE1 probeHysteresisRange[1] = {};
+		probeHysteresisRange[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+		probeHysteresisRange[0].NumDescriptors = 1;
+		probeHysteresisRange[0].BaseShaderRegister = 2;
+		probeHysteresisRange[0].RegisterSpace = 0;
+		probeHysteresisRange[0].OffsetInDescriptorsFromTableStart = 0;
+
+		D3D12_DESCRIPTOR_RANGE1 activeProbeListRange[1] = {};
+		activeProbeListRange[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+		activeProbeListRange[0].NumDescriptors = 1;
+		activeProbeListRange[0].BaseShaderRegister = 3;
+		activeProbeListRange[0].RegisterSpace = 0;
+		activeProbeListRange[0].OffsetInDescriptorsFromTableStart = 0;
+
+		D3D12_DESCRIPTOR_RANGE1 probePositionsRange[1] = {};
+		probePositionsRange[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+		probePositionsRange[0].NumDescriptors = 1;
+		probePositionsRange[0].BaseShaderRegister = 4;
+		probePositionsRange[0].RegisterSpace = 0;
+		probePositionsRange[0].OffsetInDescriptorsFromTableStart = 0;
+
+		D3D12_DESCRIPTOR_RANGE1 unfilteredIrradianceRange[1] = {};
+		unfilteredIrradianceRange[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+		unfilteredIrradianceRange[0].NumDescriptors = 1;
+		unfilteredIrradianceRange[0].BaseShaderRegister = 5;
+		unfilteredIrradianceRange[0].RegisterSpace = 0;
+		unfilteredIrradianceRange[0].OffsetInDescriptorsFromTableStart = 0;
+
 		D3D12_ROOT_PARAMETER1 slotRootParameter[RaytracingPass::ProbeBlendingRootSignatureParams::COUNT] = {};
 
 		//SRV descriptors
@@ -682,6 +1529,30 @@ bool GIVolume::CreateRootSignatures()
 		slotRootParameter[RaytracingPass::ProbeBlendingRootSignatureParams::TEXTURE_ATLAS].DescriptorTable.pDescriptorRanges = textureAtlasRange;
 		slotRootParameter[RaytracingPass::ProbeBlendingRootSignatureParams::TEXTURE_ATLAS].DescriptorTable.NumDescriptorRanges = _countof(textureAtlasRange);
 
+		//Probe hysteresis UAV
+		slotRootParameter[RaytracingPass::ProbeBlendingRootSignatureParams::PROBE_HYSTERESIS].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+		slotRootParameter[RaytracingPass::ProbeBlendingRootSignatureParams::PROBE_HYSTERESIS].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+		slotRootParameter[RaytracingPass::ProbeBlendingRootSignatureParams::PROBE_HYSTERESIS].DescriptorTable.pDescriptorRanges = probeHysteresisRange;
+		slotRootParameter[RaytracingPass::ProbeBlendingRootSignatureParams::PROBE_HYSTERESIS].DescriptorTable.NumDescriptorRanges = _countof(probeHysteresisRange);
+
+		//Active probe list UAV
+		slotRootParameter[RaytracingPass::ProbeBlendingRootSignatureParams::ACTIVE_PROBE_LIST].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+		slotRootParameter[RaytracingPass::ProbeBlendingRootSignatureParams::ACTIVE_PROBE_LIST].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+		slotRootParameter[RaytracingPass::ProbeBlendingRootSignatureParams::ACTIVE_PROBE_LIST].DescriptorTable.pDescriptorRanges = activeProbeListRange;
+		slotRootParameter[RaytracingPass::ProbeBlendingRootSignatureParams::ACTIVE_PROBE_LIST].DescriptorTable.NumDescriptorRanges = _countof(activeProbeListRange);
+
+		//Probe positions UAV
+		slotRootParameter[RaytracingPass::ProbeBlendingRootSignatureParams::PROBE_POSITIONS].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+		slotRootParameter[RaytracingPass::ProbeBlendingRootSignatureParams::PROBE_POSITIONS].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+		slotRootParameter[RaytracingPass::ProbeBlendingRootSignatureParams::PROBE_POSITIONS].DescriptorTable.pDescriptorRanges = probePositionsRange;
+		slotRootParameter[RaytracingPass::ProbeBlendingRootSignatureParams::PROBE_POSITIONS].DescriptorTable.NumDescriptorRanges = _countof(probePositionsRange);
+
+		//Unfiltered irradiance UAV
+		slotRootParameter[RaytracingPass::ProbeBlendingRootSignatureParams::UNFILTERED_IRRADIANCE].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+		slotRootParameter[RaytracingPass::ProbeBlendingRootSignatureParams::UNFILTERED_IRRADIANCE].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+		slotRootParameter[RaytracingPass::ProbeBlendingRootSignatureParams::UNFILTERED_IRRADIANCE].DescriptorTable.pDescriptorRanges = unfilteredIrradianceRange;
+		slotRootParameter[RaytracingPass::ProbeBlendingRootSignatureParams::UNFILTERED_IRRADIANCE].DescriptorTable.NumDescriptorRanges = _countof(unfilteredIrradianceRange);
+
 		//Scene per frame CB
 		slotRootParameter[RaytracingPass::ProbeBlendingRootSignatureParams::PER_FRAME_SCENE_CB].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
 		slotRootParameter[RaytracingPass::ProbeBlendingRootSignatureParams::PER_FRAME_SCENE_CB].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
@@ -937,18 +1808,112 @@ bool GIVolume::CreatePSOs()
 		return false;
 	}
 
-	return true;
-}
+	//====================================================
+	//Probe relocation
+	//====================================================
 
-bool GIVolume::CompileShaders()
-{
-	Microsoft::WRL::ComPtr<IDxcBlob> pBlob;
+	computePsoDesc.CS = CD3DX12_SHADER_BYTECODE((void*)m_Shaders[m_ProbeRelocationName]->GetBufferPointer(), m_Shaders[m_ProbeRelocationName]->GetBufferSize());
 
-	std::wstring wsRaysPerProbe = std::wstring(L"BLEND_RAYS_PER_PROBE=") + std::to_wstring(m_iRaysPerProbe);
-	std::wstring wsIrradianceTexelsPerProbe = std::wstring(L"NUM_TEXELS_PER_PROBE=") + std::to_wstring(m_iIrradianceTexelsPerProbe);
-	std::wstring wsDistanceTexelsPerProbe = std::wstring(L"NUM_TEXELS_PER_PROBE=") + std::to_wstring(m_iDistanceTexelsPerProbe);
+	hr = pDevice->CreateComputePipelineState(&computePsoDesc, IID_PPV_ARGS(m_pProbeRelocationPSO.GetAddressOf()));
 
-	LPCWSTR irradianceProbeBlendingDefines[] =
+	if (FAILED(hr))
+	{
+		LOG_ERROR(tag, L"Failed to create the probe relocation pipeline state object!");
+
+		return false;
+	}
+
+	//====================================================
+	//Probe classification
+	//====================================================
+
+	computePsoDesc.CS = CD3DX12_SHADER_BYTECODE((void*)m_Shaders[m_ProbeClassificationName]->GetBufferPointer(), m_Shaders[m_ProbeClassificationName]->GetBufferSize());
+
+	hr = pDevice->CreateComputePipelineState(&computePsoDesc, IID_PPV_ARGS(m_pProbeClassificationPSO.GetAddressOf()));
+
+	if (FAILED(hr))
+	{
+		LOG_ERROR(tag, L"Failed to create the probe classification pipeline state object!");
+
+		return false;
+	}
+
+	//====================================================
+	//Probe positions
+	//====================================================
+
+	computePsoDesc.CS = CD3DX12_SHADER_BYTECODE((void*)m_Shaders[m_ProbePositionsName]->GetBufferPointer(), m_Shaders[m_ProbePositionsName]->GetBufferSize());
+
+	hr = pDevice->CreateComputePipelineState(&computePsoDesc, IID_PPV_ARGS(m_pProbePositionsPSO.GetAddressOf()));
+
+	if (FAILED(hr))
+	{
+		LOG_ERROR(tag, L"Failed to create the probe positions pipeline state object!");
+
+		return false;
+	}
+
+	//====================================================
+	//Probe filter
+	//====================================================
+
+	computePsoDesc.CS = CD3DX12_SHADER_BYTECODE((void*)m_Shaders[m_ProbeFilterName]->GetBufferPointer(), m_Shaders[m_ProbeFilterName]->GetBufferSize());
+
+	hr = pDevice->CreateComputePipelineState(&computePsoDesc, IID_PPV_ARGS(m_pProbeFilterPSO.GetAddressOf()));
+
+	if (FAILED(hr))
+	{
+		LOG_ERROR(tag, L"Failed to create the probe filter pipeline state object!");
+
+		return false;
+	}
+
+	//====================================================
+	//Probe statistics
+	//====================================================
+
+	computePsoDesc.CS = CD3DX12_SHADER_BYTECODE((void*)m_Shaders[m_ProbeStatsName]->GetBufferPointer(), m_Shaders[m_ProbeStatsName]->GetBufferSize());
+
+	hr = pDevice->CreateComputePipelineState(&computePsoDesc, IID_PPV_ARGS(m_pProbeStatsPSO.GetAddressOf()));
+
+	if (FAILED(hr))
+	{
+		LOG_ERROR(tag, L"Failed to create the probe statistics pipeline state object!");
+
+		return false;
+	}
+
+	//====================================================
+	//SH irradiance projection
+	//====================================================
+
+	if (m_iIrradianceEncoding != PROBE_IRRADIANCE_ENCODING_OCTAHEDRAL)
+	{
+		computePsoDesc.CS = CD3DX12_SHADER_BYTECODE((void*)m_Shaders[m_IrradianceSHProjectionName]->GetBufferPointer(), m_Shaders[m_IrradianceSHProjectionName]->GetBufferSize());
+
+		hr = pDevice->CreateComputePipelineState(&computePsoDesc, IID_PPV_ARGS(m_pIrradianceSHProjectionPSO.GetAddressOf()));
+
+		if (FAILED(hr))
+		{
+			LOG_ERROR(tag, L"Failed to create the SH irradiance projection pipeline state object!");
+
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool GIVolume::CompileShaders()
+{
+	Microsoft::WRL::ComPtr<IDxcBlob> pBlob;
+
+	std::wstring wsRaysPerProbe = std::wstring(L"BLEND_RAYS_PER_PROBE=") + std::to_wstring(m_iRaysPerProbe);
+	std::wstring wsIrradianceTexelsPerProbe = std::wstring(L"NUM_TEXELS_PER_PROBE=") + std::to_wstring(m_iIrradianceTexelsPerProbe);
+	std::wstring wsDistanceTexelsPerProbe = std::wstring(L"NUM_TEXELS_PER_PROBE=") + std::to_wstring(m_iDistanceTexelsPerProbe);
+	std::wstring wsNumSHCoefficients = std::wstring(L"NUM_SH_COEFFICIENTS=") + std::to_wstring(GetNumSHCoefficients());
+
+	LPCWSTR irradianceProbeBlendingDefines[] =
 	{
 		L"BLEND_RADIANCE=1",
 		wsRaysPerProbe.c_str(),
@@ -974,6 +1939,20 @@ bool GIVolume::CompileShaders()
 		wsDistanceTexelsPerProbe.c_str()
 	};
 
+	LPCWSTR shProjectionDefines[] =
+	{
+		wsRaysPerProbe.c_str(),
+		wsNumSHCoefficients.c_str()
+	};
+
+	//The filter works on whole probe tiles so it needs to know which encoding it is filtering
+	LPCWSTR probeFilterDefines[] =
+	{
+		m_iIrradianceEncoding == PROBE_IRRADIANCE_ENCODING_OCTAHEDRAL ? L"FILTER_SH=0" : L"FILTER_SH=1",
+		wsIrradianceTexelsPerProbe.c_str(),
+		wsNumSHCoefficients.c_str()
+	};
+
 	//closest hit group defines
 	LPCWSTR normalOcclusionEmissionAlbedoMetallicRoughness[] =
 	{
@@ -1039,6 +2018,12 @@ bool GIVolume::CompileShaders()
 		CompileRecord(L"Shaders/ProbeBlendingCompute.hlsl", m_DistanceProbeBlendingName, L"cs_6_3", L"", distanceProbeBlendingDefines, _countof(distanceProbeBlendingDefines)),
 		CompileRecord(L"Shaders/ProbeBorderBlendingCompute.hlsl", m_DistanceRowProbeBlendingName, L"cs_6_3", L"RowBlend", distanceBorderProbeBlendingDefines, _countof(distanceBorderProbeBlendingDefines)),
 		CompileRecord(L"Shaders/ProbeBorderBlendingCompute.hlsl", m_DistanceColumnProbeBlendingName, L"cs_6_3", L"ColumnBlend", distanceBorderProbeBlendingDefines, _countof(distanceBorderProbeBlendingDefines)),
+
+		CompileRecord(L"Shaders/ProbeRelocationCompute.hlsl", m_ProbeRelocationName, L"cs_6_3"),
+		CompileRecord(L"Shaders/ProbeClassificationCompute.hlsl", m_ProbeClassificationName, L"cs_6_3"),
+		CompileRecord(L"Shaders/ProbeStatsCompute.hlsl", m_ProbeStatsName, L"cs_6_3"),
+		CompileRecord(L"Shaders/ProbePositionsCompute.hlsl", m_ProbePositionsName, L"cs_6_3"),
+		CompileRecord(L"Shaders/ProbeFilterCompute.hlsl", m_ProbeFilterName, L"cs_6_3", L"", probeFilterDefines, _countof(probeFilterDefines)),
 	};
 
 	for (int i = 0; i < _countof(records); ++i)
@@ -1053,6 +2038,19 @@ bool GIVolume::CompileShaders()
 		m_Shaders[records[i].ShaderName] = pBlob.Get();
 	}
 
+	//Only needed when the irradiance atlas holds SH, NUM_SH_COEFFICIENTS is 0 otherwise
+	if (m_iIrradianceEncoding != PROBE_IRRADIANCE_ENCODING_OCTAHEDRAL)
+	{
+		pBlob = DXRHelper::CompileShader(L"Shaders/ProbeSHProjectionCompute.hlsl", L"cs_6_3", L"", shProjectionDefines, _countof(shProjectionDefines));
+
+		if (pBlob == nullptr)
+		{
+			return false;
+		}
+
+		m_Shaders[m_IrradianceSHProjectionName] = pBlob.Get();
+	}
+
 	return true;
 }
 
@@ -1070,7 +2068,7 @@ void GIVolume::UpdateConstantBuffers()
 	raytracePerFrame.Hysteresis = m_fHysteresis;
 	raytracePerFrame.IrradianceFormat = m_iIrradianceFormat;
 	raytracePerFrame.IrradianceGammaEncoding = m_fIrradianceGammaEncoding;
-	raytracePerFrame.IrradianceIndex = m_pIrradianceAtlas->GetSRVDesc()->GetDescriptorIndex();
+	raytracePerFrame.IrradianceIndex = m_iProbeFilter != PROBE_FILTER_NONE ? m_pFilteredIrradianceAtlas->GetSRVDesc()->GetDescriptorIndex() : m_pIrradianceAtlas->GetSRVDesc()->GetDescriptorIndex();
 	raytracePerFrame.IrradianceThreshold = m_fIrradianceThreshold;
 	raytracePerFrame.MaxRayDistance = m_fMaxRayDistance;
 	raytracePerFrame.MissRadiance = m_MissRadiance;
@@ -1079,7 +2077,7 @@ void GIVolume::UpdateConstantBuffers()
 	raytracePerFrame.NumIrradianceTexels = m_iIrradianceTexelsPerProbe;
 	raytracePerFrame.ProbeCounts = m_ProbeCounts;
 	raytracePerFrame.ProbeSpacing = m_ProbeSpacing;
-	raytracePerFrame.RayDataFormat = (int)m_AtlasSize;
+	raytracePerFrame.RayDataFormat = m_iRayDataFormat;
 	raytracePerFrame.RayDataIndex = m_pRayDataAtlas->GetSRVDesc()->GetDescriptorIndex();
 	raytracePerFrame.RayRotation = m_RayRotation;
 	raytracePerFrame.ViewBias = m_fViewBias;
@@ -1087,146 +2085,102 @@ void GIVolume::UpdateConstantBuffers()
 	raytracePerFrame.VolumePosition = m_Position;
 	raytracePerFrame.ProbeOffsets = m_ProbeOffsets;
 	raytracePerFrame.ClearPlane = m_ClearPlanes;
+	raytracePerFrame.ProbeDataIndex = m_pProbeDataAtlas->GetSRVDesc()->GetDescriptorIndex();
+	raytracePerFrame.ProbeRelocation = (int)m_bProbeRelocation;
+	raytracePerFrame.ProbeMinFrontfaceDistance = m_fProbeMinFrontfaceDistance;
+	raytracePerFrame.ProbeBackfaceThreshold = m_fProbeBackfaceThreshold;
+	raytracePerFrame.ProbeClassification = (int)m_bProbeClassification;
+	raytracePerFrame.ActiveProbeListIndex = m_pActiveProbeListSRV->GetDescriptorIndex();
+	raytracePerFrame.UseActiveProbeList = (int)m_bUseActiveProbeList;
+	raytracePerFrame.FullProbeUpdate = (int)m_bFullProbeUpdate;
+	raytracePerFrame.TracedProbeMask = (int)m_bUploadProbeList;
+	raytracePerFrame.AdaptiveRays = (int)m_bAdaptiveRays;
+	raytracePerFrame.ProbeRayCountsIndex = m_pProbeRayCountsSRV->GetDescriptorIndex();
+	raytracePerFrame.ProbeStatsIndex = m_pProbeStatsAtlas->GetUAVDesc()->GetDescriptorIndex();
+	raytracePerFrame.IrradianceEncoding = m_iIrradianceEncoding;
+	raytracePerFrame.NumSHCoefficients = GetNumSHCoefficients();
+	raytracePerFrame.PerProbeRayRotation = (int)m_bPerProbeRayRotation;
+	raytracePerFrame.AtlasLayout = m_iAtlasLayout;
+	raytracePerFrame.ProbePositionsIndex = m_pProbePositionsSRV->GetDescriptorIndex();
+	raytracePerFrame.ProbeScale = m_ProbeScale;
+	raytracePerFrame.AdaptiveHysteresis = (int)m_bAdaptiveHysteresis;
+	raytracePerFrame.MinHysteresis = (std::min)(m_fMinHysteresis, m_fHysteresis);
+	raytracePerFrame.HysteresisRiseRate = m_fHysteresisRiseRate;
+	raytracePerFrame.HysteresisChangeThreshold = m_fHysteresisChangeThreshold;
+	raytracePerFrame.ProbeFilter = m_iProbeFilter;
+	raytracePerFrame.ProbeFilterStrength = m_fProbeFilterStrength;
+	raytracePerFrame.RayDirectionTableIndex = m_bAdaptiveRays == true ? -1 : (int)m_pRayDirectionTableSRV->GetDescriptorIndex();
 	
 	m_pRaytracedPerFrameUpload->CopyData(0, raytracePerFrame);
 }
 
-static std::uniform_real_distribution<float> s_distribution(0.f, 1.f);
-
-void GIVolume::UpdateRandomRotation()
+void GIVolume::UpdateRayRotation()
 {
-	// This approach is based on James Arvo's implementation from Graphics Gems 3 (pg 117-120).
-// Also available at: http://citeseerx.ist.psu.edu/viewdoc/download?doi=10.1.1.53.1357&rep=rep1&type=pdf
-
-// Setup a random rotation matrix using 3 uniform RVs
-	float u1 = XM_PI * s_distribution(m_rng) * 2.0f;
-	float cos1 = cosf(u1);
-	float sin1 = sinf(u1);
-
-	float u2 = XM_PI * s_distribution(m_rng) * 2.0f;
-	float cos2 = cosf(u2);
-	float sin2 = sinf(u2);
-
-	float u3 = s_distribution(m_rng);
-	float sq3 = 2.f * sqrtf(u3 * (1.f - u3));
-
-	float s2 = 2.f * u3 * sin2 * sin2 - 1.f;
-	float c2 = 2.f * u3 * cos2 * cos2 - 1.f;
-	float sc = 2.f * u3 * sin2 * cos2;
-
-	// Create the random rotation matrix
-	float _11 = cos1 * c2 - sin1 * sc;
-	float _12 = sin1 * c2 + cos1 * sc;
-	float _13 = sq3 * cos2;
-
-	float _21 = cos1 * sc - sin1 * s2;
-	float _22 = sin1 * sc + cos1 * s2;
-	float _23 = sq3 * sin2;
-
-	float _31 = cos1 * (sq3 * cos2) - sin1 * (sq3 * sin2);
-	float _32 = sin1 * (sq3 * cos2) + cos1 * (sq3 * sin2);
-	float _33 = 1.f - 2.f * u3;
-
-	// HLSL is column-major
-	DirectX::XMFLOAT3X3 transform(_11, _12, _13, _21, _22, _23, _31, _32, _33);
-
-	XMStoreFloat4(&m_RayRotation, XMQuaternionNormalize(XMQuaternionRotationMatrix(XMLoadFloat3x3(&transform))));
+	m_RayRotation = m_RayRotationGenerator.Next();
 }
 
-void GIVolume::UpdateVolumeOffsets()
+void GIVolume::UpdateRayDirectionTable()
 {
-	m_ClearPlanes.x = false;
-	m_ClearPlanes.y = false;
-	m_ClearPlanes.z = false;
-
-	DirectX::XMFLOAT3 offsettedPos = DirectX::XMFLOAT3(m_Position.x + m_ProbeSpacing.x * m_ProbeOffsets.x, m_Position.y + m_ProbeSpacing.y * m_ProbeOffsets.y, m_Position.z + m_ProbeSpacing.z * m_ProbeOffsets.z);
-
-	DirectX::XMFLOAT3 toAnchor;
-	XMStoreFloat3(&toAnchor, XMVectorSubtract(XMLoadFloat3(&m_Anchor), XMLoadFloat3(&offsettedPos)));
-
-	DirectX::XMINT3 toAnchorSigns = { 1, 1, 1 };
-
-	if (toAnchor.x < 0)
-	{
-		toAnchorSigns.x = -1;
-	}
-	if (toAnchor.y < 0)
+	//Adaptive rays spread each probe's own ray count over the spiral so the table doesn't apply
+	if (m_bAdaptiveRays == true)
 	{
-		toAnchorSigns.y = -1;
-	}
-	if (toAnchor.z < 0)
-	{
-		toAnchorSigns.z = -1;
+		return;
 	}
 
-	DirectX::XMINT3 shouldScroll;
+	m_RayDirectionTable.Update(m_iRaysPerProbe, m_RayRotation);
 
-	float val = toAnchor.x / m_ProbeSpacing.x;
-	if (val >= 0.0f)
-	{
-		shouldScroll.x = floor(val);
-	}
-	else
-	{
-		shouldScroll.x = ceil(val);
-	}
+	m_pRayDirectionTableUpload->CopyData(0, m_RayDirectionTable.GetDirections());
+}
 
-	val = toAnchor.y / m_ProbeSpacing.y;
-	if (val >= 0.0f)
-	{
-		shouldScroll.y = floor(val);
-	}
-	else
-	{
-		shouldScroll.y = ceil(val);
-	}
+void GIVolume::UpdateVolumeOffsets()
+{
+	m_ClearPlanes = GICascades::Scroll(m_Position, m_ProbeOffsets, m_ProbeCounts, m_ProbeSpacing, m_Anchor);
+}
 
-	val = toAnchor.z / m_ProbeSpacing.z;
-	if (val >= 0.0f)
-	{
-		shouldScroll.z = floor(val);
-	}
-	else
+DXGI_FORMAT GIVolume::GetRayDataFormat()
+{
+	switch(m_iRayDataFormat)
 	{
-		shouldScroll.z = ceil(val);
-	}
+	case FORMAT_PROBE_RAY_DATA_R32G32_FLOAT:
+	case FORMAT_PROBE_RAY_DATA_RGB9E5:
+	case FORMAT_PROBE_RAY_DATA_R11G11B10:
+		return DXGI_FORMAT_R32G32_FLOAT;
 
-	if (shouldScroll.x != 0)
-	{
-		m_ProbeOffsets.x += shouldScroll.x;
-		m_ClearPlanes.x = true;
+	case FORMAT_PROBE_RAY_DATA_R32G32B32A32_FLOAT:
+		return DXGI_FORMAT_R32G32B32A32_FLOAT;
 
-		Offset(m_Position.x, m_ProbeOffsets.x, m_ProbeCounts.x, m_ProbeSpacing.x, toAnchorSigns.x);
+	default:
+		return DXGI_FORMAT_UNKNOWN;
 	}
+}
 
-	if (shouldScroll.y != 0)
+DXGI_FORMAT GIVolume::GetIrradianceFormat()
+{
+	//HDR without the size of the full float format, written straight by the blend so nothing needs packing
+	if (m_iIrradianceFormat == FORMAT_PROBE_IRRADIANCE_R11G11B10_FLOAT)
 	{
-		m_ProbeOffsets.y += shouldScroll.y;
-		m_ClearPlanes.y = true;
-
-		Offset(m_Position.y, m_ProbeOffsets.y, m_ProbeCounts.y, m_ProbeSpacing.y, toAnchorSigns.y);
+		return DXGI_FORMAT_R11G11B10_FLOAT;
 	}
 
-	if (shouldScroll.z != 0)
+	switch (m_AtlasSize)
 	{
-		m_ProbeOffsets.z += shouldScroll.z;
-		m_ClearPlanes.z = true;
+	case AtlasSize::SMALLER:
+		return DXGI_FORMAT_R10G10B10A2_UNORM;
 
-		Offset(m_Position.z, m_ProbeOffsets.z, m_ProbeCounts.z, m_ProbeSpacing.z, toAnchorSigns.z);
-	}
+	case AtlasSize::BIGGER:
+		return DXGI_FORMAT_R32G32B32A32_FLOAT;
 
-	if (m_ClearPlanes.x == true || m_ClearPlanes.y == true || m_ClearPlanes.z == true)
-	{
-		UpdateProbePositions();
+	default:
+		return DXGI_FORMAT_UNKNOWN;
 	}
 }
 
-DXGI_FORMAT GIVolume::GetRayDataFormat()
+DXGI_FORMAT GIVolume::GetSHFormat()
 {
-	switch(m_AtlasSize)
+	switch (m_AtlasSize)
 	{
 	case AtlasSize::SMALLER:
-		return DXGI_FORMAT_R32G32_FLOAT;
+		return DXGI_FORMAT_R16G16B16A16_FLOAT;
 
 	case AtlasSize::BIGGER:
 		return DXGI_FORMAT_R32G32B32A32_FLOAT;
@@ -1236,18 +2190,18 @@ DXGI_FORMAT GIVolume::GetRayDataFormat()
 	}
 }
 
-DXGI_FORMAT GIVolume::GetIrradianceFormat()
+int GIVolume::GetNumSHCoefficients() const
 {
-	switch (m_AtlasSize)
+	switch (m_iIrradianceEncoding)
 	{
-	case AtlasSize::SMALLER:
-		return DXGI_FORMAT_R10G10B10A2_UNORM;
+	case PROBE_IRRADIANCE_ENCODING_SH_L1:
+		return 4;
 
-	case AtlasSize::BIGGER:
-		return DXGI_FORMAT_R32G32B32A32_FLOAT;
+	case PROBE_IRRADIANCE_ENCODING_SH_L2:
+		return 9;
 
 	default:
-		return DXGI_FORMAT_UNKNOWN;
+		return 0;
 	}
 }
 
@@ -1313,7 +2267,7 @@ void GIVolume::PopulateRayData(DescriptorHeap* pSRVHeap, UploadBuffer<ScenePerFr
 	dispatchDesc.HitGroupTable.SizeInBytes = m_pHitGroupTable->GetDesc().Width;
 	dispatchDesc.HitGroupTable.StrideInBytes = m_uiHitGroupRecordSize;
 	dispatchDesc.Width = m_iRaysPerProbe;
-	dispatchDesc.Height = m_ProbeCounts.x * m_ProbeCounts.y * m_ProbeCounts.z;
+	dispatchDesc.Height = m_bUseActiveProbeList == true ? m_iNumActiveProbes : m_ProbeCounts.x * m_ProbeCounts.y * m_ProbeCounts.z;
 	dispatchDesc.Depth = 1;
 
 	pGraphicsCommandList->SetComputeRootSignature(m_pGlobalRootSignature.Get());
@@ -1334,12 +2288,271 @@ void GIVolume::PopulateRayData(DescriptorHeap* pSRVHeap, UploadBuffer<ScenePerFr
 	GPU_PROFILE_END(GpuStats::TRACE_RAYS, pGraphicsCommandList)
 }
 
-void GIVolume::Offset(float& pos, int& probeOffset, int probeCount, float probeSpacing, int direction)
+void GIVolume::UpdateActiveProbes()
 {
-	if (probeOffset != 0 && probeOffset % probeCount == 0)
+	int iNumProbes = m_ProbeCounts.x * m_ProbeCounts.y * m_ProbeCounts.z;
+
+	bool bScheduling = m_ProbeScheduler.IsScheduling();
+	bool bSleeping = IsSleepingProbes();
+	bool bScrolled = m_ClearPlanes.x == true || m_ClearPlanes.y == true || m_ClearPlanes.z == true;
+
+	m_bUploadProbeList = bScheduling == true || bSleeping == true;
+
+	//App flushes the command queue at the end of every frame so last frame's list has already been copied back
+	if (m_bProbeClassification == true && m_bActiveProbeCountValid == true)
+	{
+		ReadActiveProbeList(m_bUploadProbeList);
+	}
+
+	m_bFullProbeUpdate = true;
+
+	if (m_bProbeClassification == true)
 	{
-		pos += probeCount * direction * probeSpacing;
-		probeOffset = 0;
+		++m_iFramesSinceFullUpdate;
+
+		//Scrolled planes hold probes in new cells so everything gets retraced and reclassified
+		m_bFullProbeUpdate = m_bActiveProbeCountValid == false || m_iFramesSinceFullUpdate >= m_iFullUpdateInterval || bScrolled == true;
+
+		if (m_bFullProbeUpdate == true)
+		{
+			m_iFramesSinceFullUpdate = 0;
+		}
+
+		//Classification this frame writes the list that next frame reads back
+		m_bActiveProbeCountValid = true;
+	}
+	else
+	{
+		m_bActiveProbeCountValid = false;
+	}
+
+	if (m_bUploadProbeList == true)
+	{
+		//Probes in scrolled planes are in new cells and get cleared by the blend so they have to be in this frame's list
+		if (bScrolled == true)
+		{
+			for (int i = 0; i < iNumProbes; ++i)
+			{
+				DirectX::XMINT3 probeCoords = ProbeHelper::GetProbeCoords(i, m_ProbeCounts);
+
+				if (ProbeHelper::IsScrolledPlane(probeCoords, 0, m_ProbeOffsets, m_ProbeCounts, m_ClearPlanes) == true ||
+					ProbeHelper::IsScrolledPlane(probeCoords, 1, m_ProbeOffsets, m_ProbeCounts, m_ClearPlanes) == true ||
+					ProbeHelper::IsScrolledPlane(probeCoords, 2, m_ProbeOffsets, m_ProbeCounts, m_ClearPlanes) == true)
+				{
+					if (bScheduling == true)
+					{
+						m_ProbeScheduler.Invalidate(i);
+					}
+
+					m_SleepTracker.Wake(i);
+				}
+			}
+		}
+
+		//Probes classification turned off are left out like sleeping ones until the next full update
+		bool bSkipInactive = m_bProbeClassification == true && m_bFullProbeUpdate == false;
+
+		const std::vector<UINT>* kpProbes = &m_AllProbes;
+
+		if (bScheduling == true)
+		{
+			//Sleeping and inactive probes don't take up any of the budget
+			for (int i = 0; i < iNumProbes; ++i)
+			{
+				bool bAsleep = bSleeping == true && m_SleepTracker.IsAsleep(i) == true;
+				bool bInactive = bSkipInactive == true && m_ClassifiedProbes[i] == false;
+
+				m_ProbeScheduler.SetProbeAsleep(i, bAsleep == true || bInactive == true);
+			}
+
+			kpProbes = &m_ProbeScheduler.Schedule(m_Position, m_ProbeSpacing, m_ProbeCounts, m_ProbeOffsets, m_Anchor);
+		}
+
+		if (bSleeping == true)
+		{
+			m_SleepTracker.RemoveSleepingProbes(*kpProbes, m_UpdatedProbes);
+		}
+		else
+		{
+			m_UpdatedProbes = *kpProbes;
+		}
+
+		if (bSkipInactive == true)
+		{
+			m_UpdatedProbes.erase(std::remove_if(m_UpdatedProbes.begin(), m_UpdatedProbes.end(), [this](UINT uiProbeIndex) { return m_ClassifiedProbes[uiProbeIndex] == false; }), m_UpdatedProbes.end());
+		}
+
+		//Relocation and classification read the mask so probes that are active but weren't traced are left alone
+		m_TracedProbeMask.assign(ProbeHelper::GetTracedProbeMaskSize(iNumProbes), 0);
+
+		for (UINT uiProbeIndex : m_UpdatedProbes)
+		{
+			m_TracedProbeMask[uiProbeIndex / 32] |= 1u << (uiProbeIndex & 31);
+		}
+
+		m_pScheduledProbeListUpload->CopyData(0, (UINT)m_UpdatedProbes.size());
+		m_pScheduledProbeListUpload->CopyData(1, m_UpdatedProbes);
+		m_pScheduledProbeListUpload->CopyData(iNumProbes + 1, m_TracedProbeMask);
+
+		m_bUseActiveProbeList = true;
+		m_iNumActiveProbes = (int)m_UpdatedProbes.size();
+
+		return;
+	}
+
+	//Which probes classification picks isn't known on the CPU, so nothing is counted towards sleeping if it is turned on
+	m_UpdatedProbes.clear();
+
+	if (m_bProbeClassification == false || m_bFullProbeUpdate == true)
+	{
+		m_bUseActiveProbeList = false;
+		m_iNumActiveProbes = iNumProbes;
+
+		return;
+	}
+
+	m_bUseActiveProbeList = true;
+}
+
+void GIVolume::ReadActiveProbeList(bool bReadProbes)
+{
+	int iNumProbes = m_ProbeCounts.x * m_ProbeCounts.y * m_ProbeCounts.z;
+
+	//The whole list is only needed when it gets intersected with the one built on the CPU
+	SIZE_T readSize = bReadProbes == true ? (iNumProbes + 1) * sizeof(UINT) : sizeof(UINT);
+
+	UINT* pList = nullptr;
+	CD3DX12_RANGE readRange(0, readSize);
+
+	if (FAILED(m_pActiveProbeListReadback->Map(0, &readRange, reinterpret_cast<void**>(&pList))))
+	{
+		m_bActiveProbeCountValid = false;
+
+		return;
+	}
+
+	m_iNumActiveProbes = (std::min)((int)pList[0], iNumProbes);
+
+	if (bReadProbes == true)
+	{
+		m_ClassifiedProbes.assign(iNumProbes, false);
+
+		for (int i = 0; i < m_iNumActiveProbes; ++i)
+		{
+			UINT uiProbeIndex = pList[i + 1];
+
+			if (uiProbeIndex < (UINT)iNumProbes)
+			{
+				m_ClassifiedProbes[uiProbeIndex] = true;
+			}
+		}
+	}
+
+	CD3DX12_RANGE writeRange(0, 0);
+	m_pActiveProbeListReadback->Unmap(0, &writeRange);
+}
+
+void GIVolume::UpdateProbeRayCounts()
+{
+	if (m_bAdaptiveRays == false)
+	{
+		m_bProbeStatsValid = false;
+		m_dAdaptiveRayError = 1.0;
+
+		return;
+	}
+
+	int iNumProbes = m_ProbeCounts.x * m_ProbeCounts.y * m_ProbeCounts.z;
+
+	m_RayAllocator.SetMaxRays(m_iRaysPerProbe);
+
+	if (m_bProbeStatsValid == false)
+	{
+		m_RayAllocator.AllocateUniform(iNumProbes, m_ProbeRayCounts);
+	}
+	else
+	{
+		//App flushes the command queue at the end of every frame so last frame's statistics have already been copied back
+		BYTE* pMappedData = nullptr;
+
+		if (SUCCEEDED(m_pProbeStatsReadback->Map(0, nullptr, reinterpret_cast<void**>(&pMappedData))))
+		{
+			std::vector<float> means(iNumProbes);
+			std::vector<float> variances(iNumProbes);
+
+			for (int i = 0; i < iNumProbes; ++i)
+			{
+				DirectX::XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(i, m_ProbeCounts, m_iAtlasLayout);
+				const float* kpStats = reinterpret_cast<const float*>(pMappedData + m_ProbeStatsFootprint.Offset + (UINT64)dataCoords.y * m_ProbeStatsFootprint.Footprint.RowPitch) + dataCoords.x * 2;
+
+				means[i] = kpStats[0];
+				variances[i] = kpStats[1];
+			}
+
+			D3D12_RANGE writeRange = { 0, 0 };
+			m_pProbeStatsReadback->Unmap(0, &writeRange);
+
+			std::vector<UINT> fixedRayCounts;
+			std::vector<float> sigmas;
+
+			AdaptiveRayAllocator::GetSigmas(means, variances, m_ProbeRayCounts, sigmas);
+
+			m_RayAllocator.Allocate(means, variances, m_ProbeRayCounts);
+			m_RayAllocator.AllocateUniform(iNumProbes, fixedRayCounts);
+
+			double dFixedError = AdaptiveRayAllocator::GetExpectedError(sigmas, fixedRayCounts);
+			m_dAdaptiveRayError = dFixedError > 0.0 ? AdaptiveRayAllocator::GetExpectedError(sigmas, m_ProbeRayCounts) / dFixedError : 1.0;
+		}
+	}
+
+	m_pProbeRayCountsUpload->CopyData(0, m_ProbeRayCounts);
+}
+
+void GIVolume::UpdateProbeConvergence()
+{
+	if (m_bAdaptiveHysteresis == false || m_bProbeHysteresisValid == false)
+	{
+		return;
+	}
+
+	int iNumProbes = m_ProbeCounts.x * m_ProbeCounts.y * m_ProbeCounts.z;
+
+	//App flushes the command queue at the end of every frame so last frame's state has already been copied back
+	BYTE* pMappedData = nullptr;
+
+	if (FAILED(m_pProbeHysteresisReadback->Map(0, nullptr, reinterpret_cast<void**>(&pMappedData))))
+	{
+		return;
+	}
+
+	std::vector<DirectX::XMFLOAT2> states(iNumProbes);
+
+	for (int i = 0; i < iNumProbes; ++i)
+	{
+		DirectX::XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(i, m_ProbeCounts, m_iAtlasLayout);
+		const float* kpState = reinterpret_cast<const float*>(pMappedData + m_ProbeHysteresisFootprint.Offset + (UINT64)dataCoords.y * m_ProbeHysteresisFootprint.Footprint.RowPitch) + dataCoords.x * 2;
+
+		states[i] = DirectX::XMFLOAT2(kpState[0], kpState[1]);
+	}
+
+	D3D12_RANGE writeRange = { 0, 0 };
+	m_pProbeHysteresisReadback->Unmap(0, &writeRange);
+
+	m_ConvergenceTracker.Update(states, (std::min)(m_fMinHysteresis, m_fHysteresis), m_fHysteresisChangeThreshold);
+
+	std::vector<float> changes(iNumProbes);
+
+	//Probes that weren't blended last frame keep the change from the last time they were
+	for (int i = 0; i < iNumProbes; ++i)
+	{
+		changes[i] = ProbeHelper::GetProbeBlendedChange(states[i]);
+
+		m_ProbeScheduler.SetProbeChange(i, changes[i]);
+	}
+
+	if (IsSleepingProbes() == true)
+	{
+		m_SleepTracker.Update(changes, m_UpdatedProbes);
 	}
 }
 
@@ -1351,6 +2564,9 @@ void GIVolume::BlendProbeAtlases(DescriptorHeap* pSRVHeap, UploadBuffer<ScenePer
 	DirectX::XMINT2 probeCounts = DirectX::XMINT2(m_ProbeCounts.x * m_ProbeCounts.y, m_ProbeCounts.z);
 	int threadGroupSize = 8;
 
+	//One group per probe, the borders are still blended everywhere as they only copy texels
+	DirectX::XMINT2 mainGroups = m_bUseActiveProbeList == true ? DirectX::XMINT2(m_iNumActiveProbes, 1) : probeCounts;
+
 	CD3DX12_RESOURCE_BARRIER* pResourceBarriers = new CD3DX12_RESOURCE_BARRIER[2];
 	pResourceBarriers[0] = CD3DX12_RESOURCE_BARRIER::Transition(m_pIrradianceAtlas->GetResource().Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 	pResourceBarriers[1] = CD3DX12_RESOURCE_BARRIER::Transition(m_pDistanceAtlas->GetResource().Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
@@ -1359,82 +2575,103 @@ void GIVolume::BlendProbeAtlases(DescriptorHeap* pSRVHeap, UploadBuffer<ScenePer
 
 	GPU_PROFILE_BEGIN(GpuStats::ATLAS_BLEND_PROBES, pGraphicsCommandList)
 
-	//Irradiance main blend
+	//Irradiance main blend, SH probes are projected with the same dispatch
 	{
-		pGraphicsCommandList->SetPipelineState(m_pIrradianceBlendPSO.Get());
+		pGraphicsCommandList->SetPipelineState(m_iIrradianceEncoding == PROBE_IRRADIANCE_ENCODING_OCTAHEDRAL ? m_pIrradianceBlendPSO.Get() : m_pIrradianceSHProjectionPSO.Get());
 
-		pGraphicsCommandList->SetComputeRootSignature(m_pProbeBlendingRootSignature.Get());
+		SetProbeBlendingRootParameters(pSRVHeap, pScenePerFrameUpload, pGraphicsCommandList);
 
 		pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::RAY_DATA, pSRVHeap->GetGpuDescriptorHandle(m_pRayDataAtlas->GetUAVDesc()->GetDescriptorIndex()));
 		pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::TEXTURE_ATLAS, pSRVHeap->GetGpuDescriptorHandle(m_pIrradianceAtlas->GetUAVDesc()->GetDescriptorIndex()));
-		pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::STANDARD_DESCRIPTORS, pSRVHeap->GetGpuDescriptorHandle());
-		pGraphicsCommandList->SetComputeRootConstantBufferView(RaytracingPass::ProbeBlendingRootSignatureParams::PER_FRAME_SCENE_CB, pScenePerFrameUpload->GetBufferGPUAddress(App::GetApp()->GetFrameIndex()));
-		pGraphicsCommandList->SetComputeRootConstantBufferView(RaytracingPass::ProbeBlendingRootSignatureParams::PER_FRAME_RAYTRACE_CB, m_pRaytracedPerFrameUpload->GetBufferGPUAddress());
 
-		pGraphicsCommandList->Dispatch(probeCounts.x, probeCounts.y, 1);
+		pGraphicsCommandList->Dispatch(mainGroups.x, mainGroups.y, 1);
 	}
 
 	//Distance main blend
 	{
 		pGraphicsCommandList->SetPipelineState(m_pDistanceBlendPSO.Get());
 
-		pGraphicsCommandList->SetComputeRootSignature(m_pProbeBlendingRootSignature.Get());
+		SetProbeBlendingRootParameters(pSRVHeap, pScenePerFrameUpload, pGraphicsCommandList);
 
 		pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::RAY_DATA, pSRVHeap->GetGpuDescriptorHandle(m_pRayDataAtlas->GetUAVDesc()->GetDescriptorIndex()));
 		pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::TEXTURE_ATLAS, pSRVHeap->GetGpuDescriptorHandle(m_pDistanceAtlas->GetUAVDesc()->GetDescriptorIndex()));
-		pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::STANDARD_DESCRIPTORS, pSRVHeap->GetGpuDescriptorHandle());
-		pGraphicsCommandList->SetComputeRootConstantBufferView(RaytracingPass::ProbeBlendingRootSignatureParams::PER_FRAME_SCENE_CB, pScenePerFrameUpload->GetBufferGPUAddress(App::GetApp()->GetFrameIndex()));
-		pGraphicsCommandList->SetComputeRootConstantBufferView(RaytracingPass::ProbeBlendingRootSignatureParams::PER_FRAME_RAYTRACE_CB, m_pRaytracedPerFrameUpload->GetBufferGPUAddress());
 
-		pGraphicsCommandList->Dispatch(probeCounts.x, probeCounts.y, 1);
+		pGraphicsCommandList->Dispatch(mainGroups.x, mainGroups.y, 1);
 	}
 
 	GPU_PROFILE_END(GpuStats::ATLAS_BLEND_PROBES, pGraphicsCommandList)
 
 	GPU_PROFILE_BEGIN(GpuStats::BORDER_BLEND_PROBES, pGraphicsCommandList)
 
-	//Irradiance row and column
+	//Distance row and column
 	{
-		DirectX::XMINT2 numGroups = DirectX::XMINT2(ceil(probeCounts.x * (m_iIrradianceTexelsPerProbe + 2) / (float)threadGroupSize), ceil(probeCounts.y / (float)threadGroupSize));
+		DirectX::XMINT2 numGroups = DirectX::XMINT2(ceil(probeCounts.x * (m_iDistanceTexelsPerProbe + 2) / (float)threadGroupSize), ceil(probeCounts.y / (float)threadGroupSize));
 
-		pGraphicsCommandList->SetPipelineState(m_pIrradianceRowBlendPSO.Get());
+		pGraphicsCommandList->SetPipelineState(m_pDistanceRowBlendPSO.Get());
 
-		pGraphicsCommandList->SetComputeRootSignature(m_pProbeBlendingRootSignature.Get());
+		SetProbeBlendingRootParameters(pSRVHeap, pScenePerFrameUpload, pGraphicsCommandList);
 
 		pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::RAY_DATA, pSRVHeap->GetGpuDescriptorHandle(m_pRayDataAtlas->GetUAVDesc()->GetDescriptorIndex()));
-		pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::TEXTURE_ATLAS, pSRVHeap->GetGpuDescriptorHandle(m_pIrradianceAtlas->GetUAVDesc()->GetDescriptorIndex()));
-		pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::STANDARD_DESCRIPTORS, pSRVHeap->GetGpuDescriptorHandle());
-		pGraphicsCommandList->SetComputeRootConstantBufferView(RaytracingPass::ProbeBlendingRootSignatureParams::PER_FRAME_SCENE_CB, pScenePerFrameUpload->GetBufferGPUAddress(App::GetApp()->GetFrameIndex()));
-		pGraphicsCommandList->SetComputeRootConstantBufferView(RaytracingPass::ProbeBlendingRootSignatureParams::PER_FRAME_RAYTRACE_CB, m_pRaytracedPerFrameUpload->GetBufferGPUAddress());
+		pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::TEXTURE_ATLAS, pSRVHeap->GetGpuDescriptorHandle(m_pDistanceAtlas->GetUAVDesc()->GetDescriptorIndex()));
 
 		pGraphicsCommandList->Dispatch(numGroups.x, numGroups.y, 1);
 
-		numGroups = DirectX::XMINT2(ceil(probeCounts.x / (float)threadGroupSize), ceil(probeCounts.y * (m_iIrradianceTexelsPerProbe + 2) / (float)threadGroupSize));
+		numGroups = DirectX::XMINT2(ceil(probeCounts.x / (float)threadGroupSize), ceil(probeCounts.y * (m_iDistanceTexelsPerProbe + 2) / (float)threadGroupSize));
 
-		pGraphicsCommandList->SetPipelineState(m_pIrradianceColumnBlendPSO.Get());
+		pGraphicsCommandList->SetPipelineState(m_pDistanceColumnBlendPSO.Get());
 
 		pGraphicsCommandList->Dispatch(numGroups.x, numGroups.y, 1);
 	}
 
-	//Distance row and column
+	//Filter across neighbouring probes, needs the distance borders as the visibility test samples the distance atlas
+	if (m_iProbeFilter != PROBE_FILTER_NONE)
 	{
-		DirectX::XMINT2 numGroups = DirectX::XMINT2(ceil(probeCounts.x * (m_iDistanceTexelsPerProbe + 2) / (float)threadGroupSize), ceil(probeCounts.y / (float)threadGroupSize));
+		GPU_PROFILE_BEGIN(GpuStats::FILTER_PROBES, pGraphicsCommandList)
 
-		pGraphicsCommandList->SetPipelineState(m_pDistanceRowBlendPSO.Get());
+		CD3DX12_RESOURCE_BARRIER filterBarriers[3];
+		filterBarriers[0] = CD3DX12_RESOURCE_BARRIER::UAV(m_pIrradianceAtlas->GetResource().Get());
+		filterBarriers[1] = CD3DX12_RESOURCE_BARRIER::Transition(m_pDistanceAtlas->GetResource().Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		filterBarriers[2] = CD3DX12_RESOURCE_BARRIER::Transition(m_pFilteredIrradianceAtlas->GetResource().Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+		pGraphicsCommandList->ResourceBarrier(3, filterBarriers);
+
+		pGraphicsCommandList->SetPipelineState(m_pProbeFilterPSO.Get());
 
-		pGraphicsCommandList->SetComputeRootSignature(m_pProbeBlendingRootSignature.Get());
+		SetProbeBlendingRootParameters(pSRVHeap, pScenePerFrameUpload, pGraphicsCommandList);
 
+		//The unfiltered irradiance is bound in its own slot by SetProbeBlendingRootParameters, the filtered irradiance is written to the atlas slot
 		pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::RAY_DATA, pSRVHeap->GetGpuDescriptorHandle(m_pRayDataAtlas->GetUAVDesc()->GetDescriptorIndex()));
-		pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::TEXTURE_ATLAS, pSRVHeap->GetGpuDescriptorHandle(m_pDistanceAtlas->GetUAVDesc()->GetDescriptorIndex()));
-		pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::STANDARD_DESCRIPTORS, pSRVHeap->GetGpuDescriptorHandle());
-		pGraphicsCommandList->SetComputeRootConstantBufferView(RaytracingPass::ProbeBlendingRootSignatureParams::PER_FRAME_SCENE_CB, pScenePerFrameUpload->GetBufferGPUAddress(App::GetApp()->GetFrameIndex()));
-		pGraphicsCommandList->SetComputeRootConstantBufferView(RaytracingPass::ProbeBlendingRootSignatureParams::PER_FRAME_RAYTRACE_CB, m_pRaytracedPerFrameUpload->GetBufferGPUAddress());
+		pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::TEXTURE_ATLAS, pSRVHeap->GetGpuDescriptorHandle(m_pFilteredIrradianceAtlas->GetUAVDesc()->GetDescriptorIndex()));
+
+		//Every probe is filtered even when only some were blended as their neighbours may have changed
+		pGraphicsCommandList->Dispatch(probeCounts.x, probeCounts.y, 1);
+
+		filterBarriers[1] = CD3DX12_RESOURCE_BARRIER::Transition(m_pDistanceAtlas->GetResource().Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+		pGraphicsCommandList->ResourceBarrier(1, &filterBarriers[1]);
+
+		GPU_PROFILE_END(GpuStats::FILTER_PROBES, pGraphicsCommandList)
+	}
+
+	Texture* pIrradianceAtlas = m_iProbeFilter != PROBE_FILTER_NONE ? m_pFilteredIrradianceAtlas : m_pIrradianceAtlas;
+
+	//Irradiance row and column, SH coefficients have no borders. Done on whichever atlas is shaded from
+	if (m_iIrradianceEncoding == PROBE_IRRADIANCE_ENCODING_OCTAHEDRAL)
+	{
+		DirectX::XMINT2 numGroups = DirectX::XMINT2(ceil(probeCounts.x * (m_iIrradianceTexelsPerProbe + 2) / (float)threadGroupSize), ceil(probeCounts.y / (float)threadGroupSize));
+
+		pGraphicsCommandList->SetPipelineState(m_pIrradianceRowBlendPSO.Get());
+
+		SetProbeBlendingRootParameters(pSRVHeap, pScenePerFrameUpload, pGraphicsCommandList);
+
+		pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::RAY_DATA, pSRVHeap->GetGpuDescriptorHandle(m_pRayDataAtlas->GetUAVDesc()->GetDescriptorIndex()));
+		pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::TEXTURE_ATLAS, pSRVHeap->GetGpuDescriptorHandle(pIrradianceAtlas->GetUAVDesc()->GetDescriptorIndex()));
 
 		pGraphicsCommandList->Dispatch(numGroups.x, numGroups.y, 1);
 
-		numGroups = DirectX::XMINT2(ceil(probeCounts.x / (float)threadGroupSize), ceil(probeCounts.y * (m_iDistanceTexelsPerProbe + 2) / (float)threadGroupSize));
+		numGroups = DirectX::XMINT2(ceil(probeCounts.x / (float)threadGroupSize), ceil(probeCounts.y * (m_iIrradianceTexelsPerProbe + 2) / (float)threadGroupSize));
 
-		pGraphicsCommandList->SetPipelineState(m_pDistanceColumnBlendPSO.Get());
+		pGraphicsCommandList->SetPipelineState(m_pIrradianceColumnBlendPSO.Get());
 
 		pGraphicsCommandList->Dispatch(numGroups.x, numGroups.y, 1);
 	}
@@ -1446,6 +2683,339 @@ void GIVolume::BlendProbeAtlases(DescriptorHeap* pSRVHeap, UploadBuffer<ScenePer
 
 	pGraphicsCommandList->ResourceBarrier(2, pResourceBarriers);
 
+	if (m_iProbeFilter != PROBE_FILTER_NONE)
+	{
+		CD3DX12_RESOURCE_BARRIER resourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(m_pFilteredIrradianceAtlas->GetResource().Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+		pGraphicsCommandList->ResourceBarrier(1, &resourceBarrier);
+	}
+
 	PIX_ONLY(PIXEndEvent());
 	GPU_PROFILE_END(GpuStats::BLEND_PROBES, pGraphicsCommandList)
 }
+
+void GIVolume::SetProbeBlendingRootParameters(DescriptorHeap* pSRVHeap, UploadBuffer<ScenePerFrameCB>* pScenePerFrameUpload, ID3D12GraphicsCommandList4* pGraphicsCommandList)
+{
+	pGraphicsCommandList->SetComputeRootSignature(m_pProbeBlendingRootSignature.Get());
+
+	//Every UAV table has to be set on resource binding tier 2 hardware, whether or not the pass's shader uses it
+	pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::PROBE_HYSTERESIS, pSRVHeap->GetGpuDescriptorHandle(m_pProbeHysteresisAtlas->GetUAVDesc()->GetDescriptorIndex()));
+	pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::ACTIVE_PROBE_LIST, pSRVHeap->GetGpuDescriptorHandle(m_pActiveProbeListUAV->GetDescriptorIndex()));
+	pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::PROBE_POSITIONS, pSRVHeap->GetGpuDescriptorHandle(m_pProbePositionsUAV->GetDescriptorIndex()));
+	pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::UNFILTERED_IRRADIANCE, pSRVHeap->GetGpuDescriptorHandle(m_pIrradianceAtlas->GetUAVDesc()->GetDescriptorIndex()));
+	pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::STANDARD_DESCRIPTORS, pSRVHeap->GetGpuDescriptorHandle());
+	pGraphicsCommandList->SetComputeRootConstantBufferView(RaytracingPass::ProbeBlendingRootSignatureParams::PER_FRAME_SCENE_CB, pScenePerFrameUpload->GetBufferGPUAddress(App::GetApp()->GetFrameIndex()));
+	pGraphicsCommandList->SetComputeRootConstantBufferView(RaytracingPass::ProbeBlendingRootSignatureParams::PER_FRAME_RAYTRACE_CB, m_pRaytracedPerFrameUpload->GetBufferGPUAddress());
+}
+
+void GIVolume::RelocateProbes(DescriptorHeap* pSRVHeap, UploadBuffer<ScenePerFrameCB>* pScenePerFrameUpload, ID3D12GraphicsCommandList4* pGraphicsCommandList)
+{
+	GPU_PROFILE_BEGIN(GpuStats::RELOCATE_PROBES, pGraphicsCommandList)
+	PIX_ONLY(PIXBeginEvent(pGraphicsCommandList, PIX_COLOR(50, 50, 50), "Relocate Probes"));
+
+	int threadGroupSize = 8;
+
+	CD3DX12_RESOURCE_BARRIER resourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(m_pProbeDataAtlas->GetResource().Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	pGraphicsCommandList->ResourceBarrier(1, &resourceBarrier);
+
+	pGraphicsCommandList->SetPipelineState(m_pProbeRelocationPSO.Get());
+
+	SetProbeBlendingRootParameters(pSRVHeap, pScenePerFrameUpload, pGraphicsCommandList);
+
+	pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::RAY_DATA, pSRVHeap->GetGpuDescriptorHandle(m_pRayDataAtlas->GetUAVDesc()->GetDescriptorIndex()));
+	pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::TEXTURE_ATLAS, pSRVHeap->GetGpuDescriptorHandle(m_pProbeDataAtlas->GetUAVDesc()->GetDescriptorIndex()));
+
+	//One thread per probe over the probe data atlas
+	DirectX::XMINT2 numGroups = DirectX::XMINT2(ceil(m_ProbeCounts.x * m_ProbeCounts.y / (float)threadGroupSize), ceil(m_ProbeCounts.z / (float)threadGroupSize));
+
+	pGraphicsCommandList->Dispatch(numGroups.x, numGroups.y, 1);
+
+	resourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(m_pProbeDataAtlas->GetResource().Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	pGraphicsCommandList->ResourceBarrier(1, &resourceBarrier);
+
+	PIX_ONLY(PIXEndEvent());
+	GPU_PROFILE_END(GpuStats::RELOCATE_PROBES, pGraphicsCommandList)
+}
+
+void GIVolume::UpdateProbePositions(DescriptorHeap* pSRVHeap, UploadBuffer<ScenePerFrameCB>* pScenePerFrameUpload, ID3D12GraphicsCommandList4* pGraphicsCommandList)
+{
+	PIX_ONLY(PIXBeginEvent(pGraphicsCommandList, PIX_COLOR(50, 50, 50), "Update Probe Positions"));
+
+	int threadGroupSize = 64;
+
+	CD3DX12_RESOURCE_BARRIER resourceBarriers[2];
+	resourceBarriers[0] = CD3DX12_RESOURCE_BARRIER::Transition(m_pProbePositions.Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	resourceBarriers[1] = CD3DX12_RESOURCE_BARRIER::Transition(m_pProbeDataAtlas->GetResource().Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	pGraphicsCommandList->ResourceBarrier(2, resourceBarriers);
+
+	pGraphicsCommandList->SetPipelineState(m_pProbePositionsPSO.Get());
+
+	SetProbeBlendingRootParameters(pSRVHeap, pScenePerFrameUpload, pGraphicsCommandList);
+
+	pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::RAY_DATA, pSRVHeap->GetGpuDescriptorHandle(m_pRayDataAtlas->GetUAVDesc()->GetDescriptorIndex()));
+	pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::TEXTURE_ATLAS, pSRVHeap->GetGpuDescriptorHandle(m_pProbeDataAtlas->GetUAVDesc()->GetDescriptorIndex()));
+
+	//One thread per probe
+	pGraphicsCommandList->Dispatch((UINT)ceil(GetNumProbes() / (float)threadGroupSize), 1, 1);
+
+	resourceBarriers[0] = CD3DX12_RESOURCE_BARRIER::Transition(m_pProbePositions.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	resourceBarriers[1] = CD3DX12_RESOURCE_BARRIER::Transition(m_pProbeDataAtlas->GetResource().Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	pGraphicsCommandList->ResourceBarrier(2, resourceBarriers);
+
+	PIX_ONLY(PIXEndEvent());
+}
+
+void GIVolume::UploadScheduledProbes(ID3D12GraphicsCommandList4* pGraphicsCommandList)
+{
+	CD3DX12_RESOURCE_BARRIER resourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(m_pActiveProbeList.Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
+	pGraphicsCommandList->ResourceBarrier(1, &resourceBarrier);
+
+	pGraphicsCommandList->CopyBufferRegion(m_pActiveProbeList.Get(), 0, m_pScheduledProbeListUpload->Get(), 0, (m_iNumActiveProbes + 1) * sizeof(UINT));
+
+	//Classification only writes the count and list so the mask is still there for it to read
+	UINT64 maskOffset = (GetNumProbes() + 1) * sizeof(UINT);
+	pGraphicsCommandList->CopyBufferRegion(m_pActiveProbeList.Get(), maskOffset, m_pScheduledProbeListUpload->Get(), maskOffset, m_TracedProbeMask.size() * sizeof(UINT));
+
+	resourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(m_pActiveProbeList.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	pGraphicsCommandList->ResourceBarrier(1, &resourceBarrier);
+}
+
+void GIVolume::UpdateProbeStats(DescriptorHeap* pSRVHeap, UploadBuffer<ScenePerFrameCB>* pScenePerFrameUpload, ID3D12GraphicsCommandList4* pGraphicsCommandList)
+{
+	GPU_PROFILE_BEGIN(GpuStats::PROBE_STATS, pGraphicsCommandList)
+	PIX_ONLY(PIXBeginEvent(pGraphicsCommandList, PIX_COLOR(50, 50, 50), "Update Probe Statistics"));
+
+	int threadGroupSize = 64;
+
+	pGraphicsCommandList->SetPipelineState(m_pProbeStatsPSO.Get());
+
+	SetProbeBlendingRootParameters(pSRVHeap, pScenePerFrameUpload, pGraphicsCommandList);
+
+	pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::RAY_DATA, pSRVHeap->GetGpuDescriptorHandle(m_pRayDataAtlas->GetUAVDesc()->GetDescriptorIndex()));
+	pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::TEXTURE_ATLAS, pSRVHeap->GetGpuDescriptorHandle(m_pProbeStatsAtlas->GetUAVDesc()->GetDescriptorIndex()));
+
+	//One thread per probe traced this frame
+	pGraphicsCommandList->Dispatch((UINT)ceil(m_iNumActiveProbes / (float)threadGroupSize), 1, 1);
+
+	CD3DX12_RESOURCE_BARRIER resourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(m_pProbeStatsAtlas->GetResource().Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+	pGraphicsCommandList->ResourceBarrier(1, &resourceBarrier);
+
+	CD3DX12_TEXTURE_COPY_LOCATION destination = CD3DX12_TEXTURE_COPY_LOCATION(m_pProbeStatsReadback.Get(), m_ProbeStatsFootprint);
+	CD3DX12_TEXTURE_COPY_LOCATION source = CD3DX12_TEXTURE_COPY_LOCATION(m_pProbeStatsAtlas->GetResource().Get(), 0);
+
+	pGraphicsCommandList->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
+
+	resourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(m_pProbeStatsAtlas->GetResource().Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	pGraphicsCommandList->ResourceBarrier(1, &resourceBarrier);
+
+	m_bProbeStatsValid = true;
+
+	PIX_ONLY(PIXEndEvent());
+	GPU_PROFILE_END(GpuStats::PROBE_STATS, pGraphicsCommandList)
+}
+
+void GIVolume::CopyProbeHysteresis(ID3D12GraphicsCommandList4* pGraphicsCommandList)
+{
+	CD3DX12_RESOURCE_BARRIER resourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(m_pProbeHysteresisAtlas->GetResource().Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+	pGraphicsCommandList->ResourceBarrier(1, &resourceBarrier);
+
+	CD3DX12_TEXTURE_COPY_LOCATION destination = CD3DX12_TEXTURE_COPY_LOCATION(m_pProbeHysteresisReadback.Get(), m_ProbeHysteresisFootprint);
+	CD3DX12_TEXTURE_COPY_LOCATION source = CD3DX12_TEXTURE_COPY_LOCATION(m_pProbeHysteresisAtlas->GetResource().Get(), 0);
+
+	pGraphicsCommandList->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
+
+	resourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(m_pProbeHysteresisAtlas->GetResource().Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	pGraphicsCommandList->ResourceBarrier(1, &resourceBarrier);
+
+	m_bProbeHysteresisValid = true;
+}
+
+void GIVolume::ClassifyProbes(DescriptorHeap* pSRVHeap, UploadBuffer<ScenePerFrameCB>* pScenePerFrameUpload, ID3D12GraphicsCommandList4* pGraphicsCommandList)
+{
+	GPU_PROFILE_BEGIN(GpuStats::CLASSIFY_PROBES, pGraphicsCommandList)
+	PIX_ONLY(PIXBeginEvent(pGraphicsCommandList, PIX_COLOR(50, 50, 50), "Classify Probes"));
+
+	int threadGroupSize = 8;
+
+	//The list is rebuilt from scratch so reset the count
+	CD3DX12_RESOURCE_BARRIER resourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(m_pActiveProbeList.Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
+	pGraphicsCommandList->ResourceBarrier(1, &resourceBarrier);
+
+	pGraphicsCommandList->CopyBufferRegion(m_pActiveProbeList.Get(), 0, m_pActiveProbeCountReset->Get(), 0, sizeof(UINT));
+
+	CD3DX12_RESOURCE_BARRIER resourceBarriers[2];
+	resourceBarriers[0] = CD3DX12_RESOURCE_BARRIER::Transition(m_pActiveProbeList.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	resourceBarriers[1] = CD3DX12_RESOURCE_BARRIER::Transition(m_pProbeDataAtlas->GetResource().Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+	pGraphicsCommandList->ResourceBarrier(2, resourceBarriers);
+
+	pGraphicsCommandList->SetPipelineState(m_pProbeClassificationPSO.Get());
+
+	SetProbeBlendingRootParameters(pSRVHeap, pScenePerFrameUpload, pGraphicsCommandList);
+
+	pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::RAY_DATA, pSRVHeap->GetGpuDescriptorHandle(m_pRayDataAtlas->GetUAVDesc()->GetDescriptorIndex()));
+	pGraphicsCommandList->SetComputeRootDescriptorTable(RaytracingPass::ProbeBlendingRootSignatureParams::TEXTURE_ATLAS, pSRVHeap->GetGpuDescriptorHandle(m_pProbeDataAtlas->GetUAVDesc()->GetDescriptorIndex()));
+
+	//One thread per probe over the probe data atlas
+	DirectX::XMINT2 numGroups = DirectX::XMINT2(ceil(m_ProbeCounts.x * m_ProbeCounts.y / (float)threadGroupSize), ceil(m_ProbeCounts.z / (float)threadGroupSize));
+
+	pGraphicsCommandList->Dispatch(numGroups.x, numGroups.y, 1);
+
+	resourceBarriers[0] = CD3DX12_RESOURCE_BARRIER::Transition(m_pActiveProbeList.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+	resourceBarriers[1] = CD3DX12_RESOURCE_BARRIER::Transition(m_pProbeDataAtlas->GetResource().Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+	pGraphicsCommandList->ResourceBarrier(2, resourceBarriers);
+
+	//Next frame's trace and blend dispatch sizes come from the count, the probes themselves are only read when a list is built on the CPU
+	pGraphicsCommandList->CopyBufferRegion(m_pActiveProbeListReadback.Get(), 0, m_pActiveProbeList.Get(), 0, (m_ProbeCounts.x * m_ProbeCounts.y * m_ProbeCounts.z + 1) * sizeof(UINT));
+
+	resourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(m_pActiveProbeList.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	pGraphicsCommandList->ResourceBarrier(1, &resourceBarrier);
+
+	PIX_ONLY(PIXEndEvent());
+	GPU_PROFILE_END(GpuStats::CLASSIFY_PROBES, pGraphicsCommandList)
+}
+
+Texture* GIVolume::GetSnapshotAtlas(int iAtlas)
+{
+	switch ((SnapshotAtlas)iAtlas)
+	{
+	case SnapshotAtlas::IRRADIANCE:
+		return m_pIrradianceAtlas;
+
+	case SnapshotAtlas::DISTANCE:
+		return m_pDistanceAtlas;
+
+	case SnapshotAtlas::PROBE_DATA:
+		return m_pProbeDataAtlas;
+
+	default:
+		return nullptr;
+	}
+}
+
+void GIVolume::CopySnapshotAtlases(ID3D12GraphicsCommandList4* pGraphicsCommandList)
+{
+	int iNumAtlases = (int)SnapshotAtlas::COUNT;
+
+	m_SnapshotReadbacks.resize(iNumAtlases);
+	m_SnapshotFootprints.resize(iNumAtlases);
+	m_SnapshotNumRows.resize(iNumAtlases);
+	m_SnapshotRowSizes.resize(iNumAtlases);
+
+	for (int i = 0; i < iNumAtlases; ++i)
+	{
+		D3D12_RESOURCE_DESC desc = GetSnapshotAtlas(i)->GetResource()->GetDesc();
+
+		UINT64 uiReadbackSize = 0;
+		App::GetApp()->GetDevice()->GetCopyableFootprints(&desc, 0, 1, 0, &m_SnapshotFootprints[i], &m_SnapshotNumRows[i], &m_SnapshotRowSizes[i], &uiReadbackSize);
+
+		HRESULT hr = App::GetApp()->GetDevice()->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+																		D3D12_HEAP_FLAG_NONE,
+																		&CD3DX12_RESOURCE_DESC::Buffer(uiReadbackSize),
+																		D3D12_RESOURCE_STATE_COPY_DEST,
+																		nullptr,
+																		IID_PPV_ARGS(m_SnapshotReadbacks[i].ReleaseAndGetAddressOf()));
+
+		if (FAILED(hr))
+		{
+			LOG_ERROR(tag, L"Failed to create the readback buffer for the GI atlas snapshot!");
+
+			m_SnapshotReadbacks.clear();
+			m_SnapshotState = SnapshotState::NONE;
+
+			return;
+		}
+	}
+
+	PIX_ONLY(PIXBeginEvent(pGraphicsCommandList, PIX_COLOR(50, 50, 50), "Copy GI Atlas Snapshot"));
+
+	std::vector<CD3DX12_RESOURCE_BARRIER> barriers(iNumAtlases);
+
+	for (int i = 0; i < iNumAtlases; ++i)
+	{
+		barriers[i] = CD3DX12_RESOURCE_BARRIER::Transition(GetSnapshotAtlas(i)->GetResource().Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE);
+	}
+
+	pGraphicsCommandList->ResourceBarrier(iNumAtlases, barriers.data());
+
+	for (int i = 0; i < iNumAtlases; ++i)
+	{
+		CD3DX12_TEXTURE_COPY_LOCATION destination = CD3DX12_TEXTURE_COPY_LOCATION(m_SnapshotReadbacks[i].Get(), m_SnapshotFootprints[i]);
+		CD3DX12_TEXTURE_COPY_LOCATION source = CD3DX12_TEXTURE_COPY_LOCATION(GetSnapshotAtlas(i)->GetResource().Get(), 0);
+
+		pGraphicsCommandList->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
+	}
+
+	for (int i = 0; i < iNumAtlases; ++i)
+	{
+		barriers[i] = CD3DX12_RESOURCE_BARRIER::Transition(GetSnapshotAtlas(i)->GetResource().Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	}
+
+	pGraphicsCommandList->ResourceBarrier(iNumAtlases, barriers.data());
+
+	PIX_ONLY(PIXEndEvent());
+
+	m_SnapshotState = SnapshotState::COPYING;
+}
+
+bool GIVolume::WriteSnapshot()
+{
+	int iNumAtlases = (int)SnapshotAtlas::COUNT;
+
+	std::vector<AtlasSnapshotEntry> entries(iNumAtlases);
+	std::vector<std::vector<BYTE>> atlasData(iNumAtlases);
+	std::vector<const BYTE*> atlasDataPtrs(iNumAtlases);
+
+	bool bSucceeded = true;
+
+	for (int i = 0; i < iNumAtlases; ++i)
+	{
+		BYTE* pMappedData = nullptr;
+		HRESULT hr = m_SnapshotReadbacks[i]->Map(0, nullptr, reinterpret_cast<void**>(&pMappedData));
+
+		if (FAILED(hr))
+		{
+			LOG_ERROR(tag, L"Failed to map the readback buffer for the GI atlas snapshot!");
+
+			bSucceeded = false;
+
+			break;
+		}
+
+		entries[i] = {};
+		entries[i].Type = (SnapshotAtlas)i;
+		entries[i].Format = m_SnapshotFootprints[i].Footprint.Format;
+		entries[i].Width = m_SnapshotFootprints[i].Footprint.Width;
+		entries[i].Height = m_SnapshotNumRows[i];
+		entries[i].RowSize = (UINT32)m_SnapshotRowSizes[i];
+
+		//Drop the row pitch padding so the file doesn't depend on the driver's alignment
+		atlasData[i].resize((size_t)entries[i].RowSize * entries[i].Height);
+
+		for (UINT32 uiRow = 0; uiRow < entries[i].Height; ++uiRow)
+		{
+			memcpy(atlasData[i].data() + (size_t)uiRow * entries[i].RowSize, pMappedData + m_SnapshotFootprints[i].Offset + (UINT64)uiRow * m_SnapshotFootprints[i].Footprint.RowPitch, entries[i].RowSize);
+		}
+
+		D3D12_RANGE writeRange = { 0, 0 };
+		m_SnapshotReadbacks[i]->Unmap(0, &writeRange);
+
+		atlasDataPtrs[i] = atlasData[i].data();
+	}
+
+	if (bSucceeded == true)
+	{
+		bSucceeded = AtlasSnapshot::Write(m_sSnapshotFilepath, GetSnapshotDesc(), entries, atlasDataPtrs);
+	}
+
+	if (bSucceeded == true)
+	{
+		LOG_VERBOSE(tag, L"Saved GI atlas snapshot to %s", std::wstring(m_sSnapshotFilepath.begin(), m_sSnapshotFilepath.end()).c_str());
+	}
+
+	m_SnapshotReadbacks.clear();
+	m_SnapshotState = SnapshotState::NONE;
+
+	return bSucceeded;
+}
@@ -5,18 +5,26 @@
 #include "Commons/UploadBuffer.h"
 #include "Shaders/ConstantBuffers.h"
 #include "Commons/AccelerationBuffers.h"
+#include "GI/AdaptiveRayAllocator.h"
+#include "GI/ProbeConvergenceTracker.h"
+#include "GI/ProbeScheduler.h"
+#include "GI/ProbeSleepTracker.h"
+#include "GI/RayDirectionTable.h"
+#include "GI/RayRotationGenerator.h"
 
 #include <DirectXMath.h>
 #include <vector>
 #include <unordered_map>
-#include <random>
+#include <string>
 
 struct IDxcBlob;
+struct AtlasSnapshotDesc;
 
 class Timer;
-class GameObject;
 class Texture;
 class DescriptorHeap;
+class SRVDescriptor;
+class UAVDescriptor;
 
 struct GIVolumeDesc
 {
@@ -31,10 +39,27 @@ struct GIVolumeDesc
 	int IrradianceTexelsPerProbe;
 	int DistanceTexelsPerProbe;
 	int GIAtlasSize;
-	int IrradianceFormat;
+	int RayDataFormat;	//FORMAT_PROBE_RAY_DATA_ value
+	int IrradianceFormat;	//FORMAT_PROBE_IRRADIANCE_ value
+	int IrradianceEncoding;	//PROBE_IRRADIANCE_ENCODING_ value, SH replaces the octahedral irradiance tiles
+	int AtlasLayout;	//PROBE_ATLAS_LAYOUT_ value
 	int RaysPerProbe;
+	int ProbeSchedulingMode;
+	int ProbeUpdateBudget;
+	int ProbeMaxAge;
+	int RayBudget;
+	int MinRaysPerProbe;
+	int RayRotationSequence;
+	int CascadeIndex;
+	int ProbeFilter;	//PROBE_FILTER_ value
+	int ProbeSleepFrames;
 
 	bool ProbeRelocation;
+	bool ProbeClassification;
+	bool AdaptiveRays;
+	bool AdaptiveHysteresis;
+	bool ProbeSleeping;
+	bool PerProbeRayRotation;
 	bool ProbeTracking;
 	bool ShowProbes;
 
@@ -45,8 +70,16 @@ struct GIVolumeDesc
 	float BrightnessThreshold;
 	float DistancePower;
 	float Hysteresis;
+	float MinHysteresis;
+	float HysteresisRiseRate;
+	float HysteresisChangeThreshold;
 	float IrradianceGammaEncoding;
 	float IrradianceThreshold;
+	float ProbeMinFrontfaceDistance;
+	float ProbeBackfaceThreshold;
+	float ProbeFilterStrength;
+	float ProbeSleepThreshold;
+	float ProbeWakeRadius;
 };
 
 namespace RaytracingPass
@@ -79,6 +112,10 @@ namespace RaytracingPass
 		{
 			RAY_DATA = 0,
 			TEXTURE_ATLAS,
+			PROBE_HYSTERESIS,
+			ACTIVE_PROBE_LIST,
+			PROBE_POSITIONS,
+			UNFILTERED_IRRADIANCE,
 			STANDARD_DESCRIPTORS,
 			PER_FRAME_SCENE_CB,
 			PER_FRAME_RAYTRACE_CB,
@@ -103,7 +140,14 @@ enum class ClosestHitShaderVariants
 class GIVolume
 {
 public:
-	GIVolume(const GIVolumeDesc& kVolumeDesc, ID3D12GraphicsCommandList4* pCommandList, DescriptorHeap* pSRVHeap, DescriptorHeap* pRTVHeap);
+	GIVolume();
+
+	bool Init(const GIVolumeDesc& kVolumeDesc, ID3D12GraphicsCommandList4* pCommandList, DescriptorHeap* pSRVHeap, DescriptorHeap* pRTVHeap);
+
+	//Descriptors every volume allocates from the SRV and RTV heaps, App sizes the heaps from these so they have to be
+	//kept in step with CreateTextureAtlases
+	static UINT GetNumSRVDescriptors();
+	static UINT GetNumRTVDescriptors();
 
 	void ShowUI();
 
@@ -111,6 +155,10 @@ public:
 
 	void Draw(DescriptorHeap* pSRVHeap, UploadBuffer<ScenePerFrameCB>* pScenePerFrameUpload, ID3D12GraphicsCommandList4* pGraphicsCommandList, AccelerationBuffers& topLevelBuffer);
 
+	//Writes every probe's world position into the probe positions buffer for the probe visualization to draw from,
+	//only needed while the probes are shown
+	void UpdateProbePositions(DescriptorHeap* pSRVHeap, UploadBuffer<ScenePerFrameCB>* pScenePerFrameUpload, ID3D12GraphicsCommandList4* pGraphicsCommandList);
+
 	//Getters
 	const DirectX::XMFLOAT3& GetPosition() const;
 	const DirectX::XMFLOAT3& GetProbeTrackingTarget() const;
@@ -118,10 +166,28 @@ public:
 	const float& GetProbeScale () const;
 
 	const DirectX::XMINT3& GetProbeCounts() const;
+	const DirectX::XMINT3& GetProbeOffsets() const;
+	int GetNumProbes() const;
+
+	//0 for the innermost cascade, which is the one that gets saved
+	int GetCascadeIndex() const;
+
+	GIVolumeDesc GetVolumeDesc() const;
+
+	//Number of probes traced and blended this frame, all of them on frames where every probe is updated
+	int GetNumActiveProbes() const;
+
+	//Last frame's per probe hysteresis and convergence, only kept up to date when adaptive hysteresis is on
+	const ProbeConvergenceStats& GetConvergenceStats() const;
+	float GetProbeConvergence(int iProbeIndex) const;
+	float GetProbeHysteresis(int iProbeIndex) const;
+
+	int GetNumSleepingProbes() const;
 
 	UploadBuffer<RaytracePerFrameCB>* GetRaytracePerFrameUpload();
 
 	const bool& IsRelocating() const;
+	const bool& IsClassifying() const;
 	const bool& IsTracking() const;
 	const bool& IsShowingProbes() const;
 
@@ -134,12 +200,20 @@ public:
 	void SetProbeCounts(DirectX::XMINT3& kProbeCounts);
 
 	void SetIsRelocating(bool bIsRelocating);
+	void SetIsClassifying(bool bIsClassifying);
 	void SetIsTracking(bool bIsTracking);
 	void SetIsShowingProbes(bool bIsShowingProbes);
 
 	void SetAnchorPosition(DirectX::XMFLOAT3 position);
 
-	void Save(nlohmann::json& data);
+	//Sleeping probes have to be woken when something they can see changes, a light or the scene near them
+	void WakeAllProbes();
+	void WakeProbesNear(const DirectX::XMFLOAT3& kBoundsMin, const DirectX::XMFLOAT3& kBoundsMax);
+
+	void Save(nlohmann::json& data, const std::string& ksFilename);
+
+	//Uploads the atlases saved by Save so the volume doesn't have to converge from black
+	bool LoadSnapshot(const std::string& ksFilepath);
 
 protected:
 
@@ -151,17 +225,16 @@ private:
 		COUNT
 	};
 
-	void CreateProbeGameObjects(ID3D12GraphicsCommandList4* pCommandList);
-
-	void UpdateProbePositions();
-	void UpdateProbeScales();
-
-	void ToggleProbeVisibility();
-
 	bool CreateTextureAtlases(DescriptorHeap* pSRVHeap, DescriptorHeap* pRTVHeap);
 	bool CreateRayDataAtlas(DescriptorHeap* pSRVHeap);
 	bool CreateProbeDataAtlas(DescriptorHeap* pSRVHeap);
+	bool CreateActiveProbeList(DescriptorHeap* pSRVHeap);
+	bool CreateProbeStatsAtlas(DescriptorHeap* pSRVHeap);
+	bool CreateProbeHysteresisAtlas(DescriptorHeap* pSRVHeap);
+	bool CreateRayDirectionTable(DescriptorHeap* pSRVHeap);
+	bool CreateProbePositions(DescriptorHeap* pSRVHeap);
 	bool CreateIrradianceAtlas(DescriptorHeap* pSRVHeap, DescriptorHeap* pRTVHeap);
+	bool CreateFilteredIrradianceAtlas(DescriptorHeap* pSRVHeap);
 	bool CreateDistanceAtlas(DescriptorHeap* pSRVHeap, DescriptorHeap* pRTVHeap);
 
 	bool CreateStateObject();
@@ -180,13 +253,25 @@ private:
 
 	void UpdateConstantBuffers();
 
-	void UpdateRandomRotation();
+	void UpdateRayRotation();
 	void UpdateVolumeOffsets();
+	void UpdateActiveProbes();
+	void ReadActiveProbeList(bool bReadProbes);
+	void UpdateProbeRayCounts();
+	void UpdateProbeConvergence();
+	void UpdateRayDirectionTable();
+
+	//Sleeping needs the smoothed change the irradiance blend only writes with adaptive hysteresis on
+	bool IsSleepingProbes() const;
 
 	DXGI_FORMAT GetRayDataFormat();
 	DXGI_FORMAT GetIrradianceFormat();
 	DXGI_FORMAT GetDistanceFormat();
 	DXGI_FORMAT GetProbeDataFormat();
+	DXGI_FORMAT GetSHFormat();
+
+	//0 when irradiance is stored octahedrally
+	int GetNumSHCoefficients() const;
 
 	void AssociateShader(LPCWSTR shaderName, LPCWSTR shaderExport, CD3DX12_STATE_OBJECT_DESC& pipelineDesc);
 
@@ -195,7 +280,19 @@ private:
 	void PopulateRayData(DescriptorHeap* pSRVHeap, UploadBuffer<ScenePerFrameCB>* pScenePerFrameUpload, ID3D12GraphicsCommandList4* pGraphicsCommandList, AccelerationBuffers& topLevelBuffer);
 	void BlendProbeAtlases(DescriptorHeap* pSRVHeap, UploadBuffer<ScenePerFrameCB>* pScenePerFrameUpload, ID3D12GraphicsCommandList4* pGraphicsCommandList);
 
-	void Offset(float& pos, int& probeOffset, int probeCount, float probeSpacing, int direction);
+	//Sets the root signature and every slot but the ray data and texture atlas, which each pass binds itself
+	void SetProbeBlendingRootParameters(DescriptorHeap* pSRVHeap, UploadBuffer<ScenePerFrameCB>* pScenePerFrameUpload, ID3D12GraphicsCommandList4* pGraphicsCommandList);
+
+	void RelocateProbes(DescriptorHeap* pSRVHeap, UploadBuffer<ScenePerFrameCB>* pScenePerFrameUpload, ID3D12GraphicsCommandList4* pGraphicsCommandList);
+	void ClassifyProbes(DescriptorHeap* pSRVHeap, UploadBuffer<ScenePerFrameCB>* pScenePerFrameUpload, ID3D12GraphicsCommandList4* pGraphicsCommandList);
+	void UploadScheduledProbes(ID3D12GraphicsCommandList4* pGraphicsCommandList);
+	void UpdateProbeStats(DescriptorHeap* pSRVHeap, UploadBuffer<ScenePerFrameCB>* pScenePerFrameUpload, ID3D12GraphicsCommandList4* pGraphicsCommandList);
+	void CopyProbeHysteresis(ID3D12GraphicsCommandList4* pGraphicsCommandList);
+
+	AtlasSnapshotDesc GetSnapshotDesc() const;
+	Texture* GetSnapshotAtlas(int iAtlas);
+	void CopySnapshotAtlases(ID3D12GraphicsCommandList4* pGraphicsCommandList);
+	bool WriteSnapshot();
 
 	UINT m_uiMissRecordSize;
 	UINT m_uiHitGroupRecordSize;
@@ -206,18 +303,69 @@ private:
 	Texture* m_pDistanceAtlas = nullptr;
 	Texture* m_pProbeDataAtlas = nullptr;
 
+	//Irradiance filtered across neighbouring probes, shaded from instead of the irradiance atlas when the filter is on.
+	//The irradiance atlas stays unfiltered so the filter doesn't build up in the history frame after frame
+	Texture* m_pFilteredIrradianceAtlas = nullptr;
+
+	//First element is the number of active probes followed by their atlas indices
+	Microsoft::WRL::ComPtr<ID3D12Resource> m_pActiveProbeList;
+	Microsoft::WRL::ComPtr<ID3D12Resource> m_pActiveProbeListReadback;
+	UploadBuffer<UINT>* m_pActiveProbeCountReset = nullptr;
+	UploadBuffer<UINT>* m_pScheduledProbeListUpload = nullptr;
+	SRVDescriptor* m_pActiveProbeListSRV = nullptr;
+	UAVDescriptor* m_pActiveProbeListUAV = nullptr;
+
+	//Running luminance mean and variance per probe, read back every frame to share out the rays
+	Texture* m_pProbeStatsAtlas = nullptr;
+	Microsoft::WRL::ComPtr<ID3D12Resource> m_pProbeStatsReadback;
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT m_ProbeStatsFootprint;
+
+	//Per probe hysteresis and smoothed irradiance change written by the irradiance blend, read back for the convergence stats
+	Texture* m_pProbeHysteresisAtlas = nullptr;
+	Microsoft::WRL::ComPtr<ID3D12Resource> m_pProbeHysteresisReadback;
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT m_ProbeHysteresisFootprint;
+
+	UploadBuffer<UINT>* m_pProbeRayCountsUpload = nullptr;
+	SRVDescriptor* m_pProbeRayCountsSRV = nullptr;
+
+	//Every ray's direction rotated by this frame's rotation, the shaders fall back to working them out per ray when
+	//adaptive rays are on as the spiral depends on each probe's ray count
+	UploadBuffer<DirectX::XMFLOAT4>* m_pRayDirectionTableUpload = nullptr;
+	SRVDescriptor* m_pRayDirectionTableSRV = nullptr;
+
+	//World position and state of every probe in atlas order, drawn from by App's probe visualization
+	Microsoft::WRL::ComPtr<ID3D12Resource> m_pProbePositions;
+	SRVDescriptor* m_pProbePositionsSRV = nullptr;
+	UAVDescriptor* m_pProbePositionsUAV = nullptr;
+
+	enum class SnapshotState
+	{
+		NONE = 0,
+		REQUESTED,
+		COPYING
+	};
+
+	SnapshotState m_SnapshotState = SnapshotState::NONE;
+	std::string m_sSnapshotFilepath = "";
+
+	//One per atlas in the order of SnapshotAtlas
+	std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> m_SnapshotReadbacks;
+	std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> m_SnapshotFootprints;
+	std::vector<UINT> m_SnapshotNumRows;
+	std::vector<UINT64> m_SnapshotRowSizes;
+
 	DirectX::XMFLOAT3 m_Position = DirectX::XMFLOAT3();
 	DirectX::XMFLOAT3 m_ProbeSpacing = DirectX::XMFLOAT3(0.3f, 0.3f, 0.3f);
 	float m_ProbeScale = 0.05f;
 	DirectX::XMINT3 m_ProbeCounts = DirectX::XMINT3(9, 9, 9);
+	int m_iCascadeIndex = 0;
 	int m_iIrradianceTexelsPerProbe = 6;
 	int m_iDistanceTexelsPerProbe = 14;
 	
 	AtlasSize m_AtlasSize = AtlasSize::BIGGER;
 
-	std::vector<GameObject*> m_ProbeGameObjects = std::vector<GameObject*>();
-
 	bool m_bProbeRelocation = false;
+	bool m_bProbeClassification = false;
 	bool m_bProbeTracking = false;
 	bool m_bShowProbes = false;
 
@@ -256,6 +404,12 @@ private:
 	LPCWSTR m_DistanceProbeBlendingName = L"DistanceProbeBlendingCompute";
 	LPCWSTR m_DistanceRowProbeBlendingName = L"DistanceRowProbeBlendingCompute";
 	LPCWSTR m_DistanceColumnProbeBlendingName = L"DistanceColumnProbeBlendingCompute";
+	LPCWSTR m_ProbeRelocationName = L"ProbeRelocationCompute";
+	LPCWSTR m_ProbeClassificationName = L"ProbeClassificationCompute";
+	LPCWSTR m_ProbeStatsName = L"ProbeStatsCompute";
+	LPCWSTR m_ProbePositionsName = L"ProbePositionsCompute";
+	LPCWSTR m_IrradianceSHProjectionName = L"IrradianceSHProjectionCompute";
+	LPCWSTR m_ProbeFilterName = L"ProbeFilterCompute";
 
 	Microsoft::WRL::ComPtr<ID3D12RootSignature> m_pGlobalRootSignature;
 	Microsoft::WRL::ComPtr<ID3D12RootSignature> m_pLocalRootSignature;
@@ -267,11 +421,18 @@ private:
 	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_pIrradianceBlendPSO;
 	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_pIrradianceRowBlendPSO;
 	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_pIrradianceColumnBlendPSO;
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_pIrradianceSHProjectionPSO;
 
 	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_pDistanceBlendPSO;
 	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_pDistanceRowBlendPSO;
 	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_pDistanceColumnBlendPSO;
 
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_pProbeRelocationPSO;
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_pProbeClassificationPSO;
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_pProbeStatsPSO;
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_pProbePositionsPSO;
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_pProbeFilterPSO;
+
 	Microsoft::WRL::ComPtr<ID3D12Resource> m_pMissTable;
 	Microsoft::WRL::ComPtr<ID3D12Resource> m_pHitGroupTable;
 	Microsoft::WRL::ComPtr<ID3D12Resource> m_pRayGenTable;
@@ -285,17 +446,69 @@ private:
 	float m_fBrightnessThreshold = 2.0f;
 	float m_fDistancePower = 50.0f;
 	float m_fHysteresis = 0.97f;
+	int m_iRayDataFormat = 1;
 	int m_iIrradianceFormat = 1;
+	int m_iIrradianceEncoding = 0;
+	int m_iAtlasLayout = 0;
 	float m_fIrradianceGammaEncoding = 5.0f;
 	float m_fIrradianceThreshold = 0.2f;
+	float m_fProbeMinFrontfaceDistance = 0.1f;
+	float m_fProbeBackfaceThreshold = 0.25f;
 	DirectX::XMFLOAT3 m_MissRadiance = DirectX::XMFLOAT3(0, 0, 0);
 	DirectX::XMINT3 m_ProbeOffsets = DirectX::XMINT3(0, 0, 0);
 	DirectX::XMINT3 m_ClearPlanes = DirectX::XMINT3(0, 0, 0);
 
+	//Inactive probes are only retraced every m_iFullUpdateInterval frames so they can become active again.
+	//m_ClassifiedProbes is last frame's active list read back, only kept up to date while the list is built on the CPU
+	bool m_bUseActiveProbeList = false;
+	bool m_bActiveProbeCountValid = false;
+	bool m_bFullProbeUpdate = true;
+	std::vector<bool> m_ClassifiedProbes;
+	int m_iNumActiveProbes = 0;
+	int m_iFramesSinceFullUpdate = 0;
+	int m_iFullUpdateInterval = 30;
+
+	//Set when the probe list is built on the CPU by scheduling or sleeping instead of by classification
+	bool m_bUploadProbeList = false;
+
+	//Caps how many probes are updated a frame, takes over the active probe list from classification when it is on
+	ProbeScheduler m_ProbeScheduler;
+
+	//m_iRaysPerProbe is the most rays any one probe can get when adaptive rays are on
+	AdaptiveRayAllocator m_RayAllocator;
+	std::vector<UINT> m_ProbeRayCounts;
+	bool m_bAdaptiveRays = false;
+	bool m_bProbeStatsValid = false;
+	double m_dAdaptiveRayError = 1.0;	//Expected error relative to giving every probe the same number of rays
+
+	//m_fHysteresis is the most any one probe's hysteresis can rise to when adaptive hysteresis is on
+	ProbeConvergenceTracker m_ConvergenceTracker;
+	bool m_bAdaptiveHysteresis = false;
+	bool m_bProbeHysteresisValid = false;
+	float m_fMinHysteresis = 0.8f;
+	float m_fHysteresisRiseRate = 0.05f;
+	float m_fHysteresisChangeThreshold = 0.1f;
+
+	//Probes that stop changing are left out of the probe list until a light, a nearby object or the volume changes.
+	//m_UpdatedProbes is the list last built on the CPU so the read back changes can be matched to the probes they are from,
+	//m_TracedProbeMask has a bit set for each of them and is uploaded after the list.
+	//m_fProbeWakeRadius is how far past a changed object's bounds probes are woken
+	ProbeSleepTracker m_SleepTracker;
+	std::vector<UINT> m_AllProbes;
+	std::vector<UINT> m_UpdatedProbes;
+	std::vector<UINT> m_TracedProbeMask;
+	bool m_bProbeSleeping = false;
+	float m_fProbeWakeRadius = 2.0f;
+
+	int m_iProbeFilter = 0;
+	float m_fProbeFilterStrength = 0.25f;
+
+	RayRotationGenerator m_RayRotationGenerator;
 	DirectX::XMFLOAT4 m_RayRotation = DirectX::XMFLOAT4(0, 0, 0, 1);
+	bool m_bPerProbeRayRotation = false;
 
-	DirectX::XMFLOAT3 m_Anchor = DirectX::XMFLOAT3(0, 0, 0);
+	RayDirectionTable m_RayDirectionTable;
 
-	std::mt19937 m_rng;
+	DirectX::XMFLOAT3 m_Anchor = DirectX::XMFLOAT3(0, 0, 0);
 };
 
@@ -0,0 +1,538 @@
+#include "AccessorHelper.h"
+#include "Include/tinygltf/tiny_gltf.h"
+#include "Commons/Timer.h"
+#include "Shaders/Vertices.h"
+
+#include <emmintrin.h>
+#include <float.h>
+#include <math.h>
+
+namespace
+{
+	//glTF divides normalized integers by the largest value the type can hold and clamps signed ones to -1
+	template<int iComponentType>
+	float GetNormalizeDivisor()
+	{
+		switch (iComponentType)
+		{
+		case TINYGLTF_COMPONENT_TYPE_BYTE:
+			return 127.0f;
+
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+			return 255.0f;
+
+		case TINYGLTF_COMPONENT_TYPE_SHORT:
+			return 32767.0f;
+
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+			return 65535.0f;
+
+		default:
+			return 1.0f;
+		}
+	}
+
+	float ReadComponent(const BYTE* kpData, int iComponentType, bool bNormalized)
+	{
+		float fValue;
+		float fDivisor = 1.0f;
+
+		switch (iComponentType)
+		{
+		case TINYGLTF_COMPONENT_TYPE_BYTE:
+		{
+			INT8 iValue;
+			memcpy(&iValue, kpData, sizeof(INT8));
+
+			fValue = (float)iValue;
+			fDivisor = GetNormalizeDivisor<TINYGLTF_COMPONENT_TYPE_BYTE>();
+		}
+		break;
+
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+			fValue = (float)kpData[0];
+			fDivisor = GetNormalizeDivisor<TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE>();
+			break;
+
+		case TINYGLTF_COMPONENT_TYPE_SHORT:
+		{
+			INT16 iValue;
+			memcpy(&iValue, kpData, sizeof(INT16));
+
+			fValue = (float)iValue;
+			fDivisor = GetNormalizeDivisor<TINYGLTF_COMPONENT_TYPE_SHORT>();
+		}
+		break;
+
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+		{
+			UINT16 uiValue;
+			memcpy(&uiValue, kpData, sizeof(UINT16));
+
+			fValue = (float)uiValue;
+			fDivisor = GetNormalizeDivisor<TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT>();
+		}
+		break;
+
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+		{
+			UINT32 uiValue;
+			memcpy(&uiValue, kpData, sizeof(UINT32));
+
+			fValue = (float)uiValue;
+		}
+		break;
+
+		case TINYGLTF_COMPONENT_TYPE_FLOAT:
+			memcpy(&fValue, kpData, sizeof(float));
+
+			return fValue;
+
+		default:
+			return 0.0f;
+		}
+
+		if (bNormalized == false)
+		{
+			return fValue;
+		}
+
+		return (std::max)(fValue / fDivisor, -1.0f);
+	}
+
+	//Loads four components, the ones past the element's end are whatever follows it
+	template<int iComponentType>
+	__m128 LoadElement(const BYTE* kpData)
+	{
+		const __m128i kZero = _mm_setzero_si128();
+
+		switch (iComponentType)
+		{
+		case TINYGLTF_COMPONENT_TYPE_BYTE:
+		{
+			int iBits;
+			memcpy(&iBits, kpData, sizeof(int));
+
+			__m128i value = _mm_cvtsi32_si128(iBits);
+			value = _mm_unpacklo_epi8(value, value);
+			value = _mm_unpacklo_epi16(value, value);
+
+			return _mm_cvtepi32_ps(_mm_srai_epi32(value, 24));
+		}
+
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+		{
+			int iBits;
+			memcpy(&iBits, kpData, sizeof(int));
+
+			__m128i value = _mm_cvtsi32_si128(iBits);
+			value = _mm_unpacklo_epi8(value, kZero);
+			value = _mm_unpacklo_epi16(value, kZero);
+
+			return _mm_cvtepi32_ps(value);
+		}
+
+		case TINYGLTF_COMPONENT_TYPE_SHORT:
+		{
+			__m128i value = _mm_loadl_epi64((const __m128i*)kpData);
+			value = _mm_unpacklo_epi16(value, value);
+
+			return _mm_cvtepi32_ps(_mm_srai_epi32(value, 16));
+		}
+
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+		{
+			__m128i value = _mm_loadl_epi64((const __m128i*)kpData);
+
+			return _mm_cvtepi32_ps(_mm_unpacklo_epi16(value, kZero));
+		}
+
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+		{
+			//Converted as two exact halves so the sum is rounded once, the same as converting the whole value
+			__m128i value = _mm_loadu_si128((const __m128i*)kpData);
+
+			__m128 high = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(value, 16)), _mm_set1_ps(65536.0f));
+			__m128 low = _mm_cvtepi32_ps(_mm_and_si128(value, _mm_set1_epi32(0xFFFF)));
+
+			return _mm_add_ps(high, low);
+		}
+
+		default:
+			return _mm_loadu_ps((const float*)kpData);
+		}
+	}
+
+	template<int iNumComponents>
+	void StoreElement(float* pOutput, __m128 value)
+	{
+		switch (iNumComponents)
+		{
+		case 1:
+			_mm_store_ss(pOutput, value);
+			break;
+
+		case 2:
+			_mm_storel_pi((__m64*)pOutput, value);
+			break;
+
+		case 3:
+			_mm_storel_pi((__m64*)pOutput, value);
+			_mm_store_ss(pOutput + 2, _mm_movehl_ps(value, value));
+			break;
+
+		default:
+			_mm_storeu_ps(pOutput, value);
+			break;
+		}
+	}
+
+	template<int iComponentType, int iNumComponents>
+	void DecodeElements(const AccessorView& kView, float* pOutput, UINT uiOutputStride)
+	{
+		const UINT kuiComponentSize = (UINT)tinygltf::GetComponentSizeInBytes(iComponentType);
+
+		//Elements that four components can be loaded from without reading past the last element
+		UINT64 uiEnd = (UINT64)(kView.Count - 1) * kView.ByteStride + kView.NumComponents * kuiComponentSize;
+		UINT uiNumVectorElements = 0;
+
+		if (uiEnd >= 4 * kuiComponentSize)
+		{
+			uiNumVectorElements = (UINT)(std::min)((UINT64)kView.Count, (uiEnd - 4 * kuiComponentSize) / kView.ByteStride + 1);
+		}
+
+		//Dividing by one and clamping to -FLT_MAX leaves the value as it is so normalization doesn't need its own loop
+		const __m128 kDivisor = _mm_set1_ps(kView.Normalized == true ? GetNormalizeDivisor<iComponentType>() : 1.0f);
+		const __m128 kMinValue = _mm_set1_ps(kView.Normalized == true ? -1.0f : -FLT_MAX);
+
+		const BYTE* kpInput = kView.Data;
+		BYTE* pOutputBytes = (BYTE*)pOutput;
+
+		UINT i = 0;
+
+		for (; i < uiNumVectorElements; ++i)
+		{
+			__m128 value = LoadElement<iComponentType>(kpInput);
+
+			if (iComponentType != TINYGLTF_COMPONENT_TYPE_FLOAT && iComponentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT)
+			{
+				value = _mm_max_ps(_mm_div_ps(value, kDivisor), kMinValue);
+			}
+
+			StoreElement<iNumComponents>((float*)pOutputBytes, value);
+
+			kpInput += kView.ByteStride;
+			pOutputBytes += uiOutputStride;
+		}
+
+		for (; i < kView.Count; ++i)
+		{
+			for (int j = 0; j < iNumComponents; ++j)
+			{
+				((float*)pOutputBytes)[j] = ReadComponent(kpInput + j * kuiComponentSize, iComponentType, kView.Normalized);
+			}
+
+			kpInput += kView.ByteStride;
+			pOutputBytes += uiOutputStride;
+		}
+	}
+
+	template<int iComponentType>
+	void DecodeElements(const AccessorView& kView, float* pOutput, UINT uiOutputStride, int iNumComponents)
+	{
+		switch (iNumComponents)
+		{
+		case 1:
+			DecodeElements<iComponentType, 1>(kView, pOutput, uiOutputStride);
+			break;
+
+		case 2:
+			DecodeElements<iComponentType, 2>(kView, pOutput, uiOutputStride);
+			break;
+
+		case 3:
+			DecodeElements<iComponentType, 3>(kView, pOutput, uiOutputStride);
+			break;
+
+		default:
+			DecodeElements<iComponentType, 4>(kView, pOutput, uiOutputStride);
+			break;
+		}
+	}
+
+	//Pseudo random bytes, floats are kept to [-1, 1] so no NaNs end up in the timings
+	void FillSyntheticData(std::vector<BYTE>& data, int iComponentType)
+	{
+		UINT32 uiState = 0x9E3779B9;
+
+		if (iComponentType == TINYGLTF_COMPONENT_TYPE_FLOAT)
+		{
+			float* pfData = (float*)data.data();
+
+			for (size_t i = 0; i < data.size() / sizeof(float); ++i)
+			{
+				uiState = uiState * 1664525u + 1013904223u;
+
+				pfData[i] = (uiState >> 8) / (float)(1 << 23) - 1.0f;
+			}
+
+			return;
+		}
+
+		for (size_t i = 0; i < data.size(); ++i)
+		{
+			uiState = uiState * 1664525u + 1013904223u;
+
+			data[i] = (BYTE)(uiState >> 24);
+		}
+	}
+}
+
+void AccessorHelper::DecodeFloats(const AccessorView& kView, float* pOutput, UINT uiOutputStride, int iNumOutputComponents)
+{
+	int iNumComponents = (std::min)(kView.NumComponents, iNumOutputComponents);
+
+	if (kView.Count == 0 || iNumComponents <= 0)
+	{
+		return;
+	}
+
+	if (kView.Data == nullptr)
+	{
+		for (UINT i = 0; i < kView.Count; ++i)
+		{
+			memset((BYTE*)pOutput + (size_t)i * uiOutputStride, 0, sizeof(float) * iNumComponents);
+		}
+
+		return;
+	}
+
+	switch (kView.ComponentType)
+	{
+	case TINYGLTF_COMPONENT_TYPE_BYTE:
+		DecodeElements<TINYGLTF_COMPONENT_TYPE_BYTE>(kView, pOutput, uiOutputStride, iNumComponents);
+		break;
+
+	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+		DecodeElements<TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE>(kView, pOutput, uiOutputStride, iNumComponents);
+		break;
+
+	case TINYGLTF_COMPONENT_TYPE_SHORT:
+		DecodeElements<TINYGLTF_COMPONENT_TYPE_SHORT>(kView, pOutput, uiOutputStride, iNumComponents);
+		break;
+
+	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+		DecodeElements<TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT>(kView, pOutput, uiOutputStride, iNumComponents);
+		break;
+
+	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+		DecodeElements<TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT>(kView, pOutput, uiOutputStride, iNumComponents);
+		break;
+
+	case TINYGLTF_COMPONENT_TYPE_FLOAT:
+		DecodeElements<TINYGLTF_COMPONENT_TYPE_FLOAT>(kView, pOutput, uiOutputStride, iNumComponents);
+		break;
+
+	default:
+		break;
+	}
+}
+
+void AccessorHelper::ScatterFloats(const AccessorView& kValues, const UINT* kpIndices, float* pOutput, UINT uiOutputStride, int iNumOutputComponents)
+{
+	int iNumComponents = (std::min)(kValues.NumComponents, iNumOutputComponents);
+	int iComponentSize = tinygltf::GetComponentSizeInBytes(kValues.ComponentType);
+
+	for (UINT i = 0; i < kValues.Count; ++i)
+	{
+		const BYTE* kpElement = kValues.Data + (size_t)i * kValues.ByteStride;
+		float* pElement = (float*)((BYTE*)pOutput + (size_t)kpIndices[i] * uiOutputStride);
+
+		for (int j = 0; j < iNumComponents; ++j)
+		{
+			pElement[j] = ReadComponent(kpElement + j * iComponentSize, kValues.ComponentType, kValues.Normalized);
+		}
+	}
+}
+
+bool AccessorHelper::WidenIndices(const BYTE* kpData, UINT uiCount, int iComponentType, UINT* pOutput)
+{
+	const __m128i kZero = _mm_setzero_si128();
+
+	UINT i = 0;
+
+	switch (iComponentType)
+	{
+	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+		memcpy(pOutput, kpData, sizeof(UINT) * uiCount);
+		break;
+
+	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+		for (; i + 8 <= uiCount; i += 8)
+		{
+			__m128i indices = _mm_loadu_si128((const __m128i*)(kpData + i * sizeof(UINT16)));
+
+			_mm_storeu_si128((__m128i*)(pOutput + i), _mm_unpacklo_epi16(indices, kZero));
+			_mm_storeu_si128((__m128i*)(pOutput + i + 4), _mm_unpackhi_epi16(indices, kZero));
+		}
+
+		for (; i < uiCount; ++i)
+		{
+			UINT16 uiIndex;
+			memcpy(&uiIndex, kpData + i * sizeof(UINT16), sizeof(UINT16));
+
+			pOutput[i] = uiIndex;
+		}
+		break;
+
+	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+		for (; i + 16 <= uiCount; i += 16)
+		{
+			__m128i indices = _mm_loadu_si128((const __m128i*)(kpData + i));
+			__m128i low = _mm_unpacklo_epi8(indices, kZero);
+			__m128i high = _mm_unpackhi_epi8(indices, kZero);
+
+			_mm_storeu_si128((__m128i*)(pOutput + i), _mm_unpacklo_epi16(low, kZero));
+			_mm_storeu_si128((__m128i*)(pOutput + i + 4), _mm_unpackhi_epi16(low, kZero));
+			_mm_storeu_si128((__m128i*)(pOutput + i + 8), _mm_unpacklo_epi16(high, kZero));
+			_mm_storeu_si128((__m128i*)(pOutput + i + 12), _mm_unpackhi_epi16(high, kZero));
+		}
+
+		for (; i < uiCount; ++i)
+		{
+			pOutput[i] = kpData[i];
+		}
+		break;
+
+	default:
+		return false;
+	}
+
+	return true;
+}
+
+void AccessorHelper::NormalizeFloat3(float* pData, UINT uiStride, UINT uiCount)
+{
+	BYTE* pBytes = (BYTE*)pData;
+
+	for (UINT i = 0; i < uiCount; ++i)
+	{
+		float* pElement = (float*)(pBytes + (size_t)i * uiStride);
+
+		//Only three floats are loaded, the element could be the last thing in the buffer
+		__m128 value = _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)pElement), _mm_load_ss(pElement + 2));
+
+		__m128 squared = _mm_mul_ps(value, value);
+		__m128 lengthSquared = _mm_add_ss(_mm_add_ss(squared, _mm_shuffle_ps(squared, squared, _MM_SHUFFLE(1, 1, 1, 1))), _mm_movehl_ps(squared, squared));
+
+		if (_mm_cvtss_f32(lengthSquared) > 0.0f)
+		{
+			value = _mm_div_ps(value, _mm_shuffle_ps(_mm_sqrt_ss(lengthSquared), _mm_sqrt_ss(lengthSquared), _MM_SHUFFLE(0, 0, 0, 0)));
+
+			_mm_storel_pi((__m64*)pElement, value);
+			_mm_store_ss(pElement + 2, _mm_movehl_ps(value, value));
+		}
+	}
+}
+
+std::vector<AccessorDecodeStats> AccessorHelper::MeasureThroughput(UINT uiNumElements)
+{
+	const int kComponentTypes[] =
+	{
+		TINYGLTF_COMPONENT_TYPE_BYTE,
+		TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE,
+		TINYGLTF_COMPONENT_TYPE_SHORT,
+		TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT,
+		TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT,
+		TINYGLTF_COMPONENT_TYPE_FLOAT
+	};
+
+	const UINT kuiInterleavedStride = 32;
+
+	std::vector<AccessorDecodeStats> stats;
+	std::vector<Vertex> vertices(uiNumElements);
+	std::vector<BYTE> data((size_t)uiNumElements * kuiInterleavedStride);
+
+	Timer timer;
+
+	for (int i = 0; i < _countof(kComponentTypes); ++i)
+	{
+		FillSyntheticData(data, kComponentTypes[i]);
+
+		for (int iNumComponents = 2; iNumComponents <= 4; ++iNumComponents)
+		{
+			//Where MeshManager puts attributes of each size
+			float* pOutput = iNumComponents == 2 ? &vertices[0].TexCoords.x : iNumComponents == 3 ? &vertices[0].Position.x : &vertices[0].Tangent.x;
+
+			UINT uiElementSize = iNumComponents * tinygltf::GetComponentSizeInBytes(kComponentTypes[i]);
+			UINT kStrides[] = { uiElementSize, kuiInterleavedStride };
+
+			for (int j = 0; j < _countof(kStrides); ++j)
+			{
+				AccessorView view;
+				view.Data = data.data();
+				view.Count = uiNumElements;
+				view.ByteStride = kStrides[j];
+				view.ComponentType = kComponentTypes[i];
+				view.NumComponents = iNumComponents;
+				view.Normalized = kComponentTypes[i] != TINYGLTF_COMPONENT_TYPE_FLOAT && kComponentTypes[i] != TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT;
+
+				timer.Reset();
+
+				DecodeFloats(view, pOutput, sizeof(Vertex), iNumComponents);
+
+				timer.Tick();
+
+				AccessorDecodeStats stat;
+				stat.ComponentType = view.ComponentType;
+				stat.NumComponents = view.NumComponents;
+				stat.Normalized = view.Normalized;
+				stat.ByteStride = view.ByteStride;
+				stat.NumElements = uiNumElements;
+				stat.DecodeSeconds = timer.DeltaTime();
+
+				stats.push_back(stat);
+			}
+		}
+	}
+
+	return stats;
+}
+
+std::vector<AccessorDecodeStats> AccessorHelper::MeasureIndexThroughput(UINT uiNumIndices)
+{
+	const int kComponentTypes[] =
+	{
+		TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE,
+		TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT,
+		TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT
+	};
+
+	std::vector<AccessorDecodeStats> stats;
+	std::vector<UINT> indices(uiNumIndices);
+	std::vector<BYTE> data((size_t)uiNumIndices * sizeof(UINT));
+
+	Timer timer;
+
+	for (int i = 0; i < _countof(kComponentTypes); ++i)
+	{
+		FillSyntheticData(data, kComponentTypes[i]);
+
+		timer.Reset();
+
+		WidenIndices(data.data(), uiNumIndices, kComponentTypes[i], indices.data());
+
+		timer.Tick();
+
+		AccessorDecodeStats stat;
+		stat.ComponentType = kComponentTypes[i];
+		stat.NumComponents = 1;
+		stat.ByteStride = tinygltf::GetComponentSizeInBytes(kComponentTypes[i]);
+		stat.NumElements = uiNumIndices;
+		stat.DecodeSeconds = timer.DeltaTime();
+
+		stats.push_back(stat);
+	}
+
+	return stats;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <vector>
+
+//Where an accessor's elements are in its buffer view and how they're stored. Data is nullptr for sparse accessors
+//without a buffer view, every element of those starts as zero.
+struct AccessorView
+{
+	const BYTE* Data = nullptr;
+	UINT Count = 0;
+	UINT ByteStride = 0;
+
+	int ComponentType = 0;	//TINYGLTF_COMPONENT_TYPE_*
+	int NumComponents = 0;
+	bool Normalized = false;
+};
+
+struct AccessorDecodeStats
+{
+	int ComponentType = 0;
+	int NumComponents = 0;
+	bool Normalized = false;
+	UINT ByteStride = 0;
+
+	UINT NumElements = 0;
+
+	float DecodeSeconds = 0.0f;
+
+	double GetElementsPerSecond() const
+	{
+		return DecodeSeconds > 0.0f ? NumElements / (double)DecodeSeconds : 0.0;
+	}
+};
+
+//SSE2 bulk conversion of glTF accessors into the layout MeshManager builds. Each element is loaded, converted and
+//normalized a whole element at a time, elements too close to the end of the data to load four components from go
+//through the scalar version so nothing is read past the accessor. Both give the same bits.
+//
+//Covers every component type with or without normalization and any stride, which is everything KHR_mesh_quantization
+//allows as well.
+class AccessorHelper
+{
+public:
+	//Converts the first iNumOutputComponents components of every element to float and writes them uiOutputStride bytes
+	//apart. Components the accessor doesn't have are left as they are.
+	static void DecodeFloats(const AccessorView& kView, float* pOutput, UINT uiOutputStride, int iNumOutputComponents);
+
+	//Decodes kValues over the elements of pOutput listed in kpIndices, the values of a sparse accessor
+	static void ScatterFloats(const AccessorView& kValues, const UINT* kpIndices, float* pOutput, UINT uiOutputStride, int iNumOutputComponents);
+
+	//Unsigned byte, short or int values to UINT, false for any other component type
+	static bool WidenIndices(const BYTE* kpData, UINT uiCount, int iComponentType, UINT* pOutput);
+
+	//Normalizes the first three floats of each element, zero length elements are left as zero
+	static void NormalizeFloat3(float* pData, UINT uiStride, UINT uiCount);
+
+	//Decodes uiNumElements synthetic elements of every component type and element size a vertex attribute could have,
+	//tightly packed and interleaved in a 32 byte stride, into a Vertex array
+	static std::vector<AccessorDecodeStats> MeasureThroughput(UINT uiNumElements);
+
+	//Same for widening indices of each type
+	static std::vector<AccessorDecodeStats> MeasureIndexThroughput(UINT uiNumIndices);
+
+protected:
+
+private:
+
+};
@@ -25,9 +25,14 @@ std::vector<std::string> DebugHelper::s_sGpuStatNames =
 	"Blend Probes",
 	"Blend Probe Atlases",
 	"Blend Probe Borders",
+	"Filter Probes",
+	"Relocate Probes",
+	"Classify Probes",
+	"Probe Statistics",
 	"Deferred Pass",
 	"G Buffer Pass",
-	"Light Pass"
+	"Light Pass",
+	"Draw Probes"
 };
 
 #define BUFFER_SIZE 256
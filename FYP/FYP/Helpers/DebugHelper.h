@@ -24,9 +24,14 @@ enum class GpuStats
 	BLEND_PROBES,
 	ATLAS_BLEND_PROBES,
 	BORDER_BLEND_PROBES,
+	FILTER_PROBES,
+	RELOCATE_PROBES,
+	CLASSIFY_PROBES,
+	PROBE_STATS,
 	DEFERRED_PASS,
 	GBUFFER,
 	LIGHT,
+	DRAW_PROBES,
 
 	COUNT
 };
@@ -0,0 +1,251 @@
+#include "HDRPackingHelper.h"
+#include "Helpers/ProbeHelper.h"
+#include "Commons/Timer.h"
+#include "Shaders/Defines.hlsli"
+
+#include <emmintrin.h>
+#include <math.h>
+
+using namespace DirectX;
+
+namespace
+{
+	void LoadFloat3x4(const XMFLOAT3* kpInput, __m128& r, __m128& g, __m128& b)
+	{
+		r = _mm_setr_ps(kpInput[0].x, kpInput[1].x, kpInput[2].x, kpInput[3].x);
+		g = _mm_setr_ps(kpInput[0].y, kpInput[1].y, kpInput[2].y, kpInput[3].y);
+		b = _mm_setr_ps(kpInput[0].z, kpInput[1].z, kpInput[2].z, kpInput[3].z);
+	}
+
+	void StoreFloat3x4(XMFLOAT3* pOutput, __m128 r, __m128 g, __m128 b)
+	{
+		alignas(16) float rs[4];
+		alignas(16) float gs[4];
+		alignas(16) float bs[4];
+
+		_mm_store_ps(rs, r);
+		_mm_store_ps(gs, g);
+		_mm_store_ps(bs, b);
+
+		for (int i = 0; i < 4; ++i)
+		{
+			pOutput[i] = XMFLOAT3(rs[i], gs[i], bs[i]);
+		}
+	}
+
+	__m128 Clamp(__m128 value, __m128 maxValue)
+	{
+		//Max returns the second operand for NaNs, same as fmaxf in the scalar version
+		return _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), maxValue);
+	}
+
+	//floor(value * scale + 0.5) for positive values, the scalar FloatToUint
+	__m128i FloatToUint(__m128 value, __m128 scale)
+	{
+		return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, scale), _mm_set1_ps(0.5f)));
+	}
+
+	__m128i FloatToUnsignedFloat(__m128 value, int iMantissaBits, float fMaxValue)
+	{
+		__m128i bits = _mm_castps_si128(Clamp(value, _mm_set1_ps(fMaxValue)));
+		__m128i flushed = _mm_cmplt_epi32(bits, _mm_set1_epi32((int)ProbeHelper::AsUint(R11G11B10_MIN)));
+
+		bits = _mm_add_epi32(bits, _mm_set1_epi32(1 << (22 - iMantissaBits)));
+		bits = _mm_sub_epi32(_mm_srl_epi32(bits, _mm_cvtsi32_si128(23 - iMantissaBits)), _mm_set1_epi32((127 - 15) << iMantissaBits));
+
+		return _mm_andnot_si128(flushed, bits);
+	}
+
+	__m128 UnsignedFloatToFloat(__m128i value, int iMantissaBits)
+	{
+		__m128i flushed = _mm_cmplt_epi32(value, _mm_set1_epi32(1 << iMantissaBits));
+
+		__m128i bits = _mm_sll_epi32(_mm_add_epi32(value, _mm_set1_epi32((127 - 15) << iMantissaBits)), _mm_cvtsi32_si128(23 - iMantissaBits));
+
+		return _mm_castsi128_ps(_mm_andnot_si128(flushed, bits));
+	}
+}
+
+void HDRPackingHelper::PackRGB9E5(const XMFLOAT3* kpInput, uint32_t* pOutput, int iCount)
+{
+	const __m128 kMaxValue = _mm_set1_ps(RGB9E5_MAX);
+
+	//Smallest value that still gives a shared exponent of 1, so clamping the max channel clamps the exponent
+	const __m128 kMinExponentValue = _mm_castsi128_ps(_mm_set1_epi32(112 << 23));
+
+	int i = 0;
+
+	for (; i + 4 <= iCount; i += 4)
+	{
+		__m128 r;
+		__m128 g;
+		__m128 b;
+		LoadFloat3x4(kpInput + i, r, g, b);
+
+		r = Clamp(r, kMaxValue);
+		g = Clamp(g, kMaxValue);
+		b = Clamp(b, kMaxValue);
+
+		__m128 maxChannel = _mm_max_ps(r, _mm_max_ps(g, b));
+
+		__m128i sharedExponent = _mm_sub_epi32(_mm_srli_epi32(_mm_castps_si128(_mm_max_ps(maxChannel, kMinExponentValue)), 23), _mm_set1_epi32(127 - 16));
+		__m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_sub_epi32(_mm_set1_epi32(127 + 24), sharedExponent), 23));
+
+		__m128i roundsUp = _mm_cmpeq_epi32(FloatToUint(maxChannel, scale), _mm_set1_epi32(512));
+		sharedExponent = _mm_sub_epi32(sharedExponent, roundsUp);
+		scale = _mm_or_ps(_mm_and_ps(_mm_castsi128_ps(roundsUp), _mm_mul_ps(scale, _mm_set1_ps(0.5f))), _mm_andnot_ps(_mm_castsi128_ps(roundsUp), scale));
+
+		__m128i packed = FloatToUint(r, scale);
+		packed = _mm_or_si128(packed, _mm_slli_epi32(FloatToUint(g, scale), 9));
+		packed = _mm_or_si128(packed, _mm_slli_epi32(FloatToUint(b, scale), 18));
+		packed = _mm_or_si128(packed, _mm_slli_epi32(sharedExponent, 27));
+
+		_mm_storeu_si128((__m128i*)(pOutput + i), packed);
+	}
+
+	for (; i < iCount; ++i)
+	{
+		pOutput[i] = ProbeHelper::Float3ToRGB9E5(kpInput[i]);
+	}
+}
+
+void HDRPackingHelper::UnpackRGB9E5(const uint32_t* kpInput, XMFLOAT3* pOutput, int iCount)
+{
+	const __m128i kMantissaMask = _mm_set1_epi32(0x000001FF);
+
+	int i = 0;
+
+	for (; i + 4 <= iCount; i += 4)
+	{
+		__m128i packed = _mm_loadu_si128((const __m128i*)(kpInput + i));
+
+		__m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_srli_epi32(packed, 27), _mm_set1_epi32(127 - 24)), 23));
+
+		__m128 r = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(packed, kMantissaMask)), scale);
+		__m128 g = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(packed, 9), kMantissaMask)), scale);
+		__m128 b = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(packed, 18), kMantissaMask)), scale);
+
+		StoreFloat3x4(pOutput + i, r, g, b);
+	}
+
+	for (; i < iCount; ++i)
+	{
+		pOutput[i] = ProbeHelper::RGB9E5ToFloat3(kpInput[i]);
+	}
+}
+
+void HDRPackingHelper::PackR11G11B10(const XMFLOAT3* kpInput, uint32_t* pOutput, int iCount)
+{
+	int i = 0;
+
+	for (; i + 4 <= iCount; i += 4)
+	{
+		__m128 r;
+		__m128 g;
+		__m128 b;
+		LoadFloat3x4(kpInput + i, r, g, b);
+
+		__m128i packed = FloatToUnsignedFloat(r, 6, R11G11B10_R_MAX);
+		packed = _mm_or_si128(packed, _mm_slli_epi32(FloatToUnsignedFloat(g, 6, R11G11B10_R_MAX), 11));
+		packed = _mm_or_si128(packed, _mm_slli_epi32(FloatToUnsignedFloat(b, 5, R11G11B10_B_MAX), 22));
+
+		_mm_storeu_si128((__m128i*)(pOutput + i), packed);
+	}
+
+	for (; i < iCount; ++i)
+	{
+		pOutput[i] = ProbeHelper::Float3ToR11G11B10(kpInput[i]);
+	}
+}
+
+void HDRPackingHelper::UnpackR11G11B10(const uint32_t* kpInput, XMFLOAT3* pOutput, int iCount)
+{
+	const __m128i kMask = _mm_set1_epi32(0x000007FF);
+
+	int i = 0;
+
+	for (; i + 4 <= iCount; i += 4)
+	{
+		__m128i packed = _mm_loadu_si128((const __m128i*)(kpInput + i));
+
+		__m128 r = UnsignedFloatToFloat(_mm_and_si128(packed, kMask), 6);
+		__m128 g = UnsignedFloatToFloat(_mm_and_si128(_mm_srli_epi32(packed, 11), kMask), 6);
+		__m128 b = UnsignedFloatToFloat(_mm_srli_epi32(packed, 22), 5);
+
+		StoreFloat3x4(pOutput + i, r, g, b);
+	}
+
+	for (; i < iCount; ++i)
+	{
+		pOutput[i] = ProbeHelper::R11G11B10ToFloat3(kpInput[i]);
+	}
+}
+
+HDRPackingStats HDRPackingHelper::MeasureRoundTrip(int iRayDataFormat, const std::vector<XMFLOAT3>& kValues)
+{
+	HDRPackingStats stats;
+	stats.NumValues = (int)kValues.size();
+
+	std::vector<uint32_t> packed(kValues.size());
+	std::vector<XMFLOAT3> unpacked(kValues.size());
+
+	bool bRGB9E5 = iRayDataFormat == FORMAT_PROBE_RAY_DATA_RGB9E5;
+
+	Timer timer;
+	timer.Reset();
+
+	if (bRGB9E5 == true)
+	{
+		PackRGB9E5(kValues.data(), packed.data(), stats.NumValues);
+	}
+	else
+	{
+		PackR11G11B10(kValues.data(), packed.data(), stats.NumValues);
+	}
+
+	timer.Tick();
+	stats.EncodeSeconds = timer.DeltaTime();
+
+	timer.Reset();
+
+	if (bRGB9E5 == true)
+	{
+		UnpackRGB9E5(packed.data(), unpacked.data(), stats.NumValues);
+	}
+	else
+	{
+		UnpackR11G11B10(packed.data(), unpacked.data(), stats.NumValues);
+	}
+
+	timer.Tick();
+	stats.DecodeSeconds = timer.DeltaTime();
+
+	//Only values in the range the formats can hold, anything outside is clamped or flushed so the error there says nothing about precision
+	float fMaxValue = bRGB9E5 == true ? RGB9E5_MAX : R11G11B10_B_MAX;
+	double dTotalError = 0.0;
+	int iNumErrors = 0;
+
+	for (int i = 0; i < stats.NumValues; ++i)
+	{
+		const XMFLOAT3& kValue = kValues[i];
+		float fMaxChannel = fmaxf(kValue.x, fmaxf(kValue.y, kValue.z));
+
+		if (fMaxChannel < R11G11B10_MIN || fMaxChannel > fMaxValue)
+		{
+			continue;
+		}
+
+		for (int j = 0; j < 3; ++j)
+		{
+			double dError = fabs((double)(&unpacked[i].x)[j] - (double)(&kValue.x)[j]) / fMaxChannel;
+
+			stats.MaxRelativeError = dError > stats.MaxRelativeError ? dError : stats.MaxRelativeError;
+			dTotalError += dError;
+			++iNumErrors;
+		}
+	}
+
+	stats.MeanRelativeError = iNumErrors > 0 ? dTotalError / iNumErrors : 0.0;
+
+	return stats;
+}
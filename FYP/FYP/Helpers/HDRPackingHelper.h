@@ -0,0 +1,48 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <stdint.h>
+#include <vector>
+
+struct HDRPackingStats
+{
+	int NumValues = 0;
+
+	//Per channel error relative to the largest channel of the value, shared exponent formats can't do better than that
+	double MaxRelativeError = 0.0;
+	double MeanRelativeError = 0.0;
+
+	float EncodeSeconds = 0.0f;
+	float DecodeSeconds = 0.0f;
+
+	double GetEncodesPerSecond() const
+	{
+		return EncodeSeconds > 0.0f ? NumValues / (double)EncodeSeconds : 0.0;
+	}
+
+	double GetDecodesPerSecond() const
+	{
+		return DecodeSeconds > 0.0f ? NumValues / (double)DecodeSeconds : 0.0;
+	}
+};
+
+//SSE2 batch versions of the RGB9E5 and R11G11B10 codecs in Shaders/MathHelper.hlsl. Four values are done at a time and
+//the remainder goes through the scalar versions in Helpers/ProbeHelper.h, the output is the same bits either way.
+class HDRPackingHelper
+{
+public:
+	static void PackRGB9E5(const DirectX::XMFLOAT3* kpInput, uint32_t* pOutput, int iCount);
+	static void UnpackRGB9E5(const uint32_t* kpInput, DirectX::XMFLOAT3* pOutput, int iCount);
+
+	static void PackR11G11B10(const DirectX::XMFLOAT3* kpInput, uint32_t* pOutput, int iCount);
+	static void UnpackR11G11B10(const uint32_t* kpInput, DirectX::XMFLOAT3* pOutput, int iCount);
+
+	//Round trips the values through the ray data format's codec, FORMAT_PROBE_RAY_DATA_RGB9E5 or FORMAT_PROBE_RAY_DATA_R11G11B10
+	static HDRPackingStats MeasureRoundTrip(int iRayDataFormat, const std::vector<DirectX::XMFLOAT3>& kValues);
+
+protected:
+
+private:
+
+};
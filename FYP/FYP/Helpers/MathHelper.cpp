@@ -34,3 +34,23 @@ XMFLOAT4X4 MathHelper::Identity()
 		0, 0, 0, 1
 	);
 }
+
+void MathHelper::TransformBounds(const XMFLOAT3& kMin, const XMFLOAT3& kMax, const XMFLOAT4X4& kTransform, XMFLOAT3& outMin, XMFLOAT3& outMax)
+{
+	XMMATRIX transform = XMLoadFloat4x4(&kTransform);
+
+	XMVECTOR boundsMin = XMVectorReplicate(FLT_MAX);
+	XMVECTOR boundsMax = XMVectorReplicate(-FLT_MAX);
+
+	for (int i = 0; i < 8; ++i)
+	{
+		XMVECTOR corner = XMVectorSet((i & 1) != 0 ? kMax.x : kMin.x, (i & 2) != 0 ? kMax.y : kMin.y, (i & 4) != 0 ? kMax.z : kMin.z, 1.0f);
+		corner = XMVector3TransformCoord(corner, transform);
+
+		boundsMin = XMVectorMin(boundsMin, corner);
+		boundsMax = XMVectorMax(boundsMax, corner);
+	}
+
+	XMStoreFloat3(&outMin, boundsMin);
+	XMStoreFloat3(&outMax, boundsMax);
+}
@@ -15,6 +15,9 @@ public:
 	static UINT CalculatePaddedConstantBufferSize(UINT size);
 
 	static DirectX::XMFLOAT4X4 Identity();
+
+	//Axis aligned box around the 8 transformed corners of kMin and kMax
+	static void TransformBounds(const DirectX::XMFLOAT3& kMin, const DirectX::XMFLOAT3& kMax, const DirectX::XMFLOAT4X4& kTransform, DirectX::XMFLOAT3& outMin, DirectX::XMFLOAT3& outMax);
 protected:
 
 private:
@@ -0,0 +1,610 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include "Shaders/Defines.hlsli"
+
+#include <algorithm>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+//C++ versions of the functions in Shaders/ProbeHelper.hlsl, Shaders/Octahedral.hlsl and Shaders/MathHelper.hlsl.
+//These are kept as close to the HLSL as possible so that the CPU GI code gives the same results as the GPU.
+class ProbeHelper
+{
+public:
+	//====================================================
+	//Probe indexing
+	//====================================================
+
+	static DirectX::XMINT3 GetProbeCoords(int iProbeIndex, const DirectX::XMINT3& kProbeCounts)
+	{
+		DirectX::XMINT3 coords;
+		coords.x = iProbeIndex % kProbeCounts.x;
+		coords.y = iProbeIndex / (kProbeCounts.x * kProbeCounts.z);
+		coords.z = (iProbeIndex / kProbeCounts.x) % kProbeCounts.z;
+
+		return coords;
+	}
+
+	static int GetProbeIndex(const DirectX::XMINT3& kProbeCoords, const DirectX::XMINT3& kProbeCounts)
+	{
+		//Probes per plane * current plane index + probe index in current plane
+		return (kProbeCounts.x * kProbeCounts.z * kProbeCoords.y) + kProbeCoords.x + (kProbeCounts.x * kProbeCoords.z);
+	}
+
+	static int GetProbeIndex(const DirectX::XMINT2& kTexCoords, int iNumTexels, const DirectX::XMINT3& kProbeCounts, int iAtlasLayout)
+	{
+		if (iAtlasLayout == PROBE_ATLAS_LAYOUT_BRICKS)
+		{
+			DirectX::XMINT2 tileCoords = DirectX::XMINT2(kTexCoords.x / iNumTexels, kTexCoords.y / iNumTexels);
+			int iPairIndex = tileCoords.x / (kProbeCounts.x * 2);
+			int iPairColumn = tileCoords.x - (iPairIndex * kProbeCounts.x * 2);
+
+			//With an odd number of planes the last one has no pair and is laid out on its own
+			if ((kProbeCounts.y & 1) == 1 && iPairIndex == kProbeCounts.y / 2)
+			{
+				return GetProbeIndex(DirectX::XMINT3(iPairColumn, kProbeCounts.y - 1, tileCoords.y), kProbeCounts);
+			}
+
+			return GetProbeIndex(DirectX::XMINT3(iPairColumn / 2, (iPairIndex * 2) + (iPairColumn & 1), tileCoords.y), kProbeCounts);
+		}
+
+		int iPlaneIndex = kTexCoords.x / (iNumTexels * kProbeCounts.x);
+		int iProbeIndex = (kTexCoords.x / iNumTexels) - (iPlaneIndex * kProbeCounts.x) + (kProbeCounts.x * (kTexCoords.y / iNumTexels));
+
+		//Probes per plane * current plane index + probe index in current plane
+		return (kProbeCounts.x * kProbeCounts.z * iPlaneIndex) + iProbeIndex;
+	}
+
+	static int GetOffsettedProbeIndex(const DirectX::XMINT3& kProbeCoords, const DirectX::XMINT3& kProbeCounts, const DirectX::XMINT3& kProbeOffsets)
+	{
+		DirectX::XMINT3 coords;
+		coords.x = (kProbeCoords.x + kProbeOffsets.x + kProbeCounts.x) % kProbeCounts.x;
+		coords.y = (kProbeCoords.y + kProbeOffsets.y + kProbeCounts.y) % kProbeCounts.y;
+		coords.z = (kProbeCoords.z + kProbeOffsets.z + kProbeCounts.z) % kProbeCounts.z;
+
+		return GetProbeIndex(coords, kProbeCounts);
+	}
+
+	//Inverse of GetOffsettedProbeIndex, gets the coords in the volume of the probe stored at iProbeIndex in the atlases
+	static DirectX::XMINT3 GetUnoffsettedProbeCoords(int iProbeIndex, const DirectX::XMINT3& kProbeCounts, const DirectX::XMINT3& kProbeOffsets)
+	{
+		DirectX::XMINT3 coords = GetProbeCoords(iProbeIndex, kProbeCounts);
+		coords.x = (coords.x - (((kProbeOffsets.x % kProbeCounts.x) + kProbeCounts.x) % kProbeCounts.x) + kProbeCounts.x) % kProbeCounts.x;
+		coords.y = (coords.y - (((kProbeOffsets.y % kProbeCounts.y) + kProbeCounts.y) % kProbeCounts.y) + kProbeCounts.y) % kProbeCounts.y;
+		coords.z = (coords.z - (((kProbeOffsets.z % kProbeCounts.z) + kProbeCounts.z) % kProbeCounts.z) + kProbeCounts.z) % kProbeCounts.z;
+
+		return coords;
+	}
+
+	static DirectX::XMFLOAT3 GetProbeCoordsWorld(const DirectX::XMINT3& kProbeCoords, const DirectX::XMFLOAT3& kVolumePosition, const DirectX::XMINT3& kProbeOffsets, const DirectX::XMFLOAT3& kProbeSpacing, const DirectX::XMINT3& kProbeCounts)
+	{
+		return DirectX::XMFLOAT3(
+			kVolumePosition.x + (kProbeOffsets.x * kProbeSpacing.x) - ((kProbeCounts.x - 1) * kProbeSpacing.x * 0.5f) + (kProbeCoords.x * kProbeSpacing.x),
+			kVolumePosition.y + (kProbeOffsets.y * kProbeSpacing.y) - ((kProbeCounts.y - 1) * kProbeSpacing.y * 0.5f) + (kProbeCoords.y * kProbeSpacing.y),
+			kVolumePosition.z + (kProbeOffsets.z * kProbeSpacing.z) - ((kProbeCounts.z - 1) * kProbeSpacing.z * 0.5f) + (kProbeCoords.z * kProbeSpacing.z));
+	}
+
+	//Texel in the probe data atlas, laid out the same way as the probes in the irradiance and distance atlases
+	static DirectX::XMINT2 GetProbeDataCoords(int iProbeIndex, const DirectX::XMINT3& kProbeCounts, int iAtlasLayout)
+	{
+		if (iAtlasLayout == PROBE_ATLAS_LAYOUT_BRICKS)
+		{
+			DirectX::XMINT3 probeCoords = GetProbeCoords(iProbeIndex, kProbeCounts);
+			int iPairIndex = probeCoords.y / 2;
+			int iPairColumn = (kProbeCounts.y & 1) == 1 && probeCoords.y == kProbeCounts.y - 1 ? probeCoords.x : (probeCoords.x * 2) + (probeCoords.y & 1);
+
+			return DirectX::XMINT2((iPairIndex * kProbeCounts.x * 2) + iPairColumn, probeCoords.z);
+		}
+
+		return DirectX::XMINT2((iProbeIndex % kProbeCounts.x) + (iProbeIndex / (kProbeCounts.x * kProbeCounts.z)) * kProbeCounts.x, (iProbeIndex / kProbeCounts.x) % kProbeCounts.z);
+	}
+
+	static DirectX::XMINT3 GetClosestProbeCoords(const DirectX::XMFLOAT3& kPosW, const DirectX::XMFLOAT3& kVolumePosition, const DirectX::XMINT3& kProbeOffsets, const DirectX::XMFLOAT3& kProbeSpacing, const DirectX::XMINT3& kProbeCounts)
+	{
+		DirectX::XMFLOAT3 relativePos = DirectX::XMFLOAT3(
+			kPosW.x - (kVolumePosition.x + (kProbeOffsets.x * kProbeSpacing.x) - (kProbeSpacing.x * (kProbeCounts.x - 1)) * 0.5f),
+			kPosW.y - (kVolumePosition.y + (kProbeOffsets.y * kProbeSpacing.y) - (kProbeSpacing.y * (kProbeCounts.y - 1)) * 0.5f),
+			kPosW.z - (kVolumePosition.z + (kProbeOffsets.z * kProbeSpacing.z) - (kProbeSpacing.z * (kProbeCounts.z - 1)) * 0.5f));
+
+		//Rounded towards zero like the int3 cast in the shader
+		DirectX::XMINT3 coords = DirectX::XMINT3((int)(relativePos.x / kProbeSpacing.x), (int)(relativePos.y / kProbeSpacing.y), (int)(relativePos.z / kProbeSpacing.z));
+		coords.x = coords.x < 0 ? 0 : (coords.x > kProbeCounts.x - 1 ? kProbeCounts.x - 1 : coords.x);
+		coords.y = coords.y < 0 ? 0 : (coords.y > kProbeCounts.y - 1 ? kProbeCounts.y - 1 : coords.y);
+		coords.z = coords.z < 0 ? 0 : (coords.z > kProbeCounts.z - 1 ? kProbeCounts.z - 1 : coords.z);
+
+		return coords;
+	}
+
+	//UVs in the irradiance or distance atlas, kOctCoords are in [-1, 1]
+	static DirectX::XMFLOAT2 GetAtlasCoords(int iProbeIndex, const DirectX::XMFLOAT2& kOctCoords, int iNumTexels, const DirectX::XMINT3& kProbeCounts, int iAtlasLayout)
+	{
+		DirectX::XMINT2 dataCoords = GetProbeDataCoords(iProbeIndex, kProbeCounts, iAtlasLayout);
+
+		DirectX::XMFLOAT2 uv;
+		uv.x = (float)(dataCoords.x * (iNumTexels + 2)) + ((iNumTexels + 2) * 0.5f) + kOctCoords.x * (iNumTexels * 0.5f);
+		uv.y = (float)(dataCoords.y * (iNumTexels + 2)) + ((iNumTexels + 2) * 0.5f) + kOctCoords.y * (iNumTexels * 0.5f);
+		uv.x /= (float)((iNumTexels + 2) * (kProbeCounts.x * kProbeCounts.y));
+		uv.y /= (float)((iNumTexels + 2) * kProbeCounts.z);
+
+		return uv;
+	}
+
+	static float GetChebyshevWeight(const DirectX::XMFLOAT2& kMoments, float fDistance)
+	{
+		if (fDistance <= kMoments.x)
+		{
+			return 1.0f;
+		}
+
+		float fVariance = fabsf(kMoments.x * kMoments.x - kMoments.y);
+		float fV = fDistance - kMoments.x;
+
+		float fChebyshevWeight = fVariance / (fV * fV + fVariance);
+
+		return fmaxf(fChebyshevWeight * fChebyshevWeight * fChebyshevWeight, 0.0f);
+	}
+
+	static DirectX::XMINT3 GetFilterNeighbourOffset(int iNeighbourIndex, int iProbeFilter)
+	{
+		if (iProbeFilter == PROBE_FILTER_6_NEIGHBOURS)
+		{
+			DirectX::XMINT3 offset = DirectX::XMINT3(0, 0, 0);
+			(&offset.x)[iNeighbourIndex >> 1] = (iNeighbourIndex & 1) == 0 ? -1 : 1;
+
+			return offset;
+		}
+
+		int iCell = iNeighbourIndex < 13 ? iNeighbourIndex : iNeighbourIndex + 1;
+
+		return DirectX::XMINT3((iCell % 3) - 1, ((iCell / 3) % 3) - 1, (iCell / 9) - 1);
+	}
+
+	//Returns true if the probe is on the plane that has just been scrolled round to the other side of the volume
+	static bool IsScrolledPlane(const DirectX::XMINT3& kProbeCoords, int iPlaneIndex, const DirectX::XMINT3& kProbeOffsets, const DirectX::XMINT3& kProbeCounts, const DirectX::XMINT3& kClearPlane)
+	{
+		const int* kpProbeCoords = &kProbeCoords.x;
+		const int* kpProbeOffsets = &kProbeOffsets.x;
+		const int* kpProbeCounts = &kProbeCounts.x;
+		const int* kpClearPlane = &kClearPlane.x;
+
+		if (kpClearPlane[iPlaneIndex] == 0)
+		{
+			return false;
+		}
+
+		int iPlane;
+
+		if (kpProbeOffsets[iPlaneIndex] > 0)
+		{
+			iPlane = (kpProbeOffsets[iPlaneIndex] % kpProbeCounts[iPlaneIndex]) - 1;
+		}
+		else
+		{
+			iPlane = (kpProbeOffsets[iPlaneIndex] % kpProbeCounts[iPlaneIndex]) + kpProbeCounts[iPlaneIndex];
+		}
+
+		return kpProbeCoords[iPlaneIndex] == iPlane;
+	}
+
+	//Number of elements the traced probe mask after the active probe list takes up, one bit per probe
+	static int GetTracedProbeMaskSize(int iNumProbes)
+	{
+		return (iNumProbes + 31) / 32;
+	}
+
+	//kpTracedProbeMask mirrors the mask after the active probe list and is only read when iTracedProbeMask is set
+	static bool WasProbeTraced(int iProbeIndex, float fProbeState, int iUseActiveProbeList, int iFullProbeUpdate, int iTracedProbeMask, const uint32_t* kpTracedProbeMask)
+	{
+		if (iUseActiveProbeList == 0)
+		{
+			return true;
+		}
+
+		//A list built on the CPU can leave out active probes that weren't scheduled or are asleep
+		if (iTracedProbeMask != 0 && kpTracedProbeMask != nullptr)
+		{
+			return (kpTracedProbeMask[iProbeIndex / 32] & (1u << (iProbeIndex & 31))) != 0;
+		}
+
+		//A list built by classification holds every active probe
+		return iFullProbeUpdate != 0 || fProbeState == PROBE_STATE_ACTIVE;
+	}
+
+	//kpProbeRayCounts mirrors the buffer at ProbeRayCountsIndex, one count per probe, and is only read with adaptive rays
+	static int GetProbeNumRays(int iProbeIndex, int iAdaptiveRays, int iRaysPerProbe, const uint32_t* kpProbeRayCounts)
+	{
+		if (iAdaptiveRays != 0 && kpProbeRayCounts != nullptr)
+		{
+			return (std::min)((int)kpProbeRayCounts[iProbeIndex], iRaysPerProbe);
+		}
+
+		return iRaysPerProbe;
+	}
+
+	//====================================================
+	//Octahedral mapping
+	//====================================================
+
+	static DirectX::XMFLOAT3 GetOctahedralDirection(const DirectX::XMFLOAT2& kCoords)
+	{
+		DirectX::XMFLOAT3 direction = DirectX::XMFLOAT3(kCoords.x, kCoords.y, 1.0f - fabsf(kCoords.x) - fabsf(kCoords.y));
+
+		if (direction.z < 0.0f)
+		{
+			DirectX::XMFLOAT2 tempDirection = DirectX::XMFLOAT2(direction.x, direction.y);
+
+			direction.x = 1.0f - fabsf(tempDirection.y);
+			direction.y = 1.0f - fabsf(tempDirection.x);
+
+			if (tempDirection.x < 0.0f)
+			{
+				direction.x *= -1.0f;
+			}
+
+			if (tempDirection.y < 0.0f)
+			{
+				direction.y *= -1.0f;
+			}
+		}
+
+		return Normalize(direction);
+	}
+
+	static DirectX::XMFLOAT2 GetNormalizedOctahedralCoords(const DirectX::XMINT2& kTexCoords, int iNumTexels)
+	{
+		DirectX::XMFLOAT2 octahedralCoords = DirectX::XMFLOAT2((float)(kTexCoords.x % iNumTexels), (float)(kTexCoords.y % iNumTexels));
+
+		octahedralCoords.x = (((octahedralCoords.x + 0.5f) / (float)iNumTexels) * 2.0f) - 1.0f;
+		octahedralCoords.y = (((octahedralCoords.y + 0.5f) / (float)iNumTexels) * 2.0f) - 1.0f;
+
+		return octahedralCoords;
+	}
+
+	static DirectX::XMFLOAT2 GetOctahedralCoords(const DirectX::XMFLOAT3& kDirection)
+	{
+		float fL1Norm = fabsf(kDirection.x) + fabsf(kDirection.y) + fabsf(kDirection.z);
+
+		DirectX::XMFLOAT2 uv = DirectX::XMFLOAT2(kDirection.x / fL1Norm, kDirection.y / fL1Norm);
+
+		if (kDirection.z < 0.0f)
+		{
+			DirectX::XMFLOAT2 tempUV = uv;
+
+			uv.x = 1.0f - fabsf(tempUV.y);
+			uv.y = 1.0f - fabsf(tempUV.x);
+
+			if (tempUV.x < 0.0f)
+			{
+				uv.x *= -1.0f;
+			}
+
+			if (tempUV.y < 0.0f)
+			{
+				uv.y *= -1.0f;
+			}
+		}
+
+		return uv;
+	}
+
+	//====================================================
+	//Ray directions
+	//====================================================
+
+	static DirectX::XMFLOAT3 GetFibonacciSpiralDirection(float fIndex, float fNumSamples)
+	{
+		const float kfPHI = sqrtf(5.0f) * 0.5f + 0.5f;
+
+		float fFrac = fIndex * (kfPHI - 1);
+		fFrac -= floorf(fFrac);
+
+		float fPhi = 2.0f * DirectX::XM_PI * fFrac;
+		float fCosTheta = 1.0f - ((2.0f * fIndex + 1.0f) / fNumSamples);
+		float fSinTheta = sqrtf(Saturate(1.0f - fCosTheta * fCosTheta));
+
+		return DirectX::XMFLOAT3(cosf(fPhi) * fSinTheta, sinf(fPhi) * fSinTheta, fCosTheta);
+	}
+
+	static DirectX::XMFLOAT3 QuaternionRotate(const DirectX::XMFLOAT3& kVec, const DirectX::XMFLOAT4& kQuat)
+	{
+		float fQuatDot = kQuat.x * kQuat.x + kQuat.y * kQuat.y + kQuat.z * kQuat.z;
+		float fVecDot = kVec.x * kQuat.x + kVec.y * kQuat.y + kVec.z * kQuat.z;
+		float fScale = kQuat.w * kQuat.w - fQuatDot;
+
+		DirectX::XMFLOAT3 cross = Cross(DirectX::XMFLOAT3(kQuat.x, kQuat.y, kQuat.z), kVec);
+
+		return DirectX::XMFLOAT3(
+			kVec.x * fScale + kQuat.x * 2.0f * fVecDot + cross.x * kQuat.w * 2.0f,
+			kVec.y * fScale + kQuat.y * 2.0f * fVecDot + cross.y * kQuat.w * 2.0f,
+			kVec.z * fScale + kQuat.z * 2.0f * fVecDot + cross.z * kQuat.w * 2.0f);
+	}
+
+	static DirectX::XMFLOAT4 QuaternionConjugate(const DirectX::XMFLOAT4& kQuat)
+	{
+		return DirectX::XMFLOAT4(-kQuat.x, -kQuat.y, -kQuat.z, kQuat.w);
+	}
+
+	//Rotating by the result is the same as rotating by kQuatB then by kQuatA
+	static DirectX::XMFLOAT4 QuaternionMultiply(const DirectX::XMFLOAT4& kQuatA, const DirectX::XMFLOAT4& kQuatB)
+	{
+		DirectX::XMFLOAT3 cross = Cross(DirectX::XMFLOAT3(kQuatA.x, kQuatA.y, kQuatA.z), DirectX::XMFLOAT3(kQuatB.x, kQuatB.y, kQuatB.z));
+
+		return DirectX::XMFLOAT4(
+			kQuatA.w * kQuatB.x + kQuatB.w * kQuatA.x + cross.x,
+			kQuatA.w * kQuatB.y + kQuatB.w * kQuatA.y + cross.y,
+			kQuatA.w * kQuatB.z + kQuatB.w * kQuatA.z + cross.z,
+			kQuatA.w * kQuatB.w - (kQuatA.x * kQuatB.x + kQuatA.y * kQuatB.y + kQuatA.z * kQuatB.z));
+	}
+
+	static DirectX::XMFLOAT4 GetProbeRaySpin(int iProbeIndex)
+	{
+		float fFraction = (((uint32_t)iProbeIndex * 2654435769u) >> 8) * (1.0f / 16777216.0f);
+		float fHalfAngle = fFraction * DirectX::XM_PI;
+
+		return DirectX::XMFLOAT4(0.0f, 0.0f, -sinf(fHalfAngle), cosf(fHalfAngle));
+	}
+
+	static DirectX::XMFLOAT4 GetProbeRayRotation(int iProbeIndex, const DirectX::XMFLOAT4& kRayRotation, int iPerProbeRotation)
+	{
+		if (iPerProbeRotation == 0)
+		{
+			return kRayRotation;
+		}
+
+		return QuaternionMultiply(kRayRotation, GetProbeRaySpin(iProbeIndex));
+	}
+
+	static DirectX::XMFLOAT3 GetTableRayDirection(const DirectX::XMFLOAT4& kTableDirection, int iProbeIndex, int iPerProbeRotation)
+	{
+		DirectX::XMFLOAT3 direction = DirectX::XMFLOAT3(kTableDirection.x, kTableDirection.y, kTableDirection.z);
+
+		if (iPerProbeRotation == 0)
+		{
+			return direction;
+		}
+
+		return QuaternionRotate(direction, QuaternionConjugate(GetProbeRaySpin(iProbeIndex)));
+	}
+
+	static DirectX::XMFLOAT3 GetRayDirection(int iRayIndex, int iRaysPerProbe, const DirectX::XMFLOAT4& kRotationQuat)
+	{
+		DirectX::XMFLOAT3 direction = GetFibonacciSpiralDirection((float)iRayIndex, (float)iRaysPerProbe);
+
+		return Normalize(QuaternionRotate(direction, QuaternionConjugate(kRotationQuat)));
+	}
+
+	//====================================================
+	//Adaptive hysteresis
+	//====================================================
+
+	static float GetLuminance(const DirectX::XMFLOAT3& kColour)
+	{
+		return kColour.x * 0.2126f + kColour.y * 0.7152f + kColour.z * 0.0722f;
+	}
+
+	static float GetProbeIrradianceChange(float fLuminance, float fPreviousLuminance, int iNumTexels)
+	{
+		return fabsf(fLuminance - fPreviousLuminance) / (fmaxf(fLuminance, fPreviousLuminance) + iNumTexels * (1.0f / 1024.0f));
+	}
+
+	//Same as UpdateProbeHysteresis in Shaders/ProbeHelper.hlsl, x is the hysteresis and y the smoothed change
+	static DirectX::XMFLOAT2 UpdateProbeHysteresis(const DirectX::XMFLOAT2& kState, float fChange, float fMinHysteresis, float fMaxHysteresis, float fRiseRate, float fChangeThreshold)
+	{
+		float fHysteresis = fmaxf(kState.x, fMinHysteresis);
+
+		if (fChange > fChangeThreshold)
+		{
+			fHysteresis = fMinHysteresis;
+		}
+		else
+		{
+			fHysteresis = Lerp(fHysteresis, fMaxHysteresis, fRiseRate * (1.0f - fChange / fChangeThreshold));
+		}
+
+		return DirectX::XMFLOAT2(fHysteresis, Lerp(fChange, kState.y, 0.9f));
+	}
+
+	//1 once the probe's smoothed change has died away, 0 while it is changing by the threshold or more each frame
+	static float GetProbeConvergence(const DirectX::XMFLOAT2& kState, float fChangeThreshold)
+	{
+		return 1.0f - Saturate(kState.y / fChangeThreshold);
+	}
+
+	//Roughly how much the probe's blended irradiance moves each frame, its smoothed change is between a single frame and
+	//the history so only the part the hysteresis lets through reaches the atlas
+	static float GetProbeBlendedChange(const DirectX::XMFLOAT2& kState)
+	{
+		return (1.0f - kState.x) * kState.y;
+	}
+
+	//====================================================
+	//Ray data packing
+	//====================================================
+
+	static uint32_t FloatToUint(float fVal, float fScale)
+	{
+		return (uint32_t)floorf(fVal * fScale + 0.5f);
+	}
+
+	static uint32_t Float3ToUint(const DirectX::XMFLOAT3& kInput)
+	{
+		return FloatToUint(kInput.x, 1023.0f) | (FloatToUint(kInput.y, 1023.0f) << 10) | (FloatToUint(kInput.z, 1023.0f) << 20);
+	}
+
+	static DirectX::XMFLOAT3 UintToFloat3(uint32_t uiInput)
+	{
+		return DirectX::XMFLOAT3(
+			(float)(uiInput & 0x000003FF) / 1023.0f,
+			(float)((uiInput >> 10) & 0x000003FF) / 1023.0f,
+			(float)((uiInput >> 20) & 0x000003FF) / 1023.0f);
+	}
+
+	static uint32_t Float3ToRGB9E5(const DirectX::XMFLOAT3& kInput)
+	{
+		DirectX::XMFLOAT3 clamped = DirectX::XMFLOAT3(fminf(fmaxf(kInput.x, 0.0f), RGB9E5_MAX), fminf(fmaxf(kInput.y, 0.0f), RGB9E5_MAX), fminf(fmaxf(kInput.z, 0.0f), RGB9E5_MAX));
+		float fMaxChannel = fmaxf(clamped.x, fmaxf(clamped.y, clamped.z));
+
+		//Floor of log2 comes straight from the float's exponent
+		int iSharedExponent = (int)(AsUint(fMaxChannel) >> 23) - 127 + 16;
+		iSharedExponent = iSharedExponent < 1 ? 1 : (iSharedExponent > 30 ? 30 : iSharedExponent);
+
+		//2 ^ (mantissa bits + bias - shared exponent)
+		float fScale = AsFloat((uint32_t)(127 + 24 - iSharedExponent) << 23);
+
+		if (FloatToUint(fMaxChannel, fScale) == 512)
+		{
+			++iSharedExponent;
+			fScale *= 0.5f;
+		}
+
+		return FloatToUint(clamped.x, fScale) | (FloatToUint(clamped.y, fScale) << 9) | (FloatToUint(clamped.z, fScale) << 18) | ((uint32_t)iSharedExponent << 27);
+	}
+
+	static DirectX::XMFLOAT3 RGB9E5ToFloat3(uint32_t uiInput)
+	{
+		float fScale = AsFloat(((uiInput >> 27) + 127 - 24) << 23);
+
+		return DirectX::XMFLOAT3(
+			(float)(uiInput & 0x000001FF) * fScale,
+			(float)((uiInput >> 9) & 0x000001FF) * fScale,
+			(float)((uiInput >> 18) & 0x000001FF) * fScale);
+	}
+
+	static uint32_t FloatToUnsignedFloat(float fInput, uint32_t uiMantissaBits, float fMaxValue)
+	{
+		uint32_t uiBits = AsUint(fminf(fmaxf(fInput, 0.0f), fMaxValue));
+
+		if (uiBits < AsUint(R11G11B10_MIN))
+		{
+			return 0;
+		}
+
+		uiBits += 1u << (22 - uiMantissaBits);
+
+		return (uiBits >> (23 - uiMantissaBits)) - ((127u - 15u) << uiMantissaBits);
+	}
+
+	static float UnsignedFloatToFloat(uint32_t uiInput, uint32_t uiMantissaBits)
+	{
+		if (uiInput < (1u << uiMantissaBits))
+		{
+			return 0.0f;
+		}
+
+		return AsFloat((uiInput + ((127u - 15u) << uiMantissaBits)) << (23 - uiMantissaBits));
+	}
+
+	static uint32_t Float3ToR11G11B10(const DirectX::XMFLOAT3& kInput)
+	{
+		return FloatToUnsignedFloat(kInput.x, 6, R11G11B10_R_MAX) | (FloatToUnsignedFloat(kInput.y, 6, R11G11B10_R_MAX) << 11) | (FloatToUnsignedFloat(kInput.z, 5, R11G11B10_B_MAX) << 22);
+	}
+
+	static DirectX::XMFLOAT3 R11G11B10ToFloat3(uint32_t uiInput)
+	{
+		return DirectX::XMFLOAT3(UnsignedFloatToFloat(uiInput & 0x000007FF, 6), UnsignedFloatToFloat((uiInput >> 11) & 0x000007FF, 6), UnsignedFloatToFloat(uiInput >> 22, 5));
+	}
+
+	static float PackRayRadiance(DirectX::XMFLOAT3 radiance, int iRayDataFormat)
+	{
+		uint32_t uiPacked;
+
+		if (iRayDataFormat == FORMAT_PROBE_RAY_DATA_RGB9E5)
+		{
+			uiPacked = Float3ToRGB9E5(radiance);
+		}
+		else
+		{
+			radiance.z = fmaxf(radiance.z, R11G11B10_MIN);
+
+			uiPacked = Float3ToR11G11B10(radiance);
+		}
+
+		return AsFloat((uiPacked >> 4) | (uiPacked << 28));
+	}
+
+	static DirectX::XMFLOAT3 UnpackRayRadiance(float fPackedRadiance, int iRayDataFormat)
+	{
+		uint32_t uiPacked = AsUint(fPackedRadiance);
+		uiPacked = (uiPacked << 4) | (uiPacked >> 28);
+
+		if (iRayDataFormat == FORMAT_PROBE_RAY_DATA_RGB9E5)
+		{
+			return RGB9E5ToFloat3(uiPacked);
+		}
+		else
+		{
+			return R11G11B10ToFloat3(uiPacked);
+		}
+	}
+
+	static DirectX::XMFLOAT3 GetRayRadiance(const DirectX::XMFLOAT4& kTexel, int iRayDataFormat)
+	{
+		if (iRayDataFormat == FORMAT_PROBE_RAY_DATA_R32G32B32A32_FLOAT)
+		{
+			return DirectX::XMFLOAT3(kTexel.x, kTexel.y, kTexel.z);
+		}
+		else if (iRayDataFormat == FORMAT_PROBE_RAY_DATA_R32G32_FLOAT)
+		{
+			return UintToFloat3((uint32_t)kTexel.x);
+		}
+		else
+		{
+			return UnpackRayRadiance(kTexel.x, iRayDataFormat);
+		}
+	}
+
+	static float GetRayDistance(const DirectX::XMFLOAT4& kTexel, int iRayDataFormat)
+	{
+		return iRayDataFormat == FORMAT_PROBE_RAY_DATA_R32G32B32A32_FLOAT ? kTexel.w : kTexel.y;
+	}
+
+	//====================================================
+	//Small HLSL intrinsics
+	//====================================================
+
+	static uint32_t AsUint(float fValue)
+	{
+		uint32_t uiValue;
+		memcpy(&uiValue, &fValue, sizeof(float));
+
+		return uiValue;
+	}
+
+	static float AsFloat(uint32_t uiValue)
+	{
+		float fValue;
+		memcpy(&fValue, &uiValue, sizeof(float));
+
+		return fValue;
+	}
+
+	static float Saturate(float fValue)
+	{
+		return fValue < 0.0f ? 0.0f : (fValue > 1.0f ? 1.0f : fValue);
+	}
+
+	static float Lerp(float fA, float fB, float fT)
+	{
+		return fA + (fB - fA) * fT;
+	}
+
+	static float Sign(float fValue)
+	{
+		return (float)((fValue > 0.0f) - (fValue < 0.0f));
+	}
+
+	static DirectX::XMFLOAT3 Cross(const DirectX::XMFLOAT3& kA, const DirectX::XMFLOAT3& kB)
+	{
+		return DirectX::XMFLOAT3(kA.y * kB.z - kA.z * kB.y, kA.z * kB.x - kA.x * kB.z, kA.x * kB.y - kA.y * kB.x);
+	}
+
+	static DirectX::XMFLOAT3 Normalize(const DirectX::XMFLOAT3& kVec)
+	{
+		float fInvLength = 1.0f / sqrtf(kVec.x * kVec.x + kVec.y * kVec.y + kVec.z * kVec.z);
+
+		return DirectX::XMFLOAT3(kVec.x * fInvLength, kVec.y * fInvLength, kVec.z * fInvLength);
+	}
+};
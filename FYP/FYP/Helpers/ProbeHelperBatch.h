@@ -0,0 +1,518 @@
+#pragma once
+
+#include "Helpers/ProbeHelper.h"
+
+#include <DirectXMath.h>
+
+//The AVX2 kernels are compiled into every x64 build without needing /arch:AVX2 for the whole project, and only run
+//when the CPU has AVX2. GCC and Clang have to be told per function which instructions they can use.
+#if defined(_M_X64) || defined(__x86_64__)
+#define PROBE_HELPER_BATCH_AVX2
+
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+
+#define PROBE_HELPER_BATCH_TARGET
+#else
+#define PROBE_HELPER_BATCH_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+//Batch versions of the probe indexing and octahedral functions in ProbeHelper, working on structure of arrays input so
+//tools can address whole atlases at once. On CPUs with AVX2 eight values are done at a time, anything left over (or
+//everything, without AVX2) goes through ProbeHelper so the results are the same either way. Nothing here uses FMA and
+//the kernels don't need the rest of the project built with /arch:AVX2, so the vector and scalar paths round the same.
+//
+//Integer inputs have to be below 2^24 in magnitude, the divides go through a float reciprocal and are then corrected.
+class ProbeHelperBatch
+{
+public:
+	//====================================================
+	//Probe indexing
+	//====================================================
+
+	static void GetProbeCoords(const int* kpProbeIndices, int iCount, const DirectX::XMINT3& kProbeCounts, int* pCoordsX, int* pCoordsY, int* pCoordsZ)
+	{
+		int i = 0;
+
+#if defined(PROBE_HELPER_BATCH_AVX2)
+		if (IsAVX2Enabled() == true)
+		{
+			i = GetProbeCoordsAVX2(kpProbeIndices, iCount, kProbeCounts, pCoordsX, pCoordsY, pCoordsZ);
+		}
+#endif
+
+		for (; i < iCount; ++i)
+		{
+			DirectX::XMINT3 coords = ProbeHelper::GetProbeCoords(kpProbeIndices[i], kProbeCounts);
+
+			pCoordsX[i] = coords.x;
+			pCoordsY[i] = coords.y;
+			pCoordsZ[i] = coords.z;
+		}
+	}
+
+	static void GetProbeIndex(const int* kpCoordsX, const int* kpCoordsY, const int* kpCoordsZ, int iCount, const DirectX::XMINT3& kProbeCounts, int* pProbeIndices)
+	{
+		int i = 0;
+
+#if defined(PROBE_HELPER_BATCH_AVX2)
+		if (IsAVX2Enabled() == true)
+		{
+			i = GetProbeIndexAVX2(kpCoordsX, kpCoordsY, kpCoordsZ, iCount, kProbeCounts, pProbeIndices);
+		}
+#endif
+
+		for (; i < iCount; ++i)
+		{
+			pProbeIndices[i] = ProbeHelper::GetProbeIndex(DirectX::XMINT3(kpCoordsX[i], kpCoordsY[i], kpCoordsZ[i]), kProbeCounts);
+		}
+	}
+
+	//Probe index of atlas texels, as used by the blending dispatches. Only the plane layout is vectorised.
+	static void GetProbeIndex(const int* kpTexCoordsX, const int* kpTexCoordsY, int iCount, int iNumTexels, const DirectX::XMINT3& kProbeCounts, int iAtlasLayout, int* pProbeIndices)
+	{
+		int i = 0;
+
+#if defined(PROBE_HELPER_BATCH_AVX2)
+		if (IsAVX2Enabled() == true && iAtlasLayout == PROBE_ATLAS_LAYOUT_PLANES)
+		{
+			i = GetPlaneProbeIndexAVX2(kpTexCoordsX, kpTexCoordsY, iCount, iNumTexels, kProbeCounts, pProbeIndices);
+		}
+#endif
+
+		for (; i < iCount; ++i)
+		{
+			pProbeIndices[i] = ProbeHelper::GetProbeIndex(DirectX::XMINT2(kpTexCoordsX[i], kpTexCoordsY[i]), iNumTexels, kProbeCounts, iAtlasLayout);
+		}
+	}
+
+	static void GetOffsettedProbeIndex(const int* kpCoordsX, const int* kpCoordsY, const int* kpCoordsZ, int iCount, const DirectX::XMINT3& kProbeCounts, const DirectX::XMINT3& kProbeOffsets, int* pProbeIndices)
+	{
+		int i = 0;
+
+#if defined(PROBE_HELPER_BATCH_AVX2)
+		if (IsAVX2Enabled() == true)
+		{
+			i = GetOffsettedProbeIndexAVX2(kpCoordsX, kpCoordsY, kpCoordsZ, iCount, kProbeCounts, kProbeOffsets, pProbeIndices);
+		}
+#endif
+
+		for (; i < iCount; ++i)
+		{
+			pProbeIndices[i] = ProbeHelper::GetOffsettedProbeIndex(DirectX::XMINT3(kpCoordsX[i], kpCoordsY[i], kpCoordsZ[i]), kProbeCounts, kProbeOffsets);
+		}
+	}
+
+	//UVs in the irradiance or distance atlas, octahedral coords are in [-1, 1]. Only the plane layout is vectorised.
+	static void GetAtlasCoords(const int* kpProbeIndices, const float* kpOctCoordsX, const float* kpOctCoordsY, int iCount, int iNumTexels, const DirectX::XMINT3& kProbeCounts, int iAtlasLayout, float* pU, float* pV)
+	{
+		int i = 0;
+
+#if defined(PROBE_HELPER_BATCH_AVX2)
+		if (IsAVX2Enabled() == true && iAtlasLayout == PROBE_ATLAS_LAYOUT_PLANES)
+		{
+			i = GetPlaneAtlasCoordsAVX2(kpProbeIndices, kpOctCoordsX, kpOctCoordsY, iCount, iNumTexels, kProbeCounts, pU, pV);
+		}
+#endif
+
+		for (; i < iCount; ++i)
+		{
+			DirectX::XMFLOAT2 uv = ProbeHelper::GetAtlasCoords(kpProbeIndices[i], DirectX::XMFLOAT2(kpOctCoordsX[i], kpOctCoordsY[i]), iNumTexels, kProbeCounts, iAtlasLayout);
+
+			pU[i] = uv.x;
+			pV[i] = uv.y;
+		}
+	}
+
+	//====================================================
+	//Octahedral mapping
+	//====================================================
+
+	static void GetOctahedralCoords(const float* kpDirectionsX, const float* kpDirectionsY, const float* kpDirectionsZ, int iCount, float* pOctCoordsX, float* pOctCoordsY)
+	{
+		int i = 0;
+
+#if defined(PROBE_HELPER_BATCH_AVX2)
+		if (IsAVX2Enabled() == true)
+		{
+			i = GetOctahedralCoordsAVX2(kpDirectionsX, kpDirectionsY, kpDirectionsZ, iCount, pOctCoordsX, pOctCoordsY);
+		}
+#endif
+
+		for (; i < iCount; ++i)
+		{
+			DirectX::XMFLOAT2 octCoords = ProbeHelper::GetOctahedralCoords(DirectX::XMFLOAT3(kpDirectionsX[i], kpDirectionsY[i], kpDirectionsZ[i]));
+
+			pOctCoordsX[i] = octCoords.x;
+			pOctCoordsY[i] = octCoords.y;
+		}
+	}
+
+	static void GetOctahedralDirection(const float* kpOctCoordsX, const float* kpOctCoordsY, int iCount, float* pDirectionsX, float* pDirectionsY, float* pDirectionsZ)
+	{
+		int i = 0;
+
+#if defined(PROBE_HELPER_BATCH_AVX2)
+		if (IsAVX2Enabled() == true)
+		{
+			i = GetOctahedralDirectionAVX2(kpOctCoordsX, kpOctCoordsY, iCount, pDirectionsX, pDirectionsY, pDirectionsZ);
+		}
+#endif
+
+		for (; i < iCount; ++i)
+		{
+			DirectX::XMFLOAT3 direction = ProbeHelper::GetOctahedralDirection(DirectX::XMFLOAT2(kpOctCoordsX[i], kpOctCoordsY[i]));
+
+			pDirectionsX[i] = direction.x;
+			pDirectionsY[i] = direction.y;
+			pDirectionsZ[i] = direction.z;
+		}
+	}
+
+	//====================================================
+	//Dispatch
+	//====================================================
+
+	//True when the CPU and OS support AVX2, worked out once on first use
+	static bool IsAVX2Supported()
+	{
+		static const bool kbSupported = CheckAVX2();
+
+		return kbSupported;
+	}
+
+	static bool IsAVX2Enabled()
+	{
+		return IsAVX2Supported() == true && AVX2Allowed() == true;
+	}
+
+	//Lets the tests and benchmarks force the scalar path to compare the two
+	static void SetAVX2Allowed(bool bAllowed)
+	{
+		AVX2Allowed() = bAllowed;
+	}
+
+protected:
+
+private:
+	static bool& AVX2Allowed()
+	{
+		static bool s_bAllowed = true;
+
+		return s_bAllowed;
+	}
+
+	static bool CheckAVX2()
+	{
+#if defined(PROBE_HELPER_BATCH_AVX2) && defined(_MSC_VER)
+		int cpuInfo[4];
+
+		__cpuid(cpuInfo, 0);
+
+		if (cpuInfo[0] < 7)
+		{
+			return false;
+		}
+
+		//The OS has to save the YMM registers as well as the CPU having the instructions
+		__cpuid(cpuInfo, 1);
+
+		bool bOSXSave = (cpuInfo[2] & (1 << 27)) != 0;
+		bool bAVX = (cpuInfo[2] & (1 << 28)) != 0;
+
+		if (bOSXSave == false || bAVX == false || (_xgetbv(0) & 6) != 6)
+		{
+			return false;
+		}
+
+		__cpuidex(cpuInfo, 7, 0);
+
+		return (cpuInfo[1] & (1 << 5)) != 0;
+#elif defined(PROBE_HELPER_BATCH_AVX2)
+		__builtin_cpu_init();
+
+		return __builtin_cpu_supports("avx2") != 0;
+#else
+		return false;
+#endif
+	}
+
+#if defined(PROBE_HELPER_BATCH_AVX2)
+	//====================================================
+	//AVX2 kernels, each returns how many values it did
+	//====================================================
+
+	PROBE_HELPER_BATCH_TARGET static int GetProbeCoordsAVX2(const int* kpProbeIndices, int iCount, const DirectX::XMINT3& kProbeCounts, int* pCoordsX, int* pCoordsY, int* pCoordsZ)
+	{
+		const Divisor kCountX = Divisor(kProbeCounts.x);
+		const Divisor kCountZ = Divisor(kProbeCounts.z);
+		const Divisor kPlaneSize = Divisor(kProbeCounts.x * kProbeCounts.z);
+
+		int i = 0;
+
+		for (; i + 8 <= iCount; i += 8)
+		{
+			__m256i probeIndex = Load(kpProbeIndices + i);
+
+			__m256i row;
+			__m256i x = Remainder(probeIndex, kCountX, row);
+
+			__m256i y = Divide(probeIndex, kPlaneSize);
+
+			__m256i unused;
+			__m256i z = Remainder(row, kCountZ, unused);
+
+			Store(pCoordsX + i, x);
+			Store(pCoordsY + i, y);
+			Store(pCoordsZ + i, z);
+		}
+
+		return i;
+	}
+
+	PROBE_HELPER_BATCH_TARGET static int GetProbeIndexAVX2(const int* kpCoordsX, const int* kpCoordsY, const int* kpCoordsZ, int iCount, const DirectX::XMINT3& kProbeCounts, int* pProbeIndices)
+	{
+		const __m256i kCountX = _mm256_set1_epi32(kProbeCounts.x);
+		const __m256i kPlaneSize = _mm256_set1_epi32(kProbeCounts.x * kProbeCounts.z);
+
+		int i = 0;
+
+		for (; i + 8 <= iCount; i += 8)
+		{
+			__m256i probeIndex = _mm256_mullo_epi32(kPlaneSize, Load(kpCoordsY + i));
+			probeIndex = _mm256_add_epi32(probeIndex, Load(kpCoordsX + i));
+			probeIndex = _mm256_add_epi32(probeIndex, _mm256_mullo_epi32(kCountX, Load(kpCoordsZ + i)));
+
+			Store(pProbeIndices + i, probeIndex);
+		}
+
+		return i;
+	}
+
+	PROBE_HELPER_BATCH_TARGET static int GetPlaneProbeIndexAVX2(const int* kpTexCoordsX, const int* kpTexCoordsY, int iCount, int iNumTexels, const DirectX::XMINT3& kProbeCounts, int* pProbeIndices)
+	{
+		const Divisor kPlaneWidth = Divisor(iNumTexels * kProbeCounts.x);
+		const Divisor kNumTexels = Divisor(iNumTexels);
+		const __m256i kCountX = _mm256_set1_epi32(kProbeCounts.x);
+		const __m256i kPlaneSize = _mm256_set1_epi32(kProbeCounts.x * kProbeCounts.z);
+
+		int i = 0;
+
+		for (; i + 8 <= iCount; i += 8)
+		{
+			__m256i texCoordsX = Load(kpTexCoordsX + i);
+
+			__m256i planeIndex = Divide(texCoordsX, kPlaneWidth);
+
+			__m256i probeIndex = _mm256_sub_epi32(Divide(texCoordsX, kNumTexels), _mm256_mullo_epi32(planeIndex, kCountX));
+			probeIndex = _mm256_add_epi32(probeIndex, _mm256_mullo_epi32(kCountX, Divide(Load(kpTexCoordsY + i), kNumTexels)));
+
+			Store(pProbeIndices + i, _mm256_add_epi32(_mm256_mullo_epi32(kPlaneSize, planeIndex), probeIndex));
+		}
+
+		return i;
+	}
+
+	PROBE_HELPER_BATCH_TARGET static int GetOffsettedProbeIndexAVX2(const int* kpCoordsX, const int* kpCoordsY, const int* kpCoordsZ, int iCount, const DirectX::XMINT3& kProbeCounts, const DirectX::XMINT3& kProbeOffsets, int* pProbeIndices)
+	{
+		const Divisor kCountX = Divisor(kProbeCounts.x);
+		const Divisor kCountY = Divisor(kProbeCounts.y);
+		const Divisor kCountZ = Divisor(kProbeCounts.z);
+		const __m256i kShiftX = _mm256_set1_epi32(kProbeOffsets.x + kProbeCounts.x);
+		const __m256i kShiftY = _mm256_set1_epi32(kProbeOffsets.y + kProbeCounts.y);
+		const __m256i kShiftZ = _mm256_set1_epi32(kProbeOffsets.z + kProbeCounts.z);
+		const __m256i kPlaneSize = _mm256_set1_epi32(kProbeCounts.x * kProbeCounts.z);
+		const __m256i kRowSize = _mm256_set1_epi32(kProbeCounts.x);
+
+		int i = 0;
+
+		for (; i + 8 <= iCount; i += 8)
+		{
+			__m256i unused;
+			__m256i x = Remainder(_mm256_add_epi32(Load(kpCoordsX + i), kShiftX), kCountX, unused);
+			__m256i y = Remainder(_mm256_add_epi32(Load(kpCoordsY + i), kShiftY), kCountY, unused);
+			__m256i z = Remainder(_mm256_add_epi32(Load(kpCoordsZ + i), kShiftZ), kCountZ, unused);
+
+			__m256i probeIndex = _mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(kPlaneSize, y), x), _mm256_mullo_epi32(kRowSize, z));
+
+			Store(pProbeIndices + i, probeIndex);
+		}
+
+		return i;
+	}
+
+	PROBE_HELPER_BATCH_TARGET static int GetPlaneAtlasCoordsAVX2(const int* kpProbeIndices, const float* kpOctCoordsX, const float* kpOctCoordsY, int iCount, int iNumTexels, const DirectX::XMINT3& kProbeCounts, float* pU, float* pV)
+	{
+		const Divisor kCountX = Divisor(kProbeCounts.x);
+		const Divisor kCountZ = Divisor(kProbeCounts.z);
+		const Divisor kPlaneSize = Divisor(kProbeCounts.x * kProbeCounts.z);
+		const __m256i kRowSize = _mm256_set1_epi32(kProbeCounts.x);
+		const __m256i kTileSize = _mm256_set1_epi32(iNumTexels + 2);
+		const __m256 kHalfTile = _mm256_set1_ps((iNumTexels + 2) * 0.5f);
+		const __m256 kHalfInterior = _mm256_set1_ps(iNumTexels * 0.5f);
+		const __m256 kWidth = _mm256_set1_ps((float)((iNumTexels + 2) * (kProbeCounts.x * kProbeCounts.y)));
+		const __m256 kHeight = _mm256_set1_ps((float)((iNumTexels + 2) * kProbeCounts.z));
+
+		int i = 0;
+
+		for (; i + 8 <= iCount; i += 8)
+		{
+			__m256i probeIndex = Load(kpProbeIndices + i);
+
+			__m256i row;
+			__m256i dataX = Remainder(probeIndex, kCountX, row);
+			dataX = _mm256_add_epi32(dataX, _mm256_mullo_epi32(Divide(probeIndex, kPlaneSize), kRowSize));
+
+			__m256i unused;
+			__m256i dataY = Remainder(row, kCountZ, unused);
+
+			__m256 u = _mm256_add_ps(_mm256_cvtepi32_ps(_mm256_mullo_epi32(dataX, kTileSize)), kHalfTile);
+			u = _mm256_add_ps(u, _mm256_mul_ps(_mm256_loadu_ps(kpOctCoordsX + i), kHalfInterior));
+
+			__m256 v = _mm256_add_ps(_mm256_cvtepi32_ps(_mm256_mullo_epi32(dataY, kTileSize)), kHalfTile);
+			v = _mm256_add_ps(v, _mm256_mul_ps(_mm256_loadu_ps(kpOctCoordsY + i), kHalfInterior));
+
+			_mm256_storeu_ps(pU + i, _mm256_div_ps(u, kWidth));
+			_mm256_storeu_ps(pV + i, _mm256_div_ps(v, kHeight));
+		}
+
+		return i;
+	}
+
+	PROBE_HELPER_BATCH_TARGET static int GetOctahedralCoordsAVX2(const float* kpDirectionsX, const float* kpDirectionsY, const float* kpDirectionsZ, int iCount, float* pOctCoordsX, float* pOctCoordsY)
+	{
+		const __m256 kZero = _mm256_setzero_ps();
+		const __m256 kOne = _mm256_set1_ps(1.0f);
+
+		int i = 0;
+
+		for (; i + 8 <= iCount; i += 8)
+		{
+			__m256 x = _mm256_loadu_ps(kpDirectionsX + i);
+			__m256 y = _mm256_loadu_ps(kpDirectionsY + i);
+			__m256 z = _mm256_loadu_ps(kpDirectionsZ + i);
+
+			__m256 l1Norm = _mm256_add_ps(_mm256_add_ps(Abs(x), Abs(y)), Abs(z));
+
+			__m256 u = _mm256_div_ps(x, l1Norm);
+			__m256 v = _mm256_div_ps(y, l1Norm);
+
+			//Lower hemisphere is folded out onto the corners
+			__m256 foldedU = FlipSign(_mm256_sub_ps(kOne, Abs(v)), _mm256_cmp_ps(u, kZero, _CMP_LT_OQ));
+			__m256 foldedV = FlipSign(_mm256_sub_ps(kOne, Abs(u)), _mm256_cmp_ps(v, kZero, _CMP_LT_OQ));
+
+			__m256 lower = _mm256_cmp_ps(z, kZero, _CMP_LT_OQ);
+
+			_mm256_storeu_ps(pOctCoordsX + i, _mm256_blendv_ps(u, foldedU, lower));
+			_mm256_storeu_ps(pOctCoordsY + i, _mm256_blendv_ps(v, foldedV, lower));
+		}
+
+		return i;
+	}
+
+	PROBE_HELPER_BATCH_TARGET static int GetOctahedralDirectionAVX2(const float* kpOctCoordsX, const float* kpOctCoordsY, int iCount, float* pDirectionsX, float* pDirectionsY, float* pDirectionsZ)
+	{
+		const __m256 kZero = _mm256_setzero_ps();
+		const __m256 kOne = _mm256_set1_ps(1.0f);
+
+		int i = 0;
+
+		for (; i + 8 <= iCount; i += 8)
+		{
+			__m256 u = _mm256_loadu_ps(kpOctCoordsX + i);
+			__m256 v = _mm256_loadu_ps(kpOctCoordsY + i);
+
+			__m256 z = _mm256_sub_ps(_mm256_sub_ps(kOne, Abs(u)), Abs(v));
+
+			__m256 foldedX = FlipSign(_mm256_sub_ps(kOne, Abs(v)), _mm256_cmp_ps(u, kZero, _CMP_LT_OQ));
+			__m256 foldedY = FlipSign(_mm256_sub_ps(kOne, Abs(u)), _mm256_cmp_ps(v, kZero, _CMP_LT_OQ));
+
+			__m256 lower = _mm256_cmp_ps(z, kZero, _CMP_LT_OQ);
+
+			__m256 x = _mm256_blendv_ps(u, foldedX, lower);
+			__m256 y = _mm256_blendv_ps(v, foldedY, lower);
+
+			//Same order as ProbeHelper::Normalize
+			__m256 lengthSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z));
+			__m256 invLength = _mm256_div_ps(kOne, _mm256_sqrt_ps(lengthSquared));
+
+			_mm256_storeu_ps(pDirectionsX + i, _mm256_mul_ps(x, invLength));
+			_mm256_storeu_ps(pDirectionsY + i, _mm256_mul_ps(y, invLength));
+			_mm256_storeu_ps(pDirectionsZ + i, _mm256_mul_ps(z, invLength));
+		}
+
+		return i;
+	}
+
+	//====================================================
+	//AVX2 helpers
+	//====================================================
+
+	struct Divisor
+	{
+		PROBE_HELPER_BATCH_TARGET Divisor(int iValue)
+		{
+			Value = _mm256_set1_epi32(iValue);
+			NegativeValue = _mm256_set1_epi32(-iValue);
+			Reciprocal = _mm256_set1_ps(1.0f / iValue);
+		}
+
+		__m256i Value;
+		__m256i NegativeValue;
+		__m256 Reciprocal;
+	};
+
+	PROBE_HELPER_BATCH_TARGET static __m256i Load(const int* kpValues)
+	{
+		return _mm256_loadu_si256((const __m256i*)kpValues);
+	}
+
+	PROBE_HELPER_BATCH_TARGET static void Store(int* pValues, __m256i values)
+	{
+		_mm256_storeu_si256((__m256i*)pValues, values);
+	}
+
+	//Rounds towards zero like integer division in C++ and HLSL
+	PROBE_HELPER_BATCH_TARGET static __m256i Divide(__m256i dividend, const Divisor& kDivisor)
+	{
+		__m256i quotient;
+		Remainder(dividend, kDivisor, quotient);
+
+		return quotient;
+	}
+
+	//Remainder with the same sign as the dividend like the % operator, also gives back the quotient
+	PROBE_HELPER_BATCH_TARGET static __m256i Remainder(__m256i dividend, const Divisor& kDivisor, __m256i& quotient)
+	{
+		const __m256i kZero = _mm256_setzero_si256();
+
+		//The estimate is at most one out either way for dividends below 2^24
+		quotient = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(dividend), kDivisor.Reciprocal));
+
+		__m256i remainder = _mm256_sub_epi32(dividend, _mm256_mullo_epi32(quotient, kDivisor.Value));
+
+		__m256i negative = _mm256_cmpgt_epi32(kZero, dividend);
+
+		//Masks are -1 so subtracting one adds to the quotient
+		__m256i tooSmall = _mm256_blendv_epi8(_mm256_cmpgt_epi32(remainder, _mm256_sub_epi32(kDivisor.Value, _mm256_set1_epi32(1))), _mm256_cmpgt_epi32(remainder, kZero), negative);
+		__m256i tooBig = _mm256_blendv_epi8(_mm256_cmpgt_epi32(kZero, remainder), _mm256_cmpgt_epi32(_mm256_add_epi32(kDivisor.NegativeValue, _mm256_set1_epi32(1)), remainder), negative);
+
+		quotient = _mm256_add_epi32(_mm256_sub_epi32(quotient, tooSmall), tooBig);
+
+		return _mm256_sub_epi32(dividend, _mm256_mullo_epi32(quotient, kDivisor.Value));
+	}
+
+	PROBE_HELPER_BATCH_TARGET static __m256 Abs(__m256 value)
+	{
+		return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), value);
+	}
+
+	PROBE_HELPER_BATCH_TARGET static __m256 FlipSign(__m256 value, __m256 mask)
+	{
+		return _mm256_xor_ps(value, _mm256_and_ps(mask, _mm256_set1_ps(-0.0f)));
+	}
+#endif
+};
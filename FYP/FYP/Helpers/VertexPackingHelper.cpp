@@ -0,0 +1,353 @@
+#include "VertexPackingHelper.h"
+#include "Helpers/ProbeHelper.h"
+#include "Shaders/Vertices.h"
+#include "Shaders/Defines.hlsli"
+
+#include <DirectXPackedVector.h>
+
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	const float s_kfRadiansToDegrees = 180.0f / 3.14159265f;
+
+	float SnormToFloat(INT16 iValue)
+	{
+		return (std::max)(iValue / 32767.0f, -1.0f);
+	}
+
+	INT16 FloatToSnorm(float fValue)
+	{
+		return (INT16)roundf((std::min)((std::max)(fValue, -1.0f), 1.0f) * 32767.0f);
+	}
+
+	float Dot(const XMFLOAT3& kA, const XMFLOAT3& kB)
+	{
+		return kA.x * kB.x + kA.y * kB.y + kA.z * kB.z;
+	}
+
+	float GetDistanceSquared(const XMFLOAT3& kA, const XMFLOAT3& kB)
+	{
+		XMFLOAT3 difference = XMFLOAT3(kA.x - kB.x, kA.y - kB.y, kA.z - kB.z);
+
+		return Dot(difference, difference);
+	}
+
+	//From the chord between the two normals, the acos of their dot product only resolves a few hundredths of a degree
+	//this close to 1 and packing loses less than that
+	float GetAngleDegrees(const XMFLOAT3& kA, const XMFLOAT3& kB)
+	{
+		return 2.0f * asinf((std::min)(sqrtf(GetDistanceSquared(kA, kB)) * 0.5f, 1.0f)) * s_kfRadiansToDegrees;
+	}
+
+	//Octahedral coordinates of a normalized direction quantized to iMaxValue steps either side of zero, or to iMaxValue
+	//steps between -1 and 1 when bUnsigned. Rounding each coordinate to nearest isn't always the closest direction once
+	//decoded so the four encodings around the exact coordinates are all tried. They're compared by distance rather than
+	//dot product, which rounds to 1 for all of them at 16 bits.
+	void QuantizeOctahedral(const XMFLOAT3& kDirection, int iMaxValue, bool bUnsigned, int& iX, int& iY)
+	{
+		XMFLOAT2 coords = ProbeHelper::GetOctahedralCoords(kDirection);
+
+		if (bUnsigned == true)
+		{
+			coords = XMFLOAT2((coords.x * 0.5f + 0.5f), (coords.y * 0.5f + 0.5f));
+		}
+
+		int iMinValue = bUnsigned == true ? 0 : -iMaxValue;
+
+		float fX = coords.x * iMaxValue;
+		float fY = coords.y * iMaxValue;
+
+		float fBestDistance = FLT_MAX;
+
+		for (int i = 0; i < 4; ++i)
+		{
+			int iCandidateX = (std::min)((std::max)((int)((i & 1) == 0 ? floorf(fX) : ceilf(fX)), iMinValue), iMaxValue);
+			int iCandidateY = (std::min)((std::max)((int)((i & 2) == 0 ? floorf(fY) : ceilf(fY)), iMinValue), iMaxValue);
+
+			XMFLOAT2 candidate = XMFLOAT2(iCandidateX / (float)iMaxValue, iCandidateY / (float)iMaxValue);
+
+			if (bUnsigned == true)
+			{
+				candidate = XMFLOAT2(candidate.x * 2.0f - 1.0f, candidate.y * 2.0f - 1.0f);
+			}
+
+			float fDistance = GetDistanceSquared(ProbeHelper::GetOctahedralDirection(candidate), kDirection);
+
+			if (fDistance < fBestDistance)
+			{
+				fBestDistance = fDistance;
+				iX = iCandidateX;
+				iY = iCandidateY;
+			}
+		}
+	}
+
+	//Zero length directions, such as the tangents of primitives without any, encode as +Z
+	XMFLOAT3 NormalizeOrZ(const XMFLOAT3& kDirection)
+	{
+		float fLength = sqrtf(Dot(kDirection, kDirection));
+
+		if (fLength == 0.0f || fLength != fLength)
+		{
+			return XMFLOAT3(0.0f, 0.0f, 1.0f);
+		}
+
+		return XMFLOAT3(kDirection.x / fLength, kDirection.y / fLength, kDirection.z / fLength);
+	}
+}
+
+UINT VertexPackingHelper::GetVertexStride(int iVertexFormat)
+{
+	switch (iVertexFormat)
+	{
+	case VERTEX_FORMAT_PACKED:
+		return sizeof(PackedVertex);
+
+	case VERTEX_FORMAT_QUANTIZED:
+		return sizeof(QuantizedVertex);
+
+	default:
+		return sizeof(Vertex);
+	}
+}
+
+uint32_t VertexPackingHelper::PackNormal(const XMFLOAT3& kNormal)
+{
+	int iX;
+	int iY;
+
+	QuantizeOctahedral(NormalizeOrZ(kNormal), 32767, false, iX, iY);
+
+	return ((uint32_t)iX & 0xFFFF) | ((uint32_t)iY << 16);
+}
+
+XMFLOAT3 VertexPackingHelper::UnpackNormal(uint32_t uiNormal)
+{
+	return ProbeHelper::GetOctahedralDirection(XMFLOAT2(SnormToFloat((INT16)(uiNormal & 0xFFFF)), SnormToFloat((INT16)(uiNormal >> 16))));
+}
+
+uint32_t VertexPackingHelper::PackTangent(const XMFLOAT4& kTangent)
+{
+	int iX;
+	int iY;
+
+	QuantizeOctahedral(NormalizeOrZ(XMFLOAT3(kTangent.x, kTangent.y, kTangent.z)), 32767, true, iX, iY);
+
+	return (uint32_t)iX | ((uint32_t)iY << 15) | (kTangent.w < 0.0f ? 0x80000000 : 0);
+}
+
+XMFLOAT4 VertexPackingHelper::UnpackTangent(uint32_t uiTangent)
+{
+	XMFLOAT2 coords = XMFLOAT2((uiTangent & 0x7FFF) / 32767.0f * 2.0f - 1.0f, ((uiTangent >> 15) & 0x7FFF) / 32767.0f * 2.0f - 1.0f);
+
+	XMFLOAT3 tangent = ProbeHelper::GetOctahedralDirection(coords);
+
+	return XMFLOAT4(tangent.x, tangent.y, tangent.z, (uiTangent & 0x80000000) != 0 ? -1.0f : 1.0f);
+}
+
+uint32_t VertexPackingHelper::PackTexCoords(const XMFLOAT2& kTexCoords)
+{
+	return (uint32_t)PackedVector::XMConvertFloatToHalf(kTexCoords.x) | ((uint32_t)PackedVector::XMConvertFloatToHalf(kTexCoords.y) << 16);
+}
+
+XMFLOAT2 VertexPackingHelper::UnpackTexCoords(uint32_t uiTexCoords)
+{
+	return XMFLOAT2(PackedVector::XMConvertHalfToFloat((PackedVector::HALF)(uiTexCoords & 0xFFFF)), PackedVector::XMConvertHalfToFloat((PackedVector::HALF)(uiTexCoords >> 16)));
+}
+
+void VertexPackingHelper::GetQuantization(const Vertex* kpVertices, UINT uiNumVertices, XMFLOAT3& offset, XMFLOAT3& scale)
+{
+	if (uiNumVertices == 0)
+	{
+		offset = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		scale = XMFLOAT3(1.0f, 1.0f, 1.0f);
+
+		return;
+	}
+
+	XMVECTOR min = XMLoadFloat3(&kpVertices[0].Position);
+	XMVECTOR max = min;
+
+	for (UINT i = 1; i < uiNumVertices; ++i)
+	{
+		XMVECTOR position = XMLoadFloat3(&kpVertices[i].Position);
+
+		min = XMVectorMin(min, position);
+		max = XMVectorMax(max, position);
+	}
+
+	XMStoreFloat3(&offset, XMVectorScale(XMVectorAdd(min, max), 0.5f));
+	XMStoreFloat3(&scale, XMVectorScale(XMVectorSubtract(max, min), 0.5f));
+
+	//Any scale works for flat axes as every position is the offset, it just can't be zero
+	scale.x = scale.x > 0.0f ? scale.x : 1.0f;
+	scale.y = scale.y > 0.0f ? scale.y : 1.0f;
+	scale.z = scale.z > 0.0f ? scale.z : 1.0f;
+}
+
+XMUINT2 VertexPackingHelper::QuantizePosition(const XMFLOAT3& kPosition, const XMFLOAT3& kOffset, const XMFLOAT3& kScale)
+{
+	UINT16 uiX = (UINT16)FloatToSnorm((kPosition.x - kOffset.x) / kScale.x);
+	UINT16 uiY = (UINT16)FloatToSnorm((kPosition.y - kOffset.y) / kScale.y);
+	UINT16 uiZ = (UINT16)FloatToSnorm((kPosition.z - kOffset.z) / kScale.z);
+
+	return XMUINT2(uiX | ((UINT)uiY << 16), uiZ);
+}
+
+XMFLOAT3 VertexPackingHelper::DequantizePosition(const XMUINT2& kPosition, const XMFLOAT3& kOffset, const XMFLOAT3& kScale)
+{
+	return XMFLOAT3(kOffset.x + kScale.x * SnormToFloat((INT16)(kPosition.x & 0xFFFF)),
+		kOffset.y + kScale.y * SnormToFloat((INT16)(kPosition.x >> 16)),
+		kOffset.z + kScale.z * SnormToFloat((INT16)(kPosition.y & 0xFFFF)));
+}
+
+XMFLOAT3X4 VertexPackingHelper::GetDequantizeTransform(const XMFLOAT3& kOffset, const XMFLOAT3& kScale)
+{
+	return XMFLOAT3X4(
+		kScale.x, 0.0f, 0.0f, kOffset.x,
+		0.0f, kScale.y, 0.0f, kOffset.y,
+		0.0f, 0.0f, kScale.z, kOffset.z);
+}
+
+void VertexPackingHelper::PackVertices(const Vertex* kpVertices, UINT uiNumVertices, int iVertexFormat, const XMFLOAT3& kOffset, const XMFLOAT3& kScale, BYTE* pOutput)
+{
+	switch (iVertexFormat)
+	{
+	case VERTEX_FORMAT_PACKED:
+	{
+		PackedVertex* pPacked = reinterpret_cast<PackedVertex*>(pOutput);
+
+		for (UINT i = 0; i < uiNumVertices; ++i)
+		{
+			pPacked[i].Position = kpVertices[i].Position;
+			pPacked[i].Normal = PackNormal(kpVertices[i].Normal);
+			pPacked[i].Tangent = PackTangent(kpVertices[i].Tangent);
+			pPacked[i].TexCoords = PackTexCoords(kpVertices[i].TexCoords);
+		}
+	}
+	break;
+
+	case VERTEX_FORMAT_QUANTIZED:
+	{
+		QuantizedVertex* pQuantized = reinterpret_cast<QuantizedVertex*>(pOutput);
+
+		for (UINT i = 0; i < uiNumVertices; ++i)
+		{
+			pQuantized[i].Position = QuantizePosition(kpVertices[i].Position, kOffset, kScale);
+			pQuantized[i].Normal = PackNormal(kpVertices[i].Normal);
+			pQuantized[i].Tangent = PackTangent(kpVertices[i].Tangent);
+			pQuantized[i].TexCoords = PackTexCoords(kpVertices[i].TexCoords);
+		}
+	}
+	break;
+
+	default:
+		memcpy(pOutput, kpVertices, sizeof(Vertex) * uiNumVertices);
+		break;
+	}
+}
+
+void VertexPackingHelper::UnpackPositions(const BYTE* kpVertices, UINT uiNumVertices, int iVertexFormat, const XMFLOAT3& kOffset, const XMFLOAT3& kScale, XMFLOAT3* pPositions)
+{
+	UINT uiStride = GetVertexStride(iVertexFormat);
+
+	for (UINT i = 0; i < uiNumVertices; ++i)
+	{
+		const BYTE* kpVertex = kpVertices + (size_t)i * uiStride;
+
+		if (iVertexFormat == VERTEX_FORMAT_QUANTIZED)
+		{
+			pPositions[i] = DequantizePosition(reinterpret_cast<const QuantizedVertex*>(kpVertex)->Position, kOffset, kScale);
+		}
+		else
+		{
+			//Full and packed vertices both start with the position as floats
+			memcpy(&pPositions[i], kpVertex, sizeof(XMFLOAT3));
+		}
+	}
+}
+
+void VertexPackingHelper::MeasurePrecision(const Vertex* kpVertices, UINT uiNumVertices, int iVertexFormat, VertexPackingStats& stats)
+{
+	XMFLOAT3 offset;
+	XMFLOAT3 scale;
+
+	GetQuantization(kpVertices, uiNumVertices, offset, scale);
+
+	UINT uiStride = GetVertexStride(iVertexFormat);
+
+	std::vector<BYTE> packed((size_t)uiStride * uiNumVertices);
+	std::vector<XMFLOAT3> positions(uiNumVertices);
+
+	PackVertices(kpVertices, uiNumVertices, iVertexFormat, offset, scale, packed.data());
+	UnpackPositions(packed.data(), uiNumVertices, iVertexFormat, offset, scale, positions.data());
+
+	float fExtent = 2.0f * (std::max)((std::max)(scale.x, scale.y), scale.z);
+
+	double dNormalErrorSum = 0.0;
+	double dTangentErrorSum = 0.0;
+
+	for (UINT i = 0; i < uiNumVertices; ++i)
+	{
+		const Vertex& kVertex = kpVertices[i];
+		const BYTE* kpPacked = packed.data() + (size_t)i * uiStride;
+
+		XMFLOAT3 normal = kVertex.Normal;
+		XMFLOAT4 tangent = kVertex.Tangent;
+		XMFLOAT2 texCoords = kVertex.TexCoords;
+
+		//Every attribute but the position is after it in both packed layouts, in the same order
+		if (iVertexFormat != VERTEX_FORMAT_FULL)
+		{
+			const UINT32* kpAttributes = reinterpret_cast<const UINT32*>(kpPacked + uiStride - 3 * sizeof(UINT32));
+
+			normal = UnpackNormal(kpAttributes[0]);
+			tangent = UnpackTangent(kpAttributes[1]);
+			texCoords = UnpackTexCoords(kpAttributes[2]);
+		}
+
+		float fNormalError = GetAngleDegrees(NormalizeOrZ(kVertex.Normal), normal);
+		float fTangentError = GetAngleDegrees(NormalizeOrZ(XMFLOAT3(kVertex.Tangent.x, kVertex.Tangent.y, kVertex.Tangent.z)), XMFLOAT3(tangent.x, tangent.y, tangent.z));
+
+		stats.MaxNormalErrorDegrees = (std::max)(stats.MaxNormalErrorDegrees, fNormalError);
+		stats.MaxTangentErrorDegrees = (std::max)(stats.MaxTangentErrorDegrees, fTangentError);
+		dNormalErrorSum += fNormalError;
+		dTangentErrorSum += fTangentError;
+
+		if ((kVertex.Tangent.w < 0.0f) != (tangent.w < 0.0f))
+		{
+			++stats.NumTangentSignErrors;
+		}
+
+		stats.MaxTexCoordError = (std::max)(stats.MaxTexCoordError, (std::max)(fabsf(texCoords.x - kVertex.TexCoords.x), fabsf(texCoords.y - kVertex.TexCoords.y)));
+
+		XMFLOAT3 positionError = XMFLOAT3(fabsf(positions[i].x - kVertex.Position.x), fabsf(positions[i].y - kVertex.Position.y), fabsf(positions[i].z - kVertex.Position.z));
+
+		stats.MaxPositionError = (std::max)(stats.MaxPositionError, (std::max)((std::max)(positionError.x, positionError.y), positionError.z) / fExtent);
+	}
+
+	int iNumVertices = stats.NumVertices + (int)uiNumVertices;
+
+	if (iNumVertices > 0)
+	{
+		stats.MeanNormalErrorDegrees = (stats.MeanNormalErrorDegrees * stats.NumVertices + dNormalErrorSum) / iNumVertices;
+		stats.MeanTangentErrorDegrees = (stats.MeanTangentErrorDegrees * stats.NumVertices + dTangentErrorSum) / iNumVertices;
+	}
+
+	stats.VertexFormat = iVertexFormat;
+	stats.NumVertices = iNumVertices;
+	stats.FullBytes += (UINT64)sizeof(Vertex) * uiNumVertices;
+	stats.PackedBytes += (UINT64)uiStride * uiNumVertices;
+
+	//Quantized primitives carry their dequantization transform as well
+	if (iVertexFormat == VERTEX_FORMAT_QUANTIZED)
+	{
+		stats.PackedBytes += sizeof(XMFLOAT3X4);
+	}
+}
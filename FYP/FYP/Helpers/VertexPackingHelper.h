@@ -0,0 +1,74 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <DirectXMath.h>
+
+#include <stdint.h>
+
+struct Vertex;
+
+struct VertexPackingStats
+{
+	int VertexFormat = 0;
+	int NumVertices = 0;
+
+	UINT64 FullBytes = 0;
+	UINT64 PackedBytes = 0;
+
+	//Between each attribute and what it decodes to, directions are compared as angles
+	float MaxNormalErrorDegrees = 0.0f;
+	double MeanNormalErrorDegrees = 0.0;
+	float MaxTangentErrorDegrees = 0.0f;
+	double MeanTangentErrorDegrees = 0.0;
+	int NumTangentSignErrors = 0;
+	float MaxTexCoordError = 0.0f;
+
+	//Relative to the largest extent of the primitive it's in, only quantized positions have any
+	float MaxPositionError = 0.0f;
+
+	float GetSaving() const
+	{
+		return FullBytes > 0 ? 1.0f - PackedBytes / (float)FullBytes : 0.0f;
+	}
+};
+
+//Packs vertices into the VERTEX_FORMAT_PACKED and VERTEX_FORMAT_QUANTIZED layouts in Shaders/Vertices.h and unpacks
+//them again, the unpacking mirrors Shaders/VertexPacking.hlsl. Normals and tangents use the octahedral mapping in
+//Helpers/ProbeHelper.h and pick whichever of the four nearest encodings decodes closest to the original.
+class VertexPackingHelper
+{
+public:
+	static UINT GetVertexStride(int iVertexFormat);
+
+	static uint32_t PackNormal(const DirectX::XMFLOAT3& kNormal);
+	static DirectX::XMFLOAT3 UnpackNormal(uint32_t uiNormal);
+
+	static uint32_t PackTangent(const DirectX::XMFLOAT4& kTangent);
+	static DirectX::XMFLOAT4 UnpackTangent(uint32_t uiTangent);
+
+	static uint32_t PackTexCoords(const DirectX::XMFLOAT2& kTexCoords);
+	static DirectX::XMFLOAT2 UnpackTexCoords(uint32_t uiTexCoords);
+
+	//Centre and half extents of the vertices' bounds, which quantized positions are relative to
+	static void GetQuantization(const Vertex* kpVertices, UINT uiNumVertices, DirectX::XMFLOAT3& offset, DirectX::XMFLOAT3& scale);
+
+	static DirectX::XMUINT2 QuantizePosition(const DirectX::XMFLOAT3& kPosition, const DirectX::XMFLOAT3& kOffset, const DirectX::XMFLOAT3& kScale);
+	static DirectX::XMFLOAT3 DequantizePosition(const DirectX::XMUINT2& kPosition, const DirectX::XMFLOAT3& kOffset, const DirectX::XMFLOAT3& kScale);
+
+	//Row major, the layout bottom level acceleration structures take their transforms in
+	static DirectX::XMFLOAT3X4 GetDequantizeTransform(const DirectX::XMFLOAT3& kOffset, const DirectX::XMFLOAT3& kScale);
+
+	//Writes the vertices to pOutput in the vertex format's layout, kOffset and kScale are only used for quantized positions
+	static void PackVertices(const Vertex* kpVertices, UINT uiNumVertices, int iVertexFormat, const DirectX::XMFLOAT3& kOffset, const DirectX::XMFLOAT3& kScale, BYTE* pOutput);
+	static void UnpackPositions(const BYTE* kpVertices, UINT uiNumVertices, int iVertexFormat, const DirectX::XMFLOAT3& kOffset, const DirectX::XMFLOAT3& kScale, DirectX::XMFLOAT3* pPositions);
+
+	//Packs the vertices of one primitive, quantizing positions to its bounds, and adds how far they are from the originals
+	//once unpacked to stats
+	static void MeasurePrecision(const Vertex* kpVertices, UINT uiNumVertices, int iVertexFormat, VertexPackingStats& stats);
+
+protected:
+
+private:
+
+};
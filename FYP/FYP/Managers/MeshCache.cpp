@@ -0,0 +1,372 @@
+#include "MeshCache.h"
+#include "Include/tinygltf/tiny_gltf.h"
+#include "Helpers/DebugHelper.h"
+#include "Shaders/Vertices.h"
+
+#include <fstream>
+
+Tag tag = L"MeshCache";
+
+static const char s_kMagic[4] = { 'M', 'E', 'S', 'H' };
+
+namespace
+{
+	UINT64 Align(UINT64 uiOffset)
+	{
+		return (uiOffset + MESH_CACHE_ALIGNMENT - 1) & ~((UINT64)MESH_CACHE_ALIGNMENT - 1);
+	}
+
+	//Pads the file with zeroes from uiOffset up to the next aligned offset and returns it
+	UINT64 WritePadding(std::ofstream& outFile, UINT64 uiOffset)
+	{
+		static const char s_kZeroes[MESH_CACHE_ALIGNMENT] = {};
+
+		UINT64 uiAligned = Align(uiOffset);
+
+		outFile.write(s_kZeroes, (std::streamsize)(uiAligned - uiOffset));
+
+		return uiAligned;
+	}
+
+	bool IsInFile(UINT64 uiOffset, UINT64 uiSize, UINT64 uiFileSize)
+	{
+		return uiOffset <= uiFileSize && uiSize <= uiFileSize - uiOffset;
+	}
+}
+
+bool MeshCache::Write(const std::string& ksFilepath, UINT64 uiSourceHash, UINT64 uiSourceSize, const std::vector<Vertex>& kVertices, const std::vector<UINT>& kIndices, const std::vector<MeshCacheNode>& kNodes, const std::vector<std::string>& kNodeNames, const std::vector<MeshCachePrimitive>& kPrimitives, const std::vector<UINT32>& kTextureImages, const std::vector<MeshCacheImage>& kImages, const std::vector<const BYTE*>& kImageData)
+{
+	std::ofstream outFile(ksFilepath, std::ios::binary);
+
+	if (outFile.is_open() == false)
+	{
+		LOG_ERROR(tag, L"Failed to open %s to write the mesh cache!", std::wstring(ksFilepath.begin(), ksFilepath.end()).c_str());
+
+		return false;
+	}
+
+	MeshCacheHeader header = {};
+	memcpy(header.Magic, s_kMagic, sizeof(s_kMagic));
+	header.Version = MESH_CACHE_VERSION;
+	header.HeaderSize = sizeof(MeshCacheHeader);
+	header.VertexSize = sizeof(Vertex);
+	header.SourceHash = uiSourceHash;
+	header.SourceSize = uiSourceSize;
+	header.NumVertices = (UINT32)kVertices.size();
+	header.NumIndices = (UINT32)kIndices.size();
+	header.NumNodes = (UINT32)kNodes.size();
+	header.NumPrimitives = (UINT32)kPrimitives.size();
+	header.NumTextures = (UINT32)kTextureImages.size();
+	header.NumImages = (UINT32)kImages.size();
+
+	//Work out where everything will end up before writing anything
+	header.VertexOffset = Align(sizeof(MeshCacheHeader));
+	header.IndexOffset = Align(header.VertexOffset + sizeof(Vertex) * kVertices.size());
+	header.NodeOffset = Align(header.IndexOffset + sizeof(UINT) * kIndices.size());
+	header.PrimitiveOffset = Align(header.NodeOffset + sizeof(MeshCacheNode) * kNodes.size());
+	header.TextureOffset = Align(header.PrimitiveOffset + sizeof(MeshCachePrimitive) * kPrimitives.size());
+	header.ImageOffset = Align(header.TextureOffset + sizeof(UINT32) * kTextureImages.size());
+
+	UINT64 uiOffset = Align(header.ImageOffset + sizeof(MeshCacheImage) * kImages.size());
+
+	std::vector<MeshCacheNode> nodes = kNodes;
+
+	for (int i = 0; i < nodes.size(); ++i)
+	{
+		nodes[i].NameOffset = uiOffset;
+		nodes[i].NameLength = (UINT32)kNodeNames[i].size();
+
+		uiOffset += nodes[i].NameLength;
+	}
+
+	std::vector<MeshCacheImage> images = kImages;
+
+	for (int i = 0; i < images.size(); ++i)
+	{
+		uiOffset = Align(uiOffset);
+
+		images[i].DataOffset = uiOffset;
+
+		uiOffset += images[i].DataSize;
+	}
+
+	outFile.write((const char*)&header, sizeof(MeshCacheHeader));
+	uiOffset = WritePadding(outFile, sizeof(MeshCacheHeader));
+
+	outFile.write((const char*)kVertices.data(), sizeof(Vertex) * kVertices.size());
+	uiOffset = WritePadding(outFile, uiOffset + sizeof(Vertex) * kVertices.size());
+
+	outFile.write((const char*)kIndices.data(), sizeof(UINT) * kIndices.size());
+	uiOffset = WritePadding(outFile, uiOffset + sizeof(UINT) * kIndices.size());
+
+	outFile.write((const char*)nodes.data(), sizeof(MeshCacheNode) * nodes.size());
+	uiOffset = WritePadding(outFile, uiOffset + sizeof(MeshCacheNode) * nodes.size());
+
+	outFile.write((const char*)kPrimitives.data(), sizeof(MeshCachePrimitive) * kPrimitives.size());
+	uiOffset = WritePadding(outFile, uiOffset + sizeof(MeshCachePrimitive) * kPrimitives.size());
+
+	outFile.write((const char*)kTextureImages.data(), sizeof(UINT32) * kTextureImages.size());
+	uiOffset = WritePadding(outFile, uiOffset + sizeof(UINT32) * kTextureImages.size());
+
+	outFile.write((const char*)images.data(), sizeof(MeshCacheImage) * images.size());
+	uiOffset = WritePadding(outFile, uiOffset + sizeof(MeshCacheImage) * images.size());
+
+	for (int i = 0; i < nodes.size(); ++i)
+	{
+		outFile.write(kNodeNames[i].data(), nodes[i].NameLength);
+		uiOffset += nodes[i].NameLength;
+	}
+
+	for (int i = 0; i < images.size(); ++i)
+	{
+		uiOffset = WritePadding(outFile, uiOffset);
+
+		outFile.write((const char*)kImageData[i], (std::streamsize)images[i].DataSize);
+		uiOffset += images[i].DataSize;
+	}
+
+	outFile.close();
+
+	if (outFile.fail() == true)
+	{
+		LOG_ERROR(tag, L"Failed to write the mesh cache to %s!", std::wstring(ksFilepath.begin(), ksFilepath.end()).c_str());
+
+		return false;
+	}
+
+	return true;
+}
+
+bool MeshCache::HashFile(const std::string& ksFilepath, UINT64& uiHash, UINT64& uiSize)
+{
+	MappedFile file;
+
+	if (file.Open(ksFilepath) == false)
+	{
+		return false;
+	}
+
+	const BYTE* kpData = file.GetData();
+	uiSize = file.GetSize();
+
+	uiHash = 14695981039346656037ull;
+
+	UINT64 uiWord;
+	UINT64 i = 0;
+
+	for (; i + sizeof(UINT64) <= uiSize; i += sizeof(UINT64))
+	{
+		memcpy(&uiWord, kpData + i, sizeof(UINT64));
+
+		uiHash = (uiHash ^ uiWord) * 1099511628211ull;
+	}
+
+	for (; i < uiSize; ++i)
+	{
+		uiHash = (uiHash ^ kpData[i]) * 1099511628211ull;
+	}
+
+	return true;
+}
+
+std::string MeshCache::GetCacheFilepath(const std::string& ksSourceFilepath)
+{
+	return ksSourceFilepath + MESH_CACHE_EXTENSION;
+}
+
+bool MeshCache::Open(const std::string& ksFilepath)
+{
+	Close();
+
+	if (m_File.Open(ksFilepath) == false)
+	{
+		return false;
+	}
+
+	UINT64 uiFileSize = m_File.GetSize();
+
+	if (uiFileSize < sizeof(MeshCacheHeader))
+	{
+		LOG_ERROR(tag, L"Mesh cache %s is too small to contain a header!", std::wstring(ksFilepath.begin(), ksFilepath.end()).c_str());
+
+		Close();
+
+		return false;
+	}
+
+	const MeshCacheHeader* kpHeader = (const MeshCacheHeader*)m_File.GetData();
+
+	if (memcmp(kpHeader->Magic, s_kMagic, sizeof(s_kMagic)) != 0 || kpHeader->HeaderSize != sizeof(MeshCacheHeader))
+	{
+		LOG_ERROR(tag, L"%s isn't a mesh cache!", std::wstring(ksFilepath.begin(), ksFilepath.end()).c_str());
+
+		Close();
+
+		return false;
+	}
+
+	if (kpHeader->Version != MESH_CACHE_VERSION || kpHeader->VertexSize != sizeof(Vertex))
+	{
+		LOG_WARNING(tag, L"Mesh cache %s is version %u but version %u is needed, it needs cooking again!", std::wstring(ksFilepath.begin(), ksFilepath.end()).c_str(), kpHeader->Version, MESH_CACHE_VERSION);
+
+		Close();
+
+		return false;
+	}
+
+	bool bValid = IsInFile(kpHeader->VertexOffset, sizeof(Vertex) * (UINT64)kpHeader->NumVertices, uiFileSize) &&
+		IsInFile(kpHeader->IndexOffset, sizeof(UINT) * (UINT64)kpHeader->NumIndices, uiFileSize) &&
+		IsInFile(kpHeader->NodeOffset, sizeof(MeshCacheNode) * (UINT64)kpHeader->NumNodes, uiFileSize) &&
+		IsInFile(kpHeader->PrimitiveOffset, sizeof(MeshCachePrimitive) * (UINT64)kpHeader->NumPrimitives, uiFileSize) &&
+		IsInFile(kpHeader->TextureOffset, sizeof(UINT32) * (UINT64)kpHeader->NumTextures, uiFileSize) &&
+		IsInFile(kpHeader->ImageOffset, sizeof(MeshCacheImage) * (UINT64)kpHeader->NumImages, uiFileSize);
+
+	if (bValid == true)
+	{
+		const MeshCacheNode* kpNodes = (const MeshCacheNode*)(m_File.GetData() + kpHeader->NodeOffset);
+
+		for (UINT32 i = 0; i < kpHeader->NumNodes && bValid == true; ++i)
+		{
+			bValid = IsInFile(kpNodes[i].NameOffset, kpNodes[i].NameLength, uiFileSize) &&
+				kpNodes[i].Parent < (INT32)kpHeader->NumNodes &&
+				(UINT64)kpNodes[i].FirstPrimitive + kpNodes[i].NumPrimitives <= kpHeader->NumPrimitives;
+		}
+
+		const MeshCachePrimitive* kpPrimitives = (const MeshCachePrimitive*)(m_File.GetData() + kpHeader->PrimitiveOffset);
+
+		for (UINT32 i = 0; i < kpHeader->NumPrimitives && bValid == true; ++i)
+		{
+			bValid = (UINT64)kpPrimitives[i].FirstIndex + kpPrimitives[i].NumIndices <= kpHeader->NumIndices &&
+				(UINT64)kpPrimitives[i].FirstVertex + kpPrimitives[i].NumVertices <= kpHeader->NumVertices;
+		}
+
+		const UINT32* kpTextureImages = (const UINT32*)(m_File.GetData() + kpHeader->TextureOffset);
+
+		for (UINT32 i = 0; i < kpHeader->NumTextures && bValid == true; ++i)
+		{
+			bValid = kpTextureImages[i] < kpHeader->NumImages;
+		}
+
+		const MeshCacheImage* kpImages = (const MeshCacheImage*)(m_File.GetData() + kpHeader->ImageOffset);
+
+		for (UINT32 i = 0; i < kpHeader->NumImages && bValid == true; ++i)
+		{
+			bValid = IsInFile(kpImages[i].DataOffset, kpImages[i].DataSize, uiFileSize);
+		}
+	}
+
+	if (bValid == false)
+	{
+		LOG_ERROR(tag, L"Mesh cache %s is truncated or corrupt!", std::wstring(ksFilepath.begin(), ksFilepath.end()).c_str());
+
+		Close();
+
+		return false;
+	}
+
+	m_kpHeader = kpHeader;
+
+	return true;
+}
+
+void MeshCache::Close()
+{
+	m_kpHeader = nullptr;
+
+	m_File.Close();
+}
+
+bool MeshCache::IsUpToDate(const std::string& ksSourceFilepath) const
+{
+	if (m_kpHeader == nullptr)
+	{
+		return false;
+	}
+
+	if (GetFileAttributesA(ksSourceFilepath.c_str()) == INVALID_FILE_ATTRIBUTES)
+	{
+		return true;
+	}
+
+	UINT64 uiHash;
+	UINT64 uiSize;
+
+	if (HashFile(ksSourceFilepath, uiHash, uiSize) == false)
+	{
+		return false;
+	}
+
+	return uiHash == m_kpHeader->SourceHash && uiSize == m_kpHeader->SourceSize;
+}
+
+const MeshCacheHeader& MeshCache::GetHeader() const
+{
+	return *m_kpHeader;
+}
+
+const Vertex* MeshCache::GetVertices() const
+{
+	return (const Vertex*)(m_File.GetData() + m_kpHeader->VertexOffset);
+}
+
+const UINT* MeshCache::GetIndices() const
+{
+	return (const UINT*)(m_File.GetData() + m_kpHeader->IndexOffset);
+}
+
+const MeshCacheNode* MeshCache::GetNodes() const
+{
+	return (const MeshCacheNode*)(m_File.GetData() + m_kpHeader->NodeOffset);
+}
+
+const MeshCachePrimitive* MeshCache::GetPrimitives() const
+{
+	return (const MeshCachePrimitive*)(m_File.GetData() + m_kpHeader->PrimitiveOffset);
+}
+
+const UINT32* MeshCache::GetTextureImages() const
+{
+	return (const UINT32*)(m_File.GetData() + m_kpHeader->TextureOffset);
+}
+
+const MeshCacheImage* MeshCache::GetImages() const
+{
+	return (const MeshCacheImage*)(m_File.GetData() + m_kpHeader->ImageOffset);
+}
+
+std::string MeshCache::GetNodeName(int iNodeIndex) const
+{
+	const MeshCacheNode& kNode = GetNodes()[iNodeIndex];
+
+	return std::string((const char*)(m_File.GetData() + kNode.NameOffset), kNode.NameLength);
+}
+
+bool MeshCache::GetImage(int iImageIndex, tinygltf::Image& image) const
+{
+	const MeshCacheImage& kImage = GetImages()[iImageIndex];
+	const BYTE* kpData = m_File.GetData() + kImage.DataOffset;
+
+	if (kImage.DataType == MeshCacheImageData::PIXELS)
+	{
+		image.width = kImage.Width;
+		image.height = kImage.Height;
+		image.component = kImage.Component;
+		image.bits = kImage.Bits;
+		image.pixel_type = kImage.PixelType;
+		image.image.assign(kpData, kpData + kImage.DataSize);
+
+		return true;
+	}
+
+	std::string err;
+	std::string warn;
+
+	if (tinygltf::LoadImageData(&image, iImageIndex, &err, &warn, 0, 0, kpData, (int)kImage.DataSize, nullptr) == false)
+	{
+		LOG_ERROR(tag, L"Failed to decode image %i from the mesh cache! %s", iImageIndex, std::wstring(err.begin(), err.end()).c_str());
+
+		return false;
+	}
+
+	return true;
+}
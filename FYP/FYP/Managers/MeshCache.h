@@ -0,0 +1,149 @@
+#pragma once
+
+#include "Commons/MappedFile.h"
+
+#include <DirectXMath.h>
+
+#include <string>
+#include <vector>
+
+#define MESH_CACHE_VERSION 2
+#define MESH_CACHE_EXTENSION ".meshcache"
+#define MESH_CACHE_ALIGNMENT 16
+
+struct Vertex;
+
+namespace tinygltf
+{
+	struct Image;
+}
+
+//Binary layout of a cooked mesh:
+//MeshCacheHeader, then the Vertex array, the UINT index array, a MeshCacheNode per node, a MeshCachePrimitive per
+//primitive, the UINT32 image index of every texture and a MeshCacheImage per image, followed by the node names and the
+//image data. Each section starts on a MESH_CACHE_ALIGNMENT boundary. Vertices are stored as they are in memory so a
+//cache is only used if the Vertex size it was cooked with still matches, the version has to be bumped for any other
+//change to what gets cooked.
+struct MeshCacheHeader
+{
+	char Magic[4];
+	UINT32 Version;
+	UINT32 HeaderSize;
+	UINT32 VertexSize;
+
+	//Of the .gltf or .glb file the cache was cooked from, files a .gltf references aren't included
+	UINT64 SourceHash;
+	UINT64 SourceSize;
+
+	UINT32 NumVertices;
+	UINT32 NumIndices;
+	UINT32 NumNodes;
+	UINT32 NumPrimitives;
+	UINT32 NumTextures;
+	UINT32 NumImages;
+
+	//From the start of the file
+	UINT64 VertexOffset;
+	UINT64 IndexOffset;
+	UINT64 NodeOffset;
+	UINT64 PrimitiveOffset;
+	UINT64 TextureOffset;
+	UINT64 ImageOffset;
+};
+
+//Nodes are in the order MeshManager::ProcessNode adds them to the mesh, children before their parents
+struct MeshCacheNode
+{
+	DirectX::XMFLOAT4X4 Transform;	//Already multiplied by every parent's
+
+	INT32 Parent;	//Into the node array, -1 for nodes in the scene's root
+	UINT32 Index;	//glTF node index
+
+	UINT32 FirstPrimitive;	//Into the primitive array
+	UINT32 NumPrimitives;
+
+	UINT64 NameOffset;
+	UINT32 NameLength;
+	UINT32 Pad;
+};
+
+struct MeshCachePrimitive
+{
+	DirectX::XMFLOAT4 BaseColour;
+
+	UINT32 FirstIndex;
+	UINT32 NumIndices;
+	UINT32 FirstVertex;
+	UINT32 NumVertices;
+
+	INT32 Index;	//Relative to the mesh's first primitive
+	INT32 AlbedoIndex;
+	INT32 NormalIndex;
+	INT32 MetallicRoughnessIndex;
+	INT32 OcclusionIndex;
+
+	UINT32 Attributes;	//PrimitiveAttributes
+};
+
+enum class MeshCacheImageData : UINT32
+{
+	ENCODED = 0,	//The image file's bytes as they were in the glTF, decoded on load
+	PIXELS			//Already decoded, used for images tinygltf only kept decoded such as data URIs
+};
+
+//Images are kept apart from textures as textures can share them and each only needs decoding once
+struct MeshCacheImage
+{
+	MeshCacheImageData DataType;
+
+	//Only used for PIXELS
+	INT32 Width;
+	INT32 Height;
+	INT32 Component;
+	INT32 Bits;
+	INT32 PixelType;
+
+	UINT64 DataOffset;
+	UINT64 DataSize;
+};
+
+class MeshCache
+{
+public:
+	//kNodeNames and kImageData line up with kNodes and kImages, the offsets in them are filled in when written
+	static bool Write(const std::string& ksFilepath, UINT64 uiSourceHash, UINT64 uiSourceSize, const std::vector<Vertex>& kVertices, const std::vector<UINT>& kIndices, const std::vector<MeshCacheNode>& kNodes, const std::vector<std::string>& kNodeNames, const std::vector<MeshCachePrimitive>& kPrimitives, const std::vector<UINT32>& kTextureImages, const std::vector<MeshCacheImage>& kImages, const std::vector<const BYTE*>& kImageData);
+
+	//64 bit FNV-1a over the file eight bytes at a time
+	static bool HashFile(const std::string& ksFilepath, UINT64& uiHash, UINT64& uiSize);
+
+	static std::string GetCacheFilepath(const std::string& ksSourceFilepath);
+
+	//Maps the file and checks the header and that every section fits in it
+	bool Open(const std::string& ksFilepath);
+	void Close();
+
+	//False if the source has changed since the cache was cooked. A missing source counts as up to date so a cache
+	//can be shipped without the glTF.
+	bool IsUpToDate(const std::string& ksSourceFilepath) const;
+
+	const MeshCacheHeader& GetHeader() const;
+
+	const Vertex* GetVertices() const;
+	const UINT* GetIndices() const;
+	const MeshCacheNode* GetNodes() const;
+	const MeshCachePrimitive* GetPrimitives() const;
+	const UINT32* GetTextureImages() const;
+	const MeshCacheImage* GetImages() const;
+
+	std::string GetNodeName(int iNodeIndex) const;
+
+	//Decodes encoded images the same way tinygltf does when it parses a glTF
+	bool GetImage(int iImageIndex, tinygltf::Image& image) const;
+
+protected:
+
+private:
+	MappedFile m_File;
+
+	const MeshCacheHeader* m_kpHeader = nullptr;
+};
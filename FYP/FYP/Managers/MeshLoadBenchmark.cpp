@@ -0,0 +1,288 @@
+#include "MeshLoadBenchmark.h"
+#include "Include/tinygltf/tiny_gltf.h"
+#include "Commons/GLTFFile.h"
+#include "Commons/Mesh.h"
+#include "Commons/Timer.h"
+#include "Commons/ThreadPool.h"
+#include "Managers/MeshManager.h"
+#include "Managers/MeshCache.h"
+#include "Shaders/Vertices.h"
+#include "Helpers/DebugHelper.h"
+
+MeshLoadStats MeshLoadBenchmark::Run(const std::string& ksFilepath, int iNumLoads)
+{
+	PROFILE("Mesh Load Benchmark");
+
+	MeshLoadStats stats;
+	stats.Filepath = ksFilepath;
+	stats.Binary = GLTFFile::IsBinaryFilepath(ksFilepath);
+
+	Timer timer;
+
+	for (int i = 0; i < iNumLoads; ++i)
+	{
+		std::vector<Vertex> vertices;
+		std::vector<UINT> indices;
+
+		timer.Reset();
+
+		GLTFFile file;
+
+		if (file.Load(ksFilepath) == false)
+		{
+			break;
+		}
+
+		timer.Tick();
+
+		double dParseSeconds = timer.DeltaTime();
+
+		Mesh mesh;
+
+		if (MeshManager::GetInstance()->BuildMesh(file, &mesh, vertices, indices) == false)
+		{
+			break;
+		}
+
+		m_Staging.resize(sizeof(Vertex) * vertices.size() + sizeof(UINT) * indices.size());
+		memcpy(m_Staging.data(), vertices.data(), sizeof(Vertex) * vertices.size());
+		memcpy(m_Staging.data() + sizeof(Vertex) * vertices.size(), indices.data(), sizeof(UINT) * indices.size());
+
+		timer.Tick();
+
+		stats.NumVertices = (UINT)vertices.size();
+		stats.NumIndices = (UINT)indices.size();
+
+		AddLoad(stats, dParseSeconds, timer.DeltaTime());
+	}
+
+	Finish(stats);
+
+	return stats;
+}
+
+MeshLoadStats MeshLoadBenchmark::RunCached(const std::string& ksFilepath, int iNumLoads)
+{
+	PROFILE("Mesh Load Benchmark");
+
+	MeshLoadStats stats;
+	stats.Filepath = ksFilepath;
+	stats.Binary = GLTFFile::IsBinaryFilepath(ksFilepath);
+	stats.Cached = true;
+
+	Timer timer;
+
+	for (int i = 0; i < iNumLoads; ++i)
+	{
+		timer.Reset();
+
+		MeshCache cache;
+
+		if (cache.Open(MeshCache::GetCacheFilepath(ksFilepath)) == false || cache.IsUpToDate(ksFilepath) == false)
+		{
+			break;
+		}
+
+		const MeshCacheHeader& kHeader = cache.GetHeader();
+
+		bool bDecoded = true;
+
+		for (UINT j = 0; j < kHeader.NumImages && bDecoded == true; ++j)
+		{
+			tinygltf::Image image;
+
+			bDecoded = cache.GetImage(j, image);
+		}
+
+		if (bDecoded == false)
+		{
+			break;
+		}
+
+		timer.Tick();
+
+		double dParseSeconds = timer.DeltaTime();
+
+		Mesh mesh;
+
+		MeshManager::GetInstance()->BuildCachedMesh(cache, &mesh);
+
+		m_Staging.resize(sizeof(Vertex) * kHeader.NumVertices + sizeof(UINT) * kHeader.NumIndices);
+		memcpy(m_Staging.data(), cache.GetVertices(), sizeof(Vertex) * kHeader.NumVertices);
+		memcpy(m_Staging.data() + sizeof(Vertex) * kHeader.NumVertices, cache.GetIndices(), sizeof(UINT) * kHeader.NumIndices);
+
+		timer.Tick();
+
+		stats.NumVertices = kHeader.NumVertices;
+		stats.NumIndices = kHeader.NumIndices;
+
+		AddLoad(stats, dParseSeconds, timer.DeltaTime());
+	}
+
+	Finish(stats);
+
+	return stats;
+}
+
+std::vector<MeshLoadStats> MeshLoadBenchmark::RunAll(const std::vector<std::string>& kFilepaths, int iNumLoads)
+{
+	std::vector<MeshLoadStats> stats;
+
+	for (int i = 0; i < kFilepaths.size(); ++i)
+	{
+		stats.push_back(Run(kFilepaths[i], iNumLoads));
+
+		if (GetFileAttributesA(MeshCache::GetCacheFilepath(kFilepaths[i]).c_str()) != INVALID_FILE_ATTRIBUTES)
+		{
+			stats.push_back(RunCached(kFilepaths[i], iNumLoads));
+		}
+	}
+
+	return stats;
+}
+
+SceneLoadStats MeshLoadBenchmark::RunScene(const std::vector<std::string>& kFilepaths, unsigned int uiNumThreads, int iNumLoads)
+{
+	PROFILE("Scene Load Benchmark");
+
+	SceneLoadStats stats;
+	stats.NumThreads = uiNumThreads;
+	stats.NumMeshes = (int)kFilepaths.size();
+
+	std::vector<std::string> names;
+
+	for (int i = 0; i < kFilepaths.size(); ++i)
+	{
+		names.push_back("Mesh" + std::to_string(i));
+	}
+
+	//ThreadPool picks its own count for 0 so no pool is used at all
+	ThreadPool* pThreadPool = uiNumThreads > 0 ? new ThreadPool(uiNumThreads) : nullptr;
+	ThreadPool* pOldThreadPool = MeshManager::GetInstance()->GetThreadPool();
+
+	MeshManager::GetInstance()->SetThreadPool(pThreadPool);
+
+	Timer timer;
+
+	for (int i = 0; i < iNumLoads; ++i)
+	{
+		int iNumFailed = 0;
+
+		timer.Reset();
+
+		MeshManager::GetInstance()->PrepareMeshes(kFilepaths, names, [this, &iNumFailed](int iIndex, PreparedMesh& prepared, bool bPrepared)
+		{
+			if (bPrepared == false)
+			{
+				++iNumFailed;
+
+				return;
+			}
+
+			m_Staging.resize(sizeof(Vertex) * prepared.m_uiNumVertices + sizeof(UINT) * prepared.m_uiNumIndices);
+			memcpy(m_Staging.data(), prepared.m_kpVertices, sizeof(Vertex) * prepared.m_uiNumVertices);
+			memcpy(m_Staging.data() + sizeof(Vertex) * prepared.m_uiNumVertices, prepared.m_kpIndices, sizeof(UINT) * prepared.m_uiNumIndices);
+		});
+
+		timer.Tick();
+
+		stats.NumFailed = iNumFailed;
+
+		if (i == 0)
+		{
+			stats.FirstLoadSeconds = timer.DeltaTime();
+		}
+		else
+		{
+			stats.Seconds += timer.DeltaTime();
+		}
+
+		++stats.NumLoads;
+	}
+
+	if (stats.NumLoads > 1)
+	{
+		stats.Seconds /= stats.NumLoads - 1;
+	}
+
+	MeshManager::GetInstance()->SetThreadPool(pOldThreadPool);
+
+	delete pThreadPool;
+
+	return stats;
+}
+
+std::vector<SceneLoadStats> MeshLoadBenchmark::RunSceneScaling(const std::vector<std::string>& kFilepaths, unsigned int uiMaxThreads, int iNumLoads)
+{
+	std::vector<SceneLoadStats> stats;
+
+	stats.push_back(RunScene(kFilepaths, 0, iNumLoads));
+
+	for (unsigned int i = 1; i <= uiMaxThreads; i *= 2)
+	{
+		stats.push_back(RunScene(kFilepaths, i, iNumLoads));
+	}
+
+	return stats;
+}
+
+std::vector<std::string> MeshLoadBenchmark::GetSampleFilepaths()
+{
+	return std::vector<std::string>
+	{
+		"Models/DamagedHelmet/glTF/DamagedHelmet.gltf",
+		"Models/DamagedHelmet/glTF-Binary/DamagedHelmet.glb",
+		"Models/CesiumMilkTruck/glTF/CesiumMilkTruck.gltf",
+		"Models/CesiumMilkTruck/glTF-Binary/CesiumMilkTruck.glb",
+		"Models/Sponza/glTF/Sponza.gltf",
+	};
+}
+
+std::vector<std::string> MeshLoadBenchmark::GetSceneFilepaths()
+{
+	return std::vector<std::string>
+	{
+		"Models/BarramundiFish/glTF/BarramundiFish.gltf",
+		"Models/BoomBox/glTF/BoomBox.gltf",
+		"Models/Box/glTF/Box.gltf",
+		"Models/BoxInterleaved/glTF/BoxInterleaved.gltf",
+		"Models/BoxTextured/glTF/BoxTextured.gltf",
+		"Models/BoxTexturedNonPowerOfTwo/glTF/BoxTexturedNonPowerOfTwo.gltf",
+		"Models/CesiumMilkTruck/glTF/CesiumMilkTruck.gltf",
+		"Models/Cornell/cornell.gltf",
+		"Models/Corset/glTF/Corset.gltf",
+		"Models/DamagedHelmet/glTF/DamagedHelmet.gltf",
+		"Models/Duck/glTF/Duck.gltf",
+		"Models/FlightHelmet/glTF/FlightHelmet.gltf",
+		"Models/SciFiHelmet/glTF/SciFiHelmet.gltf",
+		"Models/Sphere/gLTF/Sphere.gltf",
+		"Models/Sponza/glTF/Sponza.gltf",
+		"Models/WaterBottle/glTF/WaterBottle.gltf",
+		"Models/simpleMesh/glTF/simpleMesh.gltf",
+	};
+}
+
+void MeshLoadBenchmark::AddLoad(MeshLoadStats& stats, double dParseSeconds, double dBuildSeconds)
+{
+	if (stats.NumLoads == 0)
+	{
+		stats.FirstLoadSeconds = dParseSeconds + dBuildSeconds;
+	}
+	else
+	{
+		stats.ParseSeconds += dParseSeconds;
+		stats.BuildSeconds += dBuildSeconds;
+	}
+
+	++stats.NumLoads;
+}
+
+void MeshLoadBenchmark::Finish(MeshLoadStats& stats)
+{
+	if (stats.NumLoads > 1)
+	{
+		stats.ParseSeconds /= stats.NumLoads - 1;
+		stats.BuildSeconds /= stats.NumLoads - 1;
+		stats.TotalSeconds = stats.ParseSeconds + stats.BuildSeconds;
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <string>
+#include <vector>
+
+struct MeshLoadStats
+{
+	std::string Filepath;
+	bool Binary = false;
+	bool Cached = false;
+
+	int NumLoads = 0;
+
+	UINT NumVertices = 0;
+	UINT NumIndices = 0;
+
+	//Mean over every load after the first. Parsing is tinygltf reading the file and its buffers and decoding its
+	//images, or for a cache mapping it, checking it against its glTF and decoding its images. Building is filling the
+	//mesh's nodes and copying the vertices and indices to where the upload buffers would be.
+	double ParseSeconds = 0.0;
+	double BuildSeconds = 0.0;
+	double TotalSeconds = 0.0;
+
+	//Cold if nothing has read the files since the OS file cache was last emptied
+	double FirstLoadSeconds = 0.0;
+};
+
+struct SceneLoadStats
+{
+	//Workers in MeshManager's thread pool, 0 prepares every mesh on the calling thread
+	unsigned int NumThreads = 0;
+
+	int NumMeshes = 0;
+	int NumFailed = 0;
+	int NumLoads = 0;
+
+	//Mean over every load after the first of MeshManager::PrepareMeshes with each mesh staged as it becomes ready
+	double Seconds = 0.0;
+	double FirstLoadSeconds = 0.0;
+};
+
+//Times the CPU side of MeshManager::LoadMesh without creating any D3D12 resources so .gltf, .glb and cooked files of
+//the same model can be compared outside of the app.
+class MeshLoadBenchmark
+{
+public:
+	MeshLoadStats Run(const std::string& ksFilepath, int iNumLoads);
+
+	//Loads ksFilepath's MeshCache, cook it with MeshManager::CookMesh first
+	MeshLoadStats RunCached(const std::string& ksFilepath, int iNumLoads);
+
+	//Every file through the glTF path then through its cache if it has one
+	std::vector<MeshLoadStats> RunAll(const std::vector<std::string>& kFilepaths, int iNumLoads);
+
+	//Loads every file as one scene the way MeshManager::LoadMeshes does with uiNumThreads workers
+	SceneLoadStats RunScene(const std::vector<std::string>& kFilepaths, unsigned int uiNumThreads, int iNumLoads);
+
+	//RunScene with no pool then 1, 2, 4... workers up to uiMaxThreads
+	std::vector<SceneLoadStats> RunSceneScaling(const std::vector<std::string>& kFilepaths, unsigned int uiMaxThreads, int iNumLoads);
+
+	//The models the load paths were compared on in both formats where the repo has both. Sponza only ships as .gltf,
+	//convert it with any glTF tool to compare its .glb.
+	static std::vector<std::string> GetSampleFilepaths();
+
+	//Every sample model once in the format MeshManager supports, Draco and quantized variants are left out
+	static std::vector<std::string> GetSceneFilepaths();
+
+protected:
+
+private:
+	//Adds a load's times to stats, the first load is kept apart
+	static void AddLoad(MeshLoadStats& stats, double dParseSeconds, double dBuildSeconds);
+	static void Finish(MeshLoadStats& stats);
+
+	//Stands in for the upload buffers
+	std::vector<BYTE> m_Staging;
+};
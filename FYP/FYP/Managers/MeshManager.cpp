@@ -7,13 +7,85 @@
 #include "Commons/Texture.h"
 #include "Commons/SRVDescriptor.h"
 #include "Commons/Mesh.h"
+#include "Commons/GLTFFile.h"
 #include "Managers/TextureManager.h"
+#include "Managers/MeshCache.h"
 #include "Commons/Mesh.h"
+#include "Commons/ThreadPool.h"
+#include "Helpers/AccessorHelper.h"
+#include "Helpers/VertexPackingHelper.h"
+#include "Shaders/Defines.hlsli"
 
 #include <queue>
+#include <fstream>
+#include <atomic>
 
 Tag tag = L"MeshManager";
 
+namespace
+{
+	//The image file's bytes as they are in the glTF, either in a buffer view or in a file next to it. Images in data
+	//URIs aren't kept encoded by tinygltf so aren't found.
+	bool GetEncodedImage(const GLTFFile& kFile, const tinygltf::Image& kImage, const std::string& ksBaseDir, std::vector<BYTE>& fileData, const BYTE*& kpData, UINT64& uiSize)
+	{
+		if (kImage.bufferView >= 0)
+		{
+			const tinygltf::BufferView& kBufferView = kFile.GetModel().bufferViews[kImage.bufferView];
+
+			kpData = kFile.GetBufferViewData(kBufferView);
+			uiSize = kBufferView.byteLength;
+
+			return kpData != nullptr;
+		}
+
+		if (kImage.uri.empty() == true || kImage.uri.compare(0, 5, "data:") == 0)
+		{
+			return false;
+		}
+
+		std::ifstream inFile(ksBaseDir.empty() == true ? kImage.uri : ksBaseDir + "/" + kImage.uri, std::ios::binary | std::ios::ate);
+
+		if (inFile.is_open() == false)
+		{
+			return false;
+		}
+
+		fileData.resize((size_t)inFile.tellg());
+
+		inFile.seekg(0);
+		inFile.read((char*)fileData.data(), fileData.size());
+
+		if (inFile.fail() == true)
+		{
+			return false;
+		}
+
+		kpData = fileData.data();
+		uiSize = fileData.size();
+
+		return true;
+	}
+}
+
+PreparedMesh::PreparedMesh()
+{
+	m_pMesh = nullptr;
+	m_pFile = nullptr;
+	m_pCache = nullptr;
+
+	m_kpVertices = nullptr;
+	m_uiNumVertices = 0;
+	m_kpIndices = nullptr;
+	m_uiNumIndices = 0;
+}
+
+PreparedMesh::~PreparedMesh()
+{
+	delete m_pMesh;
+	delete m_pFile;
+	delete m_pCache;
+}
+
 void MeshManager::CreateDescriptors(DescriptorHeap* pHeap)
 {
 	UINT uiIndex;
@@ -55,85 +127,547 @@ void MeshManager::CreateDescriptors(DescriptorHeap* pHeap)
 
 bool MeshManager::LoadMesh(const std::string& sFilename, const std::string& sName, ID3D12GraphicsCommandList* pGraphicsCommandList)
 {
-	tinygltf::Model model;
-	tinygltf::TinyGLTF loader;
-	std::string err;
-	std::string warn;
+	PROFILE("Load Mesh");
 
-	bool bSuccess = loader.LoadASCIIFromFile(&model, &err, &warn, sFilename);
+	PreparedMesh prepared;
 
-	Mesh* pMesh = new Mesh();
+	if (PrepareMesh(sFilename, sName, prepared) == false)
+	{
+		return false;
+	}
 
-	pMesh->m_sFilePath = sFilename;
-	pMesh->m_sName = sName;
+	return CreateMesh(prepared, pGraphicsCommandList);
+}
+
+bool MeshManager::LoadMeshes(const std::vector<std::string>& kFilenames, const std::vector<std::string>& kNames, ID3D12GraphicsCommandList* pGraphicsCommandList)
+{
+	PROFILE("Load Meshes");
 
-	if (!warn.empty()) 
+	bool bSuccess = true;
+
+	PrepareMeshes(kFilenames, kNames, [this, &bSuccess, pGraphicsCommandList](int iIndex, PreparedMesh& prepared, bool bPrepared)
 	{
-		LOG_WARNING(tag, L"%s", warn);
-	}
+		if (bPrepared == false || CreateMesh(prepared, pGraphicsCommandList) == false)
+		{
+			bSuccess = false;
+		}
+	});
+
+	return bSuccess;
+}
 
-	if (!err.empty()) 
+bool MeshManager::PrepareMesh(const std::string& ksFilename, const std::string& ksName, PreparedMesh& prepared)
+{
+	prepared.m_pMesh = new Mesh();
+	prepared.m_pMesh->m_sFilePath = ksFilename;
+	prepared.m_pMesh->m_sName = ksName;
+
+	//A cooked mesh skips parsing the glTF and building the vertices and indices
+	std::string sCacheFilepath = MeshCache::GetCacheFilepath(ksFilename);
+
+	if (GetFileAttributesA(sCacheFilepath.c_str()) != INVALID_FILE_ATTRIBUTES)
 	{
-		LOG_ERROR(tag, L"%s", err);
+		prepared.m_pCache = new MeshCache();
+
+		if (prepared.m_pCache->Open(sCacheFilepath) == true && prepared.m_pCache->IsUpToDate(ksFilename) == true)
+		{
+			return PrepareCachedMesh(prepared);
+		}
+
+		delete prepared.m_pCache;
+		prepared.m_pCache = nullptr;
+
+		LOG_WARNING(tag, L"The mesh cache for %s can't be used, loading the glTF instead!", std::wstring(ksFilename.begin(), ksFilename.end()).c_str());
 	}
 
-	if (bSuccess == false) 
+	prepared.m_pFile = new GLTFFile();
+
+	if (prepared.m_pFile->Load(ksFilename) == false)
 	{
-		LOG_ERROR(tag, L"Failed to load mesh with name %s!", sFilename);
+		LOG_ERROR(tag, L"Failed to load mesh with name %s!", std::wstring(ksFilename.begin(), ksFilename.end()).c_str());
 
 		return false;
 	}
 
-	if (LoadTextures(sName, pMesh, model, pGraphicsCommandList) == false)
+	if (BuildMesh(*prepared.m_pFile, prepared.m_pMesh, prepared.m_Vertices, prepared.m_Indices) == false)
 	{
 		return false;
 	}
 
-	tinygltf::Scene* pScene;
+	prepared.m_kpVertices = prepared.m_Vertices.data();
+	prepared.m_uiNumVertices = (UINT)prepared.m_Vertices.size();
+	prepared.m_kpIndices = prepared.m_Indices.data();
+	prepared.m_uiNumIndices = (UINT)prepared.m_Indices.size();
+
+	const tinygltf::Model& kModel = prepared.m_pFile->GetModel();
 
-	if (model.defaultScene >= 0)
+	for (int i = 0; i < kModel.textures.size(); ++i)
 	{
-		pScene = &model.scenes[model.defaultScene];
+		prepared.m_TextureImages.push_back(&kModel.images[kModel.textures[i].source]);
+	}
+
+	return true;
+}
+
+bool MeshManager::PrepareCachedMesh(PreparedMesh& prepared)
+{
+	const MeshCache& kCache = *prepared.m_pCache;
+	const MeshCacheHeader& kHeader = kCache.GetHeader();
+
+	//Decoding is most of a cached load so a mesh's images are spread over the pool as well
+	prepared.m_Images.resize(kHeader.NumImages);
+
+	std::atomic<bool> bDecoded(true);
+
+	std::function<void(int, int)> decodeImages = [&kCache, &prepared, &bDecoded](int iStart, int iEnd)
+	{
+		for (int i = iStart; i < iEnd; ++i)
+		{
+			if (kCache.GetImage(i, prepared.m_Images[i]) == false)
+			{
+				bDecoded = false;
+			}
+		}
+	};
+
+	if (m_pThreadPool != nullptr)
+	{
+		m_pThreadPool->ParallelFor((int)kHeader.NumImages, 1, decodeImages);
 	}
 	else
 	{
-		pScene = &model.scenes[0];
+		decodeImages(0, (int)kHeader.NumImages);
+	}
+
+	if (bDecoded == false)
+	{
+		return false;
 	}
 
-	std::vector<Vertex> vertexBuffer = std::vector<Vertex>();
-	std::vector<UINT> indexBuffer = std::vector<UINT>();
+	for (UINT i = 0; i < kHeader.NumTextures; ++i)
+	{
+		prepared.m_TextureImages.push_back(&prepared.m_Images[kCache.GetTextureImages()[i]]);
+	}
+
+	BuildCachedMesh(kCache, prepared.m_pMesh);
+
+	prepared.m_kpVertices = kCache.GetVertices();
+	prepared.m_uiNumVertices = kHeader.NumVertices;
+	prepared.m_kpIndices = kCache.GetIndices();
+	prepared.m_uiNumIndices = kHeader.NumIndices;
+
+	return true;
+}
+
+void MeshManager::PrepareMeshes(const std::vector<std::string>& kFilenames, const std::vector<std::string>& kNames, const std::function<void(int, PreparedMesh&, bool)>& onPrepared)
+{
+	std::vector<PreparedMesh*> prepared(kFilenames.size());
+	std::vector<std::future<bool>> results(kFilenames.size());
+
+	for (int i = 0; i < kFilenames.size(); ++i)
+	{
+		prepared[i] = new PreparedMesh();
+	}
+
+	if (m_pThreadPool != nullptr)
+	{
+		for (int i = 0; i < kFilenames.size(); ++i)
+		{
+			results[i] = m_pThreadPool->Submit([this, &kFilenames, &kNames, &prepared, i]()
+			{
+				return PrepareMesh(kFilenames[i], kNames[i], *prepared[i]);
+			});
+		}
+	}
+
+	for (int i = 0; i < kFilenames.size(); ++i)
+	{
+		bool bPrepared = m_pThreadPool != nullptr ? results[i].get() : PrepareMesh(kFilenames[i], kNames[i], *prepared[i]);
+
+		onPrepared(i, *prepared[i], bPrepared);
+
+		//Frees the mesh's decoded images and file while later meshes are still being prepared
+		delete prepared[i];
+	}
+}
+
+bool MeshManager::CreateMesh(PreparedMesh& prepared, ID3D12GraphicsCommandList* pGraphicsCommandList)
+{
+	Mesh* pMesh = prepared.m_pMesh;
 
-	for (UINT i = 0; i < pScene->nodes.size(); ++i)
+	for (int i = 0; i < prepared.m_TextureImages.size(); ++i)
 	{
-		if (ProcessNode(nullptr, model.nodes[pScene->nodes[i]], pScene->nodes[i], model, pMesh, &vertexBuffer, &indexBuffer) == false)
+		Texture* pTexture;
+
+		std::string sTexName = pMesh->m_sName + "Tex" + std::to_string(i);
+
+		if (TextureManager::GetInstance()->LoadTexture(sTexName, *prepared.m_TextureImages[i], pTexture, pGraphicsCommandList) == false)
 		{
 			return false;
 		}
+
+		pMesh->m_Textures.push_back(pTexture);
 	}
 
-	pMesh->m_pVertexBuffer = new UploadBuffer<Vertex>(App::GetApp()->GetDevice(), vertexBuffer.size(), false);
-	pMesh->m_pVertexBuffer->CopyData(0, vertexBuffer);
+	CalculateBounds(pMesh, prepared.m_kpVertices);
 
-	pMesh->m_pIndexBuffer = new UploadBuffer<UINT>(App::GetApp()->GetDevice(), indexBuffer.size(), false);
-	pMesh->m_pIndexBuffer->CopyData(0, indexBuffer);
+	if (RegisterMesh(pMesh, prepared.m_kpVertices, prepared.m_uiNumVertices, prepared.m_kpIndices, prepared.m_uiNumIndices) == false)
+	{
+		return false;
+	}
+
+	prepared.m_pMesh = nullptr;
 
-	pMesh->m_uiNumVertices = vertexBuffer.size();
-	pMesh->m_uiNumIndices = indexBuffer.size();
+	return true;
+}
 
-	if (m_Meshes.count(sName) != 0)
+bool MeshManager::RegisterMesh(Mesh* pMesh, const Vertex* kpVertices, UINT uiNumVertices, const UINT* kpIndices, UINT uiNumIndices)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	if (m_Meshes.count(pMesh->m_sName) != 0)
 	{
-		LOG_ERROR(tag, L"Tried to create a new mesh called %s but one with that name already exists!", sName);
+		LOG_ERROR(tag, L"Tried to create a new mesh called %s but one with that name already exists!", std::wstring(pMesh->m_sName.begin(), pMesh->m_sName.end()).c_str());
 
 		return false;
 	}
 
-	m_Meshes[sName] = pMesh;
+	//Primitive indices index every mesh's primitives together
+	for (int i = 0; i < pMesh->m_Nodes.size(); ++i)
+	{
+		for (int j = 0; j < pMesh->m_Nodes[i]->m_Primitives.size(); ++j)
+		{
+			pMesh->m_Nodes[i]->m_Primitives[j]->m_iIndex += m_uiNumPrimitives;
+		}
+	}
+
+	m_uiNumPrimitives += pMesh->m_uiNumPrimitives;
+
+	UINT uiStride = VertexPackingHelper::GetVertexStride(m_iVertexFormat);
+
+	pMesh->m_iVertexFormat = m_iVertexFormat;
+	pMesh->m_pVertexBuffer = new UploadBuffer<BYTE>(App::GetApp()->GetDevice(), uiNumVertices, false, uiStride);
+
+	if (m_iVertexFormat == VERTEX_FORMAT_FULL)
+	{
+		pMesh->m_pVertexBuffer->CopyData(0, (const BYTE*)kpVertices, uiStride * uiNumVertices);
+	}
+	else
+	{
+		//Packed a primitive at a time as quantized positions are relative to the primitive's bounds
+		std::vector<BYTE> packedVertices(uiStride * (size_t)uiNumVertices);
+
+		if (m_iVertexFormat == VERTEX_FORMAT_QUANTIZED)
+		{
+			pMesh->m_pDequantizeBuffer = new UploadBuffer<DirectX::XMFLOAT3X4>(App::GetApp()->GetDevice(), pMesh->m_uiNumPrimitives, false);
+		}
+
+		UINT uiPrimitive = 0;
+
+		for (int i = 0; i < pMesh->m_Nodes.size(); ++i)
+		{
+			for (int j = 0; j < pMesh->m_Nodes[i]->m_Primitives.size(); ++j, ++uiPrimitive)
+			{
+				Primitive* pPrimitive = pMesh->m_Nodes[i]->m_Primitives[j];
+
+				if (m_iVertexFormat == VERTEX_FORMAT_QUANTIZED)
+				{
+					VertexPackingHelper::GetQuantization(kpVertices + pPrimitive->m_uiFirstVertex, pPrimitive->m_uiNumVertices, pPrimitive->m_PositionOffset, pPrimitive->m_PositionScale);
+
+					DirectX::XMFLOAT3X4 transform = VertexPackingHelper::GetDequantizeTransform(pPrimitive->m_PositionOffset, pPrimitive->m_PositionScale);
+					pMesh->m_pDequantizeBuffer->CopyData(uiPrimitive, &transform, 1);
+				}
+
+				VertexPackingHelper::PackVertices(kpVertices + pPrimitive->m_uiFirstVertex, pPrimitive->m_uiNumVertices, m_iVertexFormat, pPrimitive->m_PositionOffset, pPrimitive->m_PositionScale, packedVertices.data() + uiStride * (size_t)pPrimitive->m_uiFirstVertex);
+			}
+		}
+
+		pMesh->m_pVertexBuffer->CopyData(0, packedVertices.data(), (UINT)packedVertices.size());
+	}
+
+	pMesh->m_pIndexBuffer = new UploadBuffer<UINT>(App::GetApp()->GetDevice(), uiNumIndices, false);
+	pMesh->m_pIndexBuffer->CopyData(0, kpIndices, uiNumIndices);
+
+	pMesh->m_uiNumVertices = uiNumVertices;
+	pMesh->m_uiNumIndices = uiNumIndices;
+
+	m_Meshes[pMesh->m_sName] = pMesh;
 
 	return true;
 }
 
-bool MeshManager::ProcessNode(MeshNode* pParentNode, const tinygltf::Node& kNode, UINT16 uiNodeIndex, const tinygltf::Model& kModel, Mesh* pMesh, std::vector<Vertex>* pVertexBuffer, std::vector<UINT>* pIndexBuffer)
+void MeshManager::CalculateBounds(Mesh* pMesh, const Vertex* kpVertices)
 {
+	DirectX::XMFLOAT3 boundsMin = DirectX::XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+	DirectX::XMFLOAT3 boundsMax = DirectX::XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+	for (int i = 0; i < pMesh->m_Nodes.size(); ++i)
+	{
+		for (int j = 0; j < pMesh->m_Nodes[i]->m_Primitives.size(); ++j)
+		{
+			const Primitive* kpPrimitive = pMesh->m_Nodes[i]->m_Primitives[j];
+
+			if (kpPrimitive->m_uiNumVertices == 0)
+			{
+				continue;
+			}
+
+			DirectX::XMFLOAT3 primitiveMin = DirectX::XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+			DirectX::XMFLOAT3 primitiveMax = DirectX::XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+			for (UINT k = kpPrimitive->m_uiFirstVertex; k < kpPrimitive->m_uiFirstVertex + kpPrimitive->m_uiNumVertices; ++k)
+			{
+				const DirectX::XMFLOAT3& kPosition = kpVertices[k].Position;
+
+				primitiveMin = DirectX::XMFLOAT3((std::min)(primitiveMin.x, kPosition.x), (std::min)(primitiveMin.y, kPosition.y), (std::min)(primitiveMin.z, kPosition.z));
+				primitiveMax = DirectX::XMFLOAT3((std::max)(primitiveMax.x, kPosition.x), (std::max)(primitiveMax.y, kPosition.y), (std::max)(primitiveMax.z, kPosition.z));
+			}
+
+			//Only the corners go through the node's transform, not every vertex
+			MathHelper::TransformBounds(primitiveMin, primitiveMax, pMesh->m_Nodes[i]->m_Transform, primitiveMin, primitiveMax);
+
+			boundsMin = DirectX::XMFLOAT3((std::min)(boundsMin.x, primitiveMin.x), (std::min)(boundsMin.y, primitiveMin.y), (std::min)(boundsMin.z, primitiveMin.z));
+			boundsMax = DirectX::XMFLOAT3((std::max)(boundsMax.x, primitiveMax.x), (std::max)(boundsMax.y, primitiveMax.y), (std::max)(boundsMax.z, primitiveMax.z));
+		}
+	}
+
+	//A mesh without any vertices is treated as a point at its origin
+	if (boundsMin.x > boundsMax.x)
+	{
+		boundsMin = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+		boundsMax = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+	}
+
+	pMesh->m_BoundsMin = boundsMin;
+	pMesh->m_BoundsMax = boundsMax;
+}
+
+void MeshManager::BuildCachedMesh(const MeshCache& kCache, Mesh* pMesh)
+{
+	const MeshCacheHeader& kHeader = kCache.GetHeader();
+	const MeshCacheNode* kpNodes = kCache.GetNodes();
+	const MeshCachePrimitive* kpPrimitives = kCache.GetPrimitives();
+
+	pMesh->m_Nodes.reserve(kHeader.NumNodes);
+
+	for (UINT i = 0; i < kHeader.NumNodes; ++i)
+	{
+		MeshNode* pNode = new MeshNode();
+		pNode->m_uiIndex = (UINT16)kpNodes[i].Index;
+		pNode->m_sName = kCache.GetNodeName(i);
+		pNode->m_Transform = kpNodes[i].Transform;
+
+		for (UINT j = kpNodes[i].FirstPrimitive; j < kpNodes[i].FirstPrimitive + kpNodes[i].NumPrimitives; ++j)
+		{
+			const MeshCachePrimitive& kCachedPrimitive = kpPrimitives[j];
+
+			Primitive* pPrimitive = new Primitive();
+			pPrimitive->m_uiFirstIndex = kCachedPrimitive.FirstIndex;
+			pPrimitive->m_uiFirstVertex = kCachedPrimitive.FirstVertex;
+			pPrimitive->m_uiNumIndices = kCachedPrimitive.NumIndices;
+			pPrimitive->m_uiNumVertices = kCachedPrimitive.NumVertices;
+			pPrimitive->m_BaseColour = kCachedPrimitive.BaseColour;
+			pPrimitive->m_iAlbedoIndex = kCachedPrimitive.AlbedoIndex;
+			pPrimitive->m_iNormalIndex = kCachedPrimitive.NormalIndex;
+			pPrimitive->m_iMetallicRoughnessIndex = kCachedPrimitive.MetallicRoughnessIndex;
+			pPrimitive->m_iOcclusionIndex = kCachedPrimitive.OcclusionIndex;
+			pPrimitive->m_iIndex = kCachedPrimitive.Index;
+			pPrimitive->m_Attributes = (PrimitiveAttributes)kCachedPrimitive.Attributes;
+
+			pNode->m_Primitives.push_back(pPrimitive);
+		}
+
+		pMesh->m_Nodes.push_back(pNode);
+	}
+
+	//Children are stored before their parents, linking them in order keeps every parent's children in the order
+	//ProcessNode added them
+	for (UINT i = 0; i < kHeader.NumNodes; ++i)
+	{
+		if (kpNodes[i].Parent >= 0)
+		{
+			MeshNode* pNode = pMesh->m_Nodes[i];
+
+			pNode->m_pParent = pMesh->m_Nodes[kpNodes[i].Parent];
+			pNode->m_pParent->m_ChildNodes.push_back(pNode);
+		}
+	}
+
+	pMesh->m_uiNumPrimitives = kHeader.NumPrimitives;
+}
+
+bool MeshManager::CookMesh(const std::string& ksFilename)
+{
+	PROFILE("Cook Mesh");
+
+	GLTFFile file;
+
+	if (file.Load(ksFilename) == false)
+	{
+		LOG_ERROR(tag, L"Failed to load %s to cook it!", std::wstring(ksFilename.begin(), ksFilename.end()).c_str());
+
+		return false;
+	}
+
+	UINT64 uiSourceHash;
+	UINT64 uiSourceSize;
+
+	if (MeshCache::HashFile(ksFilename, uiSourceHash, uiSourceSize) == false)
+	{
+		return false;
+	}
+
+	Mesh mesh;
+	std::vector<Vertex> vertices;
+	std::vector<UINT> indices;
+
+	if (BuildMesh(file, &mesh, vertices, indices) == false)
+	{
+		return false;
+	}
+
+	std::unordered_map<const MeshNode*, int> nodeIndices;
+
+	for (int i = 0; i < mesh.m_Nodes.size(); ++i)
+	{
+		nodeIndices[mesh.m_Nodes[i]] = i;
+	}
+
+	std::vector<MeshCacheNode> nodes(mesh.m_Nodes.size());
+	std::vector<std::string> nodeNames(mesh.m_Nodes.size());
+	std::vector<MeshCachePrimitive> primitives;
+
+	for (int i = 0; i < mesh.m_Nodes.size(); ++i)
+	{
+		const MeshNode* kpNode = mesh.m_Nodes[i];
+
+		MeshCacheNode& node = nodes[i];
+		node = {};
+		node.Transform = kpNode->m_Transform;
+		node.Parent = kpNode->m_pParent != nullptr ? nodeIndices[kpNode->m_pParent] : -1;
+		node.Index = kpNode->m_uiIndex;
+		node.FirstPrimitive = (UINT32)primitives.size();
+		node.NumPrimitives = (UINT32)kpNode->m_Primitives.size();
+
+		nodeNames[i] = kpNode->m_sName;
+
+		for (int j = 0; j < kpNode->m_Primitives.size(); ++j)
+		{
+			const Primitive* kpPrimitive = kpNode->m_Primitives[j];
+
+			MeshCachePrimitive primitive = {};
+			primitive.BaseColour = kpPrimitive->m_BaseColour;
+			primitive.FirstIndex = kpPrimitive->m_uiFirstIndex;
+			primitive.NumIndices = kpPrimitive->m_uiNumIndices;
+			primitive.FirstVertex = kpPrimitive->m_uiFirstVertex;
+			primitive.NumVertices = kpPrimitive->m_uiNumVertices;
+			primitive.Index = kpPrimitive->m_iIndex;
+			primitive.AlbedoIndex = kpPrimitive->m_iAlbedoIndex;
+			primitive.NormalIndex = kpPrimitive->m_iNormalIndex;
+			primitive.MetallicRoughnessIndex = kpPrimitive->m_iMetallicRoughnessIndex;
+			primitive.OcclusionIndex = kpPrimitive->m_iOcclusionIndex;
+			primitive.Attributes = (UINT32)kpPrimitive->m_Attributes;
+
+			primitives.push_back(primitive);
+		}
+	}
+
+	const tinygltf::Model& kModel = file.GetModel();
+
+	std::vector<UINT32> textureImages(kModel.textures.size());
+
+	for (int i = 0; i < kModel.textures.size(); ++i)
+	{
+		textureImages[i] = (UINT32)kModel.textures[i].source;
+	}
+
+	//Images are kept encoded where possible so the cache is about the size of the glTF's images
+	std::string sBaseDir = GLTFFile::GetBaseDir(ksFilename);
+
+	std::vector<MeshCacheImage> images(kModel.images.size());
+	std::vector<const BYTE*> imageData(kModel.images.size());
+	std::vector<std::vector<BYTE>> imageFiles(kModel.images.size());
+
+	for (int i = 0; i < kModel.images.size(); ++i)
+	{
+		const tinygltf::Image& kImage = kModel.images[i];
+
+		MeshCacheImage& image = images[i];
+		image = {};
+
+		if (GetEncodedImage(file, kImage, sBaseDir, imageFiles[i], imageData[i], image.DataSize) == true)
+		{
+			image.DataType = MeshCacheImageData::ENCODED;
+		}
+		else
+		{
+			image.DataType = MeshCacheImageData::PIXELS;
+			image.Width = kImage.width;
+			image.Height = kImage.height;
+			image.Component = kImage.component;
+			image.Bits = kImage.bits;
+			image.PixelType = kImage.pixel_type;
+
+			imageData[i] = kImage.image.data();
+			image.DataSize = kImage.image.size();
+		}
+	}
+
+	return MeshCache::Write(MeshCache::GetCacheFilepath(ksFilename), uiSourceHash, uiSourceSize, vertices, indices, nodes, nodeNames, primitives, textureImages, images, imageData);
+}
+
+bool MeshManager::CookMeshes()
+{
+	bool bSuccess = true;
+
+	for (std::unordered_map<std::string, Mesh*>::iterator it = m_Meshes.begin(); it != m_Meshes.end(); ++it)
+	{
+		if (CookMesh(it->second->m_sFilePath) == false)
+		{
+			bSuccess = false;
+		}
+	}
+
+	return bSuccess;
+}
+
+bool MeshManager::BuildMesh(const GLTFFile& kFile, Mesh* pMesh, std::vector<Vertex>& vertices, std::vector<UINT>& indices)
+{
+	const tinygltf::Model& kModel = kFile.GetModel();
+
+	if (kModel.scenes.empty() == true)
+	{
+		LOG_ERROR(tag, L"Tried to build a mesh from a glTF without any scenes!");
+
+		return false;
+	}
+
+	const tinygltf::Scene* kpScene;
+
+	if (kModel.defaultScene >= 0)
+	{
+		kpScene = &kModel.scenes[kModel.defaultScene];
+	}
+	else
+	{
+		kpScene = &kModel.scenes[0];
+	}
+
+	for (UINT i = 0; i < kpScene->nodes.size(); ++i)
+	{
+		if (ProcessNode(nullptr, kModel.nodes[kpScene->nodes[i]], kpScene->nodes[i], kFile, pMesh, &vertices, &indices) == false)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool MeshManager::ProcessNode(MeshNode* pParentNode, const tinygltf::Node& kNode, UINT16 uiNodeIndex, const GLTFFile& kFile, Mesh* pMesh, std::vector<Vertex>* pVertexBuffer, std::vector<UINT>* pIndexBuffer)
+{
+	const tinygltf::Model& kModel = kFile.GetModel();
+
 	MeshNode* pNode = new MeshNode();
 	pNode->m_uiIndex = uiNodeIndex;
 	pNode->m_pParent = pParentNode;
@@ -194,7 +728,7 @@ bool MeshManager::ProcessNode(MeshNode* pParentNode, const tinygltf::Node& kNode
 
 	for (UINT i = 0; i < kNode.children.size(); ++i)
 	{
-		if (ProcessNode(pNode, kModel.nodes[kNode.children[i]], kNode.children[i], kModel, pMesh, pVertexBuffer, pIndexBuffer) == false)
+		if (ProcessNode(pNode, kModel.nodes[kNode.children[i]], kNode.children[i], kFile, pMesh, pVertexBuffer, pIndexBuffer) == false)
 		{
 			return false;
 		}
@@ -204,7 +738,6 @@ bool MeshManager::ProcessNode(MeshNode* pParentNode, const tinygltf::Node& kNode
 	{
 		const tinygltf::Mesh& kMesh = kModel.meshes[kNode.mesh];
 
-		m_uiNumPrimitives += kMesh.primitives.size();
 		pMesh->m_uiNumPrimitives += kMesh.primitives.size();
 
 		for (UINT i = 0; i < kMesh.primitives.size(); ++i)
@@ -216,62 +749,27 @@ bool MeshManager::ProcessNode(MeshNode* pParentNode, const tinygltf::Node& kNode
 			UINT uiVertexCount = 0;
 			bool bHasIndices = kPrimitive.indices >= 0;
 
-			//Vertex information buffers
-			const float* kpfPositionBuffer = nullptr;
-			const float* kpfNormalBuffer = nullptr;
-			const float* kpfTangentBuffer = nullptr;
-			const float* kpfTexCoordBuffer = nullptr;
-
-			UINT uiPositionStride;
-			UINT uiNormalStride;
-			UINT uiTexCoordStride;
-			UINT uiTangentStride;
-
 			Primitive* pPrimitive = new Primitive();
 
-			if (GetVertexData(kModel, kPrimitive, &kpfPositionBuffer, &uiPositionStride, &kpfNormalBuffer, &uiNormalStride, &kpfTexCoordBuffer, &uiTexCoordStride, &kpfTangentBuffer, &uiTangentStride, &uiVertexCount, pPrimitive) == false)
+			if (GetVertexData(kFile, kPrimitive, pVertexBuffer, &uiVertexCount, pPrimitive) == false)
 			{
 				return false;
 			}
 
-			Vertex vertex = {};
-
-			for (UINT j = 0; j < uiVertexCount; ++j)
-			{
-				vertex.Position = XMFLOAT3(kpfPositionBuffer[j * uiPositionStride], kpfPositionBuffer[(j * uiPositionStride) + 1], kpfPositionBuffer[(j * uiPositionStride) + 2]);
-
-				if (kpfNormalBuffer != nullptr)
-				{
-					XMStoreFloat3(&vertex.Normal, XMVector3Normalize(XMVectorSet(kpfNormalBuffer[j * uiNormalStride], kpfNormalBuffer[(j * uiNormalStride) + 1], kpfNormalBuffer[(j * uiNormalStride) + 2], 0.0f)));
-				}
-
-				if (kpfTangentBuffer != nullptr)
-				{
-					XMStoreFloat4(&vertex.Tangent, XMVector4Normalize(XMVectorSet(kpfTangentBuffer[j * uiTangentStride], kpfTangentBuffer[(j * uiTangentStride) + 1], kpfTangentBuffer[(j * uiTangentStride) + 2], kpfTangentBuffer[(j * uiTangentStride) + 3])));
-				}
-
-				if (kpfTexCoordBuffer != nullptr)
-				{
-					vertex.TexCoords = XMFLOAT2(kpfTexCoordBuffer[j * uiTexCoordStride], kpfTexCoordBuffer[(j * uiTexCoordStride) + 1]);
-				}
-
-				pVertexBuffer->push_back(vertex);
-			}
-
 			if (bHasIndices == true)
 			{
-				if (GetIndexData(kModel, kPrimitive, pIndexBuffer, &uiIndexCount) == false)
+				if (GetIndexData(kFile, kPrimitive, pIndexBuffer, &uiIndexCount) == false)
 				{
 					return false;
 				}
 			}
-			else //If no index buffer then create them
+			else //If no index buffer then create them, relative to the first vertex like the ones in a glTF
 			{
-				uiIndexCount = pVertexBuffer->size();
+				uiIndexCount = uiVertexCount;
 
-				for (int i = 0; i < uiIndexCount; ++i)
+				for (UINT j = 0; j < uiIndexCount; ++j)
 				{
-					pIndexBuffer->push_back((UINT)(i + uiVertexStart));
+					pIndexBuffer->push_back(j);
 				}
 			}
 
@@ -279,13 +777,18 @@ bool MeshManager::ProcessNode(MeshNode* pParentNode, const tinygltf::Node& kNode
 			pPrimitive->m_uiFirstVertex = uiVertexStart;
 			pPrimitive->m_uiNumIndices = uiIndexCount;
 			pPrimitive->m_uiNumVertices = uiVertexCount;
-			const std::vector<double>& baseColor = kModel.materials[kPrimitive.material].pbrMetallicRoughness.baseColorFactor;
+
+			//Primitives without a material use glTF's default one, which is what tinygltf constructs
+			const tinygltf::Material kDefaultMaterial;
+			const tinygltf::Material& kMaterial = kPrimitive.material >= 0 && kPrimitive.material < kModel.materials.size() ? kModel.materials[kPrimitive.material] : kDefaultMaterial;
+
+			const std::vector<double>& baseColor = kMaterial.pbrMetallicRoughness.baseColorFactor;
 			pPrimitive->m_BaseColour = DirectX::XMFLOAT4(baseColor[0], baseColor[1], baseColor[2], baseColor[3]);
-			pPrimitive->m_iAlbedoIndex = kModel.materials[kPrimitive.material].pbrMetallicRoughness.baseColorTexture.index;
-			pPrimitive->m_iNormalIndex = kModel.materials[kPrimitive.material].normalTexture.index;
-			pPrimitive->m_iMetallicRoughnessIndex = kModel.materials[kPrimitive.material].pbrMetallicRoughness.metallicRoughnessTexture.index;
-			pPrimitive->m_iOcclusionIndex = kModel.materials[kPrimitive.material].occlusionTexture.index;
-			pPrimitive->m_iIndex = m_uiNumPrimitives - kMesh.primitives.size() + i;
+			pPrimitive->m_iAlbedoIndex = kMaterial.pbrMetallicRoughness.baseColorTexture.index;
+			pPrimitive->m_iNormalIndex = kMaterial.normalTexture.index;
+			pPrimitive->m_iMetallicRoughnessIndex = kMaterial.pbrMetallicRoughness.metallicRoughnessTexture.index;
+			pPrimitive->m_iOcclusionIndex = kMaterial.occlusionTexture.index;
+			pPrimitive->m_iIndex = pMesh->m_uiNumPrimitives - kMesh.primitives.size() + i;
 
 			if (pPrimitive->m_iAlbedoIndex != -1)
 			{
@@ -316,32 +819,29 @@ bool MeshManager::ProcessNode(MeshNode* pParentNode, const tinygltf::Node& kNode
 	return true;
 }
 
-bool MeshManager::GetAttributeData(const tinygltf::Model& kModel, const tinygltf::Primitive& kPrimitive, std::string sAttribName, const float** kppfBuffer, UINT* puiStride, UINT* puiCount, uint32_t uiType)
+bool MeshManager::GetAttributeData(const GLTFFile& kFile, const tinygltf::Primitive& kPrimitive, const std::string& ksAttribName, UINT uiNumVertices, float* pOutput, int iNumComponents, bool* pbFound)
 {
-	if (kPrimitive.attributes.find(sAttribName) != kPrimitive.attributes.end())
-	{
-		const tinygltf::Accessor kAccessor = kModel.accessors[kPrimitive.attributes.find(sAttribName)->second];
-		const tinygltf::BufferView& kBufferView = kModel.bufferViews[kAccessor.bufferView];
+	const tinygltf::Model& kModel = kFile.GetModel();
 
-		*kppfBuffer = (const float*)&kModel.buffers[kBufferView.buffer].data[kAccessor.byteOffset + kBufferView.byteOffset];
+	auto it = kPrimitive.attributes.find(ksAttribName);
 
-		if (kAccessor.ByteStride(kBufferView) != 0)
-		{
-			*puiStride = (UINT)(kAccessor.ByteStride(kBufferView) / sizeof(float));
-		}
-		else
-		{
-			*puiStride = (UINT)(tinygltf::GetNumComponentsInType(uiType) * sizeof(float));
-		}
+	*pbFound = it != kPrimitive.attributes.end();
 
-		if (puiCount != nullptr)
-		{
-			*puiCount = (UINT)kAccessor.count;
-		}
+	if (*pbFound == false)
+	{
+		return true;
 	}
-	else
+
+	if (it->second < 0 || it->second >= kModel.accessors.size() || kModel.accessors[it->second].count != uiNumVertices)
 	{
-		LOG_ERROR(tag, L"Failed to find attribute data with name %s for primitive!", sAttribName);
+		LOG_ERROR(tag, L"Attribute %s doesn't have an accessor with an element for every vertex!", std::wstring(ksAttribName.begin(), ksAttribName.end()).c_str());
+
+		return false;
+	}
+
+	if (kFile.DecodeAccessor(kModel.accessors[it->second], pOutput, sizeof(Vertex), iNumComponents) == false)
+	{
+		LOG_ERROR(tag, L"Failed to decode attribute %s!", std::wstring(ksAttribName.begin(), ksAttribName.end()).c_str());
 
 		return false;
 	}
@@ -349,6 +849,61 @@ bool MeshManager::GetAttributeData(const tinygltf::Model& kModel, const tinygltf
 	return true;
 }
 
+void MeshManager::ApplyTextureTransform(const GLTFFile& kFile, const tinygltf::Primitive& kPrimitive, Vertex* pVertices, UINT uiNumVertices)
+{
+	const tinygltf::Model& kModel = kFile.GetModel();
+
+	if (kPrimitive.material < 0 || kPrimitive.material >= kModel.materials.size())
+	{
+		return;
+	}
+
+	const tinygltf::ExtensionMap& kExtensions = kModel.materials[kPrimitive.material].pbrMetallicRoughness.baseColorTexture.extensions;
+
+	auto it = kExtensions.find("KHR_texture_transform");
+
+	if (it == kExtensions.end())
+	{
+		return;
+	}
+
+	const tinygltf::Value& kTransform = it->second;
+
+	float fOffset[2] = { 0.0f, 0.0f };
+	float fScale[2] = { 1.0f, 1.0f };
+	float fRotation = 0.0f;
+
+	if (kTransform.Has("offset") == true && kTransform.Get("offset").ArrayLen() == 2)
+	{
+		fOffset[0] = (float)kTransform.Get("offset").Get(0).GetNumberAsDouble();
+		fOffset[1] = (float)kTransform.Get("offset").Get(1).GetNumberAsDouble();
+	}
+
+	if (kTransform.Has("scale") == true && kTransform.Get("scale").ArrayLen() == 2)
+	{
+		fScale[0] = (float)kTransform.Get("scale").Get(0).GetNumberAsDouble();
+		fScale[1] = (float)kTransform.Get("scale").Get(1).GetNumberAsDouble();
+	}
+
+	if (kTransform.Has("rotation") == true)
+	{
+		fRotation = (float)kTransform.Get("rotation").GetNumberAsDouble();
+	}
+
+	float fCos = cosf(fRotation);
+	float fSin = sinf(fRotation);
+
+	for (UINT i = 0; i < uiNumVertices; ++i)
+	{
+		XMFLOAT2& texCoords = pVertices[i].TexCoords;
+
+		float fU = texCoords.x * fScale[0];
+		float fV = texCoords.y * fScale[1];
+
+		texCoords = XMFLOAT2(fOffset[0] + fCos * fU + fSin * fV, fOffset[1] - fSin * fU + fCos * fV);
+	}
+}
+
 UINT MeshManager::GetNumMeshes() const
 {
 	return m_Meshes.size();
@@ -404,6 +959,8 @@ void MeshManager::Save(nlohmann::json& data)
 		data["Meshes"]["Name"].push_back(it->first);
 		data["Meshes"]["Filepath"].push_back(it->second->m_sFilePath);
 	}
+
+	data["Meshes"]["VertexFormat"] = m_iVertexFormat;
 }
 
 void MeshManager::LoadScene(const std::string& ksFilepath, ID3D12GraphicsCommandList* pGraphicsCommandList)
@@ -423,37 +980,44 @@ void MeshManager::LoadScene(const std::string& ksFilepath, ID3D12GraphicsCommand
 
 	inFile.close();
 
+	std::vector<std::string> filepaths;
+	std::vector<std::string> names;
+
 	for (int i = 0; i < data["Meshes"]["Name"].size(); ++i)
 	{
-		LoadMesh(data["Meshes"]["Filepath"][i], data["Meshes"]["Name"][i], pGraphicsCommandList);
+		filepaths.push_back(data["Meshes"]["Filepath"][i]);
+		names.push_back(data["Meshes"]["Name"][i]);
 	}
-}
-
-bool MeshManager::LoadTextures(std::string sName, Mesh* pMesh, const tinygltf::Model kModel, ID3D12GraphicsCommandList* pGraphicsCommandList)
-{
-	tinygltf::Image image;
 
-	for (UINT i = 0; i < kModel.textures.size(); ++i)
-	{
-		image = kModel.images[kModel.textures[i].source];
+	m_iVertexFormat = data["Meshes"].contains("VertexFormat") == true ? (int)data["Meshes"]["VertexFormat"] : VERTEX_FORMAT_FULL;
 
-		Texture* pTexture;
+	LoadMeshes(filepaths, names, pGraphicsCommandList);
+}
 
-		std::string sTexName = sName + "Tex" + std::to_string(i);
+void MeshManager::SetThreadPool(ThreadPool* pThreadPool)
+{
+	m_pThreadPool = pThreadPool;
+}
 
-		if (TextureManager::GetInstance()->LoadTexture(sTexName, image, pTexture, pGraphicsCommandList) == false)
-		{
-			return false;
-		}
+ThreadPool* MeshManager::GetThreadPool() const
+{
+	return m_pThreadPool;
+}
 
-		pMesh->m_Textures.push_back(pTexture);
-	}
+void MeshManager::SetVertexFormat(int iVertexFormat)
+{
+	m_iVertexFormat = iVertexFormat;
+}
 
-	return true;
+int MeshManager::GetVertexFormat() const
+{
+	return m_iVertexFormat;
 }
 
 bool MeshManager::GetMesh(std::string sName, Mesh*& pMesh)
 {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
 	if (m_Meshes.count(sName) == 0)
 	{
 		LOG_ERROR(tag, L"Tried to get a mesh called %s but one with that name doesn't exist!", sName);
@@ -468,6 +1032,8 @@ bool MeshManager::GetMesh(std::string sName, Mesh*& pMesh)
 
 bool MeshManager::RemoveMesh(std::string sName)
 {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
 	if (m_Meshes.count(sName) == 0)
 	{
 		LOG_ERROR(tag, L"Tried to remove a mesh called %s but one with that name doesn't exist!", sName);
@@ -480,89 +1046,87 @@ bool MeshManager::RemoveMesh(std::string sName)
 	return true;
 }
 
-bool MeshManager::GetVertexData(const tinygltf::Model& kModel, const tinygltf::Primitive& kPrimitive, const float** kppfPositionBuffer, UINT* puiPositionStride, const float** kppfNormalBuffer, UINT* puiNormalStride, const float** kppfTexCoordBuffer, UINT* puiTexCoordStride, const float** kppfTangentBuffer, UINT* puiTangentStride, UINT* puiVertexCount, Primitive* pPrimitive)
+bool MeshManager::GetVertexData(const GLTFFile& kFile, const tinygltf::Primitive& kPrimitive, std::vector<Vertex>* pVertexBuffer, UINT* puiVertexCount, Primitive* pPrimitive)
 {
-	if (GetAttributeData(kModel, kPrimitive, "POSITION", kppfPositionBuffer, puiPositionStride, puiVertexCount, TINYGLTF_TYPE_VEC3) == false)
+	const tinygltf::Model& kModel = kFile.GetModel();
+
+	auto it = kPrimitive.attributes.find("POSITION");
+
+	if (it == kPrimitive.attributes.end() || it->second < 0 || it->second >= kModel.accessors.size())
 	{
+		LOG_ERROR(tag, L"Failed to find attribute data with name POSITION for primitive!");
+
 		return false;
 	}
 
-	if (GetAttributeData(kModel, kPrimitive, "TEXCOORD_0", kppfTexCoordBuffer, puiTexCoordStride, nullptr, TINYGLTF_TYPE_VEC2) == false)
+	UINT uiVertexStart = (UINT)pVertexBuffer->size();
+
+	*puiVertexCount = (UINT)kModel.accessors[it->second].count;
+
+	//Attributes the primitive doesn't have are left as zero
+	pVertexBuffer->resize(uiVertexStart + *puiVertexCount);
+
+	Vertex* pVertices = pVertexBuffer->data() + uiVertexStart;
+
+	bool bPosition;
+	bool bNormal;
+	bool bTangent;
+	bool bTexCoords;
+
+	if (GetAttributeData(kFile, kPrimitive, "POSITION", *puiVertexCount, &pVertices->Position.x, 3, &bPosition) == false ||
+		GetAttributeData(kFile, kPrimitive, "NORMAL", *puiVertexCount, &pVertices->Normal.x, 3, &bNormal) == false ||
+		GetAttributeData(kFile, kPrimitive, "TANGENT", *puiVertexCount, &pVertices->Tangent.x, 4, &bTangent) == false ||
+		GetAttributeData(kFile, kPrimitive, "TEXCOORD_0", *puiVertexCount, &pVertices->TexCoords.x, 2, &bTexCoords) == false)
 	{
+		pVertexBuffer->resize(uiVertexStart);
+
 		return false;
 	}
 
-	if (GetAttributeData(kModel, kPrimitive, "NORMAL", kppfNormalBuffer, puiNormalStride, nullptr, TINYGLTF_TYPE_VEC3) == true)
+	if (bNormal == true)
 	{
-
+		AccessorHelper::NormalizeFloat3(&pVertices->Normal.x, sizeof(Vertex), *puiVertexCount);
 	}
 
-	if (GetAttributeData(kModel, kPrimitive, "TANGENT", kppfTangentBuffer, puiTangentStride, nullptr, TINYGLTF_TYPE_VEC4) == true)
+	if (bTangent == true)
 	{
+		//W is the handedness of the bitangent so only the direction is normalized
+		AccessorHelper::NormalizeFloat3(&pVertices->Tangent.x, sizeof(Vertex), *puiVertexCount);
+
 		//has normal map so enable bit
 		pPrimitive->m_Attributes = pPrimitive->m_Attributes | PrimitiveAttributes::NORMAL;
 	}
 
-	return true;
-}
-
-bool MeshManager::GetIndexData(const tinygltf::Model& kModel, const tinygltf::Primitive& kPrimitive, std::vector<UINT>* pIndexBuffer, UINT* puiIndexCount)
-{
-	const tinygltf::Accessor* kpAccessor;
-
-	if (kPrimitive.indices >= 0)
-	{
-		kpAccessor = &kModel.accessors[kPrimitive.indices];
-	}
-	else
+	if (bTexCoords == true)
 	{
-		kpAccessor = &kModel.accessors[0];
+		ApplyTextureTransform(kFile, kPrimitive, pVertices, *puiVertexCount);
 	}
 
-	const tinygltf::BufferView& kBufferView = kModel.bufferViews[kpAccessor->bufferView];
-	const tinygltf::Buffer& kBuffer = kModel.buffers[kBufferView.buffer];
-
-	*puiIndexCount = (UINT)kpAccessor->count;
+	return true;
+}
 
-	const void* pData = &kBuffer.data[kpAccessor->byteOffset + kBufferView.byteOffset];
+bool MeshManager::GetIndexData(const GLTFFile& kFile, const tinygltf::Primitive& kPrimitive, std::vector<UINT>* pIndexBuffer, UINT* puiIndexCount)
+{
+	const tinygltf::Model& kModel = kFile.GetModel();
 
-	switch (kpAccessor->componentType)
-	{
-	case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT:
+	if (kPrimitive.indices < 0 || kPrimitive.indices >= kModel.accessors.size())
 	{
-		const UINT* pUINTData = (const UINT*)pData;
+		LOG_ERROR(tag, L"The primitive's index accessor doesn't exist!");
 
-		for (UINT i = 0; i < *puiIndexCount; ++i)
-		{
-			pIndexBuffer->push_back((UINT)(pUINTData[i]));
-		}
+		return false;
 	}
-	break;
 
-	case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT:
-	{
-		const UINT16* pUINTData = (const UINT16*)pData;
+	const tinygltf::Accessor& kAccessor = kModel.accessors[kPrimitive.indices];
 
-		for (UINT i = 0; i < *puiIndexCount; ++i)
-		{
-			pIndexBuffer->push_back((UINT)pUINTData[i]);
-		}
-	}
-	break;
+	UINT uiIndexStart = (UINT)pIndexBuffer->size();
 
-	case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE:
-	{
-		const uint8_t* pUINTData = (const uint8_t*)pData;
+	*puiIndexCount = (UINT)kAccessor.count;
 
-		for (UINT i = 0; i < *puiIndexCount; ++i)
-		{
-			pIndexBuffer->push_back((UINT)pUINTData[i]);
-		}
-	}
-	break;
+	pIndexBuffer->resize(uiIndexStart + *puiIndexCount);
 
-	default:
-		LOG_ERROR(tag, L"The tinygltf index data type %i isn't supported!");
+	if (kFile.DecodeIndices(kAccessor, pIndexBuffer->data() + uiIndexStart) == false)
+	{
+		pIndexBuffer->resize(uiIndexStart);
 
 		return false;
 	}
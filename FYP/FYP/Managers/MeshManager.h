@@ -8,6 +8,8 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <functional>
+#include <mutex>
 
 
 #define TINYGLTF_IMPLEMENTATION
@@ -18,8 +20,11 @@
 
 class Texture;
 class DescriptorHeap;
+class GLTFFile;
+class MeshCache;
 class Descriptor;
 class Mesh;
+class ThreadPool;
 
 struct MeshNode;
 struct Vertex;
@@ -30,8 +35,41 @@ namespace tinygltf
 	class Node;
 
 	struct Primitive;
+	struct Image;
 }
 
+//The CPU side of loading a mesh. MeshManager::PrepareMesh fills it on any thread then MeshManager::CreateMesh creates
+//its D3D12 resources on the thread recording the command list.
+struct PreparedMesh
+{
+	PreparedMesh();
+	~PreparedMesh();
+
+	PreparedMesh(const PreparedMesh& rhs) = delete;
+	PreparedMesh& operator=(const PreparedMesh& rhs) = delete;
+
+	Mesh* m_pMesh;
+
+	//Only one is loaded, a cache is kept mapped as the vertices and indices are used straight from it
+	GLTFFile* m_pFile;
+	MeshCache* m_pCache;
+
+	//Built from the glTF
+	std::vector<Vertex> m_Vertices;
+	std::vector<UINT> m_Indices;
+
+	const Vertex* m_kpVertices;
+	UINT m_uiNumVertices;
+	const UINT* m_kpIndices;
+	UINT m_uiNumIndices;
+
+	//A cache's decoded images, tinygltf decodes a glTF's into its model
+	std::vector<tinygltf::Image> m_Images;
+
+	//The image each of the mesh's textures uploads
+	std::vector<const tinygltf::Image*> m_TextureImages;
+};
+
 class MeshManager : public Singleton<MeshManager>
 {
 public:
@@ -39,6 +77,29 @@ public:
 
 	bool LoadMesh(const std::string& sFilename, const std::string& sName, ID3D12GraphicsCommandList* pGraphicsCommandList);
 
+	//Prepares the meshes on the thread pool if one is set and creates them on the calling thread as they become ready,
+	//in the order they're listed so primitive indices are the same as loading them one at a time
+	bool LoadMeshes(const std::vector<std::string>& kFilenames, const std::vector<std::string>& kNames, ID3D12GraphicsCommandList* pGraphicsCommandList);
+
+	//Loads the glTF or its cache, builds the vertices and indices and decodes the textures without touching any D3D12
+	//resources or the manager so it can run on any thread
+	bool PrepareMesh(const std::string& ksFilename, const std::string& ksName, PreparedMesh& prepared);
+
+	//Runs PrepareMesh for every mesh on the thread pool, or the calling thread if there isn't one, and calls onPrepared
+	//on the calling thread with each mesh in order once it's ready
+	void PrepareMeshes(const std::vector<std::string>& kFilenames, const std::vector<std::string>& kNames, const std::function<void(int, PreparedMesh&, bool)>& onPrepared);
+
+	//Fills pMesh's nodes and primitives and the vertices and indices to upload from a loaded glTF without touching any
+	//D3D12 resources or the manager's counts. Primitive indices are relative to the mesh until LoadMesh registers it.
+	bool BuildMesh(const GLTFFile& kFile, Mesh* pMesh, std::vector<Vertex>& vertices, std::vector<UINT>& indices);
+
+	//Same as BuildMesh for a cooked mesh, the vertices and indices are used straight from the cache
+	void BuildCachedMesh(const MeshCache& kCache, Mesh* pMesh);
+
+	//Writes a MeshCache next to the glTF that LoadMesh uses instead of the glTF for as long as the glTF is unchanged
+	bool CookMesh(const std::string& ksFilename);
+	bool CookMeshes();
+
 	bool GetMesh(std::string sName, Mesh*& pMesh);
 	bool RemoveMesh(std::string sName);
 
@@ -58,18 +119,47 @@ public:
 	void Save(nlohmann::json& data);
 	void LoadScene(const std::string& ksFilepath, ID3D12GraphicsCommandList* pGraphicsCommandList);
 
+	//Used to load meshes in parallel, nullptr loads them one at a time on the calling thread
+	void SetThreadPool(ThreadPool* pThreadPool);
+	ThreadPool* GetThreadPool() const;
+
+	//VERTEX_FORMAT_ value meshes registered afterwards store their vertices in, saved with the scene
+	void SetVertexFormat(int iVertexFormat);
+	int GetVertexFormat() const;
+
 private:
-	bool ProcessNode(MeshNode* pParentNode,const tinygltf::Node& kNode, UINT16 uiNodeIndex, const tinygltf::Model& kModel, Mesh* pMesh, std::vector<Vertex>* pVertexBuffer, std::vector<UINT>* pIndexBuffer);
+	bool ProcessNode(MeshNode* pParentNode,const tinygltf::Node& kNode, UINT16 uiNodeIndex, const GLTFFile& kFile, Mesh* pMesh, std::vector<Vertex>* pVertexBuffer, std::vector<UINT>* pIndexBuffer);
+
+	//Appends the primitive's vertices, only POSITION is required
+	bool GetVertexData(const GLTFFile& kFile, const tinygltf::Primitive& kPrimitive, std::vector<Vertex>* pVertexBuffer, UINT* puiVertexCount, Primitive* pPrimitive);
+	bool GetIndexData(const GLTFFile& kFile, const tinygltf::Primitive& kPrimitive, std::vector<UINT>* pIndexBuffer, UINT* puiIndexCount);
 
-	bool GetVertexData(const tinygltf::Model& kModel, const tinygltf::Primitive& kPrimitive, const float** kppfPositionBuffer, UINT* puiPositionStride, const float** kppfNormalBuffer, UINT* puiNormalStride, const float** kppfTexCoordBuffer, UINT* puiTexCoordStride, const float** kppfTangentBuffer, UINT* puiTangentStride, UINT* puiVertexCount, Primitive* pPrimitive);
-	bool GetIndexData(const tinygltf::Model& kModel, const tinygltf::Primitive& kPrimitive, std::vector<UINT>* pIndexBuffer, UINT* puiIndexCount);
+	//Decodes the attribute into the vertices pOutput points into, pbFound is false if the primitive doesn't have it
+	bool GetAttributeData(const GLTFFile& kFile, const tinygltf::Primitive& kPrimitive, const std::string& ksAttribName, UINT uiNumVertices, float* pOutput, int iNumComponents, bool* pbFound);
 
-	bool GetAttributeData(const tinygltf::Model& kModel, const tinygltf::Primitive& kPrimitive, std::string sAttribName, const float** kppfBuffer, UINT* puiStride, UINT* puiCount, uint32_t uiType);
+	//Bakes the base colour texture's KHR_texture_transform into the texture coordinates as every texture uses the same set
+	void ApplyTextureTransform(const GLTFFile& kFile, const tinygltf::Primitive& kPrimitive, Vertex* pVertices, UINT uiNumVertices);
 
-	bool LoadTextures(std::string sName, Mesh* pMesh, const tinygltf::Model kModel, ID3D12GraphicsCommandList* pGraphicsCommandList);
+	bool PrepareCachedMesh(PreparedMesh& prepared);
+
+	//Uploads the textures and registers the mesh, the manager owns the mesh afterwards
+	bool CreateMesh(PreparedMesh& prepared, ID3D12GraphicsCommandList* pGraphicsCommandList);
+
+	//Bounds of the mesh in the space its game objects' world matrices are applied to, see Mesh::GetBoundsMin
+	void CalculateBounds(Mesh* pMesh, const Vertex* kpVertices);
+
+	//Creates the mesh's vertex and index buffers and adds it to the manager
+	bool RegisterMesh(Mesh* pMesh, const Vertex* kpVertices, UINT uiNumVertices, const UINT* kpIndices, UINT uiNumIndices);
 
 	std::unordered_map<std::string, Mesh*> m_Meshes;
 
+	//Guards m_Meshes and m_uiNumPrimitives when registering, getting and removing meshes
+	std::mutex m_Mutex;
+
+	ThreadPool* m_pThreadPool = nullptr;
+
+	int m_iVertexFormat = 0;	//VERTEX_FORMAT_ value
+
 	UINT m_uiNumPrimitives = 0;
 	UINT m_uiNumActivePrimitives = 0;
 	UINT m_uiNumActiveRaytracedPrimitives = 0;
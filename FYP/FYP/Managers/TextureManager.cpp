@@ -156,6 +156,8 @@ bool TextureManager::LoadTexture(std::string sName, const tinygltf::Image& kImag
 		pTexture = pTempTexture;
 	}
 
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
 	m_Textures[sName] = pTempTexture;
 
 	return true;
@@ -173,5 +175,7 @@ bool TextureManager::RemoveTexture(const std::string& ksName)
 
 UINT TextureManager::GetNumTextures() const
 {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
 	return m_Textures.size();
 }
@@ -4,6 +4,7 @@
 #include "Include/DirectX/d3dx12.h"
 
 #include <unordered_map>
+#include <mutex>
 
 class Texture;
 class DescriptorHeap;
@@ -16,6 +17,7 @@ namespace tinygltf
 class TextureManager : public Singleton<TextureManager>
 {
 public:
+	//Safe to call from any thread as long as only one thread records to pGraphicsCommandList at a time
 	bool LoadTexture(std::string sName, const tinygltf::Image& kImage, Texture*& pTexture, ID3D12GraphicsCommandList* pGraphicsCommandList);
 
 	bool GetTexture(const std::string& ksName, Texture*& pTexture);
@@ -27,5 +29,7 @@ protected:
 
 private:
 	std::unordered_map<std::string, Texture*> m_Textures;
+
+	mutable std::mutex m_Mutex;
 };
 
@@ -0,0 +1,5 @@
+@echo off
+
+rem Runs the CPU benchmarks on both scenes, results are written to Times\Benchmarks-<scene>-<run name>.json
+%1\FYP.exe Scenes\Sponza.json %2 -bench
+%1\FYP.exe Scenes\Cornell.json %2 -bench
\ No newline at end of file
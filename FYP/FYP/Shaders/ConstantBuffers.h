@@ -157,7 +157,8 @@ struct PrimitiveInstanceCB
 
 	UINT32 MetallicRoughnessIndex;
 	UINT32 OcclusionIndex;
-	XMFLOAT2 pad;
+	UINT32 VertexFormat;	//VERTEX_FORMAT_ value
+	float pad;
 };
 
 struct DeferredPerFrameCB
@@ -166,6 +167,8 @@ struct DeferredPerFrameCB
 	UINT32 DirectLightIndex;
 	UINT32 PositionIndex;
 	UINT32 NormalIndex;
+
+	int NumGICascades;
 };
 
 struct RaytracePerFrameCB
@@ -200,10 +203,40 @@ struct RaytracePerFrameCB
 	int RayDataIndex;
 
 	XMINT3 ProbeOffsets;
-	float pad;
+	int ProbeDataIndex;
 
 	XMINT3 ClearPlane;
-	float pad2;
+	int ProbeRelocation;
+
+	float ProbeMinFrontfaceDistance;
+	float ProbeBackfaceThreshold;
+	int ProbeClassification;
+	int ActiveProbeListIndex;
+
+	int UseActiveProbeList;	//Only the probes in the active probe list are traced and blended this frame
+	int AdaptiveRays;	//Each probe traces the number of rays in the probe ray counts buffer, RaysPerProbe is the most any probe can have
+	int ProbeRayCountsIndex;
+	int ProbeStatsIndex;
+
+	int IrradianceEncoding;
+	int NumSHCoefficients;	//0 when the irradiance atlas is octahedral
+	int PerProbeRayRotation;	//Each probe's rays are spun by GetProbeRayRotation on top of RayRotation
+	int RayDirectionTableIndex;	//-1 when the ray directions have to be worked out per ray
+
+	int AtlasLayout;	//PROBE_ATLAS_LAYOUT_ value, how the probes' tiles are arranged in every probe atlas
+	int ProbePositionsIndex;	//World position and state of every probe in atlas order, only filled in while the probes are shown
+	float ProbeScale;	//Radius the probes are drawn at
+	int pad;
+
+	int AdaptiveHysteresis;	//Each probe's irradiance hysteresis is tracked between MinHysteresis and Hysteresis
+	float MinHysteresis;
+	float HysteresisRiseRate;
+	float HysteresisChangeThreshold;
+
+	int ProbeFilter;	//PROBE_FILTER_ value, the irradiance atlas is filtered across neighbouring probes after blending
+	float ProbeFilterStrength;	//Weight of a fully visible face neighbour relative to the probe itself
+	int FullProbeUpdate;	//Inactive probes are in this frame's list too, so classification and relocation look at them again
+	int TracedProbeMask;	//The active probe list was built on the CPU and is followed by a bit per probe, set for the probes traced this frame
 };
 
 #endif // CONSTANT_BUFFERS_H
\ No newline at end of file
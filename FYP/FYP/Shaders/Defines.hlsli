@@ -3,9 +3,35 @@
 
 #define FORMAT_PROBE_RAY_DATA_R32G32_FLOAT 0
 #define FORMAT_PROBE_RAY_DATA_R32G32B32A32_FLOAT 1
+#define FORMAT_PROBE_RAY_DATA_RGB9E5 2        //R32G32 texture with the packed radiance's bits in R
+#define FORMAT_PROBE_RAY_DATA_R11G11B10 3     //R32G32 texture with the packed radiance's bits in R
 
 #define FORMAT_PROBE_IRRADIANCE_R10G10B10A2_FLOAT 0
 #define FORMAT_PROBE_IRRADIANCE_R32G32B32A32_FLOAT 1
+#define FORMAT_PROBE_IRRADIANCE_R11G11B10_FLOAT 2
+
+//Shared exponents are kept between 1 and 30 so the packed word is always a normal float once rotated into a ray data texel
+#define RGB9E5_MAX 32704.0f
+#define R11G11B10_R_MAX 65024.0f
+#define R11G11B10_B_MAX 64512.0f
+#define R11G11B10_MIN 0.00006103515625f       //Smallest normal value, anything below is flushed to zero
+
+#define PROBE_IRRADIANCE_ENCODING_OCTAHEDRAL 0
+#define PROBE_IRRADIANCE_ENCODING_SH_L1 1
+#define PROBE_IRRADIANCE_ENCODING_SH_L2 2
+
+#define MAX_SH_COEFFICIENTS 9
+
+#define PROBE_ATLAS_LAYOUT_PLANES 0
+#define PROBE_ATLAS_LAYOUT_BRICKS 1     //Pairs of y planes interleaved so each 2x2x2 brick of probes is a 4x2 block of tiles
+
+#define PROBE_FILTER_NONE 0
+#define PROBE_FILTER_6_NEIGHBOURS 1     //Face neighbours only
+#define PROBE_FILTER_26_NEIGHBOURS 2    //Face, edge and corner neighbours
+
+#define VERTEX_FORMAT_FULL 0
+#define VERTEX_FORMAT_PACKED 1          //Octahedral normals and tangents and half texture coordinates
+#define VERTEX_FORMAT_QUANTIZED 2       //Packed with 16 bit positions within each primitive's bounds as well
 
 #define DIRECTIONAL_LIGHT 0
 #define POINT_LIGHT 1
@@ -13,6 +39,11 @@
 #define CONTRIBUTE_GI 1
 #define RAYTRACE 2
 
+#define PROBE_STATE_ACTIVE 0
+#define PROBE_STATE_INACTIVE 1
+
+#define MAX_GI_CASCADES 4
+
 static const float PI = 3.14159265f;
 
 #endif
\ No newline at end of file
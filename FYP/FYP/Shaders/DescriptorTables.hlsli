@@ -4,5 +4,6 @@
 Texture2D Tex2DTable[] : register(t0, space0);
 Buffer<uint> BufferUintTable[] : register(t0, space1);
 Texture2D<float> FloatTex2DTable[] : register(t0, space2);
+Buffer<float4> BufferFloat4Table[] : register(t0, space3);
 
 #endif
\ No newline at end of file
@@ -38,14 +38,19 @@ void ClosestHit(inout PackedPayload packedPayload, in BuiltInTriangleIntersectio
     indices.y = BufferUintTable[geomInfo.IndicesIndex][primitiveIndex * 3 + 1];
     indices.z = BufferUintTable[geomInfo.IndicesIndex][primitiveIndex * 3 + 2];
 
-    StructuredBuffer<Vertex> vertices = Vertices[geomInfo.VerticesIndex];
+    Vertex vertices[3] =
+    {
+        GetVertex(geomInfo.VerticesIndex, geomInfo.VertexFormat, indices.x),
+        GetVertex(geomInfo.VerticesIndex, geomInfo.VertexFormat, indices.y),
+        GetVertex(geomInfo.VerticesIndex, geomInfo.VertexFormat, indices.z)
+    };
     
     //Get relevant mesh information at point on tri
     float3 normals[3] =
     {
-        vertices[indices.x].Normal,
-        vertices[indices.y].Normal,
-        vertices[indices.z].Normal
+        vertices[0].Normal,
+        vertices[1].Normal,
+        vertices[2].Normal
     };
     
     float3 normalL = InterpolateAttribute(normals, attr);
@@ -53,14 +58,14 @@ void ClosestHit(inout PackedPayload packedPayload, in BuiltInTriangleIntersectio
     
     //Calculate hit pos UV coords
     float3 bary = float3(1.0 - attr.barycentrics.x - attr.barycentrics.y, attr.barycentrics.x, attr.barycentrics.y);
-    float2 uv = bary.x * vertices[indices.x].TexCoords + bary.y * vertices[indices.y].TexCoords + bary.z * vertices[indices.z].TexCoords;
+    float2 uv = bary.x * vertices[0].TexCoords + bary.y * vertices[1].TexCoords + bary.z * vertices[2].TexCoords;
     
 #if NORMAL_MAPPING
     float3 tangents[3] =
     {
-        vertices[indices.x].Tangent.xyz,
-        vertices[indices.y].Tangent.xyz,
-        vertices[indices.z].Tangent.xyz
+        vertices[0].Tangent.xyz,
+        vertices[1].Tangent.xyz,
+        vertices[2].Tangent.xyz
     };
     
     float3 tangent = InterpolateAttribute(tangents, attr);
@@ -11,5 +11,6 @@ typedef float4x4 XMMATRIX;
 typedef uint UINT;
 typedef uint UINT32;
 typedef int3 XMINT3;
+typedef uint2 XMUINT2;
 
 #endif // HLSLCOMPAT_H
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include "DescriptorTables.hlsli"
 #include "ProbeHelper.hlsl"
 #include "Samplers.hlsli"
+#include "SphericalHarmonics.hlsl"
 
 //RGB is radiance and W is distance
 float4 GetIrradiance(float3 posW, float3 surfaceBias, float3 direction, RaytracePerFrameCB raytracingPerFrameCB)
@@ -33,7 +34,12 @@ float4 GetIrradiance(float3 posW, float3 surfaceBias, float3 direction, Raytrace
         int3 probeCoords = clamp(closestProbeCoords + probeOffset, int3(0, 0, 0), raytracingPerFrameCB.ProbeCounts - 1);
         int probeIndex = GetOffsettedProbeIndex(probeCoords, raytracingPerFrameCB.ProbeCounts, raytracingPerFrameCB.ProbeOffsets);
         
-        float3 probeCoordsWorld = GetProbeCoordsWorld(probeCoords, raytracingPerFrameCB.VolumePosition, raytracingPerFrameCB.ProbeOffsets, raytracingPerFrameCB.ProbeSpacing, raytracingPerFrameCB.ProbeCounts);
+        if (raytracingPerFrameCB.ProbeClassification == true && IsProbeActive(probeIndex, raytracingPerFrameCB.ProbeCounts, raytracingPerFrameCB.AtlasLayout, Tex2DTable[raytracingPerFrameCB.ProbeDataIndex]) == false)
+        {
+            continue;
+        }
+        
+        float3 probeCoordsWorld = GetProbeCoordsWorld(probeCoords, raytracingPerFrameCB.VolumePosition, raytracingPerFrameCB.ProbeOffsets, raytracingPerFrameCB.ProbeSpacing, raytracingPerFrameCB.ProbeCounts, raytracingPerFrameCB.ProbeRelocation, raytracingPerFrameCB.AtlasLayout, Tex2DTable[raytracingPerFrameCB.ProbeDataIndex]);
         
         float3 toProbe = normalize(probeCoordsWorld - posW);
         float3 biasedToProbe = probeCoordsWorld - biasedPosW;
@@ -49,21 +55,12 @@ float4 GetIrradiance(float3 posW, float3 surfaceBias, float3 direction, Raytrace
         float weight = wrapShading * wrapShading + 0.2f;
 
         float2 octCoords = GetOctahedralCoords(-biasedToProbe);
-        float2 atlasCoords = GetAtlasCoords(probeIndex, octCoords, raytracingPerFrameCB.NumDistanceTexels, raytracingPerFrameCB.ProbeCounts);
+        float2 atlasCoords = GetAtlasCoords(probeIndex, octCoords, raytracingPerFrameCB.NumDistanceTexels, raytracingPerFrameCB.ProbeCounts, raytracingPerFrameCB.AtlasLayout);
 
         //R component is distance, G component is distance squared
         float2 distance = 2.0f * distanceAtlas.SampleLevel(SamLinearWrap, atlasCoords, 0).rg;
         
-        float variance = abs(distance.x * distance.x - distance.y);
-
-        float chebyshevWeight = 1.0f;
-        if (biasedToProbeDistance > distance.x)
-        {
-            float v = biasedToProbeDistance - distance.x;
-            chebyshevWeight = variance / (v * v + variance);
-
-            chebyshevWeight = max(chebyshevWeight * chebyshevWeight * chebyshevWeight, 0.0f);
-        }
+        float chebyshevWeight = GetChebyshevWeight(distance, biasedToProbeDistance);
         
         weight *= max(0.05f, chebyshevWeight);
         weight = max(0.000001f, weight);
@@ -77,11 +74,21 @@ float4 GetIrradiance(float3 posW, float3 surfaceBias, float3 direction, Raytrace
         float trilinearWeight = trilinear.x * trilinear.y * trilinear.z;
         weight *= trilinearWeight;
 
-        octCoords = GetOctahedralCoords(direction);
-        atlasCoords = GetAtlasCoords(probeIndex, octCoords, raytracingPerFrameCB.NumIrradianceTexels, raytracingPerFrameCB.ProbeCounts);
+        float3 probeIrradiance;
+        
+        if (raytracingPerFrameCB.IrradianceEncoding == PROBE_IRRADIANCE_ENCODING_OCTAHEDRAL)
+        {
+            octCoords = GetOctahedralCoords(direction);
+            atlasCoords = GetAtlasCoords(probeIndex, octCoords, raytracingPerFrameCB.NumIrradianceTexels, raytracingPerFrameCB.ProbeCounts, raytracingPerFrameCB.AtlasLayout);
 
-        float3 probeIrradiance = irradianceAtlas.SampleLevel(SamLinearWrap, atlasCoords, 0).rgb;
-        probeIrradiance = pow(probeIrradiance, raytracingPerFrameCB.IrradianceGammaEncoding * 0.5f);
+            probeIrradiance = irradianceAtlas.SampleLevel(SamLinearWrap, atlasCoords, 0).rgb;
+            probeIrradiance = pow(probeIrradiance, raytracingPerFrameCB.IrradianceGammaEncoding * 0.5f);
+        }
+        else
+        {
+            //SH isn't gamma encoded so only the square root the octahedral decode leaves in is needed
+            probeIrradiance = sqrt(max(0.0f, EvaluateSHIrradiance(probeIndex, direction, raytracingPerFrameCB.NumSHCoefficients, raytracingPerFrameCB.ProbeCounts, raytracingPerFrameCB.AtlasLayout, irradianceAtlas)));
+        }
 
         irradiance.rgb += (weight * probeIrradiance);
         irradiance.w += (trilinearWeight * distance.x);
@@ -102,7 +109,7 @@ float4 GetIrradiance(float3 posW, float3 surfaceBias, float3 direction, Raytrace
 
     irradiance.w *= 1.0f / accumulatedDistanceWeights;
     
-    if (raytracingPerFrameCB.IrradianceFormat == FORMAT_PROBE_IRRADIANCE_R10G10B10A2_FLOAT)
+    if (raytracingPerFrameCB.IrradianceEncoding == PROBE_IRRADIANCE_ENCODING_OCTAHEDRAL && raytracingPerFrameCB.IrradianceFormat == FORMAT_PROBE_IRRADIANCE_R10G10B10A2_FLOAT)
     {
         irradiance.rgb *= 1.0989f;
     }
@@ -110,4 +117,26 @@ float4 GetIrradiance(float3 posW, float3 surfaceBias, float3 direction, Raytrace
     return irradiance;
 }
 
+//Adds one cascade's share of the irradiance at posW, cascades have to be passed in finest first. remainingWeight starts
+//at 1 and is whatever the finer cascades didn't cover, the same as GICascades::GetCascadeWeights on the CPU.
+void AccumulateCascadeIrradiance(float3 posW, float3 normalW, float3 eyePosW, RaytracePerFrameCB raytracingPerFrameCB, inout float3 irradiance, inout float remainingWeight)
+{
+    if (remainingWeight <= 0.0f)
+    {
+        return;
+    }
+    
+    float blendWeight = GetBlendWeight(posW, raytracingPerFrameCB.VolumePosition, raytracingPerFrameCB.ProbeOffsets, raytracingPerFrameCB.ProbeSpacing, raytracingPerFrameCB.ProbeCounts) * remainingWeight;
+    
+    if (blendWeight <= 0.0f)
+    {
+        return;
+    }
+    
+    float3 surfaceBias = GetSurfaceBias(normalW, normalize(posW - eyePosW), raytracingPerFrameCB.NormalBias, raytracingPerFrameCB.ViewBias);
+    
+    irradiance += GetIrradiance(posW, surfaceBias, normalW, raytracingPerFrameCB).rgb * blendWeight;
+    remainingWeight -= blendWeight;
+}
+
 #endif
\ No newline at end of file
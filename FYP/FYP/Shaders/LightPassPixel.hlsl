@@ -7,11 +7,37 @@ struct PS_INPUT
     float2 TexCoords : TEXCOORD;
 };
 
+struct PS_OUTPUT
+{
+    float4 Color : SV_TARGET;
+    float Depth : SV_DEPTH;
+};
+
 ConstantBuffer<DeferredPerFrameCB> l_DeferredPerFrameCB : register(b1);
 ConstantBuffer<RaytracePerFrameCB> l_RaytracePerFrameCB : register(b2);
+ConstantBuffer<RaytracePerFrameCB> l_RaytraceCascade1CB : register(b3);
+ConstantBuffer<RaytracePerFrameCB> l_RaytraceCascade2CB : register(b4);
+ConstantBuffer<RaytracePerFrameCB> l_RaytraceCascade3CB : register(b5);
 
-float4 main(PS_INPUT input) : SV_TARGET
+PS_OUTPUT main(PS_INPUT input)
 {
+    PS_OUTPUT output;
+    
+    //The G buffer is ray traced so nothing else fills the depth buffer, W is -1 where the G buffer ray missed everything
+    float4 surfaceW = Tex2DTable[l_DeferredPerFrameCB.PositionIndex][uint2(input.PosH.xy)];
+    
+    if (surfaceW.w >= 0.0f)
+    {
+        float4 surfaceH = mul(float4(surfaceW.xyz, 1.0f), g_ScenePerFrameCB.ViewProjection);
+        
+        output.Depth = saturate(surfaceH.z / surfaceH.w);
+    }
+    else
+    {
+        output.Depth = 1.0f;
+    }
+    
+
     //Get primitive information from textures
     float3 color = Tex2DTable[l_DeferredPerFrameCB.DirectLightIndex].SampleLevel(SamLinearClamp, input.TexCoords, 0).rgb;
     
@@ -20,16 +46,33 @@ float4 main(PS_INPUT input) : SV_TARGET
     float3 albedo = Tex2DTable[l_DeferredPerFrameCB.AlbedoIndex].SampleLevel(SamAnisotropicWrap, input.TexCoords, 0).rgb;
     float3 posW = Tex2DTable[l_DeferredPerFrameCB.PositionIndex].SampleLevel(SamLinearClamp, input.TexCoords, 0).xyz;
     
-    float blendWeight = GetBlendWeight(posW, l_RaytracePerFrameCB.VolumePosition, l_RaytracePerFrameCB.ProbeOffsets, l_RaytracePerFrameCB.ProbeSpacing, l_RaytracePerFrameCB.ProbeCounts);
-    float3 surfaceBias = GetSurfaceBias(normalW, normalize(posW - g_ScenePerFrameCB.EyePosW), l_RaytracePerFrameCB.NormalBias, l_RaytracePerFrameCB.ViewBias);
-    float4 indirectLight = GetIrradiance(posW, surfaceBias, normalW, l_RaytracePerFrameCB);
+    float3 indirectLight = float3(0, 0, 0);
+    float remainingWeight = 1.0f;
     
-    if (blendWeight > 0.0f)
+    //Finest cascade first, each coarser one fills in what is left as the finer ones fade out
+    AccumulateCascadeIrradiance(posW, normalW, g_ScenePerFrameCB.EyePosW, l_RaytracePerFrameCB, indirectLight, remainingWeight);
+    
+    if (l_DeferredPerFrameCB.NumGICascades > 1)
+    {
+        AccumulateCascadeIrradiance(posW, normalW, g_ScenePerFrameCB.EyePosW, l_RaytraceCascade1CB, indirectLight, remainingWeight);
+    }
+    
+    if (l_DeferredPerFrameCB.NumGICascades > 2)
+    {
+        AccumulateCascadeIrradiance(posW, normalW, g_ScenePerFrameCB.EyePosW, l_RaytraceCascade2CB, indirectLight, remainingWeight);
+    }
+    
+    if (l_DeferredPerFrameCB.NumGICascades > 3)
+    {
+        AccumulateCascadeIrradiance(posW, normalW, g_ScenePerFrameCB.EyePosW, l_RaytraceCascade3CB, indirectLight, remainingWeight);
+    }
+    
+    if (remainingWeight < 1.0f)
     {
 #if SHOW_INDIRECT
-        color = (albedo * indirectLight.rgb * blendWeight) / PI;
+        color = (albedo * indirectLight) / PI;
 #else
-        color += (albedo * indirectLight.rgb * blendWeight) / PI;
+        color += (albedo * indirectLight) / PI;
 #endif
     }
 #endif    
@@ -40,5 +83,7 @@ float4 main(PS_INPUT input) : SV_TARGET
     color /= (color + float3(1.0f, 1.0f, 1.0f));
     color = pow(color, float3(fMapping, fMapping, fMapping));
     
-    return float4(color, 1.0f);
+    output.Color = float4(color, 1.0f);
+    
+    return output;
 }
\ No newline at end of file
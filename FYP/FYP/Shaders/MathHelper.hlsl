@@ -32,6 +32,71 @@ float3 UintToFloat3(uint input)
     return output;
 }
 
+//Same bit layout as DXGI_FORMAT_R9G9B9E5_SHAREDEXP. Only integer and power of two maths is used so Helpers/ProbeHelper.h
+//gives exactly the same bits on the CPU.
+uint Float3ToRGB9E5(float3 input)
+{
+    float3 clamped = min(max(input, 0.0f), RGB9E5_MAX);
+    float maxChannel = max(clamped.r, max(clamped.g, clamped.b));
+
+    //Floor of log2 comes straight from the float's exponent
+    int sharedExponent = clamp(int(asuint(maxChannel) >> 23) - 127 + 16, 1, 30);
+
+    //2 ^ (mantissa bits + bias - shared exponent)
+    float scale = asfloat(uint(127 + 24 - sharedExponent) << 23);
+
+    if (FloatToUint(maxChannel, scale) == 512)
+    {
+        ++sharedExponent;
+        scale *= 0.5f;
+    }
+
+    return FloatToUint(clamped.r, scale) | (FloatToUint(clamped.g, scale) << 9) | (FloatToUint(clamped.b, scale) << 18) | (uint(sharedExponent) << 27);
+}
+
+float3 RGB9E5ToFloat3(uint input)
+{
+    float scale = asfloat(((input >> 27) + 127 - 24) << 23);
+
+    return float3(input & 0x000001FF, (input >> 9) & 0x000001FF, (input >> 18) & 0x000001FF) * scale;
+}
+
+//Unsigned float with a 5 bit exponent as used by R11G11B10. Rounds to nearest and flushes denormals to zero.
+uint FloatToUnsignedFloat(float input, uint mantissaBits, float maxValue)
+{
+    uint bits = asuint(min(max(input, 0.0f), maxValue));
+
+    if (bits < asuint(R11G11B10_MIN))
+    {
+        return 0;
+    }
+
+    bits += 1u << (22 - mantissaBits);
+
+    return (bits >> (23 - mantissaBits)) - ((127 - 15) << mantissaBits);
+}
+
+float UnsignedFloatToFloat(uint input, uint mantissaBits)
+{
+    if (input < (1u << mantissaBits))
+    {
+        return 0.0f;
+    }
+
+    return asfloat((input + ((127 - 15) << mantissaBits)) << (23 - mantissaBits));
+}
+
+//Same bit layout as DXGI_FORMAT_R11G11B10_FLOAT
+uint Float3ToR11G11B10(float3 input)
+{
+    return FloatToUnsignedFloat(input.r, 6, R11G11B10_R_MAX) | (FloatToUnsignedFloat(input.g, 6, R11G11B10_R_MAX) << 11) | (FloatToUnsignedFloat(input.b, 5, R11G11B10_B_MAX) << 22);
+}
+
+float3 R11G11B10ToFloat3(uint input)
+{
+    return float3(UnsignedFloatToFloat(input & 0x000007FF, 6), UnsignedFloatToFloat((input >> 11) & 0x000007FF, 6), UnsignedFloatToFloat(input >> 22, 5));
+}
+
 float3 QuaternionRotate(float3 vec, float4 quat)
 {
     return vec * (quat.w * quat.w - dot(quat.xyz, quat.xyz)) + quat.xyz * 2.0f * dot(vec, quat.xyz) + cross(quat.xyz, vec) * quat.w * 2.0f;
@@ -42,4 +107,10 @@ float4 QuaternionConjugate(float4 quat)
     return float4(-quat.xyz, quat.w);
 }
 
+//Rotating by the result is the same as rotating by b then by a
+float4 QuaternionMultiply(float4 a, float4 b)
+{
+    return float4(a.w * b.xyz + b.w * a.xyz + cross(a.xyz, b.xyz), a.w * b.w - dot(a.xyz, b.xyz));
+}
+
 #endif
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "RaytracingCommons.hlsli"
 
 #if BLEND_RADIANCE
+RWTexture2D<float2> ProbeHysteresis : register(u2);     //Laid out like the probe data atlas, only used with adaptive hysteresis
 RWTexture2D<float4> IrradianceData : register(u1);
 #else
 RWTexture2D<float4> DistanceData : register(u1);
@@ -9,25 +10,41 @@ RWTexture2D<float4> DistanceData : register(u1);
 
 #if BLEND_RADIANCE
 groupshared float3 RayRadiances[BLEND_RAYS_PER_PROBE];
+
+groupshared float2 TexelLuminances[NUM_TEXELS_PER_PROBE * NUM_TEXELS_PER_PROBE];
+groupshared float ProbeHysteresisValue;
 #endif
 
 groupshared float3 RayDirections[BLEND_RAYS_PER_PROBE];
 groupshared float RayDistances[BLEND_RAYS_PER_PROBE];
 
+//One group per probe, either dispatched over the whole volume or over the active probe list
 [numthreads(NUM_TEXELS_PER_PROBE, NUM_TEXELS_PER_PROBE, 1)]
-void main(uint3 DTid : SV_DispatchThreadID, uint groupIndex : SV_GroupIndex)
+void main(uint3 GTid : SV_GroupThreadID, uint3 Gid : SV_GroupID, uint groupIndex : SV_GroupIndex)
 {
     float4 result = float4(0, 0, 0, 0);
     
     int numProbes = g_RaytracePerFrame.ProbeCounts.x * g_RaytracePerFrame.ProbeCounts.y * g_RaytracePerFrame.ProbeCounts.z;
-    int probeIndex = GetProbeIndex(DTid.xy, NUM_TEXELS_PER_PROBE, g_RaytracePerFrame.ProbeCounts);
+    int probeIndex;
+    
+    if (g_RaytracePerFrame.UseActiveProbeList == true)
+    {
+        probeIndex = BufferUintTable[g_RaytracePerFrame.ActiveProbeListIndex][Gid.x + 1];
+    }
+    else
+    {
+        probeIndex = GetProbeIndex(Gid.xy, 1, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.AtlasLayout);
+    }
 
     if (probeIndex >= numProbes || probeIndex < 0)
     {
         return;
     }
+    
+    //Same as the dispatch thread ID when dispatched over the whole volume
+    uint2 DTid = uint2(GetProbeDataCoords(probeIndex, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.AtlasLayout)) * NUM_TEXELS_PER_PROBE + GTid.xy;
 
-    uint2 atlasCoords = uint2(1, 1) + DTid.xy + (DTid.xy / NUM_TEXELS_PER_PROBE) * 2;
+    uint2 atlasCoords = uint2(1, 1) + DTid + (DTid / NUM_TEXELS_PER_PROBE) * 2;
     
     int3 probeCoords = GetProbeCoords(probeIndex, g_RaytracePerFrame.ProbeCounts);
     
@@ -45,10 +62,22 @@ void main(uint3 DTid : SV_DispatchThreadID, uint groupIndex : SV_GroupIndex)
 
     if(clearedPlane == true)
     {
+#if BLEND_RADIANCE
+        //The plane now holds new probes so they start converging from scratch
+        if (g_RaytracePerFrame.AdaptiveHysteresis == true && groupIndex == 0)
+        {
+            ProbeHysteresis[GetProbeDataCoords(probeIndex, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.AtlasLayout)] = float2(0.0f, 0.0f);
+        }
+#endif
+        
         return;
     }
     
-    float2 octCoords = GetNormalizedOctahedralCoords(DTid.xy, NUM_TEXELS_PER_PROBE);
+    int numRays = GetProbeNumRays(probeIndex, g_RaytracePerFrame.AdaptiveRays, g_RaytracePerFrame.RaysPerProbe, BufferUintTable[g_RaytracePerFrame.ProbeRayCountsIndex]);
+    
+    float4 rayRotation = GetProbeRayRotation(probeIndex, g_RaytracePerFrame.RayRotation, g_RaytracePerFrame.PerProbeRayRotation);
+    
+    float2 octCoords = GetNormalizedOctahedralCoords(DTid, NUM_TEXELS_PER_PROBE);
     float3 direction = GetOctahedralDirection(octCoords);
     
     //Load all necessary data into shared memory
@@ -60,7 +89,7 @@ void main(uint3 DTid : SV_DispatchThreadID, uint groupIndex : SV_GroupIndex)
     {
         int rayIndex = (totalIterations * groupIndex) + i;
 
-        if (rayIndex >= BLEND_RAYS_PER_PROBE)
+        if (rayIndex >= numRays)
         {
             break;
         }
@@ -70,17 +99,24 @@ void main(uint3 DTid : SV_DispatchThreadID, uint groupIndex : SV_GroupIndex)
 #endif
         
         RayDistances[rayIndex] = GetRayDistance(uint2(rayIndex, probeIndex), g_RaytracePerFrame.RayDataFormat, Tex2DTable[g_RaytracePerFrame.RayDataIndex]);
-        RayDirections[rayIndex] = GetRayDirection(rayIndex, g_RaytracePerFrame.RaysPerProbe, g_RaytracePerFrame.RayRotation);
+        if (g_RaytracePerFrame.RayDirectionTableIndex != -1)
+        {
+            RayDirections[rayIndex] = GetTableRayDirection(rayIndex, probeIndex, g_RaytracePerFrame.PerProbeRayRotation, BufferFloat4Table[g_RaytracePerFrame.RayDirectionTableIndex]);
+        }
+        else
+        {
+            RayDirections[rayIndex] = GetRayDirection(rayIndex, numRays, rayRotation);
+        }
     }
 
     GroupMemoryBarrierWithGroupSync();
     
 #if BLEND_RADIANCE
     uint numBackfaceHits = 0;
-    uint maxBackfaceHits = g_RaytracePerFrame.RaysPerProbe * 0.1f;
+    uint maxBackfaceHits = numRays * 0.1f;
 #endif
     
-    for (i = 0; i < g_RaytracePerFrame.RaysPerProbe; ++i)
+    for (i = 0; i < numRays; ++i)
     {
         float weight = max(0.0f, dot(direction, RayDirections[i]));
 
@@ -111,7 +147,7 @@ void main(uint3 DTid : SV_DispatchThreadID, uint groupIndex : SV_GroupIndex)
 #endif
     }
     
-    float epsilon = float(g_RaytracePerFrame.RaysPerProbe) * 1e-9f;
+    float epsilon = float(numRays) * 1e-9f;
     
     result.rgb *= 1.0f / (2.0f * max(result.a, epsilon));
 
@@ -123,6 +159,36 @@ void main(uint3 DTid : SV_DispatchThreadID, uint groupIndex : SV_GroupIndex)
     //Tonemap
     result.rgb = pow(result.rgb, 1.0f / g_RaytracePerFrame.IrradianceGammaEncoding);
     
+    //Every texel's luminance is summed to see how much the whole probe changed this frame, which sets its hysteresis
+    if (g_RaytracePerFrame.AdaptiveHysteresis == true)
+    {
+        TexelLuminances[groupIndex] = float2(GetLuminance(result.rgb), GetLuminance(previous));
+        
+        GroupMemoryBarrierWithGroupSync();
+        
+        if (groupIndex == 0)
+        {
+            float2 luminance = float2(0.0f, 0.0f);
+            
+            for (i = 0; i < NUM_TEXELS_PER_PROBE * NUM_TEXELS_PER_PROBE; ++i)
+            {
+                luminance += TexelLuminances[i];
+            }
+            
+            uint2 stateCoords = GetProbeDataCoords(probeIndex, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.AtlasLayout);
+            float change = GetProbeIrradianceChange(luminance.x, luminance.y, NUM_TEXELS_PER_PROBE * NUM_TEXELS_PER_PROBE);
+            
+            float2 state = UpdateProbeHysteresis(ProbeHysteresis[stateCoords], change, g_RaytracePerFrame.MinHysteresis, g_RaytracePerFrame.Hysteresis, g_RaytracePerFrame.HysteresisRiseRate, g_RaytracePerFrame.HysteresisChangeThreshold);
+            
+            ProbeHysteresis[stateCoords] = state;
+            ProbeHysteresisValue = state.x;
+        }
+        
+        GroupMemoryBarrierWithGroupSync();
+        
+        hysteresis = ProbeHysteresisValue;
+    }
+    
     float3 delta = result.rgb - previous.rgb;
     
     if (max(max(previous.r - result.r, previous.g - result.g), previous.b - result.b) > g_RaytracePerFrame.IrradianceThreshold)
@@ -140,7 +206,8 @@ void main(uint3 DTid : SV_DispatchThreadID, uint groupIndex : SV_GroupIndex)
     
     if (max(max(result.r, result.g), result.b) < max(max(previous.r, previous.g), previous.b))
     {
-        lerpDelta = min(max(c_threshold, abs(lerpDelta)), abs(delta) * sign(lerpDelta));
+        //Clamp the size of the step then put the sign back, a negative bound would snap darkening texels straight to the new value
+        lerpDelta = min(max(c_threshold, abs(lerpDelta)), abs(delta)) * sign(lerpDelta);
     }
     
     IrradianceData[atlasCoords] = float4(previous + lerpDelta, 1.0f);
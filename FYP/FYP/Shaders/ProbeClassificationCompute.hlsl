@@ -0,0 +1,81 @@
+#include "ProbeHelper.hlsl"
+#include "RaytracingCommons.hlsli"
+
+RWBuffer<uint> ActiveProbes : register(u3);	//First element is the number of active probes, the atlas indices follow
+RWTexture2D<float4> ProbeData : register(u1);
+
+void AppendActiveProbe(int probeIndex)
+{
+    uint slot;
+    InterlockedAdd(ActiveProbes[0], 1, slot);
+    
+    ActiveProbes[slot + 1] = probeIndex;
+}
+
+//Marks probes as inactive when they are mostly inside geometry or have no surface close enough for them to shade.
+//Active probes are appended to the list the next frame's trace and blend are limited to.
+[numthreads(8, 8, 1)]
+void main(uint3 DTid : SV_DispatchThreadID)
+{
+    int numProbes = g_RaytracePerFrame.ProbeCounts.x * g_RaytracePerFrame.ProbeCounts.y * g_RaytracePerFrame.ProbeCounts.z;
+    int probeIndex = GetProbeIndex(DTid.xy, 1, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.AtlasLayout);
+
+    if (DTid.x >= uint(g_RaytracePerFrame.ProbeCounts.x * g_RaytracePerFrame.ProbeCounts.y) || DTid.y >= uint(g_RaytracePerFrame.ProbeCounts.z) || probeIndex >= numProbes)
+    {
+        return;
+    }
+    
+    float4 probeData = ProbeData[DTid.xy];
+    
+    //Probes left out of this frame's trace have nothing new to classify them with so keep their state.
+    //The buffer is bound for writing here so the traced probe mask after the list is read through the UAV.
+    uint tracedProbeBits = ActiveProbes[GetTracedProbeMaskIndex(probeIndex, g_RaytracePerFrame.ProbeCounts)];
+    
+    if (WasProbeTraced(probeIndex, probeData.w, tracedProbeBits, g_RaytracePerFrame.UseActiveProbeList, g_RaytracePerFrame.FullProbeUpdate, g_RaytracePerFrame.TracedProbeMask) == false)
+    {
+        if (probeData.w == PROBE_STATE_ACTIVE)
+        {
+            AppendActiveProbe(probeIndex);
+        }
+        
+        return;
+    }
+    
+    int numBackfaceHits = 0;
+    
+    float maxSurfaceDistance = length(g_RaytracePerFrame.ProbeSpacing);
+    bool nearSurface = false;
+    
+    int numRays = GetProbeNumRays(probeIndex, g_RaytracePerFrame.AdaptiveRays, g_RaytracePerFrame.RaysPerProbe, BufferUintTable[g_RaytracePerFrame.ProbeRayCountsIndex]);
+    
+    for (int i = 0; i < numRays; ++i)
+    {
+        float rayDistance = GetRayDistance(uint2(i, probeIndex), g_RaytracePerFrame.RayDataFormat, Tex2DTable[g_RaytracePerFrame.RayDataIndex]);
+        
+        if (rayDistance < 0.0f)
+        {
+            ++numBackfaceHits;
+            
+            continue;
+        }
+        
+        if (rayDistance <= maxSurfaceDistance)
+        {
+            nearSurface = true;
+        }
+    }
+    
+    int state = PROBE_STATE_ACTIVE;
+    
+    if ((numBackfaceHits / float(numRays)) > g_RaytracePerFrame.ProbeBackfaceThreshold || nearSurface == false)
+    {
+        state = PROBE_STATE_INACTIVE;
+    }
+    
+    ProbeData[DTid.xy] = float4(probeData.xyz, state);
+    
+    if (state == PROBE_STATE_ACTIVE)
+    {
+        AppendActiveProbe(probeIndex);
+    }
+}
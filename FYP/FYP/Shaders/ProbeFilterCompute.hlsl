@@ -0,0 +1,154 @@
+#include "ProbeHelper.hlsl"
+#include "RaytracingCommons.hlsli"
+
+RWTexture2D<float4> IrradianceData : register(u5);          //Unfiltered irradiance, only read so the filter never feeds back into the blend
+RWTexture2D<float4> FilteredIrradianceData : register(u1);
+
+#if FILTER_SH
+//SH probes are a row of coefficients with no border
+#define FILTER_TILE_WIDTH NUM_SH_COEFFICIENTS
+#define FILTER_TILE_HEIGHT 1
+#define FILTER_TILE_BORDER 0
+#else
+#define FILTER_TILE_WIDTH NUM_TEXELS_PER_PROBE
+#define FILTER_TILE_HEIGHT NUM_TEXELS_PER_PROBE
+#define FILTER_TILE_BORDER 1
+#endif
+
+#define MAX_FILTER_NEIGHBOURS 26
+
+groupshared int NeighbourIndices[MAX_FILTER_NEIGHBOURS];
+groupshared float NeighbourWeights[MAX_FILTER_NEIGHBOURS];
+
+float2 GetDistanceMoments(int probeIndex, float3 direction, Texture2D<float4> distanceAtlas)
+{
+    float2 atlasCoords = GetAtlasCoords(probeIndex, GetOctahedralCoords(direction), g_RaytracePerFrame.NumDistanceTexels, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.AtlasLayout);
+
+    return 2.0f * distanceAtlas.SampleLevel(SamLinearWrap, atlasCoords, 0).rg;
+}
+
+bool IsProbeOnScrolledPlane(int probeIndex)
+{
+    int3 probeCoords = GetProbeCoords(probeIndex, g_RaytracePerFrame.ProbeCounts);
+
+    return IsScrolledPlane(probeCoords, 0, g_RaytracePerFrame.ProbeOffsets, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.ClearPlane) == true ||
+           IsScrolledPlane(probeCoords, 1, g_RaytracePerFrame.ProbeOffsets, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.ClearPlane) == true ||
+           IsScrolledPlane(probeCoords, 2, g_RaytracePerFrame.ProbeOffsets, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.ClearPlane) == true;
+}
+
+//Filters each probe's irradiance with its neighbours in the grid, weighted by how well the two probes can see each
+//other and how far apart they are. Every texel of a tile is the same direction in every probe so texels are filtered
+//with the same texel in the neighbours. One group per probe over the whole volume.
+[numthreads(FILTER_TILE_WIDTH, FILTER_TILE_HEIGHT, 1)]
+void main(uint3 GTid : SV_GroupThreadID, uint3 Gid : SV_GroupID, uint groupIndex : SV_GroupIndex)
+{
+    int numProbes = g_RaytracePerFrame.ProbeCounts.x * g_RaytracePerFrame.ProbeCounts.y * g_RaytracePerFrame.ProbeCounts.z;
+    int probeIndex = GetProbeIndex(Gid.xy, 1, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.AtlasLayout);
+
+    if (probeIndex >= numProbes || probeIndex < 0)
+    {
+        return;
+    }
+
+    int2 tileSize = int2(FILTER_TILE_WIDTH, FILTER_TILE_HEIGHT) + (FILTER_TILE_BORDER * 2);
+    int2 texelCoords = GetProbeDataCoords(probeIndex, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.AtlasLayout) * tileSize + FILTER_TILE_BORDER + int2(GTid.xy);
+
+    float4 centre = IrradianceData[texelCoords];
+
+    Texture2D<float4> probeData = Tex2DTable[g_RaytracePerFrame.ProbeDataIndex];
+
+    //Cleared and inactive probes have nothing worth spreading so they are copied across as they are
+    if (IsProbeOnScrolledPlane(probeIndex) == true || (g_RaytracePerFrame.ProbeClassification == true && IsProbeActive(probeIndex, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.AtlasLayout, probeData) == false))
+    {
+        FilteredIrradianceData[texelCoords] = centre;
+
+        return;
+    }
+
+    Texture2D<float4> distanceAtlas = Tex2DTable[g_RaytracePerFrame.DistanceIndex];
+
+    int3 probeCoords = GetUnoffsettedProbeCoords(probeIndex, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.ProbeOffsets);
+    float3 probeCoordsW = GetProbeCoordsWorld(probeCoords, g_RaytracePerFrame.VolumePosition, g_RaytracePerFrame.ProbeOffsets, g_RaytracePerFrame.ProbeSpacing, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.ProbeRelocation, g_RaytracePerFrame.AtlasLayout, probeData);
+
+    int numNeighbours = g_RaytracePerFrame.ProbeFilter == PROBE_FILTER_6_NEIGHBOURS ? 6 : 26;
+
+    int i;
+
+    //The weights only depend on the probes so they are worked out once for the whole group, SH tiles can have fewer
+    //threads than there are neighbours
+    for (i = groupIndex; i < numNeighbours; i += FILTER_TILE_WIDTH * FILTER_TILE_HEIGHT)
+    {
+        int3 offset = GetFilterNeighbourOffset(i, g_RaytracePerFrame.ProbeFilter);
+        int3 neighbourCoords = probeCoords + offset;
+
+        NeighbourIndices[i] = 0;
+        NeighbourWeights[i] = 0.0f;
+
+        if (any(neighbourCoords < 0) || any(neighbourCoords >= g_RaytracePerFrame.ProbeCounts))
+        {
+            continue;
+        }
+
+        int neighbourIndex = GetOffsettedProbeIndex(neighbourCoords, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.ProbeOffsets);
+
+        if (IsProbeOnScrolledPlane(neighbourIndex) == true)
+        {
+            continue;
+        }
+
+        if (g_RaytracePerFrame.ProbeClassification == true && IsProbeActive(neighbourIndex, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.AtlasLayout, probeData) == false)
+        {
+            continue;
+        }
+
+        float3 toNeighbour = GetProbeCoordsWorld(neighbourCoords, g_RaytracePerFrame.VolumePosition, g_RaytracePerFrame.ProbeOffsets, g_RaytracePerFrame.ProbeSpacing, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.ProbeRelocation, g_RaytracePerFrame.AtlasLayout, probeData) - probeCoordsW;
+        float distance = length(toNeighbour);
+
+        toNeighbour /= max(distance, 0.0001f);
+
+        //Both probes have to be able to see each other, otherwise the neighbour is likely on the other side of a wall
+        float visibility = GetChebyshevWeight(GetDistanceMoments(probeIndex, toNeighbour, distanceAtlas), distance);
+        visibility *= GetChebyshevWeight(GetDistanceMoments(neighbourIndex, -toNeighbour, distanceAtlas), distance);
+
+        NeighbourIndices[i] = neighbourIndex;
+        NeighbourWeights[i] = g_RaytracePerFrame.ProbeFilterStrength * visibility / float(dot(offset, offset));
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    //Octahedral irradiance is gamma encoded so it is filtered in linear space, SH coefficients already are
+#if FILTER_SH
+    float3 result = centre.rgb;
+#else
+    float3 result = pow(centre.rgb, g_RaytracePerFrame.IrradianceGammaEncoding);
+#endif
+
+    float totalWeight = 1.0f;
+
+    for (i = 0; i < numNeighbours; ++i)
+    {
+        if (NeighbourWeights[i] <= 0.0f)
+        {
+            continue;
+        }
+
+        int2 neighbourTexelCoords = GetProbeDataCoords(NeighbourIndices[i], g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.AtlasLayout) * tileSize + FILTER_TILE_BORDER + int2(GTid.xy);
+
+        float3 neighbour = IrradianceData[neighbourTexelCoords].rgb;
+
+#if !FILTER_SH
+        neighbour = pow(neighbour, g_RaytracePerFrame.IrradianceGammaEncoding);
+#endif
+
+        result += NeighbourWeights[i] * neighbour;
+        totalWeight += NeighbourWeights[i];
+    }
+
+    result /= totalWeight;
+
+#if !FILTER_SH
+    result = pow(result, 1.0f / g_RaytracePerFrame.IrradianceGammaEncoding);
+#endif
+
+    FilteredIrradianceData[texelCoords] = float4(result, centre.a);
+}
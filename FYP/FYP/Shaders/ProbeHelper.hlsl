@@ -24,8 +24,23 @@ int GetProbeIndex(int3 probeCoords, int3 probeCounts)
 
 }
 
-int GetProbeIndex(int2 texCoords, int numTexels, int3 probeCounts)
+int GetProbeIndex(int2 texCoords, int numTexels, int3 probeCounts, int atlasLayout)
 {
+    if (atlasLayout == PROBE_ATLAS_LAYOUT_BRICKS)
+    {
+        int2 tileCoords = texCoords / numTexels;
+        int pairIndex = tileCoords.x / (probeCounts.x * 2);
+        int pairColumn = tileCoords.x - (pairIndex * probeCounts.x * 2);
+        
+        //With an odd number of planes the last one has no pair and is laid out on its own
+        if ((probeCounts.y & 1) == 1 && pairIndex == probeCounts.y / 2)
+        {
+            return GetProbeIndex(int3(pairColumn, probeCounts.y - 1, tileCoords.y), probeCounts);
+        }
+        
+        return GetProbeIndex(int3(pairColumn / 2, (pairIndex * 2) + (pairColumn & 1), tileCoords.y), probeCounts);
+    }
+    
     int planeIndex = int(texCoords.x / (numTexels * probeCounts.x));
     int probeIndex = int(texCoords.x / numTexels) - (planeIndex * probeCounts.x) + (probeCounts.x * int(texCoords.y / numTexels));
     
@@ -39,16 +54,135 @@ int GetOffsettedProbeIndex(int3 probeCoords, int3 probeCounts, int3 probeOffsets
     return GetProbeIndex((probeCoords + probeOffsets + probeCounts) % probeCounts, probeCounts);
 }
 
+//Inverse of GetOffsettedProbeIndex, gets the coords in the volume of the probe stored at probeIndex in the atlases
+int3 GetUnoffsettedProbeCoords(int probeIndex, int3 probeCounts, int3 probeOffsets)
+{
+    int3 wrappedOffsets = ((probeOffsets % probeCounts) + probeCounts) % probeCounts;
+    
+    return (GetProbeCoords(probeIndex, probeCounts) - wrappedOffsets + probeCounts) % probeCounts;
+}
+
 float3 GetProbeCoordsWorld(int3 probeCoords, float3 volumePosition, int3 probeOffsets, float3 probeSpacing, int3 probeCounts)
 {
     return volumePosition + (probeOffsets * probeSpacing) - ((probeCounts - 1) * probeSpacing * 0.5f) + (probeCoords * probeSpacing);
 }
 
+//Texel in the probe data atlas, laid out the same way as the probes in the irradiance and distance atlases
+int2 GetProbeDataCoords(int probeIndex, int3 probeCounts, int atlasLayout)
+{
+    if (atlasLayout == PROBE_ATLAS_LAYOUT_BRICKS)
+    {
+        int3 probeCoords = GetProbeCoords(probeIndex, probeCounts);
+        int pairIndex = probeCoords.y / 2;
+        int pairColumn = (probeCounts.y & 1) == 1 && probeCoords.y == probeCounts.y - 1 ? probeCoords.x : (probeCoords.x * 2) + (probeCoords.y & 1);
+        
+        return int2((pairIndex * probeCounts.x * 2) + pairColumn, probeCoords.z);
+    }
+    
+    int x = (probeIndex % probeCounts.x) + int(probeIndex / (probeCounts.x * probeCounts.z)) * probeCounts.x;
+    int y = (probeIndex / probeCounts.x) % probeCounts.z;
+    
+    return int2(x, y);
+}
+
+//Relocation offsets are stored as a fraction of the probe spacing
+float3 GetProbeRelocationOffset(int probeIndex, float3 probeSpacing, int3 probeCounts, int atlasLayout, Texture2D<float4> probeData)
+{
+    return probeData[GetProbeDataCoords(probeIndex, probeCounts, atlasLayout)].xyz * probeSpacing;
+}
+
+int GetProbeNumRays(int probeIndex, int adaptiveRays, int raysPerProbe, Buffer<uint> probeRayCounts)
+{
+    if (adaptiveRays == true)
+    {
+        return min(int(probeRayCounts[probeIndex]), raysPerProbe);
+    }
+    
+    return raysPerProbe;
+}
+
+bool IsProbeActive(int probeIndex, int3 probeCounts, int atlasLayout, Texture2D<float4> probeData)
+{
+    return probeData[GetProbeDataCoords(probeIndex, probeCounts, atlasLayout)].w == PROBE_STATE_ACTIVE;
+}
+
+//Element of the active probe list buffer holding the probe's bit in the traced probe mask, the mask comes after the list
+int GetTracedProbeMaskIndex(int probeIndex, int3 probeCounts)
+{
+    return (probeCounts.x * probeCounts.y * probeCounts.z) + 1 + (probeIndex / 32);
+}
+
+//Only probes with a row of ray data from this frame's trace can be relocated or classified
+bool WasProbeTraced(int probeIndex, float probeState, uint tracedProbeBits, int useActiveProbeList, int fullProbeUpdate, int tracedProbeMask)
+{
+    if (useActiveProbeList == false)
+    {
+        return true;
+    }
+    
+    //A list built on the CPU can leave out active probes that weren't scheduled or are asleep
+    if (tracedProbeMask == true)
+    {
+        return (tracedProbeBits & (1u << (probeIndex & 31))) != 0;
+    }
+    
+    //A list built by classification holds every active probe
+    return fullProbeUpdate == true || probeState == PROBE_STATE_ACTIVE;
+}
+
+float3 GetProbeCoordsWorld(int3 probeCoords, float3 volumePosition, int3 probeOffsets, float3 probeSpacing, int3 probeCounts, int probeRelocation, int atlasLayout, Texture2D<float4> probeData)
+{
+    float3 probeCoordsW = GetProbeCoordsWorld(probeCoords, volumePosition, probeOffsets, probeSpacing, probeCounts);
+    
+    if (probeRelocation == true)
+    {
+        probeCoordsW += GetProbeRelocationOffset(GetOffsettedProbeIndex(probeCoords, probeCounts, probeOffsets), probeSpacing, probeCounts, atlasLayout, probeData);
+    }
+    
+    return probeCoordsW;
+}
+
 float3 GetProbeRayDirection(int rayIndex, int raysPerProbe, float4 rayRotation)
 {
     return normalize(QuaternionRotate(GetFibonacciSpiralDirection(rayIndex, raysPerProbe), QuaternionConjugate(rayRotation)));
 }
 
+//The HDR formats keep an exponent in their top 5 bits. Rotating it down onto the float's exponent means the word is always
+//a finite, normal float so it survives being stored in the R32G32 texture with asfloat.
+float PackRayRadiance(float3 radiance, int rayDataFormat)
+{
+    uint packed;
+
+    if (rayDataFormat == FORMAT_PROBE_RAY_DATA_RGB9E5)
+    {
+        packed = Float3ToRGB9E5(radiance);
+    }
+    else
+    {
+        //Blue's exponent is the one that ends up in the float's exponent so it can't be zero
+        radiance.b = max(radiance.b, R11G11B10_MIN);
+
+        packed = Float3ToR11G11B10(radiance);
+    }
+
+    return asfloat((packed >> 4) | (packed << 28));
+}
+
+float3 UnpackRayRadiance(float packedRadiance, int rayDataFormat)
+{
+    uint packed = asuint(packedRadiance);
+    packed = (packed << 4) | (packed >> 28);
+
+    if (rayDataFormat == FORMAT_PROBE_RAY_DATA_RGB9E5)
+    {
+        return RGB9E5ToFloat3(packed);
+    }
+    else
+    {
+        return R11G11B10ToFloat3(packed);
+    }
+}
+
 void StoreRayMiss(uint2 texCoords, int rayDataFormat, float3 missRadiance, RWTexture2D<float4> rayData)
 {
     if (rayDataFormat == FORMAT_PROBE_RAY_DATA_R32G32B32A32_FLOAT)
@@ -59,10 +193,14 @@ void StoreRayMiss(uint2 texCoords, int rayDataFormat, float3 missRadiance, RWTex
         rayData[texCoords] = float4(missRadiance, 1e27f);
 #endif
     }
-    else
+    else if (rayDataFormat == FORMAT_PROBE_RAY_DATA_R32G32_FLOAT)
     {
         rayData[texCoords] = float4(Float3ToUint(missRadiance), 1e27f, 0, 0);
     }
+    else
+    {
+        rayData[texCoords] = float4(PackRayRadiance(missRadiance, rayDataFormat), 1e27f, 0, 0);
+    }
 }
 
 void StoreRayBackfaceHit(uint2 texCoords, float hitDistance, int rayDataFormat, RWTexture2D<float4> rayData)
@@ -91,7 +229,7 @@ void StoreRayFrontfaceHit(uint2 texCoords, float3 radiance, float hitDistance, i
         rayData[texCoords] = float4(radiance, hitDistance);
 #endif
     }
-    else
+    else if (rayDataFormat == FORMAT_PROBE_RAY_DATA_R32G32_FLOAT)
     {
         static const float c_threshold = 1.0f / 255.0f;
         if (max(radiance.x, max(radiance.y, radiance.z)) <= c_threshold)    //Check if max component will fit into accuracy available
@@ -101,6 +239,10 @@ void StoreRayFrontfaceHit(uint2 texCoords, float3 radiance, float hitDistance, i
 
         rayData[texCoords] = float4(Float3ToUint(radiance), hitDistance, 0.f, 0.f);
     }
+    else
+    {
+        rayData[texCoords] = float4(PackRayRadiance(radiance, rayDataFormat), hitDistance, 0.f, 0.f);
+    }
 }
 
 float3 GetSurfaceBias(float3 normal, float3 direction, float normalBias, float viewBias)
@@ -134,21 +276,52 @@ float GetBlendWeight(float3 posW, float3 volumePosition, int3 probeOffsets, floa
     return weight;
 }
 
-float2 GetAtlasCoords(int probeIndex, float2 octCoords, int numTexels, int3 probeCounts)
+float2 GetAtlasCoords(int probeIndex, float2 octCoords, int numTexels, int3 probeCounts, int atlasLayout)
 {
-    int gridSpaceX = (probeIndex % probeCounts.x);
-    int gridSpaceY = (probeIndex / probeCounts.x);
-
-    int x = gridSpaceX + int(probeIndex / (probeCounts.x * probeCounts.z)) * probeCounts.x;
-    int y = gridSpaceY % probeCounts.z;
+    int2 dataCoords = GetProbeDataCoords(probeIndex, probeCounts, atlasLayout);
     
-    float2 uv = float2(x * (numTexels + 2), y * (numTexels + 2)) + ((numTexels + 2) * 0.5f);
+    float2 uv = float2(dataCoords.x * (numTexels + 2), dataCoords.y * (numTexels + 2)) + ((numTexels + 2) * 0.5f);
     uv += octCoords.xy * (numTexels * 0.5f);
     uv /= float2((numTexels + 2) * (probeCounts.x * probeCounts.y), (numTexels + 2) * probeCounts.z);
     
     return uv;
 }
 
+//Spins the probe's rays round the world z axis by a golden ratio step of its index after the frame's rotation is
+//applied, so neighbouring probes never trace the same directions in the same frame
+float4 GetProbeRaySpin(int probeIndex)
+{
+    //Fraction of the golden ratio step in 32 bit fixed point, exact for any index
+    float fraction = ((uint(probeIndex) * 2654435769u) >> 8) * (1.0f / 16777216.0f);
+    float halfAngle = fraction * PI;
+    
+    return float4(0.0f, 0.0f, -sin(halfAngle), cos(halfAngle));
+}
+
+float4 GetProbeRayRotation(int probeIndex, float4 rayRotation, int perProbeRotation)
+{
+    if (perProbeRotation == 0)
+    {
+        return rayRotation;
+    }
+    
+    //The directions are rotated by the conjugate, so the spin goes last in the product to be applied last
+    return QuaternionMultiply(rayRotation, GetProbeRaySpin(probeIndex));
+}
+
+//The table holds every ray's direction already rotated by the frame's rotation, only the probe's spin is left to apply
+float3 GetTableRayDirection(int rayIndex, int probeIndex, int perProbeRotation, Buffer<float4> rayDirectionTable)
+{
+    float3 direction = rayDirectionTable[rayIndex].xyz;
+    
+    if (perProbeRotation == 0)
+    {
+        return direction;
+    }
+    
+    return QuaternionRotate(direction, QuaternionConjugate(GetProbeRaySpin(probeIndex)));
+}
+
 float3 GetRayDirection(int rayIndex, int raysPerProbe, float4 rotationQuat)
 {
     float3 direction = GetFibonacciSpiralDirection(rayIndex, raysPerProbe);
@@ -162,10 +335,14 @@ float3 GetRayRadiance(uint2 texCoords, int rayDataFormat, Texture2D<float4> rayD
     {
         return rayData[texCoords].rgb;
     }
-    else
+    else if (rayDataFormat == FORMAT_PROBE_RAY_DATA_R32G32_FLOAT)
     {
         return UintToFloat3(rayData[texCoords].r);
     }
+    else
+    {
+        return UnpackRayRadiance(rayData[texCoords].r, rayDataFormat);
+    }
 }
 
 float GetRayDistance(uint2 texCoords, int rayDataFormat, Texture2D<float4> rayData)
@@ -180,7 +357,71 @@ float GetRayDistance(uint2 texCoords, int rayDataFormat, Texture2D<float4> rayDa
     }
 }
 
-bool ClearScrolledPlane(int2 coords, int3 probeCoords, int planeIndex, int3 probeOffsets, int3 probeCounts, int3 clearPlane, RWTexture2D<float4> dataAtlas)
+float GetLuminance(float3 colour)
+{
+    return dot(colour, float3(0.2126f, 0.7152f, 0.0722f));
+}
+
+//Relative change in the probe's summed irradiance luminance, floored so dark probes don't look like they're changing
+float GetProbeIrradianceChange(float luminance, float previousLuminance, int numTexels)
+{
+    return abs(luminance - previousLuminance) / (max(luminance, previousLuminance) + numTexels * (1.0f / 1024.0f));
+}
+
+//State is x the probe's hysteresis and y its smoothed change. Hysteresis drops to the minimum when the change is past
+//the threshold and otherwise rises towards the maximum, faster the smaller the change.
+float2 UpdateProbeHysteresis(float2 state, float change, float minHysteresis, float maxHysteresis, float riseRate, float changeThreshold)
+{
+    float hysteresis = max(state.x, minHysteresis);
+    
+    if (change > changeThreshold)
+    {
+        hysteresis = minHysteresis;
+    }
+    else
+    {
+        hysteresis = lerp(hysteresis, maxHysteresis, riseRate * (1.0f - change / changeThreshold));
+    }
+    
+    return float2(hysteresis, lerp(change, state.y, 0.9f));
+}
+
+//How likely a point distance away from the probe is to be visible from it given the probe's distance moments in that
+//direction, x the mean distance and y the mean squared distance
+float GetChebyshevWeight(float2 moments, float distance)
+{
+    if (distance <= moments.x)
+    {
+        return 1.0f;
+    }
+    
+    float variance = abs(moments.x * moments.x - moments.y);
+    float v = distance - moments.x;
+    
+    float chebyshevWeight = variance / (v * v + variance);
+    
+    return max(chebyshevWeight * chebyshevWeight * chebyshevWeight, 0.0f);
+}
+
+//Offset in the grid to one of the probe's 6 face neighbours or 26 surrounding neighbours
+int3 GetFilterNeighbourOffset(int neighbourIndex, int probeFilter)
+{
+    if (probeFilter == PROBE_FILTER_6_NEIGHBOURS)
+    {
+        int3 offset = int3(0, 0, 0);
+        offset[neighbourIndex >> 1] = (neighbourIndex & 1) == 0 ? -1 : 1;
+        
+        return offset;
+    }
+    
+    //Skips the probe itself in the middle of the 3x3x3 block
+    int cell = neighbourIndex < 13 ? neighbourIndex : neighbourIndex + 1;
+    
+    return int3(cell % 3, (cell / 3) % 3, cell / 9) - int3(1, 1, 1);
+}
+
+//Returns true if the probe is on the plane that has just been scrolled round to the other side of the volume
+bool IsScrolledPlane(int3 probeCoords, int planeIndex, int3 probeOffsets, int3 probeCounts, int3 clearPlane)
 {
     if(clearPlane[planeIndex] == true)
     {
@@ -196,12 +437,19 @@ bool ClearScrolledPlane(int2 coords, int3 probeCoords, int planeIndex, int3 prob
             plane = (probeOffsets[planeIndex] % probeCounts[planeIndex]) + probeCounts[planeIndex];
         }
         
-        if (probeCoords[planeIndex] == plane)
-        {
-            dataAtlas[coords] = float4(0.f, 0.f, 0.f, 0.f);
-            
-            return true;
-        }
+        return probeCoords[planeIndex] == plane;
+    }
+    
+    return false;
+}
+
+bool ClearScrolledPlane(int2 coords, int3 probeCoords, int planeIndex, int3 probeOffsets, int3 probeCounts, int3 clearPlane, RWTexture2D<float4> dataAtlas)
+{
+    if (IsScrolledPlane(probeCoords, planeIndex, probeOffsets, probeCounts, clearPlane) == true)
+    {
+        dataAtlas[coords] = float4(0.f, 0.f, 0.f, 0.f);
+        
+        return true;
     }
     
     return false;
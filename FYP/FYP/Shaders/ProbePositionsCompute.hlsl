@@ -0,0 +1,31 @@
+#include "ProbeHelper.hlsl"
+#include "RaytracingCommons.hlsli"
+
+RWBuffer<float4> ProbePositions : register(u4);   //World position in xyz and probe state in w, in atlas order
+RWTexture2D<float4> ProbeData : register(u1);
+
+//Works out where every probe is this frame, scrolling and relocation included, so the probe visualization can draw
+//them all in one instanced draw without the CPU touching any of them. One thread per probe in atlas order.
+[numthreads(64, 1, 1)]
+void main(uint3 DTid : SV_DispatchThreadID)
+{
+    int numProbes = g_RaytracePerFrame.ProbeCounts.x * g_RaytracePerFrame.ProbeCounts.y * g_RaytracePerFrame.ProbeCounts.z;
+    int probeIndex = DTid.x;
+
+    if (probeIndex >= numProbes)
+    {
+        return;
+    }
+
+    int3 probeCoords = GetUnoffsettedProbeCoords(probeIndex, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.ProbeOffsets);
+    float3 probeCoordsW = GetProbeCoordsWorld(probeCoords, g_RaytracePerFrame.VolumePosition, g_RaytracePerFrame.ProbeOffsets, g_RaytracePerFrame.ProbeSpacing, g_RaytracePerFrame.ProbeCounts);
+
+    float4 probeData = ProbeData[GetProbeDataCoords(probeIndex, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.AtlasLayout)];
+
+    if (g_RaytracePerFrame.ProbeRelocation == true)
+    {
+        probeCoordsW += probeData.xyz * g_RaytracePerFrame.ProbeSpacing;
+    }
+
+    ProbePositions[probeIndex] = float4(probeCoordsW, g_RaytracePerFrame.ProbeClassification == true ? probeData.w : PROBE_STATE_ACTIVE);
+}
@@ -0,0 +1,133 @@
+#include "ProbeHelper.hlsl"
+#include "RaytracingCommons.hlsli"
+
+RWTexture2D<float4> ProbeData : register(u1);
+
+//Moves probes within their cell based on the rays traced this frame. Probes that see too many backfaces are inside
+//geometry so get pushed through the closest backface, probes that are too close to a surface get pulled away from it
+//and probes with plenty of space drift back to the centre of their cell.
+[numthreads(8, 8, 1)]
+void main(uint3 DTid : SV_DispatchThreadID)
+{
+    int numProbes = g_RaytracePerFrame.ProbeCounts.x * g_RaytracePerFrame.ProbeCounts.y * g_RaytracePerFrame.ProbeCounts.z;
+    int probeIndex = GetProbeIndex(DTid.xy, 1, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.AtlasLayout);
+
+    if (DTid.x >= uint(g_RaytracePerFrame.ProbeCounts.x * g_RaytracePerFrame.ProbeCounts.y) || DTid.y >= uint(g_RaytracePerFrame.ProbeCounts.z) || probeIndex >= numProbes)
+    {
+        return;
+    }
+    
+    int3 probeCoords = GetProbeCoords(probeIndex, g_RaytracePerFrame.ProbeCounts);
+    
+    //Probes that have just been scrolled round are in a new cell so start again from the centre
+    bool clearedPlane = false;
+    clearedPlane |= ClearScrolledPlane(DTid.xy, probeCoords, 0, g_RaytracePerFrame.ProbeOffsets, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.ClearPlane, ProbeData);
+    clearedPlane |= ClearScrolledPlane(DTid.xy, probeCoords, 1, g_RaytracePerFrame.ProbeOffsets, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.ClearPlane, ProbeData);
+    clearedPlane |= ClearScrolledPlane(DTid.xy, probeCoords, 2, g_RaytracePerFrame.ProbeOffsets, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.ClearPlane, ProbeData);
+
+    if (clearedPlane == true)
+    {
+        return;
+    }
+    
+    float4 probeData = ProbeData[DTid.xy];
+    
+    //Probes left out of this frame's trace still have last time's ray data
+    uint tracedProbeBits = BufferUintTable[g_RaytracePerFrame.ActiveProbeListIndex][GetTracedProbeMaskIndex(probeIndex, g_RaytracePerFrame.ProbeCounts)];
+    
+    if (WasProbeTraced(probeIndex, probeData.w, tracedProbeBits, g_RaytracePerFrame.UseActiveProbeList, g_RaytracePerFrame.FullProbeUpdate, g_RaytracePerFrame.TracedProbeMask) == false)
+    {
+        return;
+    }
+    
+    float3 offset = probeData.xyz * g_RaytracePerFrame.ProbeSpacing;
+    
+    int numBackfaceHits = 0;
+    
+    int closestBackfaceIndex = -1;
+    int closestFrontfaceIndex = -1;
+    int farthestFrontfaceIndex = -1;
+    
+    float closestBackfaceDistance = 1e27f;
+    float closestFrontfaceDistance = 1e27f;
+    float farthestFrontfaceDistance = 0.0f;
+    
+    int numRays = GetProbeNumRays(probeIndex, g_RaytracePerFrame.AdaptiveRays, g_RaytracePerFrame.RaysPerProbe, BufferUintTable[g_RaytracePerFrame.ProbeRayCountsIndex]);
+    
+    for (int i = 0; i < numRays; ++i)
+    {
+        float rayDistance = GetRayDistance(uint2(i, probeIndex), g_RaytracePerFrame.RayDataFormat, Tex2DTable[g_RaytracePerFrame.RayDataIndex]);
+        
+        if (rayDistance < 0.0f)
+        {
+            ++numBackfaceHits;
+            
+            //Backface distances are stored negated and scaled down
+            rayDistance *= -5.0f;
+            
+            if (rayDistance < closestBackfaceDistance)
+            {
+                closestBackfaceDistance = rayDistance;
+                closestBackfaceIndex = i;
+            }
+            
+            continue;
+        }
+        
+        if (rayDistance < closestFrontfaceDistance)
+        {
+            closestFrontfaceDistance = rayDistance;
+            closestFrontfaceIndex = i;
+        }
+        
+        if (rayDistance > farthestFrontfaceDistance)
+        {
+            farthestFrontfaceDistance = rayDistance;
+            farthestFrontfaceIndex = i;
+        }
+    }
+    
+    float3 fullOffset = float3(1e27f, 1e27f, 1e27f);
+    float4 rayRotation = GetProbeRayRotation(probeIndex, g_RaytracePerFrame.RayRotation, g_RaytracePerFrame.PerProbeRayRotation);
+    
+    if (closestBackfaceIndex != -1 && (numBackfaceHits / float(numRays)) > g_RaytracePerFrame.ProbeBackfaceThreshold)
+    {
+        //Inside geometry so move through the closest backface and a bit further so the probe ends up outside
+        float3 closestBackfaceDirection = GetRayDirection(closestBackfaceIndex, numRays, rayRotation);
+        
+        fullOffset = offset + closestBackfaceDirection * (closestBackfaceDistance + g_RaytracePerFrame.ProbeMinFrontfaceDistance * 0.5f);
+    }
+    else if (closestFrontfaceDistance < g_RaytracePerFrame.ProbeMinFrontfaceDistance)
+    {
+        //Too close to a surface so move towards the most open direction as long as that is away from the surface
+        float3 closestFrontfaceDirection = GetRayDirection(closestFrontfaceIndex, numRays, rayRotation);
+        float3 farthestFrontfaceDirection = GetRayDirection(farthestFrontfaceIndex, numRays, rayRotation);
+        
+        if (dot(closestFrontfaceDirection, farthestFrontfaceDirection) <= 0.0f)
+        {
+            fullOffset = offset + farthestFrontfaceDirection * min(farthestFrontfaceDistance, 1.0f);
+        }
+    }
+    else if (closestFrontfaceDistance > g_RaytracePerFrame.ProbeMinFrontfaceDistance)
+    {
+        //Plenty of room so drift back towards the centre of the cell
+        float offsetLength = length(offset);
+        
+        if (offsetLength > 0.0f)
+        {
+            float moveBackMargin = min(closestFrontfaceDistance - g_RaytracePerFrame.ProbeMinFrontfaceDistance, offsetLength);
+            
+            fullOffset = offset - (offset / offsetLength) * moveBackMargin;
+        }
+    }
+    
+    //Only accept offsets that stay inside the ellipsoid fitting in the cell so probes never swap places
+    float3 normalizedOffset = fullOffset / g_RaytracePerFrame.ProbeSpacing;
+    
+    if (dot(normalizedOffset, normalizedOffset) < 0.2025f)
+    {
+        offset = fullOffset;
+    }
+    
+    ProbeData[DTid.xy] = float4(offset / g_RaytracePerFrame.ProbeSpacing, probeData.w);
+}
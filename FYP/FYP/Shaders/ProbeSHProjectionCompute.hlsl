@@ -0,0 +1,136 @@
+#include "ProbeHelper.hlsl"
+#include "RaytracingCommons.hlsli"
+#include "SphericalHarmonics.hlsl"
+
+RWTexture2D<float2> ProbeHysteresis : register(u2);     //Laid out like the probe data atlas, only used with adaptive hysteresis
+RWTexture2D<float4> IrradianceData : register(u1);
+
+groupshared float3 RayRadiances[BLEND_RAYS_PER_PROBE];
+groupshared float3 RayDirections[BLEND_RAYS_PER_PROBE];
+groupshared float RayDistances[BLEND_RAYS_PER_PROBE];
+groupshared float ProbeHysteresisValue;
+
+//SH version of the irradiance blend in ProbeBlendingCompute.hlsl. One group per probe and a thread per coefficient,
+//dispatched the same way as the octahedral blend.
+[numthreads(NUM_SH_COEFFICIENTS, 1, 1)]
+void main(uint3 GTid : SV_GroupThreadID, uint3 Gid : SV_GroupID, uint groupIndex : SV_GroupIndex)
+{
+    int numProbes = g_RaytracePerFrame.ProbeCounts.x * g_RaytracePerFrame.ProbeCounts.y * g_RaytracePerFrame.ProbeCounts.z;
+    int probeIndex;
+
+    if (g_RaytracePerFrame.UseActiveProbeList == true)
+    {
+        probeIndex = BufferUintTable[g_RaytracePerFrame.ActiveProbeListIndex][Gid.x + 1];
+    }
+    else
+    {
+        probeIndex = GetProbeIndex(Gid.xy, 1, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.AtlasLayout);
+    }
+
+    if (probeIndex >= numProbes || probeIndex < 0)
+    {
+        return;
+    }
+
+    int2 shCoords = GetSHCoords(probeIndex, groupIndex, NUM_SH_COEFFICIENTS, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.AtlasLayout);
+
+    int3 probeCoords = GetProbeCoords(probeIndex, g_RaytracePerFrame.ProbeCounts);
+
+    bool clearedPlane = false;
+    clearedPlane |= ClearScrolledPlane(shCoords, probeCoords, 0, g_RaytracePerFrame.ProbeOffsets, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.ClearPlane, IrradianceData);
+    clearedPlane |= ClearScrolledPlane(shCoords, probeCoords, 1, g_RaytracePerFrame.ProbeOffsets, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.ClearPlane, IrradianceData);
+    clearedPlane |= ClearScrolledPlane(shCoords, probeCoords, 2, g_RaytracePerFrame.ProbeOffsets, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.ClearPlane, IrradianceData);
+
+    if (clearedPlane == true)
+    {
+        if (g_RaytracePerFrame.AdaptiveHysteresis == true && groupIndex == 0)
+        {
+            ProbeHysteresis[GetProbeDataCoords(probeIndex, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.AtlasLayout)] = float2(0.0f, 0.0f);
+        }
+        
+        return;
+    }
+
+    int numRays = GetProbeNumRays(probeIndex, g_RaytracePerFrame.AdaptiveRays, g_RaytracePerFrame.RaysPerProbe, BufferUintTable[g_RaytracePerFrame.ProbeRayCountsIndex]);
+    float4 rayRotation = GetProbeRayRotation(probeIndex, g_RaytracePerFrame.RayRotation, g_RaytracePerFrame.PerProbeRayRotation);
+
+    //Load all necessary data into shared memory
+
+    int totalIterations = int(ceil(BLEND_RAYS_PER_PROBE / float(NUM_SH_COEFFICIENTS)));
+
+    int i;
+    for (i = 0; i < totalIterations; ++i)
+    {
+        int rayIndex = (totalIterations * groupIndex) + i;
+
+        if (rayIndex >= numRays)
+        {
+            break;
+        }
+
+        RayRadiances[rayIndex] = GetRayRadiance(uint2(rayIndex, probeIndex), g_RaytracePerFrame.RayDataFormat, Tex2DTable[g_RaytracePerFrame.RayDataIndex]);
+        RayDistances[rayIndex] = GetRayDistance(uint2(rayIndex, probeIndex), g_RaytracePerFrame.RayDataFormat, Tex2DTable[g_RaytracePerFrame.RayDataIndex]);
+        if (g_RaytracePerFrame.RayDirectionTableIndex != -1)
+        {
+            RayDirections[rayIndex] = GetTableRayDirection(rayIndex, probeIndex, g_RaytracePerFrame.PerProbeRayRotation, BufferFloat4Table[g_RaytracePerFrame.RayDirectionTableIndex]);
+        }
+        else
+        {
+            RayDirections[rayIndex] = GetRayDirection(rayIndex, numRays, rayRotation);
+        }
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    uint numBackfaceHits = 0;
+    uint maxBackfaceHits = numRays * 0.1f;
+
+    float3 result = float3(0, 0, 0);
+    int numSamples = 0;
+
+    for (i = 0; i < numRays; ++i)
+    {
+        if (RayDistances[i] < 0.0f)
+        {
+            ++numBackfaceHits;
+
+            if (numBackfaceHits >= maxBackfaceHits)
+            {
+                return;
+            }
+
+            continue;
+        }
+
+        result += RayRadiances[i] * GetSHBasis(RayDirections[i], groupIndex);
+        ++numSamples;
+    }
+
+    //Monte Carlo estimate over the sphere, halved to match the octahedral blend
+    result *= (2.0f * GetSHBandFactor(groupIndex)) / float(max(numSamples, 1));
+
+    float3 previous = IrradianceData[shCoords].rgb;
+    
+    float hysteresis = g_RaytracePerFrame.Hysteresis;
+    
+    //The first coefficient is the probe's mean irradiance so is all that's needed to see how much the probe changed
+    if (g_RaytracePerFrame.AdaptiveHysteresis == true)
+    {
+        if (groupIndex == 0)
+        {
+            uint2 stateCoords = GetProbeDataCoords(probeIndex, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.AtlasLayout);
+            float change = GetProbeIrradianceChange(GetLuminance(result), GetLuminance(previous), 1);
+            
+            float2 state = UpdateProbeHysteresis(ProbeHysteresis[stateCoords], change, g_RaytracePerFrame.MinHysteresis, g_RaytracePerFrame.Hysteresis, g_RaytracePerFrame.HysteresisRiseRate, g_RaytracePerFrame.HysteresisChangeThreshold);
+            
+            ProbeHysteresis[stateCoords] = state;
+            ProbeHysteresisValue = state.x;
+        }
+        
+        GroupMemoryBarrierWithGroupSync();
+        
+        hysteresis = ProbeHysteresisValue;
+    }
+
+    IrradianceData[shCoords] = float4(lerp(result, previous, hysteresis), 1.0f);
+}
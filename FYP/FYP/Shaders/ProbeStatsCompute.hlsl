@@ -0,0 +1,68 @@
+#include "ProbeHelper.hlsl"
+#include "RaytracingCommons.hlsli"
+
+RWTexture2D<float2> ProbeStats : register(u1);   //Running mean and variance of the luminance the probe's rays saw
+
+//Tracks how noisy each probe is from frame to frame so the CPU can give noisy probes more rays. One thread per probe
+//traced this frame, over the active probe list when one is in use.
+[numthreads(64, 1, 1)]
+void main(uint3 DTid : SV_DispatchThreadID)
+{
+    int numProbes = g_RaytracePerFrame.ProbeCounts.x * g_RaytracePerFrame.ProbeCounts.y * g_RaytracePerFrame.ProbeCounts.z;
+    int probeIndex = DTid.x;
+    
+    if (g_RaytracePerFrame.UseActiveProbeList == true)
+    {
+        if (DTid.x >= BufferUintTable[g_RaytracePerFrame.ActiveProbeListIndex][0])
+        {
+            return;
+        }
+        
+        probeIndex = BufferUintTable[g_RaytracePerFrame.ActiveProbeListIndex][DTid.x + 1];
+    }
+
+    if (probeIndex >= numProbes)
+    {
+        return;
+    }
+    
+    int numRays = GetProbeNumRays(probeIndex, g_RaytracePerFrame.AdaptiveRays, g_RaytracePerFrame.RaysPerProbe, BufferUintTable[g_RaytracePerFrame.ProbeRayCountsIndex]);
+    
+    float luminance = 0.0f;
+    int numSamples = 0;
+    
+    for (int i = 0; i < numRays; ++i)
+    {
+        //Backfaces don't store any radiance
+        if (GetRayDistance(uint2(i, probeIndex), g_RaytracePerFrame.RayDataFormat, Tex2DTable[g_RaytracePerFrame.RayDataIndex]) < 0.0f)
+        {
+            continue;
+        }
+        
+        float3 radiance = GetRayRadiance(uint2(i, probeIndex), g_RaytracePerFrame.RayDataFormat, Tex2DTable[g_RaytracePerFrame.RayDataIndex]);
+        
+        luminance += dot(radiance, float3(0.2126f, 0.7152f, 0.0722f));
+        ++numSamples;
+    }
+    
+    luminance /= max(numSamples, 1);
+    
+    uint2 texCoords = GetProbeDataCoords(probeIndex, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.AtlasLayout);
+    float2 stats = ProbeStats[texCoords];
+    
+    //Exponentially weighted mean and variance, smoothed by the same hysteresis the blend uses
+    float alpha = 1.0f - g_RaytracePerFrame.Hysteresis;
+    float delta = luminance - stats.x;
+    
+    if (stats.x == 0.0f && stats.y == 0.0f)
+    {
+        stats = float2(luminance, 0.0f);
+    }
+    else
+    {
+        stats.x += alpha * delta;
+        stats.y = (1.0f - alpha) * (stats.y + alpha * delta * delta);
+    }
+    
+    ProbeStats[texCoords] = stats;
+}
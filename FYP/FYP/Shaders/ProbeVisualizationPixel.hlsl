@@ -0,0 +1,85 @@
+#include "RasterCommons.hlsli"
+#include "Irradiance.hlsl"
+
+struct PS_INPUT
+{
+    float4 PosH : SV_POSITION;
+    float3 PosW : POSITION;
+    nointerpolation float4 Probe : PROBE;   //Centre in xyz and state in w
+    nointerpolation uint ProbeIndex : PROBE_INDEX;
+};
+
+struct PS_OUTPUT
+{
+    float4 Color : SV_TARGET;
+    float Depth : SV_DepthGreaterEqual;
+};
+
+ConstantBuffer<RaytracePerFrameCB> l_RaytracePerFrameCB : register(b2);
+
+//Shades a probe with the irradiance it has stored for the direction of the sphere's normal, so the spheres show what
+//each probe has converged to. The sphere's depth is written out so probes are depth tested against the light pass's
+//depth and each other.
+PS_OUTPUT main(PS_INPUT input)
+{
+    PS_OUTPUT output;
+    
+    float3 rayDirection = normalize(input.PosW - g_ScenePerFrameCB.EyePosW);
+    float3 toCentre = input.Probe.xyz - g_ScenePerFrameCB.EyePosW;
+    
+    float radius = l_RaytracePerFrameCB.ProbeScale;
+    float centreDistance = dot(toCentre, rayDirection);
+    float missDistanceSquared = dot(toCentre, toCentre) - centreDistance * centreDistance;
+
+    if (missDistanceSquared > radius * radius)
+    {
+        discard;
+    }
+
+    float hitDistance = centreDistance - sqrt(radius * radius - missDistanceSquared);
+    float3 hitW = g_ScenePerFrameCB.EyePosW + rayDirection * hitDistance;
+
+    //The quad is on the front of the sphere so this is never nearer than the quad
+    float4 hitH = mul(float4(hitW, 1.0f), g_ScenePerFrameCB.ViewProjection);
+    output.Depth = max(input.PosH.z, saturate(hitH.z / hitH.w));
+
+    float3 normalW = normalize(hitW - input.Probe.xyz);
+    
+    float3 irradiance;
+
+    if (l_RaytracePerFrameCB.IrradianceEncoding == PROBE_IRRADIANCE_ENCODING_OCTAHEDRAL)
+    {
+        float2 atlasCoords = GetAtlasCoords(input.ProbeIndex, GetOctahedralCoords(normalW), l_RaytracePerFrameCB.NumIrradianceTexels, l_RaytracePerFrameCB.ProbeCounts, l_RaytracePerFrameCB.AtlasLayout);
+
+        irradiance = Tex2DTable[l_RaytracePerFrameCB.IrradianceIndex].SampleLevel(SamLinearWrap, atlasCoords, 0).rgb;
+        irradiance = pow(irradiance, l_RaytracePerFrameCB.IrradianceGammaEncoding);
+
+        if (l_RaytracePerFrameCB.IrradianceFormat == FORMAT_PROBE_IRRADIANCE_R10G10B10A2_FLOAT)
+        {
+            irradiance *= 1.0989f;
+        }
+    }
+    else
+    {
+        irradiance = max(0.0f, EvaluateSHIrradiance(input.ProbeIndex, normalW, l_RaytracePerFrameCB.NumSHCoefficients, l_RaytracePerFrameCB.ProbeCounts, l_RaytracePerFrameCB.AtlasLayout, Tex2DTable[l_RaytracePerFrameCB.IrradianceIndex]));
+    }
+
+    //GetIrradiance's 2 PI scale over the PI of a white diffuse surface, so a probe matches the surfaces it lights
+    float3 color = irradiance * 2.0f;
+
+    //Classified out probes aren't traced so are dimmed
+    if (input.Probe.w != PROBE_STATE_ACTIVE)
+    {
+        color *= 0.25f;
+    }
+
+    //Map and gamma correct the same as the light pass
+    float fMapping = 1.0f / 2.2f;
+    
+    color /= (color + float3(1.0f, 1.0f, 1.0f));
+    color = pow(color, float3(fMapping, fMapping, fMapping));
+    
+    output.Color = float4(color, 1.0f);
+    
+    return output;
+}
@@ -0,0 +1,49 @@
+#include "RasterCommons.hlsli"
+
+struct VS_OUTPUT
+{
+    float4 PosH : SV_POSITION;
+    float3 PosW : POSITION;
+    nointerpolation float4 Probe : PROBE;   //Centre in xyz and state in w
+    nointerpolation uint ProbeIndex : PROBE_INDEX;
+};
+
+ConstantBuffer<RaytracePerFrameCB> l_RaytracePerFrameCB : register(b2);
+
+static const float2 s_QuadCorners[6] =
+{
+    float2(-1, -1), float2(-1, 1), float2(1, 1),
+    float2(-1, -1), float2(1, 1), float2(1, -1)
+};
+
+//Each instance is one probe read from the probe positions buffer, drawn as a camera facing quad just big enough to
+//cover the probe's sphere. The pixel shader traces the sphere itself so there is no vertex or index buffer. The quad
+//sits on the front of the sphere so nothing the pixel shader writes is nearer than the quad, which keeps early depth.
+VS_OUTPUT main(uint vertexID : SV_VertexID, uint instanceID : SV_InstanceID)
+{
+    VS_OUTPUT output;
+
+    float4 probe = BufferFloat4Table[l_RaytracePerFrameCB.ProbePositionsIndex][instanceID];
+    float radius = l_RaytracePerFrameCB.ProbeScale;
+
+    float3 toEye = g_ScenePerFrameCB.EyePosW - probe.xyz;
+    float distanceToEye = length(toEye);
+
+    float3 forward = toEye / max(distanceToEye, 0.0001f);
+    float3 up = abs(forward.y) < 0.999f ? float3(0, 1, 0) : float3(1, 0, 0);
+    float3 right = normalize(cross(up, forward));
+    up = cross(forward, right);
+
+    //Up close the silhouette is wider than the radius, this is where the tangent cone from the eye cuts the quad's plane
+    float planeDistance = max(distanceToEye - radius, 0.0001f);
+    float extent = radius * planeDistance / sqrt(max(distanceToEye * distanceToEye - radius * radius, 0.0001f));
+
+    float2 corner = s_QuadCorners[vertexID];
+
+    output.PosW = probe.xyz + (forward * radius) + ((right * corner.x) + (up * corner.y)) * extent;
+    output.PosH = mul(float4(output.PosW, 1.0f), g_ScenePerFrameCB.ViewProjection);
+    output.Probe = probe;
+    output.ProbeIndex = instanceID;
+
+    return output;
+}
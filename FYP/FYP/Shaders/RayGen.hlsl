@@ -11,15 +11,41 @@ void RayGen()
     uint2 dispatchIndex = DispatchRaysIndex().xy;
     
     int rayIndex = dispatchIndex.x;
-    int probeIndex = dispatchIndex.y;
+    int probeIndex;
+    int3 probeCoords;
     
-    int3 probeCoords = GetProbeCoords(probeIndex, g_RaytracePerFrame.ProbeCounts);
+    if (g_RaytracePerFrame.UseActiveProbeList == true)
+    {
+        //The list holds atlas indices with the probe count in the first element
+        probeIndex = BufferUintTable[g_RaytracePerFrame.ActiveProbeListIndex][dispatchIndex.y + 1];
+        probeCoords = GetUnoffsettedProbeCoords(probeIndex, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.ProbeOffsets);
+    }
+    else
+    {
+        probeCoords = GetProbeCoords(dispatchIndex.y, g_RaytracePerFrame.ProbeCounts);
+        probeIndex = GetOffsettedProbeIndex(probeCoords, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.ProbeOffsets);
+    }
     
-    float3 probeCoordsW = GetProbeCoordsWorld(probeCoords, g_RaytracePerFrame.VolumePosition, g_RaytracePerFrame.ProbeOffsets, g_RaytracePerFrame.ProbeSpacing, g_RaytracePerFrame.ProbeCounts);
+    float3 probeCoordsW = GetProbeCoordsWorld(probeCoords, g_RaytracePerFrame.VolumePosition, g_RaytracePerFrame.ProbeOffsets, g_RaytracePerFrame.ProbeSpacing, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.ProbeRelocation, g_RaytracePerFrame.AtlasLayout, Tex2DTable[g_RaytracePerFrame.ProbeDataIndex]);
     
-    probeIndex = GetOffsettedProbeIndex(probeCoords, g_RaytracePerFrame.ProbeCounts, g_RaytracePerFrame.ProbeOffsets);
+    //The dispatch is as wide as the most rays any probe can have
+    int numRays = GetProbeNumRays(probeIndex, g_RaytracePerFrame.AdaptiveRays, g_RaytracePerFrame.RaysPerProbe, BufferUintTable[g_RaytracePerFrame.ProbeRayCountsIndex]);
     
-    float3 directionW = GetProbeRayDirection(rayIndex, g_RaytracePerFrame.RaysPerProbe, g_RaytracePerFrame.RayRotation);
+    if (rayIndex >= numRays)
+    {
+        return;
+    }
+    
+    float3 directionW;
+    
+    if (g_RaytracePerFrame.RayDirectionTableIndex != -1)
+    {
+        directionW = GetTableRayDirection(rayIndex, probeIndex, g_RaytracePerFrame.PerProbeRayRotation, BufferFloat4Table[g_RaytracePerFrame.RayDirectionTableIndex]);
+    }
+    else
+    {
+        directionW = GetProbeRayDirection(rayIndex, numRays, GetProbeRayRotation(probeIndex, g_RaytracePerFrame.RayRotation, g_RaytracePerFrame.PerProbeRayRotation));
+    }
     
     uint2 texCoords = uint2(rayIndex, probeIndex);
     
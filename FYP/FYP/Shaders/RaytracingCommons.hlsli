@@ -2,10 +2,13 @@
 #define RAYTRACING_COMMONS_HLSL
 
 #include "Commons.hlsli"
+#include "VertexPacking.hlsl"
 
 ConstantBuffer<RaytracePerFrameCB> g_RaytracePerFrame : register(b1);
 
 StructuredBuffer<Vertex> Vertices[] : register(t0, space100);
+StructuredBuffer<PackedVertex> PackedVertices[] : register(t0, space104);
+StructuredBuffer<QuantizedVertex> QuantizedVertices[] : register(t0, space105);
 
 RaytracingAccelerationStructure Scene : register(t0, space200);
 
@@ -35,6 +38,36 @@ void GenerateCameraRay(uint2 index, out float3 origin, out float3 direction)
 
 }
 
+//The vertex's normal, tangent and texture coordinates whichever VERTEX_FORMAT_ it's stored in. Positions are left out
+//as hits get theirs from the ray.
+Vertex GetVertex(uint verticesIndex, uint vertexFormat, uint index)
+{
+    Vertex vertex = (Vertex) 0;
+
+    if (vertexFormat == VERTEX_FORMAT_PACKED)
+    {
+        PackedVertex packed = PackedVertices[verticesIndex][index];
+
+        vertex.Normal = UnpackNormal(packed.Normal);
+        vertex.Tangent = UnpackTangent(packed.Tangent);
+        vertex.TexCoords = UnpackTexCoords(packed.TexCoords);
+    }
+    else if (vertexFormat == VERTEX_FORMAT_QUANTIZED)
+    {
+        QuantizedVertex quantized = QuantizedVertices[verticesIndex][index];
+
+        vertex.Normal = UnpackNormal(quantized.Normal);
+        vertex.Tangent = UnpackTangent(quantized.Tangent);
+        vertex.TexCoords = UnpackTexCoords(quantized.TexCoords);
+    }
+    else
+    {
+        vertex = Vertices[verticesIndex][index];
+    }
+
+    return vertex;
+}
+
 float3 InterpolateAttribute(float3 vertexAttribute[3], BuiltInTriangleIntersectionAttributes attr)
 {
     return vertexAttribute[0] +
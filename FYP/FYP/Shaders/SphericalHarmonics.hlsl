@@ -0,0 +1,70 @@
+#ifndef SPHERICAL_HARMONICS_HLSL
+#define SPHERICAL_HARMONICS_HLSL
+
+#include "ProbeHelper.hlsl"
+
+//Probes using SH irradiance store their coefficients in a row in the irradiance atlas, RGB in each texel, laid out
+//like the probe data atlas otherwise. Coefficients are already convolved with the cosine lobe and scaled so evaluating
+//them gives the same value as an octahedral irradiance texel before the gamma encoding.
+
+float GetSHBasis(float3 direction, int coefficient)
+{
+    switch (coefficient)
+    {
+    case 0:
+        return 0.282095f;
+    case 1:
+        return 0.488603f * direction.y;
+    case 2:
+        return 0.488603f * direction.z;
+    case 3:
+        return 0.488603f * direction.x;
+    case 4:
+        return 1.092548f * direction.x * direction.y;
+    case 5:
+        return 1.092548f * direction.y * direction.z;
+    case 6:
+        return 0.315392f * (3.0f * direction.z * direction.z - 1.0f);
+    case 7:
+        return 1.092548f * direction.x * direction.z;
+    default:
+        return 0.546274f * (direction.x * direction.x - direction.y * direction.y);
+    }
+}
+
+//Clamped cosine convolution for the coefficient's band
+float GetSHBandFactor(int coefficient)
+{
+    if (coefficient == 0)
+    {
+        return PI;
+    }
+
+    if (coefficient < 4)
+    {
+        return PI * 2.0f / 3.0f;
+    }
+
+    return PI * 0.25f;
+}
+
+int2 GetSHCoords(int probeIndex, int coefficient, int numCoefficients, int3 probeCounts, int atlasLayout)
+{
+    int2 dataCoords = GetProbeDataCoords(probeIndex, probeCounts, atlasLayout);
+
+    return int2(dataCoords.x * numCoefficients + coefficient, dataCoords.y);
+}
+
+float3 EvaluateSHIrradiance(int probeIndex, float3 direction, int numCoefficients, int3 probeCounts, int atlasLayout, Texture2D<float4> shAtlas)
+{
+    float3 irradiance = float3(0, 0, 0);
+
+    for (int i = 0; i < numCoefficients; ++i)
+    {
+        irradiance += shAtlas[GetSHCoords(probeIndex, i, numCoefficients, probeCounts, atlasLayout)].rgb * GetSHBasis(direction, i);
+    }
+
+    return irradiance;
+}
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef VERTEX_PACKING_HLSL
+#define VERTEX_PACKING_HLSL
+
+#include "Defines.hlsli"
+#include "Octahedral.hlsl"
+
+//Decodes the attributes of PackedVertex and QuantizedVertex, Helpers/VertexPackingHelper encodes them
+
+float3 UnpackNormal(uint normal)
+{
+    int2 snorm = int2(asint(normal << 16), asint(normal)) >> 16;
+
+    return GetOctahedralDirection(max(snorm / 32767.0f, -1.0f));
+}
+
+float4 UnpackTangent(uint tangent)
+{
+    float2 coords = float2(tangent & 0x7FFF, (tangent >> 15) & 0x7FFF) / 32767.0f * 2.0f - 1.0f;
+
+    return float4(GetOctahedralDirection(coords), (tangent & 0x80000000) != 0 ? -1.0f : 1.0f);
+}
+
+float2 UnpackTexCoords(uint texCoords)
+{
+    return f16tof32(uint2(texCoords, texCoords >> 16));
+}
+
+#endif
@@ -17,6 +17,26 @@ struct Vertex
 	XMFLOAT2 TexCoords;
 };
 
+//VERTEX_FORMAT_PACKED, Normal is octahedral coordinates as two 16 bit SNORMs, Tangent is octahedral coordinates as two
+//15 bit UNORMs with the bitangent sign in the top bit and TexCoords is two halves. See Shaders/VertexPacking.hlsl.
+struct PackedVertex
+{
+	XMFLOAT3 Position;
+	UINT32 Normal;
+	UINT32 Tangent;
+	UINT32 TexCoords;
+};
+
+//VERTEX_FORMAT_QUANTIZED, the same as PackedVertex but with the position as R16G16B16A16_SNORM within the bounds of the
+//vertex's primitive. Bottom level acceleration structures map it back with the primitive's dequantization transform.
+struct QuantizedVertex
+{
+	XMUINT2 Position;
+	UINT32 Normal;
+	UINT32 Tangent;
+	UINT32 TexCoords;
+};
+
 struct ScreenQuadVertex
 {
 #ifndef HLSL
@@ -1,6 +1,8 @@
 #include "Apps/App.h"
 #include "Helpers/DebugHelper.h"
 
+#include <vector>
+
 Tag tag = L"Main";
 
 App* pApp = nullptr;
@@ -10,23 +12,38 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 {
 	pApp = new App(hInstance);
 
-	//Get file path to json file from command line
+	//Get file path to json file from command line, -bench can go anywhere and runs the benchmarks instead of the app
 	std::string filepath = "";
 	std::string runNumber = "";
+	bool bRunBenchmarks = false;
 
 	int iNumArgs = -1;
 	LPWSTR* arguments = CommandLineToArgvW(GetCommandLine(), &iNumArgs);
 
-	if (iNumArgs > 1)
+	std::vector<std::wstring> positionalArguments;
+
+	for (int i = 1; i < iNumArgs; ++i)
+	{
+		if (std::wstring(arguments[i]) == L"-bench")
+		{
+			bRunBenchmarks = true;
+		}
+		else
+		{
+			positionalArguments.push_back(arguments[i]);
+		}
+	}
+
+	if (positionalArguments.size() > 0)
 	{
-		std::wstring tempFilepath = arguments[1];
+		std::wstring tempFilepath = positionalArguments[0];
 
 		filepath = std::string(tempFilepath.begin(), tempFilepath.end());
 	}
 
-	if (iNumArgs > 2)
+	if (positionalArguments.size() > 1)
 	{
-		std::wstring tempRunNumber = arguments[2];
+		std::wstring tempRunNumber = positionalArguments[1];
 
 		runNumber = std::string(tempRunNumber.begin(), tempRunNumber.end());
 	}
@@ -38,5 +55,10 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 		return 0;
 	}
 
+	if (bRunBenchmarks == true)
+	{
+		return App::GetApp()->RunBenchmarks(filepath);
+	}
+
 	return App::GetApp()->Run();
 }
\ No newline at end of file
@@ -0,0 +1,388 @@
+#include "TestHelper.h"
+#include "Helpers/AccessorHelper.h"
+#include "Include/tinygltf/tiny_gltf.h"
+
+#include <random>
+
+namespace
+{
+	const int s_kiComponentTypes[] =
+	{
+		TINYGLTF_COMPONENT_TYPE_BYTE,
+		TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE,
+		TINYGLTF_COMPONENT_TYPE_SHORT,
+		TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT,
+		TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT,
+		TINYGLTF_COMPONENT_TYPE_FLOAT
+	};
+
+	//Written everywhere the decoders shouldn't touch
+	const float s_kfUntouched = -12345.0f;
+
+	//Straight from the glTF spec, one component at a time
+	float DecodeReference(const BYTE* kpData, int iComponentType, bool bNormalized)
+	{
+		float fValue;
+		float fDivisor = 1.0f;
+
+		switch (iComponentType)
+		{
+		case TINYGLTF_COMPONENT_TYPE_BYTE:
+			fValue = (float)*(const INT8*)kpData;
+			fDivisor = 127.0f;
+			break;
+
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+			fValue = (float)*kpData;
+			fDivisor = 255.0f;
+			break;
+
+		case TINYGLTF_COMPONENT_TYPE_SHORT:
+		{
+			INT16 iValue;
+			memcpy(&iValue, kpData, sizeof(INT16));
+
+			fValue = (float)iValue;
+			fDivisor = 32767.0f;
+		}
+		break;
+
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+		{
+			UINT16 uiValue;
+			memcpy(&uiValue, kpData, sizeof(UINT16));
+
+			fValue = (float)uiValue;
+			fDivisor = 65535.0f;
+		}
+		break;
+
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+		{
+			UINT32 uiValue;
+			memcpy(&uiValue, kpData, sizeof(UINT32));
+
+			return (float)uiValue;
+		}
+
+		default:
+			memcpy(&fValue, kpData, sizeof(float));
+
+			return fValue;
+		}
+
+		return bNormalized == true ? fmaxf(fValue / fDivisor, -1.0f) : fValue;
+	}
+
+	//Random bytes with the smallest and largest values of each type mixed in, floats are kept finite
+	std::vector<BYTE> CreateData(size_t uiSize, int iComponentType, int iSeed)
+	{
+		std::mt19937 generator(iSeed);
+		std::vector<BYTE> data(uiSize);
+
+		for (size_t i = 0; i < uiSize; ++i)
+		{
+			data[i] = (BYTE)generator();
+		}
+
+		if (iComponentType == TINYGLTF_COMPONENT_TYPE_FLOAT)
+		{
+			std::uniform_real_distribution<float> values(-1000.0f, 1000.0f);
+
+			for (size_t i = 0; i + sizeof(float) <= uiSize; i += sizeof(float))
+			{
+				float fValue = values(generator);
+				memcpy(&data[i], &fValue, sizeof(float));
+			}
+		}
+		else if (uiSize >= 16)
+		{
+			memset(&data[0], 0x80, 8);
+			memset(&data[8], 0xFF, 8);
+		}
+
+		return data;
+	}
+
+	bool IsBitwiseEqual(float fLHS, float fRHS)
+	{
+		return memcmp(&fLHS, &fRHS, sizeof(float)) == 0;
+	}
+
+	//Decodes into an output with room either side of every element and checks it against the reference
+	void CheckDecode(const AccessorView& kView, int iNumOutputComponents)
+	{
+		const int kiOutputFloats = 6;
+
+		std::vector<float> output((size_t)kView.Count * kiOutputFloats + 1, s_kfUntouched);
+
+		AccessorHelper::DecodeFloats(kView, output.data() + 1, kiOutputFloats * sizeof(float), iNumOutputComponents);
+
+		int iComponentSize = tinygltf::GetComponentSizeInBytes(kView.ComponentType);
+		int iNumDecoded = (std::min)(kView.NumComponents, iNumOutputComponents);
+
+		bool bMatches = output[0] == s_kfUntouched;
+
+		for (UINT i = 0; i < kView.Count; ++i)
+		{
+			const float* kpElement = output.data() + 1 + (size_t)i * kiOutputFloats;
+
+			for (int j = 0; j < kiOutputFloats; ++j)
+			{
+				float fExpected = s_kfUntouched;
+
+				if (j < iNumDecoded)
+				{
+					fExpected = DecodeReference(kView.Data + (size_t)i * kView.ByteStride + j * iComponentSize, kView.ComponentType, kView.Normalized);
+				}
+
+				bMatches = bMatches && IsBitwiseEqual(kpElement[j], fExpected);
+			}
+		}
+
+		if (bMatches == false)
+		{
+			printf("    type %d, %d components, %s, stride %u, count %u, %d output components\n", kView.ComponentType, kView.NumComponents,
+				kView.Normalized == true ? "normalized" : "not normalized", kView.ByteStride, kView.Count, iNumOutputComponents);
+		}
+
+		CHECK(bMatches == true);
+	}
+}
+
+TEST(AccessorDecodeMatchesReference)
+{
+	const UINT kuiCounts[] = { 1, 2, 3, 4, 5, 7, 16, 33 };
+
+	for (int iComponentType : s_kiComponentTypes)
+	{
+		UINT uiComponentSize = (UINT)tinygltf::GetComponentSizeInBytes(iComponentType);
+
+		for (int iNumComponents = 1; iNumComponents <= 4; ++iNumComponents)
+		{
+			UINT uiElementSize = iNumComponents * uiComponentSize;
+
+			//Tightly packed, interleaved and an odd stride that leaves every element unaligned
+			const UINT kuiStrides[] = { uiElementSize, (std::max)(uiElementSize, 32u), uiElementSize + 1 };
+
+			for (UINT uiStride : kuiStrides)
+			{
+				for (UINT uiCount : kuiCounts)
+				{
+					//Exactly as long as the accessor so the last elements have to go through the scalar path
+					std::vector<BYTE> data = CreateData((size_t)(uiCount - 1) * uiStride + uiElementSize, iComponentType, uiCount * 31 + uiStride);
+
+					AccessorView view;
+					view.Data = data.data();
+					view.Count = uiCount;
+					view.ByteStride = uiStride;
+					view.ComponentType = iComponentType;
+					view.NumComponents = iNumComponents;
+
+					for (int iNormalized = 0; iNormalized < 2; ++iNormalized)
+					{
+						view.Normalized = iNormalized == 1;
+
+						CheckDecode(view, iNumComponents);
+					}
+
+					//A narrower output only takes the first components, a wider one leaves the rest alone
+					CheckDecode(view, iNumComponents - 1);
+					CheckDecode(view, 4);
+				}
+			}
+		}
+	}
+}
+
+TEST(AccessorDecodeNormalizesToTheSpecRange)
+{
+	const INT8 kiBytes[4] = { -128, -127, 0, 127 };
+	const UINT16 kuiShorts[4] = { 0, 1, 32768, 65535 };
+
+	float fOutput[4];
+
+	AccessorView view;
+	view.Data = (const BYTE*)kiBytes;
+	view.Count = 1;
+	view.ByteStride = sizeof(kiBytes);
+	view.ComponentType = TINYGLTF_COMPONENT_TYPE_BYTE;
+	view.NumComponents = 4;
+	view.Normalized = true;
+
+	AccessorHelper::DecodeFloats(view, fOutput, sizeof(fOutput), 4);
+
+	//-128 and -127 both map to -1
+	CHECK(fOutput[0] == -1.0f);
+	CHECK(fOutput[1] == -1.0f);
+	CHECK(fOutput[2] == 0.0f);
+	CHECK(fOutput[3] == 1.0f);
+
+	view.Data = (const BYTE*)kuiShorts;
+	view.ByteStride = sizeof(kuiShorts);
+	view.ComponentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT;
+
+	AccessorHelper::DecodeFloats(view, fOutput, sizeof(fOutput), 4);
+
+	CHECK(fOutput[0] == 0.0f);
+	CHECK(fOutput[1] == 1.0f / 65535.0f);
+	CHECK(fOutput[2] == 32768.0f / 65535.0f);
+	CHECK(fOutput[3] == 1.0f);
+}
+
+TEST(AccessorDecodeWithoutDataIsZero)
+{
+	std::vector<float> output(3 * 4, s_kfUntouched);
+
+	AccessorView view;
+	view.Count = 3;
+	view.ComponentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
+	view.NumComponents = 3;
+
+	AccessorHelper::DecodeFloats(view, output.data(), 4 * sizeof(float), 4);
+
+	for (int i = 0; i < 3; ++i)
+	{
+		CHECK(output[i * 4] == 0.0f && output[i * 4 + 1] == 0.0f && output[i * 4 + 2] == 0.0f);
+		CHECK(output[i * 4 + 3] == s_kfUntouched);
+	}
+
+	//Nothing to decode leaves the output alone
+	view.Count = 0;
+	output.assign(4, s_kfUntouched);
+
+	AccessorHelper::DecodeFloats(view, output.data(), 4 * sizeof(float), 4);
+
+	CHECK(output[0] == s_kfUntouched);
+}
+
+TEST(AccessorScatterFloatsOverwritesListedElements)
+{
+	const INT16 kiValues[3 * 2] = { 32767, -32767, 0, 16384, -1, 1 };
+	const UINT kuiIndices[3] = { 4, 0, 2 };
+
+	std::vector<float> output(5 * 3, s_kfUntouched);
+
+	AccessorView view;
+	view.Data = (const BYTE*)kiValues;
+	view.Count = 3;
+	view.ByteStride = 2 * sizeof(INT16);
+	view.ComponentType = TINYGLTF_COMPONENT_TYPE_SHORT;
+	view.NumComponents = 2;
+	view.Normalized = true;
+
+	AccessorHelper::ScatterFloats(view, kuiIndices, output.data(), 3 * sizeof(float), 3);
+
+	for (int i = 0; i < 3; ++i)
+	{
+		const float* kpElement = output.data() + kuiIndices[i] * 3;
+
+		CHECK(IsBitwiseEqual(kpElement[0], DecodeReference((const BYTE*)&kiValues[i * 2], view.ComponentType, true)) == true);
+		CHECK(IsBitwiseEqual(kpElement[1], DecodeReference((const BYTE*)&kiValues[i * 2 + 1], view.ComponentType, true)) == true);
+		CHECK(kpElement[2] == s_kfUntouched);
+	}
+
+	//Elements without a sparse value keep what the base accessor gave them
+	CHECK(output[1 * 3] == s_kfUntouched);
+	CHECK(output[3 * 3] == s_kfUntouched);
+}
+
+TEST(AccessorWidenIndicesMatchesReference)
+{
+	const int kiIndexTypes[3] = { TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE, TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT };
+
+	for (int iComponentType : kiIndexTypes)
+	{
+		int iComponentSize = tinygltf::GetComponentSizeInBytes(iComponentType);
+
+		//Around every batch size so each tail length is covered
+		for (UINT uiCount = 0; uiCount <= 50; ++uiCount)
+		{
+			std::vector<BYTE> data = CreateData((size_t)uiCount * iComponentSize, iComponentType, uiCount);
+			std::vector<UINT> indices(uiCount + 1, 0xDEADBEEF);
+
+			CHECK(AccessorHelper::WidenIndices(data.data(), uiCount, iComponentType, indices.data()) == true);
+
+			bool bMatches = true;
+
+			for (UINT i = 0; i < uiCount; ++i)
+			{
+				UINT uiExpected = 0;
+				memcpy(&uiExpected, &data[(size_t)i * iComponentSize], iComponentSize);
+
+				bMatches = bMatches && indices[i] == uiExpected;
+			}
+
+			CHECK(bMatches == true);
+			CHECK(indices[uiCount] == 0xDEADBEEF);
+		}
+	}
+
+	UINT uiIndex = 0;
+	const BYTE kData[4] = {};
+
+	CHECK(AccessorHelper::WidenIndices(kData, 1, TINYGLTF_COMPONENT_TYPE_SHORT, &uiIndex) == false);
+	CHECK(AccessorHelper::WidenIndices(kData, 1, TINYGLTF_COMPONENT_TYPE_FLOAT, &uiIndex) == false);
+}
+
+TEST(AccessorNormalizeFloat3)
+{
+	//Interleaved with a fourth float that has to be left alone
+	std::vector<float> data =
+	{
+		3.0f, 0.0f, 4.0f, 7.0f,
+		0.0f, 0.0f, 0.0f, 7.0f,
+		-1e-20f, 1e-20f, 0.0f, 7.0f,
+		1e3f, -2e3f, 2e3f, 7.0f
+	};
+
+	AccessorHelper::NormalizeFloat3(data.data(), 4 * sizeof(float), 4);
+
+	CHECK_NEAR(data[0], 0.6f, 1e-6f);
+	CHECK(data[1] == 0.0f);
+	CHECK_NEAR(data[2], 0.8f, 1e-6f);
+
+	//Zero length stays zero rather than becoming NaN
+	CHECK(data[4] == 0.0f && data[5] == 0.0f && data[6] == 0.0f);
+
+	for (int i = 0; i < 4; ++i)
+	{
+		const float* kpElement = &data[i * 4];
+
+		float fLength = sqrtf(kpElement[0] * kpElement[0] + kpElement[1] * kpElement[1] + kpElement[2] * kpElement[2]);
+
+		CHECK(i == 1 || i == 2 || fabsf(fLength - 1.0f) < 1e-6f);
+		CHECK(kpElement[3] == 7.0f);
+	}
+
+	CHECK_NEAR(data[12], 1.0f / 3.0f, 1e-6f);
+	CHECK_NEAR(data[13], -2.0f / 3.0f, 1e-6f);
+}
+
+TEST(AccessorDecodeThroughput)
+{
+	//Not a pass or fail beyond every combination being measured, prints elements per second for the test log
+	const UINT kuiNumElements = 1 << 18;
+
+	std::vector<AccessorDecodeStats> stats = AccessorHelper::MeasureThroughput(kuiNumElements);
+
+	CHECK(stats.size() == _countof(s_kiComponentTypes) * 3 * 2);
+
+	for (int i = 0; i < (int)stats.size(); ++i)
+	{
+		CHECK(stats[i].NumElements == kuiNumElements);
+		CHECK(stats[i].DecodeSeconds >= 0.0f);
+
+		printf("    type %d x%d%s stride %2u: %7.1f M elements/s\n", stats[i].ComponentType, stats[i].NumComponents, stats[i].Normalized == true ? " normalized" : "           ",
+			stats[i].ByteStride, stats[i].GetElementsPerSecond() * 1e-6);
+	}
+
+	std::vector<AccessorDecodeStats> indexStats = AccessorHelper::MeasureIndexThroughput(kuiNumElements);
+
+	CHECK(indexStats.size() == 3);
+
+	for (int i = 0; i < (int)indexStats.size(); ++i)
+	{
+		printf("    indices type %d: %7.1f M indices/s\n", indexStats[i].ComponentType, indexStats[i].GetElementsPerSecond() * 1e-6);
+	}
+}
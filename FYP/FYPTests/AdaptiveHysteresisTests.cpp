@@ -0,0 +1,194 @@
+#include "TestHelper.h"
+#include "GI/CPUProbeBlender.h"
+#include "GI/ProbeConvergenceTracker.h"
+#include "Helpers/ProbeHelper.h"
+
+using namespace DirectX;
+
+namespace
+{
+	const float s_kfMinHysteresis = 0.8f;
+	const float s_kfMaxHysteresis = 0.97f;
+	const float s_kfRiseRate = 0.05f;
+	const float s_kfChangeThreshold = 0.1f;
+
+	XMFLOAT2 Update(const XMFLOAT2& kState, float fChange)
+	{
+		return ProbeHelper::UpdateProbeHysteresis(kState, fChange, s_kfMinHysteresis, s_kfMaxHysteresis, s_kfRiseRate, s_kfChangeThreshold);
+	}
+
+	//Every ray of every probe hits a surface of the same colour
+	void SetRadiance(const XMFLOAT3& kRadiance, CPUAtlas& rayData)
+	{
+		for (int i = 0; i < (int)rayData.Texels.size(); ++i)
+		{
+			rayData.Texels[i] = XMFLOAT4(kRadiance.x, kRadiance.y, kRadiance.z, 2.0f);
+		}
+	}
+
+	XMFLOAT2 GetState(int iProbeIndex, const RaytracePerFrameCB& kParams, const CPUAtlas& kHysteresisAtlas)
+	{
+		XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(iProbeIndex, kParams.ProbeCounts, kParams.AtlasLayout);
+		const XMFLOAT4& kTexel = kHysteresisAtlas.GetTexel(dataCoords.x, dataCoords.y);
+
+		return XMFLOAT2(kTexel.x, kTexel.y);
+	}
+}
+
+TEST(HysteresisRisesWhileProbeIsSteady)
+{
+	//A new probe starts at zero and is raised to the minimum straight away
+	XMFLOAT2 state = Update(XMFLOAT2(0.0f, 0.0f), 0.0f);
+
+	CHECK_NEAR(state.x, s_kfMinHysteresis + (s_kfMaxHysteresis - s_kfMinHysteresis) * s_kfRiseRate, 1e-6f);
+	CHECK(state.y == 0.0f);
+
+	float fPreviousHysteresis = state.x;
+
+	for (int i = 0; i < 200; ++i)
+	{
+		state = Update(state, 0.0f);
+
+		CHECK(state.x >= fPreviousHysteresis);
+		CHECK(state.x <= s_kfMaxHysteresis);
+
+		fPreviousHysteresis = state.x;
+	}
+
+	CHECK_NEAR(state.x, s_kfMaxHysteresis, 1e-4f);
+	CHECK(ProbeHelper::GetProbeConvergence(state, s_kfChangeThreshold) == 1.0f);
+}
+
+TEST(HysteresisRisesSlowerWhileProbeIsChanging)
+{
+	XMFLOAT2 steady = Update(XMFLOAT2(s_kfMinHysteresis, 0.0f), 0.0f);
+	XMFLOAT2 changing = Update(XMFLOAT2(s_kfMinHysteresis, 0.0f), s_kfChangeThreshold * 0.5f);
+
+	//Half the threshold rises at half the rate
+	CHECK_NEAR(changing.x - s_kfMinHysteresis, (steady.x - s_kfMinHysteresis) * 0.5f, 1e-6f);
+
+	//Right on the threshold doesn't rise at all but isn't reset either
+	XMFLOAT2 onThreshold = Update(XMFLOAT2(0.9f, 0.0f), s_kfChangeThreshold);
+
+	CHECK_NEAR(onThreshold.x, 0.9f, 1e-6f);
+}
+
+TEST(HysteresisSnapsDownOnLightingChange)
+{
+	XMFLOAT2 state = XMFLOAT2(s_kfMaxHysteresis, 0.0f);
+	state = Update(state, s_kfChangeThreshold * 1.01f);
+
+	CHECK(state.x == s_kfMinHysteresis);
+
+	//The change is smoothed over about ten frames
+	CHECK_NEAR(state.y, s_kfChangeThreshold * 1.01f * 0.1f, 1e-6f);
+
+	float fPreviousChange = state.y;
+
+	for (int i = 0; i < 5; ++i)
+	{
+		state = Update(state, s_kfChangeThreshold * 2.0f);
+
+		CHECK(state.x == s_kfMinHysteresis);
+		CHECK(state.y > fPreviousChange);
+
+		fPreviousChange = state.y;
+	}
+
+	CHECK(ProbeHelper::GetProbeConvergence(state, s_kfChangeThreshold) < 1.0f);
+	CHECK(ProbeHelper::GetProbeBlendedChange(state) == (1.0f - state.x) * state.y);
+}
+
+TEST(ProbeConvergenceFollowsSmoothedChange)
+{
+	CHECK(ProbeHelper::GetProbeConvergence(XMFLOAT2(0.9f, 0.0f), s_kfChangeThreshold) == 1.0f);
+	CHECK_NEAR(ProbeHelper::GetProbeConvergence(XMFLOAT2(0.9f, s_kfChangeThreshold * 0.5f), s_kfChangeThreshold), 0.5f, 1e-6f);
+	CHECK(ProbeHelper::GetProbeConvergence(XMFLOAT2(0.9f, s_kfChangeThreshold), s_kfChangeThreshold) == 0.0f);
+	CHECK(ProbeHelper::GetProbeConvergence(XMFLOAT2(0.9f, s_kfChangeThreshold * 3.0f), s_kfChangeThreshold) == 0.0f);
+}
+
+TEST(ConvergenceTrackerStats)
+{
+	std::vector<XMFLOAT2> states = {
+		XMFLOAT2(s_kfMinHysteresis, 0.2f),			//Just reset
+		XMFLOAT2(0.9f, 0.05f),						//Half way
+		XMFLOAT2(0.95f, 0.01f),						//Converged
+		XMFLOAT2(s_kfMaxHysteresis, 0.0f) };		//Converged
+
+	ProbeConvergenceTracker tracker;
+	tracker.Update(states, s_kfMinHysteresis, s_kfChangeThreshold);
+
+	const ProbeConvergenceStats& kStats = tracker.GetStats();
+
+	CHECK(kStats.NumProbes == 4);
+	CHECK(kStats.NumConverged == 2);
+	CHECK(kStats.NumReset == 1);
+	CHECK_NEAR(kStats.MeanHysteresis, (s_kfMinHysteresis + 0.9f + 0.95f + s_kfMaxHysteresis) / 4.0f, 1e-6f);
+	CHECK_NEAR(kStats.MeanConvergence, (0.0f + 0.5f + 0.9f + 1.0f) / 4.0f, 1e-6f);
+
+	CHECK(tracker.GetProbeHysteresis(2) == 0.95f);
+	CHECK_NEAR(tracker.GetProbeConvergence(1), 0.5f, 1e-6f);
+
+	//Out of range probes read as nothing rather than asserting
+	CHECK(tracker.GetProbeHysteresis(-1) == 0.0f);
+	CHECK(tracker.GetProbeConvergence(4) == 0.0f);
+
+	tracker.Reset();
+
+	CHECK(tracker.GetStats().NumProbes == 0);
+	CHECK(tracker.GetProbeHysteresis(0) == 0.0f);
+}
+
+TEST(BlenderAdaptsHysteresisPerProbe)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(2, 2, 2), 64);
+	params.AdaptiveHysteresis = 1;
+
+	CPUAtlas rayData;
+	CPUAtlas irradianceAtlas;
+	CPUAtlas distanceAtlas;
+	CPUProbeBlender::CreateAtlases(params, rayData, irradianceAtlas, distanceAtlas);
+
+	CPUAtlas hysteresisAtlas;
+	CPUProbeBlender::CreateHysteresisAtlas(params, hysteresisAtlas);
+
+	SetRadiance(XMFLOAT3(0.5f, 0.5f, 0.5f), rayData);
+
+	CPUProbeBlender blender;
+
+	for (int i = 0; i < 300; ++i)
+	{
+		blender.BlendProbeAtlases(params, rayData, irradianceAtlas, distanceAtlas, &hysteresisAtlas);
+	}
+
+	std::vector<XMFLOAT2> states(TestHelper::GetNumProbes(params));
+
+	for (int i = 0; i < (int)states.size(); ++i)
+	{
+		states[i] = GetState(i, params, hysteresisAtlas);
+
+		CHECK_NEAR(states[i].x, params.Hysteresis, 1e-3f);
+	}
+
+	ProbeConvergenceTracker tracker;
+	tracker.Update(states, params.MinHysteresis, params.HysteresisChangeThreshold);
+
+	CHECK(tracker.GetStats().NumConverged == (int)states.size());
+	CHECK(tracker.GetStats().NumReset == 0);
+
+	//The light gets much brighter so every probe drops to the minimum for the next frame
+	SetRadiance(XMFLOAT3(5.0f, 5.0f, 5.0f), rayData);
+
+	blender.BlendProbeAtlases(params, rayData, irradianceAtlas, distanceAtlas, &hysteresisAtlas);
+
+	for (int i = 0; i < (int)states.size(); ++i)
+	{
+		states[i] = GetState(i, params, hysteresisAtlas);
+
+		CHECK(states[i].x == params.MinHysteresis);
+	}
+
+	tracker.Update(states, params.MinHysteresis, params.HysteresisChangeThreshold);
+
+	CHECK(tracker.GetStats().NumReset == (int)states.size());
+}
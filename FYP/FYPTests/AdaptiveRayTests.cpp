@@ -0,0 +1,218 @@
+#include "TestHelper.h"
+#include "GI/AdaptiveRayAllocator.h"
+#include "GI/CPUProbeBlender.h"
+#include "Helpers/ProbeHelper.h"
+
+#include <algorithm>
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	void CreateRandomRayData(const RaytracePerFrameCB& kParams, int iSeed, CPUAtlas& rayData)
+	{
+		std::mt19937 generator(iSeed);
+		std::uniform_real_distribution<float> radiances(0.0f, 2.0f);
+		std::uniform_real_distribution<float> distances(0.1f, 4.0f);
+
+		rayData.Resize(kParams.RaysPerProbe, TestHelper::GetNumProbes(kParams));
+
+		for (int i = 0; i < (int)rayData.Texels.size(); ++i)
+		{
+			float fRed = radiances(generator);
+			float fGreen = radiances(generator);
+			float fBlue = radiances(generator);
+
+			rayData.Texels[i] = XMFLOAT4(fRed, fGreen, fBlue, distances(generator));
+		}
+	}
+
+	//Largest difference between the two atlases over the probe's tile, borders included
+	float GetTileDifference(int iProbeIndex, int iNumTexels, const RaytracePerFrameCB& kParams, const CPUAtlas& kAtlas, const CPUAtlas& kOtherAtlas)
+	{
+		XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(iProbeIndex, kParams.ProbeCounts, kParams.AtlasLayout);
+
+		int iTileSize = iNumTexels + 2;
+		float fDifference = 0.0f;
+
+		for (int y = dataCoords.y * iTileSize; y < (dataCoords.y + 1) * iTileSize; ++y)
+		{
+			for (int x = dataCoords.x * iTileSize; x < (dataCoords.x + 1) * iTileSize; ++x)
+			{
+				const XMFLOAT4& kTexel = kAtlas.GetTexel(x, y);
+				const XMFLOAT4& kOtherTexel = kOtherAtlas.GetTexel(x, y);
+
+				fDifference = (std::max)(fDifference, fabsf(kTexel.x - kOtherTexel.x));
+				fDifference = (std::max)(fDifference, fabsf(kTexel.y - kOtherTexel.y));
+				fDifference = (std::max)(fDifference, fabsf(kTexel.z - kOtherTexel.z));
+			}
+		}
+
+		return fDifference;
+	}
+}
+
+//====================================================
+//Blender
+//====================================================
+
+TEST(BlenderWithPerProbeRayCountsMatchesFewerRays)
+{
+	RaytracePerFrameCB adaptiveParams = TestHelper::CreateParams(XMINT3(2, 2, 2), 64);
+	adaptiveParams.AdaptiveRays = 1;
+
+	//Even probes trace half the rays
+	std::vector<uint32_t> rayCounts(TestHelper::GetNumProbes(adaptiveParams));
+
+	for (int i = 0; i < (int)rayCounts.size(); ++i)
+	{
+		rayCounts[i] = i % 2 == 0 ? 32 : 64;
+	}
+
+	CPUAtlas rayData;
+	CPUAtlas irradianceAtlas;
+	CPUAtlas distanceAtlas;
+	CPUProbeBlender::CreateAtlases(adaptiveParams, rayData, irradianceAtlas, distanceAtlas);
+	CreateRandomRayData(adaptiveParams, 3, rayData);
+
+	CPUProbeBlender blender;
+	blender.BlendProbeAtlases(adaptiveParams, rayData, irradianceAtlas, distanceAtlas, nullptr, rayCounts.data());
+
+	//The same rays blended without adaptive rays, once with every probe tracing 64 and once with every probe tracing 32
+	RaytracePerFrameCB fullParams = adaptiveParams;
+	fullParams.AdaptiveRays = 0;
+
+	CPUAtlas fullRayData;
+	CPUAtlas fullIrradianceAtlas;
+	CPUAtlas fullDistanceAtlas;
+	CPUProbeBlender::CreateAtlases(fullParams, fullRayData, fullIrradianceAtlas, fullDistanceAtlas);
+	fullRayData = rayData;
+
+	blender.BlendProbeAtlases(fullParams, fullRayData, fullIrradianceAtlas, fullDistanceAtlas);
+
+	RaytracePerFrameCB halfParams = fullParams;
+	halfParams.RaysPerProbe = 32;
+
+	CPUAtlas halfRayData;
+	CPUAtlas halfIrradianceAtlas;
+	CPUAtlas halfDistanceAtlas;
+	CPUProbeBlender::CreateAtlases(halfParams, halfRayData, halfIrradianceAtlas, halfDistanceAtlas);
+
+	for (int i = 0; i < halfRayData.Height; ++i)
+	{
+		for (int j = 0; j < halfRayData.Width; ++j)
+		{
+			halfRayData.GetTexel(j, i) = rayData.GetTexel(j, i);
+		}
+	}
+
+	blender.BlendProbeAtlases(halfParams, halfRayData, halfIrradianceAtlas, halfDistanceAtlas);
+
+	for (int i = 0; i < TestHelper::GetNumProbes(adaptiveParams); ++i)
+	{
+		const CPUAtlas& kExpectedIrradiance = rayCounts[i] == 32 ? halfIrradianceAtlas : fullIrradianceAtlas;
+		const CPUAtlas& kExpectedDistance = rayCounts[i] == 32 ? halfDistanceAtlas : fullDistanceAtlas;
+
+		CHECK_NEAR(GetTileDifference(i, adaptiveParams.NumIrradianceTexels, adaptiveParams, irradianceAtlas, kExpectedIrradiance), 0.0f, 1e-4f);
+		CHECK_NEAR(GetTileDifference(i, adaptiveParams.NumDistanceTexels, adaptiveParams, distanceAtlas, kExpectedDistance), 0.0f, 1e-4f);
+	}
+
+	//Make sure the two references differ, otherwise the comparison above proves nothing
+	CHECK(GetTileDifference(0, adaptiveParams.NumIrradianceTexels, adaptiveParams, halfIrradianceAtlas, fullIrradianceAtlas) > 1e-3f);
+}
+
+//====================================================
+//Ray allocation
+//====================================================
+
+TEST(AllocatorKeepsCountsWithinLimits)
+{
+	AdaptiveRayAllocator allocator;
+	allocator.SetRayBudget(100 * 96);
+
+	std::mt19937 generator(5);
+	std::uniform_real_distribution<float> means(0.05f, 2.0f);
+	std::uniform_real_distribution<float> variances(0.0f, 0.5f);
+
+	std::vector<float> probeMeans(100);
+	std::vector<float> probeVariances(100);
+
+	for (int i = 0; i < 100; ++i)
+	{
+		probeMeans[i] = means(generator);
+		probeVariances[i] = variances(generator);
+	}
+
+	//A few probes that are all noise and a few that never change, so both limits get hit
+	probeVariances[0] = 100.0f;
+	probeVariances[1] = 100.0f;
+	probeVariances[2] = 0.0f;
+	probeVariances[3] = 0.0f;
+
+	std::vector<UINT> rayCounts;
+	allocator.Allocate(probeMeans, probeVariances, rayCounts);
+
+	CHECK(rayCounts.size() == 100);
+
+	int iTotal = 0;
+
+	for (int i = 0; i < (int)rayCounts.size(); ++i)
+	{
+		CHECK(rayCounts[i] % allocator.GetGranularity() == 0);
+		CHECK((int)rayCounts[i] >= allocator.GetMinRays());
+		CHECK((int)rayCounts[i] <= allocator.GetMaxRays());
+
+		iTotal += rayCounts[i];
+	}
+
+	CHECK(iTotal <= allocator.GetRayBudget());
+	CHECK(iTotal > allocator.GetRayBudget() - (int)rayCounts.size() * allocator.GetGranularity());
+
+	CHECK((int)rayCounts[0] == allocator.GetMaxRays());
+	CHECK((int)rayCounts[2] == allocator.GetMinRays());
+}
+
+TEST(AllocatorGivesNoisierProbesMoreRays)
+{
+	AdaptiveRayAllocator allocator;
+	allocator.SetRayBudget(4 * 96);
+
+	std::vector<float> means = { 1.0f, 1.0f, 1.0f, 1.0f };
+	std::vector<float> variances = { 0.01f, 0.04f, 0.09f, 0.16f };
+	std::vector<UINT> rayCounts = { 96, 96, 96, 96 };
+
+	allocator.Allocate(means, variances, rayCounts);
+
+	for (int i = 1; i < 4; ++i)
+	{
+		CHECK(rayCounts[i] >= rayCounts[i - 1]);
+	}
+
+	CHECK(rayCounts[3] > rayCounts[0]);
+
+	//Spending the rays where the noise is can only do better than splitting them evenly
+	std::vector<UINT> uniformCounts;
+	allocator.AllocateUniform(4, uniformCounts);
+
+	CHECK(uniformCounts == std::vector<UINT>({ 96, 96, 96, 96 }));
+
+	std::vector<float> sigmas;
+	AdaptiveRayAllocator::GetSigmas(means, variances, uniformCounts, sigmas);
+
+	CHECK(AdaptiveRayAllocator::GetExpectedError(sigmas, rayCounts) < AdaptiveRayAllocator::GetExpectedError(sigmas, uniformCounts));
+}
+
+TEST(AllocatorSplitsEvenlyWithoutStatistics)
+{
+	AdaptiveRayAllocator allocator;
+	allocator.SetRayBudget(8 * 64);
+
+	std::vector<float> means(8, 1.0f);
+	std::vector<float> variances(8, 0.0f);
+	std::vector<UINT> rayCounts;
+
+	allocator.Allocate(means, variances, rayCounts);
+
+	CHECK(rayCounts == std::vector<UINT>(8, 64));
+}
@@ -0,0 +1,103 @@
+#include "TestHelper.h"
+#include "Helpers/ProbeHelper.h"
+#include "Shaders/Defines.hlsli"
+
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	//Odd plane counts leave the last plane without a pair in the brick layout
+	const XMINT3 s_kProbeCounts[] = { XMINT3(1, 1, 1), XMINT3(2, 2, 2), XMINT3(4, 3, 2), XMINT3(3, 4, 5), XMINT3(6, 7, 4), XMINT3(5, 1, 3) };
+
+	const int s_kiLayouts[2] = { PROBE_ATLAS_LAYOUT_PLANES, PROBE_ATLAS_LAYOUT_BRICKS };
+}
+
+TEST(AtlasLayoutsGiveEveryProbeItsOwnTile)
+{
+	const int kiNumTexels = 6;
+
+	for (const XMINT3& kProbeCounts : s_kProbeCounts)
+	{
+		int iNumProbes = kProbeCounts.x * kProbeCounts.y * kProbeCounts.z;
+		int iTilesX = kProbeCounts.x * kProbeCounts.y;
+
+		for (int iLayout : s_kiLayouts)
+		{
+			//Both layouts fill the same atlas so the textures don't change size
+			std::vector<int> tiles(iTilesX * kProbeCounts.z, -1);
+
+			for (int i = 0; i < iNumProbes; ++i)
+			{
+				XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(i, kProbeCounts, iLayout);
+
+				CHECK(dataCoords.x >= 0 && dataCoords.x < iTilesX);
+				CHECK(dataCoords.y >= 0 && dataCoords.y < kProbeCounts.z);
+
+				if (dataCoords.x < 0 || dataCoords.x >= iTilesX || dataCoords.y < 0 || dataCoords.y >= kProbeCounts.z)
+				{
+					continue;
+				}
+
+				CHECK(tiles[(dataCoords.y * iTilesX) + dataCoords.x] == -1);
+				tiles[(dataCoords.y * iTilesX) + dataCoords.x] = i;
+
+				//Every texel of the tile, as the blend dispatches see them, leads back to the same probe
+				for (int y = 0; y < kiNumTexels; ++y)
+				{
+					for (int x = 0; x < kiNumTexels; ++x)
+					{
+						XMINT2 texCoords = XMINT2((dataCoords.x * kiNumTexels) + x, (dataCoords.y * kiNumTexels) + y);
+
+						CHECK(ProbeHelper::GetProbeIndex(texCoords, kiNumTexels, kProbeCounts, iLayout) == i);
+					}
+				}
+			}
+		}
+	}
+}
+
+TEST(PlaneLayoutKeepsPlanesSideBySide)
+{
+	const XMINT3 kProbeCounts = XMINT3(4, 3, 2);
+
+	for (int i = 0; i < kProbeCounts.x * kProbeCounts.y * kProbeCounts.z; ++i)
+	{
+		XMINT3 probeCoords = ProbeHelper::GetProbeCoords(i, kProbeCounts);
+		XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(i, kProbeCounts, PROBE_ATLAS_LAYOUT_PLANES);
+
+		CHECK(dataCoords.x == (probeCoords.y * kProbeCounts.x) + probeCoords.x);
+		CHECK(dataCoords.y == probeCoords.z);
+	}
+}
+
+TEST(BrickLayoutKeepsBricksInAdjacentTiles)
+{
+	const XMINT3 kProbeCounts = XMINT3(4, 5, 3);
+
+	for (int z = 0; z < kProbeCounts.z; ++z)
+	{
+		for (int y = 0; y < kProbeCounts.y; ++y)
+		{
+			for (int x = 0; x < kProbeCounts.x; ++x)
+			{
+				int iProbeIndex = ProbeHelper::GetProbeIndex(XMINT3(x, y, z), kProbeCounts);
+				XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(iProbeIndex, kProbeCounts, PROBE_ATLAS_LAYOUT_BRICKS);
+
+				CHECK(dataCoords.y == z);
+
+				if (y == kProbeCounts.y - 1)
+				{
+					//The unpaired last plane is laid out on its own after the pairs
+					CHECK(dataCoords.x == ((kProbeCounts.y - 1) * kProbeCounts.x) + x);
+
+					continue;
+				}
+
+				//Pairs of planes interleave, so each 2x2 brick of a pair is a 4x1 strip of tiles
+				CHECK(dataCoords.x == ((y / 2) * kProbeCounts.x * 2) + (x * 2) + (y & 1));
+			}
+		}
+	}
+}
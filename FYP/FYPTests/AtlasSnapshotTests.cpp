@@ -0,0 +1,226 @@
+#include "TestHelper.h"
+#include "GI/AtlasSnapshot.h"
+#include "Shaders/Defines.hlsli"
+
+#include <fstream>
+#include <stdio.h>
+
+using namespace DirectX;
+
+namespace
+{
+	const char* s_kpFilepath = "AtlasSnapshotTests.gias";
+
+	AtlasSnapshotDesc CreateDesc()
+	{
+		AtlasSnapshotDesc desc;
+		desc.Position = XMFLOAT3(1.0f, 2.0f, 3.0f);
+		desc.ProbeCounts = XMINT3(4, 3, 2);
+		desc.ProbeOffsets = XMINT3(1, 0, -1);
+		desc.IrradianceTexelsPerProbe = 6;
+		desc.DistanceTexelsPerProbe = 14;
+		desc.GIAtlasSize = 0;
+		desc.RayDataFormat = FORMAT_PROBE_RAY_DATA_R32G32B32A32_FLOAT;
+		desc.IrradianceFormat = FORMAT_PROBE_IRRADIANCE_R10G10B10A2_FLOAT;
+		desc.IrradianceEncoding = PROBE_IRRADIANCE_ENCODING_OCTAHEDRAL;
+		desc.AtlasLayout = PROBE_ATLAS_LAYOUT_PLANES;
+
+		return desc;
+	}
+
+	AtlasSnapshotEntry CreateEntry(SnapshotAtlas atlas, DXGI_FORMAT format, UINT32 uiWidth, UINT32 uiHeight, UINT32 uiRowSize)
+	{
+		AtlasSnapshotEntry entry = {};
+		entry.Type = atlas;
+		entry.Format = format;
+		entry.Width = uiWidth;
+		entry.Height = uiHeight;
+		entry.RowSize = uiRowSize;
+
+		return entry;
+	}
+
+	//Writes an irradiance and a distance atlas filled with a known pattern, the probe data atlas is left out
+	bool WriteSnapshot(std::vector<std::vector<BYTE>>& data)
+	{
+		std::vector<AtlasSnapshotEntry> entries;
+		entries.push_back(CreateEntry(SnapshotAtlas::IRRADIANCE, DXGI_FORMAT_R10G10B10A2_UNORM, 32, 18, 32 * 4));
+		entries.push_back(CreateEntry(SnapshotAtlas::DISTANCE, DXGI_FORMAT_R16G16_FLOAT, 64, 34, 64 * 4));
+
+		data.resize(entries.size());
+		std::vector<const BYTE*> dataPtrs(entries.size());
+
+		for (int i = 0; i < entries.size(); ++i)
+		{
+			data[i].resize((size_t)entries[i].RowSize * entries[i].Height);
+
+			for (int j = 0; j < data[i].size(); ++j)
+			{
+				data[i][j] = (BYTE)(j * 7 + i);
+			}
+
+			dataPtrs[i] = data[i].data();
+		}
+
+		return AtlasSnapshot::Write(s_kpFilepath, CreateDesc(), entries, dataPtrs);
+	}
+
+	//Overwrites part of the written file to corrupt it
+	void PatchSnapshot(size_t offset, const void* kpData, size_t size)
+	{
+		std::fstream file(s_kpFilepath, std::ios::binary | std::ios::in | std::ios::out);
+		file.seekp(offset);
+		file.write((const char*)kpData, size);
+	}
+
+	void TruncateSnapshot(size_t size)
+	{
+		std::vector<char> contents(size);
+
+		std::ifstream inFile(s_kpFilepath, std::ios::binary);
+		inFile.read(contents.data(), size);
+		inFile.close();
+
+		std::ofstream outFile(s_kpFilepath, std::ios::binary | std::ios::trunc);
+		outFile.write(contents.data(), size);
+	}
+}
+
+TEST(SnapshotRoundTrips)
+{
+	std::vector<std::vector<BYTE>> data;
+	CHECK(WriteSnapshot(data) == true);
+
+	AtlasSnapshot snapshot;
+	CHECK(snapshot.Open(s_kpFilepath) == true);
+
+	const AtlasSnapshotDesc& kDesc = snapshot.GetDesc();
+	CHECK(kDesc.Position.x == 1.0f && kDesc.Position.y == 2.0f && kDesc.Position.z == 3.0f);
+	CHECK(kDesc.ProbeOffsets.x == 1 && kDesc.ProbeOffsets.y == 0 && kDesc.ProbeOffsets.z == -1);
+	CHECK(snapshot.IsCompatible(CreateDesc()) == true);
+
+	const SnapshotAtlas kAtlases[2] = { SnapshotAtlas::IRRADIANCE, SnapshotAtlas::DISTANCE };
+
+	for (int i = 0; i < 2; ++i)
+	{
+		const AtlasSnapshotEntry* kpEntry = snapshot.GetEntry(kAtlases[i]);
+		CHECK(kpEntry != nullptr);
+
+		if (kpEntry != nullptr)
+		{
+			CHECK(snapshot.IsCompatible(kAtlases[i], kpEntry->Format, kpEntry->Width, kpEntry->Height, kpEntry->RowSize) == true);
+			CHECK(memcmp(snapshot.GetData(kpEntry), data[i].data(), data[i].size()) == 0);
+		}
+	}
+
+	CHECK(snapshot.GetEntry(SnapshotAtlas::PROBE_DATA) == nullptr);
+
+	snapshot.Close();
+	remove(s_kpFilepath);
+}
+
+TEST(SnapshotRejectsMismatchedDesc)
+{
+	std::vector<std::vector<BYTE>> data;
+	WriteSnapshot(data);
+
+	AtlasSnapshot snapshot;
+	CHECK(snapshot.Open(s_kpFilepath) == true);
+
+	//Where the volume was doesn't change the atlases' layout
+	AtlasSnapshotDesc desc = CreateDesc();
+	desc.Position = XMFLOAT3(-5.0f, 0.0f, 5.0f);
+	desc.ProbeOffsets = XMINT3(2, 2, 2);
+	CHECK(snapshot.IsCompatible(desc) == true);
+
+	desc = CreateDesc();
+	desc.ProbeCounts.y = 4;
+	CHECK(snapshot.IsCompatible(desc) == false);
+
+	desc = CreateDesc();
+	desc.IrradianceTexelsPerProbe = 8;
+	CHECK(snapshot.IsCompatible(desc) == false);
+
+	desc = CreateDesc();
+	desc.DistanceTexelsPerProbe = 16;
+	CHECK(snapshot.IsCompatible(desc) == false);
+
+	desc = CreateDesc();
+	desc.GIAtlasSize = 1;
+	CHECK(snapshot.IsCompatible(desc) == false);
+
+	desc = CreateDesc();
+	desc.RayDataFormat = FORMAT_PROBE_RAY_DATA_R32G32_FLOAT;
+	CHECK(snapshot.IsCompatible(desc) == false);
+
+	desc = CreateDesc();
+	desc.IrradianceFormat = FORMAT_PROBE_IRRADIANCE_R11G11B10_FLOAT;
+	CHECK(snapshot.IsCompatible(desc) == false);
+
+	desc = CreateDesc();
+	desc.IrradianceEncoding = PROBE_IRRADIANCE_ENCODING_SH_L2;
+	CHECK(snapshot.IsCompatible(desc) == false);
+
+	desc = CreateDesc();
+	desc.AtlasLayout = PROBE_ATLAS_LAYOUT_BRICKS;
+	CHECK(snapshot.IsCompatible(desc) == false);
+
+	snapshot.Close();
+	remove(s_kpFilepath);
+}
+
+TEST(SnapshotRejectsMismatchedAtlases)
+{
+	std::vector<std::vector<BYTE>> data;
+	WriteSnapshot(data);
+
+	AtlasSnapshot snapshot;
+	CHECK(snapshot.Open(s_kpFilepath) == true);
+
+	CHECK(snapshot.IsCompatible(SnapshotAtlas::IRRADIANCE, DXGI_FORMAT_R10G10B10A2_UNORM, 32, 18, 32 * 4) == true);
+	CHECK(snapshot.IsCompatible(SnapshotAtlas::IRRADIANCE, DXGI_FORMAT_R16G16B16A16_FLOAT, 32, 18, 32 * 8) == false);
+	CHECK(snapshot.IsCompatible(SnapshotAtlas::IRRADIANCE, DXGI_FORMAT_R10G10B10A2_UNORM, 40, 18, 32 * 4) == false);
+	CHECK(snapshot.IsCompatible(SnapshotAtlas::IRRADIANCE, DXGI_FORMAT_R10G10B10A2_UNORM, 32, 24, 32 * 4) == false);
+	CHECK(snapshot.IsCompatible(SnapshotAtlas::IRRADIANCE, DXGI_FORMAT_R10G10B10A2_UNORM, 32, 18, 40 * 4) == false);
+	CHECK(snapshot.IsCompatible(SnapshotAtlas::PROBE_DATA, DXGI_FORMAT_R16G16B16A16_FLOAT, 32, 18, 32 * 8) == false);
+
+	snapshot.Close();
+	remove(s_kpFilepath);
+}
+
+TEST(SnapshotRejectsBadHeaders)
+{
+	std::vector<std::vector<BYTE>> data;
+	AtlasSnapshot snapshot;
+
+	WriteSnapshot(data);
+	PatchSnapshot(offsetof(AtlasSnapshotHeader, Magic), "DDGI", 4);
+	CHECK(snapshot.Open(s_kpFilepath) == false);
+
+	UINT32 uiHeaderSize = sizeof(AtlasSnapshotHeader) + 4;
+	WriteSnapshot(data);
+	PatchSnapshot(offsetof(AtlasSnapshotHeader, HeaderSize), &uiHeaderSize, sizeof(UINT32));
+	CHECK(snapshot.Open(s_kpFilepath) == false);
+
+	UINT32 uiVersion = ATLAS_SNAPSHOT_VERSION - 1;
+	WriteSnapshot(data);
+	PatchSnapshot(offsetof(AtlasSnapshotHeader, Version), &uiVersion, sizeof(UINT32));
+	CHECK(snapshot.Open(s_kpFilepath) == false);
+
+	//Cut off inside the header, inside the entry table and inside the last atlas
+	const size_t kSizes[3] = { sizeof(AtlasSnapshotHeader) - 8, sizeof(AtlasSnapshotHeader) + sizeof(AtlasSnapshotEntry), sizeof(AtlasSnapshotHeader) + 2 * sizeof(AtlasSnapshotEntry) + data[0].size() + data[1].size() - 1 };
+
+	for (int i = 0; i < 3; ++i)
+	{
+		WriteSnapshot(data);
+		TruncateSnapshot(kSizes[i]);
+		CHECK(snapshot.Open(s_kpFilepath) == false);
+	}
+
+	//The untouched file still opens so the checks above failed for the right reason
+	WriteSnapshot(data);
+	CHECK(snapshot.Open(s_kpFilepath) == true);
+
+	snapshot.Close();
+	remove(s_kpFilepath);
+}
@@ -0,0 +1,277 @@
+#include "TestHelper.h"
+#include "GI/GICascades.h"
+#include "Helpers/ProbeHelper.h"
+
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	//Three cascades of 4x4x4 probes at the origin with 1, 2 and 4 unit spacings. They cover up to 1.5, 3 and 6 units
+	//from the centre and fade out over the next 1, 2 and 4 units.
+	void CreateCascades(GICascades& cascades)
+	{
+		cascades.Init(3, XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f), XMINT3(4, 4, 4), XMINT3(0, 0, 0));
+	}
+}
+
+TEST(CascadesInitDoublesSpacing)
+{
+	GICascades cascades;
+	cascades.Init(3, XMFLOAT3(1.0f, 2.0f, 3.0f), XMFLOAT3(1.0f, 0.5f, 2.0f), XMINT3(4, 3, 5), XMINT3(1, 0, -1));
+
+	CHECK(cascades.GetNumCascades() == 3);
+
+	for (int i = 0; i < 3; ++i)
+	{
+		const GICascade& kCascade = cascades.GetCascade(i);
+
+		CHECK(kCascade.ProbeSpacing.x == (float)(1 << i));
+		CHECK(kCascade.ProbeSpacing.y == 0.5f * (1 << i));
+		CHECK(kCascade.ProbeSpacing.z == 2.0f * (1 << i));
+		CHECK(kCascade.UpdateInterval == 1 << i);
+		CHECK(kCascade.Position.y == 2.0f);
+	}
+
+	//Only the finest cascade starts where the volume was left
+	CHECK(cascades.GetCascade(0).ProbeOffsets.x == 1);
+	CHECK(cascades.GetCascade(1).ProbeOffsets.x == 0);
+
+	cascades.Init(MAX_GI_CASCADES + 3, XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f), XMINT3(2, 2, 2), XMINT3(0, 0, 0));
+
+	CHECK(cascades.GetNumCascades() == MAX_GI_CASCADES);
+}
+
+TEST(CascadesSelectAtBoundaries)
+{
+	GICascades cascades;
+	CreateCascades(cascades);
+
+	CHECK(cascades.SelectCascade(XMFLOAT3(0.0f, 0.0f, 0.0f)) == 0);
+	CHECK(cascades.SelectCascade(XMFLOAT3(1.5f, 0.0f, 0.0f)) == 0);
+
+	//Still fading out of cascade 0 until a full probe spacing past its last probe
+	CHECK(cascades.SelectCascade(XMFLOAT3(2.49f, 0.0f, 0.0f)) == 0);
+	CHECK(cascades.SelectCascade(XMFLOAT3(2.5f, 0.0f, 0.0f)) == 1);
+	CHECK(cascades.SelectCascade(XMFLOAT3(0.0f, -2.5f, 0.0f)) == 1);
+
+	CHECK(cascades.SelectCascade(XMFLOAT3(0.0f, 0.0f, 4.99f)) == 1);
+	CHECK(cascades.SelectCascade(XMFLOAT3(0.0f, 0.0f, 5.0f)) == 2);
+
+	CHECK(cascades.SelectCascade(XMFLOAT3(-9.99f, 0.0f, 0.0f)) == 2);
+	CHECK(cascades.SelectCascade(XMFLOAT3(-10.0f, 0.0f, 0.0f)) == -1);
+
+	//Any one axis past the fade is enough to be outside
+	CHECK(cascades.SelectCascade(XMFLOAT3(0.0f, 2.5f, 0.0f)) == 1);
+	CHECK(cascades.SelectCascade(XMFLOAT3(1.0f, 1.0f, 2.5f)) == 1);
+}
+
+TEST(CascadesWeightsFinestFirst)
+{
+	GICascades cascades;
+	CreateCascades(cascades);
+
+	std::vector<float> weights;
+
+	cascades.GetCascadeWeights(XMFLOAT3(1.0f, -1.0f, 0.5f), weights);
+
+	CHECK(weights.size() == 3);
+	CHECK(weights[0] == 1.0f);
+	CHECK(weights[1] == 0.0f);
+	CHECK(weights[2] == 0.0f);
+
+	//Half way through cascade 0's fade cascade 1 takes the other half
+	cascades.GetCascadeWeights(XMFLOAT3(2.0f, 0.0f, 0.0f), weights);
+
+	CHECK_NEAR(weights[0], 0.5f, 1e-6f);
+	CHECK_NEAR(weights[1], 0.5f, 1e-6f);
+	CHECK(weights[2] == 0.0f);
+
+	cascades.GetCascadeWeights(XMFLOAT3(0.0f, 4.0f, 0.0f), weights);
+
+	CHECK(weights[0] == 0.0f);
+	CHECK_NEAR(weights[1], 0.5f, 1e-6f);
+	CHECK_NEAR(weights[2], 0.5f, 1e-6f);
+
+	//Past the last cascade's fade there is nothing left
+	cascades.GetCascadeWeights(XMFLOAT3(0.0f, 0.0f, -12.0f), weights);
+
+	CHECK(weights[0] == 0.0f);
+	CHECK(weights[1] == 0.0f);
+	CHECK(weights[2] == 0.0f);
+}
+
+TEST(CascadesWeightsSumToOne)
+{
+	GICascades cascades;
+	CreateCascades(cascades);
+
+	std::mt19937 generator(5);
+	std::uniform_real_distribution<float> positions(-10.5f, 10.5f);
+
+	std::vector<float> weights;
+
+	for (int i = 0; i < 2000; ++i)
+	{
+		XMFLOAT3 posW = XMFLOAT3(positions(generator), positions(generator), positions(generator));
+
+		cascades.GetCascadeWeights(posW, weights);
+
+		//Each cascade gets its blend weight of whatever the finer ones left
+		float fRemaining = 1.0f;
+		float fSum = 0.0f;
+
+		for (int j = 0; j < cascades.GetNumCascades(); ++j)
+		{
+			CHECK_NEAR(weights[j], GICascades::GetBlendWeight(posW, cascades.GetCascade(j)) * fRemaining, 1e-6f);
+
+			fRemaining -= weights[j];
+			fSum += weights[j];
+		}
+
+		//Anywhere the outermost cascade fully covers adds up to 1, it only falls off through that cascade's own fade
+		float fOuterWeight = GICascades::GetBlendWeight(posW, cascades.GetCascade(2));
+
+		CHECK_NEAR(fSum, fOuterWeight, 1e-5f);
+
+		if (fOuterWeight == 1.0f)
+		{
+			CHECK_NEAR(fSum, 1.0f, 1e-5f);
+		}
+
+		//The selected cascade is the first one with any weight
+		int iSelected = cascades.SelectCascade(posW);
+
+		for (int j = 0; j < (iSelected == -1 ? cascades.GetNumCascades() : iSelected); ++j)
+		{
+			CHECK(weights[j] == 0.0f);
+		}
+
+		if (iSelected != -1)
+		{
+			CHECK(weights[iSelected] > 0.0f);
+		}
+	}
+}
+
+TEST(CascadesShouldUpdateRespectsIntervals)
+{
+	GICascades cascades;
+	CreateCascades(cascades);
+
+	int iNumUpdates[3] = { 0, 0, 0 };
+
+	for (UINT64 uiFrame = 0; uiFrame < 64; ++uiFrame)
+	{
+		for (int i = 0; i < 3; ++i)
+		{
+			if (cascades.ShouldUpdate(i, uiFrame) == true)
+			{
+				++iNumUpdates[i];
+
+				CHECK((uiFrame + i) % cascades.GetCascade(i).UpdateInterval == 0);
+			}
+		}
+
+		//Staggered so cascades 1 and 2 never update on the same frame
+		CHECK((cascades.ShouldUpdate(1, uiFrame) == true && cascades.ShouldUpdate(2, uiFrame) == true) == false);
+	}
+
+	CHECK(iNumUpdates[0] == 64);
+	CHECK(iNumUpdates[1] == 32);
+	CHECK(iNumUpdates[2] == 16);
+
+	cascades.SetUpdateInterval(2, 3);
+
+	CHECK(cascades.ShouldUpdate(2, 1) == true);
+	CHECK(cascades.ShouldUpdate(2, 2) == false);
+	CHECK(cascades.ShouldUpdate(2, 3) == false);
+	CHECK(cascades.ShouldUpdate(2, 4) == true);
+
+	//Intervals below 1 would never update, or divide by zero
+	cascades.SetUpdateInterval(1, 0);
+
+	CHECK(cascades.GetCascade(1).UpdateInterval == 1);
+	CHECK(cascades.ShouldUpdate(1, 7) == true);
+}
+
+TEST(CascadesScrollMatchesVolumeOffsets)
+{
+	GICascades cascades;
+	CreateCascades(cascades);
+
+	GICascades copiedCascades;
+	CreateCascades(copiedCascades);
+
+	//Each cascade's GIVolume keeps its own position and offsets and scrolls them with the static Scroll
+	XMFLOAT3 volumePositions[3];
+	XMINT3 volumeOffsets[3];
+
+	for (int i = 0; i < 3; ++i)
+	{
+		volumePositions[i] = cascades.GetCascade(i).Position;
+		volumeOffsets[i] = cascades.GetCascade(i).ProbeOffsets;
+	}
+
+	//The camera moves less than a probe spacing each frame and the cascades only scroll on frames they update, like in App
+	XMFLOAT3 anchor = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	int iNumWraps[3] = { 0, 0, 0 };
+
+	for (UINT64 uiFrame = 1; uiFrame <= 120; ++uiFrame)
+	{
+		anchor = XMFLOAT3(anchor.x + 0.3f, anchor.y - 0.13f, anchor.z + (uiFrame < 60 ? 0.21f : -0.27f));
+
+		for (int j = 0; j < 3; ++j)
+		{
+			if (cascades.ShouldUpdate(j, uiFrame) == false)
+			{
+				continue;
+			}
+
+			XMFLOAT3 previousPosition = volumePositions[j];
+
+			XMINT3 scrolledPlanes = cascades.Scroll(j, anchor);
+			XMINT3 volumeScrolledPlanes = GICascades::Scroll(volumePositions[j], volumeOffsets[j], cascades.GetCascade(j).ProbeCounts, cascades.GetCascade(j).ProbeSpacing, anchor);
+
+			copiedCascades.SetCascadeTransform(j, volumePositions[j], volumeOffsets[j]);
+
+			CHECK(scrolledPlanes.x == volumeScrolledPlanes.x && scrolledPlanes.y == volumeScrolledPlanes.y && scrolledPlanes.z == volumeScrolledPlanes.z);
+
+			if (previousPosition.x != volumePositions[j].x || previousPosition.y != volumePositions[j].y || previousPosition.z != volumePositions[j].z)
+			{
+				++iNumWraps[j];
+			}
+
+			const GICascade& kCascade = cascades.GetCascade(j);
+			const GICascade& kCopiedCascade = copiedCascades.GetCascade(j);
+
+			CHECK(kCascade.ProbeOffsets.x == kCopiedCascade.ProbeOffsets.x && kCascade.ProbeOffsets.y == kCopiedCascade.ProbeOffsets.y && kCascade.ProbeOffsets.z == kCopiedCascade.ProbeOffsets.z);
+			CHECK(kCascade.Position.x == kCopiedCascade.Position.x && kCascade.Position.y == kCopiedCascade.Position.y && kCascade.Position.z == kCopiedCascade.Position.z);
+
+			//The anchor is always within a probe spacing of the volume's centre
+			XMFLOAT3 centre = XMFLOAT3(kCascade.Position.x + kCascade.ProbeOffsets.x * kCascade.ProbeSpacing.x, kCascade.Position.y + kCascade.ProbeOffsets.y * kCascade.ProbeSpacing.y, kCascade.Position.z + kCascade.ProbeOffsets.z * kCascade.ProbeSpacing.z);
+
+			CHECK(fabsf(anchor.x - centre.x) < kCascade.ProbeSpacing.x);
+			CHECK(fabsf(anchor.y - centre.y) < kCascade.ProbeSpacing.y);
+			CHECK(fabsf(anchor.z - centre.z) < kCascade.ProbeSpacing.z);
+
+			//The blend weight covers exactly the probes the volume places with the same offsets
+			for (int k = 0; k < kCascade.ProbeCounts.x * kCascade.ProbeCounts.y * kCascade.ProbeCounts.z; ++k)
+			{
+				XMINT3 probeCoords = ProbeHelper::GetUnoffsettedProbeCoords(k, kCascade.ProbeCounts, kCascade.ProbeOffsets);
+				XMFLOAT3 probeCoordsW = ProbeHelper::GetProbeCoordsWorld(probeCoords, kCascade.Position, kCascade.ProbeOffsets, kCascade.ProbeSpacing, kCascade.ProbeCounts);
+
+				CHECK_NEAR(GICascades::GetBlendWeight(probeCoordsW, kCascade), 1.0f, 1e-5f);
+			}
+		}
+	}
+
+	//Far enough for every cascade's offsets to wrap round and move the position on
+	CHECK(iNumWraps[0] > 0 && iNumWraps[1] > 0 && iNumWraps[2] > 0);
+
+	//The same anchor twice doesn't scroll again
+	XMINT3 scrolledPlanes = cascades.Scroll(0, anchor);
+
+	CHECK(scrolledPlanes.x == 0 && scrolledPlanes.y == 0 && scrolledPlanes.z == 0);
+}
@@ -0,0 +1,208 @@
+#include "TestHelper.h"
+#include "Helpers/HDRPackingHelper.h"
+#include "Helpers/ProbeHelper.h"
+#include "Shaders/Defines.hlsli"
+
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	//Radiance spread evenly over powers of two so every exponent in [2^-10, 2^10] is hit
+	std::vector<XMFLOAT3> CreateRadiance(int iCount, int iSeed)
+	{
+		std::mt19937 generator(iSeed);
+		std::uniform_real_distribution<float> exponents(-10.0f, 10.0f);
+
+		std::vector<XMFLOAT3> values(iCount);
+
+		for (int i = 0; i < iCount; ++i)
+		{
+			float fRed = exp2f(exponents(generator));
+			float fGreen = exp2f(exponents(generator));
+			float fBlue = exp2f(exponents(generator));
+
+			values[i] = XMFLOAT3(fRed, fGreen, fBlue);
+		}
+
+		return values;
+	}
+
+	//Values the formats can't hold, which the batch versions have to clamp and flush the same way as the scalar ones
+	std::vector<XMFLOAT3> CreateEdgeCases()
+	{
+		return std::vector<XMFLOAT3>({
+			XMFLOAT3(0.0f, 0.0f, 0.0f),
+			XMFLOAT3(-1.0f, -0.0f, -1e10f),
+			XMFLOAT3(1e10f, 1e5f, 70000.0f),
+			XMFLOAT3(RGB9E5_MAX, R11G11B10_R_MAX, R11G11B10_B_MAX),
+			XMFLOAT3(1e-8f, R11G11B10_MIN, R11G11B10_MIN * 0.99f),
+			XMFLOAT3(511.5f, 0.99999f, 1.0f),
+			XMFLOAT3(2.0f, 1e-6f, 1e-3f),
+			XMFLOAT3(65535.0f, 0.5f, 0.25f),
+			XMFLOAT3(1.0f, 1.0f, 1.0f) });
+	}
+
+	bool IsBitwiseEqual(const XMFLOAT3& kLHS, const XMFLOAT3& kRHS)
+	{
+		return memcmp(&kLHS, &kRHS, sizeof(XMFLOAT3)) == 0;
+	}
+}
+
+TEST(RGB9E5RoundTripIsWithinHalfAStep)
+{
+	std::vector<XMFLOAT3> values = CreateRadiance(10000, 1);
+
+	for (int i = 0; i < (int)values.size(); ++i)
+	{
+		XMFLOAT3 decoded = ProbeHelper::RGB9E5ToFloat3(ProbeHelper::Float3ToRGB9E5(values[i]));
+
+		//The largest channel sets the shared exponent, which leaves 9 bits of mantissa for it
+		float fMaxChannel = fmaxf(values[i].x, fmaxf(values[i].y, values[i].z));
+		float fTolerance = fMaxChannel * exp2f(-9.0f);
+
+		CHECK_NEAR(decoded.x, values[i].x, fTolerance);
+		CHECK_NEAR(decoded.y, values[i].y, fTolerance);
+		CHECK_NEAR(decoded.z, values[i].z, fTolerance);
+	}
+
+	XMFLOAT3 decoded = ProbeHelper::RGB9E5ToFloat3(ProbeHelper::Float3ToRGB9E5(XMFLOAT3(-1.0f, 1e10f, 0.0f)));
+
+	CHECK(decoded.x == 0.0f);
+	CHECK(decoded.y == RGB9E5_MAX);
+	CHECK(decoded.z == 0.0f);
+}
+
+TEST(R11G11B10RoundTripIsWithinHalfAStep)
+{
+	std::vector<XMFLOAT3> values = CreateRadiance(10000, 2);
+
+	for (int i = 0; i < (int)values.size(); ++i)
+	{
+		XMFLOAT3 decoded = ProbeHelper::R11G11B10ToFloat3(ProbeHelper::Float3ToR11G11B10(values[i]));
+
+		//Each channel has its own exponent, with 6 bits of mantissa for red and green and 5 for blue
+		CHECK_NEAR(decoded.x, values[i].x, values[i].x * exp2f(-7.0f));
+		CHECK_NEAR(decoded.y, values[i].y, values[i].y * exp2f(-7.0f));
+		CHECK_NEAR(decoded.z, values[i].z, values[i].z * exp2f(-6.0f));
+	}
+
+	XMFLOAT3 decoded = ProbeHelper::R11G11B10ToFloat3(ProbeHelper::Float3ToR11G11B10(XMFLOAT3(-1.0f, 1e10f, R11G11B10_MIN * 0.5f)));
+
+	CHECK(decoded.x == 0.0f);
+	CHECK(decoded.y == R11G11B10_R_MAX);
+	CHECK(decoded.z == 0.0f);
+}
+
+TEST(HDRBatchPackingMatchesScalar)
+{
+	std::vector<XMFLOAT3> values = CreateRadiance(64, 3);
+	std::vector<XMFLOAT3> edgeCases = CreateEdgeCases();
+	values.insert(values.begin(), edgeCases.begin(), edgeCases.end());
+
+	//Every count up to a few batches so the scalar tail is covered for each remainder
+	for (int iCount = 0; iCount <= 13; ++iCount)
+	{
+		std::vector<uint32_t> rgb9e5(iCount + 1, 0xDEADBEEF);
+		std::vector<uint32_t> r11g11b10(iCount + 1, 0xDEADBEEF);
+
+		HDRPackingHelper::PackRGB9E5(values.data(), rgb9e5.data(), iCount);
+		HDRPackingHelper::PackR11G11B10(values.data(), r11g11b10.data(), iCount);
+
+		for (int i = 0; i < iCount; ++i)
+		{
+			CHECK(rgb9e5[i] == ProbeHelper::Float3ToRGB9E5(values[i]));
+			CHECK(r11g11b10[i] == ProbeHelper::Float3ToR11G11B10(values[i]));
+		}
+
+		//Nothing past the end is touched
+		CHECK(rgb9e5[iCount] == 0xDEADBEEF);
+		CHECK(r11g11b10[iCount] == 0xDEADBEEF);
+	}
+
+	std::vector<uint32_t> rgb9e5(values.size());
+	std::vector<uint32_t> r11g11b10(values.size());
+
+	HDRPackingHelper::PackRGB9E5(values.data(), rgb9e5.data(), (int)values.size());
+	HDRPackingHelper::PackR11G11B10(values.data(), r11g11b10.data(), (int)values.size());
+
+	for (int i = 0; i < (int)values.size(); ++i)
+	{
+		CHECK(rgb9e5[i] == ProbeHelper::Float3ToRGB9E5(values[i]));
+		CHECK(r11g11b10[i] == ProbeHelper::Float3ToR11G11B10(values[i]));
+	}
+}
+
+TEST(HDRBatchUnpackingMatchesScalar)
+{
+	std::mt19937 generator(4);
+
+	//Any bit pattern is a valid encoding
+	std::vector<uint32_t> packed(77);
+
+	for (int i = 0; i < (int)packed.size(); ++i)
+	{
+		packed[i] = generator();
+	}
+
+	packed[0] = 0;
+	packed[1] = 0xFFFFFFFF;
+
+	for (int iCount = 0; iCount <= (int)packed.size(); iCount += iCount < 13 ? 1 : 64)
+	{
+		std::vector<XMFLOAT3> rgb9e5(iCount + 1, XMFLOAT3(-2.0f, -2.0f, -2.0f));
+		std::vector<XMFLOAT3> r11g11b10(iCount + 1, XMFLOAT3(-2.0f, -2.0f, -2.0f));
+
+		HDRPackingHelper::UnpackRGB9E5(packed.data(), rgb9e5.data(), iCount);
+		HDRPackingHelper::UnpackR11G11B10(packed.data(), r11g11b10.data(), iCount);
+
+		for (int i = 0; i < iCount; ++i)
+		{
+			CHECK(IsBitwiseEqual(rgb9e5[i], ProbeHelper::RGB9E5ToFloat3(packed[i])) == true);
+			CHECK(IsBitwiseEqual(r11g11b10[i], ProbeHelper::R11G11B10ToFloat3(packed[i])) == true);
+		}
+
+		CHECK(rgb9e5[iCount].x == -2.0f);
+		CHECK(r11g11b10[iCount].x == -2.0f);
+	}
+}
+
+TEST(RayRadiancePackingRoundTrips)
+{
+	std::vector<XMFLOAT3> values = CreateRadiance(1000, 5);
+	std::vector<XMFLOAT3> edgeCases = CreateEdgeCases();
+	values.insert(values.end(), edgeCases.begin(), edgeCases.end());
+
+	for (int i = 0; i < (int)values.size(); ++i)
+	{
+		XMFLOAT3 rgb9e5 = ProbeHelper::UnpackRayRadiance(ProbeHelper::PackRayRadiance(values[i], FORMAT_PROBE_RAY_DATA_RGB9E5), FORMAT_PROBE_RAY_DATA_RGB9E5);
+
+		CHECK(IsBitwiseEqual(rgb9e5, ProbeHelper::RGB9E5ToFloat3(ProbeHelper::Float3ToRGB9E5(values[i]))) == true);
+
+		//Blue is raised to the smallest normal value before packing
+		XMFLOAT3 raised = XMFLOAT3(values[i].x, values[i].y, fmaxf(values[i].z, R11G11B10_MIN));
+		float fPacked = ProbeHelper::PackRayRadiance(values[i], FORMAT_PROBE_RAY_DATA_R11G11B10);
+		XMFLOAT3 r11g11b10 = ProbeHelper::UnpackRayRadiance(fPacked, FORMAT_PROBE_RAY_DATA_R11G11B10);
+
+		CHECK(IsBitwiseEqual(r11g11b10, ProbeHelper::R11G11B10ToFloat3(ProbeHelper::Float3ToR11G11B10(raised))) == true);
+	}
+}
+
+TEST(HDRRoundTripStatsMatchFormatPrecision)
+{
+	std::vector<XMFLOAT3> values = CreateRadiance(4096, 6);
+
+	HDRPackingStats rgb9e5 = HDRPackingHelper::MeasureRoundTrip(FORMAT_PROBE_RAY_DATA_RGB9E5, values);
+	HDRPackingStats r11g11b10 = HDRPackingHelper::MeasureRoundTrip(FORMAT_PROBE_RAY_DATA_R11G11B10, values);
+
+	CHECK(rgb9e5.NumValues == 4096);
+	CHECK(rgb9e5.MaxRelativeError > 0.0);
+	CHECK(rgb9e5.MaxRelativeError <= exp2(-9.0));
+	CHECK(rgb9e5.MeanRelativeError <= rgb9e5.MaxRelativeError);
+
+	CHECK(r11g11b10.NumValues == 4096);
+	CHECK(r11g11b10.MaxRelativeError > 0.0);
+	CHECK(r11g11b10.MaxRelativeError <= exp2(-6.0));
+	CHECK(r11g11b10.MeanRelativeError <= r11g11b10.MaxRelativeError);
+}
@@ -0,0 +1,212 @@
+#include "TestHelper.h"
+#include "Commons/ThreadPool.h"
+#include "GI/CPUIrradianceQuery.h"
+#include "GI/CPUProbeBlender.h"
+#include "GI/CPUProbeRelocator.h"
+#include "Helpers/ProbeHelper.h"
+#include "Shaders/Defines.hlsli"
+
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	const XMFLOAT3 s_kEyePosition = XMFLOAT3(-4.0f, 3.0f, -6.0f);
+
+	//Atlases full of noise so every probe, texel and bilinear tap gives a different answer
+	void CreateRandomAtlases(const RaytracePerFrameCB& kParams, CPUAtlas& irradianceAtlas, CPUAtlas& distanceAtlas)
+	{
+		CPUAtlas rayData;
+		CPUProbeBlender::CreateAtlases(kParams, rayData, irradianceAtlas, distanceAtlas);
+
+		std::mt19937 generator(17);
+		std::uniform_real_distribution<float> irradiances(0.0f, 1.0f);
+		std::uniform_real_distribution<float> distances(0.1f, 1.0f);
+		std::uniform_real_distribution<float> variances(0.0f, 0.2f);
+
+		for (int i = 0; i < (int)irradianceAtlas.Texels.size(); ++i)
+		{
+			float fRed = irradiances(generator);
+			float fGreen = irradiances(generator);
+			float fBlue = irradiances(generator);
+
+			irradianceAtlas.Texels[i] = XMFLOAT4(fRed, fGreen, fBlue, 1.0f);
+		}
+
+		for (int i = 0; i < (int)distanceAtlas.Texels.size(); ++i)
+		{
+			float fDistance = distances(generator);
+
+			distanceAtlas.Texels[i] = XMFLOAT4(fDistance, fDistance * fDistance + variances(generator), 0.0f, 0.0f);
+		}
+	}
+
+	void CreateRandomQueries(const RaytracePerFrameCB& kParams, int iNumQueries, std::vector<IrradianceQuery>& queries)
+	{
+		std::mt19937 generator(23);
+		std::uniform_real_distribution<float> positionsX(kParams.ProbeCounts.x * -0.5f, kParams.ProbeCounts.x * 0.5f);
+		std::uniform_real_distribution<float> positionsY(kParams.ProbeCounts.y * -0.5f, kParams.ProbeCounts.y * 0.5f);
+		std::uniform_real_distribution<float> positionsZ(kParams.ProbeCounts.z * -0.5f, kParams.ProbeCounts.z * 0.5f);
+		std::uniform_real_distribution<float> normals(-1.0f, 1.0f);
+
+		queries.resize(iNumQueries);
+
+		for (int i = 0; i < iNumQueries; ++i)
+		{
+			float fX = positionsX(generator);
+			float fY = positionsY(generator);
+			float fZ = positionsZ(generator);
+
+			queries[i].PosW = XMFLOAT3(fX, fY, fZ);
+
+			float fNormalX = normals(generator);
+			float fNormalY = normals(generator);
+			float fNormalZ = normals(generator);
+
+			queries[i].NormalW = ProbeHelper::Normalize(XMFLOAT3(fNormalX, fNormalY, fNormalZ + 0.01f));
+		}
+	}
+
+	XMFLOAT4 GetReference(const IrradianceQuery& kQuery, const RaytracePerFrameCB& kParams, const CPUAtlas& kIrradianceAtlas, const CPUAtlas& kDistanceAtlas, const CPUAtlas* kpProbeData)
+	{
+		XMFLOAT3 cameraDirection = ProbeHelper::Normalize(XMFLOAT3(kQuery.PosW.x - s_kEyePosition.x, kQuery.PosW.y - s_kEyePosition.y, kQuery.PosW.z - s_kEyePosition.z));
+		XMFLOAT3 surfaceBias = CPUIrradianceQuery::GetSurfaceBias(kQuery.NormalW, cameraDirection, kParams.NormalBias, kParams.ViewBias);
+
+		return CPUIrradianceQuery::GetIrradiance(kQuery.PosW, surfaceBias, kQuery.NormalW, kParams, kIrradianceAtlas, kDistanceAtlas, kpProbeData);
+	}
+
+	//Checks every batched result against the one query at a time reference and returns how many were left unlit
+	int CheckAgainstReference(const RaytracePerFrameCB& kParams, const CPUAtlas& kIrradianceAtlas, const CPUAtlas& kDistanceAtlas, const CPUAtlas* kpProbeData, const std::vector<IrradianceQuery>& kQueries, const std::vector<XMFLOAT4>& kResults)
+	{
+		int iNumUnlit = 0;
+
+		for (int i = 0; i < (int)kQueries.size(); ++i)
+		{
+			XMFLOAT4 expected = GetReference(kQueries[i], kParams, kIrradianceAtlas, kDistanceAtlas, kpProbeData);
+
+			CHECK_NEAR(kResults[i].x, expected.x, 1e-4f + fabsf(expected.x) * 1e-4f);
+			CHECK_NEAR(kResults[i].y, expected.y, 1e-4f + fabsf(expected.y) * 1e-4f);
+			CHECK_NEAR(kResults[i].z, expected.z, 1e-4f + fabsf(expected.z) * 1e-4f);
+			CHECK_NEAR(kResults[i].w, expected.w, 1e-4f + fabsf(expected.w) * 1e-4f);
+
+			if (expected.w == -1.0f)
+			{
+				++iNumUnlit;
+			}
+		}
+
+		return iNumUnlit;
+	}
+}
+
+TEST(IrradianceQueryMatchesReference)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(5, 4, 3), 64);
+
+	CPUAtlas irradianceAtlas;
+	CPUAtlas distanceAtlas;
+	CreateRandomAtlases(params, irradianceAtlas, distanceAtlas);
+
+	std::vector<IrradianceQuery> queries;
+	CreateRandomQueries(params, 500, queries);
+
+	std::vector<XMFLOAT4> results;
+
+	CPUIrradianceQuery query;
+	query.QueryIrradiance(params, irradianceAtlas, distanceAtlas, nullptr, s_kEyePosition, queries, results);
+
+	CHECK(results.size() == queries.size());
+	CHECK(CheckAgainstReference(params, irradianceAtlas, distanceAtlas, nullptr, queries, results) == 0);
+}
+
+TEST(IrradianceQuerySkipsInactiveProbes)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(5, 4, 3), 64);
+	params.ProbeClassification = 1;
+	params.ProbeRelocation = 1;
+
+	CPUAtlas irradianceAtlas;
+	CPUAtlas distanceAtlas;
+	CreateRandomAtlases(params, irradianceAtlas, distanceAtlas);
+
+	CPUAtlas probeData;
+	CPUProbeRelocator::CreateAtlas(params, probeData);
+
+	std::mt19937 generator(29);
+	std::uniform_real_distribution<float> offsets(-0.3f, 0.3f);
+	std::uniform_real_distribution<float> chances(0.0f, 1.0f);
+
+	//A third of the probes are off and the rest have been moved around
+	for (int i = 0; i < TestHelper::GetNumProbes(params); ++i)
+	{
+		XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(i, params.ProbeCounts, params.AtlasLayout);
+
+		float fX = offsets(generator);
+		float fY = offsets(generator);
+		float fZ = offsets(generator);
+
+		probeData.GetTexel(dataCoords.x, dataCoords.y) = XMFLOAT4(fX, fY, fZ, chances(generator) < 0.33f ? PROBE_STATE_INACTIVE : PROBE_STATE_ACTIVE);
+	}
+
+	//Every probe around the first query is off
+	XMINT3 coords = ProbeHelper::GetProbeCoords(0, params.ProbeCounts);
+
+	for (int i = 0; i < 8; ++i)
+	{
+		XMINT3 probeCoords = XMINT3(coords.x + (i & 1), coords.y + ((i >> 1) & 1), coords.z + ((i >> 2) & 1));
+		XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(ProbeHelper::GetProbeIndex(probeCoords, params.ProbeCounts), params.ProbeCounts, params.AtlasLayout);
+
+		probeData.GetTexel(dataCoords.x, dataCoords.y).w = PROBE_STATE_INACTIVE;
+	}
+
+	std::vector<IrradianceQuery> queries;
+	CreateRandomQueries(params, 500, queries);
+
+	XMFLOAT3 firstProbePosition = ProbeHelper::GetProbeCoordsWorld(coords, params.VolumePosition, params.ProbeOffsets, params.ProbeSpacing, params.ProbeCounts);
+	queries[0].PosW = XMFLOAT3(firstProbePosition.x + 0.5f, firstProbePosition.y + 0.5f, firstProbePosition.z + 0.5f);
+
+	std::vector<XMFLOAT4> results;
+
+	CPUIrradianceQuery query;
+	query.QueryIrradiance(params, irradianceAtlas, distanceAtlas, &probeData, s_kEyePosition, queries, results);
+
+	CHECK(CheckAgainstReference(params, irradianceAtlas, distanceAtlas, &probeData, queries, results) > 0);
+
+	CHECK(results[0].x == 0.0f && results[0].y == 0.0f && results[0].z == 0.0f);
+	CHECK(results[0].w == -1.0f);
+}
+
+TEST(IrradianceQueryThreadPoolMatchesSerial)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(6, 4, 5), 64);
+
+	CPUAtlas irradianceAtlas;
+	CPUAtlas distanceAtlas;
+	CreateRandomAtlases(params, irradianceAtlas, distanceAtlas);
+
+	std::vector<IrradianceQuery> queries;
+	CreateRandomQueries(params, 5000, queries);
+
+	std::vector<XMFLOAT4> serialResults;
+	std::vector<XMFLOAT4> pooledResults;
+
+	ThreadPool threadPool(4);
+
+	CPUIrradianceQuery serialQuery;
+	serialQuery.QueryIrradiance(params, irradianceAtlas, distanceAtlas, nullptr, s_kEyePosition, queries, serialResults);
+
+	CPUIrradianceQuery pooledQuery(&threadPool);
+	pooledQuery.QueryIrradiance(params, irradianceAtlas, distanceAtlas, nullptr, s_kEyePosition, queries, pooledResults);
+
+	bool bMatch = true;
+
+	for (int i = 0; i < (int)queries.size(); ++i)
+	{
+		bMatch = bMatch && memcmp(&serialResults[i], &pooledResults[i], sizeof(XMFLOAT4)) == 0;
+	}
+
+	CHECK(bMatch == true);
+	CHECK(serialQuery.GetLastQueryStats().NumQueries == 5000);
+	CHECK(pooledQuery.GetLastQueryStats().NumThreads == 5);
+}
@@ -0,0 +1,250 @@
+#include "TestHelper.h"
+#include "Commons/ThreadPool.h"
+#include "GI/CPUProbeBlender.h"
+
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	//Every ray misses and brings back kRadiance from far enough away to be clamped
+	void CreateMissRayData(const RaytracePerFrameCB& kParams, const XMFLOAT3& kRadiance, CPUAtlas& rayData)
+	{
+		rayData.Resize(kParams.RaysPerProbe, TestHelper::GetNumProbes(kParams));
+
+		for (int i = 0; i < (int)rayData.Texels.size(); ++i)
+		{
+			rayData.Texels[i] = XMFLOAT4(kRadiance.x, kRadiance.y, kRadiance.z, 1e27f);
+		}
+	}
+
+	void CreateRandomRayData(const RaytracePerFrameCB& kParams, unsigned int uiSeed, CPUAtlas& rayData)
+	{
+		std::mt19937 rng(uiSeed);
+		std::uniform_real_distribution<float> radiance(0.0f, 2.0f);
+		std::uniform_real_distribution<float> distance(0.1f, 3.0f);
+
+		rayData.Resize(kParams.RaysPerProbe, TestHelper::GetNumProbes(kParams));
+
+		for (int i = 0; i < (int)rayData.Texels.size(); ++i)
+		{
+			rayData.Texels[i] = XMFLOAT4(radiance(rng), radiance(rng), radiance(rng), distance(rng));
+		}
+	}
+
+	//Calls func(x, y) for every interior texel of every probe, in atlas coordinates
+	void ForEachInteriorTexel(int iNumTexels, const CPUAtlas& kAtlas, const std::function<void(int, int)>& kFunc)
+	{
+		for (int y = 0; y < kAtlas.Height; ++y)
+		{
+			for (int x = 0; x < kAtlas.Width; ++x)
+			{
+				int iModX = x % (iNumTexels + 2);
+				int iModY = y % (iNumTexels + 2);
+
+				if (iModX != 0 && iModX != iNumTexels + 1 && iModY != 0 && iModY != iNumTexels + 1)
+				{
+					kFunc(x, y);
+				}
+			}
+		}
+	}
+
+	float GetEncodedIrradiance(float fRadiance, const RaytracePerFrameCB& kParams)
+	{
+		//The blend halves the cosine weighted radiance and gamma encodes it
+		return powf(fRadiance * 0.5f, 1.0f / kParams.IrradianceGammaEncoding);
+	}
+}
+
+TEST(BlenderConstantRadiance)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(3, 2, 2), 128);
+	params.Hysteresis = 0.0f;
+
+	CPUAtlas rayData;
+	CPUAtlas irradianceAtlas;
+	CPUAtlas distanceAtlas;
+	CPUProbeBlender::CreateAtlases(params, rayData, irradianceAtlas, distanceAtlas);
+
+	CHECK(irradianceAtlas.Width == 3 * 2 * 8);
+	CHECK(irradianceAtlas.Height == 2 * 8);
+	CHECK(distanceAtlas.Width == 3 * 2 * 16);
+	CHECK(distanceAtlas.Height == 2 * 16);
+
+	CreateMissRayData(params, XMFLOAT3(1.0f, 0.5f, 2.0f), rayData);
+
+	CPUProbeBlender blender;
+	blender.BlendProbeAtlases(params, rayData, irradianceAtlas, distanceAtlas);
+
+	//Every direction sees the same radiance so every texel, borders included, ends up the same
+	for (int i = 0; i < (int)irradianceAtlas.Texels.size(); ++i)
+	{
+		CHECK_NEAR(irradianceAtlas.Texels[i].x, GetEncodedIrradiance(1.0f, params), 1e-5f);
+		CHECK_NEAR(irradianceAtlas.Texels[i].y, GetEncodedIrradiance(0.5f, params), 1e-5f);
+		CHECK_NEAR(irradianceAtlas.Texels[i].z, GetEncodedIrradiance(2.0f, params), 1e-5f);
+	}
+
+	//Misses are clamped to one and a half probe diagonals, the mean and mean squared distance are halved like the irradiance
+	float fMaxDistance = sqrtf(3.0f) * 1.5f;
+
+	for (int i = 0; i < (int)distanceAtlas.Texels.size(); ++i)
+	{
+		CHECK_NEAR(distanceAtlas.Texels[i].x, fMaxDistance * 0.5f, 1e-4f);
+		CHECK_NEAR(distanceAtlas.Texels[i].y, fMaxDistance * fMaxDistance * 0.5f, 1e-4f);
+	}
+}
+
+TEST(BlenderHysteresisConverges)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(2, 2, 2), 64);
+	params.Hysteresis = 0.9f;
+
+	CPUAtlas rayData;
+	CPUAtlas irradianceAtlas;
+	CPUAtlas distanceAtlas;
+	CPUProbeBlender::CreateAtlases(params, rayData, irradianceAtlas, distanceAtlas);
+
+	CreateMissRayData(params, XMFLOAT3(1.0f, 1.0f, 1.0f), rayData);
+
+	CPUProbeBlender blender;
+	float fTarget = GetEncodedIrradiance(1.0f, params);
+
+	//Each frame moves a tenth of the way from the previous value to the new one
+	blender.BlendIrradiance(params, rayData, irradianceAtlas);
+	CHECK_NEAR(irradianceAtlas.GetTexel(1, 1).x, fTarget * 0.1f, 1e-5f);
+
+	blender.BlendIrradiance(params, rayData, irradianceAtlas);
+	CHECK_NEAR(irradianceAtlas.GetTexel(1, 1).x, fTarget * 0.19f, 1e-5f);
+
+	for (int i = 0; i < 200; ++i)
+	{
+		blender.BlendIrradiance(params, rayData, irradianceAtlas);
+	}
+
+	ForEachInteriorTexel(params.NumIrradianceTexels, irradianceAtlas, [&](int x, int y)
+	{
+		CHECK_NEAR(irradianceAtlas.GetTexel(x, y).x, fTarget, 1e-4f);
+	});
+}
+
+TEST(BlenderSkipsProbesWithManyBackfaces)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(2, 1, 1), 64);
+	params.Hysteresis = 0.0f;
+
+	CPUAtlas rayData;
+	CPUAtlas irradianceAtlas;
+	CPUAtlas distanceAtlas;
+	CPUProbeBlender::CreateAtlases(params, rayData, irradianceAtlas, distanceAtlas);
+
+	CreateMissRayData(params, XMFLOAT3(1.0f, 1.0f, 1.0f), rayData);
+
+	//A tenth of the second probe's rays hit back faces, which is enough for it to be left alone
+	for (int i = 0; i < 6; ++i)
+	{
+		rayData.GetTexel(i * 10, 1).w = -0.1f;
+	}
+
+	for (int i = 0; i < (int)irradianceAtlas.Texels.size(); ++i)
+	{
+		irradianceAtlas.Texels[i] = XMFLOAT4(0.25f, 0.25f, 0.25f, 1.0f);
+	}
+
+	CPUProbeBlender blender;
+	blender.BlendIrradiance(params, rayData, irradianceAtlas);
+
+	int iTileSize = params.NumIrradianceTexels + 2;
+
+	ForEachInteriorTexel(params.NumIrradianceTexels, irradianceAtlas, [&](int x, int y)
+	{
+		float fExpected = x < iTileSize ? GetEncodedIrradiance(1.0f, params) : 0.25f;
+
+		CHECK_NEAR(irradianceAtlas.GetTexel(x, y).x, fExpected, 1e-5f);
+	});
+}
+
+TEST(BlenderBordersMirrorTheEdges)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(3, 2, 2), 64);
+	params.Hysteresis = 0.0f;
+
+	CPUAtlas rayData;
+	CPUAtlas irradianceAtlas;
+	CPUAtlas distanceAtlas;
+	CPUProbeBlender::CreateAtlases(params, rayData, irradianceAtlas, distanceAtlas);
+
+	CreateRandomRayData(params, 7, rayData);
+
+	CPUProbeBlender blender;
+	blender.BlendProbeAtlases(params, rayData, irradianceAtlas, distanceAtlas);
+
+	const int kiNumTexels[2] = { params.NumIrradianceTexels, params.NumDistanceTexels };
+	const CPUAtlas* kpAtlases[2] = { &irradianceAtlas, &distanceAtlas };
+
+	for (int i = 0; i < 2; ++i)
+	{
+		int n = kiNumTexels[i];
+		const CPUAtlas& kAtlas = *kpAtlases[i];
+
+		for (int iTileY = 0; iTileY < kAtlas.Height / (n + 2); ++iTileY)
+		{
+			for (int iTileX = 0; iTileX < kAtlas.Width / (n + 2); ++iTileX)
+			{
+				int iOriginX = iTileX * (n + 2);
+				int iOriginY = iTileY * (n + 2);
+
+				auto isTexel = [&](int iX, int iY, int iFromX, int iFromY)
+				{
+					return memcmp(&kAtlas.GetTexel(iOriginX + iX, iOriginY + iY), &kAtlas.GetTexel(iOriginX + iFromX, iOriginY + iFromY), sizeof(XMFLOAT4)) == 0;
+				};
+
+				//Edges are the neighbouring interior row or column flipped, so bilinear filtering wraps around the octahedron
+				for (int j = 1; j <= n; ++j)
+				{
+					CHECK(isTexel(j, 0, n + 1 - j, 1) == true);
+					CHECK(isTexel(j, n + 1, n + 1 - j, n) == true);
+					CHECK(isTexel(0, j, 1, n + 1 - j) == true);
+					CHECK(isTexel(n + 1, j, n, n + 1 - j) == true);
+				}
+
+				//Corners come from the opposite interior corner
+				CHECK(isTexel(0, 0, n, n) == true);
+				CHECK(isTexel(n + 1, 0, 1, n) == true);
+				CHECK(isTexel(0, n + 1, n, 1) == true);
+				CHECK(isTexel(n + 1, n + 1, 1, 1) == true);
+			}
+		}
+	}
+}
+
+TEST(BlenderThreadPoolMatchesSerial)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(6, 4, 5), 96);
+
+	CPUAtlas rayData;
+	CPUAtlas serialIrradiance;
+	CPUAtlas serialDistance;
+	CPUProbeBlender::CreateAtlases(params, rayData, serialIrradiance, serialDistance);
+
+	CPUAtlas parallelIrradiance = serialIrradiance;
+	CPUAtlas parallelDistance = serialDistance;
+
+	ThreadPool threadPool(4);
+
+	CPUProbeBlender serialBlender;
+	CPUProbeBlender parallelBlender(&threadPool);
+
+	//A few frames so the hysteresis and threshold paths see a previous value
+	for (int i = 0; i < 3; ++i)
+	{
+		CreateRandomRayData(params, 100 + i, rayData);
+
+		serialBlender.BlendProbeAtlases(params, rayData, serialIrradiance, serialDistance);
+		parallelBlender.BlendProbeAtlases(params, rayData, parallelIrradiance, parallelDistance);
+	}
+
+	CHECK(memcmp(serialIrradiance.Texels.data(), parallelIrradiance.Texels.data(), serialIrradiance.Texels.size() * sizeof(XMFLOAT4)) == 0);
+	CHECK(memcmp(serialDistance.Texels.data(), parallelDistance.Texels.data(), serialDistance.Texels.size() * sizeof(XMFLOAT4)) == 0);
+}
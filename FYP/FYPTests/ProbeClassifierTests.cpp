@@ -0,0 +1,254 @@
+#include "TestHelper.h"
+#include "Commons/ThreadPool.h"
+#include "GI/CPUProbeClassifier.h"
+#include "Helpers/ProbeHelper.h"
+#include "Shaders/Defines.hlsli"
+
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	//Every ray of every probe hits a front face further away than the classifier looks for surfaces
+	void CreateFarRayData(const RaytracePerFrameCB& kParams, CPUAtlas& rayData)
+	{
+		rayData.Resize(kParams.RaysPerProbe, TestHelper::GetNumProbes(kParams));
+
+		for (int i = 0; i < (int)rayData.Texels.size(); ++i)
+		{
+			rayData.Texels[i] = XMFLOAT4(0.5f, 0.5f, 0.5f, 5.0f);
+		}
+	}
+
+	float GetState(int iProbeIndex, const RaytracePerFrameCB& kParams, const CPUAtlas& kProbeData)
+	{
+		XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(iProbeIndex, kParams.ProbeCounts, kParams.AtlasLayout);
+
+		return kProbeData.GetTexel(dataCoords.x, dataCoords.y).w;
+	}
+}
+
+TEST(ClassifierNeedsANearbySurface)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(2, 2, 2), 64);
+	params.ProbeClassification = 1;
+
+	CPUAtlas rayData;
+	CreateFarRayData(params, rayData);
+
+	CHECK(CPUProbeClassifier::ClassifyProbe(0, params, rayData) == PROBE_STATE_INACTIVE);
+
+	//Within the length of the spacing vector, which is sqrt(3) here
+	rayData.GetTexel(20, 0).w = 1.7f;
+
+	CHECK(CPUProbeClassifier::ClassifyProbe(0, params, rayData) == PROBE_STATE_ACTIVE);
+
+	rayData.GetTexel(20, 0).w = 1.8f;
+
+	CHECK(CPUProbeClassifier::ClassifyProbe(0, params, rayData) == PROBE_STATE_INACTIVE);
+}
+
+TEST(ClassifierTurnsOffProbesInsideGeometry)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(2, 2, 2), 64);
+	params.ProbeClassification = 1;
+
+	CPUAtlas rayData;
+	CreateFarRayData(params, rayData);
+	rayData.GetTexel(0, 0).w = 0.5f;
+
+	//16 of 64 is exactly the threshold so the probe stays on
+	for (int i = 1; i <= 16; ++i)
+	{
+		rayData.GetTexel(i, 0).w = -0.1f;
+	}
+
+	CHECK(CPUProbeClassifier::ClassifyProbe(0, params, rayData) == PROBE_STATE_ACTIVE);
+
+	rayData.GetTexel(17, 0).w = -0.1f;
+
+	CHECK(CPUProbeClassifier::ClassifyProbe(0, params, rayData) == PROBE_STATE_INACTIVE);
+}
+
+TEST(ClassifierUsesPerProbeRayCounts)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(2, 2, 2), 64);
+	params.ProbeClassification = 1;
+	params.AdaptiveRays = 1;
+
+	std::vector<uint32_t> rayCounts(TestHelper::GetNumProbes(params), 64);
+	rayCounts[0] = 32;
+	rayCounts[1] = 32;
+
+	CPUAtlas rayData;
+	CreateFarRayData(params, rayData);
+
+	//Probe 0 traced 32 rays near a surface, the back faces past them are left over from a frame with more
+	rayData.GetTexel(3, 0).w = 0.5f;
+
+	for (int i = 32; i < 64; ++i)
+	{
+		rayData.GetTexel(i, 0).w = -0.1f;
+	}
+
+	//Probe 1's only nearby surface is past its rays
+	rayData.GetTexel(40, 1).w = 0.5f;
+
+	CHECK(CPUProbeClassifier::ClassifyProbe(0, params, rayData, rayCounts.data()) == PROBE_STATE_ACTIVE);
+	CHECK(CPUProbeClassifier::ClassifyProbe(1, params, rayData, rayCounts.data()) == PROBE_STATE_INACTIVE);
+
+	//Without the counts every ray in the row is looked at
+	CHECK(CPUProbeClassifier::ClassifyProbe(0, params, rayData) == PROBE_STATE_INACTIVE);
+	CHECK(CPUProbeClassifier::ClassifyProbe(1, params, rayData) == PROBE_STATE_ACTIVE);
+
+	//And they are ignored without adaptive rays
+	params.AdaptiveRays = 0;
+
+	CHECK(CPUProbeClassifier::ClassifyProbe(0, params, rayData, rayCounts.data()) == PROBE_STATE_INACTIVE);
+}
+
+
+TEST(ClassifierListsActiveProbesInOrder)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(3, 2, 2), 64);
+	params.ProbeClassification = 1;
+	params.UseActiveProbeList = 1;
+
+	CPUAtlas rayData;
+	CreateFarRayData(params, rayData);
+
+	const int kiActiveProbes[4] = { 1, 4, 7, 10 };
+
+	for (int i = 0; i < 4; ++i)
+	{
+		rayData.GetTexel(0, kiActiveProbes[i]).w = 0.5f;
+	}
+
+	CPUAtlas probeData;
+	probeData.Resize(params.ProbeCounts.x * params.ProbeCounts.y, params.ProbeCounts.z);
+
+	std::vector<int> activeProbes;
+
+	CPUProbeClassifier classifier;
+	classifier.ClassifyProbes(params, rayData, probeData, activeProbes);
+
+	CHECK(activeProbes == std::vector<int>({ 1, 4, 7, 10 }));
+
+	for (int i = 0; i < TestHelper::GetNumProbes(params); ++i)
+	{
+		bool bActive = i == 1 || i == 4 || i == 7 || i == 10;
+
+		CHECK(GetState(i, params, probeData) == (bActive == true ? PROBE_STATE_ACTIVE : PROBE_STATE_INACTIVE));
+	}
+
+	//Inactive probes weren't traced so keep their state until the next full update, even with a surface in reach
+	params.FullProbeUpdate = 0;
+	rayData.GetTexel(0, 2).w = 0.5f;
+
+	classifier.ClassifyProbes(params, rayData, probeData, activeProbes);
+
+	CHECK(activeProbes == std::vector<int>({ 1, 4, 7, 10 }));
+
+	params.FullProbeUpdate = 1;
+
+	classifier.ClassifyProbes(params, rayData, probeData, activeProbes);
+
+	CHECK(activeProbes == std::vector<int>({ 1, 2, 4, 7, 10 }));
+}
+
+TEST(ClassifierKeepsUntracedProbes)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(3, 2, 2), 64);
+	params.ProbeClassification = 1;
+	params.UseActiveProbeList = 1;
+	params.FullProbeUpdate = 0;
+	params.TracedProbeMask = 1;
+
+	//No surface in reach of any probe so everything traced turns off
+	CPUAtlas rayData;
+	CreateFarRayData(params, rayData);
+
+	CPUAtlas probeData;
+	probeData.Resize(params.ProbeCounts.x * params.ProbeCounts.y, params.ProbeCounts.z);
+
+	for (int i = 0; i < (int)probeData.Texels.size(); ++i)
+	{
+		probeData.Texels[i].w = PROBE_STATE_ACTIVE;
+	}
+
+	//Probes 3 and 5 were scheduled, the rest are active but waiting their turn
+	std::vector<uint32_t> tracedProbeMask(ProbeHelper::GetTracedProbeMaskSize(TestHelper::GetNumProbes(params)), 0);
+	tracedProbeMask[0] = (1u << 3) | (1u << 5);
+
+	std::vector<int> activeProbes;
+
+	CPUProbeClassifier classifier;
+	classifier.ClassifyProbes(params, rayData, probeData, activeProbes, nullptr, tracedProbeMask.data());
+
+	CHECK(activeProbes == std::vector<int>({ 0, 1, 2, 4, 6, 7, 8, 9, 10, 11 }));
+	CHECK(GetState(3, params, probeData) == PROBE_STATE_INACTIVE);
+	CHECK(GetState(5, params, probeData) == PROBE_STATE_INACTIVE);
+}
+
+TEST(ClassifierThreadPoolMatchesSerial)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(8, 6, 5), 64);
+	params.ProbeClassification = 1;
+	params.AdaptiveRays = 1;
+
+	std::mt19937 generator(11);
+	std::uniform_real_distribution<float> backfaceFractions(0.0f, 0.4f);
+	std::uniform_real_distribution<float> closestDistances(0.5f, 4.0f);
+	std::uniform_real_distribution<float> chances(0.0f, 1.0f);
+	std::uniform_int_distribution<int> counts(1, 2);
+
+	CPUAtlas rayData;
+	rayData.Resize(params.RaysPerProbe, TestHelper::GetNumProbes(params));
+
+	//Some probes are inside geometry, some near it and some in the open
+	for (int i = 0; i < rayData.Height; ++i)
+	{
+		float fBackfaceFraction = backfaceFractions(generator);
+		float fClosestDistance = closestDistances(generator);
+
+		for (int j = 0; j < rayData.Width; ++j)
+		{
+			float fDistance = chances(generator) < fBackfaceFraction ? -0.1f : fClosestDistance + chances(generator) * 4.0f;
+
+			rayData.GetTexel(j, i) = XMFLOAT4(0.0f, 0.0f, 0.0f, fDistance);
+		}
+	}
+
+	std::vector<uint32_t> rayCounts(TestHelper::GetNumProbes(params));
+
+	for (int i = 0; i < (int)rayCounts.size(); ++i)
+	{
+		rayCounts[i] = counts(generator) * 32;
+	}
+
+	CPUAtlas serialProbeData;
+	serialProbeData.Resize(params.ProbeCounts.x * params.ProbeCounts.y, params.ProbeCounts.z);
+
+	CPUAtlas pooledProbeData = serialProbeData;
+
+	std::vector<int> serialActiveProbes;
+	std::vector<int> pooledActiveProbes;
+
+	ThreadPool threadPool(4);
+
+	CPUProbeClassifier serialClassifier;
+	serialClassifier.ClassifyProbes(params, rayData, serialProbeData, serialActiveProbes, rayCounts.data());
+
+	CPUProbeClassifier pooledClassifier(&threadPool);
+	pooledClassifier.ClassifyProbes(params, rayData, pooledProbeData, pooledActiveProbes, rayCounts.data());
+
+	CHECK(serialActiveProbes.empty() == false);
+	CHECK((int)serialActiveProbes.size() < TestHelper::GetNumProbes(params));
+	CHECK(serialActiveProbes == pooledActiveProbes);
+
+	for (int i = 0; i < TestHelper::GetNumProbes(params); ++i)
+	{
+		CHECK(GetState(i, params, serialProbeData) == CPUProbeClassifier::ClassifyProbe(i, params, rayData, rayCounts.data()));
+	}
+}
@@ -0,0 +1,324 @@
+#include "TestHelper.h"
+#include "Commons/ThreadPool.h"
+#include "GI/CPUProbeBlender.h"
+#include "GI/CPUProbeFilter.h"
+#include "GI/CPUProbeRelocator.h"
+#include "GI/ProbeFilterBenchmark.h"
+#include "Helpers/ProbeHelper.h"
+#include "Shaders/Defines.hlsli"
+
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	//Every probe sees 10 units in every direction, further than any neighbour, so they can all see each other
+	void CreateOpenAtlases(const RaytracePerFrameCB& kParams, CPUAtlas& irradianceAtlas, CPUAtlas& distanceAtlas)
+	{
+		CPUAtlas rayData;
+		CPUProbeBlender::CreateAtlases(kParams, rayData, irradianceAtlas, distanceAtlas);
+
+		for (int i = 0; i < (int)distanceAtlas.Texels.size(); ++i)
+		{
+			//Stored halved like the blend shader does
+			distanceAtlas.Texels[i] = XMFLOAT4(5.0f, 50.0f, 0.0f, 0.0f);
+		}
+	}
+
+	void CreateNoisyIrradiance(const RaytracePerFrameCB& kParams, int iSeed, CPUAtlas& irradianceAtlas)
+	{
+		std::mt19937 generator(iSeed);
+		std::uniform_real_distribution<float> irradiances(0.3f, 0.7f);
+
+		for (int i = 0; i < (int)irradianceAtlas.Texels.size(); ++i)
+		{
+			float fRed = irradiances(generator);
+			float fGreen = irradiances(generator);
+			float fBlue = irradiances(generator);
+
+			irradianceAtlas.Texels[i] = XMFLOAT4(fRed, fGreen, fBlue, 1.0f);
+		}
+	}
+
+	//Largest difference over the interior texels of every probe, the filter doesn't write the borders
+	float GetInteriorDifference(const RaytracePerFrameCB& kParams, const CPUAtlas& kAtlas, const CPUAtlas& kOtherAtlas)
+	{
+		int iTileSize = kParams.NumIrradianceTexels + 2;
+		float fDifference = 0.0f;
+
+		for (int y = 0; y < kAtlas.Height; ++y)
+		{
+			for (int x = 0; x < kAtlas.Width; ++x)
+			{
+				if (x % iTileSize == 0 || x % iTileSize == iTileSize - 1 || y % iTileSize == 0 || y % iTileSize == iTileSize - 1)
+				{
+					continue;
+				}
+
+				const XMFLOAT4& kTexel = kAtlas.GetTexel(x, y);
+				const XMFLOAT4& kOtherTexel = kOtherAtlas.GetTexel(x, y);
+
+				fDifference = fmaxf(fDifference, fabsf(kTexel.x - kOtherTexel.x));
+				fDifference = fmaxf(fDifference, fabsf(kTexel.y - kOtherTexel.y));
+				fDifference = fmaxf(fDifference, fabsf(kTexel.z - kOtherTexel.z));
+			}
+		}
+
+		return fDifference;
+	}
+}
+
+TEST(FilterNeighbourCounts)
+{
+	CHECK(CPUProbeFilter::GetNumNeighbours(PROBE_FILTER_NONE) == 0);
+	CHECK(CPUProbeFilter::GetNumNeighbours(PROBE_FILTER_6_NEIGHBOURS) == 6);
+	CHECK(CPUProbeFilter::GetNumNeighbours(PROBE_FILTER_26_NEIGHBOURS) == 26);
+}
+
+TEST(FilterWeighsNeighboursByDistance)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(3, 3, 3), 64);
+	params.ProbeFilter = PROBE_FILTER_26_NEIGHBOURS;
+
+	CPUAtlas irradianceAtlas;
+	CPUAtlas distanceAtlas;
+	CreateOpenAtlases(params, irradianceAtlas, distanceAtlas);
+
+	int iCentre = ProbeHelper::GetProbeIndex(XMINT3(1, 1, 1), params.ProbeCounts);
+
+	std::vector<bool> neighbourSeen(TestHelper::GetNumProbes(params), false);
+
+	for (int i = 0; i < 26; ++i)
+	{
+		int iNeighbourIndex;
+		float fWeight = CPUProbeFilter::GetNeighbourWeight(iCentre, i, params, distanceAtlas, nullptr, iNeighbourIndex);
+
+		XMINT3 offset = ProbeHelper::GetFilterNeighbourOffset(i, params.ProbeFilter);
+		XMINT3 neighbourCoords = ProbeHelper::GetProbeCoords(iNeighbourIndex, params.ProbeCounts);
+
+		//Face neighbours get the full strength, edges half and corners a third
+		CHECK_NEAR(fWeight, params.ProbeFilterStrength / (offset.x * offset.x + offset.y * offset.y + offset.z * offset.z), 1e-6f);
+		CHECK(neighbourCoords.x == 1 + offset.x && neighbourCoords.y == 1 + offset.y && neighbourCoords.z == 1 + offset.z);
+
+		neighbourSeen[iNeighbourIndex] = true;
+	}
+
+	//Every probe around the centre exactly once
+	for (int i = 0; i < (int)neighbourSeen.size(); ++i)
+	{
+		CHECK(neighbourSeen[i] == (i != iCentre));
+	}
+
+	//A corner probe has only 7 neighbours inside the volume
+	int iNumInside = 0;
+
+	for (int i = 0; i < 26; ++i)
+	{
+		int iNeighbourIndex;
+
+		if (CPUProbeFilter::GetNeighbourWeight(0, i, params, distanceAtlas, nullptr, iNeighbourIndex) > 0.0f)
+		{
+			++iNumInside;
+		}
+	}
+
+	CHECK(iNumInside == 7);
+}
+
+TEST(FilterSkipsHiddenAndInactiveNeighbours)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(3, 3, 3), 64);
+	params.ProbeFilter = PROBE_FILTER_6_NEIGHBOURS;
+	params.ProbeClassification = 1;
+
+	CPUAtlas irradianceAtlas;
+	CPUAtlas distanceAtlas;
+	CreateOpenAtlases(params, irradianceAtlas, distanceAtlas);
+
+	CPUAtlas probeData;
+	CPUProbeRelocator::CreateAtlas(params, probeData);
+
+	int iCentre = ProbeHelper::GetProbeIndex(XMINT3(1, 1, 1), params.ProbeCounts);
+
+	for (int i = 0; i < TestHelper::GetNumProbes(params); ++i)
+	{
+		XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(i, params.ProbeCounts, params.AtlasLayout);
+		probeData.GetTexel(dataCoords.x, dataCoords.y).w = PROBE_STATE_ACTIVE;
+	}
+
+	int iNeighbourIndex;
+	CPUProbeFilter::GetNeighbourWeight(iCentre, 0, params, distanceAtlas, &probeData, iNeighbourIndex);
+
+	XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(iNeighbourIndex, params.ProbeCounts, params.AtlasLayout);
+	probeData.GetTexel(dataCoords.x, dataCoords.y).w = PROBE_STATE_INACTIVE;
+
+	CHECK(CPUProbeFilter::GetNeighbourWeight(iCentre, 0, params, distanceAtlas, &probeData, iNeighbourIndex) == 0.0f);
+	CHECK(CPUProbeFilter::GetNeighbourWeight(iCentre, 1, params, distanceAtlas, &probeData, iNeighbourIndex) == params.ProbeFilterStrength);
+
+	//The centre probe has a wall 0.2 away in every direction so can't see any neighbour
+	XMINT2 tileCoords = ProbeHelper::GetProbeDataCoords(iCentre, params.ProbeCounts, params.AtlasLayout);
+	int iTileSize = params.NumDistanceTexels + 2;
+
+	for (int y = 0; y < iTileSize; ++y)
+	{
+		for (int x = 0; x < iTileSize; ++x)
+		{
+			distanceAtlas.GetTexel(tileCoords.x * iTileSize + x, tileCoords.y * iTileSize + y) = XMFLOAT4(0.1f, 0.02f, 0.0f, 0.0f);
+		}
+	}
+
+	for (int i = 1; i < 6; ++i)
+	{
+		CHECK(CPUProbeFilter::GetNeighbourWeight(iCentre, i, params, distanceAtlas, &probeData, iNeighbourIndex) < params.ProbeFilterStrength * 0.01f);
+	}
+}
+
+TEST(FilterKeepsUniformIrradiance)
+{
+	const int kiFilters[3] = { PROBE_FILTER_NONE, PROBE_FILTER_6_NEIGHBOURS, PROBE_FILTER_26_NEIGHBOURS };
+
+	for (int iFilter : kiFilters)
+	{
+		RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(4, 3, 5), 64);
+		params.ProbeFilter = iFilter;
+		params.ProbeFilterStrength = 1.0f;
+
+		CPUAtlas irradianceAtlas;
+		CPUAtlas distanceAtlas;
+		CreateOpenAtlases(params, irradianceAtlas, distanceAtlas);
+
+		for (int i = 0; i < (int)irradianceAtlas.Texels.size(); ++i)
+		{
+			irradianceAtlas.Texels[i] = XMFLOAT4(0.25f, 0.5f, 0.75f, 1.0f);
+		}
+
+		CPUAtlas filteredAtlas;
+
+		CPUProbeFilter filter;
+		filter.FilterProbes(params, irradianceAtlas, distanceAtlas, nullptr, filteredAtlas);
+
+		CHECK(filteredAtlas.Width == irradianceAtlas.Width && filteredAtlas.Height == irradianceAtlas.Height);
+		CHECK_NEAR(GetInteriorDifference(params, filteredAtlas, irradianceAtlas), 0.0f, 1e-5f);
+	}
+}
+
+TEST(FilterWithoutNeighboursCopiesProbes)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(4, 3, 5), 64);
+
+	CPUAtlas irradianceAtlas;
+	CPUAtlas distanceAtlas;
+	CreateOpenAtlases(params, irradianceAtlas, distanceAtlas);
+	CreateNoisyIrradiance(params, 1, irradianceAtlas);
+
+	CPUAtlas filteredAtlas;
+
+	CPUProbeFilter filter;
+	filter.FilterProbes(params, irradianceAtlas, distanceAtlas, nullptr, filteredAtlas);
+
+	CHECK(GetInteriorDifference(params, filteredAtlas, irradianceAtlas) == 0.0f);
+
+	//No strength is the same as no filter
+	params.ProbeFilter = PROBE_FILTER_26_NEIGHBOURS;
+	params.ProbeFilterStrength = 0.0f;
+
+	filter.FilterProbes(params, irradianceAtlas, distanceAtlas, nullptr, filteredAtlas);
+
+	CHECK_NEAR(GetInteriorDifference(params, filteredAtlas, irradianceAtlas), 0.0f, 1e-6f);
+}
+
+TEST(FilterThreadPoolMatchesSerial)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(8, 4, 6), 64);
+	params.ProbeFilter = PROBE_FILTER_26_NEIGHBOURS;
+
+	CPUAtlas irradianceAtlas;
+	CPUAtlas distanceAtlas;
+	CreateOpenAtlases(params, irradianceAtlas, distanceAtlas);
+	CreateNoisyIrradiance(params, 2, irradianceAtlas);
+
+	CPUAtlas serialAtlas;
+	CPUAtlas pooledAtlas;
+
+	ThreadPool threadPool(4);
+
+	CPUProbeFilter serialFilter;
+	serialFilter.FilterProbes(params, irradianceAtlas, distanceAtlas, nullptr, serialAtlas);
+
+	CPUProbeFilter pooledFilter(&threadPool);
+	pooledFilter.FilterProbes(params, irradianceAtlas, distanceAtlas, nullptr, pooledAtlas);
+
+	CHECK(GetInteriorDifference(params, serialAtlas, pooledAtlas) == 0.0f);
+	CHECK(GetInteriorDifference(params, serialAtlas, irradianceAtlas) > 0.0f);
+}
+
+TEST(FilterReducesFrameToFrameNoise)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(6, 4, 5), 64);
+
+	CPUAtlas irradianceAtlas;
+	CPUAtlas distanceAtlas;
+	CreateOpenAtlases(params, irradianceAtlas, distanceAtlas);
+
+	//Independent noise each frame around the same mean, the same as blending without hysteresis
+	std::vector<CPUAtlas> frames(16, irradianceAtlas);
+
+	for (int i = 0; i < (int)frames.size(); ++i)
+	{
+		CreateNoisyIrradiance(params, 100 + i, frames[i]);
+	}
+
+	ProbeFilterBenchmark benchmark;
+	std::vector<ProbeFilterStats> stats = benchmark.RunAll(params, frames, distanceAtlas, nullptr, 0.25f);
+
+	CHECK(stats.size() == 2);
+	CHECK(stats[0].ProbeFilter == PROBE_FILTER_6_NEIGHBOURS);
+	CHECK(stats[0].NumFrames == 16);
+	CHECK(stats[0].VarianceReduction > 1.2);
+
+	//More neighbours at the same strength take more of the noise out
+	CHECK(stats[1].ProbeFilter == PROBE_FILTER_26_NEIGHBOURS);
+	CHECK(stats[1].VarianceReduction > stats[0].VarianceReduction);
+
+	//No filter leaves the noise as it is
+	params.ProbeFilter = PROBE_FILTER_NONE;
+
+	ProbeFilterStats unfiltered = benchmark.Run(params, frames, distanceAtlas, nullptr);
+
+	CHECK_NEAR(unfiltered.VarianceReduction, 1.0, 1e-6);
+	CHECK(unfiltered.RelativeBias == 0.0);
+}
+
+TEST(FilterBiasComesFromNeighbourDifferences)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(6, 4, 5), 64);
+
+	CPUAtlas irradianceAtlas;
+	CPUAtlas distanceAtlas;
+	CreateOpenAtlases(params, irradianceAtlas, distanceAtlas);
+
+	ProbeFilterBenchmark benchmark;
+
+	//The same light everywhere has nothing to leak between probes
+	for (int i = 0; i < (int)irradianceAtlas.Texels.size(); ++i)
+	{
+		irradianceAtlas.Texels[i] = XMFLOAT4(0.25f, 0.5f, 0.75f, 1.0f);
+	}
+
+	std::vector<CPUAtlas> frames(4, irradianceAtlas);
+	std::vector<ProbeFilterStats> stats = benchmark.RunAll(params, frames, distanceAtlas, nullptr, 0.25f);
+
+	CHECK(stats[0].RelativeBias < 1e-5);
+	CHECK(stats[1].RelativeBias < 1e-5);
+
+	//Different light in each probe that doesn't change between frames is all bias and no variance
+	CreateNoisyIrradiance(params, 3, irradianceAtlas);
+
+	frames.assign(4, irradianceAtlas);
+	stats = benchmark.RunAll(params, frames, distanceAtlas, nullptr, 0.25f);
+
+	CHECK(stats[0].RelativeBias > 0.01);
+	CHECK(stats[1].RelativeBias > stats[0].RelativeBias);
+	CHECK(stats[0].UnfilteredVariance < 1e-12);
+}
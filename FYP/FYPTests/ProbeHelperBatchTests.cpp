@@ -0,0 +1,330 @@
+#include "TestHelper.h"
+#include "Commons/Timer.h"
+#include "Helpers/ProbeHelperBatch.h"
+#include "Shaders/Defines.hlsli"
+
+#include <random>
+#include <stdio.h>
+
+using namespace DirectX;
+
+namespace
+{
+	//Every tail length past a full batch of eight, and a count big enough to go round the loop plenty of times
+	const int s_kiCounts[] = { 0, 1, 7, 8, 9, 15, 16, 17, 23, 1001 };
+
+	const XMINT3 s_kProbeCounts[] = { XMINT3(1, 1, 1), XMINT3(4, 4, 4), XMINT3(7, 3, 5), XMINT3(22, 9, 13), XMINT3(128, 16, 96) };
+
+	//Runs a batch function with AVX2 turned off and on, which leaves the results of each in the two outputs
+	template<typename T>
+	void RunBothPaths(const std::function<void(std::vector<T>&)>& kFunction, int iCount, std::vector<T>& scalar, std::vector<T>& avx2)
+	{
+		scalar.assign(iCount, T());
+		avx2.assign(iCount, T());
+
+		ProbeHelperBatch::SetAVX2Allowed(false);
+		kFunction(scalar);
+
+		ProbeHelperBatch::SetAVX2Allowed(true);
+		kFunction(avx2);
+	}
+
+	//Bitwise so a -0 against a +0 or a different rounding shows up
+	template<typename T>
+	bool IsBitwiseEqual(const std::vector<T>& kLHS, const std::vector<T>& kRHS)
+	{
+		return kLHS.size() == kRHS.size() && (kLHS.empty() == true || memcmp(kLHS.data(), kRHS.data(), kLHS.size() * sizeof(T)) == 0);
+	}
+
+	//Random unit directions with the axes, the octahedron's edges and signed zeroes mixed in
+	void CreateDirections(int iCount, std::mt19937& generator, std::vector<float>& x, std::vector<float>& y, std::vector<float>& z)
+	{
+		std::uniform_real_distribution<float> components(-1.0f, 1.0f);
+
+		const XMFLOAT3 kEdgeCases[] = {
+			XMFLOAT3(1.0f, 0.0f, 0.0f), XMFLOAT3(-1.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(0.0f, -1.0f, 0.0f),
+			XMFLOAT3(0.0f, 0.0f, 1.0f), XMFLOAT3(0.0f, 0.0f, -1.0f), XMFLOAT3(-0.0f, -0.0f, -1.0f), XMFLOAT3(0.6f, -0.8f, -0.0f),
+			XMFLOAT3(0.577350f, 0.577350f, -0.577350f), XMFLOAT3(-0.707107f, 0.0f, -0.707107f) };
+
+		const int kiNumEdgeCases = sizeof(kEdgeCases) / sizeof(kEdgeCases[0]);
+
+		x.resize(iCount);
+		y.resize(iCount);
+		z.resize(iCount);
+
+		for (int i = 0; i < iCount; ++i)
+		{
+			XMFLOAT3 direction = kEdgeCases[i % kiNumEdgeCases];
+
+			if (i >= kiNumEdgeCases * 2 || i % 2 == 1)
+			{
+				float fX = components(generator);
+				float fY = components(generator);
+				float fZ = components(generator);
+
+				direction = ProbeHelper::Normalize(XMFLOAT3(fX, fY, fZ + 1e-3f));
+			}
+
+			x[i] = direction.x;
+			y[i] = direction.y;
+			z[i] = direction.z;
+		}
+	}
+}
+
+TEST(BatchProbeIndexingMatchesScalar)
+{
+	std::mt19937 generator(13);
+
+	for (const XMINT3& kProbeCounts : s_kProbeCounts)
+	{
+		int iNumProbes = kProbeCounts.x * kProbeCounts.y * kProbeCounts.z;
+
+		for (int iCount : s_kiCounts)
+		{
+			std::uniform_int_distribution<int> probeIndices(0, iNumProbes - 1);
+
+			std::vector<int> indices(iCount);
+
+			for (int i = 0; i < iCount; ++i)
+			{
+				indices[i] = probeIndices(generator);
+			}
+
+			std::vector<int> scalarX(iCount);
+			std::vector<int> scalarY(iCount);
+			std::vector<int> scalarZ(iCount);
+			std::vector<int> avx2X(iCount);
+			std::vector<int> avx2Y(iCount);
+			std::vector<int> avx2Z(iCount);
+
+			ProbeHelperBatch::SetAVX2Allowed(false);
+			ProbeHelperBatch::GetProbeCoords(indices.data(), iCount, kProbeCounts, scalarX.data(), scalarY.data(), scalarZ.data());
+
+			ProbeHelperBatch::SetAVX2Allowed(true);
+			ProbeHelperBatch::GetProbeCoords(indices.data(), iCount, kProbeCounts, avx2X.data(), avx2Y.data(), avx2Z.data());
+
+			CHECK(avx2X == scalarX);
+			CHECK(avx2Y == scalarY);
+			CHECK(avx2Z == scalarZ);
+
+			//And back again
+			std::vector<int> scalarIndices;
+			std::vector<int> avx2Indices;
+
+			RunBothPaths<int>([&](std::vector<int>& output)
+			{
+				ProbeHelperBatch::GetProbeIndex(scalarX.data(), scalarY.data(), scalarZ.data(), iCount, kProbeCounts, output.data());
+			}, iCount, scalarIndices, avx2Indices);
+
+			CHECK(scalarIndices == indices);
+			CHECK(avx2Indices == indices);
+
+			//Offsets of either sign and bigger than the volume so the wrap is tested both ways
+			std::uniform_int_distribution<int> offsets(-3 * iNumProbes, 3 * iNumProbes);
+			XMINT3 probeOffsets = XMINT3(offsets(generator), offsets(generator), offsets(generator));
+
+			RunBothPaths<int>([&](std::vector<int>& output)
+			{
+				ProbeHelperBatch::GetOffsettedProbeIndex(scalarX.data(), scalarY.data(), scalarZ.data(), iCount, kProbeCounts, probeOffsets, output.data());
+			}, iCount, scalarIndices, avx2Indices);
+
+			CHECK(avx2Indices == scalarIndices);
+
+			for (int i = 0; i < iCount; ++i)
+			{
+				CHECK(scalarIndices[i] == ProbeHelper::GetOffsettedProbeIndex(XMINT3(scalarX[i], scalarY[i], scalarZ[i]), kProbeCounts, probeOffsets));
+			}
+		}
+	}
+}
+
+TEST(BatchAtlasAddressingMatchesScalar)
+{
+	std::mt19937 generator(19);
+	std::uniform_real_distribution<float> octCoords(-1.0f, 1.0f);
+
+	const int kiLayouts[2] = { PROBE_ATLAS_LAYOUT_PLANES, PROBE_ATLAS_LAYOUT_BRICKS };
+	const int kiNumTexels[2] = { 6, 14 };
+
+	for (const XMINT3& kProbeCounts : s_kProbeCounts)
+	{
+		int iNumProbes = kProbeCounts.x * kProbeCounts.y * kProbeCounts.z;
+
+		for (int iLayout : kiLayouts)
+		{
+			for (int iNumTexels : kiNumTexels)
+			{
+				for (int iCount : s_kiCounts)
+				{
+					std::uniform_int_distribution<int> texCoordsX(0, iNumTexels * kProbeCounts.x * kProbeCounts.y - 1);
+					std::uniform_int_distribution<int> texCoordsY(0, iNumTexels * kProbeCounts.z - 1);
+					std::uniform_int_distribution<int> probeIndices(0, iNumProbes - 1);
+
+					std::vector<int> texX(iCount);
+					std::vector<int> texY(iCount);
+					std::vector<int> indices(iCount);
+					std::vector<float> octX(iCount);
+					std::vector<float> octY(iCount);
+
+					for (int i = 0; i < iCount; ++i)
+					{
+						texX[i] = texCoordsX(generator);
+						texY[i] = texCoordsY(generator);
+						indices[i] = probeIndices(generator);
+						octX[i] = octCoords(generator);
+						octY[i] = octCoords(generator);
+					}
+
+					std::vector<int> scalarIndices;
+					std::vector<int> avx2Indices;
+
+					RunBothPaths<int>([&](std::vector<int>& output)
+					{
+						ProbeHelperBatch::GetProbeIndex(texX.data(), texY.data(), iCount, iNumTexels, kProbeCounts, iLayout, output.data());
+					}, iCount, scalarIndices, avx2Indices);
+
+					CHECK(avx2Indices == scalarIndices);
+
+					for (int i = 0; i < iCount; ++i)
+					{
+						CHECK(scalarIndices[i] == ProbeHelper::GetProbeIndex(XMINT2(texX[i], texY[i]), iNumTexels, kProbeCounts, iLayout));
+					}
+
+					std::vector<float> scalarU(iCount);
+					std::vector<float> scalarV(iCount);
+					std::vector<float> avx2U(iCount);
+					std::vector<float> avx2V(iCount);
+
+					ProbeHelperBatch::SetAVX2Allowed(false);
+					ProbeHelperBatch::GetAtlasCoords(indices.data(), octX.data(), octY.data(), iCount, iNumTexels, kProbeCounts, iLayout, scalarU.data(), scalarV.data());
+
+					ProbeHelperBatch::SetAVX2Allowed(true);
+					ProbeHelperBatch::GetAtlasCoords(indices.data(), octX.data(), octY.data(), iCount, iNumTexels, kProbeCounts, iLayout, avx2U.data(), avx2V.data());
+
+					CHECK(IsBitwiseEqual(avx2U, scalarU) == true);
+					CHECK(IsBitwiseEqual(avx2V, scalarV) == true);
+				}
+			}
+		}
+	}
+}
+
+TEST(BatchOctahedralMappingMatchesScalar)
+{
+	std::mt19937 generator(31);
+
+	for (int iCount : s_kiCounts)
+	{
+		std::vector<float> x;
+		std::vector<float> y;
+		std::vector<float> z;
+		CreateDirections(iCount, generator, x, y, z);
+
+		std::vector<float> scalarU(iCount);
+		std::vector<float> scalarV(iCount);
+		std::vector<float> avx2U(iCount);
+		std::vector<float> avx2V(iCount);
+
+		ProbeHelperBatch::SetAVX2Allowed(false);
+		ProbeHelperBatch::GetOctahedralCoords(x.data(), y.data(), z.data(), iCount, scalarU.data(), scalarV.data());
+
+		ProbeHelperBatch::SetAVX2Allowed(true);
+		ProbeHelperBatch::GetOctahedralCoords(x.data(), y.data(), z.data(), iCount, avx2U.data(), avx2V.data());
+
+		CHECK(IsBitwiseEqual(avx2U, scalarU) == true);
+		CHECK(IsBitwiseEqual(avx2V, scalarV) == true);
+
+		std::vector<float> scalarX(iCount);
+		std::vector<float> scalarY(iCount);
+		std::vector<float> scalarZ(iCount);
+		std::vector<float> avx2X(iCount);
+		std::vector<float> avx2Y(iCount);
+		std::vector<float> avx2Z(iCount);
+
+		ProbeHelperBatch::SetAVX2Allowed(false);
+		ProbeHelperBatch::GetOctahedralDirection(scalarU.data(), scalarV.data(), iCount, scalarX.data(), scalarY.data(), scalarZ.data());
+
+		ProbeHelperBatch::SetAVX2Allowed(true);
+		ProbeHelperBatch::GetOctahedralDirection(scalarU.data(), scalarV.data(), iCount, avx2X.data(), avx2Y.data(), avx2Z.data());
+
+		CHECK(IsBitwiseEqual(avx2X, scalarX) == true);
+		CHECK(IsBitwiseEqual(avx2Y, scalarY) == true);
+		CHECK(IsBitwiseEqual(avx2Z, scalarZ) == true);
+
+		//The mapping is its own inverse up to rounding
+		for (int i = 0; i < iCount; ++i)
+		{
+			CHECK_NEAR(scalarX[i], x[i], 1e-5f);
+			CHECK_NEAR(scalarY[i], y[i], 1e-5f);
+			CHECK_NEAR(scalarZ[i], z[i], 1e-5f);
+		}
+	}
+}
+
+TEST(OctahedralMappingMatchesShader)
+{
+	//Worked out by hand from Shaders/Octahedral.hlsl
+	const float kfThird = 1.0f / 3.0f;
+
+	XMFLOAT2 coords = ProbeHelper::GetOctahedralCoords(XMFLOAT3(0.0f, 0.0f, 1.0f));
+	CHECK(coords.x == 0.0f && coords.y == 0.0f);
+
+	coords = ProbeHelper::GetOctahedralCoords(XMFLOAT3(1.0f, 0.0f, 0.0f));
+	CHECK(coords.x == 1.0f && coords.y == 0.0f);
+
+	//Lower hemisphere folds out onto the corners
+	coords = ProbeHelper::GetOctahedralCoords(XMFLOAT3(0.0f, 0.0f, -1.0f));
+	CHECK(coords.x == 1.0f && coords.y == 1.0f);
+
+	coords = ProbeHelper::GetOctahedralCoords(ProbeHelper::Normalize(XMFLOAT3(-1.0f, 1.0f, -1.0f)));
+	CHECK_NEAR(coords.x, -2.0f * kfThird, 1e-6f);
+	CHECK_NEAR(coords.y, 2.0f * kfThird, 1e-6f);
+
+	XMFLOAT3 direction = ProbeHelper::GetOctahedralDirection(XMFLOAT2(0.5f, -0.5f));
+	CHECK_NEAR(direction.x, 0.707107f, 1e-6f);
+	CHECK_NEAR(direction.y, -0.707107f, 1e-6f);
+	CHECK_NEAR(direction.z, 0.0f, 1e-6f);
+}
+
+TEST(BatchProbeHelperThroughput)
+{
+	//Not a pass or fail, prints how much the AVX2 path buys so a regression is easy to spot in the test log
+	const int kiCount = 1 << 20;
+	const int kiNumRepeats = 8;
+
+	std::mt19937 generator(37);
+
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+	CreateDirections(kiCount, generator, x, y, z);
+
+	std::vector<float> u(kiCount);
+	std::vector<float> v(kiCount);
+
+	double dSeconds[2] = { 0.0, 0.0 };
+
+	for (int i = 0; i < 2; ++i)
+	{
+		ProbeHelperBatch::SetAVX2Allowed(i == 1);
+
+		Timer timer;
+		timer.Reset();
+
+		for (int j = 0; j < kiNumRepeats; ++j)
+		{
+			ProbeHelperBatch::GetOctahedralCoords(x.data(), y.data(), z.data(), kiCount, u.data(), v.data());
+			ProbeHelperBatch::GetOctahedralDirection(u.data(), v.data(), kiCount, x.data(), y.data(), z.data());
+		}
+
+		timer.Tick();
+
+		dSeconds[i] = timer.DeltaTime();
+	}
+
+	ProbeHelperBatch::SetAVX2Allowed(true);
+
+	printf("    octahedral round trips: scalar %.2f ns, AVX2 %.2f ns%s\n", dSeconds[0] * 1e9 / (kiCount * (double)kiNumRepeats), dSeconds[1] * 1e9 / (kiCount * (double)kiNumRepeats),
+		ProbeHelperBatch::IsAVX2Supported() == true ? "" : " (AVX2 not supported, both scalar)");
+}
@@ -0,0 +1,292 @@
+#include "TestHelper.h"
+#include "Commons/ThreadPool.h"
+#include "GI/CPUProbeRelocator.h"
+#include "Helpers/ProbeHelper.h"
+#include "Shaders/Defines.hlsli"
+
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	const float s_kfOpenDistance = 5.0f;
+
+	//Every ray of every probe hits a front face s_kfOpenDistance away
+	void CreateOpenRayData(const RaytracePerFrameCB& kParams, CPUAtlas& rayData)
+	{
+		rayData.Resize(kParams.RaysPerProbe, TestHelper::GetNumProbes(kParams));
+
+		for (int i = 0; i < (int)rayData.Texels.size(); ++i)
+		{
+			rayData.Texels[i] = XMFLOAT4(0.5f, 0.5f, 0.5f, s_kfOpenDistance);
+		}
+	}
+
+	//Rays [0, iNumRays) of the probe hit back faces 0.3 away apart from iClosestRay at 0.1, stored scaled down like the shader does
+	void SetBackfaces(int iProbeIndex, int iNumRays, int iClosestRay, CPUAtlas& rayData)
+	{
+		for (int i = 0; i < iNumRays; ++i)
+		{
+			rayData.GetTexel(i, iProbeIndex).w = (i == iClosestRay ? 0.1f : 0.3f) * -0.2f;
+		}
+	}
+
+	void SetOffset(int iProbeIndex, const RaytracePerFrameCB& kParams, const XMFLOAT3& kOffset, float fState, CPUAtlas& probeData)
+	{
+		XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(iProbeIndex, kParams.ProbeCounts, kParams.AtlasLayout);
+
+		probeData.GetTexel(dataCoords.x, dataCoords.y) = XMFLOAT4(kOffset.x, kOffset.y, kOffset.z, fState);
+	}
+
+	XMFLOAT4 GetOffset(int iProbeIndex, const RaytracePerFrameCB& kParams, const CPUAtlas& kProbeData)
+	{
+		XMINT2 dataCoords = ProbeHelper::GetProbeDataCoords(iProbeIndex, kParams.ProbeCounts, kParams.AtlasLayout);
+
+		return kProbeData.GetTexel(dataCoords.x, dataCoords.y);
+	}
+
+	//Where a probe at the centre of its cell ends up after moving out through iClosestRay
+	XMFLOAT3 GetBackfaceOffset(int iProbeIndex, int iClosestRay, int iNumRays, const RaytracePerFrameCB& kParams)
+	{
+		XMFLOAT4 rayRotation = ProbeHelper::GetProbeRayRotation(iProbeIndex, kParams.RayRotation, kParams.PerProbeRayRotation);
+		XMFLOAT3 direction = ProbeHelper::GetRayDirection(iClosestRay, iNumRays, rayRotation);
+
+		float fDistance = 0.1f + kParams.ProbeMinFrontfaceDistance * 0.5f;
+
+		return XMFLOAT3(direction.x * fDistance, direction.y * fDistance, direction.z * fDistance);
+	}
+}
+
+TEST(RelocatorDriftsBackToCentreInOpenSpace)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(2, 2, 2), 64);
+	params.ProbeRelocation = 1;
+
+	CPUAtlas rayData;
+	CreateOpenRayData(params, rayData);
+
+	CPUAtlas probeData;
+	CPUProbeRelocator::CreateAtlas(params, probeData);
+
+	for (int i = 0; i < TestHelper::GetNumProbes(params); ++i)
+	{
+		SetOffset(i, params, XMFLOAT3(0.2f, -0.1f, 0.05f), PROBE_STATE_ACTIVE, probeData);
+	}
+
+	CPUProbeRelocator relocator;
+	relocator.RelocateProbes(params, rayData, probeData);
+
+	for (int i = 0; i < TestHelper::GetNumProbes(params); ++i)
+	{
+		XMFLOAT4 offset = GetOffset(i, params, probeData);
+
+		CHECK_NEAR(offset.x, 0.0f, 1e-6f);
+		CHECK_NEAR(offset.y, 0.0f, 1e-6f);
+		CHECK_NEAR(offset.z, 0.0f, 1e-6f);
+	}
+}
+
+TEST(RelocatorMovesProbesOutOfGeometry)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(2, 2, 2), 64);
+	params.ProbeRelocation = 1;
+	params.RayRotation = XMFLOAT4(0.2f, -0.3f, 0.1f, 0.927362f);
+
+	CPUAtlas rayData;
+	CreateOpenRayData(params, rayData);
+	SetBackfaces(3, 32, 7, rayData);
+
+	CPUAtlas probeData;
+	CPUProbeRelocator::CreateAtlas(params, probeData);
+
+	CPUProbeRelocator relocator;
+	relocator.RelocateProbes(params, rayData, probeData);
+
+	XMFLOAT3 expected = GetBackfaceOffset(3, 7, 64, params);
+	XMFLOAT4 offset = GetOffset(3, params, probeData);
+
+	CHECK_NEAR(offset.x, expected.x, 1e-5f);
+	CHECK_NEAR(offset.y, expected.y, 1e-5f);
+	CHECK_NEAR(offset.z, expected.z, 1e-5f);
+
+	//Other probes have nowhere to go
+	XMFLOAT4 otherOffset = GetOffset(2, params, probeData);
+
+	CHECK(otherOffset.x == 0.0f && otherOffset.y == 0.0f && otherOffset.z == 0.0f);
+}
+
+TEST(RelocatorUsesPerProbeRayCounts)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(2, 2, 2), 64);
+	params.ProbeRelocation = 1;
+	params.AdaptiveRays = 1;
+
+	std::vector<uint32_t> rayCounts(TestHelper::GetNumProbes(params), 64);
+	rayCounts[0] = 32;
+	rayCounts[1] = 32;
+
+	CPUAtlas rayData;
+	CreateOpenRayData(params, rayData);
+
+	//Probe 0 only traced its first 32 rays this frame, the back faces past them are left over from a frame with more
+	SetBackfaces(0, 64, 40, rayData);
+
+	for (int i = 0; i < 32; ++i)
+	{
+		rayData.GetTexel(i, 0).w = s_kfOpenDistance;
+	}
+
+	//Probe 1's rays are spread over the sphere for 32 rays, not 64
+	SetBackfaces(1, 32, 5, rayData);
+
+	CPUAtlas probeData;
+	CPUProbeRelocator::CreateAtlas(params, probeData);
+	SetOffset(0, params, XMFLOAT3(0.2f, 0.0f, 0.0f), PROBE_STATE_ACTIVE, probeData);
+
+	CPUProbeRelocator relocator;
+	relocator.RelocateProbes(params, rayData, probeData, rayCounts.data());
+
+	XMFLOAT4 offset = GetOffset(0, params, probeData);
+
+	CHECK_NEAR(offset.x, 0.0f, 1e-6f);
+	CHECK_NEAR(offset.y, 0.0f, 1e-6f);
+	CHECK_NEAR(offset.z, 0.0f, 1e-6f);
+
+	XMFLOAT3 expected = GetBackfaceOffset(1, 5, 32, params);
+	offset = GetOffset(1, params, probeData);
+
+	CHECK_NEAR(offset.x, expected.x, 1e-5f);
+	CHECK_NEAR(offset.y, expected.y, 1e-5f);
+	CHECK_NEAR(offset.z, expected.z, 1e-5f);
+}
+
+TEST(RelocatorSkipsInactiveProbes)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(2, 2, 2), 64);
+	params.ProbeRelocation = 1;
+	params.ProbeClassification = 1;
+	params.UseActiveProbeList = 1;
+	params.FullProbeUpdate = 0;
+
+	CPUAtlas rayData;
+	CreateOpenRayData(params, rayData);
+
+	CPUAtlas probeData;
+	CPUProbeRelocator::CreateAtlas(params, probeData);
+	SetOffset(0, params, XMFLOAT3(0.2f, 0.0f, 0.0f), PROBE_STATE_INACTIVE, probeData);
+	SetOffset(1, params, XMFLOAT3(0.2f, 0.0f, 0.0f), PROBE_STATE_ACTIVE, probeData);
+
+	CPUProbeRelocator relocator;
+	relocator.RelocateProbes(params, rayData, probeData);
+
+	CHECK(GetOffset(0, params, probeData).x == 0.2f);
+	CHECK_NEAR(GetOffset(1, params, probeData).x, 0.0f, 1e-6f);
+
+	//Every probe is looked at again on a full update
+	params.FullProbeUpdate = 1;
+
+	relocator.RelocateProbes(params, rayData, probeData);
+
+	CHECK_NEAR(GetOffset(0, params, probeData).x, 0.0f, 1e-6f);
+}
+
+TEST(RelocatorSkipsUntracedProbes)
+{
+	//A list built on the CPU by the scheduler with classification off, so every probe is active and it's a full update
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(2, 2, 2), 64);
+	params.ProbeRelocation = 1;
+	params.UseActiveProbeList = 1;
+	params.FullProbeUpdate = 1;
+	params.TracedProbeMask = 1;
+
+	CPUAtlas rayData;
+	CreateOpenRayData(params, rayData);
+
+	CPUAtlas probeData;
+	CPUProbeRelocator::CreateAtlas(params, probeData);
+	SetOffset(0, params, XMFLOAT3(0.2f, 0.0f, 0.0f), PROBE_STATE_ACTIVE, probeData);
+	SetOffset(1, params, XMFLOAT3(0.2f, 0.0f, 0.0f), PROBE_STATE_ACTIVE, probeData);
+
+	//Only probe 1 was scheduled, probe 0's row is from the last time it was traced
+	std::vector<uint32_t> tracedProbeMask(ProbeHelper::GetTracedProbeMaskSize(TestHelper::GetNumProbes(params)), 0);
+	tracedProbeMask[0] = 1u << 1;
+
+	CPUProbeRelocator relocator;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		relocator.RelocateProbes(params, rayData, probeData, nullptr, tracedProbeMask.data());
+	}
+
+	CHECK(GetOffset(0, params, probeData).x == 0.2f);
+	CHECK(GetOffset(0, params, probeData).w == PROBE_STATE_ACTIVE);
+	CHECK_NEAR(GetOffset(1, params, probeData).x, 0.0f, 1e-6f);
+
+	//Once it is scheduled it moves like any other probe
+	tracedProbeMask[0] |= 1u;
+
+	relocator.RelocateProbes(params, rayData, probeData, nullptr, tracedProbeMask.data());
+
+	CHECK_NEAR(GetOffset(0, params, probeData).x, 0.0f, 1e-6f);
+}
+
+TEST(RelocatorThreadPoolMatchesSerial)
+{
+	RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(6, 5, 4), 96);
+	params.ProbeRelocation = 1;
+	params.PerProbeRayRotation = 1;
+
+	std::mt19937 generator(7);
+	std::uniform_real_distribution<float> backfaceFractions(0.0f, 0.5f);
+	std::uniform_real_distribution<float> backfaceDistances(0.05f, 0.35f);
+	std::uniform_real_distribution<float> frontfaceDistances(0.05f, 3.0f);
+	std::uniform_real_distribution<float> chances(0.0f, 1.0f);
+
+	CPUAtlas rayData;
+	rayData.Resize(params.RaysPerProbe, TestHelper::GetNumProbes(params));
+
+	//Some probes end up inside geometry, some close to it and some in the open
+	for (int i = 0; i < rayData.Height; ++i)
+	{
+		float fBackfaceFraction = backfaceFractions(generator);
+
+		for (int j = 0; j < rayData.Width; ++j)
+		{
+			float fDistance = chances(generator) < fBackfaceFraction ? backfaceDistances(generator) * -0.2f : frontfaceDistances(generator);
+
+			rayData.GetTexel(j, i) = XMFLOAT4(0.0f, 0.0f, 0.0f, fDistance);
+		}
+	}
+
+	CPUAtlas serialProbeData;
+	CPUProbeRelocator::CreateAtlas(params, serialProbeData);
+
+	CPUAtlas pooledProbeData = serialProbeData;
+
+	ThreadPool threadPool(4);
+
+	CPUProbeRelocator serialRelocator;
+	CPUProbeRelocator pooledRelocator(&threadPool);
+
+	for (int i = 0; i < 4; ++i)
+	{
+		serialRelocator.RelocateProbes(params, rayData, serialProbeData);
+		pooledRelocator.RelocateProbes(params, rayData, pooledProbeData);
+	}
+
+	bool bMatch = true;
+	bool bMoved = false;
+
+	for (int i = 0; i < (int)serialProbeData.Texels.size(); ++i)
+	{
+		const XMFLOAT4& kSerial = serialProbeData.Texels[i];
+		const XMFLOAT4& kPooled = pooledProbeData.Texels[i];
+
+		bMatch = bMatch && kSerial.x == kPooled.x && kSerial.y == kPooled.y && kSerial.z == kPooled.z;
+		bMoved = bMoved || kSerial.x != 0.0f || kSerial.y != 0.0f || kSerial.z != 0.0f;
+	}
+
+	CHECK(bMatch == true);
+	CHECK(bMoved == true);
+}
@@ -0,0 +1,229 @@
+#include "TestHelper.h"
+#include "GI/ProbeScheduler.h"
+#include "Helpers/ProbeHelper.h"
+
+#include <algorithm>
+
+using namespace DirectX;
+
+namespace
+{
+	const XMINT3 s_kProbeCounts = XMINT3(4, 4, 4);
+	const XMINT3 s_kProbeOffsets = XMINT3(0, 0, 0);
+	const XMFLOAT3 s_kVolumePosition = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	const XMFLOAT3 s_kProbeSpacing = XMFLOAT3(1.0f, 1.0f, 1.0f);
+
+	const int s_kiNumProbes = 64;
+
+	const std::vector<UINT>& Schedule(ProbeScheduler& scheduler, const XMFLOAT3& kCameraPosition = XMFLOAT3(0.0f, 0.0f, 0.0f))
+	{
+		return scheduler.Schedule(s_kVolumePosition, s_kProbeSpacing, s_kProbeCounts, s_kProbeOffsets, kCameraPosition);
+	}
+
+	//GIVolume uploads the list as is, so it has to be ascending without repeats
+	bool IsStrictlyAscending(const std::vector<UINT>& kProbes)
+	{
+		for (int i = 1; i < (int)kProbes.size(); ++i)
+		{
+			if (kProbes[i] <= kProbes[i - 1])
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool Contains(const std::vector<UINT>& kProbes, UINT uiProbeIndex)
+	{
+		return std::find(kProbes.begin(), kProbes.end(), uiProbeIndex) != kProbes.end();
+	}
+}
+
+TEST(SchedulerAllModeSchedulesEveryProbe)
+{
+	ProbeScheduler scheduler;
+	scheduler.Init(s_kiNumProbes);
+	scheduler.SetBudget(8);
+
+	const std::vector<UINT>& kProbes = Schedule(scheduler);
+
+	CHECK(scheduler.IsScheduling() == false);
+	CHECK(kProbes.size() == s_kiNumProbes);
+	CHECK(IsStrictlyAscending(kProbes) == true);
+	CHECK(scheduler.GetMaxStaleness() == 0);
+}
+
+TEST(SchedulerRoundRobinVisitsProbesInOrder)
+{
+	ProbeScheduler scheduler;
+	scheduler.Init(s_kiNumProbes);
+	scheduler.SetMode(ProbeSchedulingMode::ROUND_ROBIN);
+	scheduler.SetBudget(16);
+
+	CHECK(scheduler.GetMaxStaleness() == 3);
+
+	for (int i = 0; i < 8; ++i)
+	{
+		const std::vector<UINT>& kProbes = Schedule(scheduler);
+
+		CHECK(kProbes.size() == 16);
+
+		UINT uiFirst = (i % 4) * 16;
+
+		for (int j = 0; j < (int)kProbes.size(); ++j)
+		{
+			CHECK(kProbes[j] == uiFirst + j);
+		}
+	}
+}
+
+TEST(SchedulerCameraProximityPicksNearestProbes)
+{
+	ProbeScheduler scheduler;
+	scheduler.Init(s_kiNumProbes);
+	scheduler.SetMode(ProbeSchedulingMode::CAMERA_PROXIMITY);
+	scheduler.SetMaxAge(s_kiNumProbes - 1);
+
+	//One round robin slot, which takes probe 0, and the 8 probes within a diagonal of the far corner
+	scheduler.SetBudget(9);
+
+	XMFLOAT3 cameraPosition = ProbeHelper::GetProbeCoordsWorld(XMINT3(3, 3, 3), s_kVolumePosition, s_kProbeOffsets, s_kProbeSpacing, s_kProbeCounts);
+
+	const std::vector<UINT>& kProbes = Schedule(scheduler, cameraPosition);
+
+	CHECK(kProbes.size() == 9);
+	CHECK(IsStrictlyAscending(kProbes) == true);
+	CHECK(Contains(kProbes, 0) == true);
+
+	for (int i = 0; i < s_kiNumProbes; ++i)
+	{
+		XMINT3 probeCoords = ProbeHelper::GetProbeCoords(i, s_kProbeCounts);
+
+		bool bNearCorner = probeCoords.x >= 2 && probeCoords.y >= 2 && probeCoords.z >= 2;
+
+		CHECK(i == 0 || Contains(kProbes, i) == bNearCorner);
+	}
+}
+
+TEST(SchedulerChangeMagnitudePicksChangingProbes)
+{
+	ProbeScheduler scheduler;
+	scheduler.Init(s_kiNumProbes);
+	scheduler.SetMode(ProbeSchedulingMode::CHANGE_MAGNITUDE);
+	scheduler.SetMaxAge(s_kiNumProbes - 1);
+	scheduler.SetBudget(4);
+
+	scheduler.SetProbeChange(5, 0.5f);
+	scheduler.SetProbeChange(17, 1.0f);
+	scheduler.SetProbeChange(40, 0.25f);
+
+	std::vector<UINT> probes = Schedule(scheduler);
+
+	CHECK(probes == std::vector<UINT>({ 0, 5, 17, 40 }));
+
+	//With nothing changing the oldest probes win, the round robin has moved on to probe 1
+	scheduler.SetProbeChange(5, 0.0f);
+	scheduler.SetProbeChange(17, 0.0f);
+	scheduler.SetProbeChange(40, 0.0f);
+
+	probes = Schedule(scheduler);
+
+	CHECK(probes.size() == 4);
+	CHECK(Contains(probes, 1) == true);
+	CHECK(Contains(probes, 5) == false);
+	CHECK(Contains(probes, 17) == false);
+	CHECK(Contains(probes, 40) == false);
+}
+
+TEST(SchedulerKeepsEveryProbeWithinMaxStaleness)
+{
+	const ProbeSchedulingMode kModes[2] = { ProbeSchedulingMode::CAMERA_PROXIMITY, ProbeSchedulingMode::CHANGE_MAGNITUDE };
+
+	for (int i = 0; i < 2; ++i)
+	{
+		ProbeScheduler scheduler;
+		scheduler.Init(s_kiNumProbes);
+		scheduler.SetMode(kModes[i]);
+		scheduler.SetMaxAge(6);
+		scheduler.SetBudget(12);
+
+		//Probe 9 keeps changing and the camera sits on probe 0, so both would starve the far probes without the round robin
+		scheduler.SetProbeChange(9, 10.0f);
+
+		int iMaxStaleness = scheduler.GetMaxStaleness();
+
+		CHECK(iMaxStaleness <= 6);
+
+		for (int j = 0; j < 100; ++j)
+		{
+			const std::vector<UINT>& kProbes = Schedule(scheduler, XMFLOAT3(-1.5f, -1.5f, -1.5f));
+
+			CHECK(kProbes.size() == 12);
+			CHECK(IsStrictlyAscending(kProbes) == true);
+
+			for (int k = 0; k < s_kiNumProbes; ++k)
+			{
+				CHECK(scheduler.GetProbeAge(k) <= iMaxStaleness);
+			}
+		}
+	}
+}
+
+TEST(SchedulerInvalidatedProbesSkipTheQueue)
+{
+	ProbeScheduler scheduler;
+	scheduler.Init(s_kiNumProbes);
+	scheduler.SetMode(ProbeSchedulingMode::ROUND_ROBIN);
+	scheduler.SetBudget(8);
+
+	scheduler.Invalidate(50);
+	scheduler.Invalidate(60);
+
+	const std::vector<UINT>& kProbes = Schedule(scheduler);
+
+	//On top of the budget
+	CHECK(kProbes.size() == 10);
+	CHECK(IsStrictlyAscending(kProbes) == true);
+	CHECK(Contains(kProbes, 50) == true);
+	CHECK(Contains(kProbes, 60) == true);
+
+	CHECK(Schedule(scheduler).size() == 8);
+}
+
+TEST(SchedulerPassesOverSleepingProbes)
+{
+	ProbeScheduler scheduler;
+	scheduler.Init(s_kiNumProbes);
+	scheduler.SetMode(ProbeSchedulingMode::CAMERA_PROXIMITY);
+	scheduler.SetBudget(16);
+
+	for (int i = 0; i < s_kiNumProbes; i += 2)
+	{
+		scheduler.SetProbeAsleep(i, true);
+	}
+
+	for (int i = 0; i < 10; ++i)
+	{
+		const std::vector<UINT>& kProbes = Schedule(scheduler);
+
+		CHECK(kProbes.size() == 16);
+
+		for (int j = 0; j < (int)kProbes.size(); ++j)
+		{
+			CHECK(kProbes[j] % 2 == 1);
+		}
+	}
+
+	//Only the awake probes are left to fill the budget with
+	for (int i = 1; i < s_kiNumProbes; i += 4)
+	{
+		scheduler.SetProbeAsleep(i, true);
+	}
+
+	CHECK(Schedule(scheduler).size() == 16);
+
+	scheduler.SetProbeAsleep(3, true);
+
+	CHECK(Schedule(scheduler).size() == 15);
+}
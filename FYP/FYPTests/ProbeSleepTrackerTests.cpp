@@ -0,0 +1,213 @@
+#include "TestHelper.h"
+#include "GI/ProbeSleepTracker.h"
+#include "Helpers/ProbeHelper.h"
+
+using namespace DirectX;
+
+namespace
+{
+	std::vector<UINT> GetAllProbes(int iNumProbes)
+	{
+		std::vector<UINT> probes(iNumProbes);
+
+		for (int i = 0; i < iNumProbes; ++i)
+		{
+			probes[i] = (UINT)i;
+		}
+
+		return probes;
+	}
+}
+
+TEST(SleepAfterSteadyFrames)
+{
+	ProbeSleepTracker tracker;
+	tracker.Init(4);
+	tracker.SetSleepFrames(3);
+
+	std::vector<UINT> probes = GetAllProbes(4);
+
+	//Probe 1 keeps changing and probe 2 changes once half way through
+	std::vector<float> changes = { 0.0f, 0.01f, 0.0f, tracker.GetChangeThreshold() * 0.5f };
+
+	for (int i = 0; i < 2; ++i)
+	{
+		tracker.Update(changes, probes);
+
+		CHECK(tracker.GetNumAsleep() == 0);
+	}
+
+	CHECK(tracker.GetFramesBelowThreshold(0) == 2);
+	CHECK(tracker.GetFramesBelowThreshold(1) == 0);
+
+	changes[2] = tracker.GetChangeThreshold();
+	tracker.Update(changes, probes);
+
+	CHECK(tracker.IsAsleep(0) == true);
+	CHECK(tracker.IsAsleep(1) == false);
+	CHECK(tracker.IsAsleep(2) == false);
+	CHECK(tracker.IsAsleep(3) == true);
+	CHECK(tracker.GetFramesBelowThreshold(2) == 0);
+	CHECK(tracker.GetNumAsleep() == 2);
+
+	changes[2] = 0.0f;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		tracker.Update(changes, probes);
+	}
+
+	CHECK(tracker.IsAsleep(2) == true);
+	CHECK(tracker.IsAsleep(1) == false);
+	CHECK(tracker.GetNumAsleep() == 3);
+}
+
+TEST(SleepOnlyCountsUpdatedProbes)
+{
+	ProbeSleepTracker tracker;
+	tracker.Init(4);
+	tracker.SetSleepFrames(2);
+
+	std::vector<float> changes(4, 0.0f);
+
+	//Probes 1 and 3 weren't traced so their change is stale
+	std::vector<UINT> updatedProbes = { 0, 2 };
+
+	tracker.Update(changes, updatedProbes);
+	tracker.Update(changes, updatedProbes);
+
+	CHECK(tracker.IsAsleep(0) == true);
+	CHECK(tracker.IsAsleep(1) == false);
+	CHECK(tracker.IsAsleep(2) == true);
+	CHECK(tracker.GetFramesBelowThreshold(3) == 0);
+
+	//Indices past the end of the changes or the volume are ignored
+	tracker.Update(std::vector<float>(2, 0.0f), std::vector<UINT>({ 3, 7 }));
+
+	CHECK(tracker.GetFramesBelowThreshold(3) == 0);
+}
+
+TEST(SleepWakeDiscardsTheNextChange)
+{
+	ProbeSleepTracker tracker;
+	tracker.Init(3);
+	tracker.SetSleepFrames(1);
+
+	std::vector<UINT> probes = GetAllProbes(3);
+	std::vector<float> changes(3, 0.0f);
+
+	tracker.Update(changes, probes);
+
+	CHECK(tracker.GetNumAsleep() == 3);
+
+	tracker.Wake(1);
+
+	CHECK(tracker.IsAsleep(1) == false);
+	CHECK(tracker.GetNumAsleep() == 2);
+
+	//Waking an awake probe doesn't change the count
+	tracker.Wake(1);
+
+	CHECK(tracker.GetNumAsleep() == 2);
+
+	//The change read back this frame is from before the wake so the probe can't go straight back to sleep
+	tracker.Update(changes, probes);
+
+	CHECK(tracker.IsAsleep(1) == false);
+
+	tracker.Update(changes, probes);
+
+	CHECK(tracker.IsAsleep(1) == true);
+
+	tracker.WakeAll();
+
+	CHECK(tracker.GetNumAsleep() == 0);
+
+	tracker.Update(changes, probes);
+
+	CHECK(tracker.GetNumAsleep() == 0);
+	CHECK(tracker.GetFramesBelowThreshold(0) == 0);
+}
+
+TEST(SleepWakeInBounds)
+{
+	const XMINT3 kProbeCounts = XMINT3(5, 3, 4);
+	const XMINT3 kProbeOffsets = XMINT3(2, 0, -1);
+	const XMFLOAT3 kProbeSpacing = XMFLOAT3(1.0f, 2.0f, 1.5f);
+	const XMFLOAT3 kVolumePosition = XMFLOAT3(10.0f, 0.0f, -3.0f);
+
+	int iNumProbes = kProbeCounts.x * kProbeCounts.y * kProbeCounts.z;
+
+	const XMFLOAT3 kBoundsMin = XMFLOAT3(11.0f, -1.0f, -5.0f);
+	const XMFLOAT3 kBoundsMax = XMFLOAT3(12.5f, 1.0f, -3.0f);
+	const float kfRadius = 0.75f;
+
+	ProbeSleepTracker tracker;
+	tracker.Init(iNumProbes);
+	tracker.SetSleepFrames(1);
+	tracker.Update(std::vector<float>(iNumProbes, 0.0f), GetAllProbes(iNumProbes));
+
+	tracker.WakeInBounds(kBoundsMin, kBoundsMax, kfRadius, kVolumePosition, kProbeSpacing, kProbeCounts, kProbeOffsets);
+
+	int iNumWoken = 0;
+
+	for (int i = 0; i < iNumProbes; ++i)
+	{
+		XMINT3 probeCoords = ProbeHelper::GetUnoffsettedProbeCoords(i, kProbeCounts, kProbeOffsets);
+		XMFLOAT3 probeCoordsW = ProbeHelper::GetProbeCoordsWorld(probeCoords, kVolumePosition, kProbeOffsets, kProbeSpacing, kProbeCounts);
+
+		float fX = fmaxf(fmaxf(kBoundsMin.x - probeCoordsW.x, probeCoordsW.x - kBoundsMax.x), 0.0f);
+		float fY = fmaxf(fmaxf(kBoundsMin.y - probeCoordsW.y, probeCoordsW.y - kBoundsMax.y), 0.0f);
+		float fZ = fmaxf(fmaxf(kBoundsMin.z - probeCoordsW.z, probeCoordsW.z - kBoundsMax.z), 0.0f);
+
+		bool bNear = sqrtf(fX * fX + fY * fY + fZ * fZ) <= kfRadius;
+
+		CHECK(tracker.IsAsleep(i) == (bNear == false));
+
+		if (bNear == true)
+		{
+			++iNumWoken;
+		}
+	}
+
+	//Some but not all of the volume
+	CHECK(iNumWoken > 0);
+	CHECK(iNumWoken < iNumProbes);
+	CHECK(tracker.GetNumAsleep() == iNumProbes - iNumWoken);
+}
+
+TEST(SleepRemovesSleepingProbesInOrder)
+{
+	ProbeSleepTracker tracker;
+	tracker.Init(8);
+	tracker.SetSleepFrames(1);
+
+	std::vector<float> changes(8, 0.0f);
+	tracker.Update(changes, std::vector<UINT>({ 1, 4, 5 }));
+
+	std::vector<UINT> awakeProbes = { 99 };
+	tracker.RemoveSleepingProbes(std::vector<UINT>({ 7, 5, 0, 4, 2, 1, 6 }), awakeProbes);
+
+	CHECK(awakeProbes == std::vector<UINT>({ 7, 0, 2, 6 }));
+
+	tracker.RemoveSleepingProbes(std::vector<UINT>(), awakeProbes);
+
+	CHECK(awakeProbes.empty() == true);
+}
+
+TEST(SleepSettersClamp)
+{
+	ProbeSleepTracker tracker;
+	tracker.SetSleepFrames(0);
+	tracker.SetChangeThreshold(-1.0f);
+
+	CHECK(tracker.GetSleepFrames() == 1);
+	CHECK(tracker.GetChangeThreshold() == 0.0f);
+
+	//Nothing is ever below a zero threshold so no probe sleeps
+	tracker.Init(2);
+	tracker.Update(std::vector<float>(2, 0.0f), GetAllProbes(2));
+
+	CHECK(tracker.GetNumAsleep() == 0);
+	CHECK(tracker.GetFramesBelowThreshold(0) == 0);
+}
@@ -0,0 +1,125 @@
+#include "TestHelper.h"
+#include "GI/RayDirectionTable.h"
+#include "Helpers/ProbeHelper.h"
+
+using namespace DirectX;
+
+namespace
+{
+	//Counts that fill the last vector and ones that leave one to three lanes spare
+	const int s_kiRayCounts[] = { 1, 5, 32, 63, 64, 130, 288 };
+
+	const XMFLOAT4 s_kRotation = XMFLOAT4(0.2f, -0.3f, 0.1f, 0.927362f);
+
+	float GetLane(const XMVECTOR& kVector, int iLane)
+	{
+		XMFLOAT4 values;
+		XMStoreFloat4(&values, kVector);
+
+		return (&values.x)[iLane];
+	}
+
+	uint32_t GetMaskLane(const XMVECTOR& kVector, int iLane)
+	{
+		uint32_t uiValues[4];
+		XMStoreInt4(uiValues, kVector);
+
+		return uiValues[iLane];
+	}
+
+	void CheckDirection(const XMFLOAT3& kActual, const XMFLOAT3& kExpected)
+	{
+		CHECK_NEAR(kActual.x, kExpected.x, 1e-5f);
+		CHECK_NEAR(kActual.y, kExpected.y, 1e-5f);
+		CHECK_NEAR(kActual.z, kExpected.z, 1e-5f);
+	}
+}
+
+TEST(RayDirectionTableMatchesGetRayDirection)
+{
+	RayDirectionTable table;
+
+	for (int iNumRays : s_kiRayCounts)
+	{
+		table.Update(iNumRays, s_kRotation);
+
+		CHECK(table.GetRaysPerProbe() == iNumRays);
+		CHECK((int)table.GetDirections().size() == iNumRays);
+
+		int iNumVectors = (iNumRays + 3) / 4;
+
+		CHECK((int)table.GetDirectionsX().size() == iNumVectors);
+		CHECK((int)table.GetMasks().size() == iNumVectors);
+
+		for (int i = 0; i < iNumVectors * 4; ++i)
+		{
+			const XMVECTOR& kX = table.GetDirectionsX()[i / 4];
+			const XMVECTOR& kY = table.GetDirectionsY()[i / 4];
+			const XMVECTOR& kZ = table.GetDirectionsZ()[i / 4];
+
+			if (i >= iNumRays)
+			{
+				CHECK(GetMaskLane(table.GetMasks()[i / 4], i % 4) == 0);
+				CHECK(GetLane(kX, i % 4) == 0.0f && GetLane(kY, i % 4) == 0.0f && GetLane(kZ, i % 4) == 0.0f);
+
+				continue;
+			}
+
+			XMFLOAT3 expected = ProbeHelper::GetRayDirection(i, iNumRays, s_kRotation);
+			const XMFLOAT4& kDirection = table.GetDirections()[i];
+
+			CHECK(GetMaskLane(table.GetMasks()[i / 4], i % 4) == 0xFFFFFFFF);
+			CheckDirection(XMFLOAT3(kDirection.x, kDirection.y, kDirection.z), expected);
+			CheckDirection(XMFLOAT3(GetLane(kX, i % 4), GetLane(kY, i % 4), GetLane(kZ, i % 4)), expected);
+		}
+	}
+}
+
+TEST(RayDirectionTableFollowsRotationAndCountChanges)
+{
+	RayDirectionTable table;
+
+	//Going back to a count that was already built has to pick up the new rotation and not the old table
+	const XMFLOAT4 kRotations[3] = { XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f), s_kRotation, XMFLOAT4(-0.5f, 0.5f, 0.5f, 0.5f) };
+	const int kiRayCounts[3] = { 64, 32, 64 };
+
+	for (int i = 0; i < 3; ++i)
+	{
+		table.Update(kiRayCounts[i], kRotations[i]);
+
+		for (int j = 0; j < kiRayCounts[i]; ++j)
+		{
+			const XMFLOAT4& kDirection = table.GetDirections()[j];
+
+			CheckDirection(XMFLOAT3(kDirection.x, kDirection.y, kDirection.z), ProbeHelper::GetRayDirection(j, kiRayCounts[i], kRotations[i]));
+		}
+	}
+}
+
+TEST(RayDirectionTableMatchesPerProbeRotation)
+{
+	RayDirectionTable table;
+
+	for (int iNumRays : s_kiRayCounts)
+	{
+		table.Update(iNumRays, s_kRotation);
+
+		std::vector<XMVECTOR> directionsX;
+		std::vector<XMVECTOR> directionsY;
+		std::vector<XMVECTOR> directionsZ;
+
+		for (int iProbeIndex = 0; iProbeIndex < 50; iProbeIndex += 7)
+		{
+			table.GetProbeDirections(iProbeIndex, directionsX, directionsY, directionsZ);
+
+			XMFLOAT4 probeRotation = ProbeHelper::GetProbeRayRotation(iProbeIndex, s_kRotation, 1);
+
+			for (int i = 0; i < iNumRays; ++i)
+			{
+				XMFLOAT3 direction = XMFLOAT3(GetLane(directionsX[i / 4], i % 4), GetLane(directionsY[i / 4], i % 4), GetLane(directionsZ[i / 4], i % 4));
+
+				CheckDirection(direction, ProbeHelper::GetRayDirection(i, iNumRays, probeRotation));
+			}
+		}
+	}
+}
@@ -0,0 +1,133 @@
+#include "TestHelper.h"
+#include "GI/RayRotationGenerator.h"
+#include "Helpers/ProbeHelper.h"
+
+using namespace DirectX;
+
+namespace
+{
+	float GetLength(const XMFLOAT4& kRotation)
+	{
+		return sqrtf(kRotation.x * kRotation.x + kRotation.y * kRotation.y + kRotation.z * kRotation.z + kRotation.w * kRotation.w);
+	}
+
+	//q and -q are the same rotation so compare the absolute dot product
+	bool IsSameRotation(const XMFLOAT4& kA, const XMFLOAT4& kB)
+	{
+		return fabsf(kA.x * kB.x + kA.y * kB.y + kA.z * kB.z + kA.w * kB.w) > 0.99999f;
+	}
+}
+
+TEST(RayRotationsAreUnitQuaternions)
+{
+	for (int i = 0; i < (int)RayRotationSequence::COUNT; ++i)
+	{
+		RayRotationGenerator generator;
+		generator.SetSequence((RayRotationSequence)i);
+
+		//Past the end of a blue noise cycle so the spin between cycles is covered too
+		for (int j = 0; j < 200; ++j)
+		{
+			CHECK_NEAR(GetLength(generator.Next()), 1.0f, 1e-4f);
+		}
+
+		CHECK(generator.GetFrameIndex() == 200);
+	}
+
+	const float kfCorners[2] = { 0.0f, 0.99999994f };
+
+	for (int i = 0; i < 8; ++i)
+	{
+		CHECK_NEAR(GetLength(RayRotationGenerator::GetArvoRotation(kfCorners[i & 1], kfCorners[(i >> 1) & 1], kfCorners[i >> 2])), 1.0f, 1e-4f);
+	}
+}
+
+TEST(RayRotationsAreDeterministicPerFrame)
+{
+	for (int i = 0; i < (int)RayRotationSequence::COUNT; ++i)
+	{
+		RayRotationGenerator generator;
+		generator.SetSequence((RayRotationSequence)i);
+		generator.SetSeed(1234);
+
+		RayRotationGenerator sameSeed;
+		sameSeed.SetSequence((RayRotationSequence)i);
+		sameSeed.SetSeed(1234);
+
+		RayRotationGenerator otherSeed;
+		otherSeed.SetSequence((RayRotationSequence)i);
+		otherSeed.SetSeed(4321);
+
+		std::vector<XMFLOAT4> rotations(100);
+		int iNumSameAsOtherSeed = 0;
+
+		for (int j = 0; j < 100; ++j)
+		{
+			rotations[j] = generator.Next();
+			XMFLOAT4 sameRotation = sameSeed.Next();
+
+			CHECK(memcmp(&rotations[j], &sameRotation, sizeof(XMFLOAT4)) == 0);
+
+			iNumSameAsOtherSeed += IsSameRotation(rotations[j], otherSeed.Next()) == true ? 1 : 0;
+		}
+
+		CHECK(iNumSameAsOtherSeed == 0);
+
+		//Seeding again starts the same frames over
+		generator.SetSeed(1234);
+
+		for (int j = 0; j < 100; ++j)
+		{
+			XMFLOAT4 rotation = generator.Next();
+
+			CHECK(memcmp(&rotations[j], &rotation, sizeof(XMFLOAT4)) == 0);
+		}
+
+		//Consecutive frames never repeat a rotation
+		for (int j = 1; j < 100; ++j)
+		{
+			CHECK(IsSameRotation(rotations[j], rotations[j - 1]) == false);
+		}
+	}
+}
+
+TEST(PerProbeRayRotationDiffersAcrossProbes)
+{
+	const int kiNumProbes = 64;
+
+	XMFLOAT4 rayRotation = RayRotationGenerator::GetArvoRotation(0.3f, 0.7f, 0.2f);
+
+	std::vector<XMFLOAT4> rotations(kiNumProbes);
+
+	for (int i = 0; i < kiNumProbes; ++i)
+	{
+		//Without per probe rotation every probe shares the frame's rotation
+		XMFLOAT4 sharedRotation = ProbeHelper::GetProbeRayRotation(i, rayRotation, 0);
+		CHECK(memcmp(&sharedRotation, &rayRotation, sizeof(XMFLOAT4)) == 0);
+
+		rotations[i] = ProbeHelper::GetProbeRayRotation(i, rayRotation, 1);
+		CHECK_NEAR(GetLength(rotations[i]), 1.0f, 1e-4f);
+
+		//The same probe gets the same rotation every time it's asked for
+		XMFLOAT4 sameRotation = ProbeHelper::GetProbeRayRotation(i, rayRotation, 1);
+		CHECK(memcmp(&sameRotation, &rotations[i], sizeof(XMFLOAT4)) == 0);
+	}
+
+	int iNumSamePairs = 0;
+
+	for (int i = 0; i < kiNumProbes; ++i)
+	{
+		for (int j = i + 1; j < kiNumProbes; ++j)
+		{
+			iNumSamePairs += IsSameRotation(rotations[i], rotations[j]) == true ? 1 : 0;
+		}
+	}
+
+	CHECK(iNumSamePairs == 0);
+
+	//Neighbouring probes trace different directions for the same ray
+	XMFLOAT3 direction0 = ProbeHelper::GetRayDirection(0, 64, rotations[0]);
+	XMFLOAT3 direction1 = ProbeHelper::GetRayDirection(0, 64, rotations[1]);
+
+	CHECK(direction0.x * direction1.x + direction0.y * direction1.y + direction0.z * direction1.z < 0.999f);
+}
@@ -0,0 +1,202 @@
+#include "TestHelper.h"
+#include "GI/CPUProbeBlender.h"
+#include "GI/CPUSHProjector.h"
+#include "Helpers/ProbeHelper.h"
+#include "Shaders/Defines.hlsli"
+
+#include <functional>
+
+using namespace DirectX;
+
+namespace
+{
+	typedef std::function<XMFLOAT3(const XMFLOAT3&)> RadianceField;
+
+	RaytracePerFrameCB CreateSHParams(int iEncoding)
+	{
+		RaytracePerFrameCB params = TestHelper::CreateParams(XMINT3(3, 2, 2), 256);
+		params.Hysteresis = 0.0f;
+		params.IrradianceEncoding = iEncoding;
+		params.NumSHCoefficients = iEncoding == PROBE_IRRADIANCE_ENCODING_SH_L1 ? 4 : 9;
+
+		return params;
+	}
+
+	//Every ray misses and brings back kField in the direction it was traced, the same rays the shaders would have traced
+	void CreateFieldRayData(const RaytracePerFrameCB& kParams, const RadianceField& kField, CPUAtlas& rayData)
+	{
+		rayData.Resize(kParams.RaysPerProbe, TestHelper::GetNumProbes(kParams));
+
+		for (int i = 0; i < TestHelper::GetNumProbes(kParams); ++i)
+		{
+			XMFLOAT4 rayRotation = ProbeHelper::GetProbeRayRotation(i, kParams.RayRotation, kParams.PerProbeRayRotation);
+
+			for (int j = 0; j < (int)kParams.RaysPerProbe; ++j)
+			{
+				XMFLOAT3 radiance = kField(ProbeHelper::GetRayDirection(j, kParams.RaysPerProbe, rayRotation));
+
+				rayData.GetTexel(j, i) = XMFLOAT4(radiance.x, radiance.y, radiance.z, 1e27f);
+			}
+		}
+	}
+
+	XMFLOAT3 GetLinearRadiance(const XMFLOAT3& kDirection)
+	{
+		return XMFLOAT3(1.0f + 0.5f * kDirection.x, 0.8f - 0.3f * kDirection.y + 0.2f * kDirection.z, 0.6f + 0.4f * kDirection.z);
+	}
+
+	//Cosine convolution of GetLinearRadiance halved like the blend, the constant band is scaled by 1/2 and the linear one by 1/3
+	XMFLOAT3 GetLinearIrradiance(const XMFLOAT3& kNormal)
+	{
+		return XMFLOAT3(0.5f + (0.5f * kNormal.x) / 3.0f, 0.4f + (-0.3f * kNormal.y + 0.2f * kNormal.z) / 3.0f, 0.3f + (0.4f * kNormal.z) / 3.0f);
+	}
+
+	//A small bright sun on a dim sky, too sharp for a few SH bands to follow
+	XMFLOAT3 GetSunRadiance(const XMFLOAT3& kDirection)
+	{
+		float fSun = kDirection.y > 0.9f ? 20.0f : 0.0f;
+
+		return XMFLOAT3(0.1f + fSun, 0.1f + fSun, 0.2f + fSun);
+	}
+
+	//Largest difference between the projected irradiance and kExpected over a spread of directions for every probe
+	float GetMaxIrradianceError(const RaytracePerFrameCB& kParams, const CPUAtlas& kSHAtlas, const RadianceField& kExpected)
+	{
+		float fMaxError = 0.0f;
+
+		for (int i = 0; i < TestHelper::GetNumProbes(kParams); ++i)
+		{
+			for (int j = 0; j < 64; ++j)
+			{
+				XMFLOAT3 normal = ProbeHelper::GetFibonacciSpiralDirection((float)j, 64.0f);
+
+				XMFLOAT3 irradiance = CPUSHProjector::EvaluateIrradiance(i, normal, kParams, kSHAtlas);
+				XMFLOAT3 expected = kExpected(normal);
+
+				fMaxError = fmaxf(fMaxError, fabsf(irradiance.x - expected.x));
+				fMaxError = fmaxf(fMaxError, fabsf(irradiance.y - expected.y));
+				fMaxError = fmaxf(fMaxError, fabsf(irradiance.z - expected.z));
+			}
+		}
+
+		return fMaxError;
+	}
+
+	SHEncodingError MeasureFieldError(RaytracePerFrameCB params, const RadianceField& kField)
+	{
+		CPUAtlas rayData;
+		CPUAtlas octahedralAtlas;
+		CPUAtlas distanceAtlas;
+		CPUProbeBlender::CreateAtlases(params, rayData, octahedralAtlas, distanceAtlas);
+
+		CreateFieldRayData(params, kField, rayData);
+
+		int iEncoding = params.IrradianceEncoding;
+		params.IrradianceEncoding = PROBE_IRRADIANCE_ENCODING_OCTAHEDRAL;
+
+		CPUProbeBlender blender;
+		blender.BlendIrradiance(params, rayData, octahedralAtlas);
+
+		params.IrradianceEncoding = iEncoding;
+
+		CPUAtlas shAtlas;
+		CPUSHProjector::CreateAtlas(params, shAtlas);
+
+		CPUSHProjector projector;
+		projector.ProjectProbes(params, rayData, shAtlas);
+
+		return CPUSHProjector::MeasureError(params, octahedralAtlas, shAtlas);
+	}
+}
+
+TEST(SHProjectsConstantRadiance)
+{
+	const int kiEncodings[2] = { PROBE_IRRADIANCE_ENCODING_SH_L1, PROBE_IRRADIANCE_ENCODING_SH_L2 };
+
+	for (int i = 0; i < 2; ++i)
+	{
+		RaytracePerFrameCB params = CreateSHParams(kiEncodings[i]);
+		params.PerProbeRayRotation = 1;
+
+		CPUAtlas rayData;
+		CreateFieldRayData(params, [](const XMFLOAT3&) { return XMFLOAT3(1.0f, 0.5f, 2.0f); }, rayData);
+
+		CPUAtlas shAtlas;
+		CPUSHProjector::CreateAtlas(params, shAtlas);
+
+		CHECK(shAtlas.Width == 3 * 2 * params.NumSHCoefficients);
+		CHECK(shAtlas.Height == 2);
+
+		CPUSHProjector projector;
+		projector.ProjectProbes(params, rayData, shAtlas);
+
+		//Only the constant band is left, 2 pi Y0 times the radiance so it evaluates to half the radiance like the octahedral blend
+		XMINT2 coords = CPUSHProjector::GetSHCoords(0, 0, params.NumSHCoefficients, params.ProbeCounts, params.AtlasLayout);
+
+		CHECK_NEAR(shAtlas.GetTexel(coords.x, coords.y).x, 2.0f * XM_PI * 0.282095f, 1e-4f);
+
+		for (int j = 1; j < params.NumSHCoefficients; ++j)
+		{
+			coords = CPUSHProjector::GetSHCoords(0, j, params.NumSHCoefficients, params.ProbeCounts, params.AtlasLayout);
+
+			CHECK_NEAR(shAtlas.GetTexel(coords.x, coords.y).x, 0.0f, 2e-3f);
+		}
+
+		CHECK(GetMaxIrradianceError(params, shAtlas, [](const XMFLOAT3&) { return XMFLOAT3(0.5f, 0.25f, 1.0f); }) < 1e-3f);
+	}
+}
+
+TEST(SHProjectsLinearRadiance)
+{
+	const int kiEncodings[2] = { PROBE_IRRADIANCE_ENCODING_SH_L1, PROBE_IRRADIANCE_ENCODING_SH_L2 };
+
+	for (int i = 0; i < 2; ++i)
+	{
+		RaytracePerFrameCB params = CreateSHParams(kiEncodings[i]);
+		params.RayRotation = XMFLOAT4(0.2f, -0.4f, 0.1f, sqrtf(1.0f - 0.21f));
+
+		CPUAtlas rayData;
+		CreateFieldRayData(params, GetLinearRadiance, rayData);
+
+		CPUAtlas shAtlas;
+		CPUSHProjector::CreateAtlas(params, shAtlas);
+
+		CPUSHProjector projector;
+		projector.ProjectProbes(params, rayData, shAtlas);
+
+		//A linear field only has the first two bands so both encodings hold it exactly, up to the ray count
+		CHECK(GetMaxIrradianceError(params, shAtlas, GetLinearIrradiance) < 1e-3f);
+	}
+}
+
+TEST(SHMatchesOctahedralOnTheSameRays)
+{
+	RaytracePerFrameCB params = CreateSHParams(PROBE_IRRADIANCE_ENCODING_SH_L2);
+
+	SHEncodingError error = MeasureFieldError(params, [](const XMFLOAT3&) { return XMFLOAT3(1.0f, 0.5f, 2.0f); });
+
+	CHECK(error.OctahedralTexelsPerProbe == 64);
+	CHECK(error.SHTexelsPerProbe == 9);
+	CHECK(error.RelativeRMSError < 1e-3);
+
+	//Both encodings get a linear field right so they agree, to within the blend's cosine weighting over the rays
+	error = MeasureFieldError(params, GetLinearRadiance);
+
+	CHECK(error.RelativeRMSError < 2e-3);
+	CHECK(error.MaxError < 2e-3);
+}
+
+TEST(SHErrorFallsWithMoreBands)
+{
+	SHEncodingError l1Error = MeasureFieldError(CreateSHParams(PROBE_IRRADIANCE_ENCODING_SH_L1), GetSunRadiance);
+	SHEncodingError l2Error = MeasureFieldError(CreateSHParams(PROBE_IRRADIANCE_ENCODING_SH_L2), GetSunRadiance);
+
+	CHECK(l1Error.SHTexelsPerProbe == 4);
+	CHECK(l2Error.SHTexelsPerProbe == 9);
+
+	//The sun can't be followed exactly by either, L2 gets closer
+	CHECK(l1Error.RelativeRMSError > 0.1);
+	CHECK(l2Error.RelativeRMSError < l1Error.RelativeRMSError);
+	CHECK(l2Error.MaxError < l1Error.MaxError);
+	CHECK(l1Error.MaxError >= l1Error.RMSError);
+}
@@ -0,0 +1,21 @@
+#include "Helpers/DebugHelper.h"
+
+#include <cstdarg>
+#include <stdio.h>
+
+//The tests only link the CPU side of the app so logging goes to the console and profile timers are dropped, the rest
+//of DebugHelper needs a device
+
+void DebugHelper::Log(LogLevel logLevel, std::wstring sTag, std::wstring sText, ...)
+{
+	std::wstring sLine = sTag + L"::" + sText + L"\n";
+
+	va_list args;
+	va_start(args, sText);
+	vwprintf(sLine.c_str(), args);
+	va_end(args);
+}
+
+void DebugHelper::AddTime(ScopedTimer* pTimer)
+{
+}
@@ -0,0 +1,114 @@
+#include "TestHelper.h"
+#include "Shaders/Defines.hlsli"
+
+#include <stdio.h>
+
+using namespace DirectX;
+
+bool TestHelper::s_bCurrentTestFailed = false;
+
+bool TestHelper::RegisterTest(const char* kpName, const std::function<void()>& kTest)
+{
+	GetTests().push_back({ kpName, kTest });
+
+	return true;
+}
+
+int TestHelper::RunTests(const std::string& ksFilter)
+{
+	int iNumRun = 0;
+	int iNumFailed = 0;
+
+	std::vector<Test>& tests = GetTests();
+
+	for (int i = 0; i < (int)tests.size(); ++i)
+	{
+		if (ksFilter.empty() == false && std::string(tests[i].Name).find(ksFilter) == std::string::npos)
+		{
+			continue;
+		}
+
+		s_bCurrentTestFailed = false;
+
+		tests[i].Function();
+
+		printf("%s %s\n", s_bCurrentTestFailed == true ? "FAILED" : "passed", tests[i].Name);
+
+		++iNumRun;
+
+		if (s_bCurrentTestFailed == true)
+		{
+			++iNumFailed;
+		}
+	}
+
+	printf("\n%d of %d tests passed\n", iNumRun - iNumFailed, iNumRun);
+
+	return iNumFailed;
+}
+
+void TestHelper::Fail(const char* kpFile, int iLine, const std::string& ksMessage)
+{
+	printf("%s(%d): CHECK failed: %s\n", kpFile, iLine, ksMessage.c_str());
+
+	s_bCurrentTestFailed = true;
+}
+
+std::string TestHelper::FormatNear(const char* kpExpression, double dActual, double dExpected, double dTolerance)
+{
+	char buffer[512];
+	snprintf(buffer, sizeof(buffer), "%s is %.9g, expected %.9g +- %.3g", kpExpression, dActual, dExpected, dTolerance);
+
+	return buffer;
+}
+
+RaytracePerFrameCB TestHelper::CreateParams(const XMINT3& kProbeCounts, int iRaysPerProbe)
+{
+	RaytracePerFrameCB params = {};
+	params.ProbeCounts = kProbeCounts;
+	params.RaysPerProbe = iRaysPerProbe;
+	params.ProbeSpacing = XMFLOAT3(1.0f, 1.0f, 1.0f);
+	params.MaxRayDistance = 10000.0f;
+	params.VolumePosition = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	params.RayDataFormat = FORMAT_PROBE_RAY_DATA_R32G32B32A32_FLOAT;
+	params.MissRadiance = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	params.NormalBias = 0.1f;
+	params.RayRotation = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+	params.ViewBias = 0.1f;
+	params.DistancePower = 50.0f;
+	params.Hysteresis = 0.97f;
+	params.IrradianceGammaEncoding = 5.0f;
+	params.IrradianceThreshold = 0.2f;
+	params.BrightnessThreshold = 2.0f;
+	params.NumDistanceTexels = 14;
+	params.NumIrradianceTexels = 6;
+	params.IrradianceFormat = FORMAT_PROBE_IRRADIANCE_R32G32B32A32_FLOAT;
+	params.ProbeOffsets = XMINT3(0, 0, 0);
+	params.ClearPlane = XMINT3(0, 0, 0);
+	params.ProbeMinFrontfaceDistance = 0.1f;
+	params.ProbeBackfaceThreshold = 0.25f;
+	params.IrradianceEncoding = PROBE_IRRADIANCE_ENCODING_OCTAHEDRAL;
+	params.RayDirectionTableIndex = -1;
+	params.AtlasLayout = PROBE_ATLAS_LAYOUT_PLANES;
+	params.MinHysteresis = 0.8f;
+	params.HysteresisRiseRate = 0.05f;
+	params.HysteresisChangeThreshold = 0.1f;
+	params.ProbeFilter = PROBE_FILTER_NONE;
+	params.ProbeFilterStrength = 0.25f;
+	params.FullProbeUpdate = 1;
+
+	return params;
+}
+
+int TestHelper::GetNumProbes(const RaytracePerFrameCB& kParams)
+{
+	return kParams.ProbeCounts.x * kParams.ProbeCounts.y * kParams.ProbeCounts.z;
+}
+
+std::vector<TestHelper::Test>& TestHelper::GetTests()
+{
+	//Function local so it exists before any test file's registration runs
+	static std::vector<Test> s_Tests;
+
+	return s_Tests;
+}
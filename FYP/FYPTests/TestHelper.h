@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Shaders/ConstantBuffers.h"
+
+#include <functional>
+#include <math.h>
+#include <string>
+#include <vector>
+
+//Keeps every test registered with TEST and runs them from main. A failed CHECK marks the test as failed and carries
+//on, so every broken expectation in a test is reported and not just the first.
+class TestHelper
+{
+public:
+	static bool RegisterTest(const char* kpName, const std::function<void()>& kTest);
+
+	//Runs every test with ksFilter in its name, or every test for an empty filter, and returns how many failed
+	static int RunTests(const std::string& ksFilter);
+
+	static void Fail(const char* kpFile, int iLine, const std::string& ksMessage);
+	static std::string FormatNear(const char* kpExpression, double dActual, double dExpected, double dTolerance);
+
+	//Per frame constants for a volume of kProbeCounts probes 1 unit apart at the origin with the defaults GIVolume
+	//uses, every optional feature is off
+	static RaytracePerFrameCB CreateParams(const DirectX::XMINT3& kProbeCounts, int iRaysPerProbe);
+
+	static int GetNumProbes(const RaytracePerFrameCB& kParams);
+
+protected:
+
+private:
+	struct Test
+	{
+		const char* Name;
+		std::function<void()> Function;
+	};
+
+	static std::vector<Test>& GetTests();
+
+	static bool s_bCurrentTestFailed;
+};
+
+#define TEST(name) \
+	static void name(); \
+	static const bool s_b##name##Registered = TestHelper::RegisterTest(#name, name); \
+	static void name()
+
+#define CHECK(condition) \
+	do \
+	{ \
+		if ((condition) == false) \
+		{ \
+			TestHelper::Fail(__FILE__, __LINE__, #condition); \
+		} \
+	} while (false)
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+	do \
+	{ \
+		double dActualValue = (double)(actual); \
+		double dExpectedValue = (double)(expected); \
+		if ((fabs(dActualValue - dExpectedValue) <= (double)(tolerance)) == false) \
+		{ \
+			TestHelper::Fail(__FILE__, __LINE__, TestHelper::FormatNear(#actual, dActualValue, dExpectedValue, (double)(tolerance))); \
+		} \
+	} while (false)
@@ -0,0 +1,389 @@
+#include "TestHelper.h"
+#include "Helpers/VertexPackingHelper.h"
+#include "Shaders/Defines.hlsli"
+#include "Shaders/Vertices.h"
+
+#include <DirectXPackedVector.h>
+
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	//Random directions with the axes and the octahedron's folds, where the mapping is least well behaved, mixed in
+	std::vector<XMFLOAT3> CreateDirections(int iCount, int iSeed)
+	{
+		std::vector<XMFLOAT3> directions =
+		{
+			XMFLOAT3(1.0f, 0.0f, 0.0f), XMFLOAT3(-1.0f, 0.0f, 0.0f),
+			XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(0.0f, -1.0f, 0.0f),
+			XMFLOAT3(0.0f, 0.0f, 1.0f), XMFLOAT3(0.0f, 0.0f, -1.0f),
+			XMFLOAT3(0.70710678f, 0.0f, -0.70710678f), XMFLOAT3(0.0f, -0.70710678f, -0.70710678f),
+			XMFLOAT3(0.57735027f, -0.57735027f, -0.57735027f)
+		};
+
+		std::mt19937 generator(iSeed);
+		std::normal_distribution<float> components(0.0f, 1.0f);
+
+		while ((int)directions.size() < iCount)
+		{
+			XMFLOAT3 direction = XMFLOAT3(components(generator), components(generator), components(generator));
+			XMStoreFloat3(&direction, XMVector3Normalize(XMLoadFloat3(&direction)));
+
+			directions.push_back(direction);
+		}
+
+		return directions;
+	}
+
+	std::vector<Vertex> CreateVertices(int iCount, int iSeed)
+	{
+		std::vector<XMFLOAT3> normals = CreateDirections(iCount, iSeed);
+		std::vector<XMFLOAT3> tangents = CreateDirections(iCount, iSeed + 1);
+
+		std::mt19937 generator(iSeed);
+		std::uniform_real_distribution<float> positions(-50.0f, 50.0f);
+		std::uniform_real_distribution<float> texCoords(-2.0f, 2.0f);
+
+		std::vector<Vertex> vertices(iCount);
+
+		for (int i = 0; i < iCount; ++i)
+		{
+			vertices[i].Position = XMFLOAT3(positions(generator) + 100.0f, positions(generator) * 0.1f, positions(generator));
+			vertices[i].Normal = normals[i];
+			vertices[i].Tangent = XMFLOAT4(tangents[i].x, tangents[i].y, tangents[i].z, (i & 1) == 0 ? 1.0f : -1.0f);
+			vertices[i].TexCoords = XMFLOAT2(texCoords(generator), texCoords(generator));
+		}
+
+		return vertices;
+	}
+
+	//In doubles from the chord so thousandths of a degree can be told apart
+	double GetAngleDegrees(const XMFLOAT3& kA, const XMFLOAT3& kB)
+	{
+		double dX = (double)kA.x - kB.x;
+		double dY = (double)kA.y - kB.y;
+		double dZ = (double)kA.z - kB.z;
+
+		return 2.0 * asin((std::min)(sqrt(dX * dX + dY * dY + dZ * dZ) * 0.5, 1.0)) * 180.0 / 3.14159265358979;
+	}
+
+	float GetLength(const XMFLOAT3& kDirection)
+	{
+		return sqrtf(kDirection.x * kDirection.x + kDirection.y * kDirection.y + kDirection.z * kDirection.z);
+	}
+}
+
+TEST(VertexStrides)
+{
+	CHECK(VertexPackingHelper::GetVertexStride(VERTEX_FORMAT_FULL) == 48);
+	CHECK(VertexPackingHelper::GetVertexStride(VERTEX_FORMAT_PACKED) == 24);
+	CHECK(VertexPackingHelper::GetVertexStride(VERTEX_FORMAT_QUANTIZED) == 20);
+}
+
+TEST(VertexNormalRoundTrip)
+{
+	std::vector<XMFLOAT3> normals = CreateDirections(20000, 1);
+
+	double dMaxError = 0.0;
+
+	for (int i = 0; i < (int)normals.size(); ++i)
+	{
+		uint32_t uiPacked = VertexPackingHelper::PackNormal(normals[i]);
+		XMFLOAT3 unpacked = VertexPackingHelper::UnpackNormal(uiPacked);
+
+		dMaxError = (std::max)(dMaxError, GetAngleDegrees(normals[i], unpacked));
+
+		CHECK_NEAR(GetLength(unpacked), 1.0f, 1e-5f);
+
+		//Normals don't have to be normalized to pack
+		XMFLOAT3 scaled = VertexPackingHelper::UnpackNormal(VertexPackingHelper::PackNormal(XMFLOAT3(normals[i].x * 3.0f, normals[i].y * 3.0f, normals[i].z * 3.0f)));
+
+		dMaxError = (std::max)(dMaxError, GetAngleDegrees(normals[i], scaled));
+	}
+
+	//Two 16 bit SNORMs resolve to a few thousandths of a degree
+	CHECK(dMaxError < 0.005);
+
+	//Zero length normals come back as +Z
+	XMFLOAT3 zero = VertexPackingHelper::UnpackNormal(VertexPackingHelper::PackNormal(XMFLOAT3(0.0f, 0.0f, 0.0f)));
+
+	CHECK(zero.x == 0.0f && zero.y == 0.0f && zero.z == 1.0f);
+}
+
+TEST(VertexNormalPacksTheClosestEncoding)
+{
+	std::vector<XMFLOAT3> normals = CreateDirections(2000, 2);
+
+	for (int i = 0; i < (int)normals.size(); ++i)
+	{
+		uint32_t uiPacked = VertexPackingHelper::PackNormal(normals[i]);
+		double dError = GetAngleDegrees(normals[i], VertexPackingHelper::UnpackNormal(uiPacked));
+
+		INT16 iX = (INT16)(uiPacked & 0xFFFF);
+		INT16 iY = (INT16)(uiPacked >> 16);
+
+		//None of the eight encodings around it decode any closer
+		for (int y = -1; y <= 1; ++y)
+		{
+			for (int x = -1; x <= 1; ++x)
+			{
+				int iNeighbourX = iX + x;
+				int iNeighbourY = iY + y;
+
+				if (iNeighbourX < -32767 || iNeighbourX > 32767 || iNeighbourY < -32767 || iNeighbourY > 32767)
+				{
+					continue;
+				}
+
+				uint32_t uiNeighbour = ((uint32_t)iNeighbourX & 0xFFFF) | ((uint32_t)iNeighbourY << 16);
+
+				CHECK(GetAngleDegrees(normals[i], VertexPackingHelper::UnpackNormal(uiNeighbour)) >= dError - 1e-5);
+			}
+		}
+	}
+}
+
+TEST(VertexTangentRoundTrip)
+{
+	std::vector<XMFLOAT3> tangents = CreateDirections(20000, 3);
+
+	double dMaxError = 0.0;
+
+	for (int i = 0; i < (int)tangents.size(); ++i)
+	{
+		float fSign = (i % 3) == 0 ? -1.0f : 1.0f;
+
+		XMFLOAT4 unpacked = VertexPackingHelper::UnpackTangent(VertexPackingHelper::PackTangent(XMFLOAT4(tangents[i].x, tangents[i].y, tangents[i].z, fSign)));
+
+		dMaxError = (std::max)(dMaxError, GetAngleDegrees(tangents[i], XMFLOAT3(unpacked.x, unpacked.y, unpacked.z)));
+
+		CHECK(unpacked.w == fSign);
+	}
+
+	//Two 15 bit UNORMs have a quarter of the steps of the normal's SNORMs
+	CHECK(dMaxError < 0.01);
+
+	//The sign bit doesn't leak into the direction
+	XMFLOAT4 positive = VertexPackingHelper::UnpackTangent(VertexPackingHelper::PackTangent(XMFLOAT4(0.0f, 0.0f, -1.0f, 1.0f)));
+	XMFLOAT4 negative = VertexPackingHelper::UnpackTangent(VertexPackingHelper::PackTangent(XMFLOAT4(0.0f, 0.0f, -1.0f, -1.0f)));
+
+	CHECK(positive.x == negative.x && positive.y == negative.y && positive.z == negative.z);
+	CHECK(positive.w == 1.0f && negative.w == -1.0f);
+}
+
+TEST(VertexTexCoordsRoundTrip)
+{
+	std::mt19937 generator(4);
+	std::uniform_real_distribution<float> texCoords(-4.0f, 4.0f);
+
+	for (int i = 0; i < 10000; ++i)
+	{
+		XMFLOAT2 original = XMFLOAT2(texCoords(generator), texCoords(generator));
+		XMFLOAT2 unpacked = VertexPackingHelper::UnpackTexCoords(VertexPackingHelper::PackTexCoords(original));
+
+		//Halves keep 11 significant bits
+		CHECK_NEAR(unpacked.x, original.x, fabsf(original.x) * exp2f(-11.0f));
+		CHECK_NEAR(unpacked.y, original.y, fabsf(original.y) * exp2f(-11.0f));
+	}
+
+	//Exactly representable coordinates survive untouched
+	XMFLOAT2 exact = VertexPackingHelper::UnpackTexCoords(VertexPackingHelper::PackTexCoords(XMFLOAT2(0.5f, -1.25f)));
+
+	CHECK(exact.x == 0.5f && exact.y == -1.25f);
+	CHECK(VertexPackingHelper::PackTexCoords(XMFLOAT2(1.0f, 0.0f)) == (uint32_t)PackedVector::XMConvertFloatToHalf(1.0f));
+}
+
+TEST(VertexPositionQuantization)
+{
+	std::vector<Vertex> vertices = CreateVertices(5000, 5);
+
+	XMFLOAT3 offset;
+	XMFLOAT3 scale;
+	VertexPackingHelper::GetQuantization(vertices.data(), (UINT)vertices.size(), offset, scale);
+
+	XMFLOAT3X4 transform = VertexPackingHelper::GetDequantizeTransform(offset, scale);
+
+	bool bHitsMin = false;
+	bool bHitsMax = false;
+
+	for (int i = 0; i < (int)vertices.size(); ++i)
+	{
+		const XMFLOAT3& kPosition = vertices[i].Position;
+
+		XMUINT2 quantized = VertexPackingHelper::QuantizePosition(kPosition, offset, scale);
+		XMFLOAT3 dequantized = VertexPackingHelper::DequantizePosition(quantized, offset, scale);
+
+		//Half a step of the SNORM either way, with some room for the float maths at an offset of 100
+		CHECK_NEAR(dequantized.x, kPosition.x, scale.x * 0.5f / 32767.0f + 1e-5f);
+		CHECK_NEAR(dequantized.y, kPosition.y, scale.y * 0.5f / 32767.0f + 1e-5f);
+		CHECK_NEAR(dequantized.z, kPosition.z, scale.z * 0.5f / 32767.0f + 1e-5f);
+
+		//The acceleration structure's transform does the same to the SNORMs
+		float fX = (std::max)((INT16)(quantized.x & 0xFFFF) / 32767.0f, -1.0f);
+		float fY = (std::max)((INT16)(quantized.x >> 16) / 32767.0f, -1.0f);
+		float fZ = (std::max)((INT16)(quantized.y & 0xFFFF) / 32767.0f, -1.0f);
+
+		CHECK_NEAR(transform._11 * fX + transform._12 * fY + transform._13 * fZ + transform._14, dequantized.x, 1e-4f);
+		CHECK_NEAR(transform._21 * fX + transform._22 * fY + transform._23 * fZ + transform._24, dequantized.y, 1e-4f);
+		CHECK_NEAR(transform._31 * fX + transform._32 * fY + transform._33 * fZ + transform._34, dequantized.z, 1e-4f);
+
+		//The fourth SNORM is padding
+		CHECK((quantized.y >> 16) == 0);
+
+		bHitsMin = bHitsMin || (INT16)(quantized.x & 0xFFFF) == -32767;
+		bHitsMax = bHitsMax || (INT16)(quantized.x & 0xFFFF) == 32767;
+	}
+
+	//The bounds use the whole range
+	CHECK(bHitsMin == true);
+	CHECK(bHitsMax == true);
+}
+
+TEST(VertexQuantizationOfFlatAndEmptyPrimitives)
+{
+	std::vector<Vertex> vertices = CreateVertices(16, 6);
+
+	for (int i = 0; i < (int)vertices.size(); ++i)
+	{
+		vertices[i].Position.y = 3.0f;
+	}
+
+	XMFLOAT3 offset;
+	XMFLOAT3 scale;
+	VertexPackingHelper::GetQuantization(vertices.data(), (UINT)vertices.size(), offset, scale);
+
+	CHECK(offset.y == 3.0f);
+	CHECK(scale.y == 1.0f);
+
+	for (int i = 0; i < (int)vertices.size(); ++i)
+	{
+		XMFLOAT3 dequantized = VertexPackingHelper::DequantizePosition(VertexPackingHelper::QuantizePosition(vertices[i].Position, offset, scale), offset, scale);
+
+		CHECK(dequantized.y == 3.0f);
+	}
+
+	VertexPackingHelper::GetQuantization(nullptr, 0, offset, scale);
+
+	CHECK(offset.x == 0.0f && offset.y == 0.0f && offset.z == 0.0f);
+	CHECK(scale.x == 1.0f && scale.y == 1.0f && scale.z == 1.0f);
+}
+
+TEST(VertexPackAndUnpackEveryFormat)
+{
+	std::vector<Vertex> vertices = CreateVertices(257, 7);
+
+	XMFLOAT3 offset;
+	XMFLOAT3 scale;
+	VertexPackingHelper::GetQuantization(vertices.data(), (UINT)vertices.size(), offset, scale);
+
+	const int kiFormats[3] = { VERTEX_FORMAT_FULL, VERTEX_FORMAT_PACKED, VERTEX_FORMAT_QUANTIZED };
+
+	for (int iVertexFormat : kiFormats)
+	{
+		UINT uiStride = VertexPackingHelper::GetVertexStride(iVertexFormat);
+
+		//One more vertex than needed to catch anything written past the end
+		std::vector<BYTE> packed((size_t)uiStride * (vertices.size() + 1), 0xCD);
+		std::vector<XMFLOAT3> positions(vertices.size());
+
+		VertexPackingHelper::PackVertices(vertices.data(), (UINT)vertices.size(), iVertexFormat, offset, scale, packed.data());
+		VertexPackingHelper::UnpackPositions(packed.data(), (UINT)vertices.size(), iVertexFormat, offset, scale, positions.data());
+
+		for (int i = 0; i < (int)vertices.size(); ++i)
+		{
+			const Vertex& kVertex = vertices[i];
+			const BYTE* kpPacked = packed.data() + (size_t)i * uiStride;
+
+			if (iVertexFormat == VERTEX_FORMAT_FULL)
+			{
+				CHECK(memcmp(kpPacked, &kVertex, sizeof(Vertex)) == 0);
+				CHECK(memcmp(&positions[i], &kVertex.Position, sizeof(XMFLOAT3)) == 0);
+
+				continue;
+			}
+
+			UINT32 uiNormal;
+			UINT32 uiTangent;
+			UINT32 uiTexCoords;
+
+			if (iVertexFormat == VERTEX_FORMAT_PACKED)
+			{
+				const PackedVertex* kpVertex = reinterpret_cast<const PackedVertex*>(kpPacked);
+
+				CHECK(memcmp(&kpVertex->Position, &kVertex.Position, sizeof(XMFLOAT3)) == 0);
+				CHECK(memcmp(&positions[i], &kVertex.Position, sizeof(XMFLOAT3)) == 0);
+
+				uiNormal = kpVertex->Normal;
+				uiTangent = kpVertex->Tangent;
+				uiTexCoords = kpVertex->TexCoords;
+			}
+			else
+			{
+				const QuantizedVertex* kpVertex = reinterpret_cast<const QuantizedVertex*>(kpPacked);
+				XMUINT2 quantized = VertexPackingHelper::QuantizePosition(kVertex.Position, offset, scale);
+
+				CHECK(kpVertex->Position.x == quantized.x && kpVertex->Position.y == quantized.y);
+
+				XMFLOAT3 dequantized = VertexPackingHelper::DequantizePosition(quantized, offset, scale);
+
+				CHECK(memcmp(&positions[i], &dequantized, sizeof(XMFLOAT3)) == 0);
+
+				uiNormal = kpVertex->Normal;
+				uiTangent = kpVertex->Tangent;
+				uiTexCoords = kpVertex->TexCoords;
+			}
+
+			CHECK(uiNormal == VertexPackingHelper::PackNormal(kVertex.Normal));
+			CHECK(uiTangent == VertexPackingHelper::PackTangent(kVertex.Tangent));
+			CHECK(uiTexCoords == VertexPackingHelper::PackTexCoords(kVertex.TexCoords));
+		}
+
+		bool bPastEndUntouched = true;
+
+		for (size_t i = (size_t)uiStride * vertices.size(); i < packed.size(); ++i)
+		{
+			bPastEndUntouched = bPastEndUntouched && packed[i] == 0xCD;
+		}
+
+		CHECK(bPastEndUntouched == true);
+	}
+}
+
+TEST(VertexPackingPrecisionStats)
+{
+	std::vector<Vertex> vertices = CreateVertices(1000, 8);
+
+	VertexPackingStats full;
+	VertexPackingHelper::MeasurePrecision(vertices.data(), (UINT)vertices.size(), VERTEX_FORMAT_FULL, full);
+
+	CHECK(full.NumVertices == 1000);
+	CHECK(full.GetSaving() == 0.0f);
+	CHECK(full.MaxPositionError == 0.0f);
+	CHECK(full.MaxTexCoordError == 0.0f);
+	CHECK(full.NumTangentSignErrors == 0);
+	CHECK(full.MaxNormalErrorDegrees < 0.001f);
+
+	VertexPackingStats packed;
+	VertexPackingHelper::MeasurePrecision(vertices.data(), (UINT)vertices.size(), VERTEX_FORMAT_PACKED, packed);
+
+	CHECK(packed.GetSaving() == 0.5f);
+	CHECK(packed.MaxPositionError == 0.0f);
+	CHECK(packed.NumTangentSignErrors == 0);
+	CHECK(packed.MaxNormalErrorDegrees > 0.0f && packed.MaxNormalErrorDegrees < 0.005f);
+	CHECK(packed.MeanNormalErrorDegrees <= packed.MaxNormalErrorDegrees);
+	CHECK(packed.MaxTangentErrorDegrees < 0.01f);
+	CHECK(packed.MaxTexCoordError > 0.0f && packed.MaxTexCoordError <= 2.0f * exp2f(-11.0f));
+
+	//Stats from a second primitive add to the first, with its own bounds
+	VertexPackingStats quantized;
+	VertexPackingHelper::MeasurePrecision(vertices.data(), 500, VERTEX_FORMAT_QUANTIZED, quantized);
+	VertexPackingHelper::MeasurePrecision(vertices.data() + 500, 500, VERTEX_FORMAT_QUANTIZED, quantized);
+
+	CHECK(quantized.NumVertices == 1000);
+	CHECK(quantized.FullBytes == 1000 * sizeof(Vertex));
+	CHECK(quantized.PackedBytes == 1000 * sizeof(QuantizedVertex) + 2 * sizeof(XMFLOAT3X4));
+	CHECK(quantized.MaxPositionError > 0.0f && quantized.MaxPositionError <= 0.5f / 65534.0f + 1e-6f);
+	CHECK_NEAR(quantized.MeanNormalErrorDegrees, packed.MeanNormalErrorDegrees, 1e-6);
+}
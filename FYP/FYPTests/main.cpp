@@ -0,0 +1,13 @@
+#include "TestHelper.h"
+
+#include <string>
+
+//Runs the CPU side tests, FYPTests.exe [filter] only runs the tests with filter in their name
+int main(int argc, char* argv[])
+{
+	std::string sFilter = argc > 1 ? argv[1] : "";
+
+	int iNumFailed = TestHelper::RunTests(sFilter);
+
+	return iNumFailed > 0 ? 1 : 0;
+}